@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "alloc_counter.h"
+#include "core/denigma.h"
+#include "core/musx_reader.h"
+#include "denigma/classify/articulations.h"
+#include "denigma/classify/barlines.h"
+#include "denigma/classify/batch.h"
+#include "denigma/classify/chords.h"
+#include "denigma/classify/clefs.h"
+#include "denigma/classify/entries.h"
+#include "denigma/classify/expressions.h"
+#include "denigma/classify/jumps.h"
+#include "denigma/classify/noteheads.h"
+#include "denigma/classify/smartshapes.h"
+#include "formats/enigmaxml/enigmaxml.h"
+#include "musx/musx.h"
+#include "utils/stringutils.h"
+
+using namespace denigma;
+using namespace musx::dom;
+
+namespace {
+
+/// Everything the benchmarks classify, gathered once from every musx document in the test inputs.
+struct Corpus
+{
+    std::vector<DocumentPtr> documents;
+    std::vector<EntryInfoPtr> entries;
+    std::vector<NoteInfoPtr> notes;
+    std::vector<std::pair<MusxInstance<details::ArticulationAssign>, EntryInfoPtr>> articulations;
+    std::vector<MusxInstanceList<details::ArticulationAssign>> articulationLists;
+    std::vector<MusxInstanceList<others::MeasureExprAssign>> expressionLists;
+    std::vector<MusxInstance<others::MeasureExprAssign>> expressions;
+    std::vector<MusxInstance<others::SmartShape>> smartShapes;
+    std::vector<MusxInstance<others::TextRepeatAssign>> textRepeats;
+    std::vector<MusxInstance<details::ChordAssign>> chords;
+    std::vector<std::pair<MusxInstance<options::ClefOptions::ClefDef>, MusxInstance<others::Staff>>> clefs;
+    struct Barline
+    {
+        MusxInstance<others::Staff> staff;
+        MusxInstance<others::Measure> measure;
+        bool isFinalMeasure{};
+        MusxInstance<options::BarlineOptions> options;
+    };
+    std::vector<Barline> barlines;
+};
+
+DocumentPtr loadDocument(const std::filesystem::path& path)
+{
+    DenigmaContext context(DENIGMA_NAME);
+    context.inputFilePath = path;
+    const auto inputData = formats::enigmaxml::detail::extractMusxInputData(path, context);
+    return createMusxDocument<MusxReader>(inputData, context);
+}
+
+void addDocument(Corpus& corpus, const DocumentPtr& document)
+{
+    corpus.documents.push_back(document);
+    const auto details = document->getDetails();
+    const auto others = document->getOthers();
+
+    document->iterateEntries(SCORE_PARTID, [&](const EntryInfoPtr& entryInfo) -> bool {
+        corpus.entries.push_back(entryInfo);
+        const auto entry = entryInfo->getEntry();
+        for (size_t index = 0; index < entry->notes.size(); ++index) {
+            corpus.notes.emplace_back(entryInfo, index);
+        }
+        auto assignments = details->getArray<details::ArticulationAssign>(SCORE_PARTID, entry->getEntryNumber());
+        for (const auto& assignment : assignments) {
+            corpus.articulations.emplace_back(assignment, entryInfo);
+        }
+        return true;
+    });
+    corpus.articulationLists.push_back(details->getArray<details::ArticulationAssign>(SCORE_PARTID));
+
+    auto expressions = others->getArray<others::MeasureExprAssign>(SCORE_PARTID);
+    corpus.expressions.insert(corpus.expressions.end(), expressions.begin(), expressions.end());
+    corpus.expressionLists.push_back(std::move(expressions));
+
+    for (const auto& shape : others->getArray<others::SmartShape>(SCORE_PARTID)) {
+        corpus.smartShapes.push_back(shape);
+    }
+    for (const auto& repeat : others->getArray<others::TextRepeatAssign>(SCORE_PARTID)) {
+        corpus.textRepeats.push_back(repeat);
+    }
+    for (const auto& chord : details->getArray<details::ChordAssign>(SCORE_PARTID)) {
+        corpus.chords.push_back(chord);
+    }
+
+    const auto staves = others->getArray<others::Staff>(SCORE_PARTID);
+    if (const auto clefOptions = document->getOptions()->get<options::ClefOptions>()) {
+        for (const auto& clefDef : clefOptions->clefDefs) {
+            corpus.clefs.emplace_back(clefDef, staves.empty() ? nullptr : staves.front());
+        }
+    }
+    const auto barlineOptions = document->getOptions()->get<options::BarlineOptions>();
+    const auto measures = others->getArray<others::Measure>(SCORE_PARTID);
+    for (const auto& measure : measures) {
+        for (const auto& staff : staves) {
+            corpus.barlines.push_back({ staff, measure, measure->getCmper() == measures.size(), barlineOptions });
+        }
+    }
+}
+
+const Corpus& corpus()
+{
+    static const Corpus result = []() {
+        Corpus loaded;
+        std::vector<std::filesystem::path> paths;
+        for (const auto& file : std::filesystem::directory_iterator(DENIGMA_BENCH_INPUT_PATH)) {
+            if (file.is_regular_file() && utils::pathExtensionEquals(file.path(), MUSX_EXTENSION)) {
+                paths.push_back(file.path());
+            }
+        }
+        std::sort(paths.begin(), paths.end()); // a stable corpus order keeps runs comparable
+        for (const auto& path : paths) {
+            addDocument(loaded, loadDocument(path));
+        }
+        return loaded;
+    }();
+    return result;
+}
+
+/// Runs classify over every item once per iteration and reports items per second and heap allocations per item.
+template <typename Items, typename Classify>
+void runOverItems(benchmark::State& state, const Items& items, Classify&& classify)
+{
+    if (items.empty()) {
+        state.SkipWithError("the benchmark corpus has no items of this kind");
+        return;
+    }
+    const std::uint64_t allocationsBefore = bench::allocationCount();
+    for (auto _ : state) {
+        for (const auto& item : items) {
+            benchmark::DoNotOptimize(classify(item));
+        }
+    }
+    const auto classified = static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(items.size());
+    state.SetItemsProcessed(classified);
+    state.counters["allocs/item"] = benchmark::Counter(
+        static_cast<double>(bench::allocationCount() - allocationsBefore) / static_cast<double>(classified));
+    state.counters["items"] = static_cast<double>(items.size());
+}
+
+// Classifiers memoize per document, so after the first iteration these measure the cached paths, which is what a
+// conversion mostly exercises. Run with --benchmark_min_time=1x to see the first, uncached pass.
+
+void classifyArticulation(benchmark::State& state)
+{
+    runOverItems(state, corpus().articulations, [](const auto& item) {
+        return classify::classifyArticulation(item.first, item.second);
+    });
+}
+BENCHMARK(classifyArticulation);
+
+void classifyArticulationColumns(benchmark::State& state)
+{
+    runOverItems(state, corpus().articulationLists, [](const auto& list) {
+        return classify::classifyArticulationColumns(list);
+    });
+}
+BENCHMARK(classifyArticulationColumns);
+
+void classifyNotehead(benchmark::State& state)
+{
+    runOverItems(state, corpus().notes, [](const NoteInfoPtr& note) {
+        return classify::classifyNotehead(note);
+    });
+}
+BENCHMARK(classifyNotehead);
+
+void classifyEntryNoteheads(benchmark::State& state)
+{
+    runOverItems(state, corpus().entries, [](const EntryInfoPtr& entry) {
+        return classify::classifyEntryNoteheads(entry);
+    });
+}
+BENCHMARK(classifyEntryNoteheads);
+
+void classifyExpression(benchmark::State& state)
+{
+    runOverItems(state, corpus().expressions, [](const MusxInstance<others::MeasureExprAssign>& assignment) {
+        return classify::classifyExpression(assignment);
+    });
+}
+BENCHMARK(classifyExpression);
+
+void classifyExpressionAssignments(benchmark::State& state)
+{
+    runOverItems(state, corpus().expressionLists, [](const MusxInstanceList<others::MeasureExprAssign>& list) {
+        return classify::classifyExpressionAssignments(list);
+    });
+}
+BENCHMARK(classifyExpressionAssignments);
+
+void classifyExpressionColumns(benchmark::State& state)
+{
+    runOverItems(state, corpus().expressionLists, [](const MusxInstanceList<others::MeasureExprAssign>& list) {
+        return classify::classifyExpressionColumns(list);
+    });
+}
+BENCHMARK(classifyExpressionColumns);
+
+void classifySmartShape(benchmark::State& state)
+{
+    runOverItems(state, corpus().smartShapes, [](const MusxInstance<others::SmartShape>& shape) {
+        return classify::classifySmartShape(shape);
+    });
+}
+BENCHMARK(classifySmartShape);
+
+void classifyJump(benchmark::State& state)
+{
+    runOverItems(state, corpus().textRepeats, [](const MusxInstance<others::TextRepeatAssign>& assignment) {
+        return classify::classifyJump(assignment);
+    });
+}
+BENCHMARK(classifyJump);
+
+void classifyChordSuffix(benchmark::State& state)
+{
+    runOverItems(state, corpus().chords, [](const MusxInstance<details::ChordAssign>& assignment) {
+        return classify::classifyChordSuffix(assignment->getChordSuffix());
+    });
+}
+BENCHMARK(classifyChordSuffix);
+
+void classifyClef(benchmark::State& state)
+{
+    runOverItems(state, corpus().clefs, [](const auto& item) {
+        return classify::classifyClef(item.first, item.second);
+    });
+}
+BENCHMARK(classifyClef);
+
+void classifyBarline(benchmark::State& state)
+{
+    runOverItems(state, corpus().barlines, [](const Corpus::Barline& item) {
+        return classify::classifyBarline(item.staff, item.measure, item.isFinalMeasure, item.options);
+    });
+}
+BENCHMARK(classifyBarline);
+
+} // namespace
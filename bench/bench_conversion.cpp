@@ -0,0 +1,447 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+// denigma_bench_conversion: times every registered converter over the fixture corpus, phase by phase, and writes the
+// measurements as JSON so that runs from different commits can be diffed.
+//
+//     denigma_bench_conversion [--repeat N] [--output results.json]
+//                              [--scale measures|staves|expressions=F1,F2,...] [input.musx ...]
+//
+// Without inputs it runs every .musx file in tests/data/inputs, headline case (large_orchestra.musx) first. Each
+// --scale instead runs the first input tiled by each factor in turn (see synthetic_score.h), to chart how the
+// converters scale with the size of the score.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "nlohmann/json.hpp"
+
+#include "core/denigma.h"
+#include "denigma/conversion.h"
+#include "denigma/formats/enigmaxml.h"
+#include "denigma/formats/mnx.h"
+#include "denigma/formats/mss.h"
+#include "denigma/formats/musicxml.h"
+#include "denigma/formats/svg.h"
+#include "denigma/io/random_access_reader.h"
+#include "denigma/prepared_document.h"
+#include "export/export.h"
+#include "formats/enigmaxml/prepared_document.h"
+#include "utils/stringutils.h"
+
+#include "synthetic_score.h"
+
+using namespace denigma;
+using denigma::bench::buildSyntheticScore;
+using denigma::bench::SyntheticScoreOptions;
+
+namespace {
+
+constexpr std::string_view HEADLINE_INPUT = "large_orchestra.musx";
+
+/// Bytes of the process's peak resident set so far. It never decreases, so it is a high-water mark for the whole run.
+std::uint64_t peakRssBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<std::uint64_t>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<std::uint64_t>(usage.ru_maxrss); // bytes on macOS
+#else
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024; // kilobytes elsewhere
+#endif
+#endif
+}
+
+struct PhaseTiming
+{
+    double wallSeconds{ std::numeric_limits<double>::max() };
+    double cpuSeconds{};
+    std::uint64_t bytesOut{};
+    std::uint64_t peakRssBytes{};
+
+    /// Keeps the fastest of several runs, which is the least disturbed by other work on the machine.
+    void keepFastest(const PhaseTiming& run)
+    {
+        if (run.wallSeconds < wallSeconds) {
+            *this = run;
+        }
+    }
+};
+
+/// Times one call of phase, which returns the number of bytes it wrote (0 for phases that write nothing).
+PhaseTiming timePhase(const std::function<std::uint64_t()>& phase)
+{
+    const auto wallStart = std::chrono::steady_clock::now();
+    const std::clock_t cpuStart = std::clock();
+    PhaseTiming result;
+    result.bytesOut = phase();
+    result.cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    result.peakRssBytes = peakRssBytes();
+    return result;
+}
+
+struct TargetFormat
+{
+    FormatId format;
+    std::string_view name;
+};
+
+constexpr TargetFormat TARGET_FORMATS[] = {
+    { FormatId::EnigmaXml, "enigmaxml" },
+    { FormatId::MnxJson, "mnx" },
+    { FormatId::MusicXml, "musicxml" },
+    { FormatId::MssXml, "mss" },
+    { FormatId::Svg, "svg" },
+};
+
+template <typename OptionsT>
+std::unique_ptr<IOptions> configuredOptions(const std::string& sourceName, bool validate)
+{
+    auto options = std::make_unique<OptionsT>();
+    options->common.sourceName = sourceName;
+    options->common.validate = validate;
+    options->common.quiet = true;
+    return options;
+}
+
+std::unique_ptr<IOptions> makeOptions(FormatId format, const std::string& sourceName, bool validate)
+{
+    switch (format) {
+    case FormatId::EnigmaXml: return configuredOptions<formats::enigmaxml::Options>(sourceName, validate);
+    case FormatId::MnxJson: return configuredOptions<formats::mnx::Options>(sourceName, validate);
+    case FormatId::MusicXml: return configuredOptions<formats::musicxml::Options>(sourceName, validate);
+    case FormatId::MssXml: return configuredOptions<formats::mss::Options>(sourceName, validate);
+    case FormatId::Svg: return configuredOptions<formats::svg::Options>(sourceName, validate);
+    case FormatId::Musx: break;
+    }
+    return nullptr;
+}
+
+/// The DOM a prepared-document converter parses for format; it must match the converter so the parse phase is reused.
+musx::dom::PartVoicingPolicy partVoicingPolicyFor(FormatId format)
+{
+    return format == FormatId::MusicXml ? musx::dom::PartVoicingPolicy::Apply : musx::dom::PartVoicingPolicy::Ignore;
+}
+
+void throwIfFailed(const ConversionResult& result, std::string_view what)
+{
+    if (result.hasError()) {
+        std::string message(what);
+        for (const auto& diagnostic : result.diagnostics()) {
+            if (diagnostic.severity == MessageSeverity::Error) {
+                message += ": " + diagnostic.message;
+                break;
+            }
+        }
+        throw std::runtime_error(message);
+    }
+}
+
+/// One document to convert: a musx file, or EnigmaXML tiled from one by buildSyntheticScore.
+struct BenchInput
+{
+    std::filesystem::path path;         ///< the musx file, or the fixture a synthetic score was tiled from
+    std::string syntheticXml;           ///< the tiled EnigmaXML; empty for a plain musx input
+    nlohmann::ordered_json scale;       ///< the tiling factors of a synthetic score; null for a plain musx input
+};
+
+/// Runs one input through one target format and returns the fastest timing of each phase over repeat runs.
+///
+/// Phases: "extract" unzips and decodes the musx archive, "parse" builds the DOM, "convert" maps and serializes the
+/// output with validation off, and "validate" is the extra time the same conversion takes with validation on.
+/// EnigmaXML output is a streamed pass-through with no DOM, so it has a single "convert" phase covering all of it.
+/// Synthetic inputs are already EnigmaXML: they skip the EnigmaXML target and their "extract" phase only wraps the text.
+nlohmann::ordered_json runCase(const BenchInput& input, const TargetFormat& target, unsigned repeat)
+{
+    const ConverterRegistry& registry = defaultConverterRegistry();
+    const std::string sourceName = utils::pathToString(input.path.filename());
+    const bool synthetic = !input.syntheticXml.empty();
+    if (synthetic && target.format == FormatId::EnigmaXml) {
+        return {};
+    }
+    const auto options = makeOptions(target.format, sourceName, false);
+    const auto validatingOptions = makeOptions(target.format, sourceName, true);
+    const FileRandomAccessReader reader(input.path);
+
+    auto countBytes = [](std::uint64_t& total) {
+        return [&total](std::string_view, std::span<const std::byte> data) { total += data.size(); };
+    };
+
+    PhaseTiming extract, parse, convert, validated;
+    if (target.format == FormatId::EnigmaXml) {
+        const auto* converter = registry.findReader(FormatId::Musx, FormatId::EnigmaXml);
+        if (!converter) {
+            return {};
+        }
+        for (unsigned run = 0; run < repeat; ++run) {
+            convert.keepFastest(timePhase([&]() -> std::uint64_t {
+                std::ostringstream output;
+                throwIfFailed(converter->convert(reader, output, ConversionRequest{ options.get() }), "enigmaxml conversion failed");
+                return static_cast<std::uint64_t>(output.tellp());
+            }));
+        }
+    } else {
+        const auto* converter = registry.findPrepared(target.format);
+        if (!converter) {
+            return {};
+        }
+        CommonOptions common;
+        common.sourceName = sourceName;
+        common.quiet = true;
+        DenigmaContext parseContext(DENIGMA_NAME);
+        parseContext.quiet = true;
+        for (unsigned run = 0; run < repeat; ++run) {
+            std::unique_ptr<PreparedDocument> prepared;
+            extract.keepFastest(timePhase([&]() -> std::uint64_t {
+                prepared = std::make_unique<PreparedDocument>(synthetic
+                    ? PreparedDocument::fromEnigmaXml(std::as_bytes(std::span(input.syntheticXml)), common)
+                    : PreparedDocument::fromMusx(reader, common));
+                throwIfFailed(prepared->preparationResult(), "extraction failed");
+                return 0;
+            }));
+            parse.keepFastest(timePhase([&]() -> std::uint64_t {
+                prepared->impl().document(partVoicingPolicyFor(target.format), parseContext);
+                return 0;
+            }));
+            convert.keepFastest(timePhase([&]() {
+                std::uint64_t bytes = 0;
+                throwIfFailed(converter->convert(*prepared, countBytes(bytes), ConversionRequest{ options.get() }),
+                    "conversion failed");
+                return bytes;
+            }));
+            validated.keepFastest(timePhase([&]() {
+                std::uint64_t bytes = 0;
+                // validation findings are diagnostics about the output, not a failure of the benchmark
+                converter->convert(*prepared, countBytes(bytes), ConversionRequest{ validatingOptions.get() });
+                return bytes;
+            }));
+        }
+    }
+
+    auto phaseJson = [](const PhaseTiming& timing) {
+        nlohmann::ordered_json result;
+        result["wallSeconds"] = timing.wallSeconds;
+        result["cpuSeconds"] = timing.cpuSeconds;
+        result["bytesOut"] = timing.bytesOut;
+        result["peakRssBytes"] = timing.peakRssBytes;
+        return result;
+    };
+
+    nlohmann::ordered_json result;
+    result["input"] = sourceName;
+    result["format"] = target.name;
+    result["headline"] = sourceName == HEADLINE_INPUT && !synthetic;
+    if (synthetic) {
+        result["scale"] = input.scale;
+    }
+    nlohmann::ordered_json phases;
+    if (target.format != FormatId::EnigmaXml) {
+        phases["extract"] = phaseJson(extract);
+        phases["parse"] = phaseJson(parse);
+    }
+    phases["convert"] = phaseJson(convert);
+    if (target.format != FormatId::EnigmaXml) {
+        PhaseTiming validate = validated;
+        validate.wallSeconds = std::max(0.0, validated.wallSeconds - convert.wallSeconds);
+        validate.cpuSeconds = std::max(0.0, validated.cpuSeconds - convert.cpuSeconds);
+        validate.bytesOut = 0;
+        phases["validate"] = phaseJson(validate);
+    }
+    result["phases"] = std::move(phases);
+    return result;
+}
+
+std::vector<std::filesystem::path> defaultInputs()
+{
+    std::vector<std::filesystem::path> result;
+    for (const auto& file : std::filesystem::directory_iterator(DENIGMA_BENCH_INPUT_PATH)) {
+        if (file.is_regular_file() && utils::pathExtensionEquals(file.path(), MUSX_EXTENSION)) {
+            result.push_back(file.path());
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+        const bool lhsHeadline = lhs.filename() == HEADLINE_INPUT;
+        const bool rhsHeadline = rhs.filename() == HEADLINE_INPUT;
+        return lhsHeadline != rhsHeadline ? lhsHeadline : lhs < rhs;
+    });
+    return result;
+}
+
+/// The EnigmaXML inside a musx file, extracted as the converters would extract it.
+std::string extractEnigmaXml(const std::filesystem::path& inputPath)
+{
+    CommonOptions common;
+    common.quiet = true;
+    const auto prepared = PreparedDocument::fromMusx(FileRandomAccessReader(inputPath), common);
+    throwIfFailed(prepared.preparationResult(), "extraction failed");
+    const auto xml = prepared.impl().inputData().primaryXml();
+    return std::string(xml.data(), xml.size());
+}
+
+/// Parses a --scale argument, "dimension=f1,f2,...", into one tiling per factor.
+std::vector<SyntheticScoreOptions> parseScale(std::string_view arg)
+{
+    const auto separator = arg.find('=');
+    if (separator == std::string_view::npos) {
+        throw std::invalid_argument("expected dimension=factors");
+    }
+    const std::string_view dimension = arg.substr(0, separator);
+    unsigned SyntheticScoreOptions::* factor = nullptr;
+    if (dimension == "measures") {
+        factor = &SyntheticScoreOptions::measureCopies;
+    } else if (dimension == "staves") {
+        factor = &SyntheticScoreOptions::staffCopies;
+    } else if (dimension == "expressions") {
+        factor = &SyntheticScoreOptions::expressionCopies;
+    } else {
+        throw std::invalid_argument("unknown dimension " + std::string(dimension));
+    }
+    std::vector<SyntheticScoreOptions> result;
+    std::istringstream factors{ std::string(arg.substr(separator + 1)) };
+    for (std::string value; std::getline(factors, value, ',');) {
+        SyntheticScoreOptions tiling;
+        tiling.*factor = static_cast<unsigned>(std::max(1, std::stoi(value)));
+        result.push_back(tiling);
+    }
+    return result;
+}
+
+nlohmann::ordered_json scaleJson(const SyntheticScoreOptions& tiling)
+{
+    nlohmann::ordered_json result;
+    result["measures"] = tiling.measureCopies;
+    result["staves"] = tiling.staffCopies;
+    result["expressions"] = tiling.expressionCopies;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned repeat = 3;
+    std::filesystem::path outputPath;
+    std::vector<std::filesystem::path> inputPaths;
+    std::vector<SyntheticScoreOptions> tilings;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view arg = argv[index];
+        try {
+            if (arg == "--repeat" && index + 1 < argc) {
+                repeat = static_cast<unsigned>(std::max(1, std::stoi(argv[++index])));
+            } else if (arg == "--output" && index + 1 < argc) {
+                outputPath = utils::utf8ToPath(argv[++index]);
+            } else if (arg == "--scale" && index + 1 < argc) {
+                const auto parsed = parseScale(argv[++index]);
+                tilings.insert(tilings.end(), parsed.begin(), parsed.end());
+            } else if (arg.starts_with("--")) {
+                throw std::invalid_argument("unknown option " + std::string(arg));
+            } else {
+                inputPaths.push_back(utils::utf8ToPath(arg));
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << "\n"
+                      << "usage: denigma_bench_conversion [--repeat N] [--output results.json]\n"
+                      << "                                [--scale measures|staves|expressions=F1,F2,...] [input.musx ...]\n";
+            return 1;
+        }
+    }
+    if (inputPaths.empty()) {
+        inputPaths = defaultInputs();
+    }
+
+    std::vector<BenchInput> inputs;
+    int exitCode = 0;
+    if (tilings.empty()) {
+        for (const auto& path : inputPaths) {
+            inputs.push_back({ path, {}, {} });
+        }
+    } else if (!inputPaths.empty()) {
+        // scaling runs tile only the first input (the headline case by default), once per factor
+        try {
+            const std::string fixture = extractEnigmaXml(inputPaths.front());
+            for (const auto& tiling : tilings) {
+                inputs.push_back({ inputPaths.front(), buildSyntheticScore(fixture, tiling), scaleJson(tiling) });
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << utils::pathToString(inputPaths.front().filename()) << ": " << ex.what() << "\n";
+            exitCode = 1;
+        }
+    }
+
+    nlohmann::ordered_json report;
+    report["denigmaVersion"] = DENIGMA_VERSION;
+    report["repeat"] = repeat;
+    report["cases"] = nlohmann::ordered_json::array();
+    for (const auto& input : inputs) {
+        for (const auto& target : TARGET_FORMATS) {
+            try {
+                if (auto result = runCase(input, target, repeat); !result.is_null()) {
+                    report["cases"].push_back(std::move(result));
+                }
+            } catch (const std::exception& ex) {
+                std::cerr << utils::pathToString(input.path.filename()) << " -> " << target.name << ": " << ex.what() << "\n";
+                exitCode = 1;
+            }
+        }
+    }
+
+    const std::string text = report.dump(2) + "\n";
+    if (outputPath.empty()) {
+        std::cout << text;
+    } else {
+        std::ofstream output(outputPath, std::ios::binary);
+        output << text;
+    }
+    return exitCode;
+}
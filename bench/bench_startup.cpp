@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// denigma_bench_startup: measures what a cold `denigma export small.musx --mnx` costs beyond the conversion itself,
+// the figure that matters when every file is converted by a fresh process.
+//
+//     denigma_bench_startup [--runs N] [--cli path/to/denigma] [--output results.json] [input.musx]
+//
+// Each run starts the CLI as a new process: once with --version, which measures bare process startup, and once
+// exporting the input to MNX. The same conversion is then timed in this process after a warm-up, and the report's
+// overhead is the fastest cold export less the fastest warm conversion. Without an input it uses the smallest fixture,
+// staff_lines.musx.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "core/denigma.h"
+#include "denigma/conversion.h"
+#include "denigma/formats/mnx.h"
+#include "denigma/io/random_access_reader.h"
+#include "export/export.h"
+#include "utils/stringutils.h"
+
+using namespace denigma;
+
+namespace {
+
+constexpr std::string_view DEFAULT_INPUT = "staff_lines.musx";
+
+/// Fastest and median of a set of timings, in milliseconds.
+nlohmann::ordered_json timingsJson(std::vector<double> milliseconds)
+{
+    std::sort(milliseconds.begin(), milliseconds.end());
+    nlohmann::ordered_json result;
+    result["minMilliseconds"] = milliseconds.front();
+    result["medianMilliseconds"] = milliseconds[milliseconds.size() / 2];
+    return result;
+}
+
+double timeMilliseconds(const std::function<void()>& work)
+{
+    const auto start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string quoted(const std::filesystem::path& path)
+{
+    return "\"" + utils::pathToString(path) + "\"";
+}
+
+/// Runs command through the shell and throws if it fails.
+void runCommand(const std::string& command)
+{
+#ifdef _WIN32
+    const std::string line = "\"" + command + " >NUL 2>&1\""; // cmd strips the outer quotes
+#else
+    const std::string line = command + " >/dev/null 2>&1";
+#endif
+    if (std::system(line.c_str()) != 0) {
+        throw std::runtime_error("command failed: " + command);
+    }
+}
+
+/// Converts input to MNX in this process, as the CLI's export does, and returns the bytes written.
+std::size_t convertInProcess(const std::filesystem::path& input)
+{
+    const auto* converter = defaultConverterRegistry().findReader(FormatId::Musx, FormatId::MnxJson);
+    if (!converter) {
+        throw std::runtime_error("no musx to MNX converter is registered");
+    }
+    formats::mnx::Options options;
+    options.common.sourceName = utils::pathToString(input.filename());
+    options.common.quiet = true;
+    std::ostringstream output;
+    const auto result = converter->convert(FileRandomAccessReader(input), output, ConversionRequest{ &options });
+    if (result.hasError()) {
+        throw std::runtime_error("in-process conversion failed");
+    }
+    return static_cast<std::size_t>(output.tellp());
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned runs = 20;
+    std::filesystem::path cliPath = utils::utf8ToPath(DENIGMA_BENCH_CLI_PATH);
+    std::filesystem::path outputPath;
+    std::filesystem::path inputPath = std::filesystem::path(DENIGMA_BENCH_INPUT_PATH) / DEFAULT_INPUT;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view arg = argv[index];
+        try {
+            if (arg == "--runs" && index + 1 < argc) {
+                runs = static_cast<unsigned>(std::max(1, std::stoi(argv[++index])));
+            } else if (arg == "--cli" && index + 1 < argc) {
+                cliPath = utils::utf8ToPath(argv[++index]);
+            } else if (arg == "--output" && index + 1 < argc) {
+                outputPath = utils::utf8ToPath(argv[++index]);
+            } else if (arg.starts_with("--")) {
+                throw std::invalid_argument("unknown option " + std::string(arg));
+            } else {
+                inputPath = utils::utf8ToPath(arg);
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << "\n"
+                      << "usage: denigma_bench_startup [--runs N] [--cli path/to/denigma] [--output results.json] [input.musx]\n";
+            return 1;
+        }
+    }
+
+    const std::filesystem::path workDir = std::filesystem::temp_directory_path() / "denigma_bench_startup";
+    std::filesystem::create_directories(workDir);
+    const std::filesystem::path mnxPath = workDir / "startup.mnx";
+    const std::string versionCommand = quoted(cliPath) + " --version";
+    const std::string exportCommand = quoted(cliPath) + " export " + quoted(inputPath) + " --mnx " + quoted(mnxPath)
+        + " --force --no-log --quiet";
+
+    nlohmann::ordered_json report;
+    report["denigmaVersion"] = DENIGMA_VERSION;
+    report["input"] = utils::pathToString(inputPath.filename());
+    report["runs"] = runs;
+    int exitCode = 0;
+    try {
+        std::vector<double> versionTimes, exportTimes, inProcessTimes;
+        for (unsigned run = 0; run < runs; ++run) {
+            versionTimes.push_back(timeMilliseconds([&]() { runCommand(versionCommand); }));
+            exportTimes.push_back(timeMilliseconds([&]() { runCommand(exportCommand); }));
+        }
+        std::size_t bytesOut = convertInProcess(inputPath); // warms this process's caches, as a long-lived server would be
+        for (unsigned run = 0; run < runs; ++run) {
+            inProcessTimes.push_back(timeMilliseconds([&]() { bytesOut = convertInProcess(inputPath); }));
+        }
+        report["processStart"] = timingsJson(versionTimes);
+        report["coldExport"] = timingsJson(exportTimes);
+        report["warmConversion"] = timingsJson(inProcessTimes);
+        report["warmConversion"]["bytesOut"] = bytesOut;
+        report["overheadMilliseconds"] = report["coldExport"]["minMilliseconds"].get<double>()
+            - report["warmConversion"]["minMilliseconds"].get<double>();
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        exitCode = 1;
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(workDir, ec);
+
+    const std::string text = report.dump(2) + "\n";
+    if (outputPath.empty()) {
+        std::cout << text;
+    } else {
+        std::ofstream output(outputPath, std::ios::binary);
+        output << text;
+    }
+    return exitCode;
+}
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// denigma_bench_textmetrics: what measuring text costs in each text-metrics mode, and how far the heuristic estimates
+// are from the installed fonts, over the text of every fixture.
+//
+//     denigma_bench_textmetrics [--passes N] [--output results.json]
+//
+// The strings are the font runs of every text expression in tests/data/inputs. Each mode measures all of them once
+// cold, then N more times warm. Heuristic runs first, since it never touches the font backend and so leaves the
+// backend cold for the fonts pass. Fonts are measured through FreeType, with faces found by whichever platform
+// resolver this build has (fontconfig, CoreText or DirectWrite, else the font index). Fonts with a built-in metric
+// table are measured from the table in both modes and are reported apart, since they cannot differ. Accuracy is
+// the heuristic advance relative to the fonts advance, over strings both modes could measure.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "core/denigma.h"
+#include "core/musx_reader.h"
+#include "formats/enigmaxml/enigmaxml.h"
+#include "musx/musx.h"
+#include "utils/stringutils.h"
+#include "utils/textmetrics.h"
+#include "utils/utf8_iterator.h"
+
+using namespace denigma;
+using namespace musx::dom;
+
+namespace {
+
+/// One run of text set in a single font.
+struct MeasuredString
+{
+    FontInfo font;
+    std::u32string text;
+};
+
+DocumentPtr loadDocument(const std::filesystem::path& path)
+{
+    DenigmaContext context(DENIGMA_NAME);
+    context.inputFilePath = path;
+    context.quiet = true;
+    const auto inputData = formats::enigmaxml::detail::extractMusxInputData(path, context);
+    return createMusxDocument<MusxReader>(inputData, context);
+}
+
+/// The font runs of every text expression of every musx document in the test inputs, in a stable order.
+std::vector<MeasuredString> loadCorpus()
+{
+    std::vector<std::filesystem::path> paths;
+    for (const auto& file : std::filesystem::directory_iterator(DENIGMA_BENCH_INPUT_PATH)) {
+        if (file.is_regular_file() && utils::pathExtensionEquals(file.path(), MUSX_EXTENSION)) {
+            paths.push_back(file.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<MeasuredString> result;
+    const musx::util::EnigmaString::EnigmaParsingOptions parsingOptions(musx::util::EnigmaString::AccidentalStyle::Unicode);
+    for (const auto& path : paths) {
+        const auto document = loadDocument(path);
+        for (const auto& def : document->getOthers()->getArray<others::TextExpressionDef>(SCORE_PARTID)) {
+            if (!def->getTextBlock()) {
+                continue;
+            }
+            const auto rawTextCtx = def->getRawTextCtx(SCORE_PARTID);
+            if (!rawTextCtx) {
+                continue;
+            }
+            rawTextCtx.parseEnigmaText([&](const std::string& chunk, const musx::util::EnigmaStyles& styles) -> bool {
+                if (!styles.font || chunk.empty()) {
+                    return true;
+                }
+                MeasuredString item{ *styles.font, {} };
+                if (utils::decodeToU32(chunk, item.text)) {
+                    result.push_back(std::move(item));
+                }
+                return true;
+            }, parsingOptions);
+        }
+    }
+    return result;
+}
+
+double timeSeconds(const std::function<void()>& work)
+{
+    const auto start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Measures every string once in mode and returns the advances, nullopt where the mode could not measure.
+std::vector<std::optional<double>> measureAll(const std::vector<MeasuredString>& corpus, TextMetricsMode mode)
+{
+    DenigmaContext context(DENIGMA_NAME);
+    context.quiet = true;
+    context.textMetrics = mode;
+    std::vector<std::optional<double>> advances;
+    advances.reserve(corpus.size());
+    for (const auto& item : corpus) {
+        const auto metrics = textmetrics::measureTextEvpu(item.font, item.text, std::nullopt, context);
+        advances.push_back(metrics ? std::optional<double>(metrics->advance) : std::nullopt);
+    }
+    return advances;
+}
+
+/// Cold and warm throughput of mode, with the advances of its cold pass.
+nlohmann::ordered_json benchmarkMode(const std::vector<MeasuredString>& corpus, TextMetricsMode mode, unsigned passes,
+    std::vector<std::optional<double>>& advances)
+{
+    const double strings = static_cast<double>(corpus.size());
+    const double coldSeconds = timeSeconds([&]() { advances = measureAll(corpus, mode); });
+    std::vector<double> warmSeconds;
+    for (unsigned pass = 0; pass < passes; ++pass) {
+        warmSeconds.push_back(timeSeconds([&]() { measureAll(corpus, mode); }));
+    }
+    std::sort(warmSeconds.begin(), warmSeconds.end());
+
+    nlohmann::ordered_json result;
+    result["coldStringsPerSecond"] = coldSeconds > 0.0 ? strings / coldSeconds : 0.0;
+    result["warmStringsPerSecond"] = warmSeconds.front() > 0.0 ? strings / warmSeconds.front() : 0.0;
+    result["warmMedianStringsPerSecond"] = warmSeconds[warmSeconds.size() / 2] > 0.0 ? strings / warmSeconds[warmSeconds.size() / 2] : 0.0;
+    result["unmeasured"] = std::count_if(advances.begin(), advances.end(), [](const auto& advance) { return !advance; });
+    return result;
+}
+
+/// Relative error of the heuristic advances against the fonts advances, skipping strings both measured identically.
+nlohmann::ordered_json accuracyJson(const std::vector<std::optional<double>>& heuristic, const std::vector<std::optional<double>>& fonts)
+{
+    std::vector<double> errors;
+    std::size_t identical = 0;
+    for (std::size_t index = 0; index < heuristic.size() && index < fonts.size(); ++index) {
+        if (!heuristic[index] || !fonts[index] || *fonts[index] <= 0.0) {
+            continue;
+        }
+        if (*heuristic[index] == *fonts[index]) {
+            ++identical; // a built-in table measured it in both modes
+            continue;
+        }
+        errors.push_back(std::abs(*heuristic[index] - *fonts[index]) / *fonts[index]);
+    }
+    nlohmann::ordered_json result;
+    result["compared"] = errors.size();
+    result["builtInTable"] = identical;
+    if (!errors.empty()) {
+        std::sort(errors.begin(), errors.end());
+        double sum = 0.0;
+        for (const double error : errors) {
+            sum += error;
+        }
+        result["meanRelativeError"] = sum / static_cast<double>(errors.size());
+        result["medianRelativeError"] = errors[errors.size() / 2];
+        result["p95RelativeError"] = errors[std::min(errors.size() - 1, errors.size() * 95 / 100)];
+        result["maxRelativeError"] = errors.back();
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned passes = 10;
+    std::filesystem::path outputPath;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view arg = argv[index];
+        try {
+            if (arg == "--passes" && index + 1 < argc) {
+                passes = static_cast<unsigned>(std::max(1, std::stoi(argv[++index])));
+            } else if (arg == "--output" && index + 1 < argc) {
+                outputPath = utils::utf8ToPath(argv[++index]);
+            } else {
+                throw std::invalid_argument("unknown option " + std::string(arg));
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << "\n"
+                      << "usage: denigma_bench_textmetrics [--passes N] [--output results.json]\n";
+            return 1;
+        }
+    }
+
+    nlohmann::ordered_json report;
+    report["denigmaVersion"] = DENIGMA_VERSION;
+    int exitCode = 0;
+    try {
+        const auto corpus = loadCorpus();
+        if (corpus.empty()) {
+            throw std::runtime_error("the fixture corpus has no text expressions");
+        }
+        report["strings"] = corpus.size();
+        report["passes"] = passes;
+        std::vector<std::optional<double>> heuristicAdvances, fontsAdvances;
+        report["heuristic"] = benchmarkMode(corpus, TextMetricsMode::Heuristic, passes, heuristicAdvances);
+        report["fonts"] = benchmarkMode(corpus, TextMetricsMode::Fonts, passes, fontsAdvances);
+        report["heuristicAccuracy"] = accuracyJson(heuristicAdvances, fontsAdvances);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        exitCode = 1;
+    }
+
+    const std::string text = report.dump(2) + "\n";
+    if (outputPath.empty()) {
+        std::cout << text;
+    } else {
+        std::ofstream output(outputPath, std::ios::binary);
+        output << text;
+    }
+    return exitCode;
+}
@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// denigma_stress: runs every registered converter over the fixture corpus on several threads at once, many times over,
+// and checks that each output is byte-identical to the one a single-threaded run produced. It exists to shake out races
+// in the per-document caches and other shared state, and to chart how conversion throughput scales with threads.
+//
+//     denigma_stress [--threads 1,2,4,...] [--iterations N] [--output results.json] [input.musx ...]
+//
+// Without inputs it runs every .musx file in tests/data/inputs. Half of the conversions of each input share one
+// PreparedDocument across all threads and half prepare their own, so both the shared-document path and the
+// per-document caches of independent documents are exercised. Single-threaded outputs are also compared with
+// tests/data/inputs/reference/<stem>.<ext> where such a file exists; those references were written with the test
+// suite's options, so a difference there is reported but is not a failure.
+//
+// For data race detection, build it with ThreadSanitizer:
+//
+//     cmake -S . -B build-tsan -Ddenigma_BUILD_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=RelWithDebInfo \
+//           -DCMAKE_CXX_FLAGS=-fsanitize=thread -DCMAKE_EXE_LINKER_FLAGS=-fsanitize=thread
+//     cmake --build build-tsan --target denigma_stress && build-tsan/bench/denigma_stress --iterations 2
+//
+// The exit code is nonzero if any conversion failed or any output differed from its single-threaded baseline.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "core/denigma.h"
+#include "core/xxhash64.h"
+#include "denigma/conversion.h"
+#include "denigma/formats/enigmaxml.h"
+#include "denigma/formats/mnx.h"
+#include "denigma/formats/mss.h"
+#include "denigma/formats/musicxml.h"
+#include "denigma/formats/svg.h"
+#include "denigma/io/random_access_reader.h"
+#include "denigma/prepared_document.h"
+#include "export/export.h"
+#include "utils/stringutils.h"
+
+using namespace denigma;
+
+namespace {
+
+struct TargetFormat
+{
+    FormatId format;
+    std::string_view name;
+    std::u8string_view extension;   ///< the extension of a reference output, or empty if there are none to compare
+};
+
+constexpr TargetFormat TARGET_FORMATS[] = {
+    { FormatId::EnigmaXml, "enigmaxml", ENIGMAXML_EXTENSION },
+    { FormatId::MnxJson, "mnx", {} },
+    { FormatId::MusicXml, "musicxml", MUSICXML_EXTENSION },
+    { FormatId::MssXml, "mss", MSS_EXTENSION },
+    { FormatId::Svg, "svg", {} },
+};
+
+template <typename OptionsT>
+std::unique_ptr<IOptions> configuredOptions(const std::string& sourceName)
+{
+    auto options = std::make_unique<OptionsT>();
+    options->common.sourceName = sourceName;
+    options->common.quiet = true;
+    return options;
+}
+
+std::unique_ptr<IOptions> makeOptions(FormatId format, const std::string& sourceName)
+{
+    switch (format) {
+    case FormatId::EnigmaXml: return configuredOptions<formats::enigmaxml::Options>(sourceName);
+    case FormatId::MnxJson: return configuredOptions<formats::mnx::Options>(sourceName);
+    case FormatId::MusicXml: return configuredOptions<formats::musicxml::Options>(sourceName);
+    case FormatId::MssXml: return configuredOptions<formats::mss::Options>(sourceName);
+    case FormatId::Svg: return configuredOptions<formats::svg::Options>(sourceName);
+    case FormatId::Musx: break;
+    }
+    return nullptr;
+}
+
+void throwIfFailed(const ConversionResult& result, std::string_view what)
+{
+    if (result.hasError()) {
+        std::string message(what);
+        for (const auto& diagnostic : result.diagnostics()) {
+            if (diagnostic.severity == MessageSeverity::Error) {
+                message += ": " + diagnostic.message;
+                break;
+            }
+        }
+        throw std::runtime_error(message);
+    }
+}
+
+/// Fingerprints every output of one conversion. Outputs are hashed by name, so the order a converter writes them in
+/// does not matter, and a name written in several pieces hashes as if written at once.
+class OutputFingerprint
+{
+public:
+    void add(std::string_view name, std::span<const std::byte> data)
+    { m_outputs[std::string(name)].update(data); }
+
+    std::uint64_t digest() const
+    {
+        Xxh64 combined;
+        for (const auto& [name, hash] : m_outputs) {
+            const std::uint64_t value = hash.digest();
+            combined.update(std::as_bytes(std::span(name.data(), name.size() + 1)));
+            combined.update(std::as_bytes(std::span(&value, 1)));
+        }
+        return combined.digest();
+    }
+
+    /// The hash of the only output, as a file holding it would hash, or nothing if there were several.
+    std::optional<std::uint64_t> singleOutputDigest() const
+    {
+        if (m_outputs.size() != 1) {
+            return std::nullopt;
+        }
+        return m_outputs.begin()->second.digest();
+    }
+
+private:
+    std::map<std::string, Xxh64> m_outputs;
+};
+
+/// One input, with the prepared document that the shared-document conversions of all threads use.
+struct StressInput
+{
+    std::filesystem::path path;
+    std::string sourceName;
+    std::unique_ptr<PreparedDocument> shared;
+};
+
+/// One input converted to one format, with the single-threaded output it must reproduce.
+struct StressCase
+{
+    const StressInput* input{};
+    const TargetFormat* target{};
+    std::unique_ptr<IOptions> options;
+    std::uint64_t baseline{};
+    std::optional<std::uint64_t> singleOutputBaseline;
+};
+
+PreparedDocument prepare(const std::filesystem::path& path, const std::string& sourceName)
+{
+    CommonOptions common;
+    common.sourceName = sourceName;
+    common.quiet = true;
+    auto prepared = PreparedDocument::fromMusx(FileRandomAccessReader(path), common);
+    throwIfFailed(prepared.preparationResult(), "extraction failed");
+    return prepared;
+}
+
+/// Converts one case and fingerprints the output. A prepared-document format converts the input's shared document
+/// when useShared is set, and a document of its own otherwise; EnigmaXML output always reads the musx file.
+OutputFingerprint convertCase(const StressCase& stressCase, bool useShared)
+{
+    const ConverterRegistry& registry = defaultConverterRegistry();
+    const ConversionRequest request{ stressCase.options.get() };
+    OutputFingerprint result;
+    if (stressCase.target->format == FormatId::EnigmaXml) {
+        const auto* converter = registry.findReader(FormatId::Musx, FormatId::EnigmaXml);
+        std::ostringstream output;
+        throwIfFailed(converter->convert(FileRandomAccessReader(stressCase.input->path), output, request),
+            "enigmaxml conversion failed");
+        const std::string text = std::move(output).str();
+        result.add({}, std::as_bytes(std::span(text)));
+        return result;
+    }
+    const auto* converter = registry.findPrepared(stressCase.target->format);
+    auto collect = [&result](std::string_view name, std::span<const std::byte> data) { result.add(name, data); };
+    if (useShared) {
+        throwIfFailed(converter->convert(*stressCase.input->shared, collect, request), "conversion failed");
+    } else {
+        const PreparedDocument own = prepare(stressCase.input->path, stressCase.input->sourceName);
+        throwIfFailed(converter->convert(own, collect, request), "conversion failed");
+    }
+    return result;
+}
+
+/// Whether the single-threaded output of stressCase matches its reference file: null if there is none to compare.
+nlohmann::ordered_json referenceMatch(const StressCase& stressCase)
+{
+    if (stressCase.target->extension.empty() || !stressCase.singleOutputBaseline) {
+        return nullptr;
+    }
+    std::filesystem::path referencePath = std::filesystem::path(DENIGMA_BENCH_INPUT_PATH) / "reference"
+        / stressCase.input->path.stem();
+    referencePath += u8".";
+    referencePath += stressCase.target->extension;
+    std::ifstream reference(referencePath, std::ios::binary);
+    if (!reference) {
+        return nullptr;
+    }
+    const std::string text{ std::istreambuf_iterator<char>(reference), std::istreambuf_iterator<char>() };
+    return Xxh64::hash(std::as_bytes(std::span(text))) == *stressCase.singleOutputBaseline;
+}
+
+/// Converts every case iterations times on threadCount threads and checks each output against its baseline.
+nlohmann::ordered_json runStress(const std::vector<StressCase>& cases, unsigned threadCount, unsigned iterations,
+    std::atomic<unsigned>& failures)
+{
+    const std::size_t taskCount = cases.size() * iterations;
+    std::atomic<std::size_t> nextTask{ 0 };
+    std::atomic<unsigned> mismatches{ 0 };
+    std::atomic<unsigned> errors{ 0 };
+    std::mutex reportMutex;
+
+    auto worker = [&]() {
+        for (std::size_t task = nextTask++; task < taskCount; task = nextTask++) {
+            const StressCase& stressCase = cases[task % cases.size()];
+            const bool useShared = (task / cases.size()) % 2 == 0;
+            try {
+                if (convertCase(stressCase, useShared).digest() != stressCase.baseline) {
+                    ++mismatches;
+                    const std::lock_guard lock(reportMutex);
+                    std::cerr << stressCase.input->sourceName << " -> " << stressCase.target->name << " ("
+                              << (useShared ? "shared" : "own") << " document, " << threadCount
+                              << " threads): output differs from the single-threaded baseline\n";
+                }
+            } catch (const std::exception& ex) {
+                ++errors;
+                const std::lock_guard lock(reportMutex);
+                std::cerr << stressCase.input->sourceName << " -> " << stressCase.target->name << " (" << threadCount
+                          << " threads): " << ex.what() << "\n";
+            }
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (unsigned index = 0; index < threadCount; ++index) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    failures += mismatches + errors;
+
+    nlohmann::ordered_json result;
+    result["threads"] = threadCount;
+    result["conversions"] = taskCount;
+    result["wallSeconds"] = wallSeconds;
+    result["conversionsPerSecond"] = wallSeconds > 0 ? static_cast<double>(taskCount) / wallSeconds : 0.0;
+    result["mismatches"] = mismatches.load();
+    result["errors"] = errors.load();
+    return result;
+}
+
+std::vector<std::filesystem::path> defaultInputs()
+{
+    std::vector<std::filesystem::path> result;
+    for (const auto& file : std::filesystem::directory_iterator(DENIGMA_BENCH_INPUT_PATH)) {
+        if (file.is_regular_file() && utils::pathExtensionEquals(file.path(), MUSX_EXTENSION)) {
+            result.push_back(file.path());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/// Parses a --threads argument, "n1,n2,...".
+std::vector<unsigned> parseThreadCounts(std::string_view arg)
+{
+    std::vector<unsigned> result;
+    std::istringstream counts{ std::string(arg) };
+    for (std::string value; std::getline(counts, value, ',');) {
+        result.push_back(static_cast<unsigned>(std::max(1, std::stoi(value))));
+    }
+    if (result.empty()) {
+        throw std::invalid_argument("expected thread counts");
+    }
+    return result;
+}
+
+std::vector<unsigned> defaultThreadCounts()
+{
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> result;
+    for (unsigned count = 1; count < hardware; count *= 2) {
+        result.push_back(count);
+    }
+    result.push_back(hardware);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<unsigned> threadCounts;
+    unsigned iterations = 4;
+    std::filesystem::path outputPath;
+    std::vector<std::filesystem::path> inputPaths;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view arg = argv[index];
+        try {
+            if (arg == "--threads" && index + 1 < argc) {
+                threadCounts = parseThreadCounts(argv[++index]);
+            } else if (arg == "--iterations" && index + 1 < argc) {
+                iterations = static_cast<unsigned>(std::max(1, std::stoi(argv[++index])));
+            } else if (arg == "--output" && index + 1 < argc) {
+                outputPath = utils::utf8ToPath(argv[++index]);
+            } else if (arg.starts_with("--")) {
+                throw std::invalid_argument("unknown option " + std::string(arg));
+            } else {
+                inputPaths.push_back(utils::utf8ToPath(arg));
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << "\n"
+                      << "usage: denigma_stress [--threads 1,2,4,...] [--iterations N] [--output results.json] [input.musx ...]\n";
+            return 1;
+        }
+    }
+    if (inputPaths.empty()) {
+        inputPaths = defaultInputs();
+    }
+    if (threadCounts.empty()) {
+        threadCounts = defaultThreadCounts();
+    }
+
+    int exitCode = 0;
+    std::vector<StressInput> inputs;
+    inputs.reserve(inputPaths.size());
+    for (const auto& path : inputPaths) {
+        const std::string sourceName = utils::pathToString(path.filename());
+        try {
+            inputs.push_back({ path, sourceName, std::make_unique<PreparedDocument>(prepare(path, sourceName)) });
+        } catch (const std::exception& ex) {
+            std::cerr << sourceName << ": " << ex.what() << "\n";
+            exitCode = 1;
+        }
+    }
+
+    // the single-threaded outputs are the baselines every threaded run must reproduce
+    nlohmann::ordered_json report;
+    report["denigmaVersion"] = DENIGMA_VERSION;
+    report["iterations"] = iterations;
+    report["cases"] = nlohmann::ordered_json::array();
+    std::vector<StressCase> cases;
+    for (const auto& input : inputs) {
+        for (const auto& target : TARGET_FORMATS) {
+            StressCase stressCase{ &input, &target, makeOptions(target.format, input.sourceName) };
+            try {
+                const OutputFingerprint fingerprint = convertCase(stressCase, false);
+                stressCase.baseline = fingerprint.digest();
+                stressCase.singleOutputBaseline = fingerprint.singleOutputDigest();
+            } catch (const std::exception& ex) {
+                std::cerr << input.sourceName << " -> " << target.name << ": " << ex.what() << "\n";
+                exitCode = 1;
+                continue;
+            }
+            nlohmann::ordered_json caseJson;
+            caseJson["input"] = input.sourceName;
+            caseJson["format"] = target.name;
+            caseJson["outputHash"] = Xxh64::toHex(stressCase.baseline);
+            caseJson["referenceMatch"] = referenceMatch(stressCase);
+            report["cases"].push_back(std::move(caseJson));
+            cases.push_back(std::move(stressCase));
+        }
+    }
+
+    std::atomic<unsigned> failures{ 0 };
+    report["runs"] = nlohmann::ordered_json::array();
+    if (!cases.empty()) {
+        double singleThreadRate = 0;
+        for (const unsigned threadCount : threadCounts) {
+            auto run = runStress(cases, threadCount, iterations, failures);
+            const double rate = run["conversionsPerSecond"].get<double>();
+            if (singleThreadRate == 0) {
+                // efficiency is measured against the first run, normally one thread
+                singleThreadRate = rate / threadCounts.front();
+            }
+            run["efficiency"] = singleThreadRate > 0 ? rate / (singleThreadRate * threadCount) : 0.0;
+            std::cerr << threadCount << " threads: " << run["conversionsPerSecond"].get<double>() << " conversions/s, "
+                      << "efficiency " << run["efficiency"].get<double>() << "\n";
+            report["runs"].push_back(std::move(run));
+        }
+    }
+    if (failures > 0) {
+        std::cerr << failures.load() << " conversions failed or differed from their single-threaded baselines\n";
+        exitCode = 1;
+    }
+
+    const std::string text = report.dump(2) + "\n";
+    if (outputPath.empty()) {
+        std::cout << text;
+    } else {
+        std::ofstream output(outputPath, std::ios::binary);
+        output << text;
+    }
+    return exitCode;
+}
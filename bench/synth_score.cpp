@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+// denigma_synth_score: writes a large EnigmaXML score tiled from an existing musx or EnigmaXML file, for benchmarking
+// the converters (or any other reader) at sizes the fixture corpus does not reach.
+//
+//     denigma_synth_score [--measures N] [--staves N] [--expressions N] input.musx output.enigmaxml
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/denigma.h"
+#include "denigma/io/random_access_reader.h"
+#include "denigma/prepared_document.h"
+#include "formats/enigmaxml/prepared_document.h"
+#include "utils/stringutils.h"
+
+#include "synthetic_score.h"
+
+using namespace denigma;
+
+namespace {
+
+std::string readEnigmaXml(const std::filesystem::path& inputPath)
+{
+    if (utils::pathExtensionEquals(inputPath, MUSX_EXTENSION)) {
+        CommonOptions common;
+        common.quiet = true;
+        const auto prepared = PreparedDocument::fromMusx(FileRandomAccessReader(inputPath), common);
+        if (prepared.preparationResult().hasError()) {
+            throw std::runtime_error("unable to extract " + utils::pathToString(inputPath));
+        }
+        const auto xml = prepared.impl().inputData().primaryXml();
+        return std::string(xml.data(), xml.size());
+    }
+    std::ifstream input(inputPath, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("unable to read " + utils::pathToString(inputPath));
+    }
+    return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::SyntheticScoreOptions options;
+    std::vector<std::filesystem::path> paths;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view arg = argv[index];
+        auto factor = [&]() { return static_cast<unsigned>(std::max(1, std::stoi(argv[++index]))); };
+        if (arg == "--measures" && index + 1 < argc) {
+            options.measureCopies = factor();
+        } else if (arg == "--staves" && index + 1 < argc) {
+            options.staffCopies = factor();
+        } else if (arg == "--expressions" && index + 1 < argc) {
+            options.expressionCopies = factor();
+        } else if (arg.starts_with("--")) {
+            paths.clear();
+            break;
+        } else {
+            paths.push_back(utils::utf8ToPath(arg));
+        }
+    }
+    if (paths.size() != 2) {
+        std::cerr << "usage: denigma_synth_score [--measures N] [--staves N] [--expressions N] input.musx output.enigmaxml\n";
+        return 1;
+    }
+
+    try {
+        const std::string score = bench::buildSyntheticScore(readEnigmaXml(paths[0]), options);
+        std::ofstream output(paths[1], std::ios::binary);
+        output << score;
+        if (!output) {
+            throw std::runtime_error("unable to write " + utils::pathToString(paths[1]));
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "synthetic_score.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "pugixml.hpp"
+
+namespace denigma::bench {
+
+namespace {
+
+/// Staff numbers from here up are reserved by Finale (32767 is the scroll-view staff).
+constexpr std::uint32_t RESERVED_STAFF = 32767;
+/// Vertical distance in EVPUs between the staves added to a system.
+constexpr int STAFF_SPACING = 288;
+
+std::uint32_t attributeNumber(pugi::xml_node node, const char* name)
+{ return node.attribute(name).as_uint(); }
+
+std::uint32_t childNumber(pugi::xml_node node, const char* name)
+{ return node.child(name).text().as_uint(); }
+
+void setChildNumber(pugi::xml_node node, const char* name, std::uint32_t value)
+{ node.child(name).text().set(value); }
+
+/// Is the record in the score rather than in one linked part?
+bool isScoreRecord(pugi::xml_node node)
+{ return attributeNumber(node, "part") == 0; }
+
+std::vector<pugi::xml_node> childrenNamed(pugi::xml_node family, const char* name)
+{
+    std::vector<pugi::xml_node> result;
+    for (auto child : family.children(name)) {
+        result.push_back(child);
+    }
+    return result;
+}
+
+/// Copies the music of the document's frames. Each call to copyFrame makes an independent copy, with its own frame
+/// number and entry numbers, so the same frame can be tiled any number of times and a copy can itself be copied.
+class FrameCopier
+{
+public:
+    FrameCopier(pugi::xml_node others, pugi::xml_node details, pugi::xml_node entries)
+        : m_others(others), m_details(details), m_entries(entries)
+    {
+        for (auto frame : others.children("frameSpec")) {
+            const std::uint32_t cmper = attributeNumber(frame, "cmper");
+            m_frames[cmper].push_back(frame);
+            m_nextFrame = std::max(m_nextFrame, cmper + 1);
+        }
+        for (auto entry : entries.children("entry")) {
+            const std::uint32_t entnum = attributeNumber(entry, "entnum");
+            m_entryNodes.emplace(entnum, entry);
+            m_nextEntry = std::max(m_nextEntry, entnum + 1);
+        }
+        for (auto detail : details.children()) {
+            if (const std::uint32_t entnum = attributeNumber(detail, "entnum")) {
+                m_entryDetails[entnum].push_back(detail);
+            }
+        }
+    }
+
+    /// Returns the number of a new copy of frame, or 0 if frame is 0 or not in the document.
+    std::uint32_t copyFrame(std::uint32_t frame)
+    {
+        const auto found = m_frames.find(frame);
+        if (frame == 0 || found == m_frames.end()) {
+            return 0;
+        }
+        const std::uint32_t newFrame = m_nextFrame++;
+        const std::vector<pugi::xml_node> sources = found->second;
+        for (auto source : sources) {
+            auto copy = m_others.append_copy(source);
+            copy.attribute("cmper").set_value(newFrame);
+            if (const std::uint32_t start = childNumber(source, "startEntry")) {
+                const auto [newStart, newEnd] = copyEntries(start, childNumber(source, "endEntry"));
+                setChildNumber(copy, "startEntry", newStart);
+                setChildNumber(copy, "endEntry", newEnd);
+            }
+            m_frames[newFrame].push_back(copy); // a copied frame holder can be copied again
+        }
+        return newFrame;
+    }
+
+private:
+    /// Copies the chain of entries from start to end, with their details, and returns the new start and end.
+    std::pair<std::uint32_t, std::uint32_t> copyEntries(std::uint32_t start, std::uint32_t end)
+    {
+        std::uint32_t newStart = 0;
+        std::uint32_t newEnd = 0;
+        pugi::xml_node previous;
+        for (std::uint32_t entnum = start; entnum != 0;) {
+            const auto found = m_entryNodes.find(entnum);
+            if (found == m_entryNodes.end()) {
+                break;
+            }
+            const pugi::xml_node source = found->second;
+            const std::uint32_t newEntnum = m_nextEntry++;
+            auto copy = m_entries.append_copy(source);
+            copy.attribute("entnum").set_value(newEntnum);
+            copy.attribute("prev").set_value(previous ? attributeNumber(previous, "entnum") : 0);
+            copy.attribute("next").set_value(0);
+            if (previous) {
+                previous.attribute("next").set_value(newEntnum);
+            }
+            if (const auto details = m_entryDetails.find(entnum); details != m_entryDetails.end()) {
+                std::vector<pugi::xml_node> newDetails;
+                for (auto detail : details->second) {
+                    newDetails.push_back(m_details.append_copy(detail));
+                    newDetails.back().attribute("entnum").set_value(newEntnum);
+                }
+                m_entryDetails.emplace(newEntnum, std::move(newDetails));
+            }
+            m_entryNodes.emplace(newEntnum, copy);
+            newStart = newStart ? newStart : newEntnum;
+            newEnd = newEntnum;
+            previous = copy;
+            if (entnum == end) {
+                break;
+            }
+            entnum = attributeNumber(source, "next");
+        }
+        return { newStart, newEnd };
+    }
+
+    pugi::xml_node m_others;
+    pugi::xml_node m_details;
+    pugi::xml_node m_entries;
+    std::unordered_map<std::uint32_t, std::vector<pugi::xml_node>> m_frames;
+    std::unordered_map<std::uint32_t, pugi::xml_node> m_entryNodes; ///< every entry, including the copies
+    std::unordered_map<std::uint32_t, std::vector<pugi::xml_node>> m_entryDetails;
+    std::uint32_t m_nextFrame{ 1 };
+    std::uint32_t m_nextEntry{ 1 };
+};
+
+/// Appends a copy of a frame holder (one staff in one measure) at staff and measure, with copies of its frames.
+void copyFrameHolder(pugi::xml_node details, pugi::xml_node source, std::uint32_t staff, std::uint32_t measure,
+    FrameCopier& frames)
+{
+    auto copy = details.append_copy(source);
+    copy.attribute("cmper1").set_value(staff);
+    copy.attribute("cmper2").set_value(measure);
+    for (const char* layer : { "frame1", "frame2", "frame3", "frame4" }) {
+        if (auto frame = copy.child(layer)) {
+            frame.text().set(frames.copyFrame(frame.text().as_uint()));
+        }
+    }
+}
+
+/// Appends copies of a measure-keyed family's records, renumbered from measure to newMeasure.
+void copyMeasureRecords(pugi::xml_node others, const char* name, std::uint32_t measure, std::uint32_t newMeasure)
+{
+    for (auto record : childrenNamed(others, name)) {
+        if (attributeNumber(record, "cmper") == measure) {
+            others.append_copy(record).attribute("cmper").set_value(newMeasure);
+        }
+    }
+}
+
+void tileMeasures(pugi::xml_node others, pugi::xml_node details, unsigned copies, FrameCopier& frames)
+{
+    std::vector<std::uint32_t> measures;
+    for (auto measure : others.children("measSpec")) {
+        measures.push_back(attributeNumber(measure, "cmper"));
+    }
+    if (measures.empty()) {
+        return;
+    }
+    const std::uint32_t measureCount = *std::max_element(measures.begin(), measures.end());
+    const auto frameHolders = childrenNamed(details, "gfhold");
+    for (unsigned copy = 1; copy < copies; ++copy) {
+        const std::uint32_t offset = copy * measureCount;
+        for (const std::uint32_t measure : measures) {
+            for (const char* family : { "measSpec", "measExprAssign", "textRepeatAssign" }) {
+                copyMeasureRecords(others, family, measure, measure + offset);
+            }
+        }
+        for (auto holder : frameHolders) {
+            if (isScoreRecord(holder)) {
+                copyFrameHolder(details, holder, attributeNumber(holder, "cmper1"),
+                    attributeNumber(holder, "cmper2") + offset, frames);
+            }
+        }
+    }
+}
+
+void tileStaves(pugi::xml_node others, pugi::xml_node details, unsigned copies, FrameCopier& frames)
+{
+    std::vector<std::uint32_t> staves;
+    for (auto staff : others.children("staffSpec")) {
+        if (const std::uint32_t cmper = attributeNumber(staff, "cmper"); cmper < RESERVED_STAFF) {
+            staves.push_back(cmper);
+        }
+    }
+    if (staves.empty() || copies <= 1) {
+        return;
+    }
+    const std::uint32_t staffCount = *std::max_element(staves.begin(), staves.end());
+    if (static_cast<std::uint64_t>(staffCount) * copies >= RESERVED_STAFF) {
+        throw std::runtime_error("too many staff copies: staff numbers would reach " + std::to_string(RESERVED_STAFF));
+    }
+    const auto frameHolders = childrenNamed(details, "gfhold");
+    const auto staffRecords = childrenNamed(others, "staffSpec");
+    const auto systemStaves = childrenNamed(others, "instUsed");
+
+    // every system's staff list, in order, so that the copies can be added below its last staff
+    std::unordered_map<std::uint32_t, std::vector<pugi::xml_node>> systems;
+    for (auto slot : systemStaves) {
+        if (isScoreRecord(slot)) {
+            systems[attributeNumber(slot, "cmper")].push_back(slot);
+        }
+    }
+
+    for (unsigned copy = 1; copy < copies; ++copy) {
+        const std::uint32_t offset = copy * staffCount;
+        for (auto staff : staffRecords) {
+            if (const std::uint32_t cmper = attributeNumber(staff, "cmper"); cmper < RESERVED_STAFF) {
+                auto newStaff = others.append_copy(staff);
+                newStaff.attribute("cmper").set_value(cmper + offset);
+                newStaff.remove_child("instUuid"); // each copy is its own instrument
+            }
+        }
+        for (auto holder : frameHolders) {
+            if (const std::uint32_t staff = attributeNumber(holder, "cmper1"); staff < RESERVED_STAFF && isScoreRecord(holder)) {
+                copyFrameHolder(details, holder, staff + offset, attributeNumber(holder, "cmper2"), frames);
+            }
+        }
+    }
+
+    for (auto& [system, slots] : systems) {
+        std::uint32_t nextInci = 0;
+        int lowest = 0;
+        for (auto slot : slots) {
+            nextInci = std::max(nextInci, attributeNumber(slot, "inci") + 1);
+            lowest = std::min(lowest, slot.child("distFromTop").text().as_int());
+        }
+        const std::vector<pugi::xml_node> originals = slots;
+        for (unsigned copy = 1; copy < copies; ++copy) {
+            for (auto slot : originals) {
+                const std::uint32_t staff = childNumber(slot, "inst");
+                if (staff >= RESERVED_STAFF) {
+                    continue;
+                }
+                auto newSlot = others.append_copy(slot);
+                newSlot.attribute("inci").set_value(nextInci++);
+                setChildNumber(newSlot, "inst", staff + copy * staffCount);
+                lowest -= STAFF_SPACING;
+                newSlot.child("distFromTop").text().set(lowest);
+            }
+        }
+    }
+}
+
+void tileExpressions(pugi::xml_node others, unsigned copies)
+{
+    const auto assignments = childrenNamed(others, "measExprAssign");
+    std::unordered_map<std::uint32_t, std::uint32_t> nextInci;
+    for (auto assignment : assignments) {
+        auto& next = nextInci[attributeNumber(assignment, "cmper")];
+        next = std::max(next, attributeNumber(assignment, "inci") + 1);
+    }
+    for (unsigned copy = 1; copy < copies; ++copy) {
+        for (auto assignment : assignments) {
+            auto newAssignment = others.append_copy(assignment);
+            newAssignment.attribute("inci").set_value(nextInci[attributeNumber(assignment, "cmper")]++);
+        }
+    }
+}
+
+} // namespace
+
+std::string buildSyntheticScore(std::string_view enigmaXml, const SyntheticScoreOptions& options)
+{
+    pugi::xml_document document;
+    if (const auto result = document.load_buffer(enigmaXml.data(), enigmaXml.size()); !result) {
+        throw std::runtime_error(std::string("unable to parse EnigmaXML: ") + result.description());
+    }
+    auto root = document.document_element();
+    auto others = root.child("others");
+    auto details = root.child("details");
+    auto entries = root.child("entries");
+    if (!others) {
+        throw std::runtime_error("EnigmaXML document has no others element");
+    }
+    if (!details) {
+        details = root.insert_child_after("details", others);
+    }
+    if (!entries) {
+        entries = root.insert_child_after("entries", details);
+    }
+
+    FrameCopier frames(others, details, entries);
+    // measures first, so that the staff copies carry the added measures' music as well
+    tileMeasures(others, details, options.measureCopies, frames);
+    tileStaves(others, details, options.staffCopies, frames);
+    tileExpressions(others, options.expressionCopies);
+
+    std::ostringstream output;
+    document.save(output, "  ");
+    return std::move(output).str();
+}
+
+} // namespace denigma::bench
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace denigma::bench {
+
+/// @brief How many times each dimension of a fixture is tiled. 1 leaves that dimension as it is.
+struct SyntheticScoreOptions
+{
+    unsigned measureCopies{ 1 };    ///< the measures are appended this many times in all, with their music
+    unsigned staffCopies{ 1 };      ///< each staff is duplicated this many times in all, with its music, on every system
+    unsigned expressionCopies{ 1 }; ///< every measure-attached expression is assigned this many times in all
+};
+
+/// @brief Builds a larger EnigmaXML document by tiling the measures, staves and expressions of an existing one.
+///
+/// Entries are copied with their frames and entry details, so the density of the music (entries per measure, notes per
+/// entry) is whatever the source has. Page and system layout, smart shapes and linked parts are not tiled: the copies
+/// are reflowed by whatever reads the result, and linked parts see the new measures but not the new staves.
+/// @throws std::runtime_error if enigmaXml does not parse or a tiled staff number would reach the reserved range.
+std::string buildSyntheticScore(std::string_view enigmaXml, const SyntheticScoreOptions& options);
+
+} // namespace denigma::bench
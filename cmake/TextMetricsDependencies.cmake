@@ -4,6 +4,12 @@ set(_denigma_textmetrics_defines "")
 set(_denigma_textmetrics_libs "")
 set(_denigma_textmetrics_include_dirs "")
 
+if(NOT DENIGMA_TEXT_METRICS_FREETYPE)
+    # textmetrics.cpp falls back to the built-in metric tables and the heuristic mode.
+    message(STATUS "Text metrics backend disabled: using built-in metric tables and heuristic metrics only")
+    return()
+endif()
+
 # Build FreeType from source so we do not require external package installation.
 set(FT_DISABLE_HARFBUZZ ON CACHE BOOL "Disable HarfBuzz support in FreeType" FORCE)
 set(FT_DISABLE_BROTLI ON CACHE BOOL "Disable Brotli support in FreeType" FORCE)
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "denigma/conversion.h"
+
+namespace denigma {
+
+/// @struct BatchTarget
+/// @brief One output format of a BatchJob and where its documents go.
+struct BatchTarget
+{
+    FormatId format{};                  ///< Target format to produce.
+    const IOptions* options{};          ///< Adapter-specific options; must stay valid until convertMany returns.
+    IMultiOutputSink* sink{};           ///< Receives the target's documents. Each job's targets run one at a time.
+};
+
+/// @struct BatchJob
+/// @brief One source document and the formats to produce from it.
+struct BatchJob
+{
+    const IRandomAccessReader* input{}; ///< Source bytes; must stay valid until convertMany returns.
+    FormatId sourceFormat{ FormatId::Musx }; ///< Format of #input.
+    std::vector<BatchTarget> targets;   ///< Formats to produce, in order.
+    /// Memory the job needs while it runs, for BatchOptions::memoryBudget. 0 estimates it from the input size.
+    std::uint64_t estimatedBytes{};
+};
+
+/// @struct BatchOptions
+/// @brief Scheduling options for BatchConverter.
+struct BatchOptions
+{
+    /// Runs the jobs as tasks on this executor, with the calling thread helping. nullptr creates threads as needed.
+    /// Set CommonOptions::executor in the targets' options to the same executor so their inner work shares it.
+    IExecutor* executor{};
+    /// Maximum number of jobs converted at once. 0 uses the executor's concurrency, or all available cores.
+    unsigned jobs{ 0 };
+    /// Starts no job while the estimated memory of the running jobs would exceed this many bytes. A job that does
+    /// not fit on its own still runs when nothing else is running. 0 means no limit.
+    std::uint64_t memoryBudget{};
+};
+
+/// @class BatchConverter
+/// @brief Converts many documents concurrently with the converters of a registry.
+///
+/// Jobs are started largest first, so the long ones do not finish last on a single thread. A job with more than one
+/// target and a MUSX source is extracted and parsed once and shared by every target that has an
+/// IPreparedDocumentConverter; the other targets read the source with their IReaderMultiOutputConverter.
+class BatchConverter
+{
+public:
+    /// Receives the results of a finished job, one per BatchJob::targets entry and in the same order. Calls are
+    /// serialized but come from whichever thread ran the job. Must not throw.
+    using JobFinished = std::function<void(std::size_t jobIndex, std::vector<ConversionResult> results)>;
+
+    /// The registry must outlive the converter.
+    explicit BatchConverter(const ConverterRegistry& registry, BatchOptions options = {})
+        : m_registry(registry), m_options(options)
+    {
+    }
+
+    /// Converts every job and returns when all have finished. A target without a registered converter, or whose
+    /// conversion throws, reports the problem as an Error diagnostic in its result.
+    void convertMany(std::span<const BatchJob> jobs, const JobFinished& jobFinished) const;
+
+private:
+    const ConverterRegistry& m_registry;
+    BatchOptions m_options;
+};
+
+} // namespace denigma
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "denigma/classify/articulations.h"
+#include "denigma/classify/expressions.h"
+#include "musx/musx.h"
+
+namespace denigma {
+namespace classify {
+
+/// @class StringPool
+/// @brief Deduplicated strings that batch classification columns refer to by index.
+class StringPool
+{
+public:
+    /// Index meaning "no string".
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+    /// Returns the index of text, adding it if it is not already pooled.
+    std::uint32_t intern(std::string_view text);
+
+    /// Returns the string at index, or an empty view for #NONE.
+    std::string_view at(std::uint32_t index) const
+    { return index == NONE ? std::string_view{} : std::string_view(m_strings[index]); }
+
+    /// Number of distinct strings pooled.
+    std::size_t size() const noexcept
+    { return m_strings.size(); }
+
+private:
+    std::deque<std::string> m_strings;  ///< a deque, so the views used as index keys never move
+    std::unordered_map<std::string_view, std::uint32_t> m_indices;
+};
+
+/// @struct ExpressionColumns
+/// @brief Expression classifications for a list of assignments, one row per assignment, stored column by column.
+///
+/// Row i describes the i-th assignment passed to #classifyExpressionColumns. Only the enum codes and text survive, so a
+/// batch over a whole score (or a corpus of them) costs a few bytes per row instead of a full
+/// ExpressionClassification.
+struct ExpressionColumns
+{
+    /// Semantic class of each row.
+    std::vector<ExpressionType> types;
+    /// Reason for each row's classification.
+    std::vector<ClassificationBasis> bases;
+    /// The enum value within the class, where the class has one: dynamics::Dynamic for Dynamic,
+    /// expression::TechniqueText::Type for TechniqueText and keyboardpedal::Type for KeyboardPedal. Zero otherwise.
+    std::vector<std::uint16_t> subtypes;
+    /// Index into #strings of the row's text (tempo, technique, rehearsal, generic or error text), or StringPool::NONE.
+    std::vector<std::uint32_t> texts;
+    /// Text referred to by #texts.
+    StringPool strings;
+
+    /// Number of rows.
+    std::size_t size() const noexcept
+    { return types.size(); }
+};
+
+/// Classifies a list of expression assignments into columns. The results match #classifyExpressionAssignments,
+/// including top-staff propagation.
+ExpressionColumns classifyExpressionColumns(
+    const musx::dom::MusxInstanceList<musx::dom::others::MeasureExprAssign>& assignments);
+
+/// @enum ArticulationKind
+/// @brief The alternative held by an ArticulationValue, in variant order.
+enum class ArticulationKind : std::uint8_t
+{
+    None,
+    ArticulationMarks,
+    TechniqueMark,
+    HarmonMute,
+    Tremolo,
+    Fermata,
+    BreathMark,
+    Caesura,
+    Arpeggio,
+    Ornament,
+    VerticalEntryBracket,
+    Parenthesis,
+    PseudoTie,
+    OtherMark
+};
+
+/// @struct ArticulationColumns
+/// @brief Articulation classifications for a list of assignments, one row per assignment, stored column by column.
+struct ArticulationColumns
+{
+    /// Payload kind of each row; ArticulationKind::None for assignments that were not recognized.
+    std::vector<ArticulationKind> kinds;
+    /// Resolved placement of each row.
+    std::vector<musx::dom::VerticalPlacement> placements;
+    /// Index into #strings of each row's SMuFL glyph name, or StringPool::NONE.
+    std::vector<std::uint32_t> glyphNames;
+    /// Glyph names referred to by #glyphNames.
+    StringPool strings;
+
+    /// Number of rows.
+    std::size_t size() const noexcept
+    { return kinds.size(); }
+};
+
+/// Classifies a list of articulation assignments into columns. Each assignment is classified against the entry it is
+/// attached to, as #classifyArticulation would be.
+ArticulationColumns classifyArticulationColumns(
+    const musx::dom::MusxInstanceList<musx::dom::details::ArticulationAssign>& assignments);
+
+} // namespace classify
+} // namespace denigma
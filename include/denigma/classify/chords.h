@@ -113,5 +113,9 @@ ChordSuffixClassification classifyChordSuffix(
 /// Classifies a Finale chord with no displayed suffix as a major triad.
 ChordSuffixClassification classifyChordSuffix();
 
+/// Classifies the suffix a chord assignment displays, or a major triad when it displays none. Each suffix is
+/// reconstructed once per document, however many chords use it.
+ChordSuffixClassification classifyChordSuffix(const musx::dom::MusxInstance<musx::dom::details::ChordAssign>& assignment);
+
 } // namespace classify
 } // namespace denigma
@@ -21,15 +21,25 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <functional>
+#include <future>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <ostream>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
@@ -41,6 +51,8 @@ namespace denigma {
 
 /// @enum FormatId
 /// @brief Stable identifiers for converter input and output formats.
+///
+/// ConverterRegistry indexes by these values, so new formats go after Svg and update its FORMAT_COUNT.
 enum class FormatId
 {    
     Musx,       ///< Finale MUSX archive.  
@@ -48,7 +60,8 @@ enum class FormatId
     MnxJson,    ///< MNX JSON as produced by mnxdom.
     MusicXml,   ///< MusicXML score-partwise XML.
     MssXml,     ///< MuseScore style sheet XML.
-    Svg         ///< Scalable Vector Graphics XML.
+    Svg,        ///< Scalable Vector Graphics XML.
+    EnigmaBinary ///< Enigma XML content as a compact binary cache. Converters from EnigmaXml also read it.
 };
 
 /// @enum MessageSeverity
@@ -69,6 +82,74 @@ struct Diagnostic
     std::string message;                 ///< Human-readable diagnostic text.
 };
 
+/// @enum StatsReport
+/// @brief How a converter reports its ConversionStats when a conversion ends.
+enum class StatsReport
+{
+    None,   ///< Only ConversionResult::stats() has them.
+    Log,    ///< One human-readable line.
+    Json    ///< One JSON object (see ConversionStats::toJson).
+};
+
+/// @enum TextMetricsMode
+/// @brief How a converter measures text and glyphs whose size affects its output (SVG shapes, MSS style values).
+enum class TextMetricsMode
+{
+    Fonts,      ///< Measure with the installed fonts through the platform font backend.
+    Heuristic   ///< Estimate from per-font width classes without finding or loading any font file.
+};
+
+/// @class IExecutor
+/// @brief A caller-owned task runner that converters schedule their concurrent work on instead of creating threads.
+class IExecutor
+{
+public:
+    virtual ~IExecutor() = default;     ///< Virtual destructor
+
+    /// Runs task once, on any thread, at any later time. It must not run task inline before returning.
+    /// The converter waits only for tasks that have started, and runs work itself when no task has picked it up,
+    /// so a pool whose threads are all busy, including with the converter's own caller, does not deadlock.
+    virtual void submit(std::function<void()> task) = 0;
+
+    /// How many tasks can usefully run at once. Converters use it where CommonOptions::outputJobs is 0.
+    virtual unsigned concurrency() const = 0;
+};
+
+/// @class CancellationToken
+/// @brief A flag that a caller sets from any thread to stop the conversions it was given to.
+///
+/// Copies share the flag, so the caller keeps one copy and passes another in CommonOptions::cancellation.
+/// Converters check it between measures, parts, shapes and archive entries, so a conversion stops soon after
+/// #cancel rather than at once.
+class CancellationToken
+{
+public:
+    CancellationToken() : m_cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    /// Asks every conversion holding a copy of this token to stop.
+    void cancel() const noexcept
+    {
+        m_cancelled->store(true, std::memory_order_relaxed);
+    }
+
+    /// Returns true once #cancel has been called on any copy.
+    [[nodiscard]] bool isCancelled() const noexcept
+    {
+        return m_cancelled->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+/// @struct MeasureRange
+/// @brief An inclusive range of measures, numbered as Finale stores them (from 1, ignoring measure number regions).
+struct MeasureRange
+{
+    int first{ 1 };     ///< first measure converted
+    int last{ 1 };      ///< last measure converted
+};
+
 /// @struct CommonOptions
 /// @brief Options common to all public converter adapters.
 struct CommonOptions
@@ -77,10 +158,44 @@ struct CommonOptions
     std::string sourceName;
     /// Enables converter-specific output validation when supported.
     bool validate{ true };
+    /// Runs validation on a worker thread while the output is written. Its diagnostics still reach the
+    /// result and #logCallback before the conversion returns, after the output itself.
+    bool validateConcurrently{ false };
+    /// Validates only one in this many conversions in the process (the first, then every Nth), so batch
+    /// runs can spot-check output without paying for validation of every file. 0 and 1 validate every conversion.
+    unsigned validateEvery{ 1 };
     /// Enables verbose logging when supported by the caller.
     bool verbose{ false };
     /// Suppresses info/verbose logging when true.
     bool quiet{ false };
+    /// Maximum number of independent outputs (such as the score and each part) a converter may build
+    /// concurrently. 0 uses all available cores. Converters without concurrent support ignore it.
+    unsigned outputJobs{ 1 };
+    /// Upstream resource for the arena that holds a conversion's intermediate mapping state. The arena is
+    /// released in one step when the conversion ends. nullptr uses std::pmr::get_default_resource(). With
+    /// more than one output job, each concurrent output has its own arena, so the resource must be thread-safe.
+    std::pmr::memory_resource* memoryResource{};
+    /// Runs the concurrent work of a conversion (outputs, measure ranges, shapes, compression blocks and concurrent
+    /// validation) as tasks instead of on threads the converter creates. #outputJobs still caps how many of one step
+    /// run at once. nullptr creates threads as needed; with the default #outputJobs of 1 everything is serial.
+    IExecutor* executor{};
+    /// Stops the conversion with an error when cancelled. See ConversionResult::cancelled.
+    CancellationToken cancellation;
+    /// Stops the conversion with an error once this time has passed. Checked at the same points as #cancellation.
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    /// TextMetricsMode::Heuristic trades exact text sizes for throughput that does not depend on the fonts installed on
+    /// the host. Fonts with compiled-in metric tables are measured from those in either mode.
+    TextMetricsMode textMetrics{ TextMetricsMode::Fonts };
+    /// Sends the conversion's ConversionStats to #logCallback as one Info message when it ends, even when #quiet is set.
+    StatsReport statsReport{ StatsReport::None };
+    /// When set, timing spans of the conversion are written to this file in Chrome trace JSON format (chrome://tracing,
+    /// Perfetto), unless a trace of the whole process is already being recorded, which the spans then join.
+    std::filesystem::path traceFile;
+    /// Hashes each output with XXH64 while it is written. See ConversionResult::outputFingerprints.
+    bool fingerprintOutputs{ false };
+    /// When set, the fingerprint of each output is also appended to this file as one tab-separated line:
+    /// hash (16 hex digits), byte count, #sourceName and output name. Setting it implies #fingerprintOutputs.
+    std::filesystem::path fingerprintManifest;
     /// Optional callback that receives converter log messages. Defaults to no-op.
     std::function<void(MessageSeverity severity, std::string_view message)> logCallback = [](MessageSeverity, std::string_view) {};
 };
@@ -91,6 +206,9 @@ class IOptions
 {
 public:
     virtual ~IOptions() = default;      ///< Virtual destructor
+
+    /// Returns the CommonOptions within these options, or nullptr if they have none.
+    [[nodiscard]] virtual const CommonOptions* commonOptions() const noexcept { return nullptr; }
 };
 
 /// @struct ConversionRequest
@@ -101,6 +219,229 @@ struct ConversionRequest
     const IOptions* options{};
 };
 
+/// @struct ConversionStats
+/// @brief Where a conversion spent its time and how much it processed, for finding slow inputs.
+///
+/// Every moment of a conversion is charged to one phase; time not claimed by a more specific phase is Convert.
+/// Phases a conversion does not run stay zero: a prepared-document conversion has no Unzip, Decode or Inflate (see
+/// PreparedDocument::preparationResult), and only the first conversion of a document has BuildDom and the source
+/// counts (measures, entries, notes). Outputs built on worker threads are charged to the phase of the thread that
+/// waits for them.
+///
+/// Builds configured with DENIGMA_ALLOCATION_STATS also count the heap use of each phase (see #phaseMemory); other
+/// builds leave #memoryCounted false and the memory figures zero.
+///
+/// #hotPathCounts count how often the conversion fell back to a slow or approximate path, on any of its threads.
+struct ConversionStats
+{
+    /// @enum Phase
+    /// @brief The stages of a conversion, in the order they run.
+    enum class Phase
+    {
+        Unzip,      ///< Reading score.dat and the other files out of the musx archive.
+        Decode,     ///< Decoding the score.dat key stream.
+        Inflate,    ///< Decompressing score.dat into Enigma XML (or reading it from the XML cache).
+        BuildDom,   ///< Parsing the Enigma XML into the musx DOM.
+        Convert,    ///< Mapping the DOM to the target format.
+        Serialize,  ///< Writing the target document's bytes.
+        Validate    ///< Validating the output. Concurrent validation overlaps Serialize.
+    };
+    static constexpr std::size_t PHASE_COUNT = 7;   ///< Number of #Phase values.
+
+    /// @enum HotPath
+    /// @brief Slow or approximate paths whose frequency shows which features of a score drive conversion cost.
+    enum class HotPath
+    {
+        TextMetricsFallback,    ///< Text measured without a font face, because its font could not be resolved or loaded.
+        UnmatchedGlyph,         ///< A classified character with no SMuFL glyph name in its font.
+        ApproximateDivisions,   ///< A MusicXML position rounded to the nearest division.
+        CueHeuristic,           ///< Cue detection run for one staff and measure (later conversions reuse the result).
+        DiscardedCueFrame       ///< Cue material left out of the output.
+    };
+    static constexpr std::size_t HOT_PATH_COUNT = 5; ///< Number of #HotPath values.
+
+    /// @struct PhaseMemory
+    /// @brief The heap use of one phase, counted on the thread that times it.
+    struct PhaseMemory
+    {
+        std::uint64_t allocatedBytes{};  ///< Bytes allocated while the phase ran.
+        std::int64_t liveBytes{};        ///< Bytes allocated less bytes freed while the phase ran: what it left behind.
+        std::uint64_t peakBytes{};       ///< The most the live bytes rose above their level when the phase (re)started.
+    };
+
+    std::array<std::chrono::nanoseconds, PHASE_COUNT> phaseTimes{}; ///< Wall time of each phase, indexed by #Phase.
+    std::array<PhaseMemory, PHASE_COUNT> phaseMemory{};             ///< Heap use of each phase, indexed by #Phase.
+    bool memoryCounted{};           ///< True when the build counted allocations into #phaseMemory.
+    std::array<std::uint64_t, HOT_PATH_COUNT> hotPathCounts{};      ///< Times each #HotPath was taken, indexed by #HotPath.
+    std::uint64_t measures{};       ///< Measures in the source score.
+    std::uint64_t entries{};        ///< Entries (notes, chords and rests) in the source, in all parts.
+    std::uint64_t notes{};          ///< Notes in those entries.
+    std::uint64_t outputs{};        ///< Output documents delivered.
+    std::uint64_t bytesWritten{};   ///< Bytes of those outputs.
+    std::uint64_t cacheHits{};      ///< Lookups answered by the XML cache or the classification cache.
+    std::uint64_t cacheMisses{};    ///< Lookups those caches had to compute.
+
+    /// Returns the stable lower-case name of phase, as used by #toJson.
+    [[nodiscard]] static constexpr std::string_view phaseName(Phase phase) noexcept
+    {
+        constexpr std::array<std::string_view, PHASE_COUNT> NAMES{
+            "unzip", "decode", "inflate", "buildDom", "convert", "serialize", "validate" };
+        return NAMES[static_cast<std::size_t>(phase)];
+    }
+
+    /// Returns the stable lower-camel-case name of path, as used by #toJson.
+    [[nodiscard]] static constexpr std::string_view hotPathName(HotPath path) noexcept
+    {
+        constexpr std::array<std::string_view, HOT_PATH_COUNT> NAMES{
+            "textMetricsFallback", "unmatchedGlyph", "approximateDivisions", "cueHeuristic", "discardedCueFrame" };
+        return NAMES[static_cast<std::size_t>(path)];
+    }
+
+    /// Returns the number of times path was taken.
+    [[nodiscard]] std::uint64_t hotPathCount(HotPath path) const noexcept
+    {
+        return hotPathCounts[static_cast<std::size_t>(path)];
+    }
+
+    /// Returns the wall time charged to phase.
+    [[nodiscard]] std::chrono::nanoseconds phaseTime(Phase phase) const noexcept
+    {
+        return phaseTimes[static_cast<std::size_t>(phase)];
+    }
+
+    /// Charges duration to phase.
+    void addPhaseTime(Phase phase, std::chrono::nanoseconds duration) noexcept
+    {
+        phaseTimes[static_cast<std::size_t>(phase)] += duration;
+    }
+
+    /// Charges heap use to phase. A phase that runs in several stretches keeps the highest of their peaks.
+    void addPhaseMemory(Phase phase, const PhaseMemory& memory) noexcept
+    {
+        auto& total = phaseMemory[static_cast<std::size_t>(phase)];
+        total.allocatedBytes += memory.allocatedBytes;
+        total.liveBytes += memory.liveBytes;
+        total.peakBytes = (std::max)(total.peakBytes, memory.peakBytes);
+    }
+
+    /// Returns the sum of all phases.
+    [[nodiscard]] std::chrono::nanoseconds totalTime() const noexcept
+    {
+        std::chrono::nanoseconds result{};
+        for (const auto time : phaseTimes) {
+            result += time;
+        }
+        return result;
+    }
+
+    /// Returns the fraction of cache lookups that hit, or 0 when there were none.
+    [[nodiscard]] double cacheHitRate() const noexcept
+    {
+        const std::uint64_t lookups = cacheHits + cacheMisses;
+        return lookups ? static_cast<double>(cacheHits) / static_cast<double>(lookups) : 0.0;
+    }
+
+    /// Returns the stats as one line of JSON, with times in whole microseconds:
+    /// `{"phaseMicroseconds":{"unzip":0,...},"totalMicroseconds":0,"measures":0,...,"cacheMisses":0}`.
+    /// The counts are followed by `"hotPaths":{"textMetricsFallback":0,...}`. When #memoryCounted, a
+    /// `"phaseMemory":{"unzip":{"allocatedBytes":0,"liveBytes":0,"peakBytes":0},...}` member comes last.
+    [[nodiscard]] std::string toJson() const
+    {
+        std::string result = "{\"phaseMicroseconds\":{";
+        for (std::size_t index = 0; index < PHASE_COUNT; ++index) {
+            result += index ? ",\"" : "\"";
+            result += phaseName(static_cast<Phase>(index));
+            result += "\":" + std::to_string(microseconds(phaseTimes[index]));
+        }
+        result += "},\"totalMicroseconds\":" + std::to_string(microseconds(totalTime()));
+        for (const auto& [name, value] : counters()) {
+            result += ",\"";
+            result += name;
+            result += "\":" + std::to_string(value);
+        }
+        result += ",\"hotPaths\":{";
+        for (std::size_t index = 0; index < HOT_PATH_COUNT; ++index) {
+            result += index ? ",\"" : "\"";
+            result += hotPathName(static_cast<HotPath>(index));
+            result += "\":" + std::to_string(hotPathCounts[index]);
+        }
+        result += "}";
+        if (memoryCounted) {
+            result += ",\"phaseMemory\":{";
+            for (std::size_t index = 0; index < PHASE_COUNT; ++index) {
+                const auto& memory = phaseMemory[index];
+                result += index ? ",\"" : "\"";
+                result += phaseName(static_cast<Phase>(index));
+                result += "\":{\"allocatedBytes\":" + std::to_string(memory.allocatedBytes)
+                    + ",\"liveBytes\":" + std::to_string(memory.liveBytes)
+                    + ",\"peakBytes\":" + std::to_string(memory.peakBytes) + "}";
+            }
+            result += "}";
+        }
+        result += "}";
+        return result;
+    }
+
+    /// Returns the stats as one human-readable line, with times in milliseconds. Hot paths are listed only when taken.
+    [[nodiscard]] std::string summary() const
+    {
+        std::string result = "total " + std::to_string(microseconds(totalTime()) / 1000) + " ms (";
+        for (std::size_t index = 0; index < PHASE_COUNT; ++index) {
+            result += index ? ", " : "";
+            result += phaseName(static_cast<Phase>(index));
+            result += " " + std::to_string(microseconds(phaseTimes[index]) / 1000);
+        }
+        result += ")";
+        for (const auto& [name, value] : counters()) {
+            result += ", ";
+            result += name;
+            result += " " + std::to_string(value);
+        }
+        std::string hotPaths;
+        for (std::size_t index = 0; index < HOT_PATH_COUNT; ++index) {
+            if (hotPathCounts[index]) {
+                hotPaths += hotPaths.empty() ? "" : ", ";
+                hotPaths += hotPathName(static_cast<HotPath>(index));
+                hotPaths += " " + std::to_string(hotPathCounts[index]);
+            }
+        }
+        if (!hotPaths.empty()) {
+            result += ", hot paths (" + hotPaths + ")";
+        }
+        if (memoryCounted) {
+            result += ", peak KiB (";
+            for (std::size_t index = 0; index < PHASE_COUNT; ++index) {
+                result += index ? ", " : "";
+                result += phaseName(static_cast<Phase>(index));
+                result += " " + std::to_string(phaseMemory[index].peakBytes / 1024);
+            }
+            result += ")";
+        }
+        return result;
+    }
+
+private:
+    static std::int64_t microseconds(std::chrono::nanoseconds duration)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    }
+
+    std::array<std::pair<std::string_view, std::uint64_t>, 7> counters() const
+    {
+        return { { { "measures", measures }, { "entries", entries }, { "notes", notes }, { "outputs", outputs },
+            { "bytesWritten", bytesWritten }, { "cacheHits", cacheHits }, { "cacheMisses", cacheMisses } } };
+    }
+};
+
+/// @struct OutputFingerprint
+/// @brief The content hash of one output, computed while the output was written.
+struct OutputFingerprint
+{
+    std::string name;       ///< Suggested output name, as passed to the callback or sink. Empty for the score or a single output.
+    std::uint64_t xxh64{};  ///< XXH64 (seed 0) of the output's bytes.
+    std::uint64_t bytes{};  ///< Size of the output.
+};
+
 /// @struct ConversionResult
 /// @brief Result metadata returned after a conversion completes.
 class ConversionResult
@@ -124,6 +465,43 @@ public:
         return !hasError();
     }
 
+    /// Returns true when the conversion ended with an error after CommonOptions::cancellation was cancelled or
+    /// CommonOptions::deadline passed. Its output is then incomplete or missing.
+    [[nodiscard]] bool cancelled() const noexcept
+    {
+        return m_cancelled;
+    }
+
+    /// Records that the conversion was stopped by its cancellation token or deadline.
+    void setCancelled() noexcept
+    {
+        m_cancelled = true;
+    }
+
+    /// Returns the most bytes the conversion's mapping arenas held at once, or 0 if the converter does not track it.
+    [[nodiscard]] std::size_t peakArenaBytes() const noexcept
+    {
+        return m_peakArenaBytes;
+    }
+
+    /// Records the arena high-water mark of the conversion.
+    void setPeakArenaBytes(std::size_t bytes) noexcept
+    {
+        m_peakArenaBytes = bytes;
+    }
+
+    /// Returns the timings and counts of the conversion.
+    [[nodiscard]] const ConversionStats& stats() const noexcept
+    {
+        return m_stats;
+    }
+
+    /// Returns the timings and counts of the conversion, for the converter to fill in.
+    [[nodiscard]] ConversionStats& stats() noexcept
+    {
+        return m_stats;
+    }
+
     /// Adds a diagnostic and updates the error state if needed.
     void addDiagnostic(MessageSeverity severity, std::string message)
     {
@@ -137,11 +515,51 @@ public:
         m_diagnostics.push_back(std::move(diagnostic));
     }
 
+    /// Returns the fingerprint of each output, in the order the outputs were finished, when
+    /// CommonOptions::fingerprintOutputs asked for them.
+    [[nodiscard]] std::span<const OutputFingerprint> outputFingerprints() const noexcept
+    {
+        return m_outputFingerprints;
+    }
+
+    /// Records the fingerprint of a finished output.
+    void addOutputFingerprint(OutputFingerprint fingerprint)
+    {
+        m_outputFingerprints.push_back(std::move(fingerprint));
+    }
+
 private:
     std::vector<Diagnostic> m_diagnostics;
+    std::vector<OutputFingerprint> m_outputFingerprints;
     bool m_hasError{};
+    bool m_cancelled{};
+    std::size_t m_peakArenaBytes{};
+    ConversionStats m_stats;
 };
 
+namespace detail {
+
+/// @brief Starts conversion on the executor named by the request's CommonOptions, or on a new thread if there is none.
+/// A DENIGMA_SINGLE_THREADED build has no threads to start, so without an executor the conversion is deferred until the
+/// future is waited on.
+inline std::future<ConversionResult> runConversionAsync(const ConversionRequest& request, std::function<ConversionResult()> conversion)
+{
+    const CommonOptions* common = request.options ? request.options->commonOptions() : nullptr;
+    if (!common || !common->executor) {
+#if defined(DENIGMA_SINGLE_THREADED)
+        return std::async(std::launch::deferred, std::move(conversion)); // runs when the caller waits
+#else
+        return std::async(std::launch::async, std::move(conversion));
+#endif
+    }
+    auto task = std::make_shared<std::packaged_task<ConversionResult()>>(std::move(conversion));
+    auto result = task->get_future();
+    common->executor->submit([task]() { (*task)(); });
+    return result;
+}
+
+} // namespace detail
+
 /// @brief Returns typed options from an erased request, or default options when none were supplied.
 /// @return converion options typed as `OptionsT`.
 /// @throw std::invalid_argument if the request contains incompatible options.
@@ -174,6 +592,15 @@ public:
     virtual ConversionResult convert(std::span<const std::byte> input,
                                      std::ostream& output,
                                      const ConversionRequest& request = {}) const = 0;
+
+    /// Starts #convert on CommonOptions::executor, or on a thread of its own when there is none, and returns at once.
+    /// input, output and the request's options must stay valid until the future is ready.
+    [[nodiscard]] std::future<ConversionResult> convertAsync(std::span<const std::byte> input,
+                                                             std::ostream& output,
+                                                             const ConversionRequest& request = {}) const
+    {
+        return detail::runConversionAsync(request, [this, input, &output, request]() { return convert(input, output, request); });
+    }
 };
 
 /// @class IReaderConverter
@@ -192,10 +619,109 @@ public:
     virtual ConversionResult convert(const IRandomAccessReader& input,
                                      std::ostream& output,
                                      const ConversionRequest& request = {}) const = 0;
+
+    /// Starts #convert on CommonOptions::executor, or on a thread of its own when there is none, and returns at once.
+    /// input, output and the request's options must stay valid until the future is ready.
+    [[nodiscard]] std::future<ConversionResult> convertAsync(const IRandomAccessReader& input,
+                                                             std::ostream& output,
+                                                             const ConversionRequest& request = {}) const
+    {
+        return detail::runConversionAsync(request, [this, &input, &output, request]() { return convert(input, output, request); });
+    }
 };
 
-/// Callback used by converters that may emit zero, one, or many output buffers.
-using MultiOutputCallback = std::function<void(std::string_view suggestedName, std::span<const std::byte> data)>;
+/// @class MultiOutputCallback
+/// @brief Callback used by converters that may emit zero, one, or many output buffers.
+///
+/// Wraps one of two handler forms. A viewing handler, `void(std::string_view suggestedName, std::span<const std::byte> data)`,
+/// sees each buffer only for the duration of the call. An owning handler, `void(std::string_view suggestedName, std::string&& data)`,
+/// takes the buffer over, so a caller that keeps outputs (for example to queue them for upload) needs no copy of its own.
+/// Converters that build an output in a std::string hand it over with the std::string&& call operator, which moves it into an
+/// owning handler; outputs delivered as a span are copied into a string for an owning handler.
+class MultiOutputCallback
+{
+public:
+    /// Handler that views each output buffer.
+    using ViewHandler = std::function<void(std::string_view suggestedName, std::span<const std::byte> data)>;
+    /// Handler that takes ownership of each output buffer.
+    using OwningHandler = std::function<void(std::string_view suggestedName, std::string&& data)>;
+
+    MultiOutputCallback() = default;                ///< empty callback
+    MultiOutputCallback(std::nullptr_t) {}          ///< empty callback
+
+    /// Wraps handler, which is a viewing handler when it can be called with a span and an owning handler otherwise.
+    template <typename Handler>
+        requires(!std::is_same_v<std::remove_cvref_t<Handler>, MultiOutputCallback>
+                 && (std::is_invocable_v<Handler&, std::string_view, std::span<const std::byte>>
+                     || std::is_invocable_v<Handler&, std::string_view, std::string&&>))
+    MultiOutputCallback(Handler&& handler)
+    {
+        if constexpr (std::is_invocable_v<Handler&, std::string_view, std::span<const std::byte>>) {
+            m_view = ViewHandler(std::forward<Handler>(handler));
+        } else {
+            m_owning = OwningHandler(std::forward<Handler>(handler));
+        }
+    }
+
+    /// True if a handler is set.
+    explicit operator bool() const { return m_view || m_owning; }
+
+    /// True if the handler takes ownership of each output buffer.
+    [[nodiscard]] bool ownsOutput() const { return static_cast<bool>(m_owning); }
+
+    /// Delivers an output the converter does not own.
+    void operator()(std::string_view suggestedName, std::span<const std::byte> data) const
+    {
+        if (m_owning) {
+            m_owning(suggestedName, std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+        } else {
+            m_view(suggestedName, data);
+        }
+    }
+
+    /// Delivers an output the converter is finished with, moving it into an owning handler.
+    void operator()(std::string_view suggestedName, std::string&& data) const
+    {
+        if (m_owning) {
+            m_owning(suggestedName, std::move(data));
+        } else {
+            m_view(suggestedName, std::as_bytes(std::span<const char>(data.data(), data.size())));
+        }
+    }
+
+private:
+    ViewHandler m_view;
+    OwningHandler m_owning;
+};
+
+/// @class IMultiOutputSink
+/// @brief Receives each generated output document incrementally, as its bytes are produced.
+///
+/// For each document a converter calls #begin, then #write zero or more times, then #end. If an error occurs
+/// while a document is being written, the exception propagates and #end is not called for that document.
+class IMultiOutputSink
+{
+public:
+    virtual ~IMultiOutputSink() = default;    ///< virtual destructor
+
+    /// Starts a new output document. Return false to skip it; no #write or #end calls follow for a skipped document.
+    virtual bool begin(std::string_view suggestedName) = 0;
+    /// Appends the next chunk of the current document.
+    virtual void write(std::span<const std::byte> data) = 0;
+    /// Finishes the current document.
+    virtual void end() = 0;
+};
+
+/// Returns a MultiOutputCallback that forwards each complete output buffer to sink as a single chunk.
+inline MultiOutputCallback multiOutputCallbackForSink(IMultiOutputSink& sink)
+{
+    return [&sink](std::string_view suggestedName, std::span<const std::byte> data) {
+        if (sink.begin(suggestedName)) {
+            sink.write(data);
+            sink.end();
+        }
+    };
+}
 
 /// @class IMultiOutputConverter
 /// @brief Public interface implemented by adapters that may produce multiple output documents.
@@ -213,6 +739,36 @@ public:
     virtual ConversionResult convert(std::span<const std::byte> input,
                                      const MultiOutputCallback& outputCallback,
                                      const ConversionRequest& request = {}) const = 0;
+
+    /// Converts the input memory buffer and streams each generated output into sink.
+    /// Converters that cannot stream deliver each output to the sink as one chunk.
+    virtual ConversionResult convert(std::span<const std::byte> input,
+                                     IMultiOutputSink& sink,
+                                     const ConversionRequest& request = {}) const
+    {
+        return convert(input, multiOutputCallbackForSink(sink), request);
+    }
+
+    /// Starts #convert on CommonOptions::executor, or on a thread of its own when there is none, and returns at once.
+    /// Each output reaches outputCallback on the converting thread as soon as it is complete. input and the request's
+    /// options must stay valid until the future is ready.
+    [[nodiscard]] std::future<ConversionResult> convertAsync(std::span<const std::byte> input,
+                                                             MultiOutputCallback outputCallback,
+                                                             const ConversionRequest& request = {}) const
+    {
+        return detail::runConversionAsync(request, [this, input, outputCallback = std::move(outputCallback), request]() {
+            return convert(input, outputCallback, request);
+        });
+    }
+
+    /// Starts #convert with sink on CommonOptions::executor, or on a thread of its own when there is none, and
+    /// returns at once. input, sink and the request's options must stay valid until the future is ready.
+    [[nodiscard]] std::future<ConversionResult> convertAsync(std::span<const std::byte> input,
+                                                             IMultiOutputSink& sink,
+                                                             const ConversionRequest& request = {}) const
+    {
+        return detail::runConversionAsync(request, [this, input, &sink, request]() { return convert(input, sink, request); });
+    }
 };
 
 /// @class IReaderMultiOutputConverter
@@ -231,98 +787,207 @@ public:
     virtual ConversionResult convert(const IRandomAccessReader& input,
                                      const MultiOutputCallback& outputCallback,
                                      const ConversionRequest& request = {}) const = 0;
+
+    /// Converts the input reader and streams each generated output into sink.
+    /// Converters that cannot stream deliver each output to the sink as one chunk.
+    virtual ConversionResult convert(const IRandomAccessReader& input,
+                                     IMultiOutputSink& sink,
+                                     const ConversionRequest& request = {}) const
+    {
+        return convert(input, multiOutputCallbackForSink(sink), request);
+    }
+
+    /// Starts #convert on CommonOptions::executor, or on a thread of its own when there is none, and returns at once.
+    /// Each output reaches outputCallback on the converting thread as soon as it is complete. input and the request's
+    /// options must stay valid until the future is ready.
+    [[nodiscard]] std::future<ConversionResult> convertAsync(const IRandomAccessReader& input,
+                                                             MultiOutputCallback outputCallback,
+                                                             const ConversionRequest& request = {}) const
+    {
+        return detail::runConversionAsync(request, [this, &input, outputCallback = std::move(outputCallback), request]() {
+            return convert(input, outputCallback, request);
+        });
+    }
+
+    /// Starts #convert with sink on CommonOptions::executor, or on a thread of its own when there is none, and
+    /// returns at once. input, sink and the request's options must stay valid until the future is ready.
+    [[nodiscard]] std::future<ConversionResult> convertAsync(const IRandomAccessReader& input,
+                                                             IMultiOutputSink& sink,
+                                                             const ConversionRequest& request = {}) const
+    {
+        return detail::runConversionAsync(request, [this, &input, &sink, request]() { return convert(input, sink, request); });
+    }
+};
+
+class PreparedDocument;
+
+/// @class IPreparedDocumentConverter
+/// @brief Public interface implemented by adapters that convert a document that has already been extracted and parsed.
+///
+/// Any number of these converters may consume the same PreparedDocument, so several target formats can be
+/// produced from one parse of the source.
+class IPreparedDocumentConverter
+{
+public:
+    virtual ~IPreparedDocumentConverter() = default;    ///< virtual destructor
+
+    /// Returns the target format produced by this converter.
+    [[nodiscard]] virtual FormatId targetFormat() const = 0;
+
+    /// Converts the prepared document and invokes outputCallback once for each generated output.
+    /// Single-document formats invoke it once with an empty suggested name.
+    virtual ConversionResult convert(const PreparedDocument& input,
+                                     const MultiOutputCallback& outputCallback,
+                                     const ConversionRequest& request = {}) const = 0;
+
+    /// Starts #convert on CommonOptions::executor, or on a thread of its own when there is none, and returns at once.
+    /// Each output reaches outputCallback on the converting thread as soon as it is complete. input and the request's
+    /// options must stay valid until the future is ready.
+    [[nodiscard]] std::future<ConversionResult> convertAsync(const PreparedDocument& input,
+                                                             MultiOutputCallback outputCallback,
+                                                             const ConversionRequest& request = {}) const
+    {
+        return detail::runConversionAsync(request, [this, &input, outputCallback = std::move(outputCallback), request]() {
+            return convert(input, outputCallback, request);
+        });
+    }
 };
 
 /// @class ConverterRegistry
 /// @brief Lightweight registry for locating converters by source and target format.
+///
+/// Lookups index a table by the (source, target) pair, so they cost no scan and no virtual calls.
+/// When several converters share a pair, the first one added is the one found.
 class ConverterRegistry
 {
 public:
     /// Adds a converter to the registry.
     void add(std::unique_ptr<IConverter> converter)
     {
-        if (!converter) {
-            throw std::invalid_argument("converter cannot be null");
-        }
-        m_converters.emplace_back(std::move(converter));
+        addIndexed(std::move(converter), m_converters, m_converterIndex);
     }
 
     /// Adds a multi-output converter to the registry.
     void add(std::unique_ptr<IMultiOutputConverter> converter)
     {
-        if (!converter) {
-            throw std::invalid_argument("converter cannot be null");
-        }
-        m_multiOutputConverters.emplace_back(std::move(converter));
+        addIndexed(std::move(converter), m_multiOutputConverters, m_multiOutputConverterIndex);
     }
 
     /// Adds a reader-backed converter to the registry.
     void add(std::unique_ptr<IReaderConverter> converter)
     {
-        if (!converter) {
-            throw std::invalid_argument("converter cannot be null");
-        }
-        m_readerConverters.emplace_back(std::move(converter));
+        addIndexed(std::move(converter), m_readerConverters, m_readerConverterIndex);
     }
 
     /// Adds a reader-backed multi-output converter to the registry.
     void add(std::unique_ptr<IReaderMultiOutputConverter> converter)
+    {
+        addIndexed(std::move(converter), m_readerMultiOutputConverters, m_readerMultiOutputConverterIndex);
+    }
+
+    /// Adds a prepared-document converter to the registry.
+    void add(std::unique_ptr<IPreparedDocumentConverter> converter)
     {
         if (!converter) {
             throw std::invalid_argument("converter cannot be null");
         }
-        m_readerMultiOutputConverters.emplace_back(std::move(converter));
+        const std::size_t slot = formatSlot(converter->targetFormat());
+        if (slot >= FORMAT_COUNT) {
+            throw std::invalid_argument("converter has an unknown target format");
+        }
+        if (!m_preparedDocumentConverterIndex[slot]) {
+            m_preparedDocumentConverterIndex[slot] = converter.get();
+        }
+        m_preparedDocumentConverters.emplace_back(std::move(converter));
     }
 
     /// Returns the first registered converter matching the requested formats, or nullptr.
     [[nodiscard]] const IConverter* find(FormatId sourceFormat, FormatId targetFormat) const
     {
-        for (const auto& converter : m_converters) {
-            if (converter->sourceFormat() == sourceFormat && converter->targetFormat() == targetFormat) {
-                return converter.get();
-            }
-        }
-        return nullptr;
+        return findIndexed(m_converterIndex, sourceFormat, targetFormat);
     }
 
     /// Returns the first registered multi-output converter matching the requested formats, or nullptr.
     [[nodiscard]] const IMultiOutputConverter* findMultiOutput(FormatId sourceFormat, FormatId targetFormat) const
     {
-        for (const auto& converter : m_multiOutputConverters) {
-            if (converter->sourceFormat() == sourceFormat && converter->targetFormat() == targetFormat) {
-                return converter.get();
-            }
-        }
-        return nullptr;
+        return findIndexed(m_multiOutputConverterIndex, sourceFormat, targetFormat);
     }
 
     /// Returns the first registered reader-backed converter matching the requested formats, or nullptr.
     [[nodiscard]] const IReaderConverter* findReader(FormatId sourceFormat, FormatId targetFormat) const
     {
-        for (const auto& converter : m_readerConverters) {
-            if (converter->sourceFormat() == sourceFormat && converter->targetFormat() == targetFormat) {
-                return converter.get();
-            }
-        }
-        return nullptr;
+        return findIndexed(m_readerConverterIndex, sourceFormat, targetFormat);
     }
 
     /// Returns the first registered reader-backed multi-output converter matching the requested formats, or nullptr.
     [[nodiscard]] const IReaderMultiOutputConverter* findReaderMultiOutput(FormatId sourceFormat, FormatId targetFormat) const
     {
-        for (const auto& converter : m_readerMultiOutputConverters) {
-            if (converter->sourceFormat() == sourceFormat && converter->targetFormat() == targetFormat) {
-                return converter.get();
-            }
-        }
-        return nullptr;
+        return findIndexed(m_readerMultiOutputConverterIndex, sourceFormat, targetFormat);
+    }
+
+    /// Returns the first registered prepared-document converter for the requested target format, or nullptr.
+    [[nodiscard]] const IPreparedDocumentConverter* findPrepared(FormatId targetFormat) const
+    {
+        const std::size_t slot = formatSlot(targetFormat);
+        return (slot < FORMAT_COUNT) ? m_preparedDocumentConverterIndex[slot] : nullptr;
     }
 
 private:
+    static constexpr std::size_t FORMAT_COUNT = static_cast<std::size_t>(FormatId::EnigmaBinary) + 1; ///< keep in step with FormatId
+    static constexpr std::size_t PAIR_COUNT = FORMAT_COUNT * FORMAT_COUNT;
+
+    template <typename Converter>
+    using PairIndex = std::array<const Converter*, PAIR_COUNT>;
+
+    static constexpr std::size_t formatSlot(FormatId format)
+    {
+        return static_cast<std::size_t>(format);
+    }
+
+    /// Returns the table slot for a format pair, or PAIR_COUNT if either format is out of range.
+    static constexpr std::size_t pairSlot(FormatId sourceFormat, FormatId targetFormat)
+    {
+        const std::size_t source = formatSlot(sourceFormat);
+        const std::size_t target = formatSlot(targetFormat);
+        return (source < FORMAT_COUNT && target < FORMAT_COUNT) ? source * FORMAT_COUNT + target : PAIR_COUNT;
+    }
+
+    template <typename Converter>
+    static void addIndexed(std::unique_ptr<Converter> converter,
+                           std::vector<std::unique_ptr<Converter>>& converters,
+                           PairIndex<Converter>& index)
+    {
+        if (!converter) {
+            throw std::invalid_argument("converter cannot be null");
+        }
+        const std::size_t slot = pairSlot(converter->sourceFormat(), converter->targetFormat());
+        if (slot >= PAIR_COUNT) {
+            throw std::invalid_argument("converter has an unknown source or target format");
+        }
+        if (!index[slot]) {
+            index[slot] = converter.get();
+        }
+        converters.emplace_back(std::move(converter));
+    }
+
+    template <typename Converter>
+    static const Converter* findIndexed(const PairIndex<Converter>& index, FormatId sourceFormat, FormatId targetFormat)
+    {
+        const std::size_t slot = pairSlot(sourceFormat, targetFormat);
+        return (slot < PAIR_COUNT) ? index[slot] : nullptr;
+    }
+
     std::vector<std::unique_ptr<IConverter>> m_converters;
     std::vector<std::unique_ptr<IMultiOutputConverter>> m_multiOutputConverters;
     std::vector<std::unique_ptr<IReaderConverter>> m_readerConverters;
     std::vector<std::unique_ptr<IReaderMultiOutputConverter>> m_readerMultiOutputConverters;
+    std::vector<std::unique_ptr<IPreparedDocumentConverter>> m_preparedDocumentConverters;
+
+    PairIndex<IConverter> m_converterIndex{};
+    PairIndex<IMultiOutputConverter> m_multiOutputConverterIndex{};
+    PairIndex<IReaderConverter> m_readerConverterIndex{};
+    PairIndex<IReaderMultiOutputConverter> m_readerMultiOutputConverterIndex{};
+    std::array<const IPreparedDocumentConverter*, FORMAT_COUNT> m_preparedDocumentConverterIndex{};
 };
 
 } // namespace denigma
@@ -36,6 +36,10 @@ struct Options final : public IOptions
 {
     /// Options common to all converters.
     CommonOptions common;
+
+    [[nodiscard]] const CommonOptions* commonOptions() const noexcept override { return &common; }
+    /// Writes the Enigma XML as Finale indented it. When false, the indentation between elements is left out.
+    bool prettyPrint{ true };
 };
 
 /// @class MusxToEnigmaXmlConverter
@@ -57,6 +61,28 @@ public:
                              const ConversionRequest& request = {}) const override;
 };
 
+/// @class MusxToEnigmaBinaryConverter
+/// @brief Converter adapter for MUSX archive input to the binary Enigma XML cache (FormatId::EnigmaBinary).
+///
+/// The cache holds the same content as the Enigma XML in a fraction of the size, and converters read it without
+/// parsing XML: extract once, then convert it as often as needed. Options::prettyPrint does not apply.
+class MusxToEnigmaBinaryConverter final : public IReaderConverter
+{
+public:
+    [[nodiscard]] FormatId sourceFormat() const override { return FormatId::Musx; }
+    [[nodiscard]] FormatId targetFormat() const override { return FormatId::EnigmaBinary; }
+
+    /// Extracts the Enigma XML from a MUSX random-access reader and writes its binary cache to the provided stream.
+    ConversionResult convert(const IRandomAccessReader& input,
+                             std::ostream& output,
+                             const Options& options = {}) const;
+
+    /// Extracts the binary cache using type-erased registry options.
+    ConversionResult convert(const IRandomAccessReader& input,
+                             std::ostream& output,
+                             const ConversionRequest& request = {}) const override;
+};
+
 /// Registers all Enigma XML format converters with the supplied registry.
 void registerConverters(ConverterRegistry& registry);
 
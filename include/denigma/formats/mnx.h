@@ -23,6 +23,7 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "denigma/conversion.h"
 
@@ -33,14 +34,31 @@ namespace formats {
 /// @brief Conversion adapters for generating MNX JSON.
 namespace mnx {
 
+/// @enum Encoding
+/// @brief Serialization used for the MNX document.
+///
+/// The binary encodings are produced from the same JSON document model, so they decode to exactly
+/// the JSON text that would otherwise have been written.
+enum class Encoding
+{
+    Json,           ///< JSON text (default).
+    Cbor,           ///< Concise Binary Object Representation (RFC 8949).
+    MessagePack,    ///< MessagePack.
+    Bson            ///< BSON.
+};
+
 /// @struct Options
 /// @brief Options for MNX JSON converters.
 struct Options final : public IOptions
 {
     /// Options common to all converters.
     CommonOptions common;
+
+    [[nodiscard]] const CommonOptions* commonOptions() const noexcept override { return &common; }
     /// Number of spaces used for formatted JSON output, or std::nullopt for compact output.
     std::optional<int> indentSpaces{ 4 };
+    /// Serialization of the output. Binary encodings ignore #indentSpaces.
+    Encoding encoding{ Encoding::Json };
     /// Optional cue layer to omit because MNX does not currently support cues.
     std::optional<int> cueLayer;
     /// Optional MNX JSON schema contents used for validation.
@@ -49,6 +67,11 @@ struct Options final : public IOptions
     bool includeTempoTool{ false };
     /// Split Finale instruments into separate MNX parts.
     bool splitInstruments{ false };
+    /// Converts only these measures. The key, clef, time signature, transposition, ottavas and ties in effect at the
+    /// first measure are restated there, and score layout that refers to other measures is left out.
+    std::optional<MeasureRange> measureRange;
+    /// Converts only the staves at these positions in the score's staff order, counted from 1. Empty converts every staff.
+    std::vector<int> staffFilter;
 };
 
 /// @class EnigmaXmlToMnxJsonConverter
@@ -89,6 +112,24 @@ public:
                              const ConversionRequest& request = {}) const override;
 };
 
+/// @class PreparedDocumentToMnxJsonConverter
+/// @brief Converter adapter for a PreparedDocument to MNX JSON output.
+class PreparedDocumentToMnxJsonConverter final : public IPreparedDocumentConverter
+{
+public:
+    [[nodiscard]] FormatId targetFormat() const override { return FormatId::MnxJson; }
+
+    /// Converts the prepared document and writes MNX JSON to the provided stream.
+    ConversionResult convert(const PreparedDocument& input,
+                             std::ostream& output,
+                             const Options& options = {}) const;
+
+    /// Converts the prepared document and invokes outputCallback once with an empty suggested name.
+    ConversionResult convert(const PreparedDocument& input,
+                             const MultiOutputCallback& outputCallback,
+                             const ConversionRequest& request = {}) const override;
+};
+
 /// Registers all MNX format converters with the supplied registry.
 void registerConverters(ConverterRegistry& registry);
 
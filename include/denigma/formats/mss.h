@@ -36,6 +36,8 @@ struct Options final : public IOptions
 {
     /// Options common to all converters.
     CommonOptions common;
+
+    [[nodiscard]] const CommonOptions* commonOptions() const noexcept override { return &common; }
     /// Emit the score plus all linked parts for multi-output conversion.
     bool allPartsAndScore{ false };
     /// Optional part-name prefix for multi-output conversion.
@@ -50,6 +52,8 @@ public:
     [[nodiscard]] FormatId sourceFormat() const override { return FormatId::EnigmaXml; }
     [[nodiscard]] FormatId targetFormat() const override { return FormatId::MssXml; }
 
+    using IMultiOutputConverter::convert; ///< exposes the streaming sink overload
+
     /// Converts Enigma XML from memory and invokes outputCallback for each MSS document.
     ConversionResult convert(std::span<const std::byte> input,
                              const MultiOutputCallback& outputCallback,
@@ -69,6 +73,8 @@ public:
     [[nodiscard]] FormatId sourceFormat() const override { return FormatId::Musx; }
     [[nodiscard]] FormatId targetFormat() const override { return FormatId::MssXml; }
 
+    using IReaderMultiOutputConverter::convert; ///< exposes the streaming sink overload
+
     /// Extracts a MUSX archive and invokes outputCallback for each MSS document.
     ConversionResult convert(const IRandomAccessReader& input,
                              const MultiOutputCallback& outputCallback,
@@ -80,6 +86,24 @@ public:
                              const ConversionRequest& request = {}) const override;
 };
 
+/// @class PreparedDocumentToMssXmlConverter
+/// @brief Converter adapter for a PreparedDocument to MSS style documents (score and/or parts).
+class PreparedDocumentToMssXmlConverter final : public IPreparedDocumentConverter
+{
+public:
+    [[nodiscard]] FormatId targetFormat() const override { return FormatId::MssXml; }
+
+    /// Converts the prepared document and invokes outputCallback for each MSS output.
+    ConversionResult convert(const PreparedDocument& input,
+                             const MultiOutputCallback& outputCallback,
+                             const Options& options = {}) const;
+
+    /// Converts the prepared document using type-erased registry options.
+    ConversionResult convert(const PreparedDocument& input,
+                             const MultiOutputCallback& outputCallback,
+                             const ConversionRequest& request = {}) const override;
+};
+
 /// Registers all MSS format converters with the supplied registry.
 void registerConverters(ConverterRegistry& registry);
 
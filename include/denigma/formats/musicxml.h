@@ -18,8 +18,12 @@
  */
 #pragma once
 
+#include <cstddef>
+#include <filesystem>
+#include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "denigma/conversion.h"
 
@@ -36,11 +40,27 @@ struct Options final : public IOptions
 {
     /// Options common to all converters.
     CommonOptions common;
+
+    [[nodiscard]] const CommonOptions* commonOptions() const noexcept override { return &common; }
     bool includeTempoTool{ false };
     /// Emit the score plus all linked parts for multi-output conversion.
     bool allPartsAndScore{ false };
     /// Optional part-name prefix for multi-output conversion.
     std::optional<std::string> partName;
+    /// Converts only these measures. The key, clef, time signature, transposition, ottavas and ties in effect at the
+    /// first measure are restated there, and score layout that refers to other measures is left out.
+    std::optional<MeasureRange> measureRange;
+    /// Converts only the staves at these positions in the score's staff order, counted from 1. Empty converts every staff.
+    std::vector<int> staffFilter;
+    /// Builds and writes one MusicXML part at a time, releasing each before the next is built, so that peak memory
+    /// follows the largest part rather than the whole score. Each document is still written in one piece, in part order.
+    bool streamParts{ false };
+    /// Converts each set of linked parts with identical conversion inputs (the same staves, measures, systems, pages,
+    /// page texts and voiced entries) once, and writes the copies with their own part names in the part-name credits.
+    /// Layout moved in only one of the parts is not compared, so this is off by default. Ignored with #streamParts.
+    bool dedupeParts{ false };
+    /// Writes indented MusicXML. When false, the indentation between elements is left out.
+    bool prettyPrint{ true };
 };
 
 /// @class EnigmaXmlToMusicXmlMultiOutputConverter
@@ -60,6 +80,16 @@ public:
     ConversionResult convert(std::span<const std::byte> input,
                              const MultiOutputCallback& outputCallback,
                              const ConversionRequest& request = {}) const override;
+
+    /// Converts Enigma XML from memory and streams each MusicXML document into sink as it is serialized.
+    ConversionResult convert(std::span<const std::byte> input,
+                             IMultiOutputSink& sink,
+                             const Options& options = {}) const;
+
+    /// Streams each MusicXML document into sink using type-erased registry options.
+    ConversionResult convert(std::span<const std::byte> input,
+                             IMultiOutputSink& sink,
+                             const ConversionRequest& request = {}) const override;
 };
 
 /// @class MusxToMusicXmlMultiOutputConverter
@@ -79,6 +109,64 @@ public:
     ConversionResult convert(const IRandomAccessReader& input,
                              const MultiOutputCallback& outputCallback,
                              const ConversionRequest& request = {}) const override;
+
+    /// Extracts a MUSX archive and streams each MusicXML document into sink as it is serialized.
+    ConversionResult convert(const IRandomAccessReader& input,
+                             IMultiOutputSink& sink,
+                             const Options& options = {}) const;
+
+    /// Streams each MusicXML document into sink using type-erased registry options.
+    ConversionResult convert(const IRandomAccessReader& input,
+                             IMultiOutputSink& sink,
+                             const ConversionRequest& request = {}) const override;
+};
+
+/// @class PreparedDocumentToMusicXmlConverter
+/// @brief Converter adapter for a PreparedDocument to one or more MusicXML outputs (score and/or parts).
+class PreparedDocumentToMusicXmlConverter final : public IPreparedDocumentConverter
+{
+public:
+    [[nodiscard]] FormatId targetFormat() const override { return FormatId::MusicXml; }
+
+    /// Converts the prepared document and invokes outputCallback for each MusicXML document.
+    ConversionResult convert(const PreparedDocument& input,
+                             const MultiOutputCallback& outputCallback,
+                             const Options& options = {}) const;
+
+    /// Converts the prepared document using type-erased registry options.
+    ConversionResult convert(const PreparedDocument& input,
+                             const MultiOutputCallback& outputCallback,
+                             const ConversionRequest& request = {}) const override;
+};
+
+/// @class MxlArchiveSink
+/// @brief Multi-output sink that deflates each MusicXML document straight into one compressed MusicXML (.mxl) archive.
+///
+/// The first document becomes the root file named by META-INF/container.xml; any later documents (linked parts)
+/// are stored beside it. Entries are named like the files a directory sink would write: the archive's stem, then
+/// ".<suggested name>" when there is one, then ".musicxml". Call #finish after the conversion to complete the archive.
+class MxlArchiveSink final : public IMultiOutputSink
+{
+public:
+    /// Creates the archive at outputPath. Throws if it cannot be created.
+    explicit MxlArchiveSink(const std::filesystem::path& outputPath);
+    /// Builds the archive in output, naming entries as for an archive whose stem is entryStem. output must outlive
+    /// the sink and holds the complete archive after #finish.
+    MxlArchiveSink(std::string& output, std::string entryStem);
+    ~MxlArchiveSink() override;
+
+    bool begin(std::string_view suggestedName) override;
+    void write(std::span<const std::byte> data) override;
+    void end() override;
+
+    /// Writes the archive's central directory. Throws if the archive could not be completed.
+    void finish();
+    /// The number of MusicXML documents written so far.
+    [[nodiscard]] std::size_t documentCount() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
 };
 
 /// Registers all MusicXML format converters with the supplied registry.
@@ -48,6 +48,8 @@ struct Options final : public IOptions
 {
     /// Options common to all converters.
     CommonOptions common;
+
+    [[nodiscard]] const CommonOptions* commonOptions() const noexcept override { return &common; }
     /// Unit suffix for SVG width and height output.
     Unit unit{ Unit::Points };
     /// Extra scale multiplier for SVG output when page scaling is not active.
@@ -56,6 +58,8 @@ struct Options final : public IOptions
     std::vector<int> shapeDefs;
     /// Use Finale page-format scaling.
     bool usePageScale{ false };
+    /// Emit one SVG document in which every shape is a <symbol> and repeated drawing elements are shared <use>s.
+    bool spriteSheet{ false };
 };
 
 /// @class EnigmaXmlToSvgConverter
@@ -66,6 +70,8 @@ public:
     [[nodiscard]] FormatId sourceFormat() const override { return FormatId::EnigmaXml; }
     [[nodiscard]] FormatId targetFormat() const override { return FormatId::Svg; }
 
+    using IMultiOutputConverter::convert; ///< exposes the streaming sink overload
+
     /// Converts Enigma XML from memory and invokes outputCallback for each SVG document.
     ConversionResult convert(std::span<const std::byte> input,
                              const MultiOutputCallback& outputCallback,
@@ -85,6 +91,8 @@ public:
     [[nodiscard]] FormatId sourceFormat() const override { return FormatId::Musx; }
     [[nodiscard]] FormatId targetFormat() const override { return FormatId::Svg; }
 
+    using IReaderMultiOutputConverter::convert; ///< exposes the streaming sink overload
+
     /// Extracts a MUSX archive and invokes outputCallback for each SVG document.
     ConversionResult convert(const IRandomAccessReader& input,
                              const MultiOutputCallback& outputCallback,
@@ -96,6 +104,24 @@ public:
                              const ConversionRequest& request = {}) const override;
 };
 
+/// @class PreparedDocumentToSvgConverter
+/// @brief Converter adapter for a PreparedDocument to SVG outputs (one per selected ShapeDef).
+class PreparedDocumentToSvgConverter final : public IPreparedDocumentConverter
+{
+public:
+    [[nodiscard]] FormatId targetFormat() const override { return FormatId::Svg; }
+
+    /// Converts the prepared document and invokes outputCallback for each SVG output.
+    ConversionResult convert(const PreparedDocument& input,
+                             const MultiOutputCallback& outputCallback,
+                             const Options& options = {}) const;
+
+    /// Converts the prepared document using type-erased registry options.
+    ConversionResult convert(const PreparedDocument& input,
+                             const MultiOutputCallback& outputCallback,
+                             const ConversionRequest& request = {}) const override;
+};
+
 /// Registers all SVG format converters with the supplied registry.
 void registerConverters(ConverterRegistry& registry);
 
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "denigma/io/random_access_reader.h"
+
+namespace denigma {
+
+/// @class HttpRandomAccessReader
+/// @brief Random-access reader that fetches byte ranges of a remote object with HTTP `Range` requests.
+///
+/// Only available when Denigma is built with the `DENIGMA_HTTP_READER` CMake option, which requires libcurl;
+/// such builds define `DENIGMA_HAS_HTTP_READER`. The constructor fetches the tail of the object, where a zip
+/// archive keeps its central directory, and learns the object size from the same response. #prefetch fetches the
+/// hinted ranges concurrently, merging ranges that lie close together, and later reads inside fetched ranges are
+/// served from memory. Any other read is one request, so wrap the reader in a CachingRandomAccessReader to
+/// coalesce small reads. One instance may be shared by concurrent readers. Failed requests throw std::runtime_error.
+class HttpRandomAccessReader final : public IRandomAccessReader
+{
+public:
+    /// @brief Request settings.
+    struct Options
+    {
+        std::vector<std::string> headers;           ///< extra request headers, such as `Authorization: Bearer ...`
+        long timeoutSeconds{ 60 };                  ///< limit for each request
+        std::size_t tailBytes{ 64 * 1024 };         ///< bytes fetched from the end of the object by the constructor
+        std::size_t maxParallelRequests{ 4 };       ///< concurrent requests issued by #prefetch
+        std::size_t coalesceGapBytes{ 64 * 1024 };  ///< prefetch ranges closer together than this are fetched as one
+    };
+
+    /// Opens url with the default #Options.
+    explicit HttpRandomAccessReader(const std::string& url);
+    /// Opens url, issuing the first request immediately.
+    HttpRandomAccessReader(const std::string& url, const Options& options);
+    ~HttpRandomAccessReader() override;
+
+    HttpRandomAccessReader(const HttpRandomAccessReader&) = delete;
+    HttpRandomAccessReader& operator=(const HttpRandomAccessReader&) = delete;
+
+    [[nodiscard]] std::uint64_t size() const override;
+    std::size_t readAt(std::uint64_t offset, std::span<std::byte> output) const override;
+    void prefetch(std::span<const ByteRange> ranges) const override;
+
+    /// Returns how many HTTP requests have been issued, including the constructor's.
+    [[nodiscard]] std::uint64_t requestCount() const;
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+};
+
+} // namespace denigma
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include <pthread.h>
+
+#include <emscripten/val.h>
+
+#include "denigma/conversion.h"
+#include "denigma/io/random_access_reader.h"
+
+namespace denigma {
+
+/// @class JsRandomAccessReader
+/// @brief Random-access reader that pulls byte ranges from a JavaScript object on demand.
+///
+/// Only available in Emscripten builds, which define `DENIGMA_HAS_JS_IO`. The source object must have a numeric
+/// `size` property and a `readInto(offset, target)` method that copies bytes from offset into the `Uint8Array`
+/// target and returns the number copied; it may also have a `prefetch(ranges)` method taking an array of
+/// `{ offset, length }`. target is a view of module memory, so each range lands in place and a `Blob`- or
+/// `ArrayBuffer`-backed score is never copied into the module whole. The view is valid only during the call.
+///
+/// A JavaScript value belongs to the thread that created it, so reads from other threads are proxied to that thread,
+/// which must not block except in calls to the library.
+class JsRandomAccessReader final : public IRandomAccessReader
+{
+public:
+    /// Reads from source, which is kept alive for the lifetime of the reader.
+    explicit JsRandomAccessReader(emscripten::val source);
+
+    [[nodiscard]] std::uint64_t size() const override;
+    std::size_t readAt(std::uint64_t offset, std::span<std::byte> output) const override;
+    void prefetch(std::span<const ByteRange> ranges) const override;
+
+private:
+    emscripten::val m_source;
+    std::uint64_t m_size{};
+    pthread_t m_owner{};
+};
+
+/// @class JsMultiOutputSink
+/// @brief Multi-output sink that hands each chunk of output to a JavaScript object as it is produced.
+///
+/// Only available in Emscripten builds. The target object must have `begin(suggestedName)`, `write(chunk)` and
+/// `end()` methods, called as described for IMultiOutputSink; `begin` skips the document only if it returns `false`.
+/// chunk is a `Uint8Array` view of module memory that is valid only during the call, so the target must copy or
+/// consume it before returning. Output therefore never accumulates in module memory. Calls from other threads are
+/// proxied to the thread that created the sink, as for JsRandomAccessReader.
+class JsMultiOutputSink final : public IMultiOutputSink
+{
+public:
+    /// Writes to target, which is kept alive for the lifetime of the sink.
+    explicit JsMultiOutputSink(emscripten::val target);
+
+    bool begin(std::string_view suggestedName) override;
+    void write(std::span<const std::byte> data) override;
+    void end() override;
+
+private:
+    emscripten::val m_target;
+    pthread_t m_owner{};
+};
+
+} // namespace denigma
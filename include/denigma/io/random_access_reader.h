@@ -21,11 +21,19 @@
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
-#include <fstream>
+#include <functional>
+#include <memory>
 #include <span>
 
 namespace denigma {
 
+/// @brief A span of bytes within a random-access source.
+struct ByteRange
+{
+    std::uint64_t offset{};
+    std::uint64_t length{};
+};
+
 /// @class IRandomAccessReader
 /// @brief Random-access byte reader used for container formats such as MUSX.
 class IRandomAccessReader
@@ -38,21 +46,62 @@ public:
 
     /// Reads up to output.size() bytes from offset and returns the number of bytes read.
     virtual std::size_t readAt(std::uint64_t offset, std::span<std::byte> output) const = 0;
+
+    /// Hints that ranges are about to be read. High-latency readers may fetch them concurrently ahead of the reads.
+    /// The default does nothing, and a reader must still serve ranges it chose not to prefetch.
+    virtual void prefetch(std::span<const ByteRange> ranges) const { (void)ranges; }
 };
 
 /// @class FileRandomAccessReader
 /// @brief Random-access reader backed by a filesystem file.
+///
+/// Reads are positional (pread on POSIX, ReadFile with an OVERLAPPED offset on Windows) and never move
+/// a shared file position, so one instance may be shared by concurrent readers without locking.
 class FileRandomAccessReader final : public IRandomAccessReader
 {
 public:
     /// Opens path for random-access reads.
     explicit FileRandomAccessReader(const std::filesystem::path& path);
+    ~FileRandomAccessReader() override;
+
+    FileRandomAccessReader(const FileRandomAccessReader&) = delete;
+    FileRandomAccessReader& operator=(const FileRandomAccessReader&) = delete;
 
     [[nodiscard]] std::uint64_t size() const override;
     std::size_t readAt(std::uint64_t offset, std::span<std::byte> output) const override;
 
 private:
-    mutable std::ifstream m_file;
+#ifdef _WIN32
+    void* m_handle{};
+#else
+    int m_fd{ -1 };
+#endif
+    std::uint64_t m_size{};
+};
+
+/// @class MappedFileRandomAccessReader
+/// @brief Random-access reader backed by a read-only memory mapping of a filesystem file.
+///
+/// Reads are served directly from the mapping, so one instance may be shared by concurrent readers.
+/// The file must not be truncated by another process while it is mapped.
+class MappedFileRandomAccessReader final : public IRandomAccessReader
+{
+public:
+    /// Maps path read-only for the lifetime of the reader.
+    explicit MappedFileRandomAccessReader(const std::filesystem::path& path);
+    ~MappedFileRandomAccessReader() override;
+
+    MappedFileRandomAccessReader(const MappedFileRandomAccessReader&) = delete;
+    MappedFileRandomAccessReader& operator=(const MappedFileRandomAccessReader&) = delete;
+
+    [[nodiscard]] std::uint64_t size() const override;
+    std::size_t readAt(std::uint64_t offset, std::span<std::byte> output) const override;
+
+    /// Returns the entire mapped file. The span is valid for the lifetime of the reader.
+    [[nodiscard]] std::span<const std::byte> data() const;
+
+private:
+    const std::byte* m_data{};
     std::uint64_t m_size{};
 };
 
@@ -71,4 +120,76 @@ private:
     std::span<const std::byte> m_data;
 };
 
+/// @class CallbackRandomAccessReader
+/// @brief Random-access reader that asks caller-supplied functions for each range.
+///
+/// For sources the library cannot reach itself, such as a JavaScript `Blob` seen from a WebAssembly module: only the
+/// ranges that are read are copied into memory. Reads past the size given to the constructor return 0 without calling
+/// read, and read is never asked for more bytes than remain. read must be safe to call from every thread that reads;
+/// wrap the reader in a CachingRandomAccessReader when each call is expensive.
+class CallbackRandomAccessReader final : public IRandomAccessReader
+{
+public:
+    /// Fills output with bytes from offset and returns the number written.
+    using ReadFunction = std::function<std::size_t(std::uint64_t offset, std::span<std::byte> output)>;
+    /// Receives #prefetch hints.
+    using PrefetchFunction = std::function<void(std::span<const ByteRange> ranges)>;
+
+    /// Serves size bytes through read, passing prefetch hints to prefetch when it is set.
+    CallbackRandomAccessReader(std::uint64_t size, ReadFunction read, PrefetchFunction prefetch = {});
+
+    [[nodiscard]] std::uint64_t size() const override;
+    std::size_t readAt(std::uint64_t offset, std::span<std::byte> output) const override;
+    void prefetch(std::span<const ByteRange> ranges) const override;
+
+private:
+    std::uint64_t m_size{};
+    ReadFunction m_read;
+    PrefetchFunction m_prefetch;
+};
+
+/// @class CachingRandomAccessReader
+/// @brief Decorator that serves reads of another reader from a cache of fixed-size blocks.
+///
+/// Every read from the wrapped reader covers whole blocks. The most recently used blocks are kept, and a read
+/// that continues where the previous one stopped also fetches the next few blocks in the same request. This turns
+/// the many small, scattered reads of zip parsing into a few large ones, which matters when the wrapped reader is
+/// backed by network storage. The cache is locked, so one instance may be shared by concurrent readers.
+/// The wrapped reader must outlive the decorator, and its contents must not change.
+class CachingRandomAccessReader final : public IRandomAccessReader
+{
+public:
+    /// @brief Cache geometry.
+    struct Options
+    {
+        std::size_t blockSize{ 64 * 1024 };    ///< bytes per cached block
+        std::size_t maxCachedBlocks{ 64 };     ///< least recently used blocks beyond this are dropped
+        std::size_t readAheadBlocks{ 4 };      ///< extra blocks fetched by a sequential read (0 disables read-ahead)
+    };
+
+    /// Wraps source with the default #Options.
+    explicit CachingRandomAccessReader(const IRandomAccessReader& source);
+    /// Wraps source. Throws std::invalid_argument if the block size or cache size is zero.
+    CachingRandomAccessReader(const IRandomAccessReader& source, const Options& options);
+    ~CachingRandomAccessReader() override;
+
+    CachingRandomAccessReader(const CachingRandomAccessReader&) = delete;
+    CachingRandomAccessReader& operator=(const CachingRandomAccessReader&) = delete;
+
+    [[nodiscard]] std::uint64_t size() const override;
+    std::size_t readAt(std::uint64_t offset, std::span<std::byte> output) const override;
+    /// Passes the hint on to the wrapped reader.
+    void prefetch(std::span<const ByteRange> ranges) const override;
+
+    /// Returns how many reads have been issued to the wrapped reader, for tuning the #Options.
+    [[nodiscard]] std::uint64_t sourceReadCount() const;
+
+private:
+    struct Cache;
+
+    const IRandomAccessReader& m_source;
+    Options m_options;
+    std::unique_ptr<Cache> m_cache;
+};
+
 } // namespace denigma
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include "denigma/conversion.h"
+
+namespace denigma {
+
+/// @class PreparedDocument
+/// @brief A Finale source that is extracted and parsed once and then shared by any number of conversions.
+///
+/// Pass a PreparedDocument to the IPreparedDocumentConverter instances found with
+/// ConverterRegistry::findPrepared to produce several target formats without re-reading the source.
+/// Parsing happens on first use and the parsed document is reused by every later conversion.
+/// A PreparedDocument may be used by concurrent conversions.
+class PreparedDocument
+{
+public:
+    class Impl;
+
+    /// Prepares Enigma XML held in caller-owned memory. The bytes must remain valid for the lifetime of the result.
+    [[nodiscard]] static PreparedDocument fromEnigmaXml(std::span<const std::byte> input, const CommonOptions& options = {});
+
+    /// Extracts a MUSX archive. The reader is only used during this call.
+    [[nodiscard]] static PreparedDocument fromMusx(const IRandomAccessReader& input, const CommonOptions& options = {});
+
+    ~PreparedDocument();
+    PreparedDocument(PreparedDocument&&) noexcept;
+    PreparedDocument& operator=(PreparedDocument&&) noexcept;
+
+    /// Returns the diagnostics collected while the source was extracted.
+    [[nodiscard]] const ConversionResult& preparationResult() const noexcept;
+
+    /// Returns the implementation used by the converter adapters.
+    [[nodiscard]] const Impl& impl() const noexcept { return *m_impl; }
+
+private:
+    explicit PreparedDocument(std::unique_ptr<Impl> impl);
+
+    std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace denigma
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace denigma {
+
+/// @brief The memory held by one of the caches that outlive a single conversion.
+struct ProcessCacheUsage
+{
+    std::string name;           ///< the cache, e.g. `smufl-metadata`
+    std::size_t bytes{};        ///< estimated bytes held now
+    std::uint64_t evictions{};  ///< entries dropped to stay within the budget
+};
+
+/// @brief Sets one memory budget for all process-wide caches (SMuFL font metadata, compiled MNX schemas and the
+/// `serve` result cache). When the caches together exceed it, the least recently used entries are dropped, whichever
+/// cache holds them. Lowering the budget evicts at once. 0, the default, means no limit.
+void setProcessCacheBudget(std::size_t bytes);
+
+/// @brief Returns the budget set by setProcessCacheBudget, or 0 if there is none.
+[[nodiscard]] std::size_t processCacheBudget();
+
+/// @brief Returns the memory held by each process-wide cache created so far.
+[[nodiscard]] std::vector<ProcessCacheUsage> processCacheUsage();
+
+} // namespace denigma
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+#
+# Generates src/utils/font_metric_tables_data.cpp from font files, so that the faces most scores use can be
+# measured without the fonts being installed. Requires fontTools (pip install fonttools).
+#
+# Usage: scripts/generate_font_metric_tables.py [--output PATH] FONT_FILE...
+#
+# Each face of each file (every member of a .ttc) becomes one table, keyed by its family name and style. The
+# metrics are those the FreeType backend of textmetrics.cpp reads unhinted: hmtx advances, glyph ink boxes,
+# hhea ascender/descender and the legacy kern table.
+
+import argparse
+import os
+import re
+import sys
+
+from fontTools.pens.boundsPen import BoundsPen
+from fontTools.ttLib import TTCollection, TTFont
+
+HEADER_PATH = os.path.join(os.path.dirname(__file__), "..", "src", "utils", "font_names.cpp")
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(__file__), "..", "src", "utils", "font_metric_tables_data.cpp")
+
+
+def normalized_font_name(name):
+    # keep in step with utils::normalizedFontName
+    return "".join(c.lower() for c in name if c.isascii() and c.isalnum())
+
+
+def family_name(font):
+    names = font["name"]
+    for name_id in (16, 1):  # typographic family first, as FreeType's family_name
+        record = names.getName(name_id, 3, 1) or names.getName(name_id, 1, 0)
+        if record:
+            return record.toUnicode()
+    raise ValueError("font has no family name")
+
+
+def style_flags(font):
+    mac_style = font["head"].macStyle
+    bold = bool(mac_style & 1)
+    italic = bool(mac_style & 2)
+    if "OS/2" in font:
+        selection = font["OS/2"].fsSelection
+        bold = bold or bool(selection & 0x20)
+        italic = italic or bool(selection & 0x01)
+    return bold, italic
+
+
+def glyph_rows(font):
+    glyph_set = font.getGlyphSet()
+    metrics = font["hmtx"].metrics
+    rows = []
+    for code_point, glyph_name in sorted(font.getBestCmap().items()):
+        pen = BoundsPen(glyph_set)
+        glyph_set[glyph_name].draw(pen)
+        x_min, y_min, x_max, y_max = pen.bounds or (0, 0, 0, 0)
+        rows.append((code_point, metrics[glyph_name][0], x_min, y_min, x_max, y_max))
+    return rows
+
+
+def kerning_rows(font):
+    if "kern" not in font:
+        return []
+    glyph_to_code_points = {}
+    for code_point, glyph_name in font.getBestCmap().items():
+        glyph_to_code_points.setdefault(glyph_name, []).append(code_point)
+    pairs = {}
+    for subtable in font["kern"].kernTables:
+        if getattr(subtable, "format", 0) != 0 or not getattr(subtable, "coverage", 1) & 1:
+            continue  # FreeType applies only horizontal format 0 subtables
+        for (left, right), value in subtable.kernTable.items():
+            for left_code_point in glyph_to_code_points.get(left, []):
+                for right_code_point in glyph_to_code_points.get(right, []):
+                    pairs[(left_code_point, right_code_point)] = value
+    return sorted((left, right, value) for (left, right), value in pairs.items() if value)
+
+
+def faces(path):
+    if path.lower().endswith((".ttc", ".otc")):
+        return list(TTCollection(path).fonts)
+    return [TTFont(path)]
+
+
+def identifier(family, bold, italic):
+    return re.sub(r"\W", "_", family) + ("_Bold" if bold else "") + ("_Italic" if italic else "")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generates the compiled-in font metric tables.")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT)
+    parser.add_argument("fonts", nargs="*")
+    args = parser.parse_args()
+
+    with open(HEADER_PATH, encoding="utf-8") as header_file:
+        license_header = header_file.read().split("*/", 1)[0] + "*/\n"
+
+    tables = []
+    arrays = []
+    for path in args.fonts:
+        for font in faces(path):
+            family = family_name(font)
+            bold, italic = style_flags(font)
+            name = identifier(family, bold, italic)
+            glyphs = glyph_rows(font)
+            kerning = kerning_rows(font)
+            arrays.append(f"// {family}{' Bold' if bold else ''}{' Italic' if italic else ''} ({os.path.basename(path)})")
+            arrays.append(f"constexpr FontMetricGlyph {name}_GLYPHS[] = {{")
+            arrays.extend(f"    {{ 0x{g[0]:04X}, {g[1]}, {g[2]}, {g[3]}, {g[4]}, {g[5]} }}," for g in glyphs)
+            arrays.append("};")
+            if kerning:
+                arrays.append(f"constexpr FontMetricKerning {name}_KERNING[] = {{")
+                arrays.extend(f"    {{ 0x{k[0]:04X}, 0x{k[1]:04X}, {k[2]} }}," for k in kerning)
+                arrays.append("};")
+            arrays.append("")
+            hhea = font["hhea"]
+            tables.append(f"    {{ \"{normalized_font_name(family)}\", {str(bold).lower()}, {str(italic).lower()}, "
+                          f"{font['head'].unitsPerEm}, {hhea.ascent}, {hhea.descent}, {name}_GLYPHS, "
+                          f"{name + '_KERNING' if kerning else '{}'} }},")
+
+    with open(args.output, "w", encoding="utf-8", newline="\n") as output:
+        output.write(license_header)
+        output.write("// Generated by scripts/generate_font_metric_tables.py. Do not edit.\n")
+        output.write("#include \"font_metric_tables.h\"\n\nnamespace utils {\n\n")
+        if tables:
+            output.write("namespace {\n\n" + "\n".join(arrays))
+            output.write("constexpr FontMetricTable TABLES[] = {\n" + "\n".join(tables) + "\n};\n\n} // namespace\n\n")
+        output.write("std::span<const FontMetricTable> builtInFontMetricTables()\n{\n")
+        output.write("    return TABLES;\n" if tables else "    return {};\n")
+        output.write("}\n\n} // namespace utils\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+#
+# Generates src/utils/smufl_metadata_tables_data.cpp from SMuFL font metadata files, so that glyph names and
+# metrics of the fonts most scores use resolve without the metadata being installed or parsed at run time.
+#
+# Usage: scripts/generate_smufl_metadata_tables.py [--output PATH] METADATA_JSON...
+#
+# Each file becomes one table, keyed by its fontName (or, lacking one, the file's base name). Only the sections
+# smufl_support.cpp reads are kept: glyphAdvanceWidths, glyphBBoxes and the code points of optionalGlyphs. Pass
+# the metadata of Bravura, Petaluma and the Finale SMuFL fonts that utils::mappedSmuflFontForFinaleLegacyFont
+# maps to (Finale Maestro, Finale Jazz, Finale Broadway, Finale Engraver, Finale Ash, Finale Legacy).
+
+import argparse
+import json
+import os
+import re
+import sys
+
+HEADER_PATH = os.path.join(os.path.dirname(__file__), "..", "src", "utils", "font_names.cpp")
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(__file__), "..", "src", "utils", "smufl_metadata_tables_data.cpp")
+
+
+def normalized_font_name(name):
+    # keep in step with utils::normalizedFontName
+    return "".join(c.lower() for c in name if c.isascii() and c.isalnum())
+
+
+def font_name(metadata, path):
+    name = metadata.get("fontName")
+    if isinstance(name, str) and name:
+        return name
+    return os.path.splitext(os.path.basename(path))[0]
+
+
+def number(value):
+    return repr(float(value))
+
+
+def glyph_rows(metadata):
+    advances = {name: value for name, value in metadata.get("glyphAdvanceWidths", {}).items()
+                if isinstance(value, (int, float))}
+    boxes = {}
+    for name, box in metadata.get("glyphBBoxes", {}).items():
+        sw = box.get("bBoxSW")
+        ne = box.get("bBoxNE")
+        if isinstance(sw, list) and isinstance(ne, list) and len(sw) >= 2 and len(ne) >= 2:
+            boxes[name] = (sw[0], sw[1], ne[0], ne[1])
+    rows = []
+    # byte order of the UTF-8 names, which is std::string_view order
+    for name in sorted(set(advances) | set(boxes), key=lambda n: n.encode("utf-8")):
+        advance = f"true, {number(advances[name])}" if name in advances else "false, 0.0"
+        box = (f"true, {{ {', '.join(number(v) for v in boxes[name])} }}" if name in boxes
+               else "false, {}")
+        rows.append(f"    {{ \"{name}\", {advance}, {box} }},")
+    return rows
+
+
+def optional_glyph_rows(metadata):
+    code_points = {}
+    for name, data in metadata.get("optionalGlyphs", {}).items():
+        code_point = data.get("codepoint") if isinstance(data, dict) else None
+        if isinstance(code_point, str) and code_point.upper().startswith("U+"):
+            code_points.setdefault(int(code_point[2:], 16), name)
+    return [f"    {{ 0x{cp:04X}, \"{name}\" }}," for cp, name in sorted(code_points.items())]
+
+
+def identifier(name):
+    return re.sub(r"\W", "_", name)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generates the compiled-in SMuFL metadata tables.")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT)
+    parser.add_argument("metadata", nargs="*")
+    args = parser.parse_args()
+
+    with open(HEADER_PATH, encoding="utf-8") as header_file:
+        license_header = header_file.read().split("*/", 1)[0] + "*/\n"
+
+    tables = []
+    arrays = []
+    for path in args.metadata:
+        with open(path, encoding="utf-8") as metadata_file:
+            metadata = json.load(metadata_file)
+        family = font_name(metadata, path)
+        name = identifier(family)
+        glyphs = glyph_rows(metadata)
+        optional_glyphs = optional_glyph_rows(metadata)
+        arrays.append(f"// {family} ({os.path.basename(path)})")
+        if glyphs:
+            arrays.append(f"constexpr SmuflMetadataGlyph {name}_GLYPHS[] = {{")
+            arrays.extend(glyphs)
+            arrays.append("};")
+        if optional_glyphs:
+            arrays.append(f"constexpr SmuflMetadataOptionalGlyph {name}_OPTIONAL_GLYPHS[] = {{")
+            arrays.extend(optional_glyphs)
+            arrays.append("};")
+        arrays.append("")
+        tables.append(f"    {{ \"{normalized_font_name(family)}\", "
+                      f"{name + '_GLYPHS' if glyphs else '{}'}, "
+                      f"{name + '_OPTIONAL_GLYPHS' if optional_glyphs else '{}'} }},")
+
+    with open(args.output, "w", encoding="utf-8", newline="\n") as output:
+        output.write(license_header)
+        output.write("// Generated by scripts/generate_smufl_metadata_tables.py. Do not edit.\n")
+        output.write("#include \"smufl_metadata_tables.h\"\n\nnamespace utils {\n\n")
+        if tables:
+            output.write("namespace {\n\n" + "\n".join(arrays))
+            output.write("constexpr SmuflMetadataTable TABLES[] = {\n" + "\n".join(tables) + "\n};\n\n} // namespace\n\n")
+        output.write("std::span<const SmuflMetadataTable> builtInSmuflMetadataTables()\n{\n")
+        output.write("    return TABLES;\n" if tables else "    return {};\n")
+        output.write("}\n\n} // namespace utils\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -21,10 +21,13 @@
  */
 #include "denigma/classify/articulations.h"
 
+#include <string>
 #include <string_view>
-#include <unordered_map>
+#include <tuple>
 #include <utility>
 
+#include "classify/classification_cache.h"
+#include "utils/constexpr_string_map.h"
 #include "smufl_mapping.h"
 
 namespace denigma::classify {
@@ -364,7 +367,7 @@ static ArticulationClassification classifyShape(
 static PrivateClassification classifyGlyphName(std::string glyphName)
 {
     using GlyphClassifier = PrivateClassification (*)(std::string);
-    static const std::unordered_map<std::string_view, GlyphClassifier> glyphClassifiers = {
+    static constexpr auto glyphClassifiers = utils::makeConstexprStringMap<GlyphClassifier>({
         // Arpeggio
         { "arpeggiato", [](std::string glyphName) -> PrivateClassification { return makeArpeggio(Arpeggio::Type::Normal, std::move(glyphName)); } },
         { "arpeggiatoDown", [](std::string glyphName) -> PrivateClassification { return makeArpeggio(Arpeggio::Type::Down, std::move(glyphName)); } },
@@ -867,11 +870,11 @@ static PrivateClassification classifyGlyphName(std::string glyphName)
         { "unmeasuredTremoloSimple", [](std::string glyphName) -> PrivateClassification {
             return makeTremolo(Tremolo::Style::Unmeasured, 0, std::move(glyphName));
         } }
-    };
+    });
 
     const std::string_view glyph = glyphName;
-    if (const auto it = glyphClassifiers.find(glyph); it != glyphClassifiers.end()) {
-        return it->second(std::move(glyphName));
+    if (const auto* classifier = glyphClassifiers.find(glyph)) {
+        return (*classifier)(std::move(glyphName));
     }
     return {};
 }
@@ -945,13 +948,31 @@ ArticulationClassification classifyArticulationSymbol(
     return std::get<ArticulationClassification>(std::move(classification));
 }
 
+/// Articulation shapes keyed by requested part and shape cmper.
+using ArticulationShapeTable = detail::ClassificationCache::Table<
+    std::pair<musx::dom::Cmper, musx::dom::Cmper>, ArticulationClassification>;
+/// Articulation glyphs keyed by font name, symbol-font flag and character, which are all the glyph lookup reads.
+using ArticulationSymbolTable = detail::ClassificationCache::Table<
+    std::tuple<std::string, bool, char32_t>, PrivateClassification>;
+
 static PrivateClassification classifySelectedSymbolContext(
     const musx::dom::details::ArticulationAssign::SelectedSymbolContext& context)
 {
+    const auto& definition = context.definition;
     if (context.symbol.isShape) {
-        return classifyShape(context.definition, context.symbol.shapeId);
+        if (!definition) {
+            return classifyShape(definition, context.symbol.shapeId);
+        }
+        return detail::cachedClassification<ArticulationShapeTable>(definition->getDocument(),
+            std::make_pair(definition->getRequestedPartId(), context.symbol.shapeId),
+            [&]() { return classifyShape(definition, context.symbol.shapeId); });
+    }
+    if (!definition || !context.symbol.font) {
+        return classifySymbol(context.symbol.font, context.symbol.character);
     }
-    return classifySymbol(context.symbol.font, context.symbol.character);
+    return detail::cachedClassification<ArticulationSymbolTable>(definition->getDocument(),
+        std::make_tuple(context.symbol.font->getName(), context.symbol.font->calcIsSymbolFont(), context.symbol.character),
+        [&]() { return classifySymbol(context.symbol.font, context.symbol.character); });
 }
 
 ArticulationClassification classifyArticulation(
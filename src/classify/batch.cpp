@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "denigma/classify/batch.h"
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace denigma::classify {
+
+namespace {
+
+static_assert(std::variant_size_v<ArticulationValue> == static_cast<std::size_t>(ArticulationKind::OtherMark) + 1);
+static_assert(std::is_same_v<
+    std::variant_alternative_t<static_cast<std::size_t>(ArticulationKind::PseudoTie), ArticulationValue>, PseudoTie>);
+
+template <typename Enum>
+std::uint16_t subtypeCode(Enum value)
+{
+    return static_cast<std::uint16_t>(value);
+}
+
+static std::pair<std::uint16_t, std::string_view> expressionSubtypeAndText(const ExpressionValue& value)
+{
+    return std::visit([](const auto& payload) -> std::pair<std::uint16_t, std::string_view> {
+        using T = std::decay_t<decltype(payload)>;
+        if constexpr (std::is_same_v<T, dynamics::Mark>) {
+            return { subtypeCode(payload.dynamic), {} };
+        } else if constexpr (std::is_same_v<T, keyboardpedal::Type>) {
+            return { subtypeCode(payload), {} };
+        } else if constexpr (std::is_same_v<T, expression::TechniqueText>) {
+            return { subtypeCode(payload.type), payload.text };
+        } else if constexpr (std::is_same_v<T, expression::TempoText> || std::is_same_v<T, expression::TempoAlteration>) {
+            return { 0, payload.tempo.text };
+        } else if constexpr (std::is_same_v<T, expression::RehearsalMark> || std::is_same_v<T, expression::GenericText>) {
+            return { 0, payload.text };
+        } else if constexpr (std::is_same_v<T, expression::Error>) {
+            return { 0, payload.message };
+        } else {
+            return { 0, {} };
+        }
+    }, value);
+}
+
+} // namespace
+
+std::uint32_t StringPool::intern(std::string_view text)
+{
+    if (const auto it = m_indices.find(text); it != m_indices.end()) {
+        return it->second;
+    }
+    const auto index = static_cast<std::uint32_t>(m_strings.size());
+    const std::string& stored = m_strings.emplace_back(text);
+    m_indices.emplace(stored, index);
+    return index;
+}
+
+ExpressionColumns classifyExpressionColumns(
+    const musx::dom::MusxInstanceList<musx::dom::others::MeasureExprAssign>& assignments)
+{
+    ExpressionColumns result;
+    result.types.reserve(assignments.size());
+    result.bases.reserve(assignments.size());
+    result.subtypes.reserve(assignments.size());
+    result.texts.reserve(assignments.size());
+    // top-staff propagation needs every classification at once, so the full results are flattened afterwards
+    for (const auto& classified : classifyExpressionAssignments(assignments)) {
+        const auto& classification = classified.classification;
+        const auto [subtype, text] = expressionSubtypeAndText(classification.value);
+        result.types.push_back(classification.type);
+        result.bases.push_back(classification.basis);
+        result.subtypes.push_back(subtype);
+        result.texts.push_back(text.empty() ? StringPool::NONE : result.strings.intern(text));
+    }
+    return result;
+}
+
+ArticulationColumns classifyArticulationColumns(
+    const musx::dom::MusxInstanceList<musx::dom::details::ArticulationAssign>& assignments)
+{
+    ArticulationColumns result;
+    result.kinds.reserve(assignments.size());
+    result.placements.reserve(assignments.size());
+    result.glyphNames.reserve(assignments.size());
+    // an entry's assignments are adjacent in the list, so resolving the last entry again is all the caching needed
+    musx::dom::EntryInfoPtr entryInfo;
+    std::optional<musx::dom::EntryNumber> entryNumber;
+    for (const auto& assignment : assignments) {
+        ArticulationClassification classification;
+        if (assignment) {
+            if (entryNumber != assignment->getEntryNumber()) {
+                entryNumber = assignment->getEntryNumber();
+                entryInfo = musx::dom::EntryInfoPtr::fromEntryNumber(
+                    assignment->getDocument(), assignment->getRequestedPartId(), *entryNumber);
+            }
+            classification = classifyArticulation(assignment, entryInfo);
+        }
+        result.kinds.push_back(static_cast<ArticulationKind>(classification.value.index()));
+        result.placements.push_back(classification.placement);
+        result.glyphNames.push_back(classification.glyphName ? result.strings.intern(*classification.glyphName) : StringPool::NONE);
+    }
+    return result;
+}
+
+} // namespace denigma::classify
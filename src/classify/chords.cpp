@@ -26,10 +26,11 @@
 #include <cctype>
 #include <optional>
 #include <string_view>
-#include <unordered_map>
 #include <utility>
 
+#include "classify/classification_cache.h"
 #include "smufl_mapping.h"
+#include "utils/constexpr_string_map.h"
 
 namespace denigma {
 namespace classify {
@@ -54,7 +55,7 @@ std::string prefixText(musx::dom::others::ChordSuffixElement::Prefix prefix)
 
 std::optional<std::string_view> unicodeTextForGlyph(std::string_view glyphName)
 {
-    static const std::unordered_map<std::string_view, std::string_view> glyphText {
+    static constexpr auto glyphText = utils::makeConstexprStringMap<std::string_view>({
         { "accidentalFlat", "♭" },
         { "accidentalNatural", "♮" },
         { "accidentalSharp", "♯" },
@@ -88,9 +89,9 @@ std::optional<std::string_view> unicodeTextForGlyph(std::string_view glyphName)
         { "csymBracketRightTall", "]" },
         { "csymAlteredBassSlash", "/" },
         { "csymDiagonalArrangementSlash", "/" },
-    };
-    const auto found = glyphText.find(glyphName);
-    return found == glyphText.end() ? std::nullopt : std::optional<std::string_view>(found->second);
+    });
+    const auto* found = glyphText.find(glyphName);
+    return found ? std::optional<std::string_view>(*found) : std::nullopt;
 }
 
 chord::SuffixString::Position suffixStringPosition(musx::dom::Evpu verticalOffset)
@@ -359,5 +360,18 @@ ChordSuffixClassification classifyChordSuffix(
     return result;
 }
 
+/// Chord suffix classifications keyed by requested part and suffix cmper.
+using ChordSuffixTable = detail::ClassificationCache::Table<std::pair<musx::dom::Cmper, musx::dom::Cmper>, ChordSuffixClassification>;
+
+ChordSuffixClassification classifyChordSuffix(const musx::dom::MusxInstance<musx::dom::details::ChordAssign>& assignment)
+{
+    if (!assignment || !assignment->showSuffix) {
+        return classifyChordSuffix();
+    }
+    return detail::cachedClassification<ChordSuffixTable>(assignment->getDocument(),
+        std::make_pair(assignment->getRequestedPartId(), assignment->suffixId),
+        [&]() { return classifyChordSuffix(assignment->getChordSuffix()); });
+}
+
 } // namespace classify
 } // namespace denigma
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "classification_cache.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace denigma::classify::detail {
+
+namespace {
+
+struct RegisteredCache
+{
+    std::weak_ptr<const musx::dom::Document> document;
+    std::weak_ptr<ClassificationCache> cache;
+};
+
+bool isSameDocument(const std::weak_ptr<const musx::dom::Document>& registered, const musx::dom::DocumentPtr& document)
+{
+    // owner comparison also tells a new document apart from a destroyed one that had the same address
+    return !registered.owner_before(document) && !document.owner_before(registered);
+}
+
+} // namespace
+
+std::shared_ptr<ClassificationCache> ClassificationCache::forDocument(const musx::dom::DocumentPtr& document)
+{
+    if (!document) {
+        return nullptr;
+    }
+    // consecutive classifications almost always belong to the same document, so skip the registry lock for those
+    thread_local RegisteredCache lastUsed;
+    if (isSameDocument(lastUsed.document, document)) {
+        if (auto cache = lastUsed.cache.lock()) {
+            return cache;
+        }
+    }
+
+    struct Registered
+    {
+        std::weak_ptr<const musx::dom::Document> document;
+        std::shared_ptr<ClassificationCache> cache;
+    };
+    static std::mutex registryMutex;
+    static std::vector<Registered> registry;
+
+    std::lock_guard lock(registryMutex);
+    auto it = std::find_if(registry.begin(), registry.end(), [&](const Registered& entry) {
+        return isSameDocument(entry.document, document);
+    });
+    if (it == registry.end()) {
+        // a document's cache is released when the next new document registers after it is destroyed
+        std::erase_if(registry, [](const Registered& entry) { return entry.document.expired(); });
+        registry.push_back({ document, std::make_shared<ClassificationCache>() });
+        it = std::prev(registry.end());
+    }
+    lastUsed = { it->document, it->cache };
+    return it->cache;
+}
+
+} // namespace denigma::classify::detail
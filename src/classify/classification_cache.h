@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+
+#include "musx/musx.h"
+
+namespace denigma::classify::detail {
+
+/**
+ * @class ClassificationCache
+ * @brief Per-document memo of the definition-level work behind the classifiers.
+ *
+ * Assignments in every measure, of the score and of each linked part, point at a small set of definitions.
+ * Each classifier keeps its own Table here, keyed by exactly what its result depends on, so that text
+ * normalization, glyph lookup and dynamic tokenizing run once per document rather than once per use. The cache
+ * belongs to the document and is shared by every conversion of it, on any thread.
+ */
+class ClassificationCache
+{
+    struct Counters
+    {
+        std::atomic<std::uint64_t> hits{};
+        std::atomic<std::uint64_t> misses{};
+    };
+
+public:
+    /// @brief How many lookups, across all of a cache's tables, found a stored value and how many computed one.
+    struct LookupCounts
+    {
+        std::uint64_t hits{};
+        std::uint64_t misses{};
+    };
+
+    /// @brief A thread-safe map from Key to a computed Value.
+    template <typename Key, typename Value>
+    class Table
+    {
+    public:
+        using value_type = Value;
+
+        /// Returns the value stored for key, computing and storing it first if it is missing.
+        template <typename Compute>
+        Value findOrCompute(const Key& key, Compute&& compute)
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                if (const auto it = m_values.find(key); it != m_values.end()) {
+                    count(&Counters::hits);
+                    return it->second;
+                }
+            }
+            count(&Counters::misses);
+            // computed unlocked, since classifiers may consult other tables; a racing duplicate is equal anyway
+            Value value = std::forward<Compute>(compute)();
+            std::lock_guard lock(m_mutex);
+            return m_values.try_emplace(key, std::move(value)).first->second;
+        }
+
+    private:
+        friend class ClassificationCache;
+
+        void count(std::atomic<std::uint64_t> Counters::* counter)
+        {
+            if (m_counters) {
+                (m_counters->*counter).fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        std::mutex m_mutex;
+        std::map<Key, Value> m_values;
+        Counters* m_counters{};     ///< the owning cache's counters, set when the cache creates the table
+    };
+
+    /// Returns this cache's table of type TableType, creating it on first use.
+    template <typename TableType>
+    TableType& table()
+    {
+        std::lock_guard lock(m_mutex);
+        auto& slot = m_tables[std::type_index(typeid(TableType))];
+        if (!slot) {
+            auto created = std::make_shared<TableType>();
+            created->m_counters = &m_counters;
+            slot = std::move(created);
+        }
+        return *std::static_pointer_cast<TableType>(slot);
+    }
+
+    /// Returns the lookups made in this cache so far. Conversions sharing the document share the counts.
+    LookupCounts lookupCounts() const
+    {
+        return { m_counters.hits.load(std::memory_order_relaxed), m_counters.misses.load(std::memory_order_relaxed) };
+    }
+
+    /// Returns the cache of document, creating it on first use, or nullptr when there is no document.
+    static std::shared_ptr<ClassificationCache> forDocument(const musx::dom::DocumentPtr& document);
+
+private:
+    std::mutex m_mutex;
+    std::unordered_map<std::type_index, std::shared_ptr<void>> m_tables;
+    Counters m_counters;
+};
+
+/// Looks key up in document's TableType, calling compute on a miss. Without a document compute is simply called.
+template <typename TableType, typename Key, typename Compute>
+typename TableType::value_type cachedClassification(const musx::dom::DocumentPtr& document, const Key& key, Compute&& compute)
+{
+    if (const auto cache = ClassificationCache::forDocument(document)) {
+        return cache->table<TableType>().findOrCompute(key, std::forward<Compute>(compute));
+    }
+    return std::forward<Compute>(compute)();
+}
+
+} // namespace denigma::classify::detail
@@ -23,6 +23,8 @@
 
 #include "smufl_mapping.h"
 
+#include "core/hot_path_counters.h"
+
 namespace denigma {
 namespace classify {
 namespace detail {
@@ -38,11 +40,10 @@ std::optional<std::string> glyphNameForFont(
         if (const auto* name = smufl_mapping::getGlyphName(codepoint)) {
             return std::string(*name);
         }
-        return std::nullopt;
-    }
-    if (const auto legacyInfo = smufl_mapping::getLegacyGlyphInfo(font->getName(), codepoint)) {
+    } else if (const auto legacyInfo = smufl_mapping::getLegacyGlyphInfo(font->getName(), codepoint)) {
         return std::string(legacyInfo->name);
     }
+    countHotPath(ConversionStats::HotPath::UnmatchedGlyph);
     return std::nullopt;
 }
 
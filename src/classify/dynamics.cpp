@@ -26,11 +26,11 @@
 #include <optional>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <vector>
 
 #include "smufl_mapping.h"
 #include "classify/classify.h"
+#include "utils/constexpr_string_map.h"
 #include "utils/stringutils.h"
 #include "utils/utf8_iterator.h"
 
@@ -49,7 +49,7 @@ struct DynamicText
     };
 
     std::string text;
-    std::vector<std::optional<std::string>> glyphNames;
+    std::vector<std::optional<std::string_view>> glyphNames; ///< views of SMuFL mapping names, which are static
     std::vector<std::optional<size_t>> glyphIds;
     std::vector<SourceSpan> sourceSpans;
 };
@@ -89,51 +89,47 @@ static DynamicText normalizeDynamicText(const DynamicText& input)
     return result;
 }
 
-static const std::unordered_map<std::string_view, std::string_view>& dynamicGlyphLettersMap()
-{
-    static const std::unordered_map<std::string_view, std::string_view> result = {
-        { "dynamicPiano", "p" },
-        { "dynamicPianoSmall", "p" },
-        { "dynamicPP", "pp" },
-        { "dynamicPPP", "ppp" },
-        { "dynamicPPPP", "pppp" },
-        { "dynamicPPPPP", "ppppp" },
-        { "dynamicPPPPPP", "pppppp" },
-        { "dynamicMezzo", "m" },
-        { "dynamicMezzoSmall", "m" },
-        { "dynamicMP", "mp" },
-        { "dynamicMF", "mf" },
-        { "dynamicForte", "f" },
-        { "dynamicForteSmall", "f" },
-        { "dynamicFF", "ff" },
-        { "dynamicFFF", "fff" },
-        { "dynamicFFFF", "ffff" },
-        { "dynamicFFFFF", "fffff" },
-        { "dynamicFFFFFF", "ffffff" },
-        { "dynamicFortePiano", "fp" },
-        { "dynamicPF", "pf" },
-        { "dynamicForzando", "fz" },
-        { "dynamicSforzando", "s" },
-        { "dynamicSforzandoLegacy", "s" },
-        { "dynamicSforzandoSmall", "s" },
-        { "dynamicSforzando1", "sf" },
-        { "dynamicSforzandoPiano", "sfp" },
-        { "dynamicSforzandoPianissimo", "sfpp" },
-        { "dynamicSforzato", "sfz" },
-        { "dynamicSforzatoPiano", "sfzp" },
-        { "dynamicSforzatoFF", "sffz" },
-        { "dynamicRinforzando", "r" },
-        { "dynamicRinforzandoSmall", "r" },
-        { "dynamicRinforzando1", "rf" },
-        { "dynamicRinforzando2", "rfz" },
-        { "dynamicZ", "z" },
-        { "dynamicZSmall", "z" },
-        { "dynamicNiente", "n" },
-        { "dynamicNienteForHairpin", "n" },
-        { "dynamicNienteSmall", "n" }
-    };
-    return result;
-}
+static constexpr auto dynamicGlyphLetters = utils::makeConstexprStringMap<std::string_view>({
+    { "dynamicPiano", "p" },
+    { "dynamicPianoSmall", "p" },
+    { "dynamicPP", "pp" },
+    { "dynamicPPP", "ppp" },
+    { "dynamicPPPP", "pppp" },
+    { "dynamicPPPPP", "ppppp" },
+    { "dynamicPPPPPP", "pppppp" },
+    { "dynamicMezzo", "m" },
+    { "dynamicMezzoSmall", "m" },
+    { "dynamicMP", "mp" },
+    { "dynamicMF", "mf" },
+    { "dynamicForte", "f" },
+    { "dynamicForteSmall", "f" },
+    { "dynamicFF", "ff" },
+    { "dynamicFFF", "fff" },
+    { "dynamicFFFF", "ffff" },
+    { "dynamicFFFFF", "fffff" },
+    { "dynamicFFFFFF", "ffffff" },
+    { "dynamicFortePiano", "fp" },
+    { "dynamicPF", "pf" },
+    { "dynamicForzando", "fz" },
+    { "dynamicSforzando", "s" },
+    { "dynamicSforzandoLegacy", "s" },
+    { "dynamicSforzandoSmall", "s" },
+    { "dynamicSforzando1", "sf" },
+    { "dynamicSforzandoPiano", "sfp" },
+    { "dynamicSforzandoPianissimo", "sfpp" },
+    { "dynamicSforzato", "sfz" },
+    { "dynamicSforzatoPiano", "sfzp" },
+    { "dynamicSforzatoFF", "sffz" },
+    { "dynamicRinforzando", "r" },
+    { "dynamicRinforzandoSmall", "r" },
+    { "dynamicRinforzando1", "rf" },
+    { "dynamicRinforzando2", "rfz" },
+    { "dynamicZ", "z" },
+    { "dynamicZSmall", "z" },
+    { "dynamicNiente", "n" },
+    { "dynamicNienteForHairpin", "n" },
+    { "dynamicNienteSmall", "n" }
+});
 
 static std::optional<std::string_view> dynamicLetterGlyphName(char ch)
 {
@@ -149,11 +145,10 @@ static std::optional<std::string_view> dynamicLetterGlyphName(char ch)
     }
 }
 
-static std::string glyphNameToDynamicText(std::string_view glyphName)
+static std::string_view glyphNameToDynamicText(std::string_view glyphName)
 {
-    const auto& glyphLetters = dynamicGlyphLettersMap();
-    const auto glyphIt = glyphLetters.find(glyphName);
-    return glyphIt == glyphLetters.end() ? std::string{} : std::string(glyphIt->second);
+    const auto* letters = dynamicGlyphLetters.find(glyphName);
+    return letters ? *letters : std::string_view{};
 }
 
 static void appendDynamicText(
@@ -163,18 +158,25 @@ static void appendDynamicText(
     size_t chunkStart)
 {
     size_t nextGlyphId = text.glyphIds.size();
+    // the font's name and SMuFL status are looked up once per chunk rather than once per code point
+    const std::string fontName = font ? font->getName() : std::string{};
+    const bool fontIsSmufl = font && font->calcIsSMuFL();
+    text.text.reserve(text.text.size() + chunk.size());
+    text.glyphNames.reserve(text.glyphNames.size() + chunk.size());
+    text.glyphIds.reserve(text.glyphIds.size() + chunk.size());
+    text.sourceSpans.reserve(text.sourceSpans.size() + chunk.size());
     for (utils::Utf8Iterator iter(chunk); !iter.atEnd(); iter.next()) {
-        const std::string codepointText = chunk.substr(iter.offset(), iter->byteCount);
+        const std::string_view codepointText = std::string_view(chunk).substr(iter.offset(), iter->byteCount);
         const DynamicText::SourceSpan sourceSpan{ chunkStart + iter.offset(), chunkStart + iter.offset() + iter->byteCount };
         if (font) {
             if (const auto* glyphName = smufl_mapping::getGlyphNameForFont(
-                    font->getName(),
+                    fontName,
                     iter->codepoint,
-                    font->calcIsSMuFL(),
+                    fontIsSmufl,
                     smufl_mapping::SmuflGlyphSource::Finale)) {
-                if (const std::string glyphText = glyphNameToDynamicText(*glyphName); !glyphText.empty()) {
+                if (const std::string_view glyphText = glyphNameToDynamicText(*glyphName); !glyphText.empty()) {
                     text.text += glyphText;
-                    text.glyphNames.insert(text.glyphNames.end(), glyphText.size(), std::string(*glyphName));
+                    text.glyphNames.insert(text.glyphNames.end(), glyphText.size(), std::string_view(*glyphName));
                     text.glyphIds.insert(text.glyphIds.end(), glyphText.size(), nextGlyphId++);
                     text.sourceSpans.insert(text.sourceSpans.end(), glyphText.size(), sourceSpan);
                     continue;
@@ -197,7 +199,7 @@ struct DynamicTokenMatch
 
 static Dynamic classifyExactDynamicToken(std::string_view text)
 {
-    static const std::unordered_map<std::string_view, Dynamic> dynamicTokens = {
+    static constexpr auto dynamicTokens = utils::makeConstexprStringMap<Dynamic>({
         { "pppppp", Dynamic::pppppp },
         { "ppppp", Dynamic::ppppp },
         { "pppp", Dynamic::pppp },
@@ -234,9 +236,9 @@ static Dynamic classifyExactDynamicToken(std::string_view text)
         { "rfz", Dynamic::rfz },
         { "n", Dynamic::n },
         { "niente", Dynamic::n }
-    };
-    const auto tokenIt = dynamicTokens.find(text);
-    return tokenIt == dynamicTokens.end() ? Dynamic::None : tokenIt->second;
+    });
+    const auto* dynamic = dynamicTokens.find(text);
+    return dynamic ? *dynamic : Dynamic::None;
 }
 
 static bool isDynamicLikeText(std::string_view text)
@@ -251,7 +253,7 @@ static bool isSmuflGlyphMatch(const DynamicText& text, const DynamicTokenMatch&
 {
     return std::all_of(text.glyphNames.begin() + static_cast<std::ptrdiff_t>(match.start),
                        text.glyphNames.begin() + static_cast<std::ptrdiff_t>(match.start + match.length),
-                       [](const std::optional<std::string>& glyphName) { return glyphName.has_value(); });
+                       [](const std::optional<std::string_view>& glyphName) { return glyphName.has_value(); });
 }
 
 static bool isSpaceDelimitedMatch(const DynamicText& text, const DynamicTokenMatch& match)
@@ -278,7 +280,7 @@ static std::vector<std::string> matchedGlyphNames(const DynamicText& text, const
             return {};
         }
         if (!previousGlyphId || *previousGlyphId != *glyphId) {
-            result.push_back(*glyphName);
+            result.emplace_back(*glyphName);
             previousGlyphId = glyphId;
         }
     }
@@ -297,7 +299,7 @@ static std::vector<std::string> knownGlyphNames(const DynamicText& text)
             continue;
         }
         if (!previousGlyphId || *previousGlyphId != *glyphId) {
-            result.push_back(*glyphName);
+            result.emplace_back(*glyphName);
             previousGlyphId = glyphId;
         }
     }
@@ -526,13 +528,12 @@ std::vector<std::string> dynamicLettersToLetterGlyphs(std::string_view letters)
 std::string dynamicGlyphsToLetters(const std::vector<std::string>& glyphs)
 {
     std::string result;
-    const auto& letterMap = dynamicGlyphLettersMap();
     for (const auto& glyph : glyphs) {
-        const auto glyphIt = letterMap.find(glyph);
-        if (glyphIt == letterMap.end()) {
+        const auto* letters = dynamicGlyphLetters.find(glyph);
+        if (!letters) {
             return {};
         }
-        result += glyphIt->second;
+        result += *letters;
     }
     return result;
 }
@@ -27,11 +27,14 @@
 #include <span>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <vector>
 
 #include "core/denigma.h"
 #include "denigma/classify/articulations.h"
+#include "classify/classification_cache.h"
 #include "classify/classify.h"
+#include "utils/constexpr_string_map.h"
 #include "utils/stringutils.h"
 #include "utils/utf8_iterator.h"
 
@@ -54,24 +57,29 @@ struct ResolvedTextExpression
     std::string errorMessage;
 };
 
-static std::string normalizeExpressionText(std::string_view text)
+/// Writes text into result lowercased, with leading and trailing whitespace dropped and inner runs collapsed to one
+/// space. result is overwritten, so a caller normalizing many texts can reuse one buffer. Only ASCII is folded, which
+/// needs no locale: the loop is plain byte arithmetic the compiler can vectorize.
+static void normalizeExpressionText(std::string_view text, std::string& result)
 {
-    std::string result;
-    result.reserve(text.size());
+    result.resize(text.size());
+    char* out = result.data();
+    char* const begin = out;
     bool previousWasSpace = false;
     for (const char ch : text) {
         const unsigned char uch = static_cast<unsigned char>(ch);
-        if (utils::isSpace(uch)) {
+        const bool isSpace = uch == ' ' || (uch >= '\t' && uch <= '\r');
+        if (isSpace) {
             previousWasSpace = true;
             continue;
         }
-        if (previousWasSpace && !result.empty()) {
-            result.push_back(' ');
+        if (previousWasSpace && out != begin) {
+            *out++ = ' ';
         }
         previousWasSpace = false;
-        result.push_back(utils::toLowerCase(ch));
+        *out++ = static_cast<char>(uch + (static_cast<unsigned char>(uch - 'A') < 26 ? 'a' - 'A' : 0));
     }
-    return result;
+    result.resize(static_cast<size_t>(out - begin));
 }
 
 static ClassificationBasis basisForRecognition(CategoryType categoryType, CategoryType expectedCategory)
@@ -175,10 +183,10 @@ static std::vector<musx::util::EnigmaTextChunk> collectVisibleExpressionChunks(
     return result;
 }
 
-static void appendGenericRun(std::vector<RunClassification>& runs, const musx::util::EnigmaTextChunk& chunk)
+static void appendGenericRun(std::vector<RunClassification>& runs, const musx::util::EnigmaTextChunk& chunk, std::string& normalizedText)
 {
     if (!chunk.text.empty()) {
-        const std::string normalizedText = normalizeExpressionText(chunk.text);
+        normalizeExpressionText(chunk.text, normalizedText);
         const Change change = qualifierChangeForText(normalizedText);
         if (change != Change::Absolute) {
             runs.push_back({ chunk, ClassificationBasis::Heuristic, DynamicQualifier{ change, chunk.text } });
@@ -195,6 +203,7 @@ static std::vector<RunClassification> classifyExpressionRuns(const ResolvedTextE
     }
 
     std::vector<RunClassification> result;
+    std::string normalizedText; // reused by every generic run
     const bool forceDynamicOther = resolved.categoryType == CategoryType::Dynamics;
     for (const auto& chunk : collectVisibleExpressionChunks(resolved.rawTextCtx)) {
         const auto dynamicSpans = detail::findDynamicSpans(chunk);
@@ -204,7 +213,7 @@ static std::vector<RunClassification> classifyExpressionRuns(const ResolvedTextE
                     ? ClassificationBasis::FinaleCategory
                     : basisForRecognition(resolved.categoryType, CategoryType::Dynamics), *dynamic });
             } else {
-                appendGenericRun(result, chunk);
+                appendGenericRun(result, chunk, normalizedText);
             }
             continue;
         }
@@ -213,7 +222,7 @@ static std::vector<RunClassification> classifyExpressionRuns(const ResolvedTextE
         for (const auto& dynamicSpan : dynamicSpans) {
             const size_t dynamicStart = static_cast<size_t>(dynamicSpan.sourceText.data() - chunk.text.data());
             if (dynamicStart > cursor) {
-                appendGenericRun(result, sliceChunk(chunk, cursor, dynamicStart - cursor));
+                appendGenericRun(result, sliceChunk(chunk, cursor, dynamicStart - cursor), normalizedText);
             }
             result.push_back({
                 sliceChunk(chunk, dynamicSpan.sourceText),
@@ -223,7 +232,7 @@ static std::vector<RunClassification> classifyExpressionRuns(const ResolvedTextE
             cursor = dynamicStart + dynamicSpan.sourceText.size();
         }
         if (cursor < chunk.text.size()) {
-            appendGenericRun(result, sliceChunk(chunk, cursor, chunk.text.size() - cursor));
+            appendGenericRun(result, sliceChunk(chunk, cursor, chunk.text.size() - cursor), normalizedText);
         }
     }
     return result;
@@ -252,75 +261,67 @@ static std::optional<ExpressionClassification> makeDynamicExpression(
     return result;
 }
 
-static bool matchesAny(std::string_view text, const std::initializer_list<std::string_view>& values)
-{
-    const std::string_view comparableText = withoutFinalPeriods(text);
-    return std::any_of(values.begin(), values.end(), [&](std::string_view value) {
-        return comparableText == withoutFinalPeriods(value);
-    });
-}
-
 static TechniqueText classifyTechniqueText(std::string_view text, std::string_view normalizedText)
 {
-    if (matchesAny(normalizedText, { "arco" })) {
-        return { TechniqueText::Type::Arco, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "pizz", "pizzicato" })) {
-        return { TechniqueText::Type::Pizzicato, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "col legno", "c. legno" })) {
-        return { TechniqueText::Type::ColLegno, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "col legno battuto", "col legno batt", "c. legno battuto", "c. legno batt" })) {
-        return { TechniqueText::Type::ColLegnoBattuto, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "col legno tratto", "col legno tratt", "c. legno tratto", "c. legno tratt" })) {
-        return { TechniqueText::Type::ColLegnoTratto, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "sul pont", "sul ponticello", "s. pont" })) {
-        return { TechniqueText::Type::SulPonticello, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "sul tasto", "s. tasto" })) {
-        return { TechniqueText::Type::SulTasto, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "flautando", "flaut" })) {
-        return { TechniqueText::Type::Flautando, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "ord", "ordinario" })) {
-        return { TechniqueText::Type::Ordinario, std::string(text) };
-    }
-    if (matchesAny(normalizedText, {
-        "straight mute", "straight", "con sordino straight", "straight sord",
-        "metal mute", "wood mute", "fiber mute", "fibre mute"
-    })) {
-        return { TechniqueText::Type::StraightMute, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "cup mute", "cup", "con sordino cup", "cup sord" })) {
-        return { TechniqueText::Type::CupMute, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "harmon mute", "harmon", "wah-wah mute", "wah wah mute", "wah-wah", "wah wah" })) {
-        return { TechniqueText::Type::HarmonMute, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "plunger mute", "plunger" })) {
-        return { TechniqueText::Type::PlungerMute, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "bucket mute", "bucket" })) {
-        return { TechniqueText::Type::BucketMute, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "solotone mute", "solotone" })) {
-        return { TechniqueText::Type::SolotoneMute, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "stop mute", "brass mute" })) {
-        return { TechniqueText::Type::StopMute, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "stopped", "stop" })) {
-        return { TechniqueText::Type::Stopped, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "con sord", "mute", "muted" })) {
-        return { TechniqueText::Type::Mute, std::string(text) };
-    }
-    if (matchesAny(normalizedText, { "senza sord", "open" })) {
-        return { TechniqueText::Type::Open, std::string(text) };
+    static constexpr auto techniquePhrases = utils::makeConstexprStringMap<TechniqueText::Type>({
+        { "arco", TechniqueText::Type::Arco },
+        { "pizz", TechniqueText::Type::Pizzicato },
+        { "pizzicato", TechniqueText::Type::Pizzicato },
+        { "col legno", TechniqueText::Type::ColLegno },
+        { "c. legno", TechniqueText::Type::ColLegno },
+        { "col legno battuto", TechniqueText::Type::ColLegnoBattuto },
+        { "col legno batt", TechniqueText::Type::ColLegnoBattuto },
+        { "c. legno battuto", TechniqueText::Type::ColLegnoBattuto },
+        { "c. legno batt", TechniqueText::Type::ColLegnoBattuto },
+        { "col legno tratto", TechniqueText::Type::ColLegnoTratto },
+        { "col legno tratt", TechniqueText::Type::ColLegnoTratto },
+        { "c. legno tratto", TechniqueText::Type::ColLegnoTratto },
+        { "c. legno tratt", TechniqueText::Type::ColLegnoTratto },
+        { "sul pont", TechniqueText::Type::SulPonticello },
+        { "sul ponticello", TechniqueText::Type::SulPonticello },
+        { "s. pont", TechniqueText::Type::SulPonticello },
+        { "sul tasto", TechniqueText::Type::SulTasto },
+        { "s. tasto", TechniqueText::Type::SulTasto },
+        { "flautando", TechniqueText::Type::Flautando },
+        { "flaut", TechniqueText::Type::Flautando },
+        { "ord", TechniqueText::Type::Ordinario },
+        { "ordinario", TechniqueText::Type::Ordinario },
+        { "straight mute", TechniqueText::Type::StraightMute },
+        { "straight", TechniqueText::Type::StraightMute },
+        { "con sordino straight", TechniqueText::Type::StraightMute },
+        { "straight sord", TechniqueText::Type::StraightMute },
+        { "metal mute", TechniqueText::Type::StraightMute },
+        { "wood mute", TechniqueText::Type::StraightMute },
+        { "fiber mute", TechniqueText::Type::StraightMute },
+        { "fibre mute", TechniqueText::Type::StraightMute },
+        { "cup mute", TechniqueText::Type::CupMute },
+        { "cup", TechniqueText::Type::CupMute },
+        { "con sordino cup", TechniqueText::Type::CupMute },
+        { "cup sord", TechniqueText::Type::CupMute },
+        { "harmon mute", TechniqueText::Type::HarmonMute },
+        { "harmon", TechniqueText::Type::HarmonMute },
+        { "wah-wah mute", TechniqueText::Type::HarmonMute },
+        { "wah wah mute", TechniqueText::Type::HarmonMute },
+        { "wah-wah", TechniqueText::Type::HarmonMute },
+        { "wah wah", TechniqueText::Type::HarmonMute },
+        { "plunger mute", TechniqueText::Type::PlungerMute },
+        { "plunger", TechniqueText::Type::PlungerMute },
+        { "bucket mute", TechniqueText::Type::BucketMute },
+        { "bucket", TechniqueText::Type::BucketMute },
+        { "solotone mute", TechniqueText::Type::SolotoneMute },
+        { "solotone", TechniqueText::Type::SolotoneMute },
+        { "stop mute", TechniqueText::Type::StopMute },
+        { "brass mute", TechniqueText::Type::StopMute },
+        { "stopped", TechniqueText::Type::Stopped },
+        { "stop", TechniqueText::Type::Stopped },
+        { "con sord", TechniqueText::Type::Mute },
+        { "mute", TechniqueText::Type::Mute },
+        { "muted", TechniqueText::Type::Mute },
+        { "senza sord", TechniqueText::Type::Open },
+        { "open", TechniqueText::Type::Open }
+    });
+    if (const auto* type = techniquePhrases.find(withoutFinalPeriods(normalizedText))) {
+        return { *type, std::string(text) };
     }
     return {};
 }
@@ -339,15 +340,38 @@ static std::optional<ExpressionClassification> classifyTechnique(std::string_vie
     return result;
 }
 
+enum class TempoPhrase
+{
+    Alteration,
+    Mark
+};
+
+static constexpr auto tempoPhrases = utils::makeConstexprStringMap<TempoPhrase>({
+    { "accel", TempoPhrase::Alteration },
+    { "accelerando", TempoPhrase::Alteration },
+    { "rit", TempoPhrase::Alteration },
+    { "ritardando", TempoPhrase::Alteration },
+    { "rall", TempoPhrase::Alteration },
+    { "rallentando", TempoPhrase::Alteration },
+    { "a tempo", TempoPhrase::Alteration },
+    { "tempo i", TempoPhrase::Alteration },
+    { "tempo iº", TempoPhrase::Alteration },
+    { "tempo primo", TempoPhrase::Alteration },
+    { "meno mosso", TempoPhrase::Alteration },
+    { "piu mosso", TempoPhrase::Alteration },
+    { "largo", TempoPhrase::Mark },
+    { "adagio", TempoPhrase::Mark },
+    { "andante", TempoPhrase::Mark },
+    { "moderato", TempoPhrase::Mark },
+    { "allegro", TempoPhrase::Mark },
+    { "presto", TempoPhrase::Mark },
+    { "vivace", TempoPhrase::Mark }
+});
+
 static bool isTempoAlterationText(std::string_view normalizedText)
 {
-    return matchesAny(normalizedText, {
-        "accel", "accelerando",
-        "rit", "ritardando",
-        "rall", "rallentando",
-        "a tempo", "tempo i", "tempo iº", "tempo primo",
-        "meno mosso", "piu mosso"
-    });
+    const auto* phrase = tempoPhrases.find(withoutFinalPeriods(normalizedText));
+    return phrase && *phrase == TempoPhrase::Alteration;
 }
 
 static bool isTempoMarkText(std::string_view normalizedText)
@@ -355,9 +379,8 @@ static bool isTempoMarkText(std::string_view normalizedText)
     if (normalizedText.find('=') != std::string_view::npos) {
         return true;
     }
-    return matchesAny(normalizedText, {
-        "largo", "adagio", "andante", "moderato", "allegro", "presto", "vivace"
-    });
+    const auto* phrase = tempoPhrases.find(withoutFinalPeriods(normalizedText));
+    return phrase && *phrase == TempoPhrase::Mark;
 }
 
 static bool isAsciiUpperAlphaNumeric(std::string_view text)
@@ -586,7 +609,7 @@ static ResolvedTextExpression resolveTextExpression(
         return result;
     }
     result.text = result.rawTextCtx.getText(true, musx::util::EnigmaString::AccidentalStyle::Unicode);
-    result.normalizedText = normalizeExpressionText(result.text);
+    normalizeExpressionText(result.text, result.normalizedText);
     return result;
 }
 
@@ -803,19 +826,16 @@ static ExpressionClassification classifyResolvedTextExpressionDefinition(const R
     return withEnigmaCtx(classifyGenericText(resolved.text, categoryType), resolved);
 }
 
-static ExpressionClassification classifyAssignedTextExpression(
-    const musx::dom::MusxInstance<musx::dom::others::TextExpressionDef>& def,
-    const musx::dom::MusxInstance<musx::dom::others::MeasureExprAssign>& assignment)
+static ExpressionClassification classifyAssignedTextExpression(const ResolvedTextExpression& resolved, bool usesTopStaff)
 {
-    const ResolvedTextExpression resolved = resolveTextExpression(def, assignment);
     const CategoryType categoryType = resolved.categoryType;
     const std::string_view normalizedText = resolved.normalizedText;
 
     if (const auto classification = classifyResolvedTextExpressionBeforeAssignment(resolved)) {
         return *classification;
     }
-    if (assignmentUsesTopStaff(assignment)) {
-        return withEnigmaCtx(classifySystemTextExpression(def, resolved.text, normalizedText, categoryType), resolved);
+    if (usesTopStaff) {
+        return withEnigmaCtx(classifySystemTextExpression(resolved.expressionDef, resolved.text, normalizedText, categoryType), resolved);
     }
     if (const auto technique = classifyTechnique(resolved.text, normalizedText, categoryType)) {
         return withEnigmaCtx(*technique, resolved);
@@ -823,10 +843,16 @@ static ExpressionClassification classifyAssignedTextExpression(
     return withEnigmaCtx(classifyGenericText(resolved.text, categoryType), resolved);
 }
 
-static ExpressionClassification classifyTextExpressionDefinition(const musx::dom::MusxInstance<musx::dom::others::TextExpressionDef>& def)
+/// How a text expression is used, which together with its definition and resolved text decides its classification.
+enum class TextExpressionUse
 {
-    return classifyResolvedTextExpressionDefinition(resolveTextExpression(def));
-}
+    Definition,
+    StaffAssignment,
+    TopStaffAssignment
+};
+
+using TextExpressionTable = detail::ClassificationCache::Table<
+    std::tuple<musx::dom::Cmper, TextExpressionUse, std::string>, ExpressionClassification>;
 
 static ExpressionClassification classifyShapeExpressionDefinition(const musx::dom::MusxInstance<musx::dom::others::ShapeExpressionDef>& def)
 {
@@ -914,10 +940,24 @@ ExpressionClassification classifyExpression(
     const musx::dom::MusxInstance<musx::dom::others::TextExpressionDef>& def,
     const musx::dom::MusxInstance<musx::dom::others::MeasureExprAssign>& assignment)
 {
-    if (assignment) {
-        return classifyAssignedTextExpression(def, assignment);
+    const ResolvedTextExpression resolved = resolveTextExpression(def, assignment);
+    const TextExpressionUse use = !assignment ? TextExpressionUse::Definition
+        : assignmentUsesTopStaff(assignment) ? TextExpressionUse::TopStaffAssignment
+        : TextExpressionUse::StaffAssignment;
+    const auto classify = [&]() {
+        return use == TextExpressionUse::Definition
+            ? classifyResolvedTextExpressionDefinition(resolved)
+            : classifyAssignedTextExpression(resolved, use == TextExpressionUse::TopStaffAssignment);
+    };
+    if (!def || !resolved.errorMessage.empty()) {
+        return classify();
     }
-    return classifyTextExpressionDefinition(def);
+    auto result = detail::cachedClassification<TextExpressionTable>(
+        def->getDocument(), std::make_tuple(def->getCmper(), use, resolved.text), classify);
+    if (result.enigmaCtx) {
+        result.enigmaCtx = resolved.rawTextCtx; // the text context is always the caller's own assignment
+    }
+    return result;
 }
 
 ExpressionClassification classifyExpression(
@@ -21,6 +21,9 @@
  */
 #include "denigma/classify/general_lines.h"
 
+#include <utility>
+
+#include "classification_cache.h"
 #include "classify.h"
 
 namespace denigma {
@@ -131,6 +134,9 @@ GeneralLine classifyBuiltInLine(
     return result;
 }
 
+/// Custom line classifications keyed by requested part and line style cmper.
+using GeneralLineTable = detail::ClassificationCache::Table<std::pair<musx::dom::Cmper, musx::dom::Cmper>, std::optional<GeneralLine>>;
+
 } // namespace
 
 std::optional<GeneralLine> classifyGeneralLine(
@@ -194,8 +200,11 @@ std::optional<GeneralLine> classifyGeneralLine(
         if (shape->lineStyleId == 0) {
             return std::nullopt;
         }
-        return classifyGeneralLine(shape->getDocument()->getOthers()->get<musx::dom::others::SmartShapeCustomLine>(
-            shape->getRequestedPartId(), shape->lineStyleId));
+        return detail::cachedClassification<GeneralLineTable>(shape->getDocument(),
+            std::make_pair(shape->getRequestedPartId(), shape->lineStyleId), [&]() {
+                return classifyGeneralLine(shape->getDocument()->getOthers()->get<musx::dom::others::SmartShapeCustomLine>(
+                    shape->getRequestedPartId(), shape->lineStyleId));
+            });
     }
     if (const auto spec = builtInLineSpec(shape->shapeType)) {
         return classifyBuiltInLine(shape, *spec);
@@ -24,7 +24,9 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 
+#include "classify/classification_cache.h"
 #include "smufl_mapping.h"
 #include "utils/stringutils.h"
 #include "utils/utf8_iterator.h"
@@ -88,12 +90,8 @@ static Jump classifyJumpTextAndGlyph(std::string_view text, std::optional<std::s
     return Jump::None;
 }
 
-Jump classifyVisualJump(const musx::dom::MusxInstance<musx::dom::others::TextRepeatDef>& def)
+Jump classifyVisualJumpUncached(const musx::dom::MusxInstance<musx::dom::others::TextRepeatDef>& def)
 {
-    if (!def) {
-        return Jump::None;
-    }
-
     const auto repeatText = def->getDocument()->getOthers()->get<musx::dom::others::TextRepeatText>(def->getRequestedPartId(), def->getCmper());
     if (!repeatText) {
         return Jump::None;
@@ -114,6 +112,19 @@ Jump classifyVisualJump(const musx::dom::MusxInstance<musx::dom::others::TextRep
     return classifyJumpTextAndGlyph(repeatText->text, glyphNameView);
 }
 
+/// Visual jump classifications keyed by requested part and text repeat cmper.
+using VisualJumpTable = detail::ClassificationCache::Table<std::pair<musx::dom::Cmper, musx::dom::Cmper>, Jump>;
+
+Jump classifyVisualJump(const musx::dom::MusxInstance<musx::dom::others::TextRepeatDef>& def)
+{
+    if (!def) {
+        return Jump::None;
+    }
+    return detail::cachedClassification<VisualJumpTable>(def->getDocument(),
+        std::make_pair(def->getRequestedPartId(), def->getCmper()),
+        [&]() { return classifyVisualJumpUncached(def); });
+}
+
 bool isJumpCommand(Jump jump)
 {
     switch (jump) {
@@ -22,9 +22,11 @@
 #include "denigma/classify/noteheads.h"
 
 #include <string_view>
-#include <unordered_map>
+#include <utility>
 
+#include "classify/classification_cache.h"
 #include "smufl_mapping.h"
+#include "utils/constexpr_string_map.h"
 
 namespace denigma::classify {
 
@@ -43,7 +45,7 @@ NoteheadClassification makeNotehead(Shape shape, Fill fill, std::optional<std::s
 
 NoteheadClassification classifyGlyphName(std::string glyphName)
 {
-    static const std::unordered_map<std::string_view, std::pair<Shape, Fill>> glyphTable = {
+    static constexpr auto glyphTable = utils::makeConstexprStringMap<std::pair<Shape, Fill>>({
         // Null
         { "noteheadNull", { Shape::Null, Fill::Unspecified } },
 
@@ -99,11 +101,11 @@ NoteheadClassification classifyGlyphName(std::string glyphName)
         { "noteheadCircledWholeLarge", { Shape::Circled, Fill::Unfilled } },
         { "noteheadCircledDoubleWhole", { Shape::Circled, Fill::Unfilled } },
         { "noteheadCircledDoubleWholeLarge", { Shape::Circled, Fill::Unfilled } },
-    };
+    });
 
     const std::string_view glyph = glyphName;
-    if (const auto it = glyphTable.find(glyph); it != glyphTable.end()) {
-        return makeNotehead(it->second.first, it->second.second, std::move(glyphName));
+    if (const auto* shapeAndFill = glyphTable.find(glyph)) {
+        return makeNotehead(shapeAndFill->first, shapeAndFill->second, std::move(glyphName));
     }
     // A real SMuFL notehead-family glyph was resolved, just not one of the specifically recognized
     // shapes above (e.g. a shape-note, cluster, or arrow notehead). This is a known alternate
@@ -128,25 +130,40 @@ NoteheadClassification classifyAsciiX(
     return {};
 }
 
-} // namespace
-
-NoteheadClassification classifyNoteheadSymbol(
+NoteheadClassification classifyNoteheadSymbolUncached(
     const musx::dom::MusxInstance<musx::dom::FontInfo>& fontInfo, char32_t symbol)
 {
-    NoteheadClassification result;
     if (symbol == U' ') {
-        result = makeNotehead(Shape::Null, Fill::Unspecified, std::nullopt);
-    } else if (auto asciiClassification = classifyAsciiX(fontInfo, symbol)) {
-        result = std::move(asciiClassification);
-    } else if (fontInfo) {
+        return makeNotehead(Shape::Null, Fill::Unspecified, std::nullopt);
+    }
+    if (auto asciiClassification = classifyAsciiX(fontInfo, symbol)) {
+        return asciiClassification;
+    }
+    if (fontInfo) {
         if (const auto* glyphName = smufl_mapping::getGlyphNameForFont(
                 fontInfo->getName(),
                 symbol,
                 fontInfo->calcIsSMuFL(),
                 smufl_mapping::SmuflGlyphSource::Finale)) {
-            result = classifyGlyphName(std::string(*glyphName));
+            return classifyGlyphName(std::string(*glyphName));
         }
     }
+    return {};
+}
+
+/// Notehead classifications, without their noteheadInfo, keyed by font id and symbol. A score uses only a handful
+/// of pairs, so glyph-name resolution runs once for each rather than once per note.
+using NoteheadSymbolTable = detail::ClassificationCache::Table<std::pair<musx::dom::Cmper, char32_t>, NoteheadClassification>;
+
+} // namespace
+
+NoteheadClassification classifyNoteheadSymbol(
+    const musx::dom::MusxInstance<musx::dom::FontInfo>& fontInfo, char32_t symbol)
+{
+    auto result = fontInfo
+        ? detail::cachedClassification<NoteheadSymbolTable>(fontInfo->getDocument(), std::make_pair(fontInfo->fontId, symbol),
+            [&]() { return classifyNoteheadSymbolUncached(fontInfo, symbol); })
+        : classifyNoteheadSymbolUncached(fontInfo, symbol);
     result.noteheadInfo.font = fontInfo;
     result.noteheadInfo.character = symbol;
     return result;
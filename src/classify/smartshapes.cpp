@@ -24,8 +24,11 @@
 #include <cstdlib>
 #include <stdexcept>
 #include <string_view>
+#include <utility>
+#include <variant>
 #include <vector>
 
+#include "classification_cache.h"
 #include "classify.h"
 #include "denigma/classify/octaves.h"
 #include "utils/utf8_iterator.h"
@@ -176,6 +179,54 @@ std::vector<musx::dom::MusxInstance<musx::dom::others::SmartShape>> collectHidde
     return result;
 }
 
+/// The octave markings in a custom line's left texts.
+struct CustomLineOctaveMarkings
+{
+    std::optional<OctaveMarkingClassification> start;       ///< The marking of the start text.
+    std::optional<OctaveMarkingClassification> combined;    ///< The marking the start and continuation texts agree on.
+};
+/// Custom line octave markings keyed by requested part and line style cmper.
+using CustomLineOctaveMarkingTable = detail::ClassificationCache::Table<std::pair<musx::dom::Cmper, musx::dom::Cmper>, CustomLineOctaveMarkings>;
+
+/// Classifies the left texts of the custom line used by @p shape. Every shape on the line shares
+/// the result, so its text is parsed once per document.
+CustomLineOctaveMarkings classifyCustomLineOctaveMarkings(
+    const musx::dom::MusxInstance<musx::dom::others::SmartShape>& shape)
+{
+    using Direction = octave::Direction;
+    const auto partId = shape->getRequestedPartId();
+    return detail::cachedClassification<CustomLineOctaveMarkingTable>(shape->getDocument(),
+        std::make_pair(partId, shape->lineStyleId),
+        [&]() -> CustomLineOctaveMarkings {
+            const auto customLine = shape->getDocument()->getOthers()->get<musx::dom::others::SmartShapeCustomLine>(
+                partId, shape->lineStyleId);
+            if (!customLine) {
+                return {};
+            }
+            CustomLineOctaveMarkings result;
+            result.start = classifyOctaveMarking(customLine->getLeftStartRawTextCtx(partId));
+            if (!result.start) {
+                return result;
+            }
+            auto marking = *result.start;
+            if (const auto continuationText = customLine->getLeftContRawTextCtx(partId)) {
+                const auto contMarking = classifyOctaveMarking(continuationText);
+                if (!contMarking || contMarking->magnitude != marking.magnitude) {
+                    return result;
+                }
+                if (marking.direction == Direction::Unknown) {
+                    marking.direction = contMarking->direction;
+                    marking.directionIsExplicit = contMarking->directionIsExplicit;
+                } else if (contMarking->direction != Direction::Unknown
+                    && contMarking->direction != marking.direction) {
+                    return result;
+                }
+            }
+            result.combined = marking;
+            return result;
+        });
+}
+
 /// Classifies a custom line as a visual ottava. Direction-ambiguous markings are
 /// resolved by pairing with a hidden built-in ottava, then by vertical placement
 /// (engravers place alta lines above the staff and bassa lines below); when neither
@@ -186,23 +237,10 @@ std::optional<Ottava> classifyOttavaLine(
 {
     using Direction = octave::Direction;
 
-    auto marking = classifyOctaveMarking(line.startText);
+    const auto marking = classifyCustomLineOctaveMarkings(shape).combined;
     if (!marking) {
         return std::nullopt;
     }
-    if (line.continuationText) {
-        const auto contMarking = classifyOctaveMarking(line.continuationText);
-        if (!contMarking || contMarking->magnitude != marking->magnitude) {
-            return std::nullopt;
-        }
-        if (marking->direction == Direction::Unknown) {
-            marking->direction = contMarking->direction;
-            marking->directionIsExplicit = contMarking->directionIsExplicit;
-        } else if (contMarking->direction != Direction::Unknown
-            && contMarking->direction != marking->direction) {
-            return std::nullopt;
-        }
-    }
 
     const auto placement = shape->calcVerticalPlacementForBeatAttached();
     auto direction = marking->direction;
@@ -283,13 +321,7 @@ bool calcHasVisualOttavaProxy(
         if (candidate->startTermSeg->endPoint->staffId != staffId || !candidate->calcIsValid()) {
             continue;
         }
-        const auto customLine = candidate->getDocument()->getOthers()->get<musx::dom::others::SmartShapeCustomLine>(
-            candidate->getRequestedPartId(), candidate->lineStyleId);
-        if (!customLine) {
-            continue;
-        }
-        const auto marking = classifyOctaveMarking(
-            customLine->getLeftStartRawTextCtx(candidate->getRequestedPartId()));
+        const auto marking = classifyCustomLineOctaveMarkings(candidate).start;
         if (!marking || marking->magnitude != std::abs(octaveShift)) {
             continue;
         }
@@ -425,6 +457,28 @@ std::optional<KeyboardPedal> classifyKeyboardPedalCustomLine(
     return result;
 }
 
+/// What a custom line's own definition classifies as, before anything about the shape using it is considered.
+using CustomLineClassification = std::variant<std::monostate, KeyboardPedal, GeneralLine>;
+/// Custom line classifications keyed by requested part and line style cmper.
+using CustomLineTable = detail::ClassificationCache::Table<std::pair<musx::dom::Cmper, musx::dom::Cmper>, CustomLineClassification>;
+
+static CustomLineClassification classifyCustomLine(const musx::dom::MusxInstance<musx::dom::others::SmartShape>& shape)
+{
+    return detail::cachedClassification<CustomLineTable>(shape->getDocument(),
+        std::make_pair(shape->getRequestedPartId(), shape->lineStyleId),
+        [&]() -> CustomLineClassification {
+            const auto customLine = shape->getDocument()->getOthers()->get<musx::dom::others::SmartShapeCustomLine>(
+                shape->getRequestedPartId(), shape->lineStyleId);
+            if (auto keyboardPedal = classifyKeyboardPedalCustomLine(customLine)) {
+                return std::move(*keyboardPedal);
+            }
+            if (auto generalLine = classifyGeneralLine(customLine)) {
+                return std::move(*generalLine);
+            }
+            return {};
+        });
+}
+
 SmartShapeClassification classifySmartShape(
     const musx::dom::MusxInstance<musx::dom::others::SmartShape>& shape)
 {
@@ -458,11 +512,10 @@ SmartShapeClassification classifySmartShape(
         if (const auto candidate = musx::util::calcNonArpeggioSpanForSmartShape(shape)) {
             result.value = NonArpeggio{ *candidate };
         } else if (shape->lineStyleId != 0 && !shape->entryBased) {
-            const auto customLine = shape->getDocument()->getOthers()->get<musx::dom::others::SmartShapeCustomLine>(
-                shape->getRequestedPartId(), shape->lineStyleId);
-            if (auto keyboardPedal = classifyKeyboardPedalCustomLine(customLine)) {
+            auto customLine = classifyCustomLine(shape);
+            if (auto* keyboardPedal = std::get_if<KeyboardPedal>(&customLine)) {
                 result.value = std::move(*keyboardPedal);
-            } else if (auto generalLine = classifyGeneralLine(customLine)) {
+            } else if (auto* generalLine = std::get_if<GeneralLine>(&customLine)) {
                 if (auto ottava = classifyOttavaLine(shape, *generalLine)) {
                     result.value = std::move(*ottava);
                 } else if (auto trillLine = classifyTrillLine(*generalLine)) {
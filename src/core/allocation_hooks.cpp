@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Replaces the global operator new and delete with versions that count bytes per thread (see allocation_stats.h).
+// Built into the executables only when DENIGMA_ALLOCATION_STATS is on: a library must not replace them for its host.
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "core/allocation_stats.h"
+
+namespace {
+
+/// Each block is preceded by its size, padded to keep the block aligned for any fundamental type.
+constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+void* countedAllocate(std::size_t size) noexcept
+{
+    void* block = std::malloc(HEADER_SIZE + size);
+    if (!block) {
+        return nullptr;
+    }
+    *static_cast<std::size_t*>(block) = size;
+    denigma::allocation_stats::recordAllocation(size);
+    return static_cast<char*>(block) + HEADER_SIZE;
+}
+
+void* countedAllocateOrThrow(std::size_t size)
+{
+    while (true) {
+        if (void* result = countedAllocate(size)) {
+            return result;
+        }
+        const auto handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void countedFree(void* pointer) noexcept
+{
+    if (!pointer) {
+        return;
+    }
+    void* block = static_cast<char*>(pointer) - HEADER_SIZE;
+    denigma::allocation_stats::recordDeallocation(*static_cast<std::size_t*>(block));
+    std::free(block);
+}
+
+const bool g_installed = [] {
+    denigma::allocation_stats::g_hooksInstalled.store(true, std::memory_order_relaxed);
+    return true;
+}();
+
+} // namespace
+
+void* operator new(std::size_t size) { return countedAllocateOrThrow(size); }
+void* operator new[](std::size_t size) { return countedAllocateOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+
+void operator delete(void* pointer) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { countedFree(pointer); }
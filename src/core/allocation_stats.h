@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace denigma::allocation_stats {
+
+/// @brief The heap use of one thread, kept by the counting operator new.
+///
+/// Memory freed on another thread than the one that allocated it is subtracted there, so one thread's #liveBytes
+/// can go negative.
+struct ThreadCounters
+{
+    std::uint64_t allocatedBytes{};  ///< bytes this thread has allocated
+    std::int64_t liveBytes{};        ///< bytes this thread has allocated less those it has freed
+    std::int64_t peakLiveBytes{};    ///< the highest #liveBytes since the last time it was reset
+};
+
+inline thread_local ThreadCounters t_counters;
+
+/// Set while the counting operator new of allocation_hooks.cpp is linked in (the DENIGMA_ALLOCATION_STATS build).
+inline std::atomic<bool> g_hooksInstalled{ false };
+
+/// Returns true when allocations are being counted.
+inline bool hooksInstalled() noexcept
+{
+    return g_hooksInstalled.load(std::memory_order_relaxed);
+}
+
+inline void recordAllocation(std::size_t bytes) noexcept
+{
+    auto& counters = t_counters;
+    counters.allocatedBytes += bytes;
+    counters.liveBytes += static_cast<std::int64_t>(bytes);
+    if (counters.liveBytes > counters.peakLiveBytes) {
+        counters.peakLiveBytes = counters.liveBytes;
+    }
+}
+
+inline void recordDeallocation(std::size_t bytes) noexcept
+{
+    t_counters.liveBytes -= static_cast<std::int64_t>(bytes);
+}
+
+} // namespace denigma::allocation_stats
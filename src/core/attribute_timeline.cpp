@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "core/attribute_timeline.h"
+
+#include <optional>
+
+namespace denigma {
+
+AttributeTimeline::AttributeTimeline(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId,
+    const musx::dom::MusxInstanceList<musx::dom::others::Measure>& measures, const std::vector<musx::dom::StaffCmper>& staves)
+{
+    using namespace musx::dom;
+
+    m_staves.reserve(staves.size());
+    for (const auto staffId : staves) {
+        auto& changes = m_staves.emplace_back();
+        const auto markAll = [&](MeasCmper measureId) {
+            if (measureId > 0) {
+                for (auto& measureIds : changes) {
+                    measureIds.insert(measureId);
+                }
+            }
+        };
+        if (!document || measures.empty()) {
+            continue;
+        }
+        markAll(measures.front()->getCmper());
+
+        if (const auto rawStaff = document->getOthers()->get<others::Staff>(partId, staffId); rawStaff && rawStaff->hasStyles) {
+            for (const auto& styleAssign : document->getOthers()->getArray<others::StaffStyleAssign>(partId, staffId)) {
+                // a boundary inside a measure shows at the start of the next one
+                markAll(styleAssign->startMeas);
+                if (styleAssign->startEdu > 0) {
+                    markAll(styleAssign->startMeas + 1);
+                }
+                if (const auto nextLocation = styleAssign->nextLocation(staffId)) {
+                    markAll(nextLocation->measureId);
+                    if (nextLocation->position != musx::util::Fraction{}) {
+                        markAll(nextLocation->measureId + 1);
+                    }
+                }
+            }
+        }
+
+        const auto musxDetails = document->getDetails();
+        MusxInstance<KeySignature> prevKey;
+        MusxInstance<TimeSignature> prevTime;
+        std::optional<ClefIndex> prevFrameClef;
+        bool prevHadClefList = false;
+        for (const auto& measure : measures) {
+            const MeasCmper measureId = measure->getCmper();
+            auto key = measure->createKeySignature(staffId);
+            if (!prevKey || !key->isSame(*prevKey.get())) {
+                changes[static_cast<std::size_t>(Attribute::Key)].insert(measureId);
+            }
+            prevKey = std::move(key);
+            auto time = measure->createDisplayTimeSignature(staffId);
+            if (!prevTime || !time->isSame(*prevTime.get())) {
+                changes[static_cast<std::size_t>(Attribute::Time)].insert(measureId);
+            }
+            prevTime = std::move(time);
+            if (const auto frameHold = musxDetails->get<details::GFrameHold>(partId, staffId, measureId)) {
+                // a clef list always counts, and so does the measure after one, whose start clef is its last clef
+                const bool hasClefList = frameHold->clefListId != 0;
+                if (hasClefList || prevHadClefList || frameHold->clefId != prevFrameClef) {
+                    changes[static_cast<std::size_t>(Attribute::Clef)].insert(measureId);
+                }
+                prevFrameClef = frameHold->clefId;
+                prevHadClefList = hasClefList;
+            }
+        }
+    }
+}
+
+} // namespace denigma
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "utils/dense_index_set.h"
+#include "musx/musx.h"
+
+namespace denigma {
+
+/**
+ * @class AttributeTimeline
+ * @brief The measures where the key, time signature or clef of each staff of a part may change.
+ *
+ * The attribute passes run once per measure and staff, and deriving the converter's key, time and clef data
+ * only to find it equal to the previous measure's was most of their cost. The timeline compares the raw musx
+ * signatures and frame clefs once per staff, so a measure that is not a change point needs no further work.
+ * Staff-style boundaries are marked for every attribute, since a style can transpose a staff, hide its time
+ * signatures or change its clef. A marked measure may still turn out unchanged; an unmarked one never changes.
+ * The document must not be edited while the timeline is in use.
+ */
+class AttributeTimeline
+{
+public:
+    enum class Attribute
+    {
+        Key,
+        Time,
+        Clef
+    };
+
+    /// Finds the change points of staves over measures, which must be in order. The first measure is always one.
+    AttributeTimeline(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId,
+        const musx::dom::MusxInstanceList<musx::dom::others::Measure>& measures, const std::vector<musx::dom::StaffCmper>& staves);
+
+    /// Returns true if attribute may change at the start of or within measureId on staves[staffIndex].
+    bool changesAt(Attribute attribute, std::size_t staffIndex, musx::dom::MeasCmper measureId) const
+    {
+        return staffIndex < m_staves.size() && m_staves[staffIndex][static_cast<std::size_t>(attribute)].contains(measureId);
+    }
+
+    /// Returns true if attribute may change at measureId on any staff.
+    bool changesAtAnyStaff(Attribute attribute, musx::dom::MeasCmper measureId) const
+    {
+        for (std::size_t staffIndex = 0; staffIndex < m_staves.size(); ++staffIndex) {
+            if (changesAt(attribute, staffIndex, measureId)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    using ChangeSets = std::array<utils::DenseIndexSet<musx::dom::MeasCmper>, 3>;
+
+    std::vector<ChangeSets> m_staves;
+};
+
+} // namespace denigma
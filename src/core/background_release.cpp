@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/background_release.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "core/denigma.h"
+
+namespace denigma {
+
+namespace {
+
+#if !defined(DENIGMA_SINGLE_THREADED)
+
+class Releaser
+{
+public:
+    /// Objects waiting to be destroyed; past this the caller destroys its own.
+    static constexpr std::size_t MAX_PENDING = 4;
+
+    ~Releaser()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        // the jthread joins once the pending objects are gone
+    }
+
+    /// Queues object for the releaser thread, starting it on first use. Returns false, leaving object with the
+    /// caller, if too many are already pending.
+    bool push(std::shared_ptr<void>& object)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_pending.size() >= MAX_PENDING) {
+                return false;
+            }
+            if (!m_thread.joinable()) {
+                m_thread = std::jthread([this]() { run(); });
+            }
+            m_pending.push_back(std::move(object));
+        }
+        m_wake.notify_one();
+        return true;
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_wake.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+            if (m_pending.empty()) {
+                return;
+            }
+            auto object = std::move(m_pending.front());
+            m_pending.pop_front();
+            lock.unlock();
+            object.reset();
+            lock.lock();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::shared_ptr<void>> m_pending;
+    bool m_stopping{};
+    std::jthread m_thread; ///< last, so that it is joined before the queue goes
+};
+
+Releaser& releaser()
+{
+    static Releaser instance;
+    return instance;
+}
+
+#endif
+
+} // namespace
+
+void releaseInBackground(const DenigmaContext& denigmaContext, std::shared_ptr<void> object)
+{
+    if (!object) {
+        return;
+    }
+    if (denigmaContext.executor) {
+        denigmaContext.executor->submit([object = std::move(object)]() mutable { object.reset(); });
+        return;
+    }
+#if !defined(DENIGMA_SINGLE_THREADED)
+    if (releaser().push(object)) {
+        return;
+    }
+#endif
+    object.reset();
+}
+
+} // namespace denigma
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <memory>
+
+namespace denigma {
+
+struct DenigmaContext;
+
+/// @brief Destroys object off the calling thread, so that the caller moves on while a large finished tree is freed.
+///
+/// The object is released as a task on denigmaContext.executor when it is set, and otherwise on one process-wide
+/// releaser thread. When the releaser already has a few objects pending, or in a DENIGMA_SINGLE_THREADED build,
+/// it is destroyed at once, so a fast producer never piles up more freed-but-not-yet-released trees than that.
+/// Objects still pending at exit are destroyed before the releaser thread is joined.
+void releaseInBackground(const DenigmaContext& denigmaContext, std::shared_ptr<void> object);
+
+} // namespace denigma
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/batch_manifest.h"
+
+#include <array>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#include "utils/stringutils.h"
+
+namespace denigma {
+
+namespace {
+
+constexpr char MANIFEST_HEADER[] = "# denigma batch manifest 1";
+constexpr char FIELD_SEPARATOR = '\t';
+constexpr std::uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+std::int64_t lastWriteTicks(const std::filesystem::path& path, std::error_code& ec)
+{
+    return static_cast<std::int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+}
+
+} // namespace
+
+BatchManifest::BatchManifest(std::filesystem::path manifestPath)
+    : m_path(std::move(manifestPath))
+{
+    std::ifstream manifestFile(m_path, std::ios::binary);
+    std::string line;
+    if (!manifestFile || !std::getline(manifestFile, line) || line != MANIFEST_HEADER) {
+        return; // a missing or foreign file starts a fresh manifest
+    }
+    while (std::getline(manifestFile, line)) {
+        std::vector<std::string> fields;
+        std::istringstream lineStream(line);
+        for (std::string field; std::getline(lineStream, field, FIELD_SEPARATOR); ) {
+            fields.push_back(std::move(field));
+        }
+        if (fields.size() < 6) {
+            continue;
+        }
+        try {
+            Entry entry;
+            entry.size = std::stoull(fields[1]);
+            entry.modified = std::stoll(fields[2]);
+            entry.contentHash = std::stoull(fields[3], nullptr, 16);
+            entry.optionsHash = std::stoull(fields[4], nullptr, 16);
+            entry.version = fields[5];
+            for (std::size_t x = 6; x < fields.size(); x++) {
+                entry.outputs.push_back(utils::utf8ToPath(fields[x]));
+            }
+            m_entries.insert_or_assign(fields[0], std::move(entry));
+        } catch (const std::logic_error&) {
+            // stoull/stoll reject a damaged line; drop it so that the input is simply converted again
+        }
+    }
+}
+
+bool BatchManifest::isUpToDate(const std::filesystem::path& inputPath, std::uint64_t optionsHash)
+{
+    const auto key = keyFor(inputPath);
+    Entry recorded;
+    {
+        std::lock_guard lock(m_mutex);
+        const auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            return false;
+        }
+        recorded = it->second;
+    }
+    if (recorded.optionsHash != optionsHash || recorded.version != DENIGMA_VERSION) {
+        return false;
+    }
+    for (const auto& output : recorded.outputs) {
+        std::error_code ec;
+        if (!std::filesystem::exists(output, ec)) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(inputPath, ec);
+    if (ec || size != recorded.size) {
+        return false;
+    }
+    const auto modified = lastWriteTicks(inputPath, ec);
+    if (ec) {
+        return false;
+    }
+    if (modified == recorded.modified) {
+        return true;
+    }
+    // touched but maybe not changed: the content decides, and a match refreshes the time so the next run is cheap
+    if (hashFile(inputPath) != recorded.contentHash) {
+        return false;
+    }
+    std::lock_guard lock(m_mutex);
+    if (const auto it = m_entries.find(key); it != m_entries.end()) {
+        it->second.modified = modified;
+    }
+    return true;
+}
+
+void BatchManifest::record(const std::filesystem::path& inputPath, std::uint64_t optionsHash, std::vector<std::filesystem::path> outputs)
+{
+    Entry entry;
+    std::error_code ec;
+    entry.size = std::filesystem::file_size(inputPath, ec);
+    entry.modified = lastWriteTicks(inputPath, ec);
+    if (ec) {
+        return; // without a size and time the entry could never match, so there is nothing worth recording
+    }
+    entry.contentHash = hashFile(inputPath);
+    entry.optionsHash = optionsHash;
+    entry.version = DENIGMA_VERSION;
+    for (auto& output : outputs) {
+        entry.outputs.push_back(std::filesystem::absolute(output, ec).lexically_normal());
+    }
+    const auto key = keyFor(inputPath);
+    std::lock_guard lock(m_mutex);
+    m_entries.insert_or_assign(key, std::move(entry));
+}
+
+void BatchManifest::save() const
+{
+    std::filesystem::path tempPath = m_path;
+    tempPath += ".tmp";
+    {
+        std::ofstream manifestFile;
+        manifestFile.exceptions(std::ios::failbit | std::ios::badbit);
+        manifestFile.open(tempPath, std::ios::binary | std::ios::trunc);
+        manifestFile << MANIFEST_HEADER << '\n';
+        std::lock_guard lock(m_mutex);
+        for (const auto& [key, entry] : m_entries) {
+            manifestFile << key << FIELD_SEPARATOR << entry.size << FIELD_SEPARATOR << entry.modified
+                << FIELD_SEPARATOR << std::hex << entry.contentHash << FIELD_SEPARATOR << entry.optionsHash << std::dec
+                << FIELD_SEPARATOR << entry.version;
+            for (const auto& output : entry.outputs) {
+                manifestFile << FIELD_SEPARATOR << utils::pathToString(output);
+            }
+            manifestFile << '\n';
+        }
+    }
+    std::filesystem::rename(tempPath, m_path);
+}
+
+std::uint64_t BatchManifest::hashText(std::string_view text, std::uint64_t hash)
+{
+    for (const char c : text) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+std::string BatchManifest::keyFor(const std::filesystem::path& inputPath)
+{
+    std::error_code ec;
+    return utils::pathToString(std::filesystem::absolute(inputPath, ec).lexically_normal());
+}
+
+std::uint64_t BatchManifest::hashFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::array<char, 1 << 16> chunk{};
+    std::uint64_t hash = FNV_OFFSET_BASIS;
+    while (file.read(chunk.data(), chunk.size()) || file.gcount() > 0) {
+        hash = hashText(std::string_view(chunk.data(), static_cast<std::size_t>(file.gcount())), hash);
+    }
+    return hash;
+}
+
+} // namespace denigma
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace denigma {
+
+/**
+ * @class BatchManifest
+ * @brief Remembers what produced each input's outputs, so that an incremental batch run can skip unchanged inputs.
+ *
+ * An input is up to date when its content, the output options and the denigma version all match the last recorded
+ * conversion and every output that conversion wrote still exists. Content is compared by size and modification time
+ * first, and by a content hash only when the time differs. Methods may be called from several batch workers at once.
+ */
+class BatchManifest
+{
+public:
+    /// Loads the manifest at manifestPath if it exists. Lines that cannot be parsed are dropped.
+    explicit BatchManifest(std::filesystem::path manifestPath);
+
+    /// Returns true if inputPath was last converted with optionsHash by this denigma version and is unchanged.
+    bool isUpToDate(const std::filesystem::path& inputPath, std::uint64_t optionsHash);
+    /// Records a successful conversion of inputPath that wrote outputs.
+    void record(const std::filesystem::path& inputPath, std::uint64_t optionsHash, std::vector<std::filesystem::path> outputs);
+    /// Writes the manifest back to its path, replacing the previous file in one step.
+    void save() const;
+
+    /// 64-bit FNV-1a hash of text, for fingerprinting option sets.
+    static std::uint64_t hashText(std::string_view text, std::uint64_t hash = FNV_OFFSET_BASIS);
+    /// 64-bit FNV-1a hash of the contents of the file at path. A file that cannot be read hashes as an empty one.
+    static std::uint64_t hashFile(const std::filesystem::path& path);
+
+private:
+    struct Entry
+    {
+        std::uintmax_t size{};
+        std::int64_t modified{};        ///< last write time, in file clock ticks
+        std::uint64_t contentHash{};
+        std::uint64_t optionsHash{};
+        std::string version;
+        std::vector<std::filesystem::path> outputs;
+    };
+
+    static constexpr std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+    static std::string keyFor(const std::filesystem::path& inputPath);
+
+    std::filesystem::path m_path;
+    mutable std::mutex m_mutex;
+    std::map<std::string, Entry> m_entries;
+};
+
+} // namespace denigma
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/buffer_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace denigma {
+
+template <typename BufferType>
+BufferPool<BufferType>& BufferPool<BufferType>::forThisThread()
+{
+    thread_local BufferPool pool;
+    return pool;
+}
+
+template <typename BufferType>
+BufferType BufferPool<BufferType>::acquire(std::size_t capacity)
+{
+    if (capacity >= MIN_POOLED_BYTES) {
+        const auto it = std::find_if(m_buffers.begin(), m_buffers.end(),
+            [capacity](const BufferType& buffer) { return buffer.capacity() >= capacity; });
+        if (it != m_buffers.end()) {
+            BufferType result = std::move(*it);
+            m_retainedBytes -= result.capacity();
+            m_buffers.erase(it);
+            return result;
+        }
+    }
+    BufferType result;
+    result.reserve(capacity);
+    return result;
+}
+
+template <typename BufferType>
+void BufferPool<BufferType>::recycle(BufferType&& buffer)
+{
+    const std::size_t capacity = buffer.capacity();
+    if (capacity < MIN_POOLED_BYTES || capacity > MAX_RETAINED_BYTES) {
+        return;
+    }
+    BufferType kept = std::move(buffer);
+    kept.clear();
+    const auto position = std::find_if(m_buffers.begin(), m_buffers.end(),
+        [capacity](const BufferType& pooled) { return pooled.capacity() > capacity; });
+    m_buffers.insert(position, std::move(kept));
+    m_retainedBytes += capacity;
+    while (m_buffers.size() > MAX_POOLED_BUFFERS || m_retainedBytes > MAX_RETAINED_BYTES) {
+        m_retainedBytes -= m_buffers.front().capacity();
+        m_buffers.erase(m_buffers.begin());
+    }
+}
+
+template <typename BufferType>
+void BufferPool<BufferType>::clear()
+{
+    m_buffers.clear();
+    m_retainedBytes = 0;
+}
+
+template class BufferPool<std::vector<char>>;
+template class BufferPool<std::string>;
+
+} // namespace denigma
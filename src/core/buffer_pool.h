@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace denigma {
+
+/**
+ * @class BufferPool
+ * @brief Keeps the large buffers a thread frees, so that the next input it converts reuses their capacity.
+ *
+ * A batch worker converts one file after another, and each file allocates input, inflate and output buffers of
+ * several megabytes. Allocations that large come straight from mmap and go back with munmap, so every file pays for
+ * fresh page faults. Each thread has a pool of its own (#forThisThread), so no locking is needed; a buffer recycled
+ * on another thread joins that thread's pool instead. Buffers under #MIN_POOLED_BYTES are not worth keeping, and a
+ * pool holds at most #MAX_POOLED_BUFFERS buffers and #MAX_RETAINED_BYTES of capacity, dropping its smallest first.
+ */
+template <typename BufferType>
+class BufferPool
+{
+public:
+    static constexpr std::size_t MIN_POOLED_BYTES = 64 * 1024;
+    static constexpr std::size_t MAX_POOLED_BUFFERS = 4;
+    static constexpr std::size_t MAX_RETAINED_BYTES = 128 * 1024 * 1024;
+
+    /// The calling thread's pool.
+    static BufferPool& forThisThread();
+
+    /// Returns an empty buffer with room for at least capacity elements, reusing the smallest pooled one that fits.
+    BufferType acquire(std::size_t capacity);
+
+    /// Takes back the capacity of buffer for a later #acquire.
+    void recycle(BufferType&& buffer);
+
+    /// The total capacity of the pooled buffers.
+    std::size_t retainedBytes() const noexcept { return m_retainedBytes; }
+
+    /// The number of pooled buffers.
+    std::size_t size() const noexcept { return m_buffers.size(); }
+
+    /// Frees every pooled buffer.
+    void clear();
+
+private:
+    std::vector<BufferType> m_buffers;  ///< ordered by capacity, smallest first
+    std::size_t m_retainedBytes{};
+};
+
+extern template class BufferPool<std::vector<char>>;
+extern template class BufferPool<std::string>;
+
+/// Returns an empty byte buffer with at least capacity bytes reserved, from the calling thread's pool when it can.
+inline std::vector<char> acquireByteBuffer(std::size_t capacity)
+{ return BufferPool<std::vector<char>>::forThisThread().acquire(capacity); }
+
+/// Returns buffer's capacity to the calling thread's pool.
+inline void recycleByteBuffer(std::vector<char>&& buffer)
+{ BufferPool<std::vector<char>>::forThisThread().recycle(std::move(buffer)); }
+
+/// Returns an empty string with at least capacity bytes reserved, from the calling thread's pool when it can.
+inline std::string acquireStringBuffer(std::size_t capacity)
+{ return BufferPool<std::string>::forThisThread().acquire(capacity); }
+
+/// Returns buffer's capacity to the calling thread's pool.
+inline void recycleStringBuffer(std::string&& buffer)
+{ BufferPool<std::string>::forThisThread().recycle(std::move(buffer)); }
+
+} // namespace denigma
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/conversion_arena.h"
+
+#include <algorithm>
+
+namespace denigma {
+
+const std::shared_ptr<ArenaBlockCache>& ArenaBlockCache::forThisThread()
+{
+    thread_local const std::shared_ptr<ArenaBlockCache> cache = std::make_shared<ArenaBlockCache>();
+    return cache;
+}
+
+std::size_t ArenaBlockCache::retainedBytes() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_retainedBytes;
+}
+
+void ArenaBlockCache::release()
+{
+    std::vector<Block> blocks;
+    {
+        std::lock_guard lock(m_mutex);
+        blocks.swap(m_blocks);
+        m_retainedBytes = 0;
+    }
+    for (const auto& block : blocks) {
+        std::pmr::get_default_resource()->deallocate(block.pointer, block.bytes, block.alignment);
+    }
+}
+
+void* ArenaBlockCache::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        const auto it = std::find_if(m_blocks.begin(), m_blocks.end(), [&](const Block& block) {
+            return block.bytes == bytes && block.alignment == alignment;
+        });
+        if (it != m_blocks.end()) {
+            void* result = it->pointer;
+            m_retainedBytes -= it->bytes;
+            m_blocks.erase(it);
+            return result;
+        }
+    }
+    return std::pmr::get_default_resource()->allocate(bytes, alignment);
+}
+
+void ArenaBlockCache::do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_retainedBytes + bytes <= MAX_RETAINED_BYTES) {
+            m_blocks.push_back({ ptr, bytes, alignment });
+            m_retainedBytes += bytes;
+            return;
+        }
+    }
+    std::pmr::get_default_resource()->deallocate(ptr, bytes, alignment);
+}
+
+} // namespace denigma
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "core/denigma.h"
+
+namespace denigma {
+
+/**
+ * @class ArenaHighWater
+ * @brief Tracks how many bytes all arenas of one conversion hold from their upstream, and the most they held at once.
+ *
+ * A conversion may run several arenas at a time (one per output or measure range being built), so the counters
+ * are atomic. DenigmaContext::arenaHighWater points to the tracker; copies of the context share it.
+ */
+class ArenaHighWater
+{
+public:
+    void add(std::size_t bytes) noexcept
+    {
+        const std::size_t live = m_liveBytes.fetch_add(bytes) + bytes;
+        std::size_t peak = m_peakBytes.load();
+        while (peak < live && !m_peakBytes.compare_exchange_weak(peak, live)) {
+        }
+    }
+
+    void remove(std::size_t bytes) noexcept { m_liveBytes.fetch_sub(bytes); }
+
+    /// Returns the most bytes held at once so far.
+    std::size_t peakBytes() const noexcept { return m_peakBytes.load(); }
+
+private:
+    std::atomic<std::size_t> m_liveBytes{};
+    std::atomic<std::size_t> m_peakBytes{};
+};
+
+/**
+ * @class ArenaHighWaterScope
+ * @brief Installs an ArenaHighWater on a context for the duration of one conversion.
+ *
+ * If the context already has a tracker (for example because an enclosing conversion installed one), that tracker
+ * is kept and highWater() reports it instead.
+ */
+class ArenaHighWaterScope
+{
+public:
+    explicit ArenaHighWaterScope(const DenigmaContext& context)
+        : m_context(context), m_installed(!context.arenaHighWater)
+    {
+        if (m_installed) {
+            m_context.arenaHighWater = &m_highWater;
+        }
+    }
+
+    ~ArenaHighWaterScope()
+    {
+        if (m_installed) {
+            m_context.arenaHighWater = nullptr;
+        }
+    }
+
+    ArenaHighWaterScope(const ArenaHighWaterScope&) = delete;
+    ArenaHighWaterScope& operator=(const ArenaHighWaterScope&) = delete;
+
+    const ArenaHighWater& highWater() const noexcept { return *m_context.arenaHighWater; }
+
+private:
+    const DenigmaContext& m_context;
+    ArenaHighWater m_highWater;
+    bool m_installed;
+};
+
+/**
+ * @class ArenaBlockCache
+ * @brief Keeps the blocks of finished ConversionArenas for the next conversion on the same worker thread.
+ *
+ * An arena asks its upstream for the same run of growing blocks in every conversion, so once a batch worker has
+ * converted a file or two, the mapping containers of the next one get all their memory from blocks kept here instead
+ * of from the system. Blocks are kept by exact size and alignment, up to #MAX_RETAINED_BYTES per thread; beyond that
+ * they are freed. A block can come back on another thread than the one whose cache it belongs to (a mapping may be
+ * released in the background), so the cache locks, which it does once per arena block.
+ */
+class ArenaBlockCache : public std::pmr::memory_resource
+{
+public:
+    static constexpr std::size_t MAX_RETAINED_BYTES = 64 * 1024 * 1024;
+
+    ArenaBlockCache() = default;
+    ~ArenaBlockCache() override { release(); }
+
+    ArenaBlockCache(const ArenaBlockCache&) = delete;
+    ArenaBlockCache& operator=(const ArenaBlockCache&) = delete;
+
+    /// The calling thread's cache. Arenas hold a reference, so it outlives the thread while one of its arenas does.
+    static const std::shared_ptr<ArenaBlockCache>& forThisThread();
+
+    /// The total size of the blocks kept for reuse.
+    std::size_t retainedBytes() const;
+
+    /// Frees every kept block.
+    void release();
+
+private:
+    struct Block
+    {
+        void* pointer{};
+        std::size_t bytes{};
+        std::size_t alignment{};
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    mutable std::mutex m_mutex;
+    std::vector<Block> m_blocks;
+    std::size_t m_retainedBytes{};
+};
+
+namespace detail {
+
+/// Forwards to an arena's upstream resource and reports the blocks it hands out to an ArenaHighWater.
+class TrackedUpstreamResource : public std::pmr::memory_resource
+{
+public:
+    TrackedUpstreamResource(std::pmr::memory_resource* upstream, ArenaHighWater* highWater)
+        : m_upstream(upstream), m_highWater(highWater)
+    {
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        void* result = m_upstream->allocate(bytes, alignment);
+        if (m_highWater) {
+            m_highWater->add(bytes);
+        }
+        return result;
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override
+    {
+        m_upstream->deallocate(ptr, bytes, alignment);
+        if (m_highWater) {
+            m_highWater->remove(bytes);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* m_upstream;
+    ArenaHighWater* m_highWater;
+};
+
+/// Holds the tracked upstream so that it is constructed before, and destroyed after, the arena using it.
+struct ArenaUpstreamHolder
+{
+    std::shared_ptr<ArenaBlockCache> blockCache;   ///< the upstream when the context names none
+    TrackedUpstreamResource trackedUpstream;
+};
+
+} // namespace detail
+
+/**
+ * @class ConversionArena
+ * @brief Monotonic memory behind one conversion's mapping containers.
+ *
+ * Converter mappings fill many small node-based containers and drop them all when the conversion ends.
+ * Allocating them from this arena turns their teardown into releasing a few large blocks obtained from
+ * DenigmaContext::memoryResource, or when that is not set from the ArenaBlockCache of the creating thread, which
+ * keeps them for the mappings of the thread's next conversion. Memory freed by a container (for example on clear or
+ * rehash) is only reclaimed when the arena itself is destroyed, so an arena should not outlive its conversion.
+ * Like the mappings that own it, an arena is used by one thread at a time.
+ * The blocks it holds are counted in DenigmaContext::arenaHighWater when that is set.
+ */
+class ConversionArena : private detail::ArenaUpstreamHolder, public std::pmr::monotonic_buffer_resource
+{
+public:
+    explicit ConversionArena(const DenigmaContext& context)
+        : detail::ArenaUpstreamHolder(makeUpstream(context)),
+          std::pmr::monotonic_buffer_resource(INITIAL_BLOCK_SIZE, &trackedUpstream)
+    {
+    }
+
+private:
+    static detail::ArenaUpstreamHolder makeUpstream(const DenigmaContext& context)
+    {
+        auto cache = context.memoryResource ? nullptr : ArenaBlockCache::forThisThread();
+        auto* upstream = context.memoryResource ? context.memoryResource : cache.get();
+        return { std::move(cache), detail::TrackedUpstreamResource(upstream, context.arenaHighWater) };
+    }
+
+    static constexpr std::size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+};
+
+} // namespace denigma
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+
+#include "core/conversion_excerpt.h"
+
+namespace denigma {
+
+ConversionExcerpt::ConversionExcerpt(const DenigmaContext& denigmaContext, const musx::dom::DocumentPtr& document,
+    musx::dom::Cmper partId)
+{
+    using namespace musx::dom;
+    m_measureCount = MeasCmper(document->getOthers()->getArray<others::Measure>(partId).size());
+    m_lastMeasure = m_measureCount;
+    if (const auto& range = denigmaContext.measureRange) {
+        const int last = (std::max)(1, int(m_measureCount));
+        m_firstMeasure = MeasCmper(std::clamp(range->first, 1, last));
+        m_lastMeasure = MeasCmper(std::clamp(range->last, int(m_firstMeasure), last));
+    }
+    if (!denigmaContext.staffFilter.empty()) {
+        // positions count the score's staves, so a linked part keeps the same staves as the score
+        const auto scoreStaves = document->getScrollViewStaves(SCORE_PARTID);
+        for (const int position : denigmaContext.staffFilter) {
+            if (position >= 1 && std::size_t(position) <= scoreStaves.size()) {
+                m_staves.push_back(scoreStaves[std::size_t(position - 1)]->staffId);
+            }
+        }
+        std::sort(m_staves.begin(), m_staves.end());
+        m_staves.erase(std::unique(m_staves.begin(), m_staves.end()), m_staves.end());
+        if (m_staves.empty()) {
+            m_staves.push_back(0); // no valid position: keep no staff rather than every staff
+        }
+    }
+}
+
+bool ConversionExcerpt::includesStaff(musx::dom::StaffCmper staffId) const
+{
+    return m_staves.empty() || std::binary_search(m_staves.begin(), m_staves.end(), staffId);
+}
+
+void ConversionExcerpt::restrict(musx::dom::MusxInstanceList<musx::dom::others::Measure>& measures) const
+{
+    if (m_lastMeasure < m_measureCount) {
+        measures.erase(std::find_if(measures.begin(), measures.end(), [this](const auto& measure) {
+            return measure->getCmper() > m_lastMeasure;
+        }), measures.end());
+    }
+    if (startsMidScore()) {
+        measures.erase(measures.begin(), std::find_if(measures.begin(), measures.end(), [this](const auto& measure) {
+            return measure->getCmper() >= m_firstMeasure;
+        }));
+    }
+}
+
+} // namespace denigma
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "core/denigma.h"
+#include "musx/musx.h"
+
+namespace denigma {
+
+/**
+ * @class ConversionExcerpt
+ * @brief The measures and staves of one part that a partial conversion keeps, from DenigmaContext::measureRange and
+ * DenigmaContext::staffFilter.
+ *
+ * Measure numbers outside the part are clamped to it, and staff positions past the last staff are ignored. Without
+ * either option the excerpt is the whole part, and every query answers as it would for a full conversion.
+ */
+class ConversionExcerpt
+{
+public:
+    /// Resolves the context's options against the measures and score staves of partId.
+    ConversionExcerpt(const DenigmaContext& denigmaContext, const musx::dom::DocumentPtr& document, musx::dom::Cmper partId);
+
+    musx::dom::MeasCmper firstMeasure() const { return m_firstMeasure; }    ///< first measure kept
+    musx::dom::MeasCmper lastMeasure() const { return m_lastMeasure; }      ///< last measure kept
+    musx::dom::MeasCmper measureCount() const { return m_measureCount; }    ///< measures in the whole part
+
+    /// True when the excerpt starts after the first measure, so state in effect there must be restated.
+    bool startsMidScore() const { return m_firstMeasure > 1; }
+    /// True when measures or staves are left out.
+    bool isPartial() const { return startsMidScore() || m_lastMeasure < m_measureCount || !m_staves.empty(); }
+
+    bool includesMeasure(musx::dom::MeasCmper measureId) const
+    { return measureId >= m_firstMeasure && measureId <= m_lastMeasure; }
+
+    bool includesStaff(musx::dom::StaffCmper staffId) const;
+
+    /// Returns the position of measureId among the kept measures, or std::nullopt when it is left out.
+    std::optional<std::size_t> measureIndex(musx::dom::MeasCmper measureId) const
+    {
+        if (!includesMeasure(measureId)) {
+            return std::nullopt;
+        }
+        return std::size_t(measureId - m_firstMeasure);
+    }
+
+    /// Removes the measures the excerpt leaves out from the part's measure list, which must be in measure order.
+    void restrict(musx::dom::MusxInstanceList<musx::dom::others::Measure>& measures) const;
+
+private:
+    musx::dom::MeasCmper m_firstMeasure{ 1 };
+    musx::dom::MeasCmper m_lastMeasure{};
+    musx::dom::MeasCmper m_measureCount{};
+    std::vector<musx::dom::StaffCmper> m_staves; ///< sorted; empty keeps every staff
+};
+
+} // namespace denigma
@@ -19,26 +19,45 @@
 
 #include "core/cue_layers.h"
 
+#include <tuple>
+
+#include "classify/classification_cache.h"
+#include "core/hot_path_counters.h"
+
 namespace denigma {
 
+namespace {
+
+/// Cue plans keyed by requested part, staff, measure and the explicit cue layer option (0 when there is none).
+using CueLayerPlanTable = classify::detail::ClassificationCache::Table<
+    std::tuple<musx::dom::Cmper, musx::dom::StaffCmper, musx::dom::MeasCmper, int>, CueLayerPlan>;
+
+} // namespace
+
 CueLayerPlan createCueLayerPlan(const musx::dom::details::GFrameHoldContext& gfHold, std::optional<int> explicitCueLayer)
 {
-    CueLayerPlan result;
-    constexpr bool includeVisibleInScore = false;
-    const auto cueSummary = gfHold.calcCueSummary(includeVisibleInScore);
-    result.discardWholeHold = cueSummary.isCueHold;
-    result.heuristicCueLayers.insert(cueSummary.cueLayers.begin(), cueSummary.cueLayers.end());
-    result.discardLayers.insert(cueSummary.cueLayers.begin(), cueSummary.cueLayers.end());
-
-    if (explicitCueLayer) {
-        const auto layer = static_cast<musx::dom::LayerIndex>(*explicitCueLayer - 1);
-        if (layer < gfHold->frames.size() && gfHold->frames[layer] != 0) {
-            result.explicitCueLayer = layer;
-            result.discardLayers.emplace(layer);
+    const auto key = std::make_tuple(gfHold->getRequestedPartId(), gfHold->getStaff(), gfHold->getMeasure(),
+        explicitCueLayer.value_or(0));
+    return classify::detail::cachedClassification<CueLayerPlanTable>(gfHold->getDocument(), key, [&]() {
+        countHotPath(ConversionStats::HotPath::CueHeuristic);
+        CueLayerPlan result;
+        constexpr bool includeVisibleInScore = false;
+        const auto cueSummary = gfHold.calcCueSummary(includeVisibleInScore);
+        result.discardWholeHold = cueSummary.isCueHold;
+        for (const auto layer : cueSummary.cueLayers) {
+            result.heuristicCueLayers |= CueLayerPlan::layerBit(layer);
         }
-    }
+        result.discardLayers = result.heuristicCueLayers;
 
-    return result;
+        if (explicitCueLayer) {
+            const auto layer = static_cast<musx::dom::LayerIndex>(*explicitCueLayer - 1);
+            if (layer < gfHold->frames.size() && gfHold->frames[layer] != 0) {
+                result.explicitCueLayer = layer;
+                result.discardLayers |= CueLayerPlan::layerBit(layer);
+            }
+        }
+        return result;
+    });
 }
 
 } // namespace denigma
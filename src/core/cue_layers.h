@@ -18,26 +18,39 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <optional>
-#include <unordered_set>
 
 #include "musx/musx.h"
 
 namespace denigma {
 
+/// @brief Which layers of one staff and measure a conversion leaves out as cues.
+///
+/// Finale frames have at most four layers, so each layer set is a bit mask: the plan is a small value that is cheap
+/// to copy into per-measure tables.
 struct CueLayerPlan
 {
     bool discardWholeHold{};
-    std::unordered_set<musx::dom::LayerIndex> discardLayers;
-    std::unordered_set<musx::dom::LayerIndex> heuristicCueLayers;
+    std::uint8_t discardLayers{};       ///< bit n set when layer index n is left out
+    std::uint8_t heuristicCueLayers{};  ///< bit n set when layer index n was detected as cue notes
     std::optional<musx::dom::LayerIndex> explicitCueLayer;
 
+    static constexpr std::uint8_t layerBit(musx::dom::LayerIndex layer)
+    { return layer < 4 ? std::uint8_t(1u << layer) : std::uint8_t(0); }
+
+    bool discardsLayer(musx::dom::LayerIndex layer) const { return (discardLayers & layerBit(layer)) != 0; }
+    bool isHeuristicCueLayer(musx::dom::LayerIndex layer) const { return (heuristicCueLayers & layerBit(layer)) != 0; }
+    bool hasHeuristicCueLayers() const { return heuristicCueLayers != 0; }
+
     bool skipsLayer(musx::dom::LayerIndex layer) const
     {
-        return discardWholeHold || discardLayers.contains(layer);
+        return discardWholeHold || discardsLayer(layer);
     }
 };
 
+/// Returns the cue plan of gfHold. Plans are cached per document, so every conversion of a document detects the cues
+/// of a staff and measure once.
 CueLayerPlan createCueLayerPlan(const musx::dom::details::GFrameHoldContext& gfHold, std::optional<int> explicitCueLayer);
 
 } // namespace denigma
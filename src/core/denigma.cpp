@@ -20,35 +20,94 @@
  * THE SOFTWARE.
  */
 #include "core/denigma.h"
+#include <algorithm>
 #include <limits>
 #include <iostream>
 #include <mutex>
+#include <sstream>
+#include <streambuf>
+
+#include "core/allocation_stats.h"
+#include "core/enigma_binary.h"
+#include "core/xxhash64.h"
 
 namespace denigma {
 
 namespace {
 
+/// The innermost PhaseTimer running on this thread, which a new timer pauses until it stops.
+thread_local PhaseTimer* t_runningPhaseTimer{};
+
+/// Counts each output and its bytes on their way to another sink, and fingerprints them when asked to.
+class CountingOutputSink final : public IMultiOutputSink
+{
+public:
+    CountingOutputSink(IMultiOutputSink& sink, const DenigmaContext& denigmaContext, bool fingerprint)
+        : m_sink(sink), m_context(denigmaContext), m_stats(denigmaContext.conversionResult->stats()), m_fingerprint(fingerprint)
+    {
+    }
+
+    bool begin(std::string_view suggestedName) override
+    {
+        m_name = suggestedName;
+        m_bytes = 0;
+        m_hasher.reset();
+        return m_sink.begin(suggestedName);
+    }
+
+    void write(std::span<const std::byte> data) override
+    {
+        PhaseTimer deliveryTimer(m_context, ConversionStats::Phase::Serialize);
+        m_stats.bytesWritten += data.size();
+        m_bytes += data.size();
+        if (m_fingerprint) {
+            m_hasher.update(data);
+        }
+        m_sink.write(data);
+    }
+
+    void end() override
+    {
+        PhaseTimer deliveryTimer(m_context, ConversionStats::Phase::Serialize);
+        ++m_stats.outputs;
+        if (m_fingerprint) {
+            m_context.conversionResult->addOutputFingerprint({ std::move(m_name), m_hasher.digest(), m_bytes });
+        }
+        m_sink.end();
+    }
+
+private:
+    IMultiOutputSink& m_sink;
+    const DenigmaContext& m_context;
+    ConversionStats& m_stats;
+    bool m_fingerprint{};
+    std::string m_name;
+    std::uint64_t m_bytes{};
+    Xxh64 m_hasher;
+};
+
+/// The callbacks of the MusxLoggerScopes open on this thread, innermost last. Scopes on one thread nest, so the
+/// bridge reads this without a lock and a conversion only ever receives the messages of its own thread.
+thread_local std::vector<musx::util::Logger::LogCallback> t_musxCallbacks;
+
+// The bridge is installed while any thread has a scope open; these are only touched when a scope opens or closes,
+// or when a thread without a scope logs.
 std::mutex g_musxLoggerMutex;
 musx::util::Logger::LogCallback g_originalMusxCallback;
-std::vector<musx::util::Logger::LogCallback> g_musxCallbackStack;
-bool g_musxBridgeInstalled{};
+std::size_t g_openMusxLoggerScopes{};
 
 musx::util::Logger::LogCallback makeMusxBridge()
 {
     return [](musx::util::Logger::LogLevel logLevel, const std::string& msg) {
-        musx::util::Logger::LogCallback callback;
+        if (!t_musxCallbacks.empty()) {
+            t_musxCallbacks.back()(logLevel, msg);
+            return;
+        }
         musx::util::Logger::LogCallback fallback;
         {
             std::lock_guard<std::mutex> lock(g_musxLoggerMutex);
-            if (!g_musxCallbackStack.empty()) {
-                callback = g_musxCallbackStack.back();
-            }
             fallback = g_originalMusxCallback;
         }
-        if (callback) {
-            callback(logLevel, msg);
-            return;
-        }
         if (fallback) {
             fallback(logLevel, msg);
             return;
@@ -70,6 +129,50 @@ musx::util::SvgConvert::SvgUnit parseSvgUnitOption(const std::string& input)
     throw std::invalid_argument("Invalid value for --svg-unit: " + input + ". Expected one of: none, px, pt, pc, cm, mm, in.");
 }
 
+formats::mnx::Encoding parseMnxEncodingOption(const std::string& input)
+{
+    const std::string value = utils::toLowerCase(input);
+    if (value == "json") return formats::mnx::Encoding::Json;
+    if (value == "cbor") return formats::mnx::Encoding::Cbor;
+    if (value == "msgpack") return formats::mnx::Encoding::MessagePack;
+    if (value == "bson") return formats::mnx::Encoding::Bson;
+    throw std::invalid_argument("Invalid value for --mnx-encoding: " + input + ". Expected one of: json, cbor, msgpack, bson.");
+}
+
+TextMetricsMode parseTextMetricsOption(const std::string& input)
+{
+    const std::string value = utils::toLowerCase(input);
+    if (value == "fonts") return TextMetricsMode::Fonts;
+    if (value == "heuristic") return TextMetricsMode::Heuristic;
+    throw std::invalid_argument("Invalid value for --text-metrics: " + input + ". Expected one of: fonts, heuristic.");
+}
+
+std::uint64_t parseByteSizeOption(const std::string& optionName, const std::string& input)
+{
+    if (input.empty()) {
+        throw std::invalid_argument("Missing value for " + optionName);
+    }
+    const auto invalid = [&]() {
+        return std::invalid_argument("Invalid value for " + optionName + ": " + input + " (expected a byte count, optionally ending in K, M or G)");
+    };
+    if (input.front() < '0' || input.front() > '9') {
+        throw invalid();
+    }
+    std::size_t digits = 0;
+    std::uint64_t value = 0;
+    try {
+        value = std::stoull(input, &digits);
+    } catch (...) {
+        throw invalid();
+    }
+    const std::string suffix = utils::toLowerCase(input.substr(digits));
+    if (suffix.empty()) return value;
+    if (suffix == "k") return value << 10;
+    if (suffix == "m") return value << 20;
+    if (suffix == "g") return value << 30;
+    throw invalid();
+}
+
 void appendShapeDefIds(const std::string& list, std::vector<musx::dom::Cmper>& out)
 {
     if (list.empty()) {
@@ -109,6 +212,27 @@ void appendShapeDefIds(const std::string& list, std::vector<musx::dom::Cmper>& o
     }
 }
 
+constexpr unsigned DEFAULT_ISOLATE_TIMEOUT_SECONDS = 600;
+constexpr unsigned DEFAULT_PIPELINE_READ_JOBS = 2;
+constexpr unsigned DEFAULT_PREFETCH_DEPTH = 1;
+
+unsigned parseJobCount(const std::string& optionName, const std::string& value)
+{
+    if (value.empty()) {
+        return 0; // omitted count means all available cores
+    }
+    int parsed = 0;
+    try {
+        parsed = std::stoi(value);
+    } catch (...) {
+        throw std::invalid_argument("Invalid value for " + optionName + ": " + value);
+    }
+    if (parsed < 0) {
+        throw std::invalid_argument("Invalid value for " + optionName + ": " + value + " (must be >= 0)");
+    }
+    return static_cast<unsigned>(parsed);
+}
+
 } // namespace
 
 std::vector<const arg_char*> DenigmaContext::parseOptions(int argc, arg_char* argv[])
@@ -157,6 +281,103 @@ std::vector<const arg_char*> DenigmaContext::parseOptions(int argc, arg_char* ar
             verbose = true;
         } else if (next == _ARG("--no-validate")) {
             noValidate = true;
+        } else if (next == _ARG("--validate-concurrently")) {
+            validateConcurrently = true;
+        } else if (next == _ARG("--validate-every")) {
+            const std::string everyValue = std::string(_ARG_CONV(getNextArg()));
+            if (everyValue.empty()) {
+                throw std::invalid_argument("Missing value for --validate-every");
+            }
+            int parsed = 0;
+            try {
+                parsed = std::stoi(everyValue);
+            } catch (...) {
+                throw std::invalid_argument("Invalid value for --validate-every: " + everyValue);
+            }
+            if (parsed < 1) {
+                throw std::invalid_argument("Invalid value for --validate-every: " + everyValue + " (must be >= 1)");
+            }
+            validateEvery = static_cast<unsigned>(parsed);
+        } else if (next == _ARG("--cache-dir")) {
+            auto option = getNextArg();
+            if (option.empty()) {
+                throw std::invalid_argument("Missing value for --cache-dir");
+            }
+            xmlCacheDir = option;
+        } else if (next == _ARG("--trace")) {
+            auto option = getNextArg();
+            if (option.empty()) {
+                throw std::invalid_argument("Missing value for --trace");
+            }
+            traceFilePath = option;
+        } else if (next == _ARG("--trace-slow")) {
+            const std::string thresholdValue = std::string(_ARG_CONV(getNextArg()));
+            if (thresholdValue.empty()) {
+                throw std::invalid_argument("Missing value for --trace-slow");
+            }
+            slowTraceThreshold = SlowFileThreshold::parse(thresholdValue);
+        } else if (next == _ARG("--fingerprint-manifest")) {
+            auto option = getNextArg();
+            if (option.empty()) {
+                throw std::invalid_argument("Missing value for --fingerprint-manifest");
+            }
+            fingerprintManifestPath = option;
+        } else if (next == _ARG("--text-metrics")) {
+            const std::string modeValue = std::string(_ARG_CONV(getNextArg()));
+            if (modeValue.empty()) {
+                throw std::invalid_argument("Missing value for --text-metrics");
+            }
+            textMetrics = parseTextMetricsOption(modeValue);
+        } else if (next == _ARG("--output-archive")) {
+            auto option = getNextArg();
+            if (option.empty()) {
+                throw std::invalid_argument("Missing value for --output-archive");
+            }
+            outputArchivePath = option;
+        } else if (next == _ARG("--output-archive-shard-size")) {
+            outputArchiveShardBytes = parseByteSizeOption("--output-archive-shard-size", std::string(_ARG_CONV(getNextArg())));
+        } else if (next == _ARG("--write-behind")) {
+            writeBehindBytes = writeBehindBytes.value_or(OutputWriter::DEFAULT_MAX_QUEUED_BYTES);
+        } else if (next == _ARG("--write-behind-queue-size")) {
+            writeBehindBytes = static_cast<std::size_t>(
+                parseByteSizeOption("--write-behind-queue-size", std::string(_ARG_CONV(getNextArg()))));
+        } else if (next == _ARG("--incremental")) {
+            incrementalManifestPath = getNextArg();
+        } else if (next == _ARG("--jobs")) {
+            jobs = parseJobCount("--jobs", std::string(_ARG_CONV(getNextArg())));
+        } else if (next == _ARG("--isolate")) {
+            const std::string value = std::string(_ARG_CONV(getNextArg()));
+            isolateTimeoutSeconds = value.empty() ? DEFAULT_ISOLATE_TIMEOUT_SECONDS : parseJobCount("--isolate", value);
+        } else if (next == _ARG("--file-timeout")) {
+            const std::string value = std::string(_ARG_CONV(getNextArg()));
+            if (value.empty()) {
+                throw std::invalid_argument("Missing value for --file-timeout");
+            }
+            fileTimeoutSeconds = parseJobCount("--file-timeout", value);
+        } else if (next == _ARG("--prefetch")) {
+            const std::string value = std::string(_ARG_CONV(getNextArg()));
+            prefetchDepth = value.empty() ? DEFAULT_PREFETCH_DEPTH : parseJobCount("--prefetch", value);
+            if (prefetchDepth == 0u) {
+                throw std::invalid_argument("Invalid value for --prefetch: " + value + " (must be >= 1)");
+            }
+        } else if (next == _ARG("--pipeline")) {
+            const std::string value = std::string(_ARG_CONV(getNextArg()));
+            pipelineReadJobs = value.empty() ? DEFAULT_PIPELINE_READ_JOBS : parseJobCount("--pipeline", value);
+            if (pipelineReadJobs == 0u) {
+                throw std::invalid_argument("Invalid value for --pipeline: " + value + " (must be >= 1)");
+            }
+        } else if (next == _ARG("--dedupe")) {
+            dedupeInputs = DuplicateOutputs::Copy;
+            if (x + 1 < argc && arg_view(argv[x + 1]) == _ARG("link")) {
+                dedupeInputs = DuplicateOutputs::HardLink;
+                x++;
+            } else if (x + 1 < argc && arg_view(argv[x + 1]) == _ARG("copy")) {
+                x++;
+            }
+        } else if (next == _ARG("--memory-budget")) {
+            memoryBudget = parseByteSizeOption("--memory-budget", std::string(_ARG_CONV(getNextArg())));
+        } else if (next == _ARG("--output-jobs")) {
+            outputJobs = parseJobCount("--output-jobs", std::string(_ARG_CONV(getNextArg())));
         } else if (next == _ARG("--cue-layer")) {
             const std::string layerValue = std::string(_ARG_CONV(getNextArg()));
             if (layerValue.empty()) {
@@ -200,6 +421,10 @@ std::vector<const arg_char*> DenigmaContext::parseOptions(int argc, arg_char* ar
             includeTempoTool = false;
         } else if (next == _ARG("--split-instruments")) {
             mnxSplitInstruments = true;
+        } else if (next == _ARG("--stream-parts")) {
+            musicXmlStreamParts = true;
+        } else if (next == _ARG("--dedupe-parts")) {
+            musicXmlDedupeParts = true;
         } else if (next == _ARG("--pretty-print")) {
             try {
                 int value = std::stoi(std::string(_ARG_CONV(getNextArg())));
@@ -207,13 +432,36 @@ std::vector<const arg_char*> DenigmaContext::parseOptions(int argc, arg_char* ar
             } catch (...) {
                 indentSpaces = JSON_INDENT_SPACES;
             }
+            compactXml = false;
         } else if (next == _ARG("--no-pretty-print")) {
             indentSpaces = std::nullopt;
+            compactXml = true;
         } else if (next == _ARG("--mnx-schema")) {
             std::filesystem::path schemaPath = getNextArg();
             if (!schemaPath.empty()) {
                 mnxSchemaPath = schemaPath;
             }
+        } else if (next == _ARG("--mnx-encoding")) {
+            const std::string encodingValue = std::string(_ARG_CONV(getNextArg()));
+            if (encodingValue.empty()) {
+                throw std::invalid_argument("Missing value for --mnx-encoding");
+            }
+            mnxEncoding = parseMnxEncodingOption(encodingValue);
+        } else if (next == _ARG("--musx-compression-level")) {
+            const std::string levelValue = std::string(_ARG_CONV(getNextArg()));
+            if (levelValue.empty()) {
+                throw std::invalid_argument("Missing value for --musx-compression-level");
+            }
+            int parsed = 0;
+            try {
+                parsed = std::stoi(levelValue);
+            } catch (...) {
+                throw std::invalid_argument("Invalid value for --musx-compression-level: " + levelValue + " (must be 0..9)");
+            }
+            if (parsed < 0 || parsed > 9) {
+                throw std::invalid_argument("Invalid value for --musx-compression-level: " + levelValue + " (must be 0..9)");
+            }
+            musxCompressionLevel = parsed;
         } else if (next == _ARG("--shape-def")) {
             const std::string shapeDefList = std::string(_ARG_CONV(getNextArg()));
             appendShapeDefIds(shapeDefList, svgShapeDefs);
@@ -228,6 +476,8 @@ std::vector<const arg_char*> DenigmaContext::parseOptions(int argc, arg_char* ar
             svgPageScaleExplicitlyEnabled = true;
         } else if (next == _ARG("--no-svg-page-scale")) {
             svgUsePageScale = false;
+        } else if (next == _ARG("--svg-sprite-sheet")) {
+            svgSpriteSheet = true;
         } else if (next == _ARG("--svg-scale")) {
             const std::string scaleValue = std::string(_ARG_CONV(getNextArg()));
             if (scaleValue.empty()) {
@@ -284,13 +534,8 @@ void DenigmaContext::logMessage(LogMsg&& msg, bool alwaysShow, MessageSeverity s
             case MessageSeverity::Error: return "[***ERROR***] ";
             }
         };
-    if (!alwaysShow) {
-        if (severity == MessageSeverity::Verbose && (!verbose || quiet)) {
-            return;
-        }
-        if (severity == MessageSeverity::Info && quiet) {
-            return;
-        }
+    if (!alwaysShow && !shouldLog(severity)) {
+        return;
     }
     if (severity == MessageSeverity::Error) {
         errorOccurred = true;
@@ -300,6 +545,10 @@ void DenigmaContext::logMessage(LogMsg&& msg, bool alwaysShow, MessageSeverity s
     if (conversionResult && (severity == MessageSeverity::Warning || severity == MessageSeverity::Error)) {
         conversionResult->addDiagnostic(severity, text);
     }
+    if (logBuffer) {
+        logBuffer->push_back({ severity, text, inputFilePath });
+        return;
+    }
     if (logCallback) {
         logCallback(severity, text);
         return;
@@ -310,16 +559,12 @@ void DenigmaContext::logMessage(LogMsg&& msg, bool alwaysShow, MessageSeverity s
     if (!inputFile.empty()) {
         inputFile += ' ';
     }
-    if (logFile && logFile->is_open()) {
-        LogMsg prefix = LogMsg() << "[" << getTimeStamp("%Y-%m-%d %H:%M:%S") << "] " << inputFile;
-        prefix.flush();
-        *logFile << prefix.str() << getSeverityStr() << text << std::endl;
-        if (severity == MessageSeverity::Error) {
-            *logFile << prefix.str() << "PROCESSING ABORTED" << std::endl;
-        }
+    if (logFile) {
+        logFile->write(inputFile + getSeverityStr() + text);
         if (severity != MessageSeverity::Error) {
             return;
         }
+        logFile->write(inputFile + "PROCESSING ABORTED", /*flush*/ true);
     }
 
 #if defined(_WIN32) && !defined(DENIGMA_TEST)
@@ -354,33 +599,346 @@ musx::util::Logger::LogCallback makeMusxLogCallback(const DenigmaContext& denigm
             case musx::util::Logger::LogLevel::Verbose: return MessageSeverity::Verbose;
             }
         }();
-        denigmaContext.logMessage(LogMsg() << msg, severity);
+        if (denigmaContext.shouldLog(severity)) {
+            denigmaContext.logMessage(LogMsg() << msg, severity);
+        }
     };
 }
 
 MusxLoggerScope::MusxLoggerScope(musx::util::Logger::LogCallback callback)
 {
-    std::lock_guard<std::mutex> lock(g_musxLoggerMutex);
-    if (!g_musxBridgeInstalled) {
-        g_originalMusxCallback = musx::util::Logger::getCallback();
-        musx::util::Logger::setCallback(makeMusxBridge());
-        g_musxBridgeInstalled = true;
+    {
+        std::lock_guard<std::mutex> lock(g_musxLoggerMutex);
+        if (g_openMusxLoggerScopes++ == 0) {
+            g_originalMusxCallback = musx::util::Logger::getCallback();
+            musx::util::Logger::setCallback(makeMusxBridge());
+        }
     }
-    g_musxCallbackStack.emplace_back(std::move(callback));
+    t_musxCallbacks.push_back(std::move(callback));
 }
 
 MusxLoggerScope::~MusxLoggerScope()
 {
+    t_musxCallbacks.pop_back();
     std::lock_guard<std::mutex> lock(g_musxLoggerMutex);
-    if (!g_musxCallbackStack.empty()) {
-        g_musxCallbackStack.pop_back();
-    }
-    if (g_musxCallbackStack.empty() && g_musxBridgeInstalled) {
+    if (--g_openMusxLoggerScopes == 0) {
         musx::util::Logger::setCallback(std::move(g_originalMusxCallback));
-        g_musxBridgeInstalled = false;
     }
 }
 
+PhaseTimer::PhaseTimer(const DenigmaContext& denigmaContext, ConversionStats::Phase phase)
+    : m_stats(denigmaContext.conversionResult ? &denigmaContext.conversionResult->stats() : nullptr), m_phase(phase)
+{
+    if (!m_stats) {
+        return;
+    }
+    m_stats->memoryCounted = m_stats->memoryCounted || allocation_stats::hooksInstalled();
+    const auto now = std::chrono::steady_clock::now();
+    m_interrupted = t_runningPhaseTimer;
+    if (m_interrupted) {
+        m_interrupted->charge(now);
+    }
+    t_runningPhaseTimer = this;
+    m_running = true;
+    resume(now);
+}
+
+void PhaseTimer::stop()
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    const auto now = std::chrono::steady_clock::now();
+    charge(now);
+    assert(t_runningPhaseTimer == this);
+    t_runningPhaseTimer = m_interrupted;
+    if (m_interrupted) {
+        m_interrupted->resume(now);
+    }
+}
+
+void PhaseTimer::resume(std::chrono::steady_clock::time_point now)
+{
+    m_start = now;
+    auto& counters = allocation_stats::t_counters;
+    m_allocatedAtStart = counters.allocatedBytes;
+    m_liveAtStart = counters.liveBytes;
+    counters.peakLiveBytes = counters.liveBytes;
+}
+
+void PhaseTimer::charge(std::chrono::steady_clock::time_point now)
+{
+    m_stats->addPhaseTime(m_phase, now - m_start);
+    if (m_stats->memoryCounted) {
+        const auto& counters = allocation_stats::t_counters;
+        m_stats->addPhaseMemory(m_phase, ConversionStats::PhaseMemory{
+            counters.allocatedBytes - m_allocatedAtStart,
+            counters.liveBytes - m_liveAtStart,
+            static_cast<std::uint64_t>((std::max)(counters.peakLiveBytes - m_liveAtStart, std::int64_t(0))) });
+    }
+}
+
+/// Hashes everything written through it on its way to the stream buffer it was put in front of.
+class HashingStreamBuf final : public std::streambuf
+{
+public:
+    explicit HashingStreamBuf(std::streambuf* target) : m_target(target), m_buffer(BUFFER_SIZE)
+    {
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+
+    std::streambuf* target() const { return m_target; }
+
+    /// Passes on anything buffered and returns the fingerprint of all that was written.
+    OutputFingerprint finish()
+    {
+        flushPending();
+        return { {}, m_hasher.digest(), m_bytes };
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!flushPending()) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        return flushPending() && m_target->pubsync() == 0 ? 0 : -1;
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override
+    {
+        // only position queries (tellp) are passed on: moving the write position would make the hash meaningless
+        if (offset != 0 || direction != std::ios_base::cur || !flushPending()) {
+            return pos_type(off_type(-1));
+        }
+        return m_target->pubseekoff(0, direction, which);
+    }
+
+private:
+    bool flushPending()
+    {
+        const auto pending = static_cast<std::streamsize>(pptr() - pbase());
+        if (pending > 0) {
+            const auto written = m_target->sputn(pbase(), pending);
+            if (written > 0) {
+                m_hasher.update(std::as_bytes(std::span<const char>(pbase(), static_cast<std::size_t>(written))));
+                m_bytes += static_cast<std::uint64_t>(written);
+            }
+            if (written != pending) {
+                return false;
+            }
+        }
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+        return true;
+    }
+
+    static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+    std::streambuf* m_target;
+    std::vector<char> m_buffer;
+    Xxh64 m_hasher;
+    std::uint64_t m_bytes{};
+};
+
+ConversionStatsScope::ConversionStatsScope(const DenigmaContext& denigmaContext, const CommonOptions& options, std::ostream* output)
+    : m_context(denigmaContext),
+      m_report(options.statsReport),
+      m_logCallback(options.logCallback),
+      m_fingerprint(options.fingerprintOutputs || !options.fingerprintManifest.empty()),
+      m_fingerprintManifest(options.fingerprintManifest),
+      m_sourceName(options.sourceName),
+      m_output(output),
+      m_outputStart(output ? output->tellp() : std::streampos(-1)),
+      m_traceRecorder(options.traceFile.empty() ? nullptr : std::make_unique<TraceRecorder>(options.traceFile)),
+      m_traceFile(std::string_view(options.sourceName)),
+      m_span("conversion"),
+      m_timer(denigmaContext, ConversionStats::Phase::Convert),
+      m_installedHotPaths(denigmaContext.conversionResult && !denigmaContext.hotPathCounters),
+      m_hotPathThread(m_installedHotPaths ? &m_hotPaths : denigmaContext.hotPathCounters)
+{
+    if (m_installedHotPaths) {
+        m_context.hotPathCounters = &m_hotPaths;
+    }
+    if (m_fingerprint && m_output && m_output->rdbuf() && denigmaContext.conversionResult) {
+        m_hashingBuf = std::make_unique<HashingStreamBuf>(m_output->rdbuf());
+        m_output->rdbuf(m_hashingBuf.get());
+    }
+}
+
+ConversionStatsScope::~ConversionStatsScope()
+{
+    restoreOutputBuffer(); // the caller's stream must not be left pointing at a destroyed buffer
+    if (m_installedHotPaths) {
+        m_context.hotPathCounters = nullptr;
+    }
+}
+
+std::optional<OutputFingerprint> ConversionStatsScope::restoreOutputBuffer()
+{
+    if (!m_hashingBuf || !m_output) {
+        return std::nullopt;
+    }
+    OutputFingerprint fingerprint = m_hashingBuf->finish();
+    // rdbuf() resets the stream state, which a failed write has to keep
+    const auto state = m_output->rdstate();
+    m_output->rdbuf(m_hashingBuf->target());
+    m_output->clear(state);
+    m_hashingBuf.reset();
+    return fingerprint;
+}
+
+void ConversionStatsScope::writeFingerprintManifest(std::span<const OutputFingerprint> fingerprints) const
+{
+    // conversions running at once may share a manifest, so each appends its lines under one lock
+    static std::mutex manifestMutex;
+    std::lock_guard lock(manifestMutex);
+    std::ofstream manifest(m_fingerprintManifest, std::ios::binary | std::ios::app);
+    for (const auto& fingerprint : fingerprints) {
+        manifest << Xxh64::toHex(fingerprint.xxh64) << '\t' << fingerprint.bytes << '\t' << m_sourceName << '\t'
+                 << fingerprint.name << '\n';
+    }
+    if (!manifest && m_logCallback) {
+        m_logCallback(MessageSeverity::Warning, "Unable to write fingerprint manifest " + utils::pathToString(m_fingerprintManifest));
+    }
+}
+
+MultiOutputCallback ConversionStatsScope::countOutputs(const MultiOutputCallback& outputCallback) const
+{
+    ConversionResult* result = m_context.conversionResult;
+    if (!result) {
+        return outputCallback;
+    }
+    // the wrapper is only called during the converter call, while outputCallback is alive, so it is not copied
+    const auto count = [result, fingerprint = m_fingerprint](std::string_view suggestedName, std::span<const std::byte> data) {
+        ++result->stats().outputs;
+        result->stats().bytesWritten += data.size();
+        if (fingerprint) {
+            result->addOutputFingerprint({ std::string(suggestedName), Xxh64::hash(data), data.size() });
+        }
+    };
+    if (outputCallback.ownsOutput()) {
+        // keep the wrapper owning, so buffers the converter hands over still reach outputCallback without a copy
+        return [&outputCallback, &context = m_context, count](std::string_view suggestedName, std::string&& data) {
+            PhaseTimer deliveryTimer(context, ConversionStats::Phase::Serialize);
+            count(suggestedName, std::as_bytes(std::span<const char>(data.data(), data.size())));
+            outputCallback(suggestedName, std::move(data));
+        };
+    }
+    return [&outputCallback, &context = m_context, count](std::string_view suggestedName, std::span<const std::byte> data) {
+        PhaseTimer deliveryTimer(context, ConversionStats::Phase::Serialize);
+        count(suggestedName, data);
+        outputCallback(suggestedName, data);
+    };
+}
+
+IMultiOutputSink& ConversionStatsScope::countOutputs(IMultiOutputSink& sink)
+{
+    if (!m_context.conversionResult) {
+        return sink;
+    }
+    m_countingSink = std::make_unique<CountingOutputSink>(sink, m_context, m_fingerprint);
+    return *m_countingSink;
+}
+
+void ConversionStatsScope::finish()
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    const auto streamFingerprint = restoreOutputBuffer();
+    m_timer.stop();
+    m_span.end();
+    if (m_traceRecorder && !m_traceRecorder->finish() && m_logCallback) {
+        m_logCallback(MessageSeverity::Warning, "Unable to write trace file " + utils::pathToString(m_traceRecorder->path()));
+    }
+    ConversionResult* result = m_context.conversionResult;
+    if (!result) {
+        return;
+    }
+    if (result->hasError() && m_context.cancellationRequested()) {
+        result->setCancelled(); // the error is the ConversionCancelled, or arrived while it was on its way
+    }
+    auto& stats = result->stats();
+    if (m_installedHotPaths) {
+        m_hotPaths.addTo(stats);
+    }
+    if (m_output && m_outputStart != std::streampos(-1)) {
+        if (const std::streampos outputEnd = m_output->tellp(); outputEnd != std::streampos(-1) && outputEnd >= m_outputStart) {
+            stats.bytesWritten += static_cast<std::uint64_t>(outputEnd - m_outputStart);
+            stats.outputs += result->hasError() ? 0 : 1;
+        }
+    }
+    if (streamFingerprint && !result->hasError()) {
+        result->addOutputFingerprint(*streamFingerprint);
+    }
+    if (!m_fingerprintManifest.empty() && !result->outputFingerprints().empty()) {
+        writeFingerprintManifest(result->outputFingerprints());
+    }
+    if (m_report != StatsReport::None && m_logCallback) {
+        m_logCallback(MessageSeverity::Info, m_report == StatsReport::Json ? stats.toJson() : "Conversion stats: " + stats.summary());
+    }
+}
+
+ClassificationCacheScope::ClassificationCacheScope(const musx::dom::DocumentPtr& document, const DenigmaContext& denigmaContext)
+    : m_context(denigmaContext)
+{
+    if (denigmaContext.conversionResult) {
+        m_cache = classify::detail::ClassificationCache::forDocument(document);
+        if (m_cache) {
+            m_start = m_cache->lookupCounts();
+        }
+    }
+}
+
+ClassificationCacheScope::~ClassificationCacheScope()
+{
+    if (m_cache && m_context.conversionResult) {
+        const auto end = m_cache->lookupCounts();
+        auto& stats = m_context.conversionResult->stats();
+        stats.cacheHits += end.hits - m_start.hits;
+        stats.cacheMisses += end.misses - m_start.misses;
+    }
+}
+
+void recordSourceCounts(std::span<const char> xml, const DenigmaContext& denigmaContext)
+{
+    if (!denigmaContext.conversionResult) {
+        return;
+    }
+    if (const auto header = enigma_binary::readHeader(xml)) {
+        // a binary cache carries the counts of the text it was encoded from
+        denigmaContext.conversionResult->stats().entries = header->entries;
+        denigmaContext.conversionResult->stats().notes = header->notes;
+        return;
+    }
+    // counted from the start tags, so the counts do not depend on which element families the reader keeps
+    const std::string_view text(xml.data(), xml.size());
+    std::uint64_t entries = 0;
+    std::uint64_t notes = 0;
+    for (std::size_t pos = text.find('<'); pos != std::string_view::npos; pos = text.find('<', pos + 1)) {
+        const std::string_view tag = text.substr(pos + 1, 6);
+        if (tag == "entry ") {
+            ++entries;
+        } else if (tag.starts_with("note ")) {
+            ++notes;
+        }
+    }
+    auto& stats = denigmaContext.conversionResult->stats();
+    stats.entries = entries;
+    stats.notes = notes;
+}
+
 bool DenigmaContext::validatePathsAndOptions(const std::filesystem::path& outputFilePath) const
 {
     if (inputFilePath == outputFilePath) {
@@ -388,7 +946,13 @@ bool DenigmaContext::validatePathsAndOptions(const std::filesystem::path& output
         return false;
     }
 
-    if (std::filesystem::exists(outputFilePath)) {
+    if (outputArchive) {
+        if (!outputArchive->reserve(outputFilePath)) {
+            logMessage(LogMsg() << utils::asUtf8Bytes(outputFilePath) << " is already in the output archive.", MessageSeverity::Warning);
+            return false;
+        }
+        logMessage(LogMsg() << "Output: " << utils::asUtf8Bytes(outputFilePath) << " (archive entry)");
+    } else if (std::filesystem::exists(outputFilePath)) {
         if (overwriteExisting) {
             logMessage(LogMsg() << "Overwriting " << utils::asUtf8Bytes(outputFilePath));
         } else {
@@ -399,9 +963,56 @@ bool DenigmaContext::validatePathsAndOptions(const std::filesystem::path& output
         logMessage(LogMsg() << "Output: " << utils::asUtf8Bytes(outputFilePath));
     }
 
+    if (outputsWritten) {
+        outputsWritten->push_back(outputFilePath);
+    }
+    if (outputValidated) {
+        outputValidated(outputFilePath);
+    }
+    return true;
+}
+
+bool SharedOutputFiles::append(const std::filesystem::path& path, std::string_view text, const DenigmaContext& denigmaContext)
+{
+    std::scoped_lock lock(m_mutex);
+    if (path.empty()) {
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+        std::cout.flush();
+        return true;
+    }
+    auto [it, inserted] = m_files.try_emplace(path);
+    if (inserted && denigmaContext.validatePathsAndOptions(path)) {
+        auto file = std::make_shared<std::ofstream>();
+        file->exceptions(std::ios::failbit | std::ios::badbit);
+        file->open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        it->second = std::move(file);
+    }
+    if (!it->second) {
+        return false;
+    }
+    it->second->write(text.data(), static_cast<std::streamsize>(text.size()));
+    it->second->flush();
     return true;
 }
 
+std::string DenigmaContext::outputOptionsFingerprint() const
+{
+    std::ostringstream result;
+    result << "parts=" << allPartsAndScore << ';' << (partName ? "=" + *partName : std::string()) << ";cue=" << cueLayer.value_or(0)
+        << ";validate=" << !noValidate
+        << ";massage=" << refloatRests << extendOttavasLeft << extendOttavasRight << fermataWholeRests
+        << ';' << (finaleFilePath ? utils::pathToString(*finaleFilePath) : std::string())
+        << ";mnx=" << indentSpaces.value_or(-1) << ',' << static_cast<int>(mnxEncoding) << ',' << includeTempoTool << mnxSplitInstruments
+        << ',' << (mnxSchemaPath ? utils::pathToString(*mnxSchemaPath) : std::string())
+        << ";musicxml=" << musicXmlStreamParts << musicXmlDedupeParts << compactXml
+        << ";musx=" << musxCompressionLevel
+        << ";svg=" << static_cast<int>(svgUnit) << ',' << svgUsePageScale << ',' << svgScale << ',' << svgSpriteSheet << ',';
+    for (const auto shapeDef : svgShapeDefs) {
+        result << shapeDef << ' ';
+    }
+    return result.str();
+}
+
 /** returns true if input path is a directory */
 bool createDirectoryIfNeeded(const std::filesystem::path& path)
 {
@@ -440,13 +1051,7 @@ void DenigmaContext::startLogging(const std::filesystem::path& defaultLogPath, i
             std::string logFileName = programName + "-" + getTimeStamp("%Y%m%d-%H%M%S") + ".log";
             path /= logFileName;
         }
-        bool appending = std::filesystem::is_regular_file(path);
-        logFile = std::make_shared<std::ofstream>();
-        logFile->exceptions(std::ios::failbit | std::ios::badbit);
-        logFile->open(path, std::ios::app);
-        if (appending) {
-            *logFile << std::endl;
-        }
+        logFile = std::make_shared<LogFileWriter>(path);
         logMessage(LogMsg() << "======= START =======", true);
         logMessage(LogMsg() << programName << " executed with the following arguments:", true);
         LogMsg args;
@@ -465,10 +1070,55 @@ void DenigmaContext::endLogging()
         logMessage(LogMsg(), true);
         logMessage(LogMsg() << programName << " processing complete", true);
         logMessage(LogMsg() << "======== END ========", true);
-        logFile.reset();
+        if (logFile) {
+            logFile->close(); // worker copies of the context may still share it
+            logFile.reset();
+        }
+    }
+}
+
+void DenigmaContext::replayBufferedLog(const std::vector<BufferedLogMessage>& messages)
+{
+    const auto savedInputFilePath = inputFilePath;
+    for (const auto& message : messages) {
+        inputFilePath = message.inputFilePath;
+        // verbosity filtering was already applied when the message was captured
+        logMessage(LogMsg() << message.text, true, message.severity);
+    }
+    inputFilePath = savedInputFilePath;
+}
+
+void ICommand::processOutputs(CommandInputData& inputData, std::span<const OutputTarget> outputs, const std::filesystem::path& inputPath, DenigmaContext& denigmaContext) const
+{
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        denigmaContext.outputIsFilename = outputs[i].outputIsFilename;
+        if (i + 1 < outputs.size()) {
+            processOutput(inputData, outputs[i].path, inputPath, denigmaContext);
+            continue;
+        }
+        // Nothing reads the XML after the last output builds its DOM, so the reader may take the buffer (or mapping)
+        // over and free it then, instead of it staying alive beside the DOM and the output for the whole conversion.
+        MusxReaderBufferHandoff xmlHandoff(inputData);
+        processOutput(inputData, outputs[i].path, inputPath, denigmaContext);
     }
 }
 
+DenigmaContext::PrefetchedInput DenigmaContext::readAhead(const std::shared_ptr<ICommand>& currentCommand, const std::filesystem::path& inpFilePath) const
+{
+    PrefetchedInput result;
+    DenigmaContext readContext(*this);
+    readContext.logBuffer = &result.log;
+    readContext.inputFilePath = inpFilePath;
+    try {
+        if (std::filesystem::is_regular_file(inpFilePath) || forTestOutput()) { // else processFile reports it
+            result.data = currentCommand->processInput(inpFilePath, readContext);
+        }
+    } catch (...) {
+        result.error = std::current_exception();
+    }
+    return result;
+}
+
 void DenigmaContext::processFile(const std::shared_ptr<ICommand>& currentCommand, const std::filesystem::path inpFilePath, const std::vector<const arg_char*>& args)
 {
     try {
@@ -490,7 +1140,16 @@ void DenigmaContext::processFile(const std::shared_ptr<ICommand>& currentCommand
         logMessage(LogMsg() << delimiter, true);
         this->inputFilePath = inpFilePath; // assign after logging the header
 
-        const auto inputData = currentCommand->processInput(inputFilePath, *this);
+        auto inputData = [&]() {
+            if (auto* prefetched = std::exchange(prefetchedInput, nullptr)) {
+                replayBufferedLog(prefetched->log);
+                if (prefetched->error) {
+                    std::rethrow_exception(prefetched->error);
+                }
+                return std::move(prefetched->data);
+            }
+            return currentCommand->processInput(inputFilePath, *this);
+        }();
 
         auto calcOutpuFilePath = [&](const std::filesystem::path& path, std::u8string_view format) -> std::filesystem::path {
             std::filesystem::path retval = path;
@@ -499,7 +1158,9 @@ void DenigmaContext::processFile(const std::shared_ptr<ICommand>& currentCommand
             }
             if (createDirectoryIfNeeded(retval)) {
                 outputIsFilename = false;
-                std::filesystem::path outputFileName = inputFilePath.filename();
+                std::filesystem::path outputFileName = isCompressedEnigmaXml(inputFilePath)
+                                                     ? inputFilePath.stem().filename() // drop the compression suffix too
+                                                     : inputFilePath.filename();
                 outputFileName.replace_extension(format);
                 retval = retval / outputFileName;
             } else {
@@ -509,7 +1170,12 @@ void DenigmaContext::processFile(const std::shared_ptr<ICommand>& currentCommand
         };
 
         // Process output options
-        bool outputFormatSpecified = false;
+        struct OutputRequest
+        {
+            std::filesystem::path path;
+            std::u8string format;
+        };
+        std::vector<OutputRequest> outputRequests;
         for (size_t i = 0; i < args.size(); ++i) {
             arg_string option = args[i];
             if (option.rfind(_ARG("--"), 0) == 0) {  // Options start with "--"
@@ -517,18 +1183,30 @@ void DenigmaContext::processFile(const std::shared_ptr<ICommand>& currentCommand
                 std::filesystem::path outputFilePath = (i + 1 < args.size() && arg_string(args[i + 1]).rfind(_ARG("--"), 0) != 0)
                                                      ? std::filesystem::path(args[++i])
                                                      : inputFilePath.parent_path();
-                currentCommand->processOutput(inputData, calcOutpuFilePath(outputFilePath, outputFormat), inputFilePath, *this);
-                outputFormatSpecified = true;
+                outputRequests.push_back({ std::move(outputFilePath), outputFormat });
             }
         }
-        if (!outputFormatSpecified) {
-            const auto& defaultFormat = currentCommand->defaultOutputFormat(inputFilePath);
-            if (defaultFormat.has_value()) {
-                currentCommand->processOutput(inputData, calcOutpuFilePath(inputFilePath.parent_path(), defaultFormat.value()), inputFilePath, *this);
+        if (outputRequests.empty()) {
+            if (const auto defaultFormat = currentCommand->defaultOutputFormat(inputFilePath)) {
+                outputRequests.push_back({ inputFilePath.parent_path(), *defaultFormat });
             }
         }
+        std::vector<ICommand::OutputTarget> outputTargets;
+        outputTargets.reserve(outputRequests.size());
+        for (const auto& request : outputRequests) {
+            auto outputPath = calcOutpuFilePath(request.path, request.format);
+            outputTargets.push_back({ std::move(outputPath), outputIsFilename });
+        }
+        currentCommand->processOutputs(inputData, outputTargets, inputFilePath, *this);
     } catch (const musx::xml::load_error& ex) {
         logMessage(LogMsg() << "Load XML failed: " << ex.what(), true, MessageSeverity::Error);
+    } catch (const ConversionCancelled& ex) {
+        if (fileTimeoutSeconds && deadline && std::chrono::steady_clock::now() >= *deadline) {
+            logMessage(LogMsg() << "conversion did not finish within the file timeout of " << fileTimeoutSeconds
+                << " seconds, so it was cancelled", true, MessageSeverity::Error);
+        } else {
+            logMessage(LogMsg() << ex.what(), true, MessageSeverity::Error);
+        }
     } catch (const std::exception& e) {
         logMessage(LogMsg() << e.what(), true, MessageSeverity::Error);
     }
@@ -24,25 +24,45 @@
 #include <string>
 #include <sstream>
 #include <array>
+#include <concepts>
+#include <chrono>
 #include <vector>
 #include <optional>
 #include <fstream>
+#include <exception>
 #include <functional>
 #include <cassert>
 #include <utility>
-
+#include <memory>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+
+#include "classify/classification_cache.h"
+#include "core/hot_path_counters.h"
+#include "core/log_writer.h"
+#include "core/mapped_input_file.h"
+#include "core/output_file.h"
+#include "core/trace.h"
 #include "denigma/conversion.h"
+#include "denigma/formats/mnx.h"
 #include "musx/musx.h"
 #include "utils/stringutils.h"
 
 constexpr char8_t MUSX_EXTENSION[]      = u8"musx";
 constexpr char8_t ENIGMAXML_EXTENSION[] = u8"enigmaxml";
+constexpr char8_t ENIGMABIN_EXTENSION[] = u8"enigmabin";
 constexpr char8_t MNX_EXTENSION[]       = u8"mnx";
 constexpr char8_t JSON_EXTENSION[]      = u8"json";
 constexpr char8_t MSS_EXTENSION[]       = u8"mss";
 constexpr char8_t SVG_EXTENSION[]       = u8"svg";
 constexpr char8_t MXL_EXTENSION[]       = u8"mxl";
 constexpr char8_t MUSICXML_EXTENSION[]  = u8"musicxml";
+constexpr char8_t JSONL_EXTENSION[]     = u8"jsonl";
 
 constexpr int JSON_INDENT_SPACES     = 4;
 
@@ -113,17 +133,132 @@ using LogMsg = std::stringstream;
 
 struct CommandInputData
 {
+    /// @brief An embedded graphic from a musx archive, kept compressed until it is inflated.
     struct EmbeddedGraphicFile
     {
         std::string filename;
-        std::string blob;
+        std::size_t size{};                                     ///< inflated size in bytes
+        std::function<void(std::span<std::byte>)> inflateInto; ///< writes the #size bytes of the graphic; throws if corrupt
+
+        /// @brief Inflates the graphic into a new string.
+        std::string blob() const
+        {
+            std::string result(size, '\0');
+            if (inflateInto) {
+                inflateInto(std::as_writable_bytes(std::span<char>(result.data(), result.size())));
+            }
+            return result;
+        }
     };
 
     Buffer primaryBuffer;
     std::optional<Buffer> notationMetadata;
     std::vector<EmbeddedGraphicFile> embeddedGraphics;
+    std::span<const char> borrowedPrimaryBuffer; ///< caller-owned XML used instead of primaryBuffer when non-empty
+    std::shared_ptr<MappedInputFile> mappedPrimaryBuffer; ///< a mapped input file used instead of primaryBuffer when set
+
+    /// @brief Returns the primary XML, whether owned, mapped or borrowed.
+    std::span<const char> primaryXml() const
+    {
+        if (mappedPrimaryBuffer) {
+            return mappedPrimaryBuffer->data();
+        }
+        if (!borrowedPrimaryBuffer.empty()) {
+            return borrowedPrimaryBuffer;
+        }
+        return { primaryBuffer.data(), primaryBuffer.size() };
+    }
+
+    /// @brief Moves out the primary XML as an owned buffer, copying it if it is mapped or borrowed.
+    Buffer takePrimaryBuffer()
+    {
+        if (mappedPrimaryBuffer || !borrowedPrimaryBuffer.empty()) {
+            const auto xml = primaryXml();
+            return Buffer(xml.begin(), xml.end());
+        }
+        return std::exchange(primaryBuffer, Buffer{});
+    }
+
+    /// @brief Creates input data that borrows the caller's bytes. They must outlive every use of the result.
+    static CommandInputData fromBorrowedBytes(std::span<const std::byte> bytes)
+    {
+        CommandInputData retval;
+        retval.borrowedPrimaryBuffer = { reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+        return retval;
+    }
+};
+
+/**
+ * @class MusxReaderBufferHandoff
+ * @brief Lets the next MusxReader on this thread take over an owned XML buffer instead of copying it.
+ *
+ * The reader parses the buffer in place, which rewrites it, so the buffer is left empty once a document
+ * has been created from it. Only hand off a buffer that nothing reads after the document is built.
+ * Offering input data also offers its mapped input file, which the reader then parses in place in the mapping.
+ */
+class MusxReaderBufferHandoff
+{
+public:
+    explicit MusxReaderBufferHandoff(Buffer& buffer) : m_previous(std::exchange(current(), Offer{ &buffer, nullptr })) {}
+    explicit MusxReaderBufferHandoff(CommandInputData& inputData)
+        : m_previous(std::exchange(current(), Offer{ &inputData.primaryBuffer, &inputData.mappedPrimaryBuffer })) {}
+    ~MusxReaderBufferHandoff() { current() = m_previous; }
+
+    MusxReaderBufferHandoff(const MusxReaderBufferHandoff&) = delete;
+    MusxReaderBufferHandoff& operator=(const MusxReaderBufferHandoff&) = delete;
+
+    /// Moves out the offered buffer if it is the one holding data, or returns std::nullopt.
+    static std::optional<Buffer> take(const char* data, std::size_t size)
+    {
+        Buffer* offered = current().buffer;
+        if (!offered || offered->data() != data || offered->size() != size) {
+            return std::nullopt;
+        }
+        current() = {};
+        return std::exchange(*offered, Buffer{});
+    }
+
+    /// Moves out the offered mapped input file if it is the one holding data, or returns nullptr.
+    static std::shared_ptr<MappedInputFile> takeMapping(const char* data, std::size_t size)
+    {
+        std::shared_ptr<MappedInputFile>* offered = current().mapping;
+        if (!offered || !*offered || (*offered)->data().data() != data || (*offered)->data().size() != size) {
+            return nullptr;
+        }
+        current() = {};
+        return std::exchange(*offered, nullptr);
+    }
+
+private:
+    struct Offer
+    {
+        Buffer* buffer{};
+        std::shared_ptr<MappedInputFile>* mapping{};
+    };
+
+    static Offer& current()
+    {
+        thread_local Offer offered;
+        return offered;
+    }
+
+    Offer m_previous;
 };
 
+/// Returns true if path is EnigmaXML with a gzip or zstd suffix, such as `score.enigmaxml.zst`.
+inline bool isCompressedEnigmaXml(const std::filesystem::path& path)
+{
+    const auto extension = utils::normalizedPathExtension(path);
+    return (extension == u8"gz" || extension == u8"zst") && utils::pathExtensionEquals(path.stem(), ENIGMAXML_EXTENSION);
+}
+
+/// Returns the extension (with its dot) that names the format of path, looking through the compression suffix of
+/// compressed EnigmaXML. Any other compressed file keeps its compression suffix, which names no format.
+inline std::u8string formatExtension(const std::filesystem::path& path)
+{
+    return isCompressedEnigmaXml(path) ? path.stem().extension().u8string() : path.extension().u8string();
+}
+
 // Function to find the appropriate processor
 template <typename Processors>
 inline decltype(Processors::value_type::processor) findProcessor(const Processors& processors, std::u8string_view extension)
@@ -137,6 +272,13 @@ inline decltype(Processors::value_type::processor) findProcessor(const Processor
     throw std::invalid_argument("Unsupported format: " + utils::utf8ToString(key));
 }
 
+/// How a batch input that duplicates one already converted gets its outputs (see `--dedupe`).
+enum class DuplicateOutputs
+{
+    Copy,       ///< copies of the original's outputs
+    HardLink    ///< hard links to the original's outputs, or copies where a link cannot be made
+};
+
 enum class MusicProgramPreset
 {
     Unspecified,
@@ -154,10 +296,59 @@ inline MusicProgramPreset toMusicProgramPreset(const std::string& inp)
     return MusicProgramPreset::Unspecified;
 }
 
+class ArenaHighWater;
 class ICommand;
+struct DenigmaContext;
+
+/**
+ * @class SharedOutputFiles
+ * @brief Output files that every input of a run appends records to, such as the `info` command's JSON Lines file.
+ *
+ * A file is validated and truncated the first time the run writes to it and appended to after that. The context
+ * copies made for batch workers share one instance, so each record from concurrent jobs is written whole.
+ */
+class SharedOutputFiles
+{
+public:
+    /// Appends text to path (standard output if path is empty), opening the file on first use.
+    /// @return false if the file failed validation, now or when it was first used.
+    bool append(const std::filesystem::path& path, std::string_view text, const DenigmaContext& denigmaContext);
+
+private:
+    std::mutex m_mutex;
+    std::map<std::filesystem::path, std::shared_ptr<std::ofstream>> m_files; ///< null for a file that failed validation
+};
+
+/// @brief Thrown at a cancellation check once the conversion's CommonOptions::cancellation or deadline has tripped.
+class ConversionCancelled : public std::runtime_error
+{
+public:
+    explicit ConversionCancelled(bool deadlineExceeded)
+        : std::runtime_error(deadlineExceeded ? "conversion deadline exceeded" : "conversion cancelled")
+    {
+    }
+};
+
 struct DenigmaContext
 {
 public:
+    /// @brief A log message captured while processing a file on a batch worker, replayed later in input order.
+    struct BufferedLogMessage
+    {
+        MessageSeverity severity{};
+        std::string text;
+        std::filesystem::path inputFilePath;
+    };
+
+    /// @brief An input read (and inflated) by a batch read stage ahead of its conversion, with the messages and any
+    /// error the read produced. #processFile replays both as if it had read the input itself.
+    struct PrefetchedInput
+    {
+        CommandInputData data;
+        std::vector<BufferedLogMessage> log;
+        std::exception_ptr error;
+    };
+
     DenigmaContext(const arg_string& progName)
         : programName(std::string(progName))
     {
@@ -177,14 +368,46 @@ public:
     bool verbose{};
     bool quiet{};
     bool noValidate{};
+    bool validateConcurrently{}; ///< validate on a worker thread while the output is written
+    unsigned validateEvery{ 1 }; ///< validate only 1 in this many conversions in the process (0 and 1 mean every one)
+    unsigned jobs{ 1 };     ///< number of files to process concurrently (0 means use all available cores)
+    std::optional<unsigned> isolateTimeoutSeconds; ///< when set, batch inputs are converted in worker processes, each stopped after this many seconds (0 means no limit)
+    unsigned fileTimeoutSeconds{}; ///< batch inputs still converting after this many seconds are cancelled and logged as errors (0 means no limit)
+    std::optional<unsigned> prefetchDepth; ///< when set, serial batch runs read up to this many inputs ahead of the one converting
+    std::optional<unsigned> pipelineReadJobs; ///< when set, batch inputs are read by this many threads ahead of the converting workers
+    std::optional<DuplicateOutputs> dedupeInputs; ///< when set, batch inputs identical to one already converted get its outputs instead of a conversion
+    std::uint64_t memoryBudget{}; ///< batch runs start a file only while the estimated memory of the files in progress fits this many bytes, and MusicXML streams its parts when one file's would not (0 means unlimited)
+    unsigned outputJobs{ 1 }; ///< number of outputs of one file (score/parts, shapes, measure ranges, MNX parts) to build concurrently (0 means use all available cores)
+    IExecutor* executor{};  ///< when set, concurrent work runs as tasks here instead of on threads of its own (see CommonOptions::executor)
+    std::optional<CancellationToken> cancellation; ///< when set, #checkCancelled throws once it is cancelled
+    std::optional<std::chrono::steady_clock::time_point> deadline; ///< when set, #checkCancelled throws once it has passed
+    TextMetricsMode textMetrics{ TextMetricsMode::Fonts }; ///< whether text is measured with the installed fonts or estimated
     std::optional<int> cueLayer;
     std::optional<std::filesystem::path> excludeFolder;
     std::optional<std::string> partName;
     std::optional<std::filesystem::path> logFilePath;
-    std::shared_ptr<std::ofstream> logFile;
+    std::optional<std::filesystem::path> xmlCacheDir; ///< when set, EnigmaXML inflated from musx is cached here, keyed by score.dat
+    std::optional<std::filesystem::path> traceFilePath; ///< when set, the run's trace spans are written here in Chrome trace format
+    std::optional<SlowFileThreshold> slowTraceThreshold; ///< when set, batch inputs slower than this are converted again with tracing
+    std::optional<std::filesystem::path> fingerprintManifestPath; ///< when set, the XXH64 fingerprint of every output is appended here
+    std::optional<std::filesystem::path> incrementalManifestPath; ///< when set, inputs unchanged since the run recorded here are skipped (empty means the default name)
+    std::shared_ptr<LogFileWriter> logFile; ///< the open log file, shared by the worker copies of the context
     std::filesystem::path inputFilePath;
     std::function<void(MessageSeverity severity, std::string_view message)> logCallback;
     ConversionResult* conversionResult{};
+    std::vector<BufferedLogMessage>* logBuffer{}; ///< when set, messages are captured here instead of being written out
+    PrefetchedInput* prefetchedInput{}; ///< when set, #processFile converts this input instead of reading it, and clears the pointer
+    std::vector<std::filesystem::path>* outputsWritten{}; ///< when set, every output path that passes validation is appended here
+    std::function<void(const std::filesystem::path& outputPath)> outputValidated; ///< when set, called with every output path that passes validation, before it is written
+    std::pmr::memory_resource* memoryResource{}; ///< upstream for converter mapping arenas (nullptr means the default resource)
+    mutable ArenaHighWater* arenaHighWater{}; ///< when set, every mapping arena counts the blocks it holds here (see ArenaHighWaterScope)
+    mutable HotPathCounters* hotPathCounters{}; ///< when set, the conversion's slow-path counts go here, shared by the worker copies (see ConversionStatsScope)
+    std::shared_ptr<SharedOutputFiles> sharedOutputFiles{ std::make_shared<SharedOutputFiles>() }; ///< files all inputs of this run append to
+    std::optional<std::filesystem::path> outputArchivePath; ///< when set, the export command writes every output into this zip archive
+    std::uint64_t outputArchiveShardBytes{}; ///< start a new archive shard once one holds this many bytes (0 means one archive)
+    std::shared_ptr<OutputArchive> outputArchive; ///< when set, outputs become entries here instead of files, shared by the worker copies of the context
+    std::optional<std::size_t> writeBehindBytes; ///< when set, the CLI writes outputs from a background thread, queuing at most this many bytes
+    std::shared_ptr<OutputWriter> outputWriter; ///< when set, output files are queued here instead of written by the converting thread
 
     // Specific options for `massage` command
     bool refloatRests{ true };
@@ -195,16 +418,32 @@ public:
 
     // Specific options for `export --mnx` command
     std::optional<int> indentSpaces{ JSON_INDENT_SPACES };
+    formats::mnx::Encoding mnxEncoding{ formats::mnx::Encoding::Json };
     std::optional<std::filesystem::path> mnxSchemaPath;
     std::optional<std::string> mnxSchema;
     bool includeTempoTool{};
     bool mnxSplitInstruments{};
 
+    // Specific options for `export --mnx` and `export --musicxml` commands
+    std::optional<MeasureRange> measureRange; ///< when set, only these measures are converted (see ConversionExcerpt)
+    std::vector<int> staffFilter;             ///< when not empty, only the staves at these 1-based score positions are converted
+
+    // Specific options for `export --musicxml` command
+    bool musicXmlStreamParts{}; ///< build, write and release one MusicXML part at a time
+    bool musicXmlDedupeParts{}; ///< convert linked parts with identical conversion inputs once and reuse the result
+
+    // Specific options for `export --musicxml` and `export --enigmaxml` commands
+    bool compactXml{}; ///< leave the indentation between elements out of written XML (`--no-pretty-print`)
+
+    // Specific options for `export --musx` command
+    int musxCompressionLevel{ -1 }; ///< zlib level (0-9) for score.dat, or -1 for zlib's default
+
     // Specific options for `export --svg` command
     std::vector<musx::dom::Cmper> svgShapeDefs;
     musx::util::SvgConvert::SvgUnit svgUnit{ musx::util::SvgConvert::SvgUnit::Points };
     bool svgUsePageScale{ false };
     double svgScale{ 1.0 };
+    bool svgSpriteSheet{};  ///< write all shapes to one SVG of symbols that share repeated drawing elements
 
     bool testOutput{}; // this may be defined on the command line by the test program
 
@@ -222,6 +461,13 @@ public:
     // validate paths
     bool validatePathsAndOptions(const std::filesystem::path& outputFilePath) const;
 
+    /// Describes every general and command option that changes what a conversion writes, for incremental batch runs.
+    std::string outputOptionsFingerprint() const;
+
+    /// Reads the input at inpFilePath the way #processFile would, on a copy of this context whose messages are captured,
+    /// so that a batch read stage can do it while another file converts. Never throws; the error is returned instead.
+    PrefetchedInput readAhead(const std::shared_ptr<ICommand>& currentCommand, const std::filesystem::path& inpFilePath) const;
+
     void processFile(const std::shared_ptr<ICommand>& currentCommand, const std::filesystem::path inpFilePath, const std::vector<const arg_char*>& args);
 
     // Logging methods
@@ -237,8 +483,75 @@ public:
         logMessage(std::move(msg), false, severity);
     }
 
+    /**
+     * @brief logs the message that format writes into the LogMsg it is passed, calling it only if the message is shown
+     *
+     * Use this form where the message is costly to build or is logged in a loop, so that a suppressed severity
+     * costs a branch: `logMessage([&](LogMsg& msg) { msg << "considered " << name; }, MessageSeverity::Verbose)`.
+     */
+    template <typename Format>
+        requires std::invocable<Format&, LogMsg&>
+    void logMessage(Format&& format, MessageSeverity severity = MessageSeverity::Info) const
+    {
+        if (shouldLog(severity)) {
+            LogMsg msg;
+            format(msg);
+            logMessage(std::move(msg), true, severity);
+        }
+    }
+
+    /// Returns whether messages of severity are shown with the current verbose and quiet settings.
+    bool shouldLog(MessageSeverity severity) const
+    {
+        switch (severity) {
+        case MessageSeverity::Verbose: return verbose && !quiet;
+        case MessageSeverity::Info: return !quiet;
+        default: return true;
+        }
+    }
+
+    /// Returns true once #cancellation has been cancelled or #deadline has passed.
+    bool cancellationRequested() const
+    {
+        return (cancellation && cancellation->isCancelled())
+            || (deadline && std::chrono::steady_clock::now() >= *deadline);
+    }
+
+    /// @brief Throws ConversionCancelled if #cancellation has been cancelled or #deadline has passed.
+    ///
+    /// Converters call it between units of work (measures, parts, shapes, archive entries), so a tripped conversion
+    /// unwinds through the same path as a failed one and ends with an error in its ConversionResult.
+    void checkCancelled() const
+    {
+        if (cancellation && cancellation->isCancelled()) {
+            throw ConversionCancelled(false);
+        }
+        if (deadline && std::chrono::steady_clock::now() >= *deadline) {
+            throw ConversionCancelled(true);
+        }
+    }
+
+    /// Counts path against this context's conversion, if it is being counted.
+    void countHotPath(ConversionStats::HotPath path) const noexcept
+    {
+        if (hotPathCounters) {
+            hotPathCounters->count(path);
+        }
+    }
+
     void endLogging(); ///< Ends logging if logging was requested
 
+    /// @brief Writes out messages captured by a batch worker's context as if they had been logged here.
+    void replayBufferedLog(const std::vector<BufferedLogMessage>& messages);
+
+    /// @brief Logs messages that a worker copy of this context captured for the same input, without filtering them again.
+    void logCapturedMessages(const std::vector<BufferedLogMessage>& messages) const
+    {
+        for (const auto& message : messages) {
+            logMessage(LogMsg() << message.text, true, message.severity);
+        }
+    }
+
     bool forTestOutput() const
     {
         return testOutput;
@@ -252,7 +565,11 @@ private:
 musx::util::Logger::LogCallback makeMusxLogCallback(const DenigmaContext& denigmaContext);
 
 /// @class MusxLoggerScope
-/// @brief Installs a musx logging callback for the lifetime of the scope and restores the previous one on exit.
+/// @brief Sends the musx messages logged on the calling thread to a callback for the lifetime of the scope.
+///
+/// Scopes on one thread nest, and the innermost receives the messages. Routing is per thread, so concurrent
+/// conversions each get their own messages, and logging takes no lock. Messages from a thread with no scope go to
+/// the callback musx had before the first scope opened.
 class MusxLoggerScope
 {
 public:
@@ -265,6 +582,130 @@ public:
     MusxLoggerScope& operator=(MusxLoggerScope&&) = delete;
 };
 
+/**
+ * @class PhaseTimer
+ * @brief Charges the wall time of a scope to one phase of the ConversionStats of the context's conversion result.
+ *
+ * Timers nest: a running timer pauses the one it interrupted on the same thread until it stops, so each moment is
+ * charged to exactly one phase. A context without a conversion result (the CLI, or a batch or output worker's copy)
+ * times nothing. When allocations are counted (see allocation_stats.h), the thread's heap use is charged the same way.
+ */
+class PhaseTimer
+{
+public:
+    PhaseTimer(const DenigmaContext& denigmaContext, ConversionStats::Phase phase);
+    ~PhaseTimer() { stop(); }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    /// Charges the time so far and resumes the interrupted timer. Only the innermost running timer may be stopped.
+    void stop();
+
+private:
+    /// Starts a stretch of the phase at now.
+    void resume(std::chrono::steady_clock::time_point now);
+    /// Charges the stretch that started at the last resume.
+    void charge(std::chrono::steady_clock::time_point now);
+
+    ConversionStats* m_stats{};
+    ConversionStats::Phase m_phase;
+    PhaseTimer* m_interrupted{};
+    std::chrono::steady_clock::time_point m_start;
+    std::uint64_t m_allocatedAtStart{};
+    std::int64_t m_liveAtStart{};
+    bool m_running{};
+};
+
+class HashingStreamBuf;
+
+/**
+ * @class ConversionStatsScope
+ * @brief Collects the ConversionStats of one public converter call and reports them as its CommonOptions ask.
+ *
+ * It times the whole call as ConversionStats::Phase::Convert, less what nested PhaseTimers claim, and counts the
+ * outputs that pass through #countOutputs or the stream it was given. Call #finish before returning the result, so
+ * that the stats are complete in the returned copy.
+ *
+ * It also records the call as a trace span tagged with CommonOptions::sourceName, and writes the trace file that
+ * CommonOptions::traceFile asks for unless a trace of the whole process is already being recorded.
+ *
+ * When CommonOptions::fingerprintOutputs asks for it, the same wrappers hash each output as it passes, and the output
+ * stream is hashed through a buffer installed on it until #finish.
+ *
+ * Unless an enclosing call already counts them, it installs the HotPathCounters of the call on the context and binds
+ * them to the calling thread; #finish adds their counts to the stats.
+ */
+class ConversionStatsScope
+{
+public:
+    /// @param output the stream a single-output converter writes to; its bytes are measured with tellp when seekable.
+    ConversionStatsScope(const DenigmaContext& denigmaContext, const CommonOptions& options, std::ostream* output = nullptr);
+    ~ConversionStatsScope();
+
+    ConversionStatsScope(const ConversionStatsScope&) = delete;
+    ConversionStatsScope& operator=(const ConversionStatsScope&) = delete;
+
+    /// Returns outputCallback wrapped so that each output and its bytes are counted.
+    MultiOutputCallback countOutputs(const MultiOutputCallback& outputCallback) const;
+    /// Returns a sink that counts each output and its bytes and forwards them to sink.
+    IMultiOutputSink& countOutputs(IMultiOutputSink& sink);
+
+    /// Stops timing, records the stream output, marks a failed result ConversionResult::cancelled when its
+    /// cancellation tripped, sends the report requested by CommonOptions::statsReport, writes the trace file and
+    /// appends the output fingerprints to CommonOptions::fingerprintManifest.
+    void finish();
+
+private:
+    /// Passes on what the hashing buffer still holds and puts the output stream's own buffer back.
+    /// @return the fingerprint of the stream output, if it was being hashed.
+    std::optional<OutputFingerprint> restoreOutputBuffer();
+    void writeFingerprintManifest(std::span<const OutputFingerprint> fingerprints) const;
+
+    const DenigmaContext& m_context;
+    StatsReport m_report;
+    std::function<void(MessageSeverity severity, std::string_view message)> m_logCallback;
+    bool m_fingerprint{};
+    std::filesystem::path m_fingerprintManifest;
+    std::string m_sourceName;
+    std::ostream* m_output{};
+    std::streampos m_outputStart{ -1 };
+    std::unique_ptr<HashingStreamBuf> m_hashingBuf; ///< installed on m_output while fingerprinting
+    std::unique_ptr<IMultiOutputSink> m_countingSink;
+    std::unique_ptr<TraceRecorder> m_traceRecorder; ///< set when CommonOptions::traceFile asks for a trace
+    TraceFileScope m_traceFile;
+    TraceSpan m_span;
+    PhaseTimer m_timer;
+    HotPathCounters m_hotPaths;
+    bool m_installedHotPaths{};     ///< true when m_hotPaths is the context's counter
+    HotPathThreadScope m_hotPathThread;
+    bool m_finished{};
+};
+
+/**
+ * @class ClassificationCacheScope
+ * @brief Adds the classification-cache lookups made for a document during the scope to the context's ConversionStats.
+ *
+ * The counts belong to the document, so concurrent conversions of one prepared document also count each other's.
+ */
+class ClassificationCacheScope
+{
+public:
+    ClassificationCacheScope(const musx::dom::DocumentPtr& document, const DenigmaContext& denigmaContext);
+    ~ClassificationCacheScope();
+
+    ClassificationCacheScope(const ClassificationCacheScope&) = delete;
+    ClassificationCacheScope& operator=(const ClassificationCacheScope&) = delete;
+
+private:
+    const DenigmaContext& m_context;
+    std::shared_ptr<classify::detail::ClassificationCache> m_cache;
+    classify::detail::ClassificationCache::LookupCounts m_start;
+};
+
+/// @brief Records the entry and note counts of the Enigma XML about to be parsed in the context's conversion result.
+void recordSourceCounts(std::span<const char> xml, const DenigmaContext& denigmaContext);
+
 class ICommand
 {
 public:
@@ -276,6 +717,17 @@ public:
     virtual bool canProcess(const std::filesystem::path& inputPath) const = 0;
     virtual CommandInputData processInput(const std::filesystem::path& inputPath, const DenigmaContext& denigmaContext) const = 0;
     virtual void processOutput(const CommandInputData& inputData, const std::filesystem::path& outputPath, const std::filesystem::path& inputPath, const DenigmaContext& denigmaContext) const = 0;
+
+    /// @brief One of the outputs requested for an input.
+    struct OutputTarget
+    {
+        std::filesystem::path path;
+        bool outputIsFilename{};    ///< the DenigmaContext::outputIsFilename that path was resolved with
+    };
+
+    /// @brief Produces every requested output of one input. The default produces them one after another with
+    /// #processOutput; a command may instead share the work they have in common.
+    virtual void processOutputs(CommandInputData& inputData, std::span<const OutputTarget> outputs, const std::filesystem::path& inputPath, DenigmaContext& denigmaContext) const;
     virtual std::optional<std::u8string_view> defaultInputFormat() const { return std::nullopt; }
     virtual std::optional<std::u8string> defaultOutputFormat(const std::filesystem::path&) const { return std::nullopt; }
 
@@ -293,15 +745,23 @@ template <typename Reader>
 musx::dom::DocumentPtr createMusxDocument(
     const CommandInputData& inputData,
     const DenigmaContext& denigmaContext,
-    musx::dom::PartVoicingPolicy partVoicingPolicy = musx::dom::PartVoicingPolicy::Ignore)
+    musx::dom::PartVoicingPolicy partVoicingPolicy = musx::dom::PartVoicingPolicy::Ignore,
+    bool withEmbeddedGraphics = true)
 {
+    denigmaContext.checkCancelled();
+    // Graphics are inflated straight into the DOM's buffers, and only for callers that render them.
     musx::factory::DocumentFactory::CreateOptions::EmbeddedGraphicFiles embeddedGraphicFiles;
-    embeddedGraphicFiles.reserve(inputData.embeddedGraphics.size());
-    for (const auto& graphic : inputData.embeddedGraphics) {
-        musx::factory::DocumentFactory::CreateOptions::EmbeddedGraphicFile file;
-        file.filename = graphic.filename;
-        file.bytes.assign(graphic.blob.begin(), graphic.blob.end());
-        embeddedGraphicFiles.emplace_back(std::move(file));
+    if (withEmbeddedGraphics) {
+        embeddedGraphicFiles.reserve(inputData.embeddedGraphics.size());
+        for (const auto& graphic : inputData.embeddedGraphics) {
+            musx::factory::DocumentFactory::CreateOptions::EmbeddedGraphicFile file;
+            file.filename = graphic.filename;
+            file.bytes.resize(graphic.size);
+            if (graphic.inflateInto) {
+                graphic.inflateInto(std::as_writable_bytes(std::span(file.bytes.data(), file.bytes.size())));
+            }
+            embeddedGraphicFiles.emplace_back(std::move(file));
+        }
     }
 
     musx::factory::DocumentFactory::CreateOptions createOptions(
@@ -310,7 +770,16 @@ musx::dom::DocumentPtr createMusxDocument(
         std::move(embeddedGraphicFiles),
         partVoicingPolicy);
 
-    return musx::factory::DocumentFactory::create<Reader>(inputData.primaryBuffer, std::move(createOptions));
+    const auto xml = inputData.primaryXml();
+    recordSourceCounts(xml, denigmaContext);
+    TraceSpan span("createMusxDocument");
+    PhaseTimer buildTimer(denigmaContext, ConversionStats::Phase::BuildDom);
+    auto document = musx::factory::DocumentFactory::create<Reader>(xml.data(), xml.size(), std::move(createOptions));
+    if (denigmaContext.conversionResult) {
+        denigmaContext.conversionResult->stats().measures =
+            document->getOthers()->getArray<musx::dom::others::Measure>(musx::dom::SCORE_PARTID).size();
+    }
+    return document;
 }
 
 template <typename T>
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/directory_walker.h"
+
+#include <algorithm>
+
+namespace denigma {
+
+DirectoryWalker::DirectoryWalker(unsigned threadCount)
+{
+    m_workers.reserve(threadCount);
+    for (unsigned x = 0; x < threadCount; x++) {
+        m_workers.emplace_back([this](std::stop_token stopToken) { workerLoop(stopToken); });
+    }
+}
+
+DirectoryWalker::~DirectoryWalker()
+{
+    for (auto& worker : m_workers) {
+        worker.request_stop();
+    }
+    m_queueChanged.notify_all();
+    m_workers.clear(); // joins
+}
+
+void DirectoryWalker::fill(Listing& listing) const
+{
+    try {
+        for (const auto& entry : std::filesystem::directory_iterator(listing.directory)) {
+            listing.entries.push_back(entry);
+        }
+        std::sort(listing.entries.begin(), listing.entries.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.path().filename() < rhs.path().filename();
+        });
+    } catch (...) {
+        listing.error = std::current_exception();
+    }
+}
+
+void DirectoryWalker::workerLoop(std::stop_token stopToken)
+{
+    while (true) {
+        ListingPtr listing;
+        {
+            std::unique_lock lock(m_mutex);
+            if (!m_queueChanged.wait(lock, stopToken, [&]() { return !m_queue.empty(); })) {
+                return;
+            }
+            listing = std::move(m_queue.front());
+            m_queue.pop_front();
+            if (listing->claimed) {
+                continue; // the walking thread got to it first
+            }
+            listing->claimed = true;
+        }
+        fill(*listing);
+        {
+            std::lock_guard lock(m_mutex);
+            listing->done = true;
+        }
+        m_listingDone.notify_all();
+    }
+}
+
+void DirectoryWalker::complete(const ListingPtr& listing)
+{
+    {
+        std::unique_lock lock(m_mutex);
+        if (listing->claimed) {
+            m_listingDone.wait(lock, [&]() { return listing->done; });
+            return;
+        }
+        listing->claimed = true;
+    }
+    fill(*listing);
+    std::lock_guard lock(m_mutex);
+    listing->done = true;
+}
+
+void DirectoryWalker::walk(const std::filesystem::path& directory, bool recursive, const std::optional<std::filesystem::path>& excludeFolder, const EntryFunc& onEntry)
+{
+    auto root = std::make_shared<Listing>();
+    root->directory = directory;
+    walkListing(root, recursive, excludeFolder, onEntry);
+}
+
+void DirectoryWalker::walkListing(const ListingPtr& listing, bool recursive, const std::optional<std::filesystem::path>& excludeFolder, const EntryFunc& onEntry)
+{
+    complete(listing);
+    if (listing->error) {
+        std::rethrow_exception(listing->error);
+    }
+
+    // one slot per entry, set for the subdirectories that are descended into
+    std::vector<ListingPtr> children(listing->entries.size());
+    bool hasChildren = false;
+    for (std::size_t index = 0; index < listing->entries.size(); index++) {
+        const auto& entry = listing->entries[index];
+        if (recursive && entry.is_directory() && !entry.is_symlink() && entry.path().filename() != excludeFolder) {
+            children[index] = std::make_shared<Listing>();
+            children[index]->directory = entry.path();
+            hasChildren = true;
+        }
+    }
+    if (hasChildren && !m_workers.empty()) {
+        {
+            std::lock_guard lock(m_mutex);
+            for (const auto& child : children) {
+                if (child) {
+                    m_queue.push_back(child);
+                }
+            }
+        }
+        m_queueChanged.notify_all();
+    }
+
+    for (std::size_t index = 0; index < listing->entries.size(); index++) {
+        onEntry(listing->entries[index]);
+        if (children[index]) {
+            walkListing(children[index], recursive, excludeFolder, onEntry);
+            children[index].reset();
+        }
+    }
+    listing->entries.clear();
+    listing->entries.shrink_to_fit();
+}
+
+} // namespace denigma
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace denigma {
+
+/**
+ * @class DirectoryWalker
+ * @brief Enumerates a directory tree in sorted path order while reading subdirectory listings ahead on worker threads.
+ *
+ * Entries are delivered on the calling thread, depth first with each directory's entries sorted, which is the same
+ * order as sorting every full path. As soon as a directory is listed, its subdirectories are queued for the workers,
+ * so a slow file system is read in parallel while the caller is still consuming earlier entries. When the caller
+ * reaches a directory no worker has started, it lists that directory itself rather than waiting in the queue.
+ * Like std::filesystem::recursive_directory_iterator, symlinked directories are not followed and an error listing
+ * any directory is thrown to the caller.
+ */
+class DirectoryWalker
+{
+public:
+    using EntryFunc = std::function<void(const std::filesystem::directory_entry& entry)>;
+
+    /// @param threadCount the number of listing threads (0 lists every directory on the calling thread).
+    explicit DirectoryWalker(unsigned threadCount);
+    ~DirectoryWalker();
+
+    DirectoryWalker(const DirectoryWalker&) = delete;
+    DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+
+    /// @brief Calls onEntry for every entry under directory, in sorted path order.
+    /// @param directory [in] the directory to enumerate.
+    /// @param recursive [in] descend into subdirectories.
+    /// @param excludeFolder [in] subdirectories with this file name are reported but not descended into.
+    /// @param onEntry [in] called on the calling thread for each file and directory found.
+    void walk(const std::filesystem::path& directory, bool recursive, const std::optional<std::filesystem::path>& excludeFolder, const EntryFunc& onEntry);
+
+private:
+    struct Listing
+    {
+        std::filesystem::path directory;
+        std::vector<std::filesystem::directory_entry> entries;
+        std::exception_ptr error;
+        bool claimed{};     ///< guarded by m_mutex
+        bool done{};        ///< guarded by m_mutex
+    };
+    using ListingPtr = std::shared_ptr<Listing>;
+
+    /// Lists and sorts listing's directory, unless another thread already claimed it, and then waits for it.
+    void complete(const ListingPtr& listing);
+    void fill(Listing& listing) const;
+    void workerLoop(std::stop_token stopToken);
+    void walkListing(const ListingPtr& listing, bool recursive, const std::optional<std::filesystem::path>& excludeFolder, const EntryFunc& onEntry);
+
+    std::mutex m_mutex;
+    std::condition_variable_any m_queueChanged;
+    std::condition_variable m_listingDone;
+    std::deque<ListingPtr> m_queue;
+    std::vector<std::jthread> m_workers;
+};
+
+} // namespace denigma
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/duplicate_inputs.h"
+
+#include "core/batch_manifest.h"
+
+namespace denigma {
+
+std::optional<DuplicateInputs::Original> DuplicateInputs::claim(const std::filesystem::path& inputPath, std::uint64_t quickKey)
+{
+    std::vector<std::shared_ptr<Group>> candidates;
+    {
+        std::lock_guard lock(m_mutex);
+        const auto [begin, end] = m_groups.equal_range(quickKey);
+        for (auto it = begin; it != end; ++it) {
+            candidates.push_back(it->second);
+        }
+        if (candidates.empty()) {
+            auto group = std::make_shared<Group>(Group{ inputPath });
+            m_converting.emplace(inputPath, group);
+            m_groups.emplace(quickKey, std::move(group));
+            return std::nullopt;
+        }
+    }
+
+    // the files are read without the lock held; a group's hash may be computed twice, but to the same value
+    const std::uint64_t contentHash = BatchManifest::hashFile(inputPath);
+    std::shared_ptr<Group> match;
+    for (const auto& group : candidates) {
+        std::optional<std::uint64_t> originalHash;
+        {
+            std::lock_guard lock(m_mutex);
+            originalHash = group->contentHash;
+        }
+        if (!originalHash) {
+            originalHash = BatchManifest::hashFile(group->original);
+            std::lock_guard lock(m_mutex);
+            group->contentHash = originalHash;
+        }
+        if (*originalHash == contentHash) {
+            match = group;
+            break;
+        }
+    }
+
+    std::unique_lock lock(m_mutex);
+    if (!match) {
+        auto group = std::make_shared<Group>(Group{ inputPath, contentHash });
+        m_converting.emplace(inputPath, group);
+        m_groups.emplace(quickKey, std::move(group));
+        return std::nullopt;
+    }
+    m_finished.wait(lock, [&]() { return match->done; });
+    if (!match->succeeded) {
+        return std::nullopt;
+    }
+    return Original{ match->original, match->outputs };
+}
+
+void DuplicateInputs::finish(const std::filesystem::path& inputPath, bool succeeded, std::vector<std::filesystem::path> outputs)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        const auto node = m_converting.extract(inputPath);
+        if (!node) {
+            return;
+        }
+        Group& group = *node.mapped();
+        group.done = true;
+        group.succeeded = succeeded;
+        group.outputs = std::move(outputs);
+    }
+    m_finished.notify_all();
+}
+
+} // namespace denigma
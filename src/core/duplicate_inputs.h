@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace denigma {
+
+/**
+ * @class DuplicateInputs
+ * @brief Finds batch inputs whose content is identical to an input already converted in the same run.
+ *
+ * Inputs are grouped by a quick key the caller computes cheaply (for musx, the file size and the CRC of score.dat
+ * from the zip directory). Only inputs that share a quick key are hashed in full, to confirm they really are copies.
+ * The first input of each content is its original: the caller converts it and reports the outputs with #finish.
+ * Methods may be called from several batch workers at once; a copy claimed while its original is still converting
+ * waits for it.
+ */
+class DuplicateInputs
+{
+public:
+    /// The original an input duplicates, and the outputs its conversion wrote.
+    struct Original
+    {
+        std::filesystem::path inputPath;
+        std::vector<std::filesystem::path> outputs;
+    };
+
+    /// Returns the original whose content inputPath duplicates, once it has been converted successfully. Returns
+    /// nothing when inputPath is the first input of its content (it then becomes the original) or when its original
+    /// failed; the caller converts inputPath itself in either case, and must then call #finish.
+    std::optional<Original> claim(const std::filesystem::path& inputPath, std::uint64_t quickKey);
+
+    /// Reports the conversion of inputPath, which only matters if it is an original. Copies waiting on it resume.
+    void finish(const std::filesystem::path& inputPath, bool succeeded, std::vector<std::filesystem::path> outputs);
+
+private:
+    struct Group
+    {
+        std::filesystem::path original;
+        std::optional<std::uint64_t> contentHash; ///< of the original, computed once a second input shares the quick key
+        bool done{};
+        bool succeeded{};
+        std::vector<std::filesystem::path> outputs;
+    };
+
+    std::mutex m_mutex;
+    std::condition_variable m_finished;
+    std::multimap<std::uint64_t, std::shared_ptr<Group>> m_groups;  ///< by quick key
+    std::map<std::filesystem::path, std::shared_ptr<Group>> m_converting; ///< groups whose original is not finished
+};
+
+} // namespace denigma
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace denigma {
+
+/**
+ * @brief Layout of the binary EnigmaXML cache (FormatId::EnigmaBinary).
+ *
+ * The file holds the element tree of an EnigmaXML document without its markup, so loading it is a walk over records
+ * rather than an XML parse. All integers after the fixed header are unsigned LEB128 varints.
+ *
+ * - Header: the 8-byte #MAGIC, then version, flags (both uint32) and the source entry and note counts
+ *   (both uint64), little-endian.
+ * - String table: a count, then each string as its length, its bytes and a terminating zero. Every element name,
+ *   attribute name, attribute value and text appears once, and records refer to it by index. The terminators let a
+ *   reader use the strings in place, straight out of a mapped file.
+ * - Tree: one element record for the root. An element record is #ELEMENT, the name index, the attribute
+ *   count, a name and value index per attribute, and the byte length of its child records followed by them, so that a
+ *   reader can step over a whole element. #TEXT and #CDATA records carry one string index.
+ */
+namespace enigma_binary {
+
+inline constexpr std::array<char, 8> MAGIC = { '\x89', 'E', 'N', 'B', '\r', '\n', '\x1a', '\n' };
+inline constexpr std::uint32_t VERSION = 1;
+inline constexpr std::size_t HEADER_SIZE = 32;
+
+inline constexpr std::uint8_t ELEMENT = 1;
+inline constexpr std::uint8_t TEXT = 2;
+inline constexpr std::uint8_t CDATA = 3;
+
+/// @brief The fixed header of a binary EnigmaXML cache.
+struct Header
+{
+    std::uint32_t version{ VERSION };
+    std::uint32_t flags{};
+    std::uint64_t entries{};    ///< entry elements in the source, for ConversionStats
+    std::uint64_t notes{};      ///< note elements in the source, for ConversionStats
+};
+
+/// Returns true if data starts with the binary EnigmaXML magic.
+inline bool isEnigmaBinary(std::span<const char> data)
+{
+    return data.size() >= MAGIC.size() && std::memcmp(data.data(), MAGIC.data(), MAGIC.size()) == 0;
+}
+
+namespace detail {
+
+template <typename T>
+T readLittleEndian(const char* data)
+{
+    T value{};
+    for (std::size_t index = 0; index < sizeof(T); ++index) {
+        value |= static_cast<T>(static_cast<unsigned char>(data[index])) << (8 * index);
+    }
+    return value;
+}
+
+template <typename T>
+void appendLittleEndian(std::vector<char>& out, T value)
+{
+    for (std::size_t index = 0; index < sizeof(T); ++index) {
+        out.push_back(static_cast<char>((value >> (8 * index)) & 0xff));
+    }
+}
+
+} // namespace detail
+
+/// Reads the header of data, or returns std::nullopt if data is not a binary EnigmaXML cache this version reads.
+inline std::optional<Header> readHeader(std::span<const char> data)
+{
+    if (!isEnigmaBinary(data) || data.size() < HEADER_SIZE) {
+        return std::nullopt;
+    }
+    Header header;
+    header.version = detail::readLittleEndian<std::uint32_t>(data.data() + 8);
+    header.flags = detail::readLittleEndian<std::uint32_t>(data.data() + 12);
+    header.entries = detail::readLittleEndian<std::uint64_t>(data.data() + 16);
+    header.notes = detail::readLittleEndian<std::uint64_t>(data.data() + 24);
+    if (header.version != VERSION) {
+        return std::nullopt;
+    }
+    return header;
+}
+
+/// Appends the header to out.
+inline void appendHeader(std::vector<char>& out, const Header& header)
+{
+    out.insert(out.end(), MAGIC.begin(), MAGIC.end());
+    detail::appendLittleEndian(out, header.version);
+    detail::appendLittleEndian(out, header.flags);
+    detail::appendLittleEndian(out, header.entries);
+    detail::appendLittleEndian(out, header.notes);
+}
+
+/// Appends value to out as an unsigned LEB128 varint.
+inline void appendVarint(std::vector<char>& out, std::uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @class Cursor
+ * @brief Reads the records of a binary EnigmaXML cache, throwing std::runtime_error where the data is cut short.
+ */
+class Cursor
+{
+public:
+    Cursor(const char* pos, const char* end) : m_pos(pos), m_end(end) {}
+
+    const char* position() const { return m_pos; }
+    bool atEnd() const { return m_pos == m_end; }
+
+    std::uint8_t readByte()
+    {
+        require(1);
+        return static_cast<std::uint8_t>(*m_pos++);
+    }
+
+    std::uint64_t readVarint()
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const std::uint8_t byte = readByte();
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        throw std::runtime_error("binary EnigmaXML has an overlong varint");
+    }
+
+    /// Returns the next count bytes and moves past them.
+    const char* take(std::uint64_t count)
+    {
+        require(count);
+        const char* start = m_pos;
+        m_pos += count;
+        return start;
+    }
+
+private:
+    void require(std::uint64_t count) const
+    {
+        if (count > static_cast<std::uint64_t>(m_end - m_pos)) {
+            throw std::runtime_error("binary EnigmaXML is truncated");
+        }
+    }
+
+    const char* m_pos;
+    const char* m_end;
+};
+
+} // namespace enigma_binary
+} // namespace denigma
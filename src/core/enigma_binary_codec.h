@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "pugixml.hpp"
+
+#include "core/enigma_binary.h"
+
+// Header-only for the same reason as createMusxDocument: pugixml must not become a dependency of denigma_core.
+
+namespace denigma {
+namespace enigma_binary {
+
+namespace detail {
+
+/// Builds the string table and the records of one document.
+class Encoder
+{
+public:
+    std::vector<char> encode(const ::pugi::xml_node root)
+    {
+        std::vector<char> tree;
+        encodeElement(root, tree);
+
+        std::vector<char> out;
+        appendHeader(out, m_header);
+        appendVarint(out, m_strings.size());
+        for (const auto string : m_strings) {
+            appendVarint(out, string.size());
+            out.insert(out.end(), string.begin(), string.end());
+            out.push_back('\0');
+        }
+        out.insert(out.end(), tree.begin(), tree.end());
+        return out;
+    }
+
+private:
+    std::uint64_t intern(const char* text)
+    {
+        const auto [found, inserted] = m_index.emplace(std::string_view(text), m_strings.size());
+        if (inserted) {
+            m_strings.push_back(found->first);
+        }
+        return found->second;
+    }
+
+    void encodeElement(const ::pugi::xml_node element, std::vector<char>& out)
+    {
+        const std::string_view name = element.name();
+        m_header.entries += name == "entry";
+        m_header.notes += name == "note";
+        out.push_back(static_cast<char>(ELEMENT));
+        appendVarint(out, intern(element.name()));
+        std::uint64_t attributeCount = 0;
+        for ([[maybe_unused]] const auto attribute : element.attributes()) {
+            ++attributeCount;
+        }
+        appendVarint(out, attributeCount);
+        for (const auto attribute : element.attributes()) {
+            appendVarint(out, intern(attribute.name()));
+            appendVarint(out, intern(attribute.value()));
+        }
+        // the children go through a buffer of their own because their length precedes them
+        std::vector<char> children;
+        for (const auto child : element.children()) {
+            switch (child.type()) {
+            case ::pugi::node_element:
+                encodeElement(child, children);
+                break;
+            case ::pugi::node_pcdata:
+            case ::pugi::node_cdata:
+                children.push_back(static_cast<char>(child.type() == ::pugi::node_pcdata ? TEXT : CDATA));
+                appendVarint(children, intern(child.value()));
+                break;
+            default:
+                break; // comments and processing instructions are not part of the content
+            }
+        }
+        appendVarint(out, children.size());
+        out.insert(out.end(), children.begin(), children.end());
+    }
+
+    Header m_header;
+    std::unordered_map<std::string_view, std::uint64_t> m_index;
+    std::vector<std::string_view> m_strings;
+};
+
+/// Recreates the element records of one binary cache as pugixml nodes.
+class Decoder
+{
+public:
+    Decoder(std::span<const char> data, bool (*keep)(std::string_view name))
+        : m_cursor(data.data(), data.data() + data.size()), m_keep(keep)
+    {
+        if (!readHeader(data)) {
+            throw std::runtime_error("not a binary EnigmaXML cache of version " + std::to_string(VERSION));
+        }
+        m_cursor.take(HEADER_SIZE);
+        const auto stringCount = m_cursor.readVarint();
+        if (stringCount > data.size()) {
+            throw std::runtime_error("binary EnigmaXML has a corrupt string table");
+        }
+        m_strings.reserve(static_cast<std::size_t>(stringCount));
+        for (std::uint64_t index = 0; index < stringCount; ++index) {
+            const auto length = m_cursor.readVarint();
+            const char* text = m_cursor.take(length);
+            if (m_cursor.readByte() != 0) {
+                throw std::runtime_error("binary EnigmaXML has a corrupt string table");
+            }
+            m_strings.push_back(text); // used in place: pugixml copies what it keeps
+        }
+    }
+
+    void decode(::pugi::xml_document& document)
+    {
+        if (m_cursor.readByte() != ELEMENT) {
+            throw std::runtime_error("binary EnigmaXML has no root element");
+        }
+        decodeElement(m_cursor, document, 0);
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 256;
+
+    const char* string(std::uint64_t index) const
+    {
+        if (index >= m_strings.size()) {
+            throw std::runtime_error("binary EnigmaXML refers to a missing string");
+        }
+        return m_strings[static_cast<std::size_t>(index)];
+    }
+
+    void decodeElement(Cursor& cursor, ::pugi::xml_node parent, int depth)
+    {
+        if (depth > MAX_DEPTH) {
+            throw std::runtime_error("binary EnigmaXML is nested too deeply");
+        }
+        const char* name = string(cursor.readVarint());
+        const auto attributeCount = cursor.readVarint();
+        // only the root's children are filtered, the same families the text reader cuts out
+        const bool skipped = depth == 1 && m_keep && !m_keep(name);
+        ::pugi::xml_node element = skipped ? ::pugi::xml_node() : parent.append_child(name);
+        for (std::uint64_t index = 0; index < attributeCount; ++index) {
+            const char* attributeName = string(cursor.readVarint());
+            const char* attributeValue = string(cursor.readVarint());
+            if (!skipped) {
+                element.append_attribute(attributeName).set_value(attributeValue);
+            }
+        }
+        const auto childrenLength = cursor.readVarint();
+        const char* childrenStart = cursor.take(childrenLength);
+        if (skipped) {
+            return;
+        }
+        Cursor children(childrenStart, childrenStart + childrenLength);
+        while (!children.atEnd()) {
+            switch (children.readByte()) {
+            case ELEMENT:
+                decodeElement(children, element, depth + 1);
+                break;
+            case TEXT:
+                element.append_child(::pugi::node_pcdata).set_value(string(children.readVarint()));
+                break;
+            case CDATA:
+                element.append_child(::pugi::node_cdata).set_value(string(children.readVarint()));
+                break;
+            default:
+                throw std::runtime_error("binary EnigmaXML has an unknown record");
+            }
+        }
+    }
+
+    Cursor m_cursor;
+    bool (*m_keep)(std::string_view name);
+    std::vector<const char*> m_strings;
+};
+
+} // namespace detail
+
+/// Encodes the EnigmaXML text xml as a binary cache. Throws std::runtime_error if xml does not parse.
+inline std::vector<char> encode(std::span<const char> xml)
+{
+    ::pugi::xml_document document;
+    constexpr unsigned PARSE_FLAGS = ::pugi::parse_cdata | ::pugi::parse_escapes | ::pugi::parse_eol;
+    const auto result = document.load_buffer(xml.data(), xml.size(), PARSE_FLAGS, ::pugi::encoding_utf8);
+    if (!result) {
+        throw std::runtime_error(std::string("unable to parse EnigmaXML: ") + result.description());
+    }
+    const auto root = document.document_element();
+    if (!root) {
+        throw std::runtime_error("EnigmaXML has no root element");
+    }
+    return detail::Encoder().encode(root);
+}
+
+/// Builds document from the binary cache data. When keep is set, the root's child elements whose names fail it are
+/// stepped over without being built. Throws std::runtime_error if data is not a readable cache.
+inline void decode(std::span<const char> data, ::pugi::xml_document& document, bool (*keep)(std::string_view name) = nullptr)
+{
+    document.reset();
+    detail::Decoder(data, keep).decode(document);
+}
+
+} // namespace enigma_binary
+} // namespace denigma
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include "musx/musx.h"
+
+namespace denigma {
+
+/**
+ * @class EntryFrameCache
+ * @brief Memoizes the entry frames of one part for one conversion.
+ *
+ * Creating an entry frame resolves every entry of a layer: its timing, tuplets and beaming. The note, beam and
+ * sequence passes each walk the same frames, and smart-shape, tie and arpeggio passes look entries up again by
+ * number, so they share one of these per part. Entries of the frames built so far are indexed by entry number.
+ * The document must not be edited while the cache is in use.
+ *
+ * Frames built before the passes start (see Prebuilt) are taken over on their first request instead of rebuilt.
+ */
+class EntryFrameCache
+{
+public:
+    using EntryFramePtr = decltype(std::declval<const musx::dom::details::GFrameHoldContext&>().createEntryFrame(musx::dom::LayerIndex{}));
+
+    class Prebuilt;
+
+    /// Returns the same value as gfHold.createEntryFrame(layer), building it only on the first request.
+    EntryFramePtr get(const musx::dom::details::GFrameHoldContext& gfHold, musx::dom::LayerIndex layer)
+    {
+        const Key key{ gfHold->getStaff(), gfHold->getMeasure(), layer };
+        if (const auto it = m_frames.find(key); it != m_frames.end()) {
+            return it->second;
+        }
+        auto frame = m_prebuilt ? m_prebuilt->take(key) : EntryFramePtr{};
+        if (!frame) {
+            frame = gfHold.createEntryFrame(layer);
+        }
+        if (frame) {
+            frame->iterateEntries([&](const musx::dom::EntryInfoPtr& entryInfo) -> bool {
+                m_entries.try_emplace(entryInfo->getEntry()->getEntryNumber(), entryInfo);
+                return true;
+            });
+        }
+        m_frames.emplace(key, frame);
+        return frame;
+    }
+
+    /// Returns the entry numbered entryNumber in a frame this cache has built, or a null EntryInfoPtr.
+    musx::dom::EntryInfoPtr findEntry(musx::dom::EntryNumber entryNumber) const
+    {
+        const auto it = m_entries.find(entryNumber);
+        return it == m_entries.end() ? musx::dom::EntryInfoPtr() : it->second;
+    }
+
+    /// Frames are looked for in prebuilt before they are built. The clear and merge functions leave it in place.
+    void setPrebuilt(std::shared_ptr<Prebuilt> prebuilt) { m_prebuilt = std::move(prebuilt); }
+    const std::shared_ptr<Prebuilt>& prebuilt() const { return m_prebuilt; }
+
+    void clear()
+    {
+        m_frames.clear();
+        m_entries.clear();
+    }
+
+    /// Moves the frames other built into this cache. Entries already here are kept.
+    void mergeFrom(EntryFrameCache&& other)
+    {
+        m_frames.merge(other.m_frames);
+        m_entries.merge(other.m_entries);
+        other.clear();
+    }
+
+private:
+    using Key = std::tuple<musx::dom::StaffCmper, musx::dom::MeasCmper, musx::dom::LayerIndex>;
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            const auto [staffId, measureId, layer] = key;
+            std::size_t result = std::hash<musx::dom::StaffCmper>{}(staffId);
+            result = result * 31 + std::hash<musx::dom::MeasCmper>{}(measureId);
+            return result * 31 + std::hash<musx::dom::LayerIndex>{}(layer);
+        }
+    };
+
+    std::unordered_map<Key, EntryFramePtr, KeyHash> m_frames;
+    std::unordered_map<musx::dom::EntryNumber, musx::dom::EntryInfoPtr> m_entries;
+    std::shared_ptr<Prebuilt> m_prebuilt;
+};
+
+/**
+ * @class EntryFrameCache::Prebuilt
+ * @brief Entry frames built by a pass that runs ahead of the per-part passes, held until one of them asks.
+ *
+ * Each frame is handed to the first cache that requests it and released from here, so a frame lives in one place at
+ * a time. Worker caches of the same part share one of these, so taking is serialized.
+ */
+class EntryFrameCache::Prebuilt
+{
+public:
+    /// Keeps frame (the result of gfHold.createEntryFrame(layer)) for the first cache that requests it.
+    void put(const musx::dom::details::GFrameHoldContext& gfHold, musx::dom::LayerIndex layer, EntryFramePtr frame)
+    {
+        std::lock_guard lock(m_mutex);
+        m_frames.insert_or_assign(Key{ gfHold->getStaff(), gfHold->getMeasure(), layer }, std::move(frame));
+    }
+
+private:
+    friend class EntryFrameCache;
+
+    EntryFramePtr take(const Key& key)
+    {
+        std::lock_guard lock(m_mutex);
+        const auto node = m_frames.extract(key);
+        return node ? std::move(node.mapped()) : EntryFramePtr{};
+    }
+
+    std::mutex m_mutex;
+    std::unordered_map<Key, EntryFramePtr, KeyHash> m_frames;
+};
+
+} // namespace denigma
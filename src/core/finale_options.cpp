@@ -24,6 +24,8 @@
 #include <stdexcept>
 #include <string>
 
+#include "classify/classification_cache.h"
+
 namespace denigma {
 
 namespace {
@@ -38,9 +40,10 @@ musx::dom::MusxInstance<T> getRequiredOptions(const musx::dom::DocumentPtr& docu
     return retval;
 }
 
-} // namespace
+/// Resolved options keyed by the part they were resolved for.
+using FinaleOptionsTable = classify::detail::ClassificationCache::Table<musx::dom::Cmper, FinaleOptions>;
 
-FinaleOptions loadFinaleOptions(const musx::dom::DocumentPtr& document, musx::dom::Cmper forPartId)
+FinaleOptions resolveFinaleOptions(const musx::dom::DocumentPtr& document, musx::dom::Cmper forPartId)
 {
     using namespace musx::dom;
 
@@ -100,4 +103,14 @@ FinaleOptions loadFinaleOptions(const musx::dom::DocumentPtr& document, musx::do
     return retval;
 }
 
+} // namespace
+
+FinaleOptions loadFinaleOptions(const musx::dom::DocumentPtr& document, musx::dom::Cmper forPartId)
+{
+    // a document that fails to resolve throws on every call, since nothing is stored for it
+    return classify::detail::cachedClassification<FinaleOptionsTable>(document, forPartId, [&]() {
+        return resolveFinaleOptions(document, forPartId);
+    });
+}
+
 } // namespace denigma
@@ -64,6 +64,8 @@ struct FinaleOptions
     musx::dom::MusxInstance<musx::dom::others::PartGlobals> effectivePartGlobals;
 };
 
+/// Returns the options of document resolved for forPartId. They are resolved once per document and part, and every
+/// conversion of the document shares them.
 FinaleOptions loadFinaleOptions(const musx::dom::DocumentPtr& document, musx::dom::Cmper forPartId = musx::dom::SCORE_PARTID);
 
 } // namespace denigma
@@ -0,0 +1,445 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/forked_workers.h"
+
+#include <stdexcept>
+#include <utility>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "utils/stringutils.h"
+
+namespace denigma {
+
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+
+ForkedWorkerPool::ForkedWorkerPool(const DenigmaContext& denigmaContext, ConvertFunc convert, std::chrono::seconds timeout)
+    : m_context(denigmaContext), m_convert(std::move(convert)), m_timeout(timeout)
+{
+    throw std::runtime_error("--isolate is not supported on this platform");
+}
+
+ForkedWorkerPool::~ForkedWorkerPool() = default;
+
+void ForkedWorkerPool::convert(DenigmaContext&, const std::filesystem::path&)
+{
+    throw std::logic_error("ForkedWorkerPool is not supported on this platform");
+}
+
+#else
+
+namespace {
+
+// Each frame is a type byte, a 4-byte little-endian payload length and the payload.
+constexpr char FRAME_CONVERT = 'C'; ///< to a worker: the utf-8 path of the input to convert
+constexpr char FRAME_OUTPUT = 'O';  ///< from a worker: the utf-8 path of an output that passed validation
+constexpr char FRAME_LOG = 'L';     ///< from a worker: one message (see encodeLogMessage)
+constexpr char FRAME_DONE = 'D';    ///< from a worker: the conversion has finished
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL; // a worker that died must not take the sender down with SIGPIPE
+#else
+constexpr int SEND_FLAGS = 0;            // SO_NOSIGPIPE is set on each socket instead
+#endif
+
+enum class ReceiveStatus
+{
+    Received,
+    Closed,
+    TimedOut
+};
+
+using Deadline = std::optional<std::chrono::steady_clock::time_point>;
+
+void configureSocket(int socket)
+{
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    ::setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)socket;
+#endif
+}
+
+void appendUint32(std::string& out, std::uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+}
+
+std::optional<std::uint32_t> readUint32(std::string_view in, std::size_t& pos)
+{
+    if (pos > in.size() || in.size() - pos < 4) {
+        return std::nullopt;
+    }
+    std::uint32_t value = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        value |= std::uint32_t(static_cast<unsigned char>(in[pos++])) << shift;
+    }
+    return value;
+}
+
+bool sendAll(int socket, const char* data, std::size_t size)
+{
+    while (size > 0) {
+        const ssize_t sent = ::send(socket, data, size, SEND_FLAGS);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+bool sendFrame(int socket, char type, std::string_view payload)
+{
+    std::string frame(1, type);
+    appendUint32(frame, static_cast<std::uint32_t>(payload.size()));
+    frame.append(payload);
+    return sendAll(socket, frame.data(), frame.size());
+}
+
+ReceiveStatus receiveAll(int socket, char* data, std::size_t size, const Deadline& deadline)
+{
+    while (size > 0) {
+        if (deadline) {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                return ReceiveStatus::TimedOut;
+            }
+            pollfd request{ socket, POLLIN, 0 };
+            const int ready = ::poll(&request, 1, static_cast<int>((std::min<long long>)(remaining, INT_MAX)));
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready == 0) {
+                return ReceiveStatus::TimedOut;
+            }
+        }
+        const ssize_t received = ::recv(socket, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return ReceiveStatus::Closed;
+        }
+        data += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return ReceiveStatus::Received;
+}
+
+ReceiveStatus receiveFrame(int socket, char& type, std::string& payload, const Deadline& deadline)
+{
+    char header[5];
+    if (const auto status = receiveAll(socket, header, sizeof(header), deadline); status != ReceiveStatus::Received) {
+        return status;
+    }
+    type = header[0];
+    std::size_t pos = 1;
+    payload.resize(*readUint32(std::string_view(header, sizeof(header)), pos));
+    return receiveAll(socket, payload.data(), payload.size(), deadline);
+}
+
+/// Passes socketToSend (or nothing, when it is negative) and pid over via.
+bool sendWorkerSocket(int via, int socketToSend, std::int32_t pid)
+{
+    iovec data{ &pid, sizeof(pid) };
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    if (socketToSend >= 0) {
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(header), &socketToSend, sizeof(int));
+    }
+    while (::sendmsg(via, &message, SEND_FLAGS) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Receives what sendWorkerSocket sent: the socket and the pid, or nothing if the worker could not be started.
+std::optional<std::pair<int, std::int32_t>> receiveWorkerSocket(int via)
+{
+    std::int32_t pid = -1;
+    iovec data{ &pid, sizeof(pid) };
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t received = 0;
+    while ((received = ::recvmsg(via, &message, 0)) < 0 && errno == EINTR) {
+    }
+    if (received != static_cast<ssize_t>(sizeof(pid)) || pid <= 0) {
+        return std::nullopt;
+    }
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            int socket = -1;
+            std::memcpy(&socket, CMSG_DATA(header), sizeof(int));
+            return std::make_pair(socket, pid);
+        }
+    }
+    return std::nullopt;
+}
+
+/// A severity byte, the message text with its 4-byte length, and the utf-8 input path.
+std::string encodeLogMessage(MessageSeverity severity, std::string_view text, const std::filesystem::path& inputFilePath)
+{
+    std::string out(1, static_cast<char>(severity));
+    appendUint32(out, static_cast<std::uint32_t>(text.size()));
+    out.append(text);
+    out.append(utils::pathToString(inputFilePath));
+    return out;
+}
+
+std::optional<DenigmaContext::BufferedLogMessage> decodeLogMessage(std::string_view payload)
+{
+    std::size_t pos = 1;
+    const auto textSize = payload.empty() ? std::nullopt : readUint32(payload, pos);
+    if (!textSize || payload.size() - pos < *textSize) {
+        return std::nullopt;
+    }
+    DenigmaContext::BufferedLogMessage message;
+    message.severity = static_cast<MessageSeverity>(payload[0]);
+    message.text = std::string(payload.substr(pos, *textSize));
+    message.inputFilePath = utils::utf8ToPath(payload.substr(pos + *textSize));
+    return message;
+}
+
+} // namespace
+
+ForkedWorkerPool::ForkedWorkerPool(const DenigmaContext& denigmaContext, ConvertFunc convert, std::chrono::seconds timeout)
+    : m_context(denigmaContext), m_convert(std::move(convert)), m_timeout(timeout)
+{
+    m_context.conversionResult = nullptr;
+    m_context.logBuffer = nullptr;
+    m_context.outputsWritten = nullptr;
+
+    int sockets[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        throw std::runtime_error("unable to create a socket for worker processes: " + std::string(std::strerror(errno)));
+    }
+    std::cout.flush(); // nothing buffered now can be written twice
+    std::cerr.flush();
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        const int error = errno;
+        ::close(sockets[0]);
+        ::close(sockets[1]);
+        throw std::runtime_error("unable to start worker processes: " + std::string(std::strerror(error)));
+    }
+    if (pid == 0) {
+        ::close(sockets[0]);
+        runZygote(sockets[1]);
+    }
+    ::close(sockets[1]);
+    configureSocket(sockets[0]);
+    m_zygotePid = pid;
+    m_zygoteSocket = sockets[0];
+}
+
+ForkedWorkerPool::~ForkedWorkerPool()
+{
+    for (const auto& worker : m_idle) {
+        ::close(worker.socket); // the worker exits when its socket closes
+    }
+    ::close(m_zygoteSocket);
+    int status = 0;
+    while (::waitpid(m_zygotePid, &status, 0) < 0 && errno == EINTR) {
+    }
+}
+
+void ForkedWorkerPool::runZygote(int socket)
+{
+    ::signal(SIGCHLD, SIG_IGN); // workers are reaped without waiting for them
+    ::signal(SIGPIPE, SIG_IGN);
+    configureSocket(socket);
+    while (true) {
+        char request = 0;
+        if (receiveAll(socket, &request, 1, std::nullopt) != ReceiveStatus::Received) {
+            ::_exit(0);
+        }
+        int sockets[2];
+        pid_t pid = -1;
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0) {
+            pid = ::fork();
+            if (pid == 0) {
+                ::close(socket);
+                ::close(sockets[0]);
+                runWorker(sockets[1]);
+            }
+            ::close(sockets[1]);
+        } else {
+            sockets[0] = -1;
+        }
+        const bool sent = sendWorkerSocket(socket, pid > 0 ? sockets[0] : -1, pid);
+        if (sockets[0] >= 0) {
+            ::close(sockets[0]);
+        }
+        if (!sent) {
+            ::_exit(0);
+        }
+    }
+}
+
+void ForkedWorkerPool::runWorker(int socket)
+{
+    configureSocket(socket);
+    while (true) {
+        char type = 0;
+        std::string payload;
+        if (receiveFrame(socket, type, payload, std::nullopt) != ReceiveStatus::Received || type != FRAME_CONVERT) {
+            ::_exit(0); // the parent is done with this worker; skip destructors, which belong to the parent's objects
+        }
+        const std::filesystem::path path = utils::utf8ToPath(payload);
+        DenigmaContext context(m_context);
+        context.inputFilePath = "";
+        context.logCallback = [&context, socket](MessageSeverity severity, std::string_view text) {
+            sendFrame(socket, FRAME_LOG, encodeLogMessage(severity, text, context.inputFilePath));
+        };
+        context.outputValidated = [socket](const std::filesystem::path& outputPath) {
+            sendFrame(socket, FRAME_OUTPUT, utils::pathToString(outputPath));
+        };
+        try {
+            m_convert(context, path);
+        } catch (const std::exception& e) {
+            context.logMessage(LogMsg() << e.what(), MessageSeverity::Error);
+        }
+        if (!sendFrame(socket, FRAME_DONE, {})) {
+            ::_exit(0);
+        }
+    }
+}
+
+ForkedWorkerPool::Worker ForkedWorkerPool::startWorker()
+{
+    std::lock_guard lock(m_zygoteMutex);
+    const char request = 'W';
+    if (!sendAll(m_zygoteSocket, &request, 1)) {
+        throw std::runtime_error("the process that starts worker processes has exited");
+    }
+    const auto received = receiveWorkerSocket(m_zygoteSocket);
+    if (!received) {
+        throw std::runtime_error("unable to start a worker process");
+    }
+    configureSocket(received->first);
+    return { received->second, received->first };
+}
+
+void ForkedWorkerPool::convert(DenigmaContext& context, const std::filesystem::path& path)
+{
+    Worker worker;
+    {
+        std::lock_guard lock(m_idleMutex);
+        if (!m_idle.empty()) {
+            worker = m_idle.back();
+            m_idle.pop_back();
+        }
+    }
+    if (worker.socket < 0) {
+        worker = startWorker();
+    }
+
+    Deadline deadline;
+    if (m_timeout.count() > 0) {
+        deadline = std::chrono::steady_clock::now() + m_timeout;
+    }
+    std::vector<DenigmaContext::BufferedLogMessage> log;
+    auto status = sendFrame(worker.socket, FRAME_CONVERT, utils::pathToString(path)) ? ReceiveStatus::Received : ReceiveStatus::Closed;
+    while (status == ReceiveStatus::Received) {
+        char type = 0;
+        std::string payload;
+        status = receiveFrame(worker.socket, type, payload, deadline);
+        if (status != ReceiveStatus::Received || type == FRAME_DONE) {
+            break;
+        }
+        if (type == FRAME_LOG) {
+            auto message = decodeLogMessage(payload);
+            if (!message) {
+                status = ReceiveStatus::Closed; // not from a worker in a sound state
+                break;
+            }
+            log.push_back(std::move(*message));
+        } else if (type == FRAME_OUTPUT) {
+            const auto outputPath = utils::utf8ToPath(payload);
+            if (context.outputsWritten) {
+                context.outputsWritten->push_back(outputPath);
+            }
+            if (context.outputValidated) {
+                context.outputValidated(outputPath);
+            }
+        }
+    }
+    context.replayBufferedLog(log);
+    if (status == ReceiveStatus::Received) {
+        std::lock_guard lock(m_idleMutex);
+        m_idle.push_back(worker);
+        return;
+    }
+
+    ::kill(worker.pid, SIGKILL);
+    ::close(worker.socket);
+    context.inputFilePath = path;
+    if (status == ReceiveStatus::TimedOut) {
+        context.logMessage(LogMsg() << "conversion did not finish within " << m_timeout.count()
+            << " seconds, so its worker process was stopped", MessageSeverity::Error);
+    } else {
+        context.logMessage(LogMsg() << "the worker process converting this file exited unexpectedly", MessageSeverity::Error);
+    }
+}
+
+#endif // defined(_WIN32) || defined(__EMSCRIPTEN__)
+
+} // namespace denigma
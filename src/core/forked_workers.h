@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "core/denigma.h"
+
+namespace denigma {
+
+/**
+ * @class ForkedWorkerPool
+ * @brief Converts batch inputs in worker processes, so an input that crashes or hangs costs only its own conversion.
+ *
+ * The constructor forks a zygote process, and the zygote forks each worker. Every worker therefore starts from the
+ * caches the parent warmed up before constructing the pool (fonts, SMuFL metadata, schema, converter registry) and
+ * shares their pages copy-on-write. The zygote never starts a thread, which is what keeps forking it again safe
+ * while the parent runs batch threads. A worker converts one input at a time and stays alive for the next.
+ *
+ * Forking needs POSIX; on Windows and WebAssembly the constructor throws.
+ */
+class ForkedWorkerPool
+{
+public:
+    /// Converts path in a worker process, against a copy of the context the pool was constructed with.
+    using ConvertFunc = std::function<void(DenigmaContext& context, const std::filesystem::path& path)>;
+
+    /// Starts the zygote. What denigmaContext and convert refer to is used in the workers as it is now.
+    /// @param timeout How long one conversion may run before its worker is killed (0 means no limit).
+    /// @throws std::runtime_error if the zygote cannot be started or the platform cannot fork.
+    ForkedWorkerPool(const DenigmaContext& denigmaContext, ConvertFunc convert, std::chrono::seconds timeout);
+    ~ForkedWorkerPool();
+
+    ForkedWorkerPool(const ForkedWorkerPool&) = delete;
+    ForkedWorkerPool& operator=(const ForkedWorkerPool&) = delete;
+
+    /// Converts path in an idle worker, starting one if none is idle, and returns once it is done. The worker's
+    /// messages are logged on context as it logged them, and each output it validates is passed on to
+    /// context.outputValidated and context.outputsWritten. A worker that dies or runs past the timeout is discarded,
+    /// with an error logged on context. May be called from several threads at once.
+    void convert(DenigmaContext& context, const std::filesystem::path& path);
+
+private:
+    struct Worker
+    {
+        int pid{ -1 };
+        int socket{ -1 };
+    };
+
+    Worker startWorker();
+    [[noreturn]] void runZygote(int socket);
+    [[noreturn]] void runWorker(int socket);
+
+    DenigmaContext m_context;       ///< copied for each conversion in a worker
+    ConvertFunc m_convert;
+    std::chrono::seconds m_timeout;
+    std::mutex m_zygoteMutex;       ///< one worker request to the zygote at a time
+    int m_zygotePid{ -1 };
+    int m_zygoteSocket{ -1 };
+    std::mutex m_idleMutex;
+    std::vector<Worker> m_idle;
+};
+
+} // namespace denigma
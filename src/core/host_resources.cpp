@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "core/host_resources.h"
+
+namespace denigma {
+
+namespace detail {
+
+namespace {
+
+std::string_view trim(std::string_view text)
+{
+    const auto first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+std::optional<std::uint64_t> parseUnsigned(std::string_view text)
+{
+    std::uint64_t value = 0;
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc{} || result.ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+} // namespace
+
+std::optional<std::string> findCgroupPath(std::string_view procSelfCgroup, std::string_view controller)
+{
+    // each line is "hierarchy-id:controller,controller,...:path"; the unified hierarchy is "0::path"
+    std::size_t lineStart = 0;
+    while (lineStart < procSelfCgroup.size()) {
+        auto lineEnd = procSelfCgroup.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = procSelfCgroup.size();
+        }
+        const auto line = procSelfCgroup.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        const auto firstColon = line.find(':');
+        const auto secondColon = firstColon == std::string_view::npos ? firstColon : line.find(':', firstColon + 1);
+        if (secondColon == std::string_view::npos) {
+            continue;
+        }
+        const auto controllers = line.substr(firstColon + 1, secondColon - firstColon - 1);
+        const auto path = trim(line.substr(secondColon + 1));
+        if (controller.empty()) {
+            if (controllers.empty()) {
+                return std::string(path);
+            }
+            continue;
+        }
+        std::size_t nameStart = 0;
+        while (nameStart <= controllers.size()) {
+            const auto comma = (std::min)(controllers.find(',', nameStart), controllers.size());
+            if (controllers.substr(nameStart, comma - nameStart) == controller) {
+                return std::string(path);
+            }
+            nameStart = comma + 1;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<double> parseCgroupV2CpuMax(std::string_view text)
+{
+    text = trim(text);
+    const auto space = text.find(' ');
+    if (space == std::string_view::npos) {
+        return std::nullopt;
+    }
+    const auto quota = parseUnsigned(text.substr(0, space)); // "max" has no quota
+    const auto period = parseUnsigned(trim(text.substr(space + 1)));
+    if (!quota || !period || *quota == 0 || *period == 0) {
+        return std::nullopt;
+    }
+    return static_cast<double>(*quota) / static_cast<double>(*period);
+}
+
+std::optional<std::uint64_t> parseCgroupMemoryLimit(std::string_view text)
+{
+    // v2 writes "max"; v1 writes the largest page-aligned signed 64-bit value, so anything near it means no limit
+    constexpr std::uint64_t UNLIMITED_THRESHOLD = std::uint64_t(1) << 60;
+    const auto value = parseUnsigned(trim(text));
+    if (!value || *value == 0 || *value >= UNLIMITED_THRESHOLD) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+} // namespace detail
+
+namespace {
+
+#if defined(__linux__)
+
+std::optional<std::string> readSmallFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+/// Returns the directories whose limits apply to a cgroup: its own under mountPoint and then each ancestor up to the
+/// mount point. Inside a cgroup namespace the path is "/" and only the mount point itself is searched.
+std::vector<std::filesystem::path> cgroupDirectories(const std::filesystem::path& mountPoint, const std::string& cgroupPath)
+{
+    std::vector<std::filesystem::path> result;
+    auto relative = std::filesystem::path(cgroupPath).relative_path();
+    while (true) {
+        result.push_back(mountPoint / relative);
+        if (relative.empty()) {
+            break;
+        }
+        relative = relative.parent_path();
+    }
+    return result;
+}
+
+void detectCgroupLimits(HostResources& resources)
+{
+    const std::filesystem::path mountPoint = "/sys/fs/cgroup";
+    const auto procSelfCgroup = readSmallFile("/proc/self/cgroup").value_or(std::string{});
+    std::optional<double> cpuQuota;
+    auto applyCpuQuota = [&](std::optional<double> quota) {
+        if (quota) {
+            cpuQuota = cpuQuota ? (std::min)(*cpuQuota, *quota) : *quota;
+        }
+    };
+    auto applyMemoryLimit = [&](std::optional<std::uint64_t> limit) {
+        if (limit) {
+            resources.memoryLimit = resources.memoryLimit ? (std::min)(*resources.memoryLimit, *limit) : *limit;
+        }
+    };
+
+    if (std::filesystem::exists(mountPoint / "cgroup.controllers")) {
+        // v2: one unified hierarchy, and an ancestor's limit bounds its descendants
+        for (const auto& directory : cgroupDirectories(mountPoint, detail::findCgroupPath(procSelfCgroup, {}).value_or("/"))) {
+            if (const auto cpuMax = readSmallFile(directory / "cpu.max")) {
+                applyCpuQuota(detail::parseCgroupV2CpuMax(*cpuMax));
+            }
+            if (const auto memoryMax = readSmallFile(directory / "memory.max")) {
+                applyMemoryLimit(detail::parseCgroupMemoryLimit(*memoryMax));
+            }
+        }
+    } else {
+        // v1: each controller is mounted on its own, usually as cpu,cpuacct (with cpu and cpuacct links) and memory
+        const auto cpuPath = detail::findCgroupPath(procSelfCgroup, "cpu").value_or("/");
+        for (const auto& controllerMount : { mountPoint / "cpu,cpuacct", mountPoint / "cpu" }) {
+            if (!std::filesystem::exists(controllerMount)) {
+                continue;
+            }
+            for (const auto& directory : cgroupDirectories(controllerMount, cpuPath)) {
+                const auto quota = readSmallFile(directory / "cpu.cfs_quota_us");
+                const auto period = readSmallFile(directory / "cpu.cfs_period_us");
+                if (quota && period) {
+                    // a quota of -1 means none, which the unsigned parse rejects
+                    applyCpuQuota(detail::parseCgroupV2CpuMax(std::string(detail::trim(*quota)) + " " + *period));
+                }
+            }
+            break;
+        }
+        for (const auto& directory : cgroupDirectories(mountPoint / "memory", detail::findCgroupPath(procSelfCgroup, "memory").value_or("/"))) {
+            if (const auto limit = readSmallFile(directory / "memory.limit_in_bytes")) {
+                applyMemoryLimit(detail::parseCgroupMemoryLimit(*limit));
+            }
+        }
+    }
+    if (cpuQuota) {
+        resources.cpus = (std::min)(resources.cpus, (std::max)(1u, static_cast<unsigned>(std::ceil(*cpuQuota))));
+    }
+}
+
+#elif defined(_WIN32)
+
+void detectJobObjectLimits(HostResources& resources)
+{
+    // a null handle queries the job object the process belongs to, if any
+    JOBOBJECT_CPU_RATE_CONTROL_INFORMATION cpuRate{};
+    if (QueryInformationJobObject(nullptr, JobObjectCpuRateControlInformation, &cpuRate, sizeof(cpuRate), nullptr)
+        && (cpuRate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_ENABLE) && (cpuRate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP)) {
+        // CpuRate is the share of all the host's processors, in hundredths of a percent
+        const double cpus = static_cast<double>(cpuRate.CpuRate) * GetActiveProcessorCount(ALL_PROCESSOR_GROUPS) / 10000.0;
+        resources.cpus = (std::min)(resources.cpus, (std::max)(1u, static_cast<unsigned>(std::ceil(cpus))));
+    }
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits{};
+    if (QueryInformationJobObject(nullptr, JobObjectExtendedLimitInformation, &limits, sizeof(limits), nullptr)) {
+        const auto flags = limits.BasicLimitInformation.LimitFlags;
+        if (flags & JOB_OBJECT_LIMIT_JOB_MEMORY) {
+            resources.memoryLimit = limits.JobMemoryLimit;
+        }
+        if (flags & JOB_OBJECT_LIMIT_PROCESS_MEMORY) {
+            resources.memoryLimit = resources.memoryLimit ? (std::min)(*resources.memoryLimit, std::uint64_t(limits.ProcessMemoryLimit))
+                                                          : std::uint64_t(limits.ProcessMemoryLimit);
+        }
+    }
+}
+
+#endif
+
+HostResources detectHostResources()
+{
+    HostResources resources;
+    resources.cpus = (std::max)(std::thread::hardware_concurrency(), 1u);
+#if defined(__linux__)
+    cpu_set_t affinity;
+    CPU_ZERO(&affinity);
+    if (sched_getaffinity(0, sizeof(affinity), &affinity) == 0) {
+        resources.cpus = (std::min)(resources.cpus, (std::max)(static_cast<unsigned>(CPU_COUNT(&affinity)), 1u));
+    }
+    try {
+        detectCgroupLimits(resources);
+    } catch (const std::exception&) {
+        // an unreadable cgroup tree leaves the limits found so far
+    }
+#elif defined(_WIN32)
+    // hardware_concurrency can stop at one processor group; the active processors of all groups are what can run
+    resources.cpus = (std::max)(static_cast<unsigned>(GetActiveProcessorCount(ALL_PROCESSOR_GROUPS)), 1u);
+    detectJobObjectLimits(resources);
+#endif
+    return resources;
+}
+
+} // namespace
+
+const HostResources& hostResources()
+{
+    static const HostResources resources = detectHostResources();
+    return resources;
+}
+
+} // namespace denigma
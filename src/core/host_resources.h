@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace denigma {
+
+/**
+ * @struct HostResources
+ * @brief The CPUs and memory this process may use, which in a container or job object is less than the host has.
+ *
+ * std::thread::hardware_concurrency() reports every core of the host, so a worker pool sized from it inside a
+ * 4-CPU container runs dozens of threads against a 4-CPU quota, and the throttled threads make every job slower.
+ * #cpus is instead the smallest of the CPUs the process is allowed to run on, the cgroup (v1 or v2) CPU quota
+ * rounded up, and a Windows job object's hard CPU rate cap.
+ */
+struct HostResources
+{
+    unsigned cpus{ 1 };                         ///< CPUs worth of work that can run at once; at least 1
+    std::optional<std::uint64_t> memoryLimit;   ///< the cgroup or job object memory limit, if there is one
+};
+
+/// Returns the resources of this process, detected on first use.
+const HostResources& hostResources();
+
+/// Returns hostResources().cpus: the default number of workers wherever a job count of 0 means "all cores".
+inline unsigned availableCpuCount() { return hostResources().cpus; }
+
+namespace detail {
+
+/// Returns the cgroup path of controller (for example `cpu` or `memory`) in the text of /proc/self/cgroup, or of the
+/// unified (v2) hierarchy when controller is empty.
+std::optional<std::string> findCgroupPath(std::string_view procSelfCgroup, std::string_view controller);
+
+/// Returns the CPUs a cgroup v2 `cpu.max` value ("quota period" or "max period") allows, or std::nullopt for none.
+std::optional<double> parseCgroupV2CpuMax(std::string_view text);
+
+/// Returns a cgroup memory limit (v2 `memory.max` or v1 `memory.limit_in_bytes`), or std::nullopt for none.
+std::optional<std::uint64_t> parseCgroupMemoryLimit(std::string_view text);
+
+} // namespace detail
+
+} // namespace denigma
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "denigma/conversion.h"
+
+namespace denigma {
+
+/**
+ * @class HotPathCounters
+ * @brief Counts the ConversionStats::HotPath fallbacks one conversion takes, on any of its threads.
+ *
+ * ConversionStatsScope installs one for each public converter call. Code that has the conversion's context counts
+ * through DenigmaContext::hotPathCounters, which the context's worker copies share; code that does not, such as the
+ * classifiers, counts against the thread's binding (see HotPathThreadScope), which output workers take from their
+ * context. A count is a relaxed atomic add, so the counters stay compiled into every build.
+ */
+class HotPathCounters
+{
+public:
+    void count(ConversionStats::HotPath path) noexcept
+    { m_counts[static_cast<std::size_t>(path)].fetch_add(1, std::memory_order_relaxed); }
+
+    /// Adds the counts so far to stats.
+    void addTo(ConversionStats& stats) const noexcept
+    {
+        for (std::size_t index = 0; index < ConversionStats::HOT_PATH_COUNT; ++index) {
+            stats.hotPathCounts[index] += m_counts[index].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, ConversionStats::HOT_PATH_COUNT> m_counts{};
+};
+
+namespace detail {
+inline thread_local HotPathCounters* t_hotPathCounters{};
+} // namespace detail
+
+/**
+ * @class HotPathThreadScope
+ * @brief Binds counters to the current thread for the scope, so countHotPath without a context reaches them.
+ *
+ * Scopes nest; the previous binding is restored on exit. Binding nullptr leaves the thread uncounted.
+ */
+class HotPathThreadScope
+{
+public:
+    explicit HotPathThreadScope(HotPathCounters* counters) noexcept
+        : m_previous(detail::t_hotPathCounters)
+    { detail::t_hotPathCounters = counters; }
+
+    ~HotPathThreadScope() { detail::t_hotPathCounters = m_previous; }
+
+    HotPathThreadScope(const HotPathThreadScope&) = delete;
+    HotPathThreadScope& operator=(const HotPathThreadScope&) = delete;
+
+private:
+    HotPathCounters* m_previous;
+};
+
+/// Counts path against the conversion bound to this thread, if any.
+inline void countHotPath(ConversionStats::HotPath path) noexcept
+{
+    if (auto* counters = detail::t_hotPathCounters) {
+        counters->count(path);
+    }
+}
+
+} // namespace denigma
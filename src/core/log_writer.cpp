@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/log_writer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace denigma {
+
+LogFileWriter::LogFileWriter(const std::filesystem::path& path, std::size_t capacity)
+    : m_ring((std::max)(capacity, std::size_t(1)))
+{
+    std::error_code ec;
+    const bool appending = std::filesystem::is_regular_file(path, ec) && std::filesystem::file_size(path, ec) > 0;
+    m_file.exceptions(std::ios::failbit | std::ios::badbit);
+    m_file.open(path, std::ios::app);
+    if (appending) {
+        m_file << '\n';
+    }
+    m_thread = std::thread([this]() { run(); });
+}
+
+void LogFileWriter::write(std::string line, bool flush)
+{
+    const std::time_t now = std::time(nullptr);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_spaceFreed.wait(lock, [&]() { return m_closing || m_count < m_ring.size(); });
+        if (m_closing) {
+            return;
+        }
+        m_ring[(m_head + m_count) % m_ring.size()] = { now, std::move(line), flush };
+        ++m_count;
+    }
+    m_lineQueued.notify_one();
+}
+
+void LogFileWriter::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closing) {
+            return;
+        }
+        m_closing = true;
+    }
+    m_lineQueued.notify_one();
+    m_spaceFreed.notify_all();
+    m_thread.join();
+}
+
+void LogFileWriter::run()
+{
+    std::vector<Line> batch;
+    bool failed = false; // the file stays as it was; messages still reach stderr as before
+    while (true) {
+        bool closing = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_lineQueued.wait(lock, [&]() { return m_closing || m_count > 0; });
+            for (; m_count > 0; --m_count) {
+                batch.push_back(std::move(m_ring[m_head]));
+                m_head = (m_head + 1) % m_ring.size();
+            }
+            closing = m_closing;
+        }
+        m_spaceFreed.notify_all();
+        if (!failed) {
+            try {
+                bool flush = false;
+                for (const auto& line : batch) {
+                    m_file << '[' << timestamp(line.time) << "] " << line.text << '\n';
+                    flush = flush || line.flush;
+                }
+                if (flush || closing) {
+                    m_file.flush();
+                }
+            } catch (const std::ios_base::failure&) {
+                failed = true;
+            }
+        }
+        batch.clear();
+        if (closing) {
+            break;
+        }
+    }
+    try {
+        m_file.close();
+    } catch (const std::ios_base::failure&) {
+    }
+}
+
+const std::string& LogFileWriter::timestamp(std::time_t time)
+{
+    if (time != m_stampTime) {
+        std::tm localTime;
+#ifdef _WIN32
+        localtime_s(&localTime, &time);
+#else
+        localtime_r(&time, &localTime);
+#endif
+        std::ostringstream stamp;
+        stamp << std::put_time(&localTime, "%Y-%m-%d %H:%M:%S");
+        m_stamp = stamp.str();
+        m_stampTime = time;
+    }
+    return m_stamp;
+}
+
+} // namespace denigma
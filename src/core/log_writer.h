@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace denigma {
+
+/**
+ * @class LogFileWriter
+ * @brief Appends timestamped lines to a log file from a background thread.
+ *
+ * Callers only queue a line into a bounded ring buffer, waiting while it is full, so a burst of messages from a
+ * batch run does not turn into one write and flush per line. Lines are written in the order they were queued, each
+ * prefixed with the local time of the second it was queued; the text of that timestamp is formatted once per second.
+ * The file is flushed after a line queued with flush set, and when the writer closes.
+ */
+class LogFileWriter
+{
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 1024; ///< lines the ring buffer holds
+
+    /// Opens path for appending, starting with an empty line if the file already has content.
+    /// @throws std::ios_base::failure if the file cannot be opened.
+    explicit LogFileWriter(const std::filesystem::path& path, std::size_t capacity = DEFAULT_CAPACITY);
+    ~LogFileWriter() { close(); }
+
+    LogFileWriter(const LogFileWriter&) = delete;
+    LogFileWriter& operator=(const LogFileWriter&) = delete;
+
+    /// Queues line (without its timestamp or line end). With flush set, the file is flushed once it is written.
+    /// Lines queued after #close are dropped.
+    void write(std::string line, bool flush = false);
+
+    /// Writes every queued line, flushes and closes the file. Safe to call more than once.
+    void close();
+
+private:
+    struct Line
+    {
+        std::time_t time{};
+        std::string text;
+        bool flush{};
+    };
+
+    void run();
+    const std::string& timestamp(std::time_t time);
+
+    std::ofstream m_file;
+    std::mutex m_mutex;
+    std::condition_variable m_lineQueued;
+    std::condition_variable m_spaceFreed;
+    std::vector<Line> m_ring;      ///< fixed size; the queued lines are m_count entries from m_head, wrapping
+    std::size_t m_head{};
+    std::size_t m_count{};
+    bool m_closing{};
+    std::time_t m_stampTime{ -1 }; ///< writer thread only
+    std::string m_stamp;           ///< writer thread only
+    std::thread m_thread;          ///< declared last so that it starts after the rest is constructed
+};
+
+} // namespace denigma
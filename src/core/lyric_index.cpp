@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/lyric_index.h"
+
+#include <utility>
+
+#include "classify/classification_cache.h"
+
+namespace denigma {
+
+namespace {
+
+/// The one index of each document; the key is unused.
+using LyricIndexTable = classify::detail::ClassificationCache::Table<int, std::shared_ptr<const LyricIndex>>;
+
+} // namespace
+
+template <typename TextType>
+void LyricIndex::addTexts(const musx::dom::DocumentPtr& document)
+{
+    auto& texts = m_texts[typeIndex<TextType>()];
+    for (const auto& lyricText : document->getTexts()->getArray<TextType>()) {
+        Syllables syllables;
+        syllables.reserve(lyricText->syllables.size());
+        for (std::size_t index = 0; index < lyricText->syllables.size(); index++) {
+            const auto& syllable = lyricText->syllables[index];
+            IndexedLyricSyllable indexed;
+            indexed.text = syllable->syllable;
+            indexed.hyphenBefore = syllable->hasHyphenBefore;
+            indexed.hyphenAfter = syllable->hasHyphenAfter;
+            indexed.hasExtender = syllable->strippedUnderscores > 0;
+            bool firstRun = true;
+            lyricText->iterateStylesForSyllable(index, [&](const std::string& chunk, const musx::util::EnigmaStyles& styles) -> bool {
+                indexed.styledText += chunk;
+                if (firstRun) {
+                    indexed.font = styles.font;
+                    firstRun = false;
+                }
+                return true;
+            });
+            syllables.emplace_back(std::move(indexed));
+        }
+        texts.emplace(lyricText->getTextNumber(), std::move(syllables));
+    }
+}
+
+std::shared_ptr<const LyricIndex> LyricIndex::forDocument(const musx::dom::DocumentPtr& document)
+{
+    return classify::detail::cachedClassification<LyricIndexTable>(document, 0, [&]() {
+        auto result = std::make_shared<LyricIndex>();
+        if (document) {
+            result->addTexts<musx::dom::texts::LyricsVerse>(document);
+            result->addTexts<musx::dom::texts::LyricsChorus>(document);
+            result->addTexts<musx::dom::texts::LyricsSection>(document);
+        }
+        return std::shared_ptr<const LyricIndex>(std::move(result));
+    });
+}
+
+} // namespace denigma
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "musx/musx.h"
+
+namespace denigma {
+
+/// @brief One syllable of a lyric text, split and styled once per document.
+struct IndexedLyricSyllable
+{
+    using FontPtr = decltype(musx::util::EnigmaStyles::font);
+
+    std::string text;           ///< the syllable as musx split it
+    std::string styledText;     ///< the syllable as its styled runs spell it
+    FontPtr font;               ///< the font of the syllable's first styled run, or null when it has none
+    bool hyphenBefore{};
+    bool hyphenAfter{};
+    bool hasExtender{};         ///< true when underscores followed the syllable in the text
+};
+
+/**
+ * @class LyricIndex
+ * @brief Every verse, chorus and section text of a document, split into syllables in one pass.
+ *
+ * Lyric assignments in every entry, of the score and of each linked part, name a syllable of a shared text. The
+ * index splits and style-parses each text once, so emitting a lyric is a lookup rather than a walk of the text.
+ */
+class LyricIndex
+{
+public:
+    using Syllables = std::vector<IndexedLyricSyllable>;
+
+    /// Returns the syllables of TextType textNumber, or nullptr when the document has no such text.
+    template <typename TextType>
+    const Syllables* findText(musx::dom::Cmper textNumber) const
+    {
+        const auto& texts = m_texts[typeIndex<TextType>()];
+        const auto it = texts.find(textNumber);
+        return it == texts.end() ? nullptr : &it->second;
+    }
+
+    /// Returns the index of document. Indexes are cached per document, so every conversion of it shares one.
+    static std::shared_ptr<const LyricIndex> forDocument(const musx::dom::DocumentPtr& document);
+
+private:
+    template <typename TextType>
+    static constexpr std::size_t typeIndex()
+    {
+        if constexpr (std::is_same_v<TextType, musx::dom::texts::LyricsVerse>) {
+            return 0;
+        } else if constexpr (std::is_same_v<TextType, musx::dom::texts::LyricsChorus>) {
+            return 1;
+        } else {
+            static_assert(std::is_same_v<TextType, musx::dom::texts::LyricsSection>, "TextType must be a lyrics text type");
+            return 2;
+        }
+    }
+
+    template <typename TextType>
+    void addTexts(const musx::dom::DocumentPtr& document);
+
+    std::array<std::unordered_map<musx::dom::Cmper, Syllables>, 3> m_texts; ///< verses, choruses and sections
+};
+
+} // namespace denigma
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "core/mapped_input_file.h"
+
+namespace denigma {
+
+MappedInputFile::MappedInputFile(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("unable to open input file");
+    }
+    LARGE_INTEGER fileSize{};
+    if (!::GetFileSizeEx(file, &fileSize)) {
+        ::CloseHandle(file);
+        throw std::runtime_error("unable to determine input file size");
+    }
+    if (static_cast<std::uint64_t>(fileSize.QuadPart) > (std::numeric_limits<std::size_t>::max)()) {
+        ::CloseHandle(file);
+        throw std::runtime_error("input file is too large to map on this platform");
+    }
+    m_size = static_cast<std::size_t>(fileSize.QuadPart);
+    if (m_size > 0) {
+        // PAGE_WRITECOPY with FILE_MAP_COPY gives each written page a private copy
+        HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (!mapping) {
+            ::CloseHandle(file);
+            throw std::runtime_error("unable to create memory mapping for input file");
+        }
+        void* view = ::MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        ::CloseHandle(mapping);
+        if (!view) {
+            ::CloseHandle(file);
+            throw std::runtime_error("unable to map input file into memory");
+        }
+        m_data = static_cast<char*>(view);
+    }
+    ::CloseHandle(file);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("unable to open input file");
+    }
+    struct stat fileStat{};
+    if (::fstat(fd, &fileStat) != 0) {
+        ::close(fd);
+        throw std::runtime_error("unable to determine input file size");
+    }
+    if (static_cast<std::uint64_t>(fileStat.st_size) > (std::numeric_limits<std::size_t>::max)()) {
+        ::close(fd);
+        throw std::runtime_error("input file is too large to map on this platform");
+    }
+    m_size = static_cast<std::size_t>(fileStat.st_size);
+    if (m_size > 0) {
+        // a read-only descriptor may still back a writable MAP_PRIVATE mapping; the mapping outlives the descriptor
+        void* view = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("unable to map input file into memory");
+        }
+#ifdef MADV_SEQUENTIAL
+        ::madvise(view, m_size, MADV_SEQUENTIAL); // parsers read it front to back
+#endif
+        m_data = static_cast<char*>(view);
+    }
+    ::close(fd);
+#endif
+}
+
+MappedInputFile::~MappedInputFile()
+{
+    if (!m_data) {
+        return;
+    }
+#ifdef _WIN32
+    ::UnmapViewOfFile(m_data);
+#else
+    ::munmap(m_data, m_size);
+#endif
+}
+
+} // namespace denigma
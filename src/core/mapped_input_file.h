@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace denigma {
+
+/**
+ * @class MappedInputFile
+ * @brief A private, copy-on-write memory mapping of a whole input file.
+ *
+ * The page cache serves the reads, so a large file is neither allocated nor copied up front, and parsing starts on
+ * the first page. Writes through #data (an in-place parse rewrites its input) copy only the pages they touch and
+ * never reach the file. The file must not be truncated by another process while it is mapped.
+ */
+class MappedInputFile
+{
+public:
+    /// Maps path; throws std::runtime_error if it cannot be opened or mapped. An empty file maps to empty data.
+    explicit MappedInputFile(const std::filesystem::path& path);
+    ~MappedInputFile();
+
+    MappedInputFile(const MappedInputFile&) = delete;
+    MappedInputFile& operator=(const MappedInputFile&) = delete;
+
+    /// The file's bytes, writable for this mapping only. Valid for the lifetime of the object.
+    std::span<char> data() const { return { m_data, m_size }; }
+
+private:
+    char* m_data{};
+    std::size_t m_size{};
+};
+
+} // namespace denigma
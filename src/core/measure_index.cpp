@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <utility>
+
+#include "core/measure_index.h"
+
+namespace denigma {
+
+MeasureIndex::MeasureIndex(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId)
+    : m_document(document), m_partId(partId), m_empty(document, partId)
+{
+    using namespace musx::dom;
+    const auto musxOthers = document->getOthers();
+    const auto measures = musxOthers->getArray<others::Measure>(partId);
+    m_measures.reserve(measures.size());
+    for (const auto& measure : measures) {
+        const MeasCmper measureId = measure->getCmper();
+        MeasureAssignments assignments(document, partId);
+        if (measure->hasExpression) {
+            assignments.expressions = musxOthers->getArray<others::MeasureExprAssign>(partId, measureId);
+        }
+        assignments.tempoChanges = musxOthers->getArray<others::TempoChange>(SCORE_PARTID, measureId);
+        if (measure->hasTextRepeat) {
+            assignments.textRepeats = musxOthers->getArray<others::TextRepeatAssign>(partId, measureId);
+        }
+        if (measure->hasSmartShape) {
+            assignments.smartShapes = musxOthers->getArray<others::SmartShapeMeasureAssign>(partId, measureId);
+        }
+        m_measures.emplace(measureId, std::move(assignments));
+    }
+}
+
+} // namespace denigma
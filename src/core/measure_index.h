@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <unordered_map>
+
+#include "musx/musx.h"
+
+namespace denigma {
+
+/**
+ * @class MeasureIndex
+ * @brief The per-measure assignment arrays of one part, fetched once for a conversion.
+ *
+ * The global, measure and smart-shape passes each need the expression, tempo, text-repeat and smart-shape
+ * assignments of every measure. Building them in one pass keeps those passes from fetching the same arrays
+ * again. The document must not be edited while the index is in use.
+ */
+class MeasureIndex
+{
+public:
+    /// The assignments attached to one measure. A list is empty when the measure flags say it has none.
+    struct MeasureAssignments
+    {
+        musx::dom::MusxInstanceList<musx::dom::others::MeasureExprAssign> expressions;        ///< expression assignments
+        musx::dom::MusxInstanceList<musx::dom::others::TempoChange> tempoChanges;             ///< tempo tool changes (always from the score)
+        musx::dom::MusxInstanceList<musx::dom::others::TextRepeatAssign> textRepeats;         ///< text repeat assignments
+        musx::dom::MusxInstanceList<musx::dom::others::SmartShapeMeasureAssign> smartShapes;  ///< smart shape assignments
+
+        MeasureAssignments(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId)
+            : expressions(document, partId), tempoChanges(document, musx::dom::SCORE_PARTID),
+              textRepeats(document, partId), smartShapes(document, partId) {}
+    };
+
+    /// Fetches the assignments of every measure of partId.
+    MeasureIndex(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId);
+
+    /// Returns the assignments of measureId, which are empty for a measure the part does not have.
+    const MeasureAssignments& get(musx::dom::MeasCmper measureId) const
+    {
+        const auto it = m_measures.find(measureId);
+        return it != m_measures.end() ? it->second : m_empty;
+    }
+
+    /// Every measure of the part, keyed by measure id, in no particular order.
+    const std::unordered_map<musx::dom::MeasCmper, MeasureAssignments>& getMeasures() const { return m_measures; }
+
+    const musx::dom::DocumentPtr& getDocument() const { return m_document; }
+    musx::dom::Cmper getPartId() const { return m_partId; }
+
+private:
+    musx::dom::DocumentPtr m_document;
+    musx::dom::Cmper m_partId;
+    MeasureAssignments m_empty;
+    std::unordered_map<musx::dom::MeasCmper, MeasureAssignments> m_measures;
+};
+
+} // namespace denigma
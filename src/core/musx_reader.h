@@ -33,8 +33,306 @@
 #undef DENIGMA_UNDEFINE_MUSX_USE_PUGIXML
 #endif
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "core/buffer_pool.h"
+#include "core/denigma.h"
+#include "core/enigma_binary_codec.h"
+
 namespace denigma {
 
-using MusxReader = ::musx::xml::pugi::Document;
+namespace detail {
+
+/// @brief Removes the child elements of xml's root element whose names fail keep, without parsing them.
+///
+/// Only the root's direct children are tokenized; each is skipped to its matching end tag, which is valid because no
+/// EnigmaXML element family nests an element of its own name. Anything unexpected at that level (text, CDATA, a
+/// DOCTYPE) leaves xml unchanged, and the caller falls back to detaching the families after parsing.
+/// @return The length of the text left at the front of xml if it was scanned, whether or not anything was removed.
+inline std::optional<std::size_t> removeRootChildElements(std::span<char> xml, bool (*keep)(std::string_view name))
+{
+    const std::string_view text(xml.data(), xml.size());
+    std::size_t pos = 0;
+    auto skipSpace = [&]() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n')) {
+            ++pos;
+        }
+    };
+    auto skipPast = [&](std::string_view terminator) {
+        const auto found = text.find(terminator, pos);
+        pos = found == std::string_view::npos ? std::string_view::npos : found + terminator.size();
+        return pos != std::string_view::npos;
+    };
+    auto readName = [&]() {
+        const std::size_t start = pos;
+        while (pos < text.size() && text[pos] != ' ' && text[pos] != '\t' && text[pos] != '\r' && text[pos] != '\n'
+               && text[pos] != '/' && text[pos] != '>') {
+            ++pos;
+        }
+        return text.substr(start, pos - start);
+    };
+    // moves past the end of a start tag and reports whether it was self-closing
+    auto skipStartTag = [&](bool& selfClosing) {
+        char quote = 0;
+        for (; pos < text.size(); ++pos) {
+            const char c = text[pos];
+            if (quote) {
+                quote = c == quote ? 0 : quote;
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                selfClosing = pos > 0 && text[pos - 1] == '/';
+                ++pos;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // prolog: declaration, processing instructions and comments
+    while (true) {
+        skipSpace();
+        if (text.substr(pos, 2) == "<?") {
+            if (!skipPast("?>")) {
+                return std::nullopt;
+            }
+        } else if (text.substr(pos, 4) == "<!--") {
+            if (!skipPast("-->")) {
+                return std::nullopt;
+            }
+        } else if (pos < text.size() && text[pos] == '<' && text.substr(pos, 2) != "<!") {
+            break;
+        } else {
+            return std::nullopt;
+        }
+    }
+    ++pos;
+    readName();
+    bool selfClosing = false;
+    if (!skipStartTag(selfClosing)) {
+        return std::nullopt;
+    }
+    if (selfClosing) {
+        return xml.size(); // an empty root has nothing to remove
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t>> removedRanges;
+    while (true) {
+        skipSpace();
+        if (pos >= text.size() || text[pos] != '<') {
+            return std::nullopt;
+        }
+        if (text.substr(pos, 4) == "<!--") {
+            if (!skipPast("-->")) {
+                return std::nullopt;
+            }
+            continue;
+        }
+        if (text.substr(pos, 2) == "</") {
+            break; // end of the root element
+        }
+        if (text.substr(pos, 2) == "<!" || text.substr(pos, 2) == "<?") {
+            return std::nullopt;
+        }
+        const std::size_t start = pos++;
+        const std::string_view name = readName();
+        if (name.empty() || !skipStartTag(selfClosing)) {
+            return std::nullopt;
+        }
+        if (!selfClosing) {
+            const std::string endTag = "</" + std::string(name);
+            while (true) {
+                if (!skipPast(endTag)) {
+                    return std::nullopt;
+                }
+                skipSpace();
+                if (pos < text.size() && text[pos] == '>') {
+                    ++pos;
+                    break;
+                }
+            }
+        }
+        if (!keep(name)) {
+            removedRanges.emplace_back(start, pos);
+        }
+    }
+
+    if (removedRanges.empty()) {
+        return xml.size();
+    }
+    auto out = xml.begin() + static_cast<std::ptrdiff_t>(removedRanges.front().first);
+    for (std::size_t index = 0; index < removedRanges.size(); index++) {
+        const std::size_t keptEnd = index + 1 < removedRanges.size() ? removedRanges[index + 1].first : xml.size();
+        const auto keptBegin = xml.begin() + static_cast<std::ptrdiff_t>(removedRanges[index].second);
+        out = std::copy(keptBegin, xml.begin() + static_cast<std::ptrdiff_t>(keptEnd), out);
+    }
+    return static_cast<std::size_t>(out - xml.begin());
+}
 
+/// @brief Removes the child elements of xml's root element whose names fail keep, shrinking xml to what is left.
+/// @return true if xml was scanned, whether or not anything was removed.
+inline bool removeRootChildElements(Buffer& xml, bool (*keep)(std::string_view name))
+{
+    const auto remaining = removeRootChildElements(std::span<char>(xml), keep);
+    if (remaining) {
+        xml.resize(*remaining);
+    }
+    return remaining.has_value();
 }
+
+} // namespace detail
+
+/// @brief Which top-level element families of an EnigmaXML document a musx reader hands to the DOM factory.
+enum class MusxLoadProfile
+{
+    Full,       ///< the whole document
+    Styles,     ///< header, options, others and texts: what style (MSS) export reads
+    Shapes,     ///< header, options and others: ShapeDef and everything a shape refers to
+    Metadata,   ///< header, options, others and texts: file info, parts, measures and pages (the `info` command)
+};
+
+/**
+ * @class BasicMusxReader
+ * @brief pugixml-backed musx XML reader that parses a buffer it owns in place.
+ *
+ * pugixml's load_buffer copies its input before parsing; parsing in place skips that copy, which is the largest
+ * allocation of a conversion. The buffer is taken over outright when it was offered with MusxReaderBufferHandoff, and
+ * an offered MappedInputFile is parsed where it is mapped, so a mapped file is never copied at all.
+ *
+ * A profile other than MusxLoadProfile::Full detaches the element families it excludes (entries and details are the
+ * bulk of any score) before the factory walks the document, so their DOM objects are never built.
+ *
+ * A binary EnigmaXML cache (see enigma_binary.h) is recognized by its magic and built into the document from its
+ * records without any XML parsing, stepping over the excluded families by their recorded length.
+ *
+ * There is no streaming (pull or SAX) variant. The factory reaches records through getRootElement and the
+ * IXmlElement navigation calls, so a reader has to hand it a complete tree, however that tree is built. On a
+ * memory-constrained worker, the ways to lower the DOM-build peak are to drop element families (a profile) and to
+ * leave out the source text (a binary cache, which decodes straight into the tree).
+ */
+template <MusxLoadProfile Profile>
+class BasicMusxReader final : public ::musx::xml::IXmlDocument
+{
+public:
+    ~BasicMusxReader() override
+    {
+        m_document.reset();
+        recycleByteBuffer(std::move(m_buffer)); // the next input on this thread inflates into it
+    }
+
+    void loadFromString(const std::string& xmlContent) override
+    { loadFromBuffer(xmlContent.data(), xmlContent.size()); }
+
+    void loadFromBuffer(const char* data, size_t size) override
+    {
+        if (enigma_binary::isEnigmaBinary(std::span<const char>(data, size))) {
+            // the document copies what it keeps, so the cache is read where it lies, even from a mapped file
+            try {
+                enigma_binary::decode(std::span<const char>(data, size), m_document,
+                    Profile == MusxLoadProfile::Full ? nullptr : &keepsElement);
+            } catch (const std::runtime_error& ex) {
+                throw ::musx::xml::load_error(ex.what());
+            }
+            removeUnreadElements();
+            return;
+        }
+        std::span<char> text;
+        if ((m_mapping = MusxReaderBufferHandoff::takeMapping(data, size))) {
+            text = m_mapping->data(); // copy-on-write, so the parse below only copies the pages it rewrites
+        } else {
+            if (auto offered = MusxReaderBufferHandoff::take(data, size)) {
+                m_buffer = std::move(*offered);
+            } else {
+                m_buffer = acquireByteBuffer(size);
+                m_buffer.assign(data, data + size);
+            }
+            text = m_buffer;
+        }
+        if constexpr (Profile != MusxLoadProfile::Full) {
+            // cutting the excluded families out of the text means pugixml never tokenizes them
+            if (const auto remaining = detail::removeRootChildElements(text, &keepsElement)) {
+                text = text.first(*remaining);
+            }
+        }
+        // musx reads no whitespace-only or trimmed text, so keep pugixml's defaults minus attribute whitespace rewriting
+        constexpr unsigned PARSE_FLAGS = ::pugi::parse_cdata | ::pugi::parse_escapes | ::pugi::parse_eol;
+        // the parse is the part of createMusxDocument this reader owns; the rest is the factory populating the pools
+        TraceSpan span("parseEnigmaXml");
+        const auto result = m_document.load_buffer_inplace(text.data(), text.size(), PARSE_FLAGS, ::pugi::encoding_utf8);
+        if (!result) {
+            throw ::musx::xml::load_error(result.description());
+        }
+        removeUnreadElements();
+    }
+
+    std::unique_ptr<::musx::xml::IXmlElement> getRootElement() const override
+    {
+        const auto root = m_document.document_element();
+        if (!root) {
+            return nullptr;
+        }
+        return std::make_unique<::musx::xml::pugi::Element>(root);
+    }
+
+private:
+    static bool keepsElement(std::string_view name)
+    {
+        if (name == "header" || name == "options" || name == "others") {
+            return true;
+        }
+        return (Profile == MusxLoadProfile::Styles || Profile == MusxLoadProfile::Metadata) && name == "texts";
+    }
+
+    /// Detaches what the profile excludes and the loaders left in place.
+    void removeUnreadElements()
+    {
+        if constexpr (Profile != MusxLoadProfile::Full) {
+            auto root = m_document.document_element();
+            for (auto child = root.first_child(); child; ) {
+                const auto next = child.next_sibling();
+                if (!keepsElement(child.name())) {
+                    root.remove_child(child); // only reached if the text scan gave up
+                } else if constexpr (Profile == MusxLoadProfile::Styles || Profile == MusxLoadProfile::Metadata) {
+                    removeUnreadStyleElements(child);
+                }
+                child = next;
+            }
+        }
+    }
+
+    /// Detaches the per-measure and per-entry records within a kept family that style export never reads. Each is only
+    /// ever referenced from the entries, details or other records removed here, so nothing left dangles.
+    static void removeUnreadStyleElements(::pugi::xml_node family)
+    {
+        auto isUnread = [](std::string_view name) {
+            return name == "smartShape" || name == "smartShapeMeasMark" || name == "measExprAssign" || name == "frameSpec"
+                || name == "chorus" || name == "section"; // lyric verses are read, choruses and sections are not
+        };
+        for (auto child = family.first_child(); child; ) {
+            const auto next = child.next_sibling();
+            if (isUnread(child.name())) {
+                family.remove_child(child);
+            }
+            child = next;
+        }
+    }
+
+    Buffer m_buffer;                ///< the parsed text; the document's strings point into it
+    std::shared_ptr<MappedInputFile> m_mapping; ///< the parsed text instead of m_buffer when a mapped file was offered
+    ::pugi::xml_document m_document;
+};
+
+using MusxReader = BasicMusxReader<MusxLoadProfile::Full>;           ///< reads the whole document
+using MusxStylesReader = BasicMusxReader<MusxLoadProfile::Styles>;   ///< reads only what style export needs
+using MusxShapesReader = BasicMusxReader<MusxLoadProfile::Shapes>;   ///< reads only what shape export needs
+using MusxMetadataReader = BasicMusxReader<MusxLoadProfile::Metadata>; ///< reads only what the `info` probe needs
+
+} // namespace denigma
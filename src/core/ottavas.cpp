@@ -17,6 +17,9 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <optional>
+
 #include "core/ottavas.h"
 
 namespace denigma {
@@ -35,45 +38,101 @@ bool isOttavaShapeType(musx::dom::others::SmartShape::ShapeType shapeType)
     }
 }
 
-OttavaShapeMap collectOttavasForMeasureStaff(
-    const musx::dom::DocumentPtr& document,
-    musx::dom::Cmper partId,
-    const musx::dom::MusxInstance<musx::dom::others::Measure>& measure,
-    musx::dom::StaffCmper staffId)
+OttavaIndex::OttavaIndex(const MeasureIndex& measureIndex)
 {
     using ShapeType = musx::dom::others::SmartShape::ShapeType;
 
-    OttavaShapeMap result;
-    if (!document || !measure || !measure->hasSmartShape) {
-        return result;
+    const auto& document = measureIndex.getDocument();
+    if (!document) {
+        return;
     }
 
-    const auto shapeAssigns = document->getOthers()->getArray<musx::dom::others::SmartShapeMeasureAssign>(partId, measure->getCmper());
-    for (const auto& assignment : shapeAssigns) {
-        if (!assignment) {
-            continue;
+    // Classify each shape once, then widen its span to every measure it is assigned to.
+    struct Candidate
+    {
+        std::optional<OttavaInstance> carrier;
+        musx::dom::MeasCmper firstMeasure{};
+        musx::dom::MeasCmper lastMeasure{};
+    };
+    std::unordered_map<musx::dom::Cmper, Candidate> candidates;
+    for (const auto& [measureId, assignments] : measureIndex.getMeasures()) {
+        for (const auto& assignment : assignments.smartShapes) {
+            if (!assignment) {
+                continue;
+            }
+            auto [it, inserted] = candidates.try_emplace(assignment->shapeNum);
+            auto& candidate = it->second;
+            if (inserted) {
+                candidate.firstMeasure = candidate.lastMeasure = measureId;
+                const auto shape = document->getOthers()->get<musx::dom::others::SmartShape>(assignment->getRequestedPartId(), assignment->shapeNum);
+                // Cheap pre-filter: only built-in ottavas and custom lines can classify as ottavas.
+                if (!shape || (!isOttavaShapeType(shape->shapeType) && shape->shapeType != ShapeType::CustomLine)) {
+                    continue;
+                }
+                const auto classification = classify::classifySmartShape(shape);
+                if (const auto* ottava = classification.as<classify::smartshape::Ottava>(); ottava && ottava->calcIsSemanticCarrier()) {
+                    candidate.carrier = OttavaInstance{ shape, *ottava };
+                }
+                continue;
+            }
+            candidate.firstMeasure = (std::min)(candidate.firstMeasure, measureId);
+            candidate.lastMeasure = (std::max)(candidate.lastMeasure, measureId);
         }
-        const auto shape = document->getOthers()->get<musx::dom::others::SmartShape>(assignment->getRequestedPartId(), assignment->shapeNum);
-        if (!shape || result.contains(shape->getCmper())) {
-            continue;
-        }
-        // Cheap pre-filter: only built-in ottavas and custom lines can classify as ottavas.
-        if (!isOttavaShapeType(shape->shapeType) && shape->shapeType != ShapeType::CustomLine) {
+    }
+
+    for (auto& [shapeId, candidate] : candidates) {
+        static_cast<void>(shapeId);
+        if (!candidate.carrier) {
             continue;
         }
-        if (shape->startTermSeg->endPoint->staffId != staffId && shape->endTermSeg->endPoint->staffId != staffId) {
-            continue;
+        const auto& shape = candidate.carrier->shape;
+        const musx::dom::StaffCmper startStaffId = shape->startTermSeg->endPoint->staffId;
+        const musx::dom::StaffCmper endStaffId = shape->endTermSeg->endPoint->staffId;
+        const Span span{ candidate.firstMeasure, candidate.lastMeasure, *candidate.carrier };
+        m_spansByStaff[startStaffId].push_back(span);
+        if (endStaffId != startStaffId) {
+            m_spansByStaff[endStaffId].push_back(span);
         }
-        const auto classification = classify::classifySmartShape(shape);
-        const auto* ottava = classification.as<classify::smartshape::Ottava>();
-        if (!ottava || !ottava->calcIsSemanticCarrier()) {
-            continue;
+    }
+    for (auto& [staffId, spans] : m_spansByStaff) {
+        static_cast<void>(staffId);
+        std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) {
+            return a.firstMeasure < b.firstMeasure;
+        });
+    }
+}
+
+OttavaShapeMap OttavaIndex::collect(const musx::dom::MusxInstance<musx::dom::others::Measure>& measure, musx::dom::StaffCmper staffId) const
+{
+    OttavaShapeMap result;
+    if (!measure || !measure->hasSmartShape) {
+        return result;
+    }
+    const auto staffIt = m_spansByStaff.find(staffId);
+    if (staffIt == m_spansByStaff.end()) {
+        return result;
+    }
+    const musx::dom::MeasCmper measureId = measure->getCmper();
+    const auto& spans = staffIt->second;
+    const auto endIt = std::upper_bound(spans.begin(), spans.end(), measureId, [](musx::dom::MeasCmper value, const Span& span) {
+        return value < span.firstMeasure;
+    });
+    for (auto it = spans.begin(); it != endIt; ++it) {
+        if (it->lastMeasure >= measureId) {
+            result.emplace(it->instance.shape->getCmper(), it->instance);
         }
-        result.emplace(shape->getCmper(), OttavaInstance{ shape, *ottava });
     }
     return result;
 }
 
+OttavaShapeMap collectOttavasForMeasureStaff(
+    const OttavaIndex& ottavaIndex,
+    const musx::dom::MusxInstance<musx::dom::others::Measure>& measure,
+    musx::dom::StaffCmper staffId)
+{
+    return ottavaIndex.collect(measure, staffId);
+}
+
 int calcOttavaOctaveAdjustment(
     const OttavaShapeMap& ottavas,
     const musx::dom::NoteInfoPtr& noteInfo,
@@ -20,7 +20,9 @@
 
 #include <functional>
 #include <unordered_map>
+#include <vector>
 
+#include "core/measure_index.h"
 #include "denigma/classify/smartshapes.h"
 #include "musx/musx.h"
 
@@ -43,10 +45,38 @@ using OttavaShapeMap = std::unordered_map<musx::dom::Cmper, OttavaInstance>;
 
 bool isOttavaShapeType(musx::dom::others::SmartShape::ShapeType shapeType);
 
+/**
+ * @class OttavaIndex
+ * @brief The semantic-carrier ottavas of one part, found and classified once, as measure spans per staff.
+ *
+ * A long ottava is assigned to every measure it spans, so classifying each measure's assignments would
+ * classify it again for every measure and staff. The index classifies each shape once and keeps the range
+ * of measures it is assigned to under its start and end staves.
+ */
+class OttavaIndex
+{
+public:
+    /// Classifies the smart shapes assigned to the measures of measureIndex.
+    explicit OttavaIndex(const MeasureIndex& measureIndex);
+
+    /// Returns the carriers assigned to measure that start or end on staffId.
+    OttavaShapeMap collect(const musx::dom::MusxInstance<musx::dom::others::Measure>& measure, musx::dom::StaffCmper staffId) const;
+
+private:
+    struct Span
+    {
+        musx::dom::MeasCmper firstMeasure{}; ///< first measure the shape is assigned to
+        musx::dom::MeasCmper lastMeasure{};  ///< last measure the shape is assigned to
+        OttavaInstance instance;
+    };
+
+    std::unordered_map<musx::dom::StaffCmper, std::vector<Span>> m_spansByStaff; ///< each sorted by firstMeasure
+};
+
 /// @brief Collects the semantic-carrier ottavas that touch the given measure and staff.
+/// ottavaIndex must be the index of the measure's part.
 OttavaShapeMap collectOttavasForMeasureStaff(
-    const musx::dom::DocumentPtr& document,
-    musx::dom::Cmper partId,
+    const OttavaIndex& ottavaIndex,
     const musx::dom::MusxInstance<musx::dom::others::Measure>& measure,
     musx::dom::StaffCmper staffId);
 
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/output_file.h"
+
+#include <string_view>
+#include <utility>
+
+#include "core/buffer_pool.h"
+
+namespace denigma {
+
+OutputWriter::OutputWriter(std::size_t maxQueuedBytes)
+    : m_maxQueuedBytes(maxQueuedBytes), m_thread([this]() { run(); })
+{
+}
+
+void OutputWriter::write(std::filesystem::path path, std::string contents)
+{
+    Document document{ std::move(path), std::move(contents) };
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_spaceFreed.wait(lock, [&]() {
+            return m_closing || m_queuedBytes == 0 || m_queuedBytes + document.contents.size() <= m_maxQueuedBytes;
+        });
+        if (!m_closing) {
+            m_queuedBytes += document.contents.size();
+            m_queue.push_back(std::move(document));
+            m_documentQueued.notify_one();
+            return;
+        }
+    }
+    writeDocument(document);
+}
+
+void OutputWriter::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closing) {
+            return;
+        }
+        m_closing = true;
+    }
+    m_documentQueued.notify_one();
+    m_spaceFreed.notify_all();
+    m_thread.join();
+}
+
+std::vector<OutputWriter::Failure> OutputWriter::failures() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failures;
+}
+
+void OutputWriter::run()
+{
+    while (true) {
+        Document document;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_documentQueued.wait(lock, [&]() { return m_closing || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                break; // closing, and everything queued is written
+            }
+            document = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        writeDocument(document);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queuedBytes -= document.contents.size();
+        }
+        m_spaceFreed.notify_all();
+    }
+}
+
+void OutputWriter::writeDocument(const Document& document)
+{
+    try {
+        std::ofstream file;
+        file.exceptions(std::ios::failbit | std::ios::badbit);
+        file.open(document.path, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(document.contents.data(), static_cast<std::streamsize>(document.contents.size()));
+        file.close();
+    } catch (const std::exception& ex) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_failures.push_back({ document.path, ex.what() });
+    }
+}
+
+OutputFile::OutputFile(const std::filesystem::path& path, std::shared_ptr<OutputArchive> archive,
+        std::shared_ptr<OutputWriter> writer)
+    : m_path(path), m_archive(std::move(archive)), m_writer(m_archive ? nullptr : std::move(writer)),
+      m_buffered(m_archive || m_writer)
+{
+    if (m_buffered) {
+        m_buffer.str(acquireStringBuffer(BufferPool<std::string>::MIN_POOLED_BYTES));
+        m_buffer.exceptions(std::ios::failbit | std::ios::badbit);
+    } else {
+        m_file.exceptions(std::ios::failbit | std::ios::badbit);
+        m_file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+}
+
+void OutputFile::close()
+{
+    if (!m_buffered) {
+        if (m_file.is_open()) {
+            m_file.close();
+        }
+        return;
+    }
+    if (const auto writer = std::exchange(m_writer, nullptr)) {
+        writer->write(m_path, std::move(m_buffer).str());
+        return;
+    }
+    if (const auto archive = std::exchange(m_archive, nullptr)) {
+        const std::string_view contents = m_buffer.view();
+        archive->add(m_path, std::span<const char>(contents.data(), contents.size()));
+        recycleStringBuffer(std::move(m_buffer).str()); // the archive copied (or compressed) the contents
+    }
+}
+
+} // namespace denigma
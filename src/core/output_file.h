@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace denigma {
+
+/**
+ * @class OutputArchive
+ * @brief Takes every output document of a run as an entry of one archive instead of a file of its own.
+ *
+ * The CLI opens one for `--output-archive`. The worker copies of the context share it, so implementations must accept
+ * entries from concurrent jobs.
+ */
+class OutputArchive
+{
+public:
+    virtual ~OutputArchive() = default;
+
+    /// Claims the entry that stands for outputPath. Returns false if the run already claimed it.
+    virtual bool reserve(const std::filesystem::path& outputPath) = 0;
+    /// Adds the complete contents of the entry for outputPath.
+    virtual void add(const std::filesystem::path& outputPath, std::span<const char> contents) = 0;
+};
+
+/**
+ * @class OutputWriter
+ * @brief Writes whole output documents to disk from a background thread.
+ *
+ * The CLI opens one for `--write-behind`, so converting threads hand over a finished document and go on to the next
+ * input instead of waiting on the disk. The queue is bounded by the bytes it holds: #write waits while adding a
+ * document would pass the bound (a document larger than the bound is still accepted into an empty queue). Documents
+ * are written in the order queued. One that cannot be written is recorded in #failures and the rest are still written.
+ */
+class OutputWriter
+{
+public:
+    static constexpr std::size_t DEFAULT_MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+
+    explicit OutputWriter(std::size_t maxQueuedBytes = DEFAULT_MAX_QUEUED_BYTES);
+    ~OutputWriter() { close(); }
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    /// Queues contents to replace whatever is at path. Documents queued after #close are written synchronously.
+    void write(std::filesystem::path path, std::string contents);
+
+    /// Writes every queued document and stops the thread. Safe to call more than once.
+    void close();
+
+    /// A document that could not be written.
+    struct Failure
+    {
+        std::filesystem::path path;
+        std::string message;
+    };
+
+    /// The documents that could not be written. Complete once #close has returned.
+    std::vector<Failure> failures() const;
+
+private:
+    struct Document
+    {
+        std::filesystem::path path;
+        std::string contents;
+    };
+
+    void run();
+    void writeDocument(const Document& document);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_documentQueued;
+    std::condition_variable m_spaceFreed;
+    std::deque<Document> m_queue;
+    std::size_t m_maxQueuedBytes{};
+    std::size_t m_queuedBytes{};   ///< includes the document being written, so memory stays within the bound
+    bool m_closing{};
+    std::vector<Failure> m_failures;
+    std::thread m_thread;
+};
+
+/**
+ * @class OutputFile
+ * @brief One output document of a CLI run: its own file, or an entry of the run's OutputArchive.
+ *
+ * With an archive the document is buffered, and #close adds it as one entry, so concurrent jobs never interleave
+ * their bytes. With a writer (and no archive) the document is buffered too, and #close queues it on the writer.
+ * The stream throws std::ios_base::failure when a write fails.
+ */
+class OutputFile
+{
+public:
+    /// Opens path for binary writing, truncating it, or starts a buffer for it when archive or writer is set.
+    /// @throws std::ios_base::failure if the file cannot be opened.
+    OutputFile(const std::filesystem::path& path, std::shared_ptr<OutputArchive> archive,
+        std::shared_ptr<OutputWriter> writer = nullptr);
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    /// The stream the document is written to.
+    std::ostream& stream() { return m_buffered ? static_cast<std::ostream&>(m_buffer) : m_file; }
+
+    /// Appends data to the document.
+    void write(std::span<const char> data) { stream().write(data.data(), static_cast<std::streamsize>(data.size())); }
+
+    /// Closes the file, or hands the buffered document to the archive or writer. Nothing is handed over if #close is
+    /// never called.
+    void close();
+
+private:
+    std::filesystem::path m_path;
+    std::shared_ptr<OutputArchive> m_archive;
+    std::shared_ptr<OutputWriter> m_writer;
+    bool m_buffered{};
+    std::ofstream m_file;
+    std::ostringstream m_buffer;
+};
+
+} // namespace denigma
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "musx/musx.h"
+#include "musx/util/Arpeggio.h"
+
+namespace denigma {
+
+/// @brief A 128-bit key packed from musx ids. Used to dedupe deferred spans without building strings.
+struct PackedIdKey
+{
+    std::uint64_t high{};
+    std::uint64_t low{};
+
+    bool operator==(const PackedIdKey&) const = default;
+};
+
+struct PackedIdKeyHash
+{
+    std::size_t operator()(const PackedIdKey& key) const noexcept
+    {
+        // splitmix64 finalizer over both halves, so keys that differ in either half spread across buckets
+        std::uint64_t value = (key.high * 0x9E3779B97F4A7C15ull) ^ key.low;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<std::size_t>(value ^ (value >> 31));
+    }
+};
+
+/// Packs an entry number and note id into one value, unique within a document.
+inline std::uint64_t packedNoteId(musx::dom::EntryNumber entryNumber, musx::dom::NoteNumber noteId)
+{
+    return (std::uint64_t(static_cast<std::uint32_t>(entryNumber)) << 32) | std::uint64_t(static_cast<std::uint32_t>(noteId));
+}
+
+inline std::uint64_t packedNoteId(const musx::dom::NoteInfoPtr& noteInfo)
+{
+    return packedNoteId(noteInfo.getEntryInfo()->getEntry()->getEntryNumber(), noteInfo->getNoteId());
+}
+
+/// Identifies a tie from startNote to endNote.
+inline PackedIdKey jumpTieKey(const musx::dom::NoteInfoPtr& startNote, const musx::dom::NoteInfoPtr& endNote)
+{
+    return { packedNoteId(startNote), packedNoteId(endNote) };
+}
+
+/// Identifies an arpeggio span by its shape and boundary entries. The entry that found the span is not part of
+/// the key, so the same span found from each of its segment entries is only kept once.
+inline PackedIdKey arpeggioSpanKey(const musx::util::ArpeggioSpanCandidate& candidate)
+{
+    const auto entryNumberOf = [](const musx::dom::EntryInfoPtr& entryInfo) -> std::uint32_t {
+        return entryInfo ? static_cast<std::uint32_t>(entryInfo->getEntry()->getEntryNumber()) : 0;
+    };
+    const std::uint64_t shape = std::uint64_t(static_cast<std::uint8_t>(candidate.type))
+        | (std::uint64_t(static_cast<std::uint8_t>(candidate.direction)) << 8)
+        | (std::uint64_t(static_cast<std::uint8_t>(candidate.arrow)) << 16);
+    return { shape, (std::uint64_t(entryNumberOf(candidate.topEntry)) << 32) | entryNumberOf(candidate.bottomEntry) };
+}
+
+} // namespace denigma
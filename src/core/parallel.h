@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "core/denigma.h"
+#include "core/host_resources.h"
+
+namespace denigma {
+
+/// Resolves a requested job count (0 means all available cores, see HostResources) against the number of work items.
+inline std::size_t resolveJobCount(unsigned requestedJobs, std::size_t itemCount)
+{
+#if defined(DENIGMA_SINGLE_THREADED)
+    (void)requestedJobs;
+    return (std::min)(std::size_t(1), itemCount); // no threads to start
+#else
+    std::size_t jobCount = requestedJobs;
+    if (jobCount == 0) {
+        jobCount = availableCpuCount();
+    }
+    return (std::min)(jobCount, itemCount);
+#endif
+}
+
+/// Resolves denigmaContext.outputJobs against the number of work items. 0 means the executor's concurrency when
+/// the context has an executor, or else all available cores.
+inline std::size_t resolveJobCount(const DenigmaContext& denigmaContext, std::size_t itemCount)
+{
+    if (denigmaContext.outputJobs == 0 && denigmaContext.executor) {
+        return (std::min)(std::size_t((std::max)(denigmaContext.executor->concurrency(), 1u)), itemCount);
+    }
+    return resolveJobCount(denigmaContext.outputJobs, itemCount);
+}
+
+namespace detail {
+
+/**
+ * @class ConcurrentWorkers
+ * @brief Runs copies of one work function concurrently with the calling thread, on the context's executor when it
+ * has one and on threads of its own otherwise, and waits for them in #join.
+ *
+ * Executor tasks may start late or never, so #join waits only for the tasks that have started; a task that starts
+ * after #join does nothing. Work that must happen therefore cannot be left to the tasks alone: the caller claims
+ * whatever no task has picked up by the time it needs it. work must not throw.
+ */
+class ConcurrentWorkers
+{
+public:
+    ConcurrentWorkers(const DenigmaContext& denigmaContext, std::function<void()> work)
+        : m_executor(denigmaContext.executor), m_work(std::move(work))
+    {
+    }
+    ConcurrentWorkers(IExecutor* executor, std::function<void()> work)
+        : m_executor(executor), m_work(std::move(work))
+    {
+    }
+    ~ConcurrentWorkers() { join(); }
+
+    ConcurrentWorkers(const ConcurrentWorkers&) = delete;
+    ConcurrentWorkers& operator=(const ConcurrentWorkers&) = delete;
+
+    /// Whether the workers run on an executor, which the caller must help out as described above.
+    bool onExecutor() const { return m_executor != nullptr; }
+
+    /// Starts count more copies of the work.
+    void start(std::size_t count)
+    {
+        for (std::size_t index = 0; index < count; index++) {
+            if (m_executor) {
+                m_executor->submit([gate = m_gate, this]() {
+                    if (gate->enter()) {
+                        m_work();
+                        gate->leave();
+                    }
+                });
+            } else {
+                m_threads.emplace_back(m_work);
+            }
+        }
+    }
+
+    /// Waits for every copy of the work that has started. Safe to call more than once.
+    void join()
+    {
+        m_gate->close();
+        m_threads.clear(); // joins
+    }
+
+private:
+    class Gate
+    {
+    public:
+        bool enter()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running += m_closed ? 0 : 1;
+            return !m_closed;
+        }
+
+        void leave()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                --m_running;
+            }
+            m_idle.notify_all();
+        }
+
+        void close()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_idle.wait(lock, [this]() { return m_running == 0; });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_idle;
+        std::size_t m_running{};
+        bool m_closed{};
+    };
+
+    IExecutor* m_executor;
+    std::function<void()> m_work;
+    std::shared_ptr<Gate> m_gate{ std::make_shared<Gate>() }; ///< shared with the tasks, which can outlive this object
+    std::vector<std::jthread> m_threads;
+};
+
+/// Returns the copy of denigmaContext that work for another thread runs against: its messages are buffered for
+/// replay rather than sent out, it times nothing, and it runs nested parallel steps serially.
+inline DenigmaContext makeWorkerContext(const DenigmaContext& denigmaContext)
+{
+    DenigmaContext workerContext(denigmaContext);
+    workerContext.conversionResult = nullptr;
+    workerContext.logCallback = nullptr;
+    workerContext.outputJobs = 1;
+    return workerContext;
+}
+
+} // namespace detail
+
+/// @brief Builds count independent results concurrently and consumes them in index order.
+///
+/// produce(context, index) runs on up to denigmaContext.outputJobs workers: tasks on denigmaContext.executor when it
+/// is set, or else threads. Each worker gets its own copy of denigmaContext whose messages are buffered; they are
+/// replayed on denigmaContext just before consume(index, result) runs on the calling thread, so logs and outputs keep
+/// the serial order.
+/// The worker copies have outputJobs set to 1, so a forEachInOrder nested inside produce runs serially
+/// rather than multiplying the thread count.
+/// A worker does not start an item until the items more than outputJobs places before it have been consumed,
+/// so at most outputJobs results are held at once no matter how far the workers could run ahead.
+/// On an executor the calling thread is one of the workers: it produces the next item to consume itself if no task
+/// has taken it yet, so the step completes even when the executor is too busy to start its tasks.
+/// With a single job everything runs serially on the calling thread against denigmaContext itself.
+/// The first exception thrown by produce or consume stops scheduling new items and is rethrown. Each item starts with
+/// DenigmaContext::checkCancelled, so a cancelled conversion stops between items.
+template <typename Result, typename Produce, typename Consume>
+void forEachInOrder(std::size_t count, const DenigmaContext& denigmaContext, Produce&& produce, Consume&& consume)
+{
+    const std::size_t jobCount = resolveJobCount(denigmaContext, count);
+    if (jobCount <= 1) {
+        for (std::size_t index = 0; index < count; index++) {
+            denigmaContext.checkCancelled();
+            consume(index, produce(denigmaContext, index));
+        }
+        return;
+    }
+
+    struct Slot
+    {
+        std::optional<Result> result;
+        std::vector<DenigmaContext::BufferedLogMessage> log;
+        std::exception_ptr error;
+        bool done{};
+    };
+    std::vector<Slot> slots(count);
+    std::mutex slotMutex;
+    std::condition_variable slotReady;
+    std::atomic<std::size_t> nextIndex{ 0 };
+    std::atomic<bool> stopRequested{ false };
+    std::size_t consumedCount = 0; // guarded by slotMutex
+    bool consumerDone = false;     // guarded by slotMutex
+    std::condition_variable slotConsumed;
+
+    auto produceItem = [&](DenigmaContext& workerContext, std::size_t index) {
+        Slot& slot = slots[index];
+        workerContext.logBuffer = &slot.log;
+        std::optional<Result> result;
+        std::exception_ptr error;
+        try {
+            workerContext.checkCancelled();
+            result.emplace(produce(std::as_const(workerContext), index));
+        } catch (...) {
+            error = std::current_exception();
+            stopRequested = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            slot.result = std::move(result);
+            slot.error = error;
+            slot.done = true;
+        }
+        slotReady.notify_all();
+    };
+
+    const std::uint32_t traceFile = TraceFileScope::current();
+    // copied here rather than from denigmaContext by each worker, which may start while the caller is logging on it
+    const DenigmaContext workerTemplate = detail::makeWorkerContext(denigmaContext);
+    detail::ConcurrentWorkers workers(denigmaContext, [&]() {
+        nameTraceThread("output worker");
+        TraceFileScope traceFileScope(traceFile);
+        DenigmaContext workerContext(workerTemplate);
+        MusxLoggerScope musxLogger(makeMusxLogCallback(workerContext));
+        HotPathThreadScope hotPaths(workerContext.hotPathCounters);
+        while (!stopRequested) {
+            const std::size_t index = nextIndex++;
+            if (index >= count) {
+                break;
+            }
+            {
+                std::unique_lock<std::mutex> lock(slotMutex);
+                // an item already taken must still be produced unless the consumer is gone, since it may be waiting for it
+                slotConsumed.wait(lock, [&]() { return consumerDone || index < consumedCount + jobCount; });
+                if (consumerDone) {
+                    break;
+                }
+            }
+            produceItem(workerContext, index);
+        }
+    });
+    struct StopOnExit
+    {
+        std::atomic<bool>& stopRequested;
+        std::mutex& slotMutex;
+        bool& consumerDone;
+        std::condition_variable& slotConsumed;
+        ~StopOnExit()
+        {
+            stopRequested = true;
+            {
+                std::lock_guard<std::mutex> lock(slotMutex);
+                consumerDone = true;
+            }
+            slotConsumed.notify_all();
+        }
+    } stopOnExit{ stopRequested, slotMutex, consumerDone, slotConsumed }; // destroyed before workers, so an exception from consume lets them wind down
+    const bool callerProduces = workers.onExecutor();
+    workers.start(callerProduces ? jobCount - 1 : jobCount);
+    std::optional<DenigmaContext> callerContext;
+
+    for (std::size_t index = 0; index < count; index++) {
+        Slot& slot = slots[index];
+        // every earlier item has been taken, so index is the next to take unless a worker already has it
+        std::size_t unclaimed = index;
+        if (callerProduces && nextIndex.compare_exchange_strong(unclaimed, index + 1)) {
+            if (!callerContext) {
+                callerContext.emplace(workerTemplate);
+            }
+            MusxLoggerScope musxLogger(makeMusxLogCallback(*callerContext));
+            produceItem(*callerContext, index);
+        }
+        {
+            std::unique_lock<std::mutex> lock(slotMutex);
+            slotReady.wait(lock, [&slot]() { return slot.done; });
+        }
+        denigmaContext.logCapturedMessages(slot.log);
+        slot.log = {};
+        if (slot.error) {
+            std::rethrow_exception(slot.error);
+        }
+        consume(index, std::move(*slot.result));
+        slot.result.reset();
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            consumedCount = index + 1;
+        }
+        slotConsumed.notify_all();
+    }
+}
+
+/// @brief Runs background while foreground runs on the calling thread, and returns once both are done.
+///
+/// background runs as a task on denigmaContext.executor when it is set, or else on a thread of its own. If the
+/// executor has not started it by the time foreground finishes, it runs on the calling thread instead. background
+/// must not throw.
+template <typename Background, typename Foreground>
+void runAlongside(const DenigmaContext& denigmaContext, Background&& background, Foreground&& foreground)
+{
+    std::atomic<bool> claimed{ false };
+    auto runOnce = [&]() {
+        if (!claimed.exchange(true)) {
+            background();
+        }
+    };
+    detail::ConcurrentWorkers workers(denigmaContext, runOnce);
+    workers.start(1);
+    foreground();
+    runOnce();
+    workers.join();
+}
+
+} // namespace denigma
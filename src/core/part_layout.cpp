@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/part_layout.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "classify/classification_cache.h"
+
+namespace denigma {
+
+namespace {
+
+using PartLayoutTable = classify::detail::ClassificationCache::Table<musx::dom::Cmper, std::shared_ptr<const PartLayout>>;
+
+template <typename Item, typename Id>
+const Item* findById(const std::vector<Item>& items, Id id)
+{
+    const auto it = std::lower_bound(items.begin(), items.end(), id, [](const Item& item, Id value) { return item.id < value; });
+    return it != items.end() && it->id == id ? &*it : nullptr;
+}
+
+} // namespace
+
+bool PartLayout::System::containsStaff(musx::dom::StaffCmper staffId) const
+{
+    return std::find(staves.begin(), staves.end(), staffId) != staves.end();
+}
+
+PartLayout::PartLayout(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId)
+{
+    using namespace musx::dom;
+    const auto pool = document->getOthers();
+
+    const auto systems = pool->getArray<others::StaffSystem>(partId);
+    m_systems.reserve(systems.size());
+    for (const auto& system : systems) {
+        System& item = m_systems.emplace_back();
+        item.id = system->getCmper();
+        item.startMeas = system->startMeas;
+        item.endMeas = system->endMeas;
+        item.top = system->top;
+        item.distanceToPrev = system->distanceToPrev;
+        item.staffSizes = system->calcMinMaxStaffSizes();
+        const auto staves = pool->getArray<others::StaffUsed>(partId, system->getCmper());
+        item.staves.reserve(staves.size());
+        for (const auto& staffSlot : staves) {
+            item.staves.push_back(staffSlot->staffId);
+        }
+    }
+    std::sort(m_systems.begin(), m_systems.end(), [](const System& a, const System& b) { return a.id < b.id; });
+
+    const auto pages = pool->getArray<others::Page>(partId);
+    m_pages.reserve(pages.size());
+    for (const auto& page : pages) {
+        Page& item = m_pages.emplace_back();
+        item.id = page->getCmper();
+        item.holdMargins = page->holdMargins;
+        item.blank = page->isBlank();
+        item.firstSystem = page->firstSystemId;
+        item.lastSystem = page->lastSystemId;
+    }
+    std::sort(m_pages.begin(), m_pages.end(), [](const Page& a, const Page& b) { return a.id < b.id; });
+}
+
+std::shared_ptr<const PartLayout> PartLayout::forPart(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId)
+{
+    return classify::detail::cachedClassification<PartLayoutTable>(document, partId, [&]() {
+        return std::shared_ptr<const PartLayout>(std::make_shared<PartLayout>(document, partId));
+    });
+}
+
+const PartLayout::System* PartLayout::findSystem(musx::dom::SystemCmper systemId) const
+{
+    return findById(m_systems, systemId);
+}
+
+const PartLayout::Page* PartLayout::findPage(musx::dom::PageCmper pageId) const
+{
+    return findById(m_pages, pageId);
+}
+
+const PartLayout::System* PartLayout::findSystemForMeasure(musx::dom::MeasCmper measureId) const
+{
+    // systems run in measure order, so the one in question is the last to start at or before measureId
+    const auto it = std::upper_bound(m_systems.begin(), m_systems.end(), measureId,
+        [](musx::dom::MeasCmper value, const System& system) { return value < system.startMeas; });
+    return it == m_systems.begin() ? nullptr : &*std::prev(it);
+}
+
+} // namespace denigma
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "musx/musx.h"
+
+namespace denigma {
+
+/**
+ * @class PartLayout
+ * @brief The page and system layout of one part, in EVPU, read once per document.
+ *
+ * MusicXML defaults, staff attributes and jumps, MNX layouts and pages, and MSS page styles each read the systems
+ * of a part and the staves on each. The layout is plain values, so it is cached with the document and every
+ * conversion of the part shares it.
+ */
+class PartLayout
+{
+public:
+    using StaffSizes = decltype(std::declval<const musx::dom::others::StaffSystem&>().calcMinMaxStaffSizes());
+
+    /// One staff system and the staves it shows.
+    struct System
+    {
+        musx::dom::SystemCmper id{};
+        musx::dom::MeasCmper startMeas{};
+        musx::dom::MeasCmper endMeas{};
+        musx::dom::Evpu top{};                      ///< the system's top margin
+        musx::dom::Evpu distanceToPrev{};           ///< the distance from the previous system
+        StaffSizes staffSizes{};                    ///< the smallest and largest staff size on the system
+        std::vector<musx::dom::StaffCmper> staves;  ///< the system's staves, top to bottom
+
+        bool containsStaff(musx::dom::StaffCmper staffId) const;
+    };
+
+    /// One page and the systems on it.
+    struct Page
+    {
+        musx::dom::PageCmper id{};
+        bool holdMargins{};
+        bool blank{};
+        musx::dom::SystemCmper firstSystem{};
+        std::optional<musx::dom::SystemCmper> lastSystem;  ///< none when the page has no systems
+    };
+
+    /// Reads the layout of partId.
+    PartLayout(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId);
+
+    /// Returns the layout of partId. Layouts are cached per document, so it is read once however many conversions use it.
+    static std::shared_ptr<const PartLayout> forPart(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId);
+
+    const std::vector<System>& getSystems() const { return m_systems; }
+    const std::vector<Page>& getPages() const { return m_pages; }
+
+    /// Returns system systemId, or nullptr if the part has no such system.
+    const System* findSystem(musx::dom::SystemCmper systemId) const;
+    /// Returns page pageId, or nullptr if the part has no such page.
+    const Page* findPage(musx::dom::PageCmper pageId) const;
+    /// Returns the last system starting at or before measureId, or nullptr if there is none.
+    const System* findSystemForMeasure(musx::dom::MeasCmper measureId) const;
+
+private:
+    std::vector<System> m_systems;  ///< ordered by id
+    std::vector<Page> m_pages;      ///< ordered by id
+};
+
+} // namespace denigma
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "core/smartshape_index.h"
+
+namespace denigma {
+
+SmartShapeStartIndex::SmartShapeStartIndex(const MeasureIndex& measureIndex)
+{
+    using namespace musx::dom;
+
+    const auto& document = measureIndex.getDocument();
+    if (!document) {
+        return;
+    }
+    const auto musxOthers = document->getOthers();
+    for (const auto& [measureId, assignments] : measureIndex.getMeasures()) {
+        for (const auto& assignment : assignments.smartShapes) {
+            if (!assignment || assignment->centerShapeNum != 0) {
+                continue;
+            }
+            auto shape = musxOthers->get<others::SmartShape>(SCORE_PARTID, assignment->shapeNum);
+            if (!shape || !shape->startTermSeg || !shape->startTermSeg->endPoint) {
+                continue;
+            }
+            const auto& start = shape->startTermSeg->endPoint;
+            if (start->measId != measureId) {
+                continue; // the assignment in the end measure
+            }
+            auto classification = classify::classifySmartShape(shape);
+            m_shapes[key(measureId, start->staffId)].push_back({ std::move(shape), std::move(classification) });
+        }
+    }
+}
+
+} // namespace denigma
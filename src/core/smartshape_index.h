@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "core/measure_index.h"
+#include "denigma/classify/smartshapes.h"
+#include "musx/musx.h"
+
+namespace denigma {
+
+/// @struct StartingSmartShape
+/// @brief A smart shape assigned to the measure it starts in, together with its classification.
+struct StartingSmartShape
+{
+    musx::dom::MusxInstance<musx::dom::others::SmartShape> shape;  ///< The shape, from the score.
+    classify::SmartShapeClassification classification;             ///< Its classification.
+};
+
+/**
+ * @class SmartShapeStartIndex
+ * @brief The smart shapes of one part bucketed by the measure and staff they start on, each classified once.
+ *
+ * The smart-shape passes run once per measure and staff. Scanning the measure's assignments for each staff fetched
+ * and tested every shape of the measure again for every staff; the index does that once for the whole part.
+ * Only the assignment in a shape's start measure that is not a center assignment is kept, which is the one both
+ * converters emit the shape from. The document must not be edited while the index is in use.
+ */
+class SmartShapeStartIndex
+{
+public:
+    /// Buckets the smart shapes assigned to the measures of measureIndex.
+    explicit SmartShapeStartIndex(const MeasureIndex& measureIndex);
+
+    /// Returns the shapes that start in measureId on staffId, in assignment order.
+    std::span<const StartingSmartShape> get(musx::dom::MeasCmper measureId, musx::dom::StaffCmper staffId) const
+    {
+        const auto it = m_shapes.find(key(measureId, staffId));
+        return it != m_shapes.end() ? std::span<const StartingSmartShape>(it->second) : std::span<const StartingSmartShape>();
+    }
+
+private:
+    static std::uint64_t key(musx::dom::MeasCmper measureId, musx::dom::StaffCmper staffId)
+    {
+        return (std::uint64_t(static_cast<std::uint32_t>(measureId)) << 32) | std::uint64_t(static_cast<std::uint32_t>(staffId));
+    }
+
+    std::unordered_map<std::uint64_t, std::vector<StartingSmartShape>> m_shapes;
+};
+
+} // namespace denigma
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include "musx/musx.h"
+
+namespace denigma {
+
+/**
+ * @class StaffCompositeCache
+ * @brief Memoizes musx::dom::others::StaffComposite::createCurrent for one conversion.
+ *
+ * Building a composite staff walks the staff-style assignments every time. Converters ask for the same
+ * (part, staff, measure, edu) composite from several passes, so they share one of these per conversion.
+ * The document must not be edited while the cache is in use.
+ */
+class StaffCompositeCache
+{
+public:
+    using StaffCompositePtr = decltype(musx::dom::others::StaffComposite::createCurrent(
+        std::declval<const musx::dom::DocumentPtr&>(), musx::dom::Cmper{}, musx::dom::StaffCmper{}, musx::dom::MeasCmper{}, musx::dom::Edu{}));
+
+    /// Returns the same value as StaffComposite::createCurrent, building it only on the first request.
+    StaffCompositePtr get(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId, musx::dom::StaffCmper staffId,
+        musx::dom::MeasCmper measureId, musx::dom::Edu eduPosition)
+    {
+        const Key key{ partId, staffId, measureId, eduPosition };
+        if (const auto it = m_staves.find(key); it != m_staves.end()) {
+            return it->second;
+        }
+        auto staff = musx::dom::others::StaffComposite::createCurrent(document, partId, staffId, measureId, eduPosition);
+        m_staves.emplace(key, staff);
+        return staff;
+    }
+
+    void clear() { m_staves.clear(); }
+
+    /// Moves the composites other built into this cache. Entries already here are kept.
+    void mergeFrom(StaffCompositeCache&& other)
+    {
+        m_staves.merge(other.m_staves);
+        other.clear();
+    }
+
+private:
+    using Key = std::tuple<musx::dom::Cmper, musx::dom::StaffCmper, musx::dom::MeasCmper, musx::dom::Edu>;
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            const auto [partId, staffId, measureId, eduPosition] = key;
+            std::size_t result = std::hash<musx::dom::Cmper>{}(partId);
+            result = result * 31 + std::hash<musx::dom::StaffCmper>{}(staffId);
+            result = result * 31 + std::hash<musx::dom::MeasCmper>{}(measureId);
+            return result * 31 + std::hash<musx::dom::Edu>{}(eduPosition);
+        }
+    };
+
+    std::unordered_map<Key, StaffCompositePtr, KeyHash> m_staves;
+};
+
+} // namespace denigma
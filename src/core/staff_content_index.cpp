@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "core/staff_content_index.h"
+
+namespace denigma {
+
+StaffContentIndex::StaffContentIndex(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId)
+{
+    using namespace musx::dom;
+
+    if (!document) {
+        return;
+    }
+    const auto addFrames = [&](Cmper forPartId) {
+        for (const auto& frameHold : document->getDetails()->getArray<details::GFrameHold>(forPartId)) {
+            if (frameHold && frameHold->getMeasure() > 0) {
+                m_measures[frameHold->getStaff()].insert(frameHold->getMeasure());
+            }
+        }
+    };
+    addFrames(SCORE_PARTID);
+    if (partId != SCORE_PARTID) {
+        addFrames(partId);
+    }
+}
+
+} // namespace denigma
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <unordered_map>
+
+#include "utils/dense_index_set.h"
+#include "musx/musx.h"
+
+namespace denigma {
+
+/**
+ * @class StaffContentIndex
+ * @brief The measures of each staff that have a frame-hold record, gathered once for a part.
+ *
+ * A staff with no frame-hold record in a measure has no entries there, and both converters reduce it to a
+ * full-measure rest or to nothing. Checking the index lets the note passes skip the ottava, pickup and frame
+ * work for those cells. The records of the score and of the part are both counted, so a cell reported empty
+ * has no record in either. The document must not be edited while the index is in use.
+ */
+class StaffContentIndex
+{
+public:
+    /// Collects the frame-hold records of partId.
+    StaffContentIndex(const musx::dom::DocumentPtr& document, musx::dom::Cmper partId);
+
+    /// Returns true if staffId has a frame-hold record in measureId.
+    bool hasFrames(musx::dom::MeasCmper measureId, musx::dom::StaffCmper staffId) const
+    {
+        const auto it = m_measures.find(staffId);
+        return it != m_measures.end() && it->second.contains(measureId);
+    }
+
+private:
+    std::unordered_map<musx::dom::StaffCmper, utils::DenseIndexSet<musx::dom::MeasCmper>> m_measures;
+};
+
+} // namespace denigma
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/trace.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "utils/stringutils.h"
+#include "utils/text_escape.h"
+
+namespace denigma {
+
+namespace {
+
+thread_local std::uint32_t t_traceThread{};   ///< 0 until the thread records or is named
+thread_local std::uint32_t t_traceFile{};
+
+std::uint32_t traceThreadId()
+{
+    static std::atomic<std::uint32_t> nextThread{ 1 };
+    if (t_traceThread == 0) {
+        t_traceThread = nextThread.fetch_add(1, std::memory_order_relaxed);
+    }
+    return t_traceThread;
+}
+
+void writeJsonString(std::ostream& out, std::string_view text)
+{
+    std::string escaped;
+    escaped.reserve(text.size() + 2);
+    escaped += '"';
+    utils::appendJsonEscaped(escaped, text);
+    escaped += '"';
+    out << escaped;
+}
+
+} // namespace
+
+TraceRecorder::TraceRecorder(std::filesystem::path path)
+    : m_path(std::move(path)), m_start(std::chrono::steady_clock::now())
+{
+    TraceRecorder* expected = nullptr;
+    m_recording = s_active.compare_exchange_strong(expected, this);
+    if (m_recording) {
+        nameThread("main");
+    }
+}
+
+bool TraceRecorder::finish()
+{
+    if (!m_recording) {
+        return true;
+    }
+    m_recording = false;
+    s_active.store(nullptr);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return write();
+}
+
+void TraceRecorder::record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    const Event event{ name, traceThreadId(), t_traceFile, start - m_start, end - start };
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.push_back(event);
+}
+
+std::uint32_t TraceRecorder::fileIndex(std::string_view file)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::size_t index = 0; index < m_files.size(); index++) {
+        if (m_files[index] == file) {
+            return static_cast<std::uint32_t>(index + 1);
+        }
+    }
+    m_files.emplace_back(file);
+    return static_cast<std::uint32_t>(m_files.size());
+}
+
+void TraceRecorder::nameThread(std::string_view name)
+{
+    const auto thread = traceThreadId();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threadNames[thread] = std::string(name) + " " + std::to_string(thread);
+}
+
+bool TraceRecorder::write() const
+{
+    std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    // timestamps are microseconds; three decimals keep nanosecond resolution
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separate = [&]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+    for (const auto& [thread, name] : m_threadNames) {
+        separate();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":";
+        writeJsonString(out, name);
+        out << "}}";
+    }
+    for (const auto& event : m_events) {
+        separate();
+        out << "{\"name\":";
+        writeJsonString(out, event.name);
+        out << ",\"cat\":\"denigma\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << static_cast<double>(event.start.count()) / 1000.0
+            << ",\"dur\":" << static_cast<double>(event.duration.count()) / 1000.0;
+        if (event.file > 0 && event.file <= m_files.size()) {
+            out << ",\"args\":{\"file\":";
+            writeJsonString(out, m_files[event.file - 1]);
+            out << '}';
+        }
+        out << '}';
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out.flush());
+}
+
+TraceFileScope::TraceFileScope(std::string_view file)
+    : m_previous(t_traceFile)
+{
+    if (auto* recorder = TraceRecorder::active(); recorder && !file.empty()) {
+        t_traceFile = recorder->fileIndex(file);
+    }
+}
+
+TraceFileScope::TraceFileScope(const std::filesystem::path& file)
+    : m_previous(t_traceFile)
+{
+    if (auto* recorder = TraceRecorder::active()) {
+        t_traceFile = recorder->fileIndex(utils::pathToString(file));
+    }
+}
+
+TraceFileScope::TraceFileScope(std::uint32_t fileIndex)
+    : m_previous(t_traceFile)
+{
+    t_traceFile = fileIndex;
+}
+
+TraceFileScope::~TraceFileScope()
+{
+    t_traceFile = m_previous;
+}
+
+std::uint32_t TraceFileScope::current() noexcept
+{
+    return t_traceFile;
+}
+
+void nameTraceThread(std::string_view name)
+{
+    if (auto* recorder = TraceRecorder::active()) {
+        recorder->nameThread(name);
+    }
+}
+
+SlowFileThreshold SlowFileThreshold::parse(std::string_view text)
+{
+    const auto invalid = [&]() {
+        return std::invalid_argument("Invalid value for --trace-slow: " + std::string(text)
+            + " (expected seconds, a median multiple such as 10x, or both joined by a comma)");
+    };
+    SlowFileThreshold result;
+    std::string_view rest = text;
+    while (true) {
+        const auto comma = rest.find(',');
+        std::string_view part = rest.substr(0, comma);
+        const bool multiple = !part.empty() && (part.back() == 'x' || part.back() == 'X');
+        if (multiple) {
+            part.remove_suffix(1);
+        }
+        double value = 0;
+        const auto [end, error] = std::from_chars(part.data(), part.data() + part.size(), value);
+        if (part.empty() || error != std::errc() || end != part.data() + part.size() || !(value > 0)) {
+            throw invalid();
+        }
+        if (multiple) {
+            result.medianMultiple = value;
+        } else {
+            result.minimum = std::chrono::duration<double>(value);
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        rest.remove_prefix(comma + 1);
+    }
+    return result;
+}
+
+SlowFileTracer::SlowFileTracer(SlowFileThreshold threshold, std::filesystem::path traceDirectory, std::string namePrefix)
+    : m_threshold(threshold), m_traceDirectory(std::move(traceDirectory)), m_namePrefix(std::move(namePrefix))
+{
+    m_window.reserve(MEDIAN_WINDOW);
+}
+
+bool SlowFileTracer::observe(std::chrono::steady_clock::duration elapsed)
+{
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const bool overMinimum = seconds > m_threshold.minimum.count();
+    if (m_threshold.medianMultiple <= 0) {
+        return overMinimum;
+    }
+    std::lock_guard lock(m_mutex);
+    bool slow = overMinimum && m_window.size() >= MIN_MEDIAN_SAMPLES;
+    if (slow) {
+        std::vector<double> sorted(m_window);
+        const auto middle = sorted.begin() + static_cast<std::ptrdiff_t>(sorted.size() / 2);
+        std::nth_element(sorted.begin(), middle, sorted.end());
+        slow = seconds > *middle * m_threshold.medianMultiple;
+    }
+    // the input's own time joins the window after it was judged against the others
+    if (m_window.size() < MEDIAN_WINDOW) {
+        m_window.push_back(seconds);
+    } else {
+        m_window[m_nextSample] = seconds;
+        m_nextSample = (m_nextSample + 1) % MEDIAN_WINDOW;
+    }
+    return slow;
+}
+
+std::filesystem::path SlowFileTracer::nextTracePath(const std::filesystem::path& input)
+{
+    std::uint32_t number = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        number = ++m_traceCount;
+    }
+    const auto directory = m_traceDirectory.empty() ? input.parent_path() : m_traceDirectory;
+    auto name = std::filesystem::path(m_namePrefix + "slow" + std::to_string(number) + "-");
+    name += input.filename();
+    name += ".trace.json";
+    return directory / name;
+}
+
+} // namespace denigma
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace denigma {
+
+/**
+ * @class TraceRecorder
+ * @brief Collects the TraceSpans of the whole process and writes them as a Chrome trace JSON file, which
+ * chrome://tracing and ui.perfetto.dev open.
+ *
+ * At most one recorder is active at a time. While none is, a TraceSpan costs one relaxed atomic load. Each span is
+ * tagged with its thread (named by #nameThread) and with the input file of the enclosing TraceFileScope.
+ */
+class TraceRecorder
+{
+public:
+    /// Starts recording to path. A recorder created while another is active records nothing and writes no file.
+    explicit TraceRecorder(std::filesystem::path path);
+    ~TraceRecorder() { finish(); }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /// Returns the recorder spans are sent to, or nullptr when tracing is off.
+    static TraceRecorder* active() noexcept { return s_active.load(std::memory_order_relaxed); }
+
+    /// Stops recording and writes the trace file. Later calls do nothing. Call it once every thread that records
+    /// spans to this recorder has finished them.
+    /// @return false if the file could not be written.
+    bool finish();
+
+    /// The file the trace is written to.
+    const std::filesystem::path& path() const noexcept { return m_path; }
+
+    /// Records a finished span of the calling thread.
+    void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    /// Returns the number that tags spans with file, adding it to the trace if it is new.
+    std::uint32_t fileIndex(std::string_view file);
+
+    /// Names the calling thread in the trace.
+    void nameThread(std::string_view name);
+
+private:
+    struct Event
+    {
+        const char* name{};
+        std::uint32_t thread{};
+        std::uint32_t file{};   ///< 1-based index into m_files, or 0 for none
+        std::chrono::nanoseconds start{};
+        std::chrono::nanoseconds duration{};
+    };
+
+    bool write() const;
+
+    static inline std::atomic<TraceRecorder*> s_active{};
+
+    std::filesystem::path m_path;
+    std::chrono::steady_clock::time_point m_start;
+    std::mutex m_mutex;
+    std::vector<Event> m_events;
+    std::vector<std::string> m_files;
+    std::map<std::uint32_t, std::string> m_threadNames;
+    bool m_recording{};
+};
+
+/**
+ * @class TraceSpan
+ * @brief Records the wall time of a scope as one span of the active TraceRecorder.
+ *
+ * The name must outlive the recorder; pass a string literal.
+ */
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name) noexcept
+        : m_name(name)
+    {
+        if (TraceRecorder::active()) {
+            m_start = std::chrono::steady_clock::now();
+            m_running = true;
+        }
+    }
+    ~TraceSpan() { end(); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    /// Ends the span before the scope does.
+    void end()
+    {
+        if (m_running) {
+            m_running = false;
+            if (auto* recorder = TraceRecorder::active()) {
+                recorder->record(m_name, m_start, std::chrono::steady_clock::now());
+            }
+        }
+    }
+
+private:
+    const char* m_name;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_running{};
+};
+
+/**
+ * @class TraceFileScope
+ * @brief Tags the spans the calling thread records during the scope with an input file.
+ *
+ * Worker threads do not inherit the tag; a worker passes #current of the thread that started it to the second
+ * constructor.
+ */
+class TraceFileScope
+{
+public:
+    /// Tags spans with file (UTF-8). Does nothing when tracing is off or file is empty.
+    explicit TraceFileScope(std::string_view file);
+    /// Tags spans with file, which is converted only when tracing is on.
+    explicit TraceFileScope(const std::filesystem::path& file);
+    /// Tags spans with a file number returned by #current on another thread.
+    explicit TraceFileScope(std::uint32_t fileIndex);
+    ~TraceFileScope();
+
+    TraceFileScope(const TraceFileScope&) = delete;
+    TraceFileScope& operator=(const TraceFileScope&) = delete;
+
+    /// Returns the file number the calling thread tags its spans with, or 0 for none.
+    static std::uint32_t current() noexcept;
+
+private:
+    std::uint32_t m_previous{};
+};
+
+/// Names the calling thread in the active trace, if any.
+void nameTraceThread(std::string_view name);
+
+/**
+ * @struct SlowFileThreshold
+ * @brief How slow a batch input must be for `--trace-slow` to convert it again with tracing.
+ *
+ * When both limits are set, a file must exceed both, so a 10x multiple does not trace every file of a run of tiny
+ * inputs.
+ */
+struct SlowFileThreshold
+{
+    std::chrono::duration<double> minimum{};    ///< slower than this many seconds (0 means no absolute limit)
+    double medianMultiple{};                    ///< slower than this multiple of the running median (0 means no relative limit)
+
+    /// Parses `seconds`, `<n>x` (a multiple of the median) or both joined by a comma, e.g. `2,10x`.
+    /// @throws std::invalid_argument if text is none of these.
+    static SlowFileThreshold parse(std::string_view text);
+};
+
+/**
+ * @class SlowFileTracer
+ * @brief Picks out the batch inputs that convert much slower than the rest, so only they pay for a full trace.
+ *
+ * Every input's conversion time goes to #observe, which keeps the median of a window of recent times. The caller
+ * converts a slow input again under a TraceRecorder of its own, holding #traceMutex, since only one recorder is
+ * active at a time. Spans that other workers record meanwhile land in the same trace.
+ */
+class SlowFileTracer
+{
+public:
+    static constexpr std::size_t MEDIAN_WINDOW = 1024;      ///< the number of recent times the median is taken over
+    static constexpr std::size_t MIN_MEDIAN_SAMPLES = 16;   ///< the relative limit applies once this many times are known
+
+    /// Traces are written to traceDirectory (or beside each input when it is empty), named starting with namePrefix.
+    SlowFileTracer(SlowFileThreshold threshold, std::filesystem::path traceDirectory, std::string namePrefix);
+
+    /// Adds the conversion time of one input and returns true if the input is slow.
+    bool observe(std::chrono::steady_clock::duration elapsed);
+
+    /// Returns the trace file for input, unique within the run.
+    std::filesystem::path nextTracePath(const std::filesystem::path& input);
+
+    /// Held for the duration of each traced conversion.
+    std::mutex& traceMutex() noexcept { return m_traceMutex; }
+
+private:
+    SlowFileThreshold m_threshold;
+    std::filesystem::path m_traceDirectory;
+    std::string m_namePrefix;
+    std::mutex m_mutex;
+    std::vector<double> m_window;   ///< ring buffer of recent times in seconds
+    std::size_t m_nextSample{};
+    std::uint32_t m_traceCount{};
+    std::mutex m_traceMutex;
+};
+
+} // namespace denigma
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "core/xxhash64.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace denigma {
+
+namespace {
+
+constexpr std::uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr std::uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr std::uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+// XXH64 reads its input as little-endian words
+std::uint64_t readLE64(const std::byte* data)
+{
+    std::uint64_t result = 0;
+    for (int index = 7; index >= 0; --index) {
+        result = (result << 8) | std::to_integer<std::uint64_t>(data[index]);
+    }
+    return result;
+}
+
+std::uint32_t readLE32(const std::byte* data)
+{
+    std::uint32_t result = 0;
+    for (int index = 3; index >= 0; --index) {
+        result = (result << 8) | std::to_integer<std::uint32_t>(data[index]);
+    }
+    return result;
+}
+
+std::uint64_t round(std::uint64_t accumulator, std::uint64_t input)
+{
+    accumulator += input * PRIME64_2;
+    accumulator = std::rotl(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+std::uint64_t mergeRound(std::uint64_t hash, std::uint64_t accumulator)
+{
+    hash ^= round(0, accumulator);
+    return hash * PRIME64_1 + PRIME64_4;
+}
+
+} // namespace
+
+void Xxh64::reset(std::uint64_t seed)
+{
+    m_seed = seed;
+    m_accumulators = { seed + PRIME64_1 + PRIME64_2, seed + PRIME64_2, seed, seed - PRIME64_1 };
+    m_buffered = 0;
+    m_totalLength = 0;
+}
+
+void Xxh64::consumeStripe(const std::byte* stripe)
+{
+    for (std::size_t lane = 0; lane < m_accumulators.size(); ++lane) {
+        m_accumulators[lane] = round(m_accumulators[lane], readLE64(stripe + lane * 8));
+    }
+}
+
+void Xxh64::update(std::span<const std::byte> data)
+{
+    m_totalLength += data.size();
+    const std::byte* next = data.data();
+    std::size_t remaining = data.size();
+    if (m_buffered > 0) {
+        const std::size_t taken = (std::min)(remaining, STRIPE_SIZE - m_buffered);
+        std::memcpy(m_buffer.data() + m_buffered, next, taken);
+        m_buffered += taken;
+        next += taken;
+        remaining -= taken;
+        if (m_buffered < STRIPE_SIZE) {
+            return;
+        }
+        consumeStripe(m_buffer.data());
+        m_buffered = 0;
+    }
+    for (; remaining >= STRIPE_SIZE; next += STRIPE_SIZE, remaining -= STRIPE_SIZE) {
+        consumeStripe(next);
+    }
+    if (remaining > 0) {
+        std::memcpy(m_buffer.data(), next, remaining);
+        m_buffered = remaining;
+    }
+}
+
+std::uint64_t Xxh64::digest() const
+{
+    std::uint64_t hash;
+    if (m_totalLength >= STRIPE_SIZE) {
+        const auto& acc = m_accumulators;
+        hash = std::rotl(acc[0], 1) + std::rotl(acc[1], 7) + std::rotl(acc[2], 12) + std::rotl(acc[3], 18);
+        for (const auto accumulator : acc) {
+            hash = mergeRound(hash, accumulator);
+        }
+    } else {
+        hash = m_seed + PRIME64_5;
+    }
+    hash += m_totalLength;
+
+    const std::byte* tail = m_buffer.data();
+    std::size_t remaining = m_buffered;
+    for (; remaining >= 8; tail += 8, remaining -= 8) {
+        hash ^= round(0, readLE64(tail));
+        hash = std::rotl(hash, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (remaining >= 4) {
+        hash ^= static_cast<std::uint64_t>(readLE32(tail)) * PRIME64_1;
+        hash = std::rotl(hash, 23) * PRIME64_2 + PRIME64_3;
+        tail += 4;
+        remaining -= 4;
+    }
+    for (; remaining > 0; ++tail, --remaining) {
+        hash ^= std::to_integer<std::uint64_t>(*tail) * PRIME64_5;
+        hash = std::rotl(hash, 11) * PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+std::string Xxh64::toHex(std::uint64_t hash)
+{
+    constexpr char DIGITS[] = "0123456789abcdef";
+    std::string result(16, '0');
+    for (std::size_t index = 16; index-- > 0; hash >>= 4) {
+        result[index] = DIGITS[hash & 0xF];
+    }
+    return result;
+}
+
+} // namespace denigma
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace denigma {
+
+/**
+ * @class Xxh64
+ * @brief Streaming XXH64 hash (the 64-bit xxHash), for fingerprinting outputs while they are written.
+ *
+ * Feeding the data in any number of pieces gives the same digest as feeding it at once, and the digest matches the
+ * reference XXH64 with the same seed, so downstream tools can recompute it.
+ */
+class Xxh64
+{
+public:
+    explicit Xxh64(std::uint64_t seed = 0) { reset(seed); }
+
+    /// Starts over with seed.
+    void reset(std::uint64_t seed = 0);
+
+    /// Adds data to the hash.
+    void update(std::span<const std::byte> data);
+
+    /// Returns the hash of everything added so far. More data may still be added afterwards.
+    std::uint64_t digest() const;
+
+    /// Returns the hash of data.
+    static std::uint64_t hash(std::span<const std::byte> data, std::uint64_t seed = 0)
+    {
+        Xxh64 hasher(seed);
+        hasher.update(data);
+        return hasher.digest();
+    }
+
+    /// Returns hash as 16 lower-case hex digits, the form xxhsum prints.
+    static std::string toHex(std::uint64_t hash);
+
+private:
+    static constexpr std::size_t STRIPE_SIZE = 32;
+
+    void consumeStripe(const std::byte* stripe);
+
+    std::uint64_t m_seed{};
+    std::array<std::uint64_t, 4> m_accumulators{};
+    std::array<std::byte, STRIPE_SIZE> m_buffer{};
+    std::size_t m_buffered{};
+    std::uint64_t m_totalLength{};
+};
+
+} // namespace denigma
@@ -28,29 +28,33 @@
 #include <cstring>
 #include <span>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
+#include <mutex>
 #include <optional>
 #include <vector>
 
-#include "denigma/formats/mss.h"
-#include "denigma/formats/musicxml.h"
-#include "denigma/formats/mnx.h"
-#include "denigma/formats/svg.h"
 #include "export/export.h"
+#include "denigma/formats/enigmaxml.h"
+#include "denigma/prepared_document.h"
+#include "core/parallel.h"
 #include "formats/enigmaxml/enigmaxml.h"
 #include "utils/stringutils.h"
 
 namespace denigma {
 
-namespace {
-
 CommonOptions makeCommonOptions(const DenigmaContext& denigmaContext)
 {
     CommonOptions options;
     options.sourceName = utils::pathToString(denigmaContext.inputFilePath);
     options.validate = !denigmaContext.noValidate;
+    options.validateConcurrently = denigmaContext.validateConcurrently;
+    options.validateEvery = denigmaContext.validateEvery;
     options.verbose = denigmaContext.verbose;
     options.quiet = denigmaContext.quiet;
+    options.outputJobs = denigmaContext.outputJobs;
+    options.textMetrics = denigmaContext.textMetrics;
+    options.fingerprintManifest = denigmaContext.fingerprintManifestPath.value_or(std::filesystem::path{});
     options.logCallback = [&denigmaContext](MessageSeverity severity, std::string_view message) {
         denigmaContext.logMessage(LogMsg() << message, severity);
     };
@@ -62,6 +66,7 @@ formats::mnx::Options makeMnxOptions(const DenigmaContext& denigmaContext)
     formats::mnx::Options options;
     options.common = makeCommonOptions(denigmaContext);
     options.indentSpaces = denigmaContext.indentSpaces;
+    options.encoding = denigmaContext.mnxEncoding;
     options.cueLayer = denigmaContext.cueLayer;
     options.schema = denigmaContext.mnxSchema;
     options.includeTempoTool = denigmaContext.includeTempoTool;
@@ -76,6 +81,9 @@ formats::musicxml::Options makeMusicXmlOptions(const DenigmaContext& denigmaCont
     options.includeTempoTool = denigmaContext.includeTempoTool;
     options.allPartsAndScore = denigmaContext.allPartsAndScore;
     options.partName = denigmaContext.partName;
+    options.streamParts = denigmaContext.musicXmlStreamParts;
+    options.dedupeParts = denigmaContext.musicXmlDedupeParts;
+    options.prettyPrint = !denigmaContext.compactXml;
     return options;
 }
 
@@ -117,6 +125,7 @@ formats::svg::Options makeSvgOptions(const DenigmaContext& denigmaContext)
     }
     options.scale = denigmaContext.svgScale;
     options.usePageScale = denigmaContext.svgUsePageScale;
+    options.spriteSheet = denigmaContext.svgSpriteSheet;
     options.shapeDefs.reserve(denigmaContext.svgShapeDefs.size());
     for (const auto shapeDef : denigmaContext.svgShapeDefs) {
         options.shapeDefs.push_back(static_cast<int>(shapeDef));
@@ -124,13 +133,107 @@ formats::svg::Options makeSvgOptions(const DenigmaContext& denigmaContext)
     return options;
 }
 
+const ConverterRegistry& defaultConverterRegistry()
+{
+    // Built once, so per-file exports and serve requests do not allocate and register converters every time.
+    static const ConverterRegistry registry = []() {
+        ConverterRegistry retval;
+        formats::enigmaxml::registerConverters(retval);
+        formats::mnx::registerConverters(retval);
+        formats::musicxml::registerConverters(retval);
+        formats::mss::registerConverters(retval);
+        formats::svg::registerConverters(retval);
+        return retval;
+    }();
+    return registry;
+}
+
+namespace {
+
+/// Writes each multi-output document to a file next to outputPath, named with its suggested name.
+class OutputFileSink final : public IMultiOutputSink
+{
+public:
+    OutputFileSink(const std::filesystem::path& outputPath, const DenigmaContext& denigmaContext)
+        : m_outputPath(outputPath), m_denigmaContext(denigmaContext)
+    {
+    }
+
+    bool begin(std::string_view suggestedName) override
+    {
+        std::filesystem::path qualifiedOutputPath = m_outputPath;
+        if (!suggestedName.empty()) {
+            auto currExtension = qualifiedOutputPath.extension();
+            qualifiedOutputPath.replace_extension(utils::stringToUtf8(suggestedName) + currExtension.u8string());
+        }
+        if (!m_denigmaContext.validatePathsAndOptions(qualifiedOutputPath)) {
+            return false;
+        }
+        m_output.emplace(qualifiedOutputPath, m_denigmaContext.outputArchive, m_denigmaContext.outputWriter);
+        return true;
+    }
+
+    void write(std::span<const std::byte> data) override
+    {
+        m_output->write(std::span<const char>(reinterpret_cast<const char*>(data.data()), data.size()));
+    }
+
+    void end() override
+    {
+        m_output->close();
+        m_output.reset();
+        ++m_generatedCount;
+    }
+
+    size_t generatedCount() const { return m_generatedCount; }
+
+private:
+    std::filesystem::path m_outputPath;
+    const DenigmaContext& m_denigmaContext;
+    std::optional<OutputFile> m_output;
+    size_t m_generatedCount{};
+};
+
 std::span<const std::byte> enigmaXmlBytes(const CommandInputData& inputData)
 {
-    return std::as_bytes(std::span(inputData.primaryBuffer.data(), inputData.primaryBuffer.size()));
+    return std::as_bytes(inputData.primaryXml());
+}
+
+/// The source of one export: the extracted input and, when several targets share one parse of it, its prepared document.
+struct ExportSource
+{
+    const CommandInputData& inputData;
+    const PreparedDocument* prepared{};
+};
+
+/// Converts source to a multi-output target, from the prepared document when there is one. output is an
+/// IMultiOutputSink or a MultiOutputCallback.
+template <typename Output>
+void convertToMultiOutput(const ExportSource& source, FormatId targetFormat, std::string_view formatName,
+                          Output&& output, const IOptions& options)
+{
+    const ConversionRequest request{ &options };
+    if (source.prepared) {
+        const auto* converter = defaultConverterRegistry().findPrepared(targetFormat);
+        if (!converter) {
+            throw std::logic_error(std::string(formatName) + " converter is not registered.");
+        }
+        if constexpr (std::is_base_of_v<IMultiOutputSink, std::remove_cvref_t<Output>>) {
+            converter->convert(*source.prepared, multiOutputCallbackForSink(output), request);
+        } else {
+            converter->convert(*source.prepared, output, request);
+        }
+        return;
+    }
+    const auto* converter = defaultConverterRegistry().findMultiOutput(FormatId::EnigmaXml, targetFormat);
+    if (!converter) {
+        throw std::logic_error(std::string(formatName) + " converter is not registered.");
+    }
+    converter->convert(enigmaXmlBytes(source.inputData), output, request);
 }
 
 void exportMnxJsonWithAdapter(const std::filesystem::path& outputPath,
-                              const CommandInputData& inputData,
+                              const ExportSource& source,
                               const DenigmaContext& denigmaContext)
 {
 #ifdef DENIGMA_TEST
@@ -141,24 +244,26 @@ void exportMnxJsonWithAdapter(const std::filesystem::path& outputPath,
 #endif
     if (!denigmaContext.validatePathsAndOptions(outputPath)) return;
 
-    ConverterRegistry registry;
-    formats::mnx::registerConverters(registry);
-    const auto* converter = registry.find(FormatId::EnigmaXml, FormatId::MnxJson);
+    OutputFile output(outputPath, denigmaContext.outputArchive, denigmaContext.outputWriter);
+    const auto options = makeMnxOptions(denigmaContext);
+    if (source.prepared) {
+        convertToMultiOutput(source, FormatId::MnxJson, "MNX JSON", [&](std::string_view, std::span<const std::byte> json) {
+            output.write(std::span<const char>(reinterpret_cast<const char*>(json.data()), json.size()));
+        }, options);
+        output.close();
+        return;
+    }
+
+    const auto* converter = defaultConverterRegistry().find(FormatId::EnigmaXml, FormatId::MnxJson);
     if (!converter) {
         throw std::logic_error("MNX JSON converter is not registered.");
     }
-
-    std::ofstream output;
-    output.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-    output.open(outputPath, std::ios::out | std::ios::binary);
-
-    const auto options = makeMnxOptions(denigmaContext);
-    converter->convert(enigmaXmlBytes(inputData), output, ConversionRequest{ &options });
+    converter->convert(enigmaXmlBytes(source.inputData), output.stream(), ConversionRequest{ &options });
     output.close();
 }
 
 void exportMusicXmlWithAdapter(const std::filesystem::path& outputPath,
-                               const CommandInputData& inputData,
+                               const ExportSource& source,
                                const DenigmaContext& denigmaContext)
 {
 #ifdef DENIGMA_TEST
@@ -168,39 +273,17 @@ void exportMusicXmlWithAdapter(const std::filesystem::path& outputPath,
     }
 #endif
 
-    ConverterRegistry registry;
-    formats::musicxml::registerConverters(registry);
-    const auto* converter = registry.findMultiOutput(FormatId::EnigmaXml, FormatId::MusicXml);
-    if (!converter) {
-        throw std::logic_error("MusicXML converter is not registered.");
-    }
-
-    size_t generatedCount = 0;
+    OutputFileSink sink(outputPath, denigmaContext);
     const auto options = makeMusicXmlOptions(denigmaContext);
-    converter->convert(enigmaXmlBytes(inputData), [&](std::string_view suggestedName, std::span<const std::byte> musicXmlData) {
-        std::filesystem::path qualifiedOutputPath = outputPath;
-        if (!suggestedName.empty()) {
-            auto currExtension = qualifiedOutputPath.extension();
-            qualifiedOutputPath.replace_extension(utils::stringToUtf8(suggestedName) + currExtension.u8string());
-        }
-        if (!denigmaContext.validatePathsAndOptions(qualifiedOutputPath)) {
-            return;
-        }
-        std::ofstream output;
-        output.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-        output.open(qualifiedOutputPath, std::ios::out | std::ios::binary);
-        output.write(reinterpret_cast<const char*>(musicXmlData.data()), static_cast<std::streamsize>(musicXmlData.size()));
-        output.close();
-        ++generatedCount;
-    }, ConversionRequest{ &options });
+    convertToMultiOutput(source, FormatId::MusicXml, "MusicXML", sink, options);
 
-    if (generatedCount == 0) {
+    if (sink.generatedCount() == 0) {
         denigmaContext.logMessage(LogMsg() << "No MusicXML files were written.", MessageSeverity::Warning);
     }
 }
 
-void exportMssWithAdapter(const std::filesystem::path& outputPath,
-                          const CommandInputData& inputData,
+void exportMxlWithAdapter(const std::filesystem::path& outputPath,
+                          const ExportSource& source,
                           const DenigmaContext& denigmaContext)
 {
 #ifdef DENIGMA_TEST
@@ -209,34 +292,47 @@ void exportMssWithAdapter(const std::filesystem::path& outputPath,
         return;
     }
 #endif
+    if (!denigmaContext.validatePathsAndOptions(outputPath)) return;
 
-    ConverterRegistry registry;
-    formats::mss::registerConverters(registry);
-    const auto* converter = registry.findMultiOutput(FormatId::EnigmaXml, FormatId::MssXml);
-    if (!converter) {
-        throw std::logic_error("MSS converter is not registered.");
+    // The score and any parts are deflated into the archive as they are serialized. It is built in memory only when
+    // it goes into the run's output archive or to the write-behind writer.
+    std::string archiveEntry;
+    std::optional<formats::musicxml::MxlArchiveSink> sink;
+    if (denigmaContext.outputArchive || denigmaContext.outputWriter) {
+        sink.emplace(archiveEntry, utils::pathToString(outputPath.stem()));
+    } else {
+        sink.emplace(outputPath);
+    }
+    const auto options = makeMusicXmlOptions(denigmaContext);
+    convertToMultiOutput(source, FormatId::MusicXml, "MusicXML", *sink, options);
+    sink->finish();
+    if (denigmaContext.outputArchive) {
+        denigmaContext.outputArchive->add(outputPath, archiveEntry);
+    } else if (denigmaContext.outputWriter) {
+        denigmaContext.outputWriter->write(outputPath, std::move(archiveEntry));
     }
 
-    size_t generatedCount = 0;
+    if (sink->documentCount() == 0) {
+        denigmaContext.logMessage(LogMsg() << "No MusicXML files were written to the archive.", MessageSeverity::Warning);
+    }
+}
+
+void exportMssWithAdapter(const std::filesystem::path& outputPath,
+                          const ExportSource& source,
+                          const DenigmaContext& denigmaContext)
+{
+#ifdef DENIGMA_TEST
+    if (denigmaContext.forTestOutput()) {
+        denigmaContext.logMessage(LogMsg() << "Converting to " << utils::asUtf8Bytes(outputPath));
+        return;
+    }
+#endif
+
+    OutputFileSink sink(outputPath, denigmaContext);
     const auto options = makeMssOptions(denigmaContext);
-    converter->convert(enigmaXmlBytes(inputData), [&](std::string_view suggestedName, std::span<const std::byte> mssData) {
-        std::filesystem::path qualifiedOutputPath = outputPath;
-        if (!suggestedName.empty()) {
-            auto currExtension = qualifiedOutputPath.extension();
-            qualifiedOutputPath.replace_extension(utils::stringToUtf8(suggestedName) + currExtension.u8string());
-        }
-        if (!denigmaContext.validatePathsAndOptions(qualifiedOutputPath)) {
-            return;
-        }
-        std::ofstream output;
-        output.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-        output.open(qualifiedOutputPath, std::ios::out | std::ios::binary);
-        output.write(reinterpret_cast<const char*>(mssData.data()), static_cast<std::streamsize>(mssData.size()));
-        output.close();
-        ++generatedCount;
-    }, ConversionRequest{ &options });
+    convertToMultiOutput(source, FormatId::MssXml, "MSS", sink, options);
 
-    if (generatedCount == 0) {
+    if (sink.generatedCount() == 0) {
         denigmaContext.logMessage(LogMsg() << "No MSS files were written.", MessageSeverity::Warning);
     }
 }
@@ -279,7 +375,7 @@ int shapeCmperFromSuggestedSvgName(std::string_view suggestedName)
 }
 
 void exportSvgWithAdapter(const std::filesystem::path& outputPath,
-                          const CommandInputData& inputData,
+                          const ExportSource& source,
                           const DenigmaContext& denigmaContext)
 {
 #ifdef DENIGMA_TEST
@@ -289,13 +385,6 @@ void exportSvgWithAdapter(const std::filesystem::path& outputPath,
     }
 #endif
 
-    ConverterRegistry registry;
-    formats::svg::registerConverters(registry);
-    const auto* converter = registry.findMultiOutput(FormatId::EnigmaXml, FormatId::Svg);
-    if (!converter) {
-        throw std::logic_error("SVG converter is not registered.");
-    }
-
     struct PendingSvg
     {
         int shapeCmper{};
@@ -304,25 +393,24 @@ void exportSvgWithAdapter(const std::filesystem::path& outputPath,
 
     std::vector<PendingSvg> pendingSvgs;
     const auto options = makeSvgOptions(denigmaContext);
-    converter->convert(enigmaXmlBytes(inputData), [&](std::string_view suggestedName, std::span<const std::byte> svgData) {
+    convertToMultiOutput(source, FormatId::Svg, "SVG", [&](std::string_view suggestedName, std::span<const std::byte> svgData) {
         std::string data;
         data.resize(svgData.size());
         std::memcpy(data.data(), svgData.data(), svgData.size());
         pendingSvgs.push_back(PendingSvg{ shapeCmperFromSuggestedSvgName(suggestedName), std::move(data) });
-    }, ConversionRequest{ &options });
+    }, options);
 
     const bool multipleShapes = pendingSvgs.size() > 1;
     size_t generatedCount = 0;
     for (const auto& pendingSvg : pendingSvgs) {
-        const auto resolvedOutputPath = resolveSvgOutputPath(
-            outputPath, pendingSvg.shapeCmper, denigmaContext.outputIsFilename, multipleShapes);
+        const auto resolvedOutputPath = denigmaContext.svgSpriteSheet
+            ? outputPath // the sheet holds every shape
+            : resolveSvgOutputPath(outputPath, pendingSvg.shapeCmper, denigmaContext.outputIsFilename, multipleShapes);
         if (!denigmaContext.validatePathsAndOptions(resolvedOutputPath)) {
             continue;
         }
-        std::ofstream output;
-        output.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-        output.open(resolvedOutputPath, std::ios::out | std::ios::binary);
-        output.write(pendingSvg.data.data(), static_cast<std::streamsize>(pendingSvg.data.size()));
+        OutputFile output(resolvedOutputPath, denigmaContext.outputArchive, denigmaContext.outputWriter);
+        output.write(pendingSvg.data);
         output.close();
         ++generatedCount;
     }
@@ -332,6 +420,13 @@ void exportSvgWithAdapter(const std::filesystem::path& outputPath,
     }
 }
 
+/// Writes a format that is made from the extracted input itself rather than from a parsed document.
+template <void (*Write)(const std::filesystem::path&, const CommandInputData&, const DenigmaContext&)>
+void writeSourceData(const std::filesystem::path& outputPath, const ExportSource& source, const DenigmaContext& denigmaContext)
+{
+    Write(outputPath, source.inputData, denigmaContext);
+}
+
 } // namespace
 
 // Input format processors
@@ -345,6 +440,7 @@ constexpr auto inputProcessors = []() {
     return std::to_array<InputProcessor>({
             { MUSX_EXTENSION, formats::enigmaxml::detail::extractMusxInputData },
             { ENIGMAXML_EXTENSION, formats::enigmaxml::detail::readEnigmaXmlInputData },
+            { ENIGMABIN_EXTENSION, formats::enigmaxml::detail::readEnigmaXmlInputData }, // the reader tells them apart
         });
     }();
 
@@ -353,17 +449,19 @@ constexpr auto outputProcessors = []() {
     struct OutputProcessor
     {
         std::u8string_view extension;
-        void(*processor)(const std::filesystem::path&, const CommandInputData&, const DenigmaContext&);
+        void(*processor)(const std::filesystem::path&, const ExportSource&, const DenigmaContext&);
     };
 
     return std::to_array<OutputProcessor>({
-            { MUSX_EXTENSION, formats::enigmaxml::detail::writeMusxForCli },
-            { ENIGMAXML_EXTENSION, formats::enigmaxml::detail::writeEnigmaXml },
+            { MUSX_EXTENSION, writeSourceData<formats::enigmaxml::detail::writeMusxForCli> },
+            { ENIGMAXML_EXTENSION, writeSourceData<formats::enigmaxml::detail::writeEnigmaXml> },
+            { ENIGMABIN_EXTENSION, writeSourceData<formats::enigmaxml::detail::writeEnigmaBinaryForCli> },
             { MSS_EXTENSION, exportMssWithAdapter },
             { SVG_EXTENSION, exportSvgWithAdapter },
             { MNX_EXTENSION, exportMnxJsonWithAdapter },
             { JSON_EXTENSION, exportMnxJsonWithAdapter },
             { MUSICXML_EXTENSION, exportMusicXmlWithAdapter },
+            { MXL_EXTENSION, exportMxlWithAdapter },
         });
     }();
 
@@ -375,10 +473,13 @@ int ExportCommand::showHelpPage(const std::string_view& programName, const std::
     std::cout << indentSpaces << "Currently it can export" << std::endl;
     std::cout << indentSpaces << "  musx:       Finale-readable musx file from enigmaxml" << std::endl;
     std::cout << indentSpaces << "  enigmaxml:  the internal xml representation of musx" << std::endl;
+    std::cout << indentSpaces << "              (an output or input named *.enigmaxml.gz or *.enigmaxml.zst is compressed)" << std::endl;
+    std::cout << indentSpaces << "  enigmabin:  compact binary cache of the enigmaxml, read back without xml parsing" << std::endl;
     std::cout << indentSpaces << "  mss:        the Styles format for MuseScore" << std::endl;
     std::cout << indentSpaces << "  svg:        Shape Designer shapes as SVG files" << std::endl;
     std::cout << indentSpaces << "  mnx:        MNX open standard files (currently in development)" << std::endl;
     std::cout << indentSpaces << "  musicxml:   MusicXML files (currently in development)" << std::endl;
+    std::cout << indentSpaces << "  mxl:        compressed MusicXML archive holding the score and any parts" << std::endl;
     std::cout << indentSpaces << "Note: reverse export to musx is intended for small test cases" << std::endl;
     std::cout << indentSpaces << "      and does not restore ancillary files (for example embedded graphics or audio)." << std::endl;
     std::cout << std::endl;
@@ -386,16 +487,21 @@ int ExportCommand::showHelpPage(const std::string_view& programName, const std::
     std::cout << std::endl;
     std::cout << indentSpaces << "Specific options:" << std::endl;
     std::cout << indentSpaces << "  --cue-layer <1..4>              Treat entries in this Finale layer as cue material." << std::endl;
+    std::cout << indentSpaces << "  --musx-compression-level <0..9> Compression level for reverse musx export (default: zlib default)." << std::endl;
+    std::cout << indentSpaces << "  --mnx-encoding <json|cbor|msgpack|bson>  Serialization for mnx output (default: json)." << std::endl;
     std::cout << indentSpaces << "  --mnx-schema [file-path]        Validate against this json schema file rather than the embedded one." << std::endl;
     std::cout << indentSpaces << "  --include-tempo-tool            Include tempo changes created with the Tempo Tool." << std::endl;
     std::cout << indentSpaces << "  --no-include-tempo-tool         Exclude tempo changes created with the Tempo Tool (default: exclude)." << std::endl;
-    std::cout << indentSpaces << "  --pretty-print [indent-spaces]  Print human readable format (default: on, " << JSON_INDENT_SPACES << " indent spaces)." << std::endl;
-    std::cout << indentSpaces << "  --no-pretty-print               Print compact json with no indentions or new lines." << std::endl;
+    std::cout << indentSpaces << "  --pretty-print [indent-spaces]  Print human readable format (default: on, " << JSON_INDENT_SPACES << " indent spaces for json)." << std::endl;
+    std::cout << indentSpaces << "  --no-pretty-print               Print compact json, musicxml and enigmaxml with no indentions or new lines." << std::endl;
+    std::cout << indentSpaces << "  --stream-parts                  Build and write MusicXML one part at a time to limit memory use (automatic over --memory-budget)." << std::endl;
+    std::cout << indentSpaces << "  --dedupe-parts                  Convert linked parts with identical content once and reuse the MusicXML." << std::endl;
     std::cout << indentSpaces << "  --shape-def <id[,id...]>        Export only specific ShapeDef cmper IDs (repeatable)." << std::endl;
     std::cout << indentSpaces << "  --svg-unit <none|px|pt|pc|cm|mm|in>  Unit suffix for SVG width/height (default: pt)." << std::endl;
     std::cout << indentSpaces << "  --svg-page-scale                Use page-format scaling for SVG output (default: off)." << std::endl;
     std::cout << indentSpaces << "  --no-svg-page-scale             Disable page-format scaling for SVG output (default)." << std::endl;
     std::cout << indentSpaces << "  --svg-scale <positive-float>    Extra SVG scaling multiplier (default: 1.0)." << std::endl;
+    std::cout << indentSpaces << "  --svg-sprite-sheet              Write all shapes to one SVG of <symbol>s that share repeated drawing elements." << std::endl;
 
     // Supported input formats
     std::cout << indentSpaces << "Supported input formats:" << std::endl;
@@ -423,6 +529,7 @@ int ExportCommand::showHelpPage(const std::string_view& programName, const std::
     std::cout << indentSpaces << "Examples:" << std::endl;
     std::cout << indentSpaces << "  " << fullCommand << " input.musx" << std::endl;
     std::cout << indentSpaces << "  " << fullCommand << " input.musx --enigmaxml output.enigmaxml -mss" << std::endl;
+    std::cout << indentSpaces << "  " << fullCommand << " input.musx --enigmaxml.zst" << std::endl;
     std::cout << indentSpaces << "  " << fullCommand << " input.enigmaxml --mss --part" << std::endl;
     std::cout << indentSpaces << "  " << fullCommand << " myfolder --mss exports/mss --all-parts --recursive" << std::endl;
     std::cout << indentSpaces << "  " << fullCommand << " input.enigmaxml --mnx --mss" << std::endl;
@@ -435,7 +542,7 @@ int ExportCommand::showHelpPage(const std::string_view& programName, const std::
 bool ExportCommand::canProcess(const std::filesystem::path& inputPath) const
 {
     try {
-        findProcessor(inputProcessors, inputPath.extension().u8string());
+        findProcessor(inputProcessors, formatExtension(inputPath));
         return true;
     } catch (...) {}
     return false;
@@ -444,15 +551,58 @@ bool ExportCommand::canProcess(const std::filesystem::path& inputPath) const
 CommandInputData ExportCommand::processInput(const std::filesystem::path& inputPath, const DenigmaContext& denigmaContext) const
 {
     MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
-    auto inputProcessor = findProcessor(inputProcessors, inputPath.extension().u8string());
+    auto inputProcessor = findProcessor(inputProcessors, formatExtension(inputPath));
     return inputProcessor(inputPath, denigmaContext);
 }
 
 void ExportCommand::processOutput(const CommandInputData& inputData, const std::filesystem::path& outputPath, const std::filesystem::path&, const DenigmaContext& denigmaContext) const
 {
     MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
-    auto outputProcessor = findProcessor(outputProcessors, outputPath.extension().u8string());
-    outputProcessor(outputPath, inputData, denigmaContext);
+    auto outputProcessor = findProcessor(outputProcessors, formatExtension(outputPath));
+    outputProcessor(outputPath, ExportSource{ inputData }, denigmaContext);
+}
+
+void ExportCommand::processOutputs(CommandInputData& inputData, std::span<const OutputTarget> outputs, const std::filesystem::path& inputPath, DenigmaContext& denigmaContext) const
+{
+    if (outputs.size() < 2 || denigmaContext.forTestOutput()) {
+        ICommand::processOutputs(inputData, outputs, inputPath, denigmaContext);
+        return;
+    }
+
+    // Every target converts the one document parsed from the input, and with --output-jobs the targets run at once.
+    // Each writes its files as soon as it is done; its messages are replayed in the order the targets were given.
+    std::vector<decltype(findProcessor(outputProcessors, std::u8string_view{}))> processors;
+    processors.reserve(outputs.size());
+    for (const auto& output : outputs) {
+        processors.push_back(findProcessor(outputProcessors, formatExtension(output.path)));
+    }
+    const auto prepared = PreparedDocument::fromEnigmaXml(enigmaXmlBytes(inputData), makeCommonOptions(denigmaContext));
+    const ExportSource source{ inputData, &prepared };
+    std::mutex outputValidatedMutex;
+
+    forEachInOrder<std::vector<std::filesystem::path>>(outputs.size(), denigmaContext,
+        [&](const DenigmaContext& context, std::size_t index) {
+            DenigmaContext targetContext(context);
+            targetContext.outputIsFilename = outputs[index].outputIsFilename;
+            // concurrent targets must not append to the caller's list, so theirs is merged in target order
+            std::vector<std::filesystem::path> outputsWritten;
+            targetContext.outputsWritten = &outputsWritten;
+            if (context.outputValidated) {
+                targetContext.outputValidated = [&](const std::filesystem::path& outputPath) {
+                    std::lock_guard<std::mutex> lock(outputValidatedMutex);
+                    context.outputValidated(outputPath);
+                };
+            }
+            MusxLoggerScope musxLogger(makeMusxLogCallback(targetContext));
+            processors[index](outputs[index].path, source, targetContext);
+            context.errorOccurred = context.errorOccurred || targetContext.errorOccurred;
+            return outputsWritten;
+        },
+        [&](std::size_t, std::vector<std::filesystem::path> outputsWritten) {
+            if (denigmaContext.outputsWritten) {
+                denigmaContext.outputsWritten->insert(denigmaContext.outputsWritten->end(), outputsWritten.begin(), outputsWritten.end());
+            }
+        });
 }
 
 } // namespace denigma
@@ -22,9 +22,23 @@
 #pragma once
 
 #include "core/denigma.h"
+#include "denigma/formats/mnx.h"
+#include "denigma/formats/mss.h"
+#include "denigma/formats/musicxml.h"
+#include "denigma/formats/svg.h"
 
 namespace denigma {
 
+// Map the command-line options held in a DenigmaContext to the option structs of the converter adapters.
+CommonOptions makeCommonOptions(const DenigmaContext& denigmaContext);
+formats::mnx::Options makeMnxOptions(const DenigmaContext& denigmaContext);
+formats::musicxml::Options makeMusicXmlOptions(const DenigmaContext& denigmaContext);
+formats::mss::Options makeMssOptions(const DenigmaContext& denigmaContext);
+formats::svg::Options makeSvgOptions(const DenigmaContext& denigmaContext);
+
+/// Returns the process-wide registry holding every format's converters, built on first use.
+const ConverterRegistry& defaultConverterRegistry();
+
 struct ExportCommand : public ICommand
 {
     using ICommand::ICommand;
@@ -34,6 +48,7 @@ struct ExportCommand : public ICommand
     bool canProcess(const std::filesystem::path& inputPath) const override;
     CommandInputData processInput(const std::filesystem::path& inputPath, const DenigmaContext& denigmaContext) const override;
     void processOutput(const CommandInputData& inputData, const std::filesystem::path& outputPath, const std::filesystem::path&, const DenigmaContext& denigmaContext) const override;
+    void processOutputs(CommandInputData& inputData, std::span<const OutputTarget> outputs, const std::filesystem::path& inputPath, DenigmaContext& denigmaContext) const override;
 
     std::optional<std::u8string_view> defaultInputFormat() const override { return MUSX_EXTENSION; };
     std::optional<std::u8string> defaultOutputFormat(const std::filesystem::path& inputPath) const override
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "denigma/batch_converter.h"
+#include "denigma/prepared_document.h"
+
+#include "core/parallel.h"
+
+namespace denigma {
+
+namespace {
+
+// Rough peak memory of a conversion per input byte: a musx archive inflates to far larger EnigmaXML, which then
+// becomes a DOM; uncompressed sources are already close to the size of their DOM text.
+constexpr std::uint64_t MEMORY_PER_MUSX_BYTE = 40;
+constexpr std::uint64_t MEMORY_PER_INPUT_BYTE = 4;
+
+std::uint64_t estimateJobBytes(const BatchJob& job)
+{
+    if (job.estimatedBytes || !job.input) {
+        return job.estimatedBytes;
+    }
+    const auto perByte = job.sourceFormat == FormatId::Musx ? MEMORY_PER_MUSX_BYTE : MEMORY_PER_INPUT_BYTE;
+    return job.input->size() * perByte;
+}
+
+ConversionResult errorResult(std::string message)
+{
+    ConversionResult result;
+    result.addDiagnostic(MessageSeverity::Error, std::move(message));
+    return result;
+}
+
+template <typename Convert>
+ConversionResult convertCatching(Convert&& convert)
+{
+    try {
+        return convert();
+    } catch (const std::exception& ex) {
+        return errorResult(std::string("conversion failed: ") + ex.what());
+    } catch (...) {
+        return errorResult("conversion failed with an unknown exception");
+    }
+}
+
+std::vector<ConversionResult> runJob(const ConverterRegistry& registry, const BatchJob& job)
+{
+    std::vector<ConversionResult> results(job.targets.size());
+    if (!job.input) {
+        std::fill(results.begin(), results.end(), errorResult("batch job has no input"));
+        return results;
+    }
+
+    // targets that can share one extraction and parse of the source
+    std::vector<const IPreparedDocumentConverter*> preparedConverters(job.targets.size());
+    std::size_t preparedCount = 0;
+    const CommonOptions* preparationOptions = nullptr;
+    if (job.sourceFormat == FormatId::Musx && job.targets.size() > 1) {
+        for (std::size_t index = 0; index < job.targets.size(); index++) {
+            const auto& target = job.targets[index];
+            if (!target.sink || !(preparedConverters[index] = registry.findPrepared(target.format))) {
+                continue;
+            }
+            if (!preparationOptions && target.options) {
+                preparationOptions = target.options->commonOptions();
+            }
+            ++preparedCount;
+        }
+    }
+    std::optional<PreparedDocument> prepared;
+    if (preparedCount > 1) {
+        prepared.emplace(PreparedDocument::fromMusx(*job.input, preparationOptions ? *preparationOptions : CommonOptions{}));
+    }
+
+    for (std::size_t index = 0; index < job.targets.size(); index++) {
+        const auto& target = job.targets[index];
+        if (!target.sink) {
+            results[index] = errorResult("batch target has no output sink");
+            continue;
+        }
+        const ConversionRequest request{ target.options };
+        if (prepared && preparedConverters[index]) {
+            if (prepared->preparationResult().hasError()) {
+                results[index] = prepared->preparationResult();
+                continue;
+            }
+            results[index] = convertCatching([&]() {
+                return preparedConverters[index]->convert(*prepared, multiOutputCallbackForSink(*target.sink), request);
+            });
+            // extraction diagnostics belong to every target that read the prepared source
+            if (!prepared->preparationResult().diagnostics().empty()) {
+                ConversionResult merged = prepared->preparationResult();
+                for (const auto& diagnostic : results[index].diagnostics()) {
+                    merged.addDiagnostic(diagnostic);
+                }
+                if (results[index].cancelled()) {
+                    merged.setCancelled();
+                }
+                merged.setPeakArenaBytes(results[index].peakArenaBytes());
+                merged.stats() = results[index].stats();
+                results[index] = std::move(merged);
+            }
+            continue;
+        }
+        const auto* converter = registry.findReaderMultiOutput(job.sourceFormat, target.format);
+        if (!converter) {
+            results[index] = errorResult("no converter is registered for this source and target format");
+            continue;
+        }
+        results[index] = convertCatching([&]() { return converter->convert(*job.input, *target.sink, request); });
+    }
+    return results;
+}
+
+} // namespace
+
+void BatchConverter::convertMany(std::span<const BatchJob> jobs, const JobFinished& jobFinished) const
+{
+    if (jobs.empty()) {
+        return;
+    }
+
+    struct PendingJob
+    {
+        std::size_t index;
+        std::uint64_t cost;
+    };
+    std::vector<PendingJob> pending;
+    pending.reserve(jobs.size());
+    for (std::size_t index = 0; index < jobs.size(); index++) {
+        pending.push_back({ index, estimateJobBytes(jobs[index]) });
+    }
+    // largest first; the scheduler takes from the front
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingJob& a, const PendingJob& b) { return a.cost > b.cost; });
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::mutex callbackMutex;
+    std::size_t running = 0;
+    std::uint64_t costInProgress = 0;
+    auto admissible = [&]() {
+        if (m_options.memoryBudget == 0 || running == 0) {
+            return pending.begin();
+        }
+        const auto available = m_options.memoryBudget > costInProgress ? m_options.memoryBudget - costInProgress : 0;
+        return std::find_if(pending.begin(), pending.end(), [&](const PendingJob& job) { return job.cost <= available; });
+    };
+
+    auto work = [&]() {
+        while (true) {
+            PendingJob job{};
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                auto next = pending.end();
+                changed.wait(lock, [&]() { return pending.empty() || (next = admissible()) != pending.end(); });
+                if (pending.empty()) {
+                    return;
+                }
+                job = *next;
+                pending.erase(next);
+                ++running;
+                costInProgress += job.cost;
+            }
+            auto results = runJob(m_registry, jobs[job.index]);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --running;
+                costInProgress -= job.cost;
+            }
+            changed.notify_all();
+            if (jobFinished) {
+                std::lock_guard<std::mutex> lock(callbackMutex);
+                jobFinished(job.index, std::move(results));
+            }
+        }
+    };
+
+    std::size_t jobCount = 0;
+    if (m_options.jobs == 0 && m_options.executor) {
+        jobCount = (std::min)(std::size_t((std::max)(m_options.executor->concurrency(), 1u)), jobs.size());
+    } else {
+        jobCount = resolveJobCount(m_options.jobs, jobs.size());
+    }
+    detail::ConcurrentWorkers workers(m_options.executor, work);
+    workers.start(jobCount - 1);
+    work(); // returns once every job has been taken; join waits for the ones still running
+    workers.join();
+}
+
+} // namespace denigma
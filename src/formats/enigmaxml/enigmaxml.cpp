@@ -23,25 +23,34 @@
 #include <algorithm>
 #include <array>
 #include <filesystem>
+#include <fstream>
+#include <functional>
 #include <vector>
+#include <iomanip>
 #include <iostream>
+#include <optional>
 #include <sstream>
-#include <ctime>
-#include <regex>
+#include <string_view>
+#include <utility>
+#include <span>
 #include <limits>
+#include <cstdint>
 #include <stdexcept>
+#include <thread>
 
 #include "zlib.h"
-#include "zip.h"
-
-#ifdef _WIN32
-#include "iowin32.h"
-#endif
 
 #include "musx/musx.h"
 
+#include "core/buffer_pool.h"
 #include "core/denigma.h"
+#include "core/enigma_binary_codec.h"
+#include "core/parallel.h"
 #include "enigmaxml.h"
+#include "utils/inflate.h"
+#include "utils/stream_compression.h"
+#include "utils/xml_header_probe.h"
+#include "utils/xml_indent.h"
 #include "utils/ziputils.h"
 #include "score_encoder/score_encoder.h"
 
@@ -54,17 +63,44 @@ namespace detail {
 
 CommandInputData extractMusxInputData(const IRandomAccessReader& reader, const DenigmaContext& denigmaContext);
 
+/// Returns the gzip ISIZE trailer: the uncompressed size modulo 2^32, or 0 if the data is too short to have one.
+static std::uint32_t gzipTrailerSize(const std::string& compressedData)
+{
+    constexpr std::size_t GZIP_MIN_SIZE = 18; // 10-byte header + 8-byte trailer
+    if (compressedData.size() < GZIP_MIN_SIZE) {
+        return 0;
+    }
+    const auto* trailer = reinterpret_cast<const unsigned char*>(compressedData.data() + compressedData.size() - 4);
+    return static_cast<std::uint32_t>(trailer[0])
+        | (static_cast<std::uint32_t>(trailer[1]) << 8)
+        | (static_cast<std::uint32_t>(trailer[2]) << 16)
+        | (static_cast<std::uint32_t>(trailer[3]) << 24);
+}
+
 static Buffer gunzipBuffer(const std::string& compressedData)
 {
+    // Inflate straight into a buffer sized from the ISIZE trailer. It is only a hint (it wraps at 4 GB and could be
+    // wrong), so the buffer still grows if needed. The extra byte keeps output space available when the size is exact,
+    // so inflate can reach Z_STREAM_END without a growth step.
+    constexpr std::size_t MAX_DEFLATE_RATIO = 1032;
+    constexpr std::size_t MIN_GROWTH = 16384;
+    const std::size_t trailerSize = (std::min<std::size_t>)(gzipTrailerSize(compressedData), compressedData.size() * MAX_DEFLATE_RATIO);
+    if (utils::hasAcceleratedInflate()) {
+        Buffer output = acquireByteBuffer(trailerSize);
+        output.resize(trailerSize);
+        if (utils::inflateKnownSize(compressedData, utils::DeflateFormat::Gzip, output)) {
+            return output;
+        }
+    }
+
     z_stream stream{};
     int rc = inflateInit2(&stream, 16 + MAX_WBITS); // 16 + MAX_WBITS = gzip stream
     if (rc != Z_OK) {
         throw std::runtime_error("unable to initialize zlib inflate");
     }
-
-    Buffer output;
-    output.reserve(compressedData.size());
-    std::array<char, 16384> chunk{};
+    Buffer output = acquireByteBuffer(trailerSize + 1);
+    output.resize(trailerSize + 1);
+    std::size_t produced = 0;
 
     const auto* nextInput = reinterpret_cast<const Bytef*>(compressedData.data());
     std::size_t remainingInput = compressedData.size();
@@ -78,8 +114,12 @@ static Buffer gunzipBuffer(const std::string& compressedData)
             remainingInput -= inputChunk;
         }
 
-        stream.next_out = reinterpret_cast<Bytef*>(chunk.data());
-        stream.avail_out = static_cast<uInt>(chunk.size());
+        if (produced == output.size()) {
+            output.resize(output.size() + (std::max)(output.size() / 2, MIN_GROWTH));
+        }
+        const std::size_t outputChunk = std::min<std::size_t>(output.size() - produced, std::numeric_limits<uInt>::max());
+        stream.next_out = reinterpret_cast<Bytef*>(output.data() + produced);
+        stream.avail_out = static_cast<uInt>(outputChunk);
         inflateRc = inflate(&stream, Z_NO_FLUSH);
 
         if (inflateRc != Z_OK && inflateRc != Z_STREAM_END) {
@@ -87,8 +127,8 @@ static Buffer gunzipBuffer(const std::string& compressedData)
             throw std::runtime_error("unable to decompress gzip stream");
         }
 
-        const auto written = static_cast<std::size_t>(chunk.size() - stream.avail_out);
-        output.insert(output.end(), chunk.data(), chunk.data() + written);
+        const auto written = static_cast<std::size_t>(outputChunk - stream.avail_out);
+        produced += written;
 
         if (inflateRc == Z_STREAM_END) {
             break;
@@ -101,156 +141,186 @@ static Buffer gunzipBuffer(const std::string& compressedData)
     }
 
     inflateEnd(&stream);
+    output.resize(produced);
     return output;
 }
 
-static std::string gzipBuffer(const Buffer& uncompressedData)
+struct GzipBlock
+{
+    std::string data;
+    uLong crc{};
+};
+
+/// Deflates one block as raw deflate, primed with up to 32 KB of the input before it.
+/// All but the last block end with a sync flush, so the blocks concatenate into one deflate stream.
+static GzipBlock deflateGzipBlock(std::span<const char> uncompressedData, std::size_t offset, std::size_t length, int level)
 {
+    constexpr std::size_t DEFLATE_WINDOW_SIZE = 32 * 1024;
+    constexpr std::size_t SYNC_FLUSH_SLACK = 16; // deflateBound covers Z_FINISH; a sync flush adds an empty stored block
+
     z_stream stream{};
-    int rc = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    int rc = deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
     if (rc != Z_OK) {
         throw std::runtime_error("unable to initialize zlib deflate");
     }
-
-    std::string output;
-    output.reserve(uncompressedData.size() / 2);
-    std::array<char, 16384> chunk{};
-
-    const auto* nextInput = reinterpret_cast<const Bytef*>(uncompressedData.data());
-    std::size_t remainingInput = uncompressedData.size();
-    int deflateRc = Z_OK;
-    while (true) {
-        if (stream.avail_in == 0 && remainingInput > 0) {
-            const std::size_t inputChunk = std::min<std::size_t>(remainingInput, std::numeric_limits<uInt>::max());
-            stream.next_in = const_cast<Bytef*>(nextInput);
-            stream.avail_in = static_cast<uInt>(inputChunk);
-            nextInput += inputChunk;
-            remainingInput -= inputChunk;
-        }
-
-        stream.next_out = reinterpret_cast<Bytef*>(chunk.data());
-        stream.avail_out = static_cast<uInt>(chunk.size());
-        deflateRc = deflate(&stream, (remainingInput == 0 && stream.avail_in == 0) ? Z_FINISH : Z_NO_FLUSH);
-
-        if (deflateRc != Z_OK && deflateRc != Z_STREAM_END) {
+    if (offset > 0) {
+        const std::size_t dictionaryLength = (std::min)(offset, DEFLATE_WINDOW_SIZE);
+        rc = deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(uncompressedData.data() + offset - dictionaryLength),
+                                  static_cast<uInt>(dictionaryLength));
+        if (rc != Z_OK) {
             deflateEnd(&stream);
-            throw std::runtime_error("unable to compress gzip stream");
-        }
-
-        const auto written = static_cast<std::size_t>(chunk.size() - stream.avail_out);
-        output.append(chunk.data(), written);
-
-        if (deflateRc == Z_STREAM_END) {
-            break;
+            throw std::runtime_error("unable to prime zlib deflate");
         }
     }
 
+    const bool lastBlock = offset + length == uncompressedData.size();
+    GzipBlock block;
+    block.data.resize(deflateBound(&stream, static_cast<uLong>(length)) + SYNC_FLUSH_SLACK);
+    stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(uncompressedData.data() + offset));
+    stream.avail_in = static_cast<uInt>(length);
+    stream.next_out = reinterpret_cast<Bytef*>(block.data.data());
+    stream.avail_out = static_cast<uInt>(block.data.size());
+    rc = deflate(&stream, lastBlock ? Z_FINISH : Z_SYNC_FLUSH);
+    const bool complete = lastBlock ? (rc == Z_STREAM_END) : (rc == Z_OK && stream.avail_in == 0 && stream.avail_out > 0);
     deflateEnd(&stream);
-    return output;
+    if (!complete) {
+        throw std::runtime_error("unable to compress gzip stream");
+    }
+    block.data.resize(block.data.size() - stream.avail_out);
+    block.crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(uncompressedData.data() + offset), static_cast<uInt>(length));
+    return block;
 }
 
-static zipFile openZipForWrite(const std::filesystem::path& outputPath)
+/// Compresses the data as one gzip member in independent blocks the way pigz does, so that the blocks can be
+/// deflated on up to denigmaContext.outputJobs threads. The result does not depend on the number of threads.
+static std::string gzipBuffer(std::span<const char> uncompressedData, int level, const DenigmaContext& denigmaContext)
 {
-#ifdef _WIN32
-    zlib_filefunc64_def fileFuncs{};
-    fill_win32_filefunc64W(&fileFuncs);
-    std::wstring widePath = outputPath.wstring();
-    return zipOpen2_64(widePath.c_str(), APPEND_STATUS_CREATE, nullptr, &fileFuncs);
-#else
-    auto utf8Path = outputPath.u8string();
-    return zipOpen64(utf8Path.c_str(), APPEND_STATUS_CREATE);
-#endif
+    constexpr std::size_t GZIP_BLOCK_SIZE = 128 * 1024;
+    // ID1, ID2, CM = deflate, no flags, no mtime, no extra flags, OS = unknown
+    constexpr std::array<unsigned char, 10> GZIP_HEADER{ 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+
+    auto appendLittleEndian32 = [](std::string& output, std::uint32_t value) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            output.push_back(static_cast<char>((value >> shift) & 0xff));
+        }
+    };
+    auto blockLength = [&](std::size_t index) {
+        return (std::min)(GZIP_BLOCK_SIZE, uncompressedData.size() - index * GZIP_BLOCK_SIZE);
+    };
+
+    std::string output;
+    output.reserve(uncompressedData.size() / 2);
+    output.append(reinterpret_cast<const char*>(GZIP_HEADER.data()), GZIP_HEADER.size());
+    uLong crc = crc32(0L, Z_NULL, 0);
+    const std::size_t blockCount = (std::max<std::size_t>)(1, (uncompressedData.size() + GZIP_BLOCK_SIZE - 1) / GZIP_BLOCK_SIZE);
+    forEachInOrder<GzipBlock>(blockCount, denigmaContext,
+        [&](const DenigmaContext&, std::size_t index) {
+            return deflateGzipBlock(uncompressedData, index * GZIP_BLOCK_SIZE, blockLength(index), level);
+        },
+        [&](std::size_t index, GzipBlock&& block) {
+            output.append(block.data);
+            crc = crc32_combine(crc, block.crc, static_cast<z_off_t>(blockLength(index)));
+        });
+    appendLittleEndian32(output, static_cast<std::uint32_t>(crc));
+    appendLittleEndian32(output, static_cast<std::uint32_t>(uncompressedData.size() & 0xffffffffU));
+    return output;
 }
 
-static zip_fileinfo makeCurrentZipFileInfo()
+static std::pair<int, int> extractFileVersionFromEnigmaXml(std::span<const char> xmlBuffer)
 {
-    zip_fileinfo info{};
-    const std::time_t now = std::time(nullptr);
-    std::tm localTime{};
-#ifdef _WIN32
-    localtime_s(&localTime, &now);
-#else
-    localtime_r(&now, &localTime);
-#endif
-    info.tmz_date.tm_sec = localTime.tm_sec;
-    info.tmz_date.tm_min = localTime.tm_min;
-    info.tmz_date.tm_hour = localTime.tm_hour;
-    info.tmz_date.tm_mday = localTime.tm_mday;
-    info.tmz_date.tm_mon = localTime.tm_mon;
-    info.tmz_date.tm_year = localTime.tm_year + 1900;
-    return info;
+    // Only the header is probed, so a late or missing version no longer costs a scan of the whole document.
+    return utils::probeEnigmaXmlFileVersion(std::string_view(xmlBuffer.data(), xmlBuffer.size())).value_or(std::make_pair(27, 4));
 }
 
-static void writeZipEntry(zipFile outputZip, const char* name, const std::string& content, int method, int level)
+/// Names the cached EnigmaXML for an (still encoded) score.dat by its CRC-32, Adler-32, size and the denigma version,
+/// so that a new build never reads what an older one wrote.
+static std::filesystem::path xmlCachePath(const std::filesystem::path& cacheDir, std::span<const char> scoreDat)
 {
-    zip_fileinfo info = makeCurrentZipFileInfo();
-    int rc = zipOpenNewFileInZip64(
-        outputZip,
-        name,
-        &info,
-        nullptr,
-        0,
-        nullptr,
-        0,
-        nullptr,
-        method,
-        level,
-        content.size() >= 0xffffffffULL ? 1 : 0
-    );
-    if (rc != ZIP_OK) {
-        throw std::runtime_error(std::string("unable to create ") + name + " in musx archive");
+    uLong crc = crc32(0L, Z_NULL, 0);
+    uLong adler = adler32(0L, Z_NULL, 0);
+    for (std::size_t offset = 0; offset < scoreDat.size(); ) {
+        const std::size_t length = (std::min<std::size_t>)(scoreDat.size() - offset, std::numeric_limits<uInt>::max());
+        const auto* bytes = reinterpret_cast<const Bytef*>(scoreDat.data() + offset);
+        crc = crc32(crc, bytes, static_cast<uInt>(length));
+        adler = adler32(adler, bytes, static_cast<uInt>(length));
+        offset += length;
     }
+    std::ostringstream name;
+    name << std::hex << std::setfill('0') << std::setw(8) << crc << std::setw(8) << adler
+         << std::dec << '-' << scoreDat.size() << "-" DENIGMA_VERSION "." << utils::utf8ToString(ENIGMAXML_EXTENSION);
+    return cacheDir / name.str();
+}
 
-    std::size_t offset = 0;
-    while (offset < content.size()) {
-        const std::size_t chunkSize = std::min<std::size_t>(content.size() - offset, std::numeric_limits<unsigned>::max());
-        rc = zipWriteInFileInZip(outputZip, content.data() + offset, static_cast<unsigned>(chunkSize));
-        if (rc < 0) {
-            zipCloseFileInZip(outputZip);
-            throw std::runtime_error(std::string("unable to write ") + name + " to musx archive");
-        }
-        offset += chunkSize;
+static std::optional<Buffer> readCachedXml(const std::filesystem::path& cachePath)
+{
+    std::ifstream cacheFile(cachePath, std::ios::binary | std::ios::ate);
+    if (!cacheFile) {
+        return std::nullopt;
     }
-
-    rc = zipCloseFileInZip(outputZip);
-    if (rc != ZIP_OK) {
-        throw std::runtime_error(std::string("unable to finalize ") + name + " in musx archive");
+    Buffer buffer(static_cast<std::size_t>(cacheFile.tellg()));
+    cacheFile.seekg(0, std::ios::beg);
+    if (!cacheFile.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+        return std::nullopt;
     }
+    return buffer;
 }
 
-static std::pair<int, int> extractFileVersionFromEnigmaXml(const Buffer& xmlBuffer)
+/// Stores xml at cachePath. The file is renamed into place, so concurrent jobs never read a partial entry.
+/// A cache that cannot be written only costs the next run its hit, so failures are reported as warnings.
+static void writeCachedXml(const std::filesystem::path& cachePath, std::span<const char> xml, const DenigmaContext& denigmaContext)
 {
-    std::match_results<Buffer::const_iterator> match;
-    const std::regex modifiedFileVersion(
-        R"(<modified>[\s\S]*?<fileVersion>[\s\S]*?<major>(\d+)</major>[\s\S]*?<minor>(\d+)</minor>)"
-    );
-    if (std::regex_search(xmlBuffer.cbegin(), xmlBuffer.cend(), match, modifiedFileVersion) && match.size() >= 3) {
-        return {
-            std::stoi(std::string(match[1].first, match[1].second)),
-            std::stoi(std::string(match[2].first, match[2].second))
-        };
-    }
-
-    const std::regex createdFileVersion(
-        R"(<created>[\s\S]*?<fileVersion>[\s\S]*?<major>(\d+)</major>[\s\S]*?<minor>(\d+)</minor>)"
-    );
-    if (std::regex_search(xmlBuffer.cbegin(), xmlBuffer.cend(), match, createdFileVersion) && match.size() >= 3) {
-        return {
-            std::stoi(std::string(match[1].first, match[1].second)),
-            std::stoi(std::string(match[2].first, match[2].second))
-        };
+    std::filesystem::path tempPath = cachePath;
+    tempPath += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    try {
+        std::filesystem::create_directories(cachePath.parent_path());
+        {
+            std::ofstream cacheFile;
+            cacheFile.exceptions(std::ios::failbit | std::ios::badbit);
+            cacheFile.open(tempPath, std::ios::binary);
+            cacheFile.write(xml.data(), static_cast<std::streamsize>(xml.size()));
+        }
+        std::filesystem::rename(tempPath, cachePath);
+    } catch (const std::exception& ex) {
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        denigmaContext.logMessage(LogMsg() << "unable to cache enigmaxml at " << utils::asUtf8Bytes(cachePath)
+            << " (" << ex.what() << ")", MessageSeverity::Warning);
     }
-
-    return { 27, 4 };
 }
 
 static CommandInputData readMusxArchive(const IRandomAccessReader& reader, const DenigmaContext& denigmaContext)
 {
+    PhaseTimer unzipTimer(denigmaContext, ConversionStats::Phase::Unzip);
     auto archiveFiles = utils::readMusxArchiveFiles(reader, denigmaContext);
-    musx::encoder::ScoreFileEncoder::recodeBuffer(archiveFiles.scoreDat);
+    unzipTimer.stop();
+    denigmaContext.checkCancelled();
 
     CommandInputData result;
-    result.primaryBuffer = gunzipBuffer(archiveFiles.scoreDat);
+    std::optional<std::filesystem::path> cachePath;
+    std::optional<Buffer> cachedXml;
+    if (denigmaContext.xmlCacheDir) {
+        PhaseTimer cacheTimer(denigmaContext, ConversionStats::Phase::Inflate);
+        cachePath = xmlCachePath(*denigmaContext.xmlCacheDir, archiveFiles.scoreDat);
+        cachedXml = readCachedXml(*cachePath);
+        if (denigmaContext.conversionResult) {
+            auto& stats = denigmaContext.conversionResult->stats();
+            ++(cachedXml ? stats.cacheHits : stats.cacheMisses);
+        }
+    }
+    if (cachedXml) {
+        result.primaryBuffer = std::move(*cachedXml);
+    } else {
+        {
+            PhaseTimer decodeTimer(denigmaContext, ConversionStats::Phase::Decode);
+            musx::encoder::ScoreFileEncoder::recodeBuffer(archiveFiles.scoreDat);
+        }
+        PhaseTimer inflateTimer(denigmaContext, ConversionStats::Phase::Inflate);
+        result.primaryBuffer = gunzipBuffer(archiveFiles.scoreDat);
+        if (cachePath) {
+            writeCachedXml(*cachePath, result.primaryBuffer, denigmaContext);
+        }
+        recycleStringBuffer(std::move(archiveFiles.scoreDat));
+    }
     if (archiveFiles.notationMetadata.has_value()) {
         result.notationMetadata = Buffer(
             archiveFiles.notationMetadata->begin(),
@@ -268,23 +338,20 @@ CommandInputData readEnigmaXmlInputData(const std::filesystem::path& inputPath,
         return {};
     }
     try {
-        std::ifstream xmlFile;
-        xmlFile.exceptions(std::ios::failbit | std::ios::badbit);
-        xmlFile.open(inputPath, std::ios::binary | std::ios::ate);
-
-        // Preallocate buffer based on file size
-        std::streamsize fileSize = xmlFile.tellg();
-        xmlFile.seekg(0, std::ios::beg);
-
-        Buffer buffer(static_cast<std::size_t>(fileSize));
-        xmlFile.read(buffer.data(), fileSize);
-        return CommandInputData{ std::move(buffer), std::nullopt, {} };
-    } catch (const std::ios_base::failure& ex) {
+        // the page cache is the buffer; the reader parses the copy-on-write mapping in place
+        CommandInputData result;
+        auto mapping = std::make_shared<MappedInputFile>(inputPath);
+        if (const auto compression = utils::detectCompression(mapping->data()); compression != utils::StreamCompression::None) {
+            // a compressed intermediate (.enigmaxml.gz or .zst) inflates from the mapping straight into the parse buffer
+            PhaseTimer inflateTimer(denigmaContext, ConversionStats::Phase::Inflate);
+            result.primaryBuffer = utils::decompress(mapping->data(), compression);
+        } else {
+            result.mappedPrimaryBuffer = std::move(mapping);
+        }
+        return result;
+    } catch (const std::exception& ex) {
         denigmaContext.logMessage(LogMsg() << "unable to read " << utils::asUtf8Bytes(inputPath), MessageSeverity::Error);
         denigmaContext.logMessage(LogMsg() << "message: " << ex.what(), MessageSeverity::Error);
-        if (const auto* ec = dynamic_cast<const std::error_code*>(&ex.code())) {
-            denigmaContext.logMessage(LogMsg() << "details: " << ec->message(), MessageSeverity::Error);
-        }
         throw;
     };
 }
@@ -297,7 +364,7 @@ CommandInputData extractMusxInputData(const std::filesystem::path& inputPath, co
         return {};
     }
     try {
-        FileRandomAccessReader reader(inputPath);
+        MappedFileRandomAccessReader reader(inputPath);
         return extractMusxInputData(reader, denigmaContext);
     } catch (const std::exception& ex) {
         denigmaContext.logMessage(LogMsg() << "unable to extract enigmaxml from file " << utils::asUtf8Bytes(inputPath), MessageSeverity::Error);
@@ -308,6 +375,7 @@ CommandInputData extractMusxInputData(const std::filesystem::path& inputPath, co
 
 CommandInputData extractMusxInputData(const IRandomAccessReader& reader, const DenigmaContext& denigmaContext)
 {
+    TraceSpan span("extractMusxInputData");
     MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
     if (denigmaContext.forTestOutput()) {
         denigmaContext.logMessage(LogMsg() << "Extracting from random-access reader");
@@ -322,6 +390,75 @@ CommandInputData extractMusxInputData(const IRandomAccessReader& reader, const D
     }
 }
 
+void streamMusxToEnigmaXml(const IRandomAccessReader& reader, std::ostream& output, const DenigmaContext& denigmaContext)
+{
+    MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+    // The score encoder restarts its key stream every RECODE_BLOCK bytes, so each block of score.dat can be
+    // recoded on its own and fed straight to the gzip inflater.
+    constexpr std::size_t RECODE_BLOCK = 0x20000;
+    constexpr std::size_t OUTPUT_CHUNK = 0x40000;
+
+    z_stream stream{};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) { // 16 + MAX_WBITS = gzip stream
+        throw std::runtime_error("unable to initialize zlib inflate");
+    }
+    try {
+        std::vector<char> inflated(OUTPUT_CHUNK);
+        std::optional<utils::XmlIndentStripper> stripper;
+        std::string stripped;
+        if (denigmaContext.compactXml) {
+            stripper.emplace();
+        }
+        auto writeInflated = [&](std::size_t size) {
+            if (stripper) {
+                stripped.clear();
+                stripper->strip(std::string_view(inflated.data(), size), stripped);
+                output.write(stripped.data(), static_cast<std::streamsize>(stripped.size()));
+            } else {
+                output.write(inflated.data(), static_cast<std::streamsize>(size));
+            }
+        };
+        bool streamEnded = false;
+        PhaseTimer unzipTimer(denigmaContext, ConversionStats::Phase::Unzip); // paused while each block is decoded and inflated
+        utils::readFileInChunks(reader, SCORE_DAT_NAME, RECODE_BLOCK, [&](std::span<char> block) {
+            if (streamEnded) {
+                return; // like gunzipBuffer, ignore anything after the gzip stream
+            }
+            {
+                PhaseTimer decodeTimer(denigmaContext, ConversionStats::Phase::Decode);
+                musx::encoder::ScoreFileEncoder::recodeBuffer(block.data(), block.size());
+            }
+            PhaseTimer inflateTimer(denigmaContext, ConversionStats::Phase::Inflate);
+            stream.next_in = reinterpret_cast<Bytef*>(block.data());
+            stream.avail_in = static_cast<uInt>(block.size());
+            while (stream.avail_in > 0 && !streamEnded) {
+                stream.next_out = reinterpret_cast<Bytef*>(inflated.data());
+                stream.avail_out = static_cast<uInt>(inflated.size());
+                const int rc = inflate(&stream, Z_NO_FLUSH);
+                if (rc != Z_OK && rc != Z_STREAM_END) {
+                    throw std::runtime_error("unable to decompress gzip stream");
+                }
+                streamEnded = rc == Z_STREAM_END;
+                writeInflated(inflated.size() - stream.avail_out);
+            }
+        }, denigmaContext);
+        if (!streamEnded) {
+            throw std::runtime_error("unexpected end of gzip stream");
+        }
+        if (stripper) {
+            stripped.clear();
+            stripper->finish(stripped);
+            output.write(stripped.data(), static_cast<std::streamsize>(stripped.size()));
+        }
+        inflateEnd(&stream);
+    } catch (const std::exception& ex) {
+        inflateEnd(&stream);
+        denigmaContext.logMessage(LogMsg() << "unable to extract enigmaxml from random-access reader", MessageSeverity::Error);
+        denigmaContext.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
+        throw;
+    }
+}
+
 void writeEnigmaXml(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext)
 {
     MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
@@ -333,16 +470,34 @@ void writeEnigmaXml(const std::filesystem::path& outputPath, const CommandInputD
     if (!denigmaContext.validatePathsAndOptions(outputPath)) return;
 
     try	{
-        const Buffer& xmlBuffer = inputData.primaryBuffer;
+        const auto xmlBuffer = inputData.primaryXml();
+        if (enigma_binary::isEnigmaBinary(xmlBuffer)) {
+            denigmaContext.logMessage(LogMsg() << "a binary enigmaxml cache cannot be written as enigmaxml: "
+                << utils::asUtf8Bytes(outputPath), MessageSeverity::Error);
+            return;
+        }
         std::ifstream inFile;
 
         size_t uncompressedSize = xmlBuffer.size();
         denigmaContext.logMessage(LogMsg() << "decompressed size of enigmaxml: " << uncompressedSize);
 
-        std::ofstream xmlFile;
-        xmlFile.exceptions(std::ios::failbit | std::ios::badbit);
-        xmlFile.open(outputPath, std::ios::binary);
-        xmlFile.write(xmlBuffer.data(), xmlBuffer.size());
+        OutputFile xmlFile(outputPath, denigmaContext.outputArchive, denigmaContext.outputWriter);
+        std::string compact;
+        std::span<const char> xml = xmlBuffer;
+        if (denigmaContext.compactXml) {
+            compact = utils::stripXmlIndentation(std::string_view(xmlBuffer.data(), xmlBuffer.size()));
+            xml = std::span<const char>(compact.data(), compact.size());
+        }
+        if (isCompressedEnigmaXml(outputPath)) {
+            const auto compression = utils::compressionForExtension(utils::normalizedPathExtension(outputPath));
+            PhaseTimer serializeTimer(denigmaContext, ConversionStats::Phase::Serialize);
+            const auto compressed = utils::compress(xml, compression);
+            denigmaContext.logMessage(LogMsg() << "compressed enigmaxml to " << compressed.size() << " bytes", MessageSeverity::Verbose);
+            xmlFile.write(std::span<const char>(compressed.data(), compressed.size()));
+        } else {
+            xmlFile.write(xml);
+        }
+        xmlFile.close();
     } catch (const std::ios_base::failure& ex) {
         std::stringstream sst;
         denigmaContext.logMessage(LogMsg() << "unable to write " << utils::asUtf8Bytes(outputPath), MessageSeverity::Error);
@@ -354,6 +509,48 @@ void writeEnigmaXml(const std::filesystem::path& outputPath, const CommandInputD
     }
 }
 
+/// Returns the binary cache of inputData's EnigmaXML, or the input itself when it already is one.
+static Buffer enigmaBinaryFrom(const CommandInputData& inputData, const DenigmaContext& denigmaContext)
+{
+    const auto xmlBuffer = inputData.primaryXml();
+    if (enigma_binary::isEnigmaBinary(xmlBuffer)) {
+        return Buffer(xmlBuffer.begin(), xmlBuffer.end());
+    }
+    PhaseTimer serializeTimer(denigmaContext, ConversionStats::Phase::Serialize);
+    auto binary = enigma_binary::encode(xmlBuffer);
+    denigmaContext.logMessage(LogMsg() << "encoded " << xmlBuffer.size() << " bytes of enigmaxml as " << binary.size()
+        << " bytes of binary enigmaxml", MessageSeverity::Verbose);
+    return binary;
+}
+
+void writeEnigmaBinary(std::ostream& output, const CommandInputData& inputData, const DenigmaContext& denigmaContext)
+{
+    const Buffer binary = enigmaBinaryFrom(inputData, denigmaContext);
+    output.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+}
+
+void writeEnigmaBinaryForCli(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext)
+{
+    MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+    if (denigmaContext.forTestOutput()) {
+        denigmaContext.logMessage(LogMsg() << "Writing " << utils::asUtf8Bytes(outputPath));
+        return;
+    }
+
+    if (!denigmaContext.validatePathsAndOptions(outputPath)) return;
+
+    try {
+        const Buffer binary = enigmaBinaryFrom(inputData, denigmaContext);
+        OutputFile binaryFile(outputPath, denigmaContext.outputArchive, denigmaContext.outputWriter);
+        binaryFile.write(binary);
+        binaryFile.close();
+    } catch (const std::exception& ex) {
+        denigmaContext.logMessage(LogMsg() << "unable to write binary enigmaxml to " << utils::asUtf8Bytes(outputPath), MessageSeverity::Error);
+        denigmaContext.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
+        throw;
+    }
+}
+
 void writeMusxForCli(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext)
 {
     MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
@@ -365,14 +562,22 @@ void writeMusxForCli(const std::filesystem::path& outputPath, const CommandInput
     if (!denigmaContext.validatePathsAndOptions(outputPath)) return;
 
     try {
-        const Buffer& xmlBuffer = inputData.primaryBuffer;
-        std::string encodedBuffer = gzipBuffer(xmlBuffer);
+        const auto xmlBuffer = inputData.primaryXml();
+        if (enigma_binary::isEnigmaBinary(xmlBuffer)) {
+            denigmaContext.logMessage(LogMsg() << "a binary enigmaxml cache cannot be written as musx: "
+                << utils::asUtf8Bytes(outputPath), MessageSeverity::Error);
+            return;
+        }
+        std::string encodedBuffer = gzipBuffer(xmlBuffer, denigmaContext.musxCompressionLevel, denigmaContext);
         musx::encoder::ScoreFileEncoder::recodeBuffer(encodedBuffer);
         const auto [fileVersionMajor, fileVersionMinor] = extractFileVersionFromEnigmaXml(xmlBuffer);
 
-        zipFile outputZip = openZipForWrite(outputPath);
-        if (!outputZip) {
-            throw std::runtime_error("unable to create output musx archive");
+        std::string archiveEntry; // the musx, when it goes into the run's output archive or to the write-behind writer
+        std::optional<utils::ZipStreamWriter> outputZip;
+        if (denigmaContext.outputArchive || denigmaContext.outputWriter) {
+            outputZip.emplace(archiveEntry);
+        } else {
+            outputZip.emplace(outputPath);
         }
 
         static const std::string kMimetype = "application/vnd.makemusic.notation";
@@ -394,14 +599,16 @@ void writeMusxForCli(const std::filesystem::path& outputPath, const CommandInput
             "  </fileInfo>\n"
             "</metadata>\n";
 
-        writeZipEntry(outputZip, "mimetype", kMimetype, 0, 0);
-        writeZipEntry(outputZip, "META-INF/container.xml", kContainerXml, Z_DEFLATED, Z_DEFAULT_COMPRESSION);
-        writeZipEntry(outputZip, "NotationMetadata.xml", kNotationMetadataXml, Z_DEFLATED, Z_DEFAULT_COMPRESSION);
-        writeZipEntry(outputZip, SCORE_DAT_NAME, encodedBuffer, Z_DEFLATED, Z_DEFAULT_COMPRESSION);
-
-        int rc = zipClose(outputZip, nullptr);
-        if (rc != ZIP_OK) {
-            throw std::runtime_error("unable to finalize musx archive");
+        outputZip->writeEntry("mimetype", kMimetype, 0);
+        outputZip->writeEntry("META-INF/container.xml", kContainerXml, Z_DEFAULT_COMPRESSION);
+        outputZip->writeEntry("NotationMetadata.xml", kNotationMetadataXml, Z_DEFAULT_COMPRESSION);
+        // score.dat is already gzip (recoded), so deflating it again would cost time for no gain.
+        outputZip->writeEntry(SCORE_DAT_NAME, encodedBuffer, 0);
+        outputZip->close();
+        if (denigmaContext.outputArchive) {
+            denigmaContext.outputArchive->add(outputPath, archiveEntry);
+        } else if (denigmaContext.outputWriter) {
+            denigmaContext.outputWriter->write(outputPath, std::move(archiveEntry));
         }
     } catch (const std::exception& ex) {
         denigmaContext.logMessage(LogMsg() << "unable to write musx to " << utils::asUtf8Bytes(outputPath), MessageSeverity::Error);
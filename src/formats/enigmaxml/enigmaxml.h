@@ -21,6 +21,7 @@
  */
 #pragma once
 
+#include <ostream>
 #include <string>
 #include <vector>
 #include <optional>
@@ -35,8 +36,13 @@ namespace detail {
 
 CommandInputData extractMusxInputData(const std::filesystem::path& inputFile, const DenigmaContext& denigmaContext);
 CommandInputData extractMusxInputData(const IRandomAccessReader& reader, const DenigmaContext& denigmaContext);
+/// Writes the EnigmaXML in a musx archive to output without holding all of it, one recode block at a time.
+void streamMusxToEnigmaXml(const IRandomAccessReader& reader, std::ostream& output, const DenigmaContext& denigmaContext);
 CommandInputData readEnigmaXmlInputData(const std::filesystem::path& inputFile, const DenigmaContext& denigmaContext);
 void writeEnigmaXml(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext);
+/// Writes the binary Enigma XML cache of inputData to output, passing it through if it is one already.
+void writeEnigmaBinary(std::ostream& output, const CommandInputData& inputData, const DenigmaContext& denigmaContext);
+void writeEnigmaBinaryForCli(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext);
 void writeMusxForCli(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext);
 
 } // namespace detail
@@ -38,12 +38,23 @@ ConversionResult MusxToEnigmaXmlConverter::convert(const IRandomAccessReader& in
         ? std::filesystem::path("input.musx")
         : utils::utf8ToPath(options.common.sourceName);
     context.noValidate = !options.common.validate;
+    context.outputJobs = options.common.outputJobs;
+    context.executor = options.common.executor;
+    context.cancellation = options.common.cancellation;
+    context.deadline = options.common.deadline;
+    context.textMetrics = options.common.textMetrics;
     context.logCallback = options.common.logCallback;
+    context.compactXml = !options.prettyPrint;
     context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common, &output);
     MusxLoggerScope musxLogger(makeMusxLogCallback(context));
 
-    const Buffer buffer = detail::extractMusxInputData(input, context).primaryBuffer;
-    output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    try {
+        detail::streamMusxToEnigmaXml(input, output, context); // a pass-through needs no DOM, nor the whole XML at once
+    } catch (const ConversionCancelled& ex) {
+        context.logMessage(LogMsg() << "Enigma XML extraction stopped (" << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
     return result;
 }
 
@@ -54,9 +65,48 @@ ConversionResult MusxToEnigmaXmlConverter::convert(const IRandomAccessReader& in
     return convert(input, output, optionsFromRequest<Options>(request, "MusxToEnigmaXmlConverter"));
 }
 
+ConversionResult MusxToEnigmaBinaryConverter::convert(const IRandomAccessReader& input,
+                                                     std::ostream& output,
+                                                     const Options& options) const
+{
+    ConversionResult result;
+    DenigmaContext context(DENIGMA_NAME);
+    context.inputFilePath = options.common.sourceName.empty()
+        ? std::filesystem::path("input.musx")
+        : utils::utf8ToPath(options.common.sourceName);
+    context.noValidate = !options.common.validate;
+    context.outputJobs = options.common.outputJobs;
+    context.executor = options.common.executor;
+    context.cancellation = options.common.cancellation;
+    context.deadline = options.common.deadline;
+    context.textMetrics = options.common.textMetrics;
+    context.logCallback = options.common.logCallback;
+    context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common, &output);
+    MusxLoggerScope musxLogger(makeMusxLogCallback(context));
+
+    try {
+        const auto inputData = detail::extractMusxInputData(input, context);
+        detail::writeEnigmaBinary(output, inputData, context);
+    } catch (const std::exception& ex) {
+        context.logMessage(LogMsg() << "unable to extract binary Enigma XML", MessageSeverity::Error);
+        context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
+    return result;
+}
+
+ConversionResult MusxToEnigmaBinaryConverter::convert(const IRandomAccessReader& input,
+                                                     std::ostream& output,
+                                                     const ConversionRequest& request) const
+{
+    return convert(input, output, optionsFromRequest<Options>(request, "MusxToEnigmaBinaryConverter"));
+}
+
 void registerConverters(ConverterRegistry& registry)
 {
     registry.add(std::make_unique<MusxToEnigmaXmlConverter>());
+    registry.add(std::make_unique<MusxToEnigmaBinaryConverter>());
 }
 
 } // namespace enigmaxml
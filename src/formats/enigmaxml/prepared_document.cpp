@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "prepared_document.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+#include "core/musx_reader.h"
+#include "enigmaxml.h"
+#include "utils/stringutils.h"
+
+namespace denigma {
+
+namespace {
+
+DenigmaContext makePreparationContext(const CommonOptions& options, std::string_view defaultSourceName, ConversionResult& result)
+{
+    DenigmaContext context(DENIGMA_NAME);
+    context.inputFilePath = options.sourceName.empty()
+        ? std::filesystem::path(defaultSourceName)
+        : utils::utf8ToPath(options.sourceName);
+    context.noValidate = !options.validate;
+    context.verbose = options.verbose;
+    context.quiet = options.quiet;
+    context.outputJobs = options.outputJobs;
+    context.executor = options.executor;
+    context.cancellation = options.cancellation;
+    context.deadline = options.deadline;
+    context.textMetrics = options.textMetrics;
+    context.logCallback = options.logCallback;
+    context.conversionResult = &result;
+    return context;
+}
+
+/// Returns true if any linked part of document has part voicing. Without any, PartVoicingPolicy changes nothing.
+bool calcHasPartVoicing(const musx::dom::DocumentPtr& document)
+{
+    const auto parts = document->getOthers()->getArray<musx::dom::others::PartDefinition>(musx::dom::SCORE_PARTID);
+    return std::any_of(parts.begin(), parts.end(), [&](const auto& part) {
+        return part->getCmper() != musx::dom::SCORE_PARTID
+            && !document->getOthers()->getArray<musx::dom::others::PartVoicing>(part->getCmper()).empty();
+    });
+}
+
+} // namespace
+
+musx::dom::DocumentPtr PreparedDocument::Impl::document(musx::dom::PartVoicingPolicy partVoicingPolicy,
+                                                        const DenigmaContext& denigmaContext) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const bool applyVoicing = partVoicingPolicy == musx::dom::PartVoicingPolicy::Apply;
+    auto& document = applyVoicing ? m_applyVoicingDocument : m_ignoreVoicingDocument;
+    if (!document) {
+        const auto& otherDocument = applyVoicing ? m_ignoreVoicingDocument : m_applyVoicingDocument;
+        if (otherDocument && !calcHasPartVoicing(otherDocument)) {
+            document = otherDocument;
+        } else {
+            document = createMusxDocument<MusxReader>(m_inputData, denigmaContext, partVoicingPolicy);
+        }
+    }
+    return document;
+}
+
+musx::dom::DocumentPtr PreparedDocument::Impl::document(MusxLoadProfile profile, const DenigmaContext& denigmaContext) const
+{
+    if (profile == MusxLoadProfile::Full) {
+        return document(musx::dom::PartVoicingPolicy::Ignore, denigmaContext);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_ignoreVoicingDocument) {
+        return m_ignoreVoicingDocument;
+    }
+    if (m_applyVoicingDocument && !calcHasPartVoicing(m_applyVoicingDocument)) {
+        return m_applyVoicingDocument;
+    }
+    auto& document = m_profileDocuments[profile];
+    if (!document) {
+        switch (profile) {
+        case MusxLoadProfile::Styles:
+            document = createMusxDocument<MusxStylesReader>(m_inputData, denigmaContext, musx::dom::PartVoicingPolicy::Ignore, false);
+            break;
+        case MusxLoadProfile::Shapes:
+            document = createMusxDocument<MusxShapesReader>(m_inputData, denigmaContext);
+            break;
+        case MusxLoadProfile::Metadata:
+            document = createMusxDocument<MusxMetadataReader>(m_inputData, denigmaContext, musx::dom::PartVoicingPolicy::Ignore, false);
+            break;
+        case MusxLoadProfile::Full:
+            break; // handled above
+        }
+    }
+    return document;
+}
+
+PreparedDocument::PreparedDocument(std::unique_ptr<Impl> impl)
+    : m_impl(std::move(impl))
+{
+}
+
+PreparedDocument::~PreparedDocument() = default;
+PreparedDocument::PreparedDocument(PreparedDocument&&) noexcept = default;
+PreparedDocument& PreparedDocument::operator=(PreparedDocument&&) noexcept = default;
+
+PreparedDocument PreparedDocument::fromEnigmaXml(std::span<const std::byte> input, const CommonOptions& options)
+{
+    auto impl = std::make_unique<Impl>(CommandInputData::fromBorrowedBytes(input));
+    impl->sourceName = options.sourceName;
+    return PreparedDocument(std::move(impl));
+}
+
+PreparedDocument PreparedDocument::fromMusx(const IRandomAccessReader& input, const CommonOptions& options)
+{
+    ConversionResult result;
+    auto context = makePreparationContext(options, "input.musx", result);
+    ConversionStatsScope stats(context, options);
+    MusxLoggerScope musxLogger(makeMusxLogCallback(context));
+
+    CommandInputData inputData;
+    try {
+        inputData = formats::enigmaxml::detail::extractMusxInputData(input, context);
+    } catch (const std::exception& ex) {
+        context.logMessage(LogMsg() << "unable to prepare MUSX input", MessageSeverity::Error);
+        context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
+    auto impl = std::make_unique<Impl>(std::move(inputData));
+    impl->sourceName = options.sourceName;
+    impl->preparationResult = std::move(result);
+    return PreparedDocument(std::move(impl));
+}
+
+const ConversionResult& PreparedDocument::preparationResult() const noexcept
+{
+    return m_impl->preparationResult;
+}
+
+} // namespace denigma
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "denigma/prepared_document.h"
+#include "core/denigma.h"
+
+namespace denigma {
+
+enum class MusxLoadProfile; // see core/musx_reader.h
+
+class PreparedDocument::Impl
+{
+public:
+    explicit Impl(CommandInputData inputData) : m_inputData(std::move(inputData)) {}
+
+    const CommandInputData& inputData() const { return m_inputData; }
+
+    /// Returns the parsed document for partVoicingPolicy, parsing it with denigmaContext on first request. A score
+    /// whose parts voice no staves builds the same document under either policy, so one document serves both.
+    musx::dom::DocumentPtr document(musx::dom::PartVoicingPolicy partVoicingPolicy, const DenigmaContext& denigmaContext) const;
+
+    /// Returns a document, ignoring part voicing, that holds at least what profile reads. That is the full document
+    /// when a target that needs it has already built it, and otherwise one loaded with profile on first request, so
+    /// that targets which never read entries or details (styles, shapes) do not materialize them.
+    musx::dom::DocumentPtr document(MusxLoadProfile profile, const DenigmaContext& denigmaContext) const;
+
+    std::string sourceName;                 ///< UTF-8 source name supplied when the document was prepared
+    ConversionResult preparationResult;     ///< diagnostics collected while extracting the source
+
+private:
+    CommandInputData m_inputData;
+    mutable std::mutex m_mutex;
+    mutable musx::dom::DocumentPtr m_ignoreVoicingDocument;
+    mutable musx::dom::DocumentPtr m_applyVoicingDocument;
+    mutable std::map<MusxLoadProfile, musx::dom::DocumentPtr> m_profileDocuments; ///< built for profiles other than Full
+};
+
+} // namespace denigma
@@ -19,14 +19,26 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
 #include <ostream>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "mnx.h"
+#include "mnx_schema.h"
+#include "core/background_release.h"
 #include "core/musx_reader.h"
+#include "core/parallel.h"
+#include "core/part_layout.h"
 #include "utils/stringutils.h"
 
 using namespace musx::dom;
@@ -36,8 +48,6 @@ namespace formats {
 namespace mnx {
 namespace detail {
 
-namespace {
-
 musx::util::Logger::LogCallback makeMusxLogCallback(const MnxMusxMappingPtr& context)
 {
     return [context](musx::util::Logger::LogLevel logLevel, const std::string& msg) {
@@ -50,14 +60,17 @@ musx::util::Logger::LogCallback makeMusxLogCallback(const MnxMusxMappingPtr& con
             case musx::util::Logger::LogLevel::Verbose: return MessageSeverity::Verbose;
             }
         }();
-        context->logMessage(LogMsg() << msg, severity);
+        if (context->denigmaContext->shouldLog(severity)) {
+            context->logMessage(LogMsg() << msg, severity);
+        }
     };
 }
 
-} // namespace
-
 void MnxMusxMapping::logMessage(LogMsg&& msg, MessageSeverity severity)
 {
+    if (!denigmaContext->shouldLog(severity)) {
+        return; // before the staff name lookup
+    }
     std::string logEntry;
     if (current.staff > 0 && current.meas > 0) {
         std::string staffName = [&]() -> std::string {
@@ -82,6 +95,7 @@ void MnxMusxMapping::logMessage(LogMsg&& msg, MessageSeverity severity)
 void MnxMusxMapping::logDiscardedCueLayerFrame(LayerIndex layer)
 {
     discardedCueFrames++;
+    denigmaContext->countHotPath(ConversionStats::HotPath::DiscardedCueFrame);
     logMessage(LogMsg() << "discarded cue material detected by --cue-layer in measure "
         << current.meas << ", staff " << current.staff << ", layer " << (layer + 1)
         << "; MNX does not currently support cues.");
@@ -90,16 +104,60 @@ void MnxMusxMapping::logDiscardedCueLayerFrame(LayerIndex layer)
 void MnxMusxMapping::logDiscardedHeuristicCueHold()
 {
     discardedCueFrames++;
+    denigmaContext->countHotPath(ConversionStats::HotPath::DiscardedCueFrame);
     logMessage(LogMsg() << "discarded cue material detected heuristically in measure "
         << current.meas << ", staff " << current.staff
         << "; MNX does not currently support cues.");
 }
 
+void MnxMusxMapping::mergePartFrom(MnxMusxMapping& worker, size_t partIndex)
+{
+    // A part's measures only write into that part and, for kit notes, into the global sounds.
+    auto& root = *mnxDocument->root();
+    auto& workerRoot = *worker.mnxDocument->root();
+    root["parts"][partIndex] = std::move(workerRoot["parts"][partIndex]);
+    auto& workerGlobal = workerRoot["global"];
+    if (const auto workerSounds = workerGlobal.find("sounds"); workerSounds != workerGlobal.end()) {
+        auto& sounds = root["global"]["sounds"];
+        if (sounds.is_null()) {
+            sounds = std::decay_t<decltype(root)>::object();
+        }
+        for (auto it = workerSounds->begin(); it != workerSounds->end(); ++it) {
+            if (!sounds.contains(it.key())) {
+                sounds[it.key()] = std::move(it.value());
+            }
+        }
+    }
+
+    // The worker's document has the same part order, so its json pointers are valid here as they are.
+    for (auto& [noteKey, pointer] : worker.noteJsonByKey) {
+        noteJsonByKey.emplace(noteKey, std::move(pointer));
+    }
+    for (auto& [entryNumber, target] : worker.entryTargetByNumber) {
+        entryTargetByNumber.insert_or_assign(entryNumber, std::move(target));
+    }
+    for (auto& deferred : worker.deferredJumpTies) {
+        if (deferredJumpTieKeys.emplace(PackedIdKey{ deferred.startNoteKey, deferred.endNoteKey }).second) {
+            deferredJumpTies.push_back(std::move(deferred));
+        }
+    }
+    for (auto& candidate : worker.deferredArpeggios) {
+        if (deferredArpeggioKeys.emplace(arpeggioSpanKey(candidate)).second) {
+            deferredArpeggios.push_back(std::move(candidate));
+        }
+    }
+    discardedCueFrames += worker.discardedCueFrames;
+    staffComposites.mergeFrom(std::move(worker.staffComposites));
+}
+
 void MnxMusxMapping::setCurrentMeasureStaff(const MusxInstance<others::Measure>& musxMeasure, StaffCmper staffCmper)
 {
     current.clear();
     current.meas = musxMeasure->getCmper();
     current.staff = staffCmper;
+    if (!staffContent->hasFrames(current.meas, staffCmper)) {
+        return; // no frames: leave gfhold empty so that the beam and sequence passes skip the cell
+    }
     current.gfhold.emplace(musxMeasure->getDocument(), musxMeasure->getRequestedPartId(), staffCmper, musxMeasure->getCmper());
     if (!*current.gfhold) {
         return;
@@ -107,18 +165,29 @@ void MnxMusxMapping::setCurrentMeasureStaff(const MusxInstance<others::Measure>&
 
     current.layerVoices = current.gfhold->calcVoices();
     current.cueDiscardPlan = createCueLayerPlan(*current.gfhold, denigmaContext->cueLayer);
-    if (!current.cueDiscardPlan.heuristicCueLayers.empty()) {
+    if (current.cueDiscardPlan.hasHeuristicCueLayers()) {
         logDiscardedHeuristicCueHold();
         if (current.cueDiscardPlan.discardWholeHold) {
             return;
         }
     }
     if (current.cueDiscardPlan.explicitCueLayer
-        && !current.cueDiscardPlan.heuristicCueLayers.contains(*current.cueDiscardPlan.explicitCueLayer)) {
+        && !current.cueDiscardPlan.isHeuristicCueLayer(*current.cueDiscardPlan.explicitCueLayer)) {
         logDiscardedCueLayerFrame(*current.cueDiscardPlan.explicitCueLayer);
     }
 }
 
+const MnxMusxMapping::PercussionIds& MnxMusxMapping::percussionIdsFor(const MusxInstance<others::PercussionNoteInfo>& percNoteInfo)
+{
+    // a drum map has a few dozen note types, while a drum part has one kit note per hit
+    auto [it, inserted] = percussionIds.try_emplace(percNoteInfo->percNoteType);
+    if (inserted) {
+        it->second.kitId = calcPercussionKitId(percNoteInfo);
+        it->second.soundId = calcPercussionSoundId(percNoteInfo);
+    }
+    return it->second;
+}
+
 std::optional<int> MnxMusxMapping::mnxPartStaffFromStaff(StaffCmper staff) const
 {
     const auto it = std::find(currPartStaves.begin(), currPartStaves.end(), staff);
@@ -203,16 +272,15 @@ static void createScores(const MnxMusxMappingPtr& context)
                 mnxMmRest.set_label("");
             }
         }
-        auto pages = context->document->getOthers()->getArray<others::Page>(linkedPart->getCmper());
-        for (size_t x = 0; x < pages.size(); x++) {
+        const auto layout = PartLayout::forPart(context->document, linkedPart->getCmper());
+        for (const auto& page : layout->getPages()) {
             auto mnxPage = mnxScore.ensure_pages().append();
             auto mnxSystems = mnxPage.systems();
-            auto page = pages[x];
-            if (!page->isBlank() && page->lastSystemId.has_value()) {
-                for (SystemCmper sysId = page->firstSystemId; sysId <= page->lastSystemId.value(); sysId++) {
-                    auto system = context->document->getOthers()->get<others::StaffSystem>(linkedPart->getCmper(), sysId);
+            if (!page.blank && page.lastSystem.has_value()) {
+                for (SystemCmper sysId = page.firstSystem; sysId <= page.lastSystem.value(); sysId++) {
+                    const auto* system = layout->findSystem(sysId);
                     if (!system) {
-                        throw std::logic_error("System " + std::to_string(sysId) + " on page " + std::to_string(page->getCmper())
+                        throw std::logic_error("System " + std::to_string(sysId) + " on page " + std::to_string(page.id)
                             + " in part " + linkedPart->getName() + " does not exist.");
                     }
                     auto mnxSystem = mnxSystems.append(calcGlobalMeasureId(system->startMeas));
@@ -226,9 +294,10 @@ static void createScores(const MnxMusxMappingPtr& context)
     }
 }
 
-static std::unique_ptr<mnxdom::Document> createMnxDocument(const CommandInputData& inputData, const DenigmaContext& denigmaContext)
+static std::unique_ptr<mnxdom::Document> createMnxDocument(const DocumentPtr& document, const DenigmaContext& denigmaContext)
 {
-    auto document = denigma::createMusxDocument<MusxReader>(inputData, denigmaContext);
+    TraceSpan span("createMnxDocument");
+    ClassificationCacheScope classificationCache(document, denigmaContext);
     auto context = std::make_shared<MnxMusxMapping>(denigmaContext, document);
     context->mnxDocument = std::make_unique<mnxdom::Document>();
     context->musxParts = others::PartDefinition::getInUserOrder(document);
@@ -240,7 +309,8 @@ static std::unique_ptr<mnxdom::Document> createMnxDocument(const CommandInputDat
     finalizeArpeggios(context);
     finalizeJumpTies(context);
     // Split-instrument parts need time-varying layout sources; skip scores/layouts until MNX has a stable model for that.
-    if (!denigmaContext.mnxSplitInstruments) {
+    // An excerpt's layouts would refer to staves and systems that are not in it, so it gets none either.
+    if (!denigmaContext.mnxSplitInstruments && !context->excerpt.isPartial()) {
         createLayouts(context); // must come after createParts
         createScores(context); // must come after createLayouts
     }
@@ -252,42 +322,142 @@ static std::unique_ptr<mnxdom::Document> createMnxDocument(const CommandInputDat
     return std::move(context->mnxDocument);
 }
 
+static bool shouldValidateMnxDocument(const DenigmaContext& denigmaContext)
+{
+    if (denigmaContext.noValidate) {
+        return false;
+    }
+    if (denigmaContext.validateEvery <= 1) {
+        return true;
+    }
+    // One count per process, so a batch run validates 1 in N of its files whichever thread converts them.
+    static std::atomic<unsigned long long> conversionCount{ 0 };
+    if (conversionCount.fetch_add(1, std::memory_order_relaxed) % denigmaContext.validateEvery == 0) {
+        return true;
+    }
+    denigmaContext.logMessage(LogMsg() << "Validation skipped (validating 1 in " << denigmaContext.validateEvery << " outputs).",
+        MessageSeverity::Verbose);
+    return false;
+}
+
 static void validateMnxDocument(const mnxdom::Document& mnxDocument, const DenigmaContext& denigmaContext)
 {
-    if (!denigmaContext.noValidate) {
-        denigmaContext.logMessage(LogMsg() << "Validation starting.", MessageSeverity::Verbose);
-        if (auto validateResult = mnxdom::validation::schemaValidate(mnxDocument, denigmaContext.mnxSchema); !validateResult) {
-            denigmaContext.logMessage(LogMsg() << "Schema validation errors:", MessageSeverity::Warning);
-            for (const auto& error : validateResult.errors) {
-                denigmaContext.logMessage(LogMsg() << "    " << error.to_string(), MessageSeverity::Warning);
+    TraceSpan span("validateMnxDocument");
+    PhaseTimer validateTimer(denigmaContext, ConversionStats::Phase::Validate);
+    denigmaContext.logMessage(LogMsg() << "Validation starting.", MessageSeverity::Verbose);
+    // A caller-supplied schema is compiled once per process and reused, and its sections are checked on the output
+    // workers; the embedded schema is mnxdom's to manage.
+    std::vector<std::string> schemaErrors;
+    if (denigmaContext.mnxSchema) {
+        schemaErrors = CompiledMnxSchema::forSchema(denigmaContext.mnxSchema.value())->validate(mnxDocument, denigmaContext);
+    } else if (auto validateResult = mnxdom::validation::schemaValidate(mnxDocument, std::nullopt); !validateResult) {
+        for (const auto& error : validateResult.errors) {
+            schemaErrors.push_back(error.to_string());
+        }
+    }
+    if (!schemaErrors.empty()) {
+        denigmaContext.logMessage(LogMsg() << "Schema validation errors:", MessageSeverity::Warning);
+        for (const auto& error : schemaErrors) {
+            denigmaContext.logMessage(LogMsg() << "    " << error, MessageSeverity::Warning);
+        }
+    } else {
+        denigmaContext.logMessage(LogMsg() << "Schema validation succeeded.");
+        if (auto semanticResult = mnxdom::validation::semanticValidate(mnxDocument); !semanticResult) {
+            denigmaContext.logMessage(LogMsg() << "Semantic validation errors:", MessageSeverity::Warning);
+            for (const auto& error : semanticResult.errors) {
+                denigmaContext.logMessage(LogMsg() << "    " << error.to_string(4), MessageSeverity::Warning);
             }
         } else {
-            denigmaContext.logMessage(LogMsg() << "Schema validation succeeded.");
-            if (auto semanticResult = mnxdom::validation::semanticValidate(mnxDocument); !semanticResult) {
-                denigmaContext.logMessage(LogMsg() << "Semantic validation errors:", MessageSeverity::Warning);
-                for (const auto& error : semanticResult.errors) {
-                    denigmaContext.logMessage(LogMsg() << "    " << error.to_string(4), MessageSeverity::Warning);
-                }
-            } else {
-                size_t layoutSize = mnxDocument.layouts() ? mnxDocument.layouts().value().size() : 0;
-                denigmaContext.logMessage(LogMsg() << "Semantic validation complete (" << mnxDocument.global().measures().size() << " measures, "
-                    << mnxDocument.parts().size() << " parts, " << layoutSize << " layouts).");
-            }
+            size_t layoutSize = mnxDocument.layouts() ? mnxDocument.layouts().value().size() : 0;
+            denigmaContext.logMessage(LogMsg() << "Semantic validation complete (" << mnxDocument.global().measures().size() << " measures, "
+                << mnxDocument.parts().size() << " parts, " << layoutSize << " layouts).");
         }
     }
 }
 
-static void writeMnxDocumentJson(std::ostream& output, const mnxdom::Document& mnxDocument, const DenigmaContext& denigmaContext)
+static void writeMnxDocument(std::ostream& output, const mnxdom::Document& mnxDocument, const DenigmaContext& denigmaContext)
+{
+    PhaseTimer serializeTimer(denigmaContext, ConversionStats::Phase::Serialize);
+    using JsonType = std::decay_t<decltype(*mnxDocument.root())>;
+    const auto& root = *mnxDocument.root();
+    switch (denigmaContext.mnxEncoding) {
+        case formats::mnx::Encoding::Cbor:
+            JsonType::to_cbor(root, nlohmann::detail::output_adapter<char>(output));
+            return;
+        case formats::mnx::Encoding::MessagePack:
+            JsonType::to_msgpack(root, nlohmann::detail::output_adapter<char>(output));
+            return;
+        case formats::mnx::Encoding::Bson:
+            JsonType::to_bson(root, nlohmann::detail::output_adapter<char>(output));
+            return;
+        case formats::mnx::Encoding::Json:
+            break;
+    }
+    // Serialize straight into the stream rather than through dump(), which builds the whole text as one string first.
+    // This is what operator<< does, except that it cannot express dump(0) (newlines without indentation).
+    const int indent = denigmaContext.indentSpaces.value_or(-1);
+    nlohmann::detail::serializer<JsonType> serializer(nlohmann::detail::output_adapter<char>(output), ' ');
+    serializer.dump(root, indent >= 0, false, static_cast<unsigned int>((std::max)(indent, 0)));
+}
+
+/// Writes mnxDocument to output, validating it first or alongside when the context asks for validation.
+static void writeAndValidateMnxDocument(std::ostream& output, const mnxdom::Document& mnxDocument, const DenigmaContext& denigmaContext)
 {
-    output << mnxDocument.root()->dump(denigmaContext.indentSpaces.value_or(-1));
+    if (!shouldValidateMnxDocument(denigmaContext)) {
+        writeMnxDocument(output, mnxDocument, denigmaContext);
+        return;
+    }
+    if (!denigmaContext.validateConcurrently) {
+        validateMnxDocument(mnxDocument, denigmaContext);
+        writeMnxDocument(output, mnxDocument, denigmaContext);
+        return;
+    }
+    // Validation only reads the document, so it runs while the document is written. Its messages are buffered
+    // and replayed here afterwards, keeping them off the caller's callback and result from another thread.
+    std::vector<DenigmaContext::BufferedLogMessage> validationLog;
+    DenigmaContext validationContext(denigmaContext);
+    validationContext.conversionResult = nullptr;
+    validationContext.logCallback = nullptr;
+    validationContext.logBuffer = &validationLog;
+    std::exception_ptr validationError;
+    std::chrono::nanoseconds validationTime{};
+    runAlongside(denigmaContext, [&]() {
+            const auto start = std::chrono::steady_clock::now();
+            try {
+                validateMnxDocument(mnxDocument, validationContext);
+            } catch (...) {
+                validationError = std::current_exception();
+            }
+            validationTime = std::chrono::steady_clock::now() - start;
+        }, [&]() {
+            writeMnxDocument(output, mnxDocument, denigmaContext);
+        });
+    if (denigmaContext.conversionResult) {
+        // the validation context has no result to time into, so charge its time here; it overlaps serialization
+        denigmaContext.conversionResult->stats().addPhaseTime(ConversionStats::Phase::Validate, validationTime);
+    }
+    denigmaContext.logCapturedMessages(validationLog);
+    if (validationError) {
+        std::rethrow_exception(validationError);
+    }
+}
+
+void exportJson(std::ostream& output, const DocumentPtr& document, const DenigmaContext& denigmaContext)
+{
+    MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+    auto mnxDocument = createMnxDocument(document, denigmaContext);
+    writeAndValidateMnxDocument(output, *mnxDocument, denigmaContext);
+    // mnxdom fixes the tree's JSON type, allocator included, so a large score's millions of nodes cannot come from
+    // the conversion arena; freeing them is left to another thread instead.
+    releaseInBackground(denigmaContext, std::move(mnxDocument));
 }
 
 void exportJson(std::ostream& output, const CommandInputData& inputData, const DenigmaContext& denigmaContext)
 {
     MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
-    auto mnxDocument = createMnxDocument(inputData, denigmaContext);
-    validateMnxDocument(*mnxDocument, denigmaContext);
-    writeMnxDocumentJson(output, *mnxDocument, denigmaContext);
+    // MNX does not carry page graphics, so leave them compressed.
+    exportJson(output, denigma::createMusxDocument<MusxReader>(inputData, denigmaContext, musx::dom::PartVoicingPolicy::Ignore,
+        /*withEmbeddedGraphics*/ false), denigmaContext);
 }
 
 void exportJson(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext)
@@ -21,19 +21,38 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <ostream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "core/denigma.h"
+#include "core/conversion_arena.h"
+#include "core/conversion_excerpt.h"
 #include "core/cue_layers.h"
+#include "core/entry_frame_cache.h"
 #include "core/finale_options.h"
+#include "core/measure_index.h"
 #include "core/ottavas.h"
+#include "core/packed_keys.h"
+#include "core/smartshape_index.h"
+#include "core/staff_composite_cache.h"
+#include "core/staff_content_index.h"
+#include "utils/dense_index_set.h"
 #include "musx/musx.h"
 #include "mnxdom.h"
 
@@ -73,44 +92,93 @@ struct SequenceHash {
     }
 };
 
+/// The MNX content of a dynamic text expression, derived once per definition (see appendDynamic).
+struct MnxDynamicPrototype
+{
+    std::vector<std::string> sourceText;                        ///< the classified run texts it was derived from
+    bool hasDynamic{};                                          ///< false when the expression yields no MNX dynamic
+    std::optional<mnxdom::DynamicValue> value;
+    std::optional<mnxdom::DynamicValue> attackValue;
+    std::optional<mnxdom::DynamicRelativeValue> relativeValue; ///< set when the dynamic is louder or softer
+    bool isAccent{};
+    std::string prefixText;
+    std::string suffixText;
+    std::vector<std::string> glyphs;
+};
+
 using json = nlohmann::ordered_json;
 //using json = nlohmann::json;
 
 struct MnxMusxMapping
 {
     MnxMusxMapping(const DenigmaContext& context, const DocumentPtr& doc)
-        : denigmaContext(&context), document(doc), finaleOptions(loadFinaleOptions(doc)), mnxDocument(), musxParts(doc, SCORE_PARTID) {}
+        : arena(context), denigmaContext(&context), document(doc), finaleOptions(loadFinaleOptions(doc)), mnxDocument(), musxParts(doc, SCORE_PARTID),
+          measureIndex(std::make_shared<const MeasureIndex>(doc, SCORE_PARTID)),
+          ottavaIndex(std::make_shared<const OttavaIndex>(*measureIndex)),
+          smartShapeStarts(std::make_shared<const SmartShapeStartIndex>(*measureIndex)),
+          staffContent(std::make_shared<const StaffContentIndex>(doc, SCORE_PARTID)), excerpt(context, doc, SCORE_PARTID) {}
+
+    /// Creates a mapping that builds the measures of one part on a worker thread. It starts from a copy of
+    /// source's MNX document and part maps; mergePartFrom later moves its results back into source.
+    MnxMusxMapping(const DenigmaContext& context, const MnxMusxMapping& source)
+        : arena(context), denigmaContext(&context), document(source.document), finaleOptions(source.finaleOptions),
+          mnxDocument(std::make_unique<mnxdom::Document>()), musxParts(source.musxParts),
+          measureIndex(source.measureIndex), ottavaIndex(source.ottavaIndex), smartShapeStarts(source.smartShapeStarts),
+          staffContent(source.staffContent), excerpt(source.excerpt),
+          part2Inst(source.part2Inst, &arena), inst2Part(source.inst2Part, &arena),
+          part2SplitInstrumentUuid(source.part2SplitInstrumentUuid, &arena), lyricLineIds(source.lyricLineIds, &arena)
+    {
+        *mnxDocument->root() = *source.mnxDocument->root();
+    }
 
+    ConversionArena arena; ///< backs the scratch containers below; declared first so that it outlives them
     const DenigmaContext* denigmaContext;
     musx::dom::DocumentPtr document;
     FinaleOptions finaleOptions;
     std::unique_ptr<mnxdom::Document> mnxDocument;
     MusxInstanceList<others::PartDefinition> musxParts;
+    std::shared_ptr<const MeasureIndex> measureIndex; ///< score measure assignments, shared with worker mappings
+    std::shared_ptr<const OttavaIndex> ottavaIndex; ///< carrier ottavas of measureIndex, shared with worker mappings
+    std::shared_ptr<const SmartShapeStartIndex> smartShapeStarts; ///< smart shapes of measureIndex by start, shared with worker mappings
+    std::shared_ptr<const StaffContentIndex> staffContent; ///< measures with frames of each score staff, shared with worker mappings
+    ConversionExcerpt excerpt; ///< the measures and staves being converted; MNX measure arrays start at its first measure
 
-    std::unordered_map<std::string, std::vector<StaffCmper>> part2Inst;
-    std::unordered_map<StaffCmper, std::string> inst2Part;
-    std::unordered_map<std::string, std::string> part2SplitInstrumentUuid;
-    std::unordered_set<std::string> lyricLineIds;
+    std::pmr::unordered_map<std::string, std::vector<StaffCmper>> part2Inst{ &arena };
+    std::pmr::unordered_map<StaffCmper, std::string> inst2Part{ &arena };
+    std::pmr::unordered_map<std::string, std::string> part2SplitInstrumentUuid{ &arena };
+    std::pmr::unordered_set<std::string> lyricLineIds{ &arena };
 
     // musx mappings
-    std::unordered_map<std::string, mnxdom::json_pointer> noteJsonById;
-    std::unordered_map<EntryNumber, EntryTarget> entryTargetByNumber;
+    std::pmr::unordered_map<std::uint64_t, mnxdom::json_pointer> noteJsonByKey{ &arena }; ///< keyed by packedNoteId
+    std::pmr::unordered_map<EntryNumber, EntryTarget> entryTargetByNumber{ &arena };
 
     struct DeferredJumpTie {
-        std::string startNoteId;
+        std::uint64_t startNoteKey{}; ///< packedNoteId of the start note
+        std::uint64_t endNoteKey{}; ///< packedNoteId of the end note
         std::string endNoteId;
         std::optional<mnxdom::SlurTieSide> side;
     };
 
-    std::vector<DeferredJumpTie> deferredJumpTies;
-    std::unordered_set<std::string> deferredJumpTieKeys;
-    std::vector<musx::util::ArpeggioSpanCandidate> deferredArpeggios;
-    std::unordered_set<std::string> deferredArpeggioKeys;
+    std::pmr::vector<DeferredJumpTie> deferredJumpTies{ &arena };
+    std::pmr::unordered_set<PackedIdKey, PackedIdKeyHash> deferredJumpTieKeys{ &arena }; ///< jumpTieKey of each deferred tie
+    std::pmr::vector<musx::util::ArpeggioSpanCandidate> deferredArpeggios{ &arena };
+    std::pmr::unordered_set<PackedIdKey, PackedIdKeyHash> deferredArpeggioKeys{ &arena }; ///< arpeggioSpanKey of each deferred arpeggio
+    std::pmr::unordered_map<Cmper, MnxDynamicPrototype> dynamicPrototypes{ &arena }; ///< keyed by text expression cmper
+
+    /// The MNX kit component and sound ids of a percussion note type.
+    struct PercussionIds {
+        std::string kitId;
+        std::string soundId;
+    };
+    using PercussionNoteType = decltype(others::PercussionNoteInfo::percNoteType);
+    std::pmr::unordered_map<PercussionNoteType, PercussionIds> percussionIds{ &arena }; ///< keyed by percussion note type
 
     std::optional<std::string> currSplitInstrumentUuid;
     std::vector<StaffCmper> currPartStaves;
-    std::unordered_set<EntryNumber> beamedEntries;
+    utils::DenseIndexSet<EntryNumber, std::pmr::polymorphic_allocator<std::uint64_t>> beamedEntries{ &arena };
     size_t discardedCueFrames{};
+    StaffCompositeCache staffComposites; ///< composites built for this conversion, shared by the part and layout passes
+    EntryFrameCache entryFrames; ///< entry frames of the current part, shared by the beam and sequence passes
 
     struct CurrentMeasureStaff {
         MeasCmper meas{};
@@ -141,68 +209,122 @@ struct MnxMusxMapping
         currSplitInstrumentUuid.reset();
         currPartStaves.clear();
         beamedEntries.clear();
+        entryFrames.clear();
         current.clear();
     }
 
+    /// Moves what worker produced for the part at partIndex into this mapping, as if this mapping had built it.
+    void mergePartFrom(MnxMusxMapping& worker, size_t partIndex);
+
     void setCurrentMeasureStaff(const MusxInstance<others::Measure>& musxMeasure, StaffCmper staffCmper);
+    /// Returns the kit and sound ids of percNoteInfo's note type, building them on the first request.
+    const PercussionIds& percussionIdsFor(const MusxInstance<others::PercussionNoteInfo>& percNoteInfo);
     void logMessage(LogMsg&& msg, MessageSeverity severity = MessageSeverity::Info);
     void logDiscardedHeuristicCueHold();
     void logDiscardedCueLayerFrame(LayerIndex layer);
 };
 
+/// Routes musx log messages through context, so that they carry its current measure and staff.
+musx::util::Logger::LogCallback makeMusxLogCallback(const MnxMusxMappingPtr& context);
+
 std::string mnxPartDisplayName(const MnxMusxMappingPtr& context, const std::string& partId);
 std::string mnxPartDisplayName(const MnxMusxMappingPtr& context, const mnxdom::Part& part);
 std::string mnxPartDisplayList(const MnxMusxMappingPtr& context, const std::vector<std::string>& partIds);
 
+/**
+ * @class MnxIdBuilder
+ * @brief Formats an MNX id into a fixed stack buffer.
+ *
+ * The id is then turned into a std::string once, which is short enough to stay in the small-string buffer,
+ * instead of through a chain of std::to_string and operator+ temporaries.
+ */
+class MnxIdBuilder
+{
+public:
+    MnxIdBuilder& operator<<(std::string_view text)
+    {
+        if (text.size() > m_buffer.size() - m_length) {
+            throw std::length_error("MNX id is too long for MnxIdBuilder.");
+        }
+        std::copy(text.begin(), text.end(), m_buffer.begin() + m_length);
+        m_length += text.size();
+        return *this;
+    }
+
+    template <typename Integer, std::enable_if_t<std::is_integral_v<Integer>, int> = 0>
+    MnxIdBuilder& operator<<(Integer value)
+    {
+        const auto [end, error] = std::to_chars(m_buffer.data() + m_length, m_buffer.data() + m_buffer.size(), value);
+        if (error != std::errc{}) {
+            throw std::length_error("MNX id is too long for MnxIdBuilder.");
+        }
+        m_length = static_cast<std::size_t>(end - m_buffer.data());
+        return *this;
+    }
+
+    std::string_view view() const { return { m_buffer.data(), m_length }; }
+    std::string str() const { return std::string(view()); }
+
+private:
+    std::array<char, 48> m_buffer{};
+    std::size_t m_length{};
+};
+
 inline std::string calcSystemLayoutId(Cmper partId, Cmper systemId)
 {
+    MnxIdBuilder result;
+    result << "S" << partId;
     if (systemId == BASE_SYSTEM_ID) {
-        return "S" + std::to_string(partId) + "-ScrVw";
+        result << "-ScrVw";
+    } else {
+        result << "-Sys" << systemId;
     }
-    return "S" + std::to_string(partId) + "-Sys" + std::to_string(systemId);
+    return result.str();
 }
 
 inline std::string calcEventId(EntryNumber entryNum)
 {
-    return "ev" + std::to_string(entryNum);
+    return (MnxIdBuilder() << "ev" << entryNum).str();
 }
 
 inline std::string calcNoteId(const NoteInfoPtr& noteInfo)
 {
-    return calcEventId(noteInfo.getEntryInfo()->getEntry()->getEntryNumber()) + "n" + std::to_string(noteInfo->getNoteId());
+    return (MnxIdBuilder() << "ev" << noteInfo.getEntryInfo()->getEntry()->getEntryNumber() << "n" << noteInfo->getNoteId()).str();
 }
 
 inline std::string calcVoice(int partStaffNum, LayerIndex idx, int voice)
 {
-    std::string result = "s" + std::to_string(partStaffNum) + "layer" + std::to_string(idx + 1);
+    MnxIdBuilder result;
+    result << "s" << partStaffNum << "layer" << (idx + 1);
     if (voice > 1) {
-        result += "v" + std::to_string(voice);
+        result << "v" << voice;
     }
-    return result;
+    return result.str();
 }
 
 inline std::string calcGlobalMeasureId(Cmper cmperValue)
 {
-    return "m" + std::to_string(cmperValue);
+    return (MnxIdBuilder() << "m" << cmperValue).str();
 }
 
 inline std::string calcLyricLineId(const std::string& type, Cmper textNumber)
 {
-    return type.substr(0, 1) + std::to_string(textNumber);
+    return (MnxIdBuilder() << std::string_view(type).substr(0, 1) << textNumber).str();
 }
 
 inline std::string calcPercussionKitId(const MusxInstance<others::PercussionNoteInfo>& percNoteInfo)
 {
-    return "ke" + std::to_string(percNoteInfo->percNoteType);
+    return (MnxIdBuilder() << "ke" << percNoteInfo->percNoteType).str();
 }
 
 inline std::string calcPercussionSoundId(const MusxInstance<others::PercussionNoteInfo>& percNoteInfo)
 {
-    std::string result = "pn" + std::to_string(percNoteInfo->getBaseNoteTypeId());
+    MnxIdBuilder result;
+    result << "pn" << percNoteInfo->getBaseNoteTypeId();
     if (auto orderId = percNoteInfo->getNoteTypeOrderId()) {
-        result += "o" + std::to_string(orderId + 1);
+        result << "o" << (orderId + 1);
     }
-    return result;
+    return result.str();
 }
 
 void createLayouts(const MnxMusxMappingPtr& context);
@@ -216,6 +338,7 @@ void finalizeJumpTies(const MnxMusxMappingPtr& context);
 
 void exportJson(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext);
 void exportJson(std::ostream& output, const CommandInputData& inputData, const DenigmaContext& denigmaContext);
+void exportJson(std::ostream& output, const DocumentPtr& document, const DenigmaContext& denigmaContext);
 void exportMnx(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext);
 
 template <typename ToEnum, typename FromEnum>
@@ -301,7 +301,7 @@ void appendArpeggioCandidate(const MnxMusxMappingPtr& context, mnxdom::part::Mea
         return;
     }
 
-    if (context->deferredArpeggioKeys.emplace(candidate.key()).second) {
+    if (context->deferredArpeggioKeys.emplace(arpeggioSpanKey(candidate)).second) {
         context->deferredArpeggios.push_back(candidate);
     }
 }
@@ -367,11 +367,11 @@ static bool appendDeferredArpeggioToPart(const MnxMusxMappingPtr& context,
             continue;
         }
         auto measures = part.measures();
-        const auto measureIndex = static_cast<size_t>(candidate.sourceEntry.getMeasure() - 1);
-        if (measureIndex >= measures.size()) {
+        const auto measureIndex = context->excerpt.measureIndex(candidate.sourceEntry.getMeasure());
+        if (!measureIndex || *measureIndex >= measures.size()) {
             return false;
         }
-        auto mnxMeasure = measures.at(measureIndex);
+        auto mnxMeasure = measures.at(*measureIndex);
         appendArpeggioOrNonArpeggio(splitTopNote.value(), splitBottomNote.value(), mnxMeasure, candidate);
         return true;
     }
@@ -23,10 +23,14 @@
 
 #include <filesystem>
 #include <memory>
+#include <sstream>
 #include <vector>
 
 #include "core/denigma.h"
+#include "core/musx_reader.h"
+#include "denigma/prepared_document.h"
 #include "formats/enigmaxml/enigmaxml.h"
+#include "formats/enigmaxml/prepared_document.h"
 #include "mnx.h"
 #include "utils/stringutils.h"
 
@@ -43,13 +47,24 @@ DenigmaContext makeMnxContext(const Options& options, const std::filesystem::pat
         ? defaultSourceName
         : utils::utf8ToPath(options.common.sourceName);
     context.noValidate = !options.common.validate;
+    context.validateConcurrently = options.common.validateConcurrently;
+    context.validateEvery = options.common.validateEvery;
     context.verbose = options.common.verbose;
     context.quiet = options.common.quiet;
+    context.outputJobs = options.common.outputJobs;
+    context.executor = options.common.executor;
+    context.cancellation = options.common.cancellation;
+    context.deadline = options.common.deadline;
+    context.textMetrics = options.common.textMetrics;
+    context.memoryResource = options.common.memoryResource;
     context.indentSpaces = options.indentSpaces;
+    context.mnxEncoding = options.encoding;
     context.cueLayer = options.cueLayer;
     context.mnxSchema = options.schema;
     context.includeTempoTool = options.includeTempoTool;
     context.mnxSplitInstruments = options.splitInstruments;
+    context.measureRange = options.measureRange;
+    context.staffFilter = options.staffFilter;
     return context;
 }
 
@@ -60,23 +75,20 @@ ConversionResult EnigmaXmlToMnxJsonConverter::convert(std::span<const std::byte>
                                                       const Options& options) const
 {
     ConversionResult result;
-    Buffer buffer;
-    buffer.reserve(input.size());
-    for (const std::byte value : input) {
-        buffer.push_back(static_cast<char>(value));
-    }
 
     auto context = makeMnxContext(options, "input.enigmaxml");
     context.logCallback = options.common.logCallback;
     context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common, &output);
     MusxLoggerScope musxLogger(makeMusxLogCallback(context));
 
     try {
-        detail::exportJson(output, CommandInputData{ std::move(buffer), std::nullopt, {} }, context);
+        detail::exportJson(output, CommandInputData::fromBorrowedBytes(input), context);
     } catch (const std::exception& ex) {
         context.logMessage(LogMsg() << "unable to convert Enigma XML to MNX JSON", MessageSeverity::Error);
         context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
     }
+    stats.finish();
     return result;
 }
 
@@ -95,14 +107,18 @@ ConversionResult MusxToMnxJsonConverter::convert(const IRandomAccessReader& inpu
     auto context = makeMnxContext(options, "input.musx");
     context.logCallback = options.common.logCallback;
     context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common, &output);
     MusxLoggerScope musxLogger(makeMusxLogCallback(context));
 
     try {
-        detail::exportJson(output, formats::enigmaxml::detail::extractMusxInputData(input, context), context);
+        auto inputData = formats::enigmaxml::detail::extractMusxInputData(input, context);
+        MusxReaderBufferHandoff xmlHandoff(inputData.primaryBuffer); // nothing reads the XML after the DOM is built
+        detail::exportJson(output, inputData, context);
     } catch (const std::exception& ex) {
         context.logMessage(LogMsg() << "unable to convert MUSX to MNX JSON", MessageSeverity::Error);
         context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
     }
+    stats.finish();
     return result;
 }
 
@@ -113,10 +129,48 @@ ConversionResult MusxToMnxJsonConverter::convert(const IRandomAccessReader& inpu
     return convert(input, output, optionsFromRequest<Options>(request, "MusxToMnxJsonConverter"));
 }
 
+ConversionResult PreparedDocumentToMnxJsonConverter::convert(const PreparedDocument& input,
+                                                             std::ostream& output,
+                                                             const Options& options) const
+{
+    ConversionResult result;
+    auto effectiveOptions = options;
+    if (effectiveOptions.common.sourceName.empty()) {
+        effectiveOptions.common.sourceName = input.impl().sourceName;
+    }
+    auto context = makeMnxContext(effectiveOptions, "input.musx");
+    context.logCallback = options.common.logCallback;
+    context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common, &output);
+    MusxLoggerScope musxLogger(makeMusxLogCallback(context));
+
+    try {
+        detail::exportJson(output, input.impl().document(musx::dom::PartVoicingPolicy::Ignore, context), context);
+    } catch (const std::exception& ex) {
+        context.logMessage(LogMsg() << "unable to convert prepared document to MNX JSON", MessageSeverity::Error);
+        context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
+    return result;
+}
+
+ConversionResult PreparedDocumentToMnxJsonConverter::convert(const PreparedDocument& input,
+                                                             const MultiOutputCallback& outputCallback,
+                                                             const ConversionRequest& request) const
+{
+    std::ostringstream output;
+    auto result = convert(input, output, optionsFromRequest<Options>(request, "PreparedDocumentToMnxJsonConverter"));
+    if (result) {
+        outputCallback({}, std::move(output).str());
+    }
+    return result;
+}
+
 void registerConverters(ConverterRegistry& registry)
 {
     registry.add(std::make_unique<EnigmaXmlToMnxJsonConverter>());
     registry.add(std::make_unique<MusxToMnxJsonConverter>());
+    registry.add(std::make_unique<PreparedDocumentToMnxJsonConverter>());
 }
 
 } // namespace mnx
@@ -233,58 +233,94 @@ std::pair<std::optional<mnxdom::DynamicValue>, std::optional<mnxdom::DynamicValu
     return std::make_pair(dynValue, attackValue);
 }
 
-void appendDynamic(const MnxMusxMappingPtr& context, mnxdom::part::Measure& mnxMeasure, std::optional<int> mnxStaffNumber,
-    const MusxInstance<others::MeasureExprAssign>& asgn, const classify::ExpressionClassification& classification, VerticalPlacement placement)
+/// Derives the MNX content of a dynamic expression from its classification alone.
+MnxDynamicPrototype calcDynamicPrototype(const classify::ExpressionClassification& classification)
 {
-    if (asgn->layer > 0 && context->current.cueDiscardPlan.discardLayers.contains(asgn->layer - 1)) {
-        return;
+    MnxDynamicPrototype result;
+    for (const auto& run : classification.runs) {
+        result.sourceText.push_back(run.chunk.text);
     }
-
     auto dynamicClass = projectPrimaryDynamicForMnx(classification);
     if (!dynamicClass) {
-        return;
+        return result;
     }
 
-    bool isAccent{};
     bool copyGlyphs{};
-    const auto [dynValue, attackValue] = calcDynamicType(dynamicClass->dynamic, copyGlyphs, isAccent);
+    const auto [dynValue, attackValue] = calcDynamicType(dynamicClass->dynamic, copyGlyphs, result.isAccent);
     if (!dynValue && (dynamicClass->change == classify::dynamics::Change::Absolute || !dynamicClass->containsText())) {
+        return result;
+    }
+
+    result.hasDynamic = true;
+    result.value = dynValue;
+    result.attackValue = attackValue;
+    using DynRelType = classify::dynamics::Change;
+    if (dynamicClass->change != DynRelType::Absolute) {
+        result.relativeValue = dynamicClass->change == DynRelType::RelativeIncrease
+            ? mnxdom::DynamicRelativeValue::Louder
+            : mnxdom::DynamicRelativeValue::Softer;
+    }
+    result.prefixText = std::move(dynamicClass->prefixText);
+    result.suffixText = std::move(dynamicClass->suffixText);
+    result.glyphs = std::move(dynamicClass->glyphs);
+    if (copyGlyphs && !result.glyphs.empty()) {
+        result.glyphs = classify::dynamicCanonicalLetterGlyphs(dynamicClass->dynamic);
+    }
+    return result;
+}
+
+/// Returns the prototype of asgn's text expression, deriving it again only if the classified text differs, as text
+/// with inserts can.
+const MnxDynamicPrototype& cachedDynamicPrototype(const MnxMusxMappingPtr& context,
+    const MusxInstance<others::MeasureExprAssign>& asgn, const classify::ExpressionClassification& classification)
+{
+    auto [it, inserted] = context->dynamicPrototypes.try_emplace(asgn->textExprId);
+    const auto& sourceText = it->second.sourceText;
+    const bool sameSource = !inserted && sourceText.size() == classification.runs.size()
+        && std::equal(sourceText.begin(), sourceText.end(), classification.runs.begin(),
+            [](const std::string& text, const classify::expression::RunClassification& run) { return text == run.chunk.text; });
+    if (!sameSource) {
+        it->second = calcDynamicPrototype(classification);
+    }
+    return it->second;
+}
+
+void appendDynamic(const MnxMusxMappingPtr& context, mnxdom::part::Measure& mnxMeasure, std::optional<int> mnxStaffNumber,
+    const MusxInstance<others::MeasureExprAssign>& asgn, const classify::ExpressionClassification& classification, VerticalPlacement placement)
+{
+    if (asgn->layer > 0 && context->current.cueDiscardPlan.discardsLayer(asgn->layer - 1)) {
         return;
     }
 
-    std::vector<std::string> glyphs = std::move(dynamicClass->glyphs);
-    if (copyGlyphs && !glyphs.empty()) {
-        glyphs = classify::dynamicCanonicalLetterGlyphs(dynamicClass->dynamic);
+    const auto& prototype = cachedDynamicPrototype(context, asgn, classification);
+    if (!prototype.hasDynamic) {
+        return;
     }
 
     auto mnxDynamic = [&]() -> mnxdom::part::DynamicGroupBase {
-        using DynRelType = classify::dynamics::Change;
-        if (dynamicClass->change != DynRelType::Absolute) {
-            auto relValue = dynamicClass->change == DynRelType::RelativeIncrease
-                ? mnxdom::DynamicRelativeValue::Louder
-                : mnxdom::DynamicRelativeValue::Softer;
-            auto dyn = mnxMeasure.ensure_dynamics().appendRelative(relValue, mnxFractionFromEdu(asgn->eduPosition));
-            if (dynValue) {
-                dyn.set_value(dynValue.value());
+        if (prototype.relativeValue) {
+            auto dyn = mnxMeasure.ensure_dynamics().appendRelative(prototype.relativeValue.value(), mnxFractionFromEdu(asgn->eduPosition));
+            if (prototype.value) {
+                dyn.set_value(prototype.value.value());
             }
             return dyn;
-        } else if (isAccent) {
-            return mnxMeasure.ensure_dynamics().appendAccent(dynValue.value(), mnxFractionFromEdu(asgn->eduPosition));
+        } else if (prototype.isAccent) {
+            return mnxMeasure.ensure_dynamics().appendAccent(prototype.value.value(), mnxFractionFromEdu(asgn->eduPosition));
         } else {
-            return mnxMeasure.ensure_dynamics().appendImmediate(dynValue.value(), mnxFractionFromEdu(asgn->eduPosition));
+            return mnxMeasure.ensure_dynamics().appendImmediate(prototype.value.value(), mnxFractionFromEdu(asgn->eduPosition));
         }
     }();
-    if (attackValue) {
-        mnxDynamic.set_attackValue(attackValue.value());
+    if (prototype.attackValue) {
+        mnxDynamic.set_attackValue(prototype.attackValue.value());
     }
-    if (!dynamicClass->prefixText.empty()) {
-        mnxDynamic.set_prefix(dynamicClass->prefixText);
+    if (!prototype.prefixText.empty()) {
+        mnxDynamic.set_prefix(prototype.prefixText);
     }
-    if (!dynamicClass->suffixText.empty()) {
-        mnxDynamic.set_suffix(dynamicClass->suffixText);
+    if (!prototype.suffixText.empty()) {
+        mnxDynamic.set_suffix(prototype.suffixText);
     }
-    if (!glyphs.empty()) {
-        mnxDynamic.ensure_glyphs().assign(glyphs);
+    if (!prototype.glyphs.empty()) {
+        mnxDynamic.ensure_glyphs().assign(prototype.glyphs);
     }
     const auto entryInfo = asgn->calcAssociatedEntry();
     int entryVoice = 1;
@@ -299,7 +335,7 @@ void appendDynamic(const MnxMusxMappingPtr& context, mnxdom::part::Measure& mnxM
         } else if (entryInfo.calcHasGraceNote()) {
             mnxDynamic.position().set_graceIndex(0);
         }
-    } else if (context->current.gfhold) {
+    } else if (context->current.meas) {
         if (const auto measure = context->document->getOthers()->get<others::Measure>(asgn->getRequestedPartId(), context->current.meas)) {
             if (musx::util::Fraction::fromEdu(asgn->eduPosition) >= measure->calcDuration(context->current.staff)) {
                 // if we are at the end of a measure, explicitly require main position to ignore any grace
@@ -360,8 +396,7 @@ void processExpressions(const MnxMusxMappingPtr& context, const MusxInstance<oth
     mnxdom::part::Measure& mnxMeasure, std::optional<int> mnxStaffNumber)
 {
     if (musxMeasure->hasExpression) {
-        auto exprAssigns = context->document->getOthers()->getArray<others::MeasureExprAssign>(musxMeasure->getRequestedPartId(), musxMeasure->getCmper());
-        for (const auto& asgn : exprAssigns) {
+        for (const auto& asgn : context->measureIndex->get(musxMeasure->getCmper()).expressions) {
             if (asgn->hidden || asgn->staffAssign != context->current.staff) {
                 continue;
             }
@@ -91,11 +91,13 @@ static void assignBarline(
     }
 }
 
-static void createEnding(mnxdom::global::Measure& mnxMeasure, const MusxInstance<others::Measure>& musxMeasure)
+static void createEnding(const MnxMusxMappingPtr& context, mnxdom::global::Measure& mnxMeasure, const MusxInstance<others::Measure>& musxMeasure)
 {
     if (musxMeasure->hasEnding) {
         if (auto musxEnding = musxMeasure->getDocument()->getOthers()->get<others::RepeatEndingStart>(SCORE_PARTID, musxMeasure->getCmper())) {
-            auto mnxEnding = mnxMeasure.ensure_ending(musxEnding->calcEndingLength());
+            // an ending that runs past an excerpt stops at its last measure
+            const int remainingMeasures = context->excerpt.lastMeasure() - musxMeasure->getCmper() + 1;
+            auto mnxEnding = mnxMeasure.ensure_ending((std::min)(int(musxEnding->calcEndingLength()), remainingMeasures));
             mnxEnding.set_open(musxEnding->calcIsOpen());
             if (auto musxNumbers = musxMeasure->getDocument()->getOthers()->get<others::RepeatPassList>(SCORE_PARTID, musxMeasure->getCmper())) {
                 for (int value : musxNumbers->values) {
@@ -126,17 +128,14 @@ enum class JumpClassificationSide
 
 static std::optional<MusxInstance<others::TextRepeatAssign>> searchForJump(
     classify::jump::Jump jumpType,
-    const MusxInstance<others::Measure>& musxMeasure,
+    const MeasureIndex::MeasureAssignments& assignments,
     JumpClassificationSide side)
 {
-    if (musxMeasure->hasTextRepeat) {
-        auto textRepeatAssigns = musxMeasure->getDocument()->getOthers()->getArray<others::TextRepeatAssign>(SCORE_PARTID, musxMeasure->getCmper());
-        for (const auto& next : textRepeatAssigns) {
-            const auto classification = classify::classifyJump(next);
-            const auto candidate = (side == JumpClassificationSide::Visual) ? classification.visual : classification.playback;
-            if (candidate == jumpType) {
-                return next;
-            }
+    for (const auto& next : assignments.textRepeats) {
+        const auto classification = classify::classifyJump(next);
+        const auto candidate = (side == JumpClassificationSide::Visual) ? classification.visual : classification.playback;
+        if (candidate == jumpType) {
+            return next;
         }
     }
     return std::nullopt;
@@ -144,9 +143,10 @@ static std::optional<MusxInstance<others::TextRepeatAssign>> searchForJump(
 
 static void createFine(
     mnxdom::global::Measure& mnxMeasure,
-    const MusxInstance<others::Measure>& musxMeasure)
+    const MusxInstance<others::Measure>& musxMeasure,
+    const MeasureIndex::MeasureAssignments& assignments)
 {
-    if (auto repeatAssign = searchForJump(classify::jump::Jump::Fine, musxMeasure, JumpClassificationSide::Playback)) {
+    if (auto repeatAssign = searchForJump(classify::jump::Jump::Fine, assignments, JumpClassificationSide::Playback)) {
         auto location = calcJumpLocation(repeatAssign.value(), musxMeasure);
         mnxMeasure.ensure_fine(mnxFractionFromFraction(location));
     }
@@ -154,7 +154,8 @@ static void createFine(
 
 static void createJump(
     mnxdom::global::Measure& mnxMeasure,
-    const MusxInstance<others::Measure>& musxMeasure)
+    const MusxInstance<others::Measure>& musxMeasure,
+    const MeasureIndex::MeasureAssignments& assignments)
 {
     constexpr auto jumpMapping = std::to_array<std::pair<classify::jump::Jump, mnxdom::JumpType>>(
     {
@@ -164,7 +165,7 @@ static void createJump(
     });
 
     for (const auto& mapping : jumpMapping) {
-        if (auto repeatAssign = searchForJump(mapping.first, musxMeasure, JumpClassificationSide::Playback)) {
+        if (auto repeatAssign = searchForJump(mapping.first, assignments, JumpClassificationSide::Playback)) {
             auto location = calcJumpLocation(repeatAssign.value(), musxMeasure);
             mnxMeasure.ensure_jump(mapping.second, mnxFractionFromFraction(location));
         }            
@@ -183,10 +184,11 @@ static void assignKey(
     }
 }
 
-static void assignDisplayNumber(mnxdom::global::Measure& mnxMeasure, const MusxInstance<others::Measure>& musxMeasure)
+static void assignDisplayNumber(mnxdom::global::Measure& mnxMeasure, const MusxInstance<others::Measure>& musxMeasure,
+    bool alwaysNumber)
 {
     if (const auto displayNumber = musxMeasure->calcDisplayNumber()) {
-        if (displayNumber.value() != musxMeasure->getCmper()) {
+        if (alwaysNumber || displayNumber.value() != musxMeasure->getCmper()) {
             mnxMeasure.set_number(displayNumber.value());
         }
     }
@@ -205,9 +207,10 @@ static void assignRepeats(mnxdom::global::Measure& mnxMeasure, const MusxInstanc
 
 static void createSegno(
     mnxdom::global::Measure& mnxMeasure,
-    const MusxInstance<others::Measure>& musxMeasure)
+    const MusxInstance<others::Measure>& musxMeasure,
+    const MeasureIndex::MeasureAssignments& assignments)
 {
-    if (auto repeatAssign = searchForJump(classify::jump::Jump::Segno, musxMeasure, JumpClassificationSide::Visual)) {
+    if (auto repeatAssign = searchForJump(classify::jump::Jump::Segno, assignments, JumpClassificationSide::Visual)) {
         auto location = calcJumpLocation(repeatAssign.value(), musxMeasure);
         auto segno = mnxMeasure.ensure_segno(mnxFractionFromFraction(location));
         if (auto repeatText = musxMeasure->getDocument()->getOthers()->get<others::TextRepeatText>(SCORE_PARTID, repeatAssign.value()->textRepeatId)) {
@@ -220,7 +223,8 @@ static void createSegno(
     }
 }
 
-static void createTempos(const MnxMusxMappingPtr& context, mnxdom::global::Measure& mnxMeasure, const MusxInstance<others::Measure>& musxMeasure)
+static void createTempos(const MnxMusxMappingPtr& context, mnxdom::global::Measure& mnxMeasure, const MusxInstance<others::Measure>& musxMeasure,
+    const MeasureIndex::MeasureAssignments& assignments)
 {
     auto createTempo = [&mnxMeasure](int bpm, Edu noteValue, Edu eduPosition) {
         auto mnxTempos = mnxMeasure.ensure_tempos();
@@ -233,8 +237,7 @@ static void createTempos(const MnxMusxMappingPtr& context, mnxdom::global::Measu
     std::map<Edu, classify::expression::TempoInfo> temposAtPositions;
     if (musxMeasure->hasExpression) {
         // Search in order of decreasing precedence. Using emplace keeps the first tempo at a beat location.
-        const auto expAssigns = musxMeasure->getDocument()->getOthers()->getArray<others::MeasureExprAssign>(SCORE_PARTID, musxMeasure->getCmper());
-        const auto expAssignClassifications = classify::classifyExpressionAssignments(expAssigns);
+        const auto expAssignClassifications = classify::classifyExpressionAssignments(assignments.expressions);
         const auto addExpressionTempos = [&](bool textExpressions) {
             for (const auto& expAssignClassification : expAssignClassifications) {
                 const auto& expAssign = expAssignClassification.assignment;
@@ -259,8 +262,7 @@ static void createTempos(const MnxMusxMappingPtr& context, mnxdom::global::Measu
     }
     std::optional<NoteType> tempoUnit;
     if (context->denigmaContext->includeTempoTool) {
-        const auto tempoChanges = musxMeasure->getDocument()->getOthers()->getArray<others::TempoChange>(SCORE_PARTID, musxMeasure->getCmper());
-        for (const auto& tempoChange : tempoChanges) {
+        for (const auto& tempoChange : assignments.tempoChanges) {
             if (!tempoChange->isRelative) {
                 if (!tempoUnit) {
                     auto [count, unit] = musxMeasure->createTimeSignature()->calcSimplified();
@@ -301,12 +303,9 @@ static void assignTimeSignature(
     }
 }
 
-static void createBarlineFermata(const MnxMusxMappingPtr& context, mnxdom::global::Measure& mnxMeasure, const MusxInstance<others::Measure>& musxMeasure)
+static void createBarlineFermata(mnxdom::global::Measure& mnxMeasure, const MeasureIndex::MeasureAssignments& assignments)
 {
-    const auto& musxDocument = context->document;
-    const auto forPartId = musxMeasure->getRequestedPartId();
-    const auto exprAssigns = musxDocument->getOthers()->getArray<others::MeasureExprAssign>(forPartId, musxMeasure->getCmper());
-    for (const auto& exprAssign : exprAssigns) {
+    for (const auto& exprAssign : assignments.expressions) {
         if (!exprAssign->hidden && exprAssign->calcIsPartOfStaffListAssignment()) {
             if (const auto textExp = exprAssign->getTextExpression(); textExp && textExp->horzMeasExprAlign == others::HorizontalMeasExprAlign::RightBarline) {
                 const auto classification = classify::classifyExpression(textExp);
@@ -328,23 +327,27 @@ static void createGlobalMeasures(const MnxMusxMappingPtr& context)
     const auto& musxDocument = context->document;
 
     // Retrieve the linked parts in order.
-    const auto musxMeasures = musxDocument->getOthers()->getArray<others::Measure>(SCORE_PARTID);
+    auto musxMeasures = musxDocument->getOthers()->getArray<others::Measure>(SCORE_PARTID);
+    context->excerpt.restrict(musxMeasures);
+    // the measures of an excerpt are numbered from 1 by position, so each states its own number
+    const bool alwaysNumber = context->excerpt.startsMidScore();
     const auto musxBarlineOptions = context->finaleOptions.barlineOptions;
     std::optional<int> prevKeyFifths;
     MusxInstance<TimeSignature> prevTimeSig;
     for (const auto& musxMeasure : musxMeasures) {
+        const auto& assignments = context->measureIndex->get(musxMeasure->getCmper());
         auto mnxMeasure = mnxDocument->global().measures().append();
         mnxMeasure.set_id(calcGlobalMeasureId(musxMeasure->getCmper()));
-        assignBarline(context, mnxMeasure, musxMeasure, musxBarlineOptions, musxMeasure->getCmper() == musxMeasures.size());
-        createEnding(mnxMeasure, musxMeasure);
-        createBarlineFermata(context, mnxMeasure, musxMeasure);
-        createFine(mnxMeasure, musxMeasure);
-        createJump(mnxMeasure, musxMeasure);
+        assignBarline(context, mnxMeasure, musxMeasure, musxBarlineOptions, musxMeasure->getCmper() == context->excerpt.measureCount());
+        createEnding(context, mnxMeasure, musxMeasure);
+        createBarlineFermata(mnxMeasure, assignments);
+        createFine(mnxMeasure, musxMeasure, assignments);
+        createJump(mnxMeasure, musxMeasure, assignments);
         assignKey(mnxMeasure, musxMeasure, prevKeyFifths);
-        assignDisplayNumber(mnxMeasure, musxMeasure);
+        assignDisplayNumber(mnxMeasure, musxMeasure, alwaysNumber);
         assignRepeats(mnxMeasure, musxMeasure);
-        createSegno(mnxMeasure, musxMeasure);
-        createTempos(context, mnxMeasure, musxMeasure);
+        createSegno(mnxMeasure, musxMeasure, assignments);
+        createTempos(context, mnxMeasure, musxMeasure, assignments);
         assignTimeSignature(context, mnxMeasure, musxMeasure, prevTimeSig);
     }
 }
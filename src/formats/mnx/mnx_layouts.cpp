@@ -25,6 +25,7 @@
 #include <unordered_map>
 
 #include "mnx.h"
+#include "core/part_layout.h"
 
 namespace denigma {
 namespace formats {
@@ -41,7 +42,7 @@ static void buildMnxStaff(mnxdom::layout::Staff&& mnxStaff,
     if (it == context->inst2Part.end()) {
         throw std::logic_error("Staff id " + std::to_string(staffSlot->staffId) + " was not assigned to any MNX part.");
     }
-    auto staff = others::StaffComposite::createCurrent(context->document, staffSlot->getRequestedPartId(), staffSlot->staffId, meas->getCmper(), 0);
+    auto staff = context->staffComposites.get(context->document, staffSlot->getRequestedPartId(), staffSlot->staffId, meas->getCmper(), 0);
     if (!staff) {
         throw std::logic_error("Staff id " + std::to_string(staffSlot->staffId) + " does not have a Staff instance.");
     }
@@ -125,7 +126,6 @@ static void buildOrderedContent(
     size_t toIndex = std::numeric_limits<size_t>::max(),
     size_t groupIndex = 0)
 {
-    json retval = json::array();
     size_t index = fromIndex;
     while (index < systemStaves.size()) {
         // Skip groups that have already ended
@@ -203,11 +203,12 @@ void createLayouts(const MnxMusxMappingPtr& context)
     // Iterate over each linked part and generate layouts.
     for (const auto& linkedPart : context->musxParts) {
         Cmper baseSystemIuList = linkedPart->calcScrollViewCmper();
-        auto staffSystems = context->document->getOthers()->getArray<others::StaffSystem>(linkedPart->getCmper());
+        const auto layout = PartLayout::forPart(context->document, linkedPart->getCmper());
+        const auto& staffSystems = layout->getSystems();
         const SystemCmper minSystem = BASE_SYSTEM_ID;
         const SystemCmper maxSystem = SystemCmper(staffSystems.size());
         for (SystemCmper sysId = minSystem; sysId <= maxSystem; sysId++) { //NOTE: unusual loop limits are *on purpose*
-            Cmper systemIuList = sysId ? staffSystems[sysId - 1]->getCmper() : baseSystemIuList;
+            Cmper systemIuList = sysId ? staffSystems[sysId - 1].id : baseSystemIuList;
             if (sysId != BASE_SYSTEM_ID && systemIuList == baseSystemIuList) {
                 continue;
             }
@@ -220,7 +221,7 @@ void createLayouts(const MnxMusxMappingPtr& context)
             // Retrieve staff groups and staves in scroll view order.
             const auto systemStaves = context->document->getOthers()->getArray<others::StaffUsed>(
                 linkedPart->getCmper(), systemIuList);
-            const MeasCmper forMeas = sysId ? staffSystems[sysId - 1]->startMeas : 1;
+            const MeasCmper forMeas = sysId ? staffSystems[sysId - 1].startMeas : 1;
             std::vector<details::StaffGroupInfo> groups = details::StaffGroupInfo::getGroupsAtMeasure(forMeas, linkedPart->getCmper(), systemStaves);
             sortGroups(groups);
             // Create a sequential content array.
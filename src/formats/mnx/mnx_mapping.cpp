@@ -75,13 +75,13 @@ int mnxStaffPosition(const MusxInstance<others::Staff>& staff, int musxStaffPosi
     return musxStaffPosition - staff->calcMiddleStaffPosition();
 }
 
-mnxdom::LyricLineType mnxLineTypeFromLyric(const MusxInstance<LyricsSyllableInfo>& syl)
+mnxdom::LyricLineType mnxLineTypeFromLyric(const IndexedLyricSyllable& syl)
 {
-    if (syl->hasHyphenBefore && syl->hasHyphenAfter) {
+    if (syl.hyphenBefore && syl.hyphenAfter) {
         return mnxdom::LyricLineType::Middle;
-    } else if (syl->hasHyphenBefore && !syl->hasHyphenAfter) {
+    } else if (syl.hyphenBefore && !syl.hyphenAfter) {
         return mnxdom::LyricLineType::End;
-    } else if (!syl->hasHyphenBefore && syl->hasHyphenAfter) {
+    } else if (!syl.hyphenBefore && syl.hyphenAfter) {
         return mnxdom::LyricLineType::Start;
     }
     return mnxdom::LyricLineType::Whole;
@@ -25,6 +25,7 @@
 #include <optional>
 
 #include "core/denigma.h"
+#include "core/lyric_index.h"
 #include "musx/musx.h"
 #include "mnxdom.h"
 
@@ -42,7 +43,7 @@ struct MnxMusxMapping;
 
 mnxdom::NoteValue::Required mnxNoteValueFromEdu(Edu duration);
 mnxdom::NoteValueQuantity::Required mnxNoteValueQuantityFromFraction(const std::shared_ptr<MnxMusxMapping>& context, musx::util::Fraction duration);
-mnxdom::LyricLineType mnxLineTypeFromLyric(const MusxInstance<LyricsSyllableInfo>& syl);
+mnxdom::LyricLineType mnxLineTypeFromLyric(const IndexedLyricSyllable& syl);
 
 musx::util::Fraction fractionFromMnxFraction(const mnxdom::FractionValue& mnxFraction);
 mnxdom::FractionValue mnxFractionFromFraction(const musx::util::Fraction& fraction);
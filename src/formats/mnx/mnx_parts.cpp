@@ -20,9 +20,11 @@
  * THE SOFTWARE.
  */
 #include <cmath>
+#include <cstddef>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -30,6 +32,7 @@
 #include "mnx_expressions.h"
 #include "mnx_smartshapes.h"
 
+#include "core/parallel.h"
 #include "denigma/classify/clefs.h"
 #include "denigma/classify/dynamics.h"
 #include "utils/stringutils.h"
@@ -58,7 +61,7 @@ static void createBeams(
                 for (auto next = firstInBeam; next; next = next.getNextInBeamGroupAcrossBars(EntryInfoPtr::BeamIterationMode::Interpreted)) {
                     const auto entry = next->getEntry();
                     const EntryNumber entryNumber = entry->getEntryNumber();
-                    context->beamedEntries.emplace(entryNumber);
+                    context->beamedEntries.insert(entryNumber);
                     beam.events().push_back(calcEventId(entryNumber));
                     if (unsigned lowestBeamStart = next.calcLowestBeamStart(/*considerBeamOverBarlines*/true)) {
                         unsigned nextBeamNumber = beamNumber + 1;
@@ -101,12 +104,16 @@ static void createBeams(
                 }
                 if (auto sourceEntry = entryInfo.findHiddenSourceForBeamOverBarline()) {
                     const auto sourceMeasureId = static_cast<size_t>(sourceEntry.getMeasure());
-                    ASSERT_IF(sourceMeasureId >= mnxMeasures.size() || sourceMeasureId == 0) {
+                    ASSERT_IF(sourceMeasureId >= size_t(context->excerpt.measureCount()) || sourceMeasureId == 0) {
                         throw std::logic_error("Source entry's measure " + std::to_string(sourceMeasureId) + " is not a valid measure.");
                     }
-                    mnxMeasure = mnxMeasures.at(sourceMeasureId - 1);
+                    const auto sourceMeasureIndex = context->excerpt.measureIndex(sourceEntry.getMeasure());
+                    if (!sourceMeasureIndex) {
+                        return true; // the beam belongs to a measure before the excerpt
+                    }
+                    mnxMeasure = mnxMeasures.at(*sourceMeasureIndex);
                 } else {
-                    mnxMeasure = mnxMeasures.at(entryInfo.getMeasure() - 1);
+                    mnxMeasure = mnxMeasures.at(entryInfo.getMeasure() - context->excerpt.firstMeasure());
                 }
                 processBeam(mnxMeasure.ensure_beams(), 1, entryInfo, processBeam);
             }
@@ -116,7 +123,7 @@ static void createBeams(
             if (context->current.cueDiscardPlan.skipsLayer(layer)) {
                 continue;
             }
-            if (auto entryFrame = context->current.gfhold->createEntryFrame(layer)) {
+            if (auto entryFrame = context->entryFrames.get(*context->current.gfhold, layer)) {
                 entryFrame->iterateEntries(processEntry);
             }
         }
@@ -185,7 +192,7 @@ static void createClefs(
         if (clefIndex == prevClefIndex) {
             return;
         }
-        auto musxStaff = musx::dom::others::StaffComposite::createCurrent(
+        auto musxStaff = context->staffComposites.get(
             musxDocument, musxMeasure->getRequestedPartId(), staffCmper, musxMeasure->getCmper(), location.calcEduDuration());
         if (!musxStaff) {
             context->logMessage(LogMsg() << mnxPartDisplayName(context, mnxPart)
@@ -197,7 +204,7 @@ static void createClefs(
         }
     };
 
-    auto staff = others::StaffComposite::createCurrent(musxDocument, musxMeasure->getRequestedPartId(), staffCmper, musxMeasure->getCmper(), 0);
+    auto staff = context->staffComposites.get(musxDocument, musxMeasure->getRequestedPartId(), staffCmper, musxMeasure->getCmper(), 0);
     if (!staff) {
         context->logMessage(LogMsg() << mnxPartDisplayName(context, mnxPart)
             << " has no staff information for staff " << staffCmper, MessageSeverity::Warning);
@@ -236,11 +243,11 @@ static bool createFirstClefForInactiveInstrument(
         const auto& instInfo = context->document->getInstrumentForStaff(staffCmper);
         const auto identity = instInfo.getInstrumentIdentityAt(MusicPoint(musxMeasure->getCmper(), musx::util::Fraction{}));
         if (identity.instUuid != context->currSplitInstrumentUuid.value()) {
-            if (musxMeasure->getCmper() == 1) {
+            if (musxMeasure->getCmper() == context->excerpt.firstMeasure()) {
                 const auto splitIdentity = InstrumentInfo::InstrumentIdentity{ context->currSplitInstrumentUuid.value() };
                 if (const auto splitChange = findChangeForIdentity(instInfo, splitIdentity)) {
                     const auto& splitPoint = splitChange->first;
-                    const auto musxStaff = others::StaffComposite::createCurrent(
+                    const auto musxStaff = context->staffComposites.get(
                         musxMeasure->getDocument(),
                         musxMeasure->getRequestedPartId(),
                         staffCmper,
@@ -276,6 +283,7 @@ static void createMeasures(const MnxMusxMappingPtr& context, mnxdom::Part& part)
 
     // Retrieve the linked parts in order.
     auto musxMeasures = musxDocument->getOthers()->getArray<others::Measure>(SCORE_PARTID);
+    context->excerpt.restrict(musxMeasures);
     auto mnxMeasures = part.create_measures();
     const auto it = context->part2Inst.find(part.id_or(""));
     if (it == context->part2Inst.end() || it->second.empty()) {
@@ -293,6 +301,7 @@ static void createMeasures(const MnxMusxMappingPtr& context, mnxdom::Part& part)
     }
     size_t measureIndex = 0;
     for (const auto& musxMeasure : musxMeasures) {
+        context->denigmaContext->checkCancelled();
         auto mnxMeasure = mnxMeasures.at(measureIndex++);
         if (const auto partId = part.id()) {
             mnxMeasure.set_id(partId.value() + "." + calcGlobalMeasureId(musxMeasure->getCmper()));
@@ -303,8 +312,8 @@ static void createMeasures(const MnxMusxMappingPtr& context, mnxdom::Part& part)
             if (createFirstClefForInactiveInstrument(context, mnxMeasure, staffNumber, musxMeasure, staffCmper, prevClefs[x])) {
                 continue;
             }
-            if (!context->currSplitInstrumentUuid && musxMeasure->getCmper() == 1) {
-                const auto musxStaff = others::StaffComposite::createCurrent(musxDocument, musxMeasure->getRequestedPartId(), staffCmper, 1, 0);
+            if (!context->currSplitInstrumentUuid && musxMeasure->getCmper() == context->excerpt.firstMeasure()) {
+                const auto musxStaff = context->staffComposites.get(musxDocument, musxMeasure->getRequestedPartId(), staffCmper, musxMeasure->getCmper(), 0);
                 prevClefs[x] = createClef(context, mnxMeasure, staffNumber, musxStaff->calcClefIndex(/*forWrittenPitch*/ true), 0, musxStaff);
             }
             context->setCurrentMeasureStaff(musxMeasure, staffCmper);
@@ -334,14 +343,22 @@ static void logNonBarlineInstrumentChanges(const MnxMusxMappingPtr& context, con
     }
 }
 
+/// Returns the staves of instInfo in order, without those an excerpt leaves out.
+static std::vector<StaffCmper> calcIncludedStaves(const MnxMusxMappingPtr& context, const InstrumentInfo& instInfo)
+{
+    auto staves = instInfo.getSequentialStaves();
+    std::erase_if(staves, [&](StaffCmper staffId) { return !context->excerpt.includesStaff(staffId); });
+    return staves;
+}
+
 static void mapPartToInstrumentStaves(const MnxMusxMappingPtr& context, const std::string& id, const InstrumentInfo& instInfo)
 {
     if (instInfo.staves.size() > 1) {
-        for (const auto& [staffId, index] : instInfo.staves) {
-            static_cast<void>(index);
+        const auto staves = calcIncludedStaves(context, instInfo);
+        for (const auto staffId : staves) {
             context->inst2Part.emplace(staffId, id);
         }
-        context->part2Inst.emplace(id, instInfo.getSequentialStaves());
+        context->part2Inst.emplace(id, staves);
     } else {
         const auto staves = instInfo.getSequentialStaves();
         if (!staves.empty()) {
@@ -369,8 +386,8 @@ static void populatePartMetadata(
     if (!abrvName.empty()) {
         part.set_shortName(utils::trimNewLineFromString(abrvName));
     }
-    if (instInfo.staves.size() > 1) {
-        part.set_staves(int(instInfo.staves.size()));
+    if (const auto staffCount = calcIncludedStaves(context, instInfo).size(); staffCount > 1) {
+        part.set_staves(int(staffCount));
     }
     const auto [transpositionDisp, transpositionAlt] = staff->calcTranspositionInterval();
     if (transpositionDisp || transpositionAlt) {
@@ -400,6 +417,9 @@ void createParts(const MnxMusxMappingPtr& context)
             continue;
         }
         const auto& [topStaffId, instInfo] = *instIt;
+        if (calcIncludedStaves(context, instInfo).empty()) {
+            continue;
+        }
 
         std::vector<InstrumentInfo::InstrumentIdentity> identities;
         if (context->denigmaContext->mnxSplitInstruments) {
@@ -424,9 +444,30 @@ void createParts(const MnxMusxMappingPtr& context)
             }
             populatePartMetadata(context, part, id, instInfo, partStaff);
             mapPartToInstrumentStaves(context, id, instInfo);
+        }
+    }
+
+    // Every part exists with its metadata before any measures are built, so the measures of different parts
+    // can be built concurrently, each into a copy of the document, and moved back in part order.
+    const size_t partCount = parts.size();
+    if (resolveJobCount(*context->denigmaContext, partCount) <= 1) {
+        for (size_t partIndex = 0; partIndex < partCount; ++partIndex) {
+            auto part = parts[partIndex];
             createMeasures(context, part);
         }
+        return;
     }
+    forEachInOrder<MnxMusxMappingPtr>(partCount, *context->denigmaContext,
+        [&](const DenigmaContext& workerContext, size_t partIndex) {
+            auto worker = std::make_shared<MnxMusxMapping>(workerContext, *context);
+            MusxLoggerScope workerMusxLogger(makeMusxLogCallback(worker));
+            auto part = worker->mnxDocument->parts()[partIndex];
+            createMeasures(worker, part);
+            return worker;
+        },
+        [&](size_t partIndex, MnxMusxMappingPtr&& worker) {
+            context->mergePartFrom(*worker, partIndex);
+        });
 }
 
 } // namespace detail
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "mnx_schema.h"
+#include "core/parallel.h"
+#include "utils/cache_budget.h"
+
+namespace denigma {
+namespace formats {
+namespace mnx {
+namespace detail {
+
+namespace {
+
+/// Items validated by one worker task, so a score of thousands of measures is not scheduled measure by measure.
+constexpr std::size_t ITEMS_PER_TASK = 64;
+
+/// A compiled schema keeps the parsed schema tree and a validator node per sub-schema, several times its text.
+constexpr std::size_t COMPILED_SCHEMA_BYTES_PER_TEXT_BYTE = 8;
+
+/// The compiled schemas, keyed by schema text. A process sees very few distinct schemas (usually one), so entries are
+/// only dropped under the process cache budget; a validation already holding one keeps it alive.
+class CompiledSchemaCache
+{
+public:
+    CompiledSchemaCache()
+        : m_account("mnx-schemas", [this]() { return oldestUse(); }, [this]() { return evictOldest(); })
+    {
+    }
+
+    std::shared_ptr<const CompiledMnxSchema> get(const std::string& schemaText)
+    {
+        std::shared_ptr<const CompiledMnxSchema> result;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (auto it = m_entries.find(schemaText); it != m_entries.end()) {
+                it->second.lastUse = utils::CacheBudget::tick();
+                return it->second.schema;
+            }
+            result = std::make_shared<const CompiledMnxSchema>(schemaText);
+            m_entries.emplace(schemaText, Entry{ result, utils::CacheBudget::tick() });
+            m_account.charge(entryBytes(schemaText));
+        }
+        utils::CacheBudget::instance().enforce();
+        return result;
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<const CompiledMnxSchema> schema;
+        std::uint64_t lastUse{};
+    };
+
+    static std::size_t entryBytes(const std::string& schemaText)
+    { return schemaText.size() * (1 + COMPILED_SCHEMA_BYTES_PER_TEXT_BYTE); }
+
+    std::optional<std::uint64_t> oldestUse() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::optional<std::uint64_t> result;
+        for (const auto& [schemaText, entry] : m_entries) {
+            result = result ? std::min(*result, entry.lastUse) : entry.lastUse;
+        }
+        return result;
+    }
+
+    std::size_t evictOldest()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto oldest = std::min_element(m_entries.begin(), m_entries.end(),
+            [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+        if (oldest == m_entries.end()) {
+            return 0;
+        }
+        const std::size_t bytes = entryBytes(oldest->first);
+        m_entries.erase(oldest);
+        return bytes;
+    }
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    utils::CacheBudget::Account m_account;  ///< last, so it is unregistered before the entries go
+};
+
+/// Collects each violation as "pointer: message", with pointer prefixed by where the instance sits in the document.
+class CollectingErrorHandler : public nlohmann::json_schema::basic_error_handler
+{
+public:
+    explicit CollectingErrorHandler(std::string location = {}) : m_location(std::move(location)) {}
+
+    void error(const nlohmann::json::json_pointer& pointer, const nlohmann::json& instance, const std::string& message) override
+    {
+        nlohmann::json_schema::basic_error_handler::error(pointer, instance, message);
+        errors.push_back(m_location + pointer.to_string() + ": " + message);
+    }
+
+    std::vector<std::string> errors;
+
+private:
+    std::string m_location;
+};
+
+/// Returns the JSON pointer of the schema at pointer, following any `$ref` to another place in the same schema.
+/// Returns std::nullopt if there is no schema there or a `$ref` is anything other than the whole of its node.
+std::optional<std::string> resolveSchemaPointer(const nlohmann::json& schema, std::string pointer)
+{
+    constexpr int MAX_REFERENCES = 16;
+    for (int references = 0; references <= MAX_REFERENCES; references++) {
+        const nlohmann::json::json_pointer jsonPointer(pointer);
+        if (!schema.contains(jsonPointer) || !schema.at(jsonPointer).is_object()) {
+            return std::nullopt;
+        }
+        const auto& node = schema.at(jsonPointer);
+        const auto ref = node.find("$ref");
+        if (ref == node.end()) {
+            return pointer;
+        }
+        if (node.size() != 1 || !ref->is_string() || !ref->get_ref<const std::string&>().starts_with('#')) {
+            return std::nullopt;
+        }
+        pointer = ref->get_ref<const std::string&>().substr(1);
+    }
+    return std::nullopt;
+}
+
+/// Returns true if the array schema at pointer constrains nothing but the schema of its items, so an array is valid
+/// exactly when it is empty or each item is valid on its own.
+bool constrainsOnlyItems(const nlohmann::json& schema, const std::string& pointer)
+{
+    const auto& node = schema.at(nlohmann::json::json_pointer(pointer));
+    const auto items = node.find("items");
+    if (items == node.end() || !items->is_object()) {
+        return false;
+    }
+    for (const auto& [key, value] : node.items()) {
+        if (key == "type") {
+            if (value != "array") {
+                return false;
+            }
+        } else if (key != "items" && key != "description" && key != "title" && key != "$comment") {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+CompiledMnxSchema::CompiledMnxSchema(const std::string& schemaText)
+{
+    auto schema = nlohmann::json::parse(schemaText);
+
+    // the independent bulk of an MNX document, by the property names that lead to each array
+    constexpr std::array<std::array<std::string_view, 2>, 4> SECTIONS = { {
+        { "global", "measures" },
+        { "parts", {} },
+        { "layouts", {} },
+        { "scores", {} },
+    } };
+    for (const auto& path : SECTIONS) {
+        std::optional<std::string> schemaPointer = std::string{};
+        std::string location;
+        for (const auto name : path) {
+            if (name.empty() || !schemaPointer) {
+                continue;
+            }
+            schemaPointer = resolveSchemaPointer(schema, *schemaPointer + "/properties/" + std::string(name));
+            location += "/" + std::string(name);
+        }
+        if (schemaPointer && constrainsOnlyItems(schema, *schemaPointer)) {
+            m_sections.push_back({ location, "#" + *schemaPointer + "/items" });
+        }
+    }
+
+    m_validator.set_root_schema(std::move(schema));
+}
+
+std::vector<std::string> CompiledMnxSchema::validate(const mnxdom::Document& mnxDocument) const
+{
+    CollectingErrorHandler errorHandler;
+    // the validator works on nlohmann::json, while mnxdom keeps its document as ordered_json
+    m_validator.validate(nlohmann::json(*mnxDocument.root()), errorHandler);
+    return std::move(errorHandler.errors);
+}
+
+std::vector<std::string> CompiledMnxSchema::validate(const mnxdom::Document& mnxDocument, const DenigmaContext& denigmaContext) const
+{
+    if (m_sections.empty() || resolveJobCount(denigmaContext, 2) <= 1) {
+        return validate(mnxDocument);
+    }
+
+    // the sections' items are moved out, and the rest of the document keeps each array empty
+    struct SplitSection
+    {
+        const Section* section{};
+        nlohmann::json items;
+    };
+    nlohmann::json document(*mnxDocument.root());
+    std::vector<SplitSection> splitSections;
+    for (const auto& section : m_sections) {
+        const nlohmann::json::json_pointer pointer(section.location);
+        if (document.contains(pointer) && document.at(pointer).is_array()) {
+            splitSections.push_back({ &section, std::exchange(document.at(pointer), nlohmann::json::array()) });
+        }
+    }
+
+    struct Task
+    {
+        const SplitSection* split{}; ///< nullptr for the rest of the document
+        std::size_t begin{};
+        std::size_t end{};
+    };
+    std::vector<Task> tasks{ Task{} };
+    for (const auto& split : splitSections) {
+        for (std::size_t begin = 0; begin < split.items.size(); begin += ITEMS_PER_TASK) {
+            tasks.push_back({ &split, begin, (std::min)(begin + ITEMS_PER_TASK, split.items.size()) });
+        }
+    }
+
+    std::vector<std::string> errors;
+    try {
+        forEachInOrder<std::vector<std::string>>(tasks.size(), denigmaContext,
+            [&](const DenigmaContext&, std::size_t index) {
+                const auto& task = tasks[index];
+                if (!task.split) {
+                    CollectingErrorHandler errorHandler;
+                    m_validator.validate(document, errorHandler);
+                    return std::move(errorHandler.errors);
+                }
+                const nlohmann::json_schema::json_uri itemsUri(task.split->section->itemsUri);
+                std::vector<std::string> taskErrors;
+                for (std::size_t item = task.begin; item < task.end; item++) {
+                    CollectingErrorHandler errorHandler(task.split->section->location + "/" + std::to_string(item));
+                    m_validator.validate(task.split->items[item], errorHandler, itemsUri);
+                    taskErrors.insert(taskErrors.end(), std::make_move_iterator(errorHandler.errors.begin()),
+                        std::make_move_iterator(errorHandler.errors.end()));
+                }
+                return taskErrors;
+            },
+            [&](std::size_t, std::vector<std::string> taskErrors) {
+                errors.insert(errors.end(), std::make_move_iterator(taskErrors.begin()), std::make_move_iterator(taskErrors.end()));
+            });
+    } catch (const std::invalid_argument&) {
+        // the validator found no compiled sub-schema at a section's items URI, so check the document whole
+        return validate(mnxDocument);
+    }
+    return errors;
+}
+
+std::shared_ptr<const CompiledMnxSchema> CompiledMnxSchema::forSchema(const std::string& schemaText)
+{
+    static CompiledSchemaCache cache;
+    return cache.get(schemaText);
+}
+
+} // namespace detail
+} // namespace mnx
+} // namespace formats
+} // namespace denigma
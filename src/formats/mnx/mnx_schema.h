@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json-schema.hpp"
+#include "mnxdom.h"
+
+#include "mnx_fwd.h"
+
+namespace denigma {
+
+struct DenigmaContext;
+
+namespace formats {
+namespace mnx {
+namespace detail {
+
+/// @brief A JSON schema that is parsed and compiled once and then validates any number of MNX documents.
+class CompiledMnxSchema
+{
+public:
+    /// @throws nlohmann::json::exception or std::invalid_argument if schemaText is not a usable JSON schema.
+    explicit CompiledMnxSchema(const std::string& schemaText);
+
+    /// Returns one message per schema violation, or an empty vector if the document is valid.
+    /// May be called from several threads at once.
+    std::vector<std::string> validate(const mnxdom::Document& mnxDocument) const;
+
+    /// Validates like the overload above, but checks the global measures and the items of the parts, layouts and
+    /// scores arrays concurrently on up to denigmaContext.outputJobs workers, against the sub-schemas their arrays
+    /// declare for items. The rest of the document is checked with those arrays emptied. Messages come in document
+    /// order: the rest of the document first, then each section's items in turn.
+    ///
+    /// A section is only split off when its array schema constrains nothing but its items, so the result matches
+    /// a whole-document validation; the other sections, or all of them, are validated as part of the whole.
+    std::vector<std::string> validate(const mnxdom::Document& mnxDocument, const DenigmaContext& denigmaContext) const;
+
+    /// Returns the compiled form of schemaText, compiling it the first time any caller asks for it.
+    static std::shared_ptr<const CompiledMnxSchema> forSchema(const std::string& schemaText);
+
+private:
+    /// An array of the document whose items are validated apart from the rest of it.
+    struct Section
+    {
+        std::string location;   ///< JSON pointer to the array in the document
+        std::string itemsUri;   ///< URI of the sub-schema for its items
+    };
+
+    nlohmann::json_schema::json_validator m_validator;
+    std::vector<Section> m_sections;
+};
+
+} // namespace detail
+} // namespace mnx
+} // namespace formats
+} // namespace denigma
@@ -19,13 +19,17 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <cstdint>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
 #include <optional>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "core/lyric_index.h"
 #include "mnx.h"
 #include "mnx_smartshapes.h"
 #include "utils/smufl_support.h"
@@ -35,6 +39,24 @@ namespace formats {
 namespace mnx {
 namespace detail {
 
+/// @brief reserves capacity for the array at @p pointer, creating it if it does not exist yet
+///
+/// mnxdom appends children one node at a time, so sizing the backing array up front keeps
+/// the appends from reallocating and moving the already-built sibling nodes.
+static void reserveJsonArray(const MnxMusxMappingPtr& context, const mnxdom::json_pointer& pointer, size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    auto& node = (*context->mnxDocument->root())[pointer];
+    if (node.is_null()) {
+        node = json::array();
+    }
+    if (node.is_array()) {
+        node.get_ref<json::array_t&>().reserve(count);
+    }
+}
+
 static void appendMeasureRemainderSpaces(mnxdom::sequence::SequenceContent content,
     const musx::util::Fraction& elapsedInVoice,
     const musx::util::Fraction& measureDuration)
@@ -141,7 +163,9 @@ static void createTies(const MnxMusxMappingPtr& context, mnxdom::sequence::NoteB
         auto mnxTies = mnxNote.ensure_ties();
         auto tiedTo = musxNote.calcTieTo();
         auto mnxTie = mnxTies.append();
-        if (tiedTo && tiedTo->tieEnd && !tiedTo.getEntryInfo()->getEntry()->isHidden) {
+        // a tie into a measure after the excerpt has no note to target, so it is left to ring
+        if (tiedTo && tiedTo->tieEnd && !tiedTo.getEntryInfo()->getEntry()->isHidden
+            && context->excerpt.includesMeasure(tiedTo.getEntryInfo().getMeasure())) {
             mnxTie.set_target(calcNoteId(tiedTo));
         } else {
             mnxTie.set_lv(true);
@@ -199,20 +223,22 @@ static void deferJumpTies(const MnxMusxMappingPtr& context, const NoteInfoPtr& m
         return;
     }
 
-    const auto endNoteId = calcNoteId(musxNote);
+    std::optional<std::string> endNoteId;
     for (const auto& [startNote, direction] : jumpTies) {
         if (!startNote || startNote.getEntryInfo()->getEntry()->isHidden) {
             continue;
         }
-        const auto startNoteId = calcNoteId(startNote);
-        const std::string key = startNoteId + "->" + endNoteId;
-        if (!context->deferredJumpTieKeys.emplace(key).second) {
+        if (!context->deferredJumpTieKeys.emplace(jumpTieKey(startNote, musxNote)).second) {
             continue;
         }
+        if (!endNoteId) {
+            endNoteId = calcNoteId(musxNote);
+        }
 
         MnxMusxMapping::DeferredJumpTie deferred{
-            startNoteId,
-            endNoteId,
+            packedNoteId(startNote),
+            packedNoteId(musxNote),
+            *endNoteId,
             std::nullopt
         };
         if (direction != CurveContourDirection::Unspecified) {
@@ -240,7 +266,7 @@ mnxdom::sequence::Note createNormalNote(const MnxMusxMappingPtr& context, mnxdom
             acciDisp.ensure_enclosure(mnxdom::AccidentalEnclosureSymbol::Parentheses);
         }
     }
-    const auto musxEntry = musxNote.getEntryInfo()->getEntry();
+    const auto& musxEntry = musxNote.getEntryInfo()->getEntry();
     if (musxNote.calcIsEnharmonicRespellInAnyPart()) {
         auto [enharmonicLev, enharmonicAlt] = musxNote.calcDefaultEnharmonic();
         auto mnxWritten = mnxNote.ensure_written();
@@ -252,7 +278,8 @@ mnxdom::sequence::Note createNormalNote(const MnxMusxMappingPtr& context, mnxdom
 mnxdom::sequence::KitNote createKitNote(const MnxMusxMappingPtr& context, mnxdom::sequence::Event& mnxEvent, const MusxInstance<others::PercussionNoteInfo>& percNoteInfo,
     const MusxInstance<others::Staff>& musxStaff)
 {
-    auto mnxNote = mnxEvent.ensure_kitNotes().append(calcPercussionKitId(percNoteInfo));
+    const auto& percussionIds = context->percussionIdsFor(percNoteInfo);
+    auto mnxNote = mnxEvent.ensure_kitNotes().append(percussionIds.kitId);
     auto part = mnxNote.getEnclosingElement<mnxdom::Part>();
     MNX_ASSERT_IF(!part.has_value()) {
         throw std::logic_error("Note created without a part.");
@@ -265,7 +292,7 @@ mnxdom::sequence::KitNote createKitNote(const MnxMusxMappingPtr& context, mnxdom
         const auto& percNoteType = percNoteInfo->getNoteType();
         if (percNoteType.instrumentId != 0) {
             kitElement.set_name(percNoteType.createName(percNoteInfo->getNoteTypeOrderId()));
-            kitElement.set_sound(calcPercussionSoundId(percNoteInfo));
+            kitElement.set_sound(percussionIds.soundId);
             auto sounds = context->mnxDocument->global().ensure_sounds();
             if (!sounds.contains(kitElement.sound().value())) {
                 auto sound = sounds.append(kitElement.sound().value());
@@ -286,7 +313,7 @@ static void createNote(const MnxMusxMappingPtr& context, mnxdom::sequence::Event
 {
     static_assert(std::is_base_of_v<mnxdom::sequence::NoteBase, MnxNoteType>, "MnxNoteType must have base type NoteBase.");
 
-    const auto musxEntry = musxNote.getEntryInfo()->getEntry();
+    const auto& musxEntry = musxNote.getEntryInfo()->getEntry();
 
     MnxNoteType mnxNote = [&]() {
         if constexpr (std::is_same_v<MnxNoteType, mnxdom::sequence::Note>) {
@@ -298,9 +325,8 @@ static void createNote(const MnxMusxMappingPtr& context, mnxdom::sequence::Event
             return createKitNote(context, mnxEvent, percNoteInfo, musxStaff);
         }
     }();
-    const auto noteId = calcNoteId(musxNote);
-    mnxNote.set_id(noteId);
-    context->noteJsonById.emplace(noteId, mnxNote.pointer());
+    mnxNote.set_id(calcNoteId(musxNote));
+    context->noteJsonByKey.emplace(packedNoteId(musxNote), mnxNote.pointer());
     if (musxNote->crossStaff && !mnxEvent.staff()) { // createEvent already handled cross-staffing if the entire entry is crossed
         StaffCmper noteStaff = musxNote.calcStaff();
         if (const auto& mnxNoteStaff = context->mnxPartStaffFromStaff(noteStaff)) {
@@ -317,11 +343,24 @@ static void createNote(const MnxMusxMappingPtr& context, mnxdom::sequence::Event
 static void createNotes(const MnxMusxMappingPtr& context, mnxdom::sequence::Event& mnxEvent, const EntryInfoPtr& musxEntryInfo,
     const MusxInstance<others::Staff>& musxStaff)
 {
-    const auto musxEntry = musxEntryInfo->getEntry();
+    const auto& musxEntry = musxEntryInfo->getEntry();
+
+    // resolve percussion info once so both note arrays can be sized before the first append
+    std::vector<MusxInstance<others::PercussionNoteInfo>> percNoteInfos;
+    percNoteInfos.reserve(musxEntry->notes.size());
+    size_t numKitNotes = 0;
+    for (size_t x = 0; x < musxEntry->notes.size(); x++) {
+        percNoteInfos.push_back(NoteInfoPtr(musxEntryInfo, x).calcPercussionNoteInfo());
+        if (percNoteInfos.back()) {
+            numKitNotes++;
+        }
+    }
+    reserveJsonArray(context, mnxEvent.pointer() / "notes", musxEntry->notes.size() - numKitNotes);
+    reserveJsonArray(context, mnxEvent.pointer() / "kitNotes", numKitNotes);
 
     for (size_t x = 0; x < musxEntry->notes.size(); x++) {
         const auto mnxNote = NoteInfoPtr(musxEntryInfo, x);
-        if (const auto percNoteInfo = mnxNote.calcPercussionNoteInfo()) {
+        if (const auto& percNoteInfo = percNoteInfos[x]) {
             createNote<mnxdom::sequence::KitNote>(context, mnxEvent, mnxNote, musxStaff, percNoteInfo);
         } else {
             createNote<mnxdom::sequence::Note>(context, mnxEvent, mnxNote, musxStaff, nullptr);
@@ -332,7 +371,7 @@ static void createNotes(const MnxMusxMappingPtr& context, mnxdom::sequence::Even
 static void createRest([[maybe_unused]] const MnxMusxMappingPtr& context, mnxdom::sequence::Event& mnxEvent, const EntryInfoPtr& musxEntryInfo,
     const MusxInstance<others::Staff>& musxStaff)
 {
-    const auto musxEntry = musxEntryInfo->getEntry();
+    const auto& musxEntry = musxEntryInfo->getEntry();
 
     auto mnxRest = mnxEvent.ensure_rest();
     // If a rest is hidden, it has been detected as a beam workaround, so its staff position is meaningless
@@ -356,7 +395,7 @@ static void createFullMeasureRest(const MnxMusxMappingPtr& context, mnxdom::sequ
     }
 
     auto fullMeasure = sequence->ensure_fullMeasure();
-    const auto musxEntry = musxEntryInfo->getEntry();
+    const auto& musxEntry = musxEntryInfo->getEntry();
     context->entryTargetByNumber.insert_or_assign(
         musxEntry->getEntryNumber(),
         EntryTarget{ EntryTargetKind::FullMeasureRest, fullMeasure.pointer() });
@@ -373,26 +412,26 @@ static void createFullMeasureRest(const MnxMusxMappingPtr& context, mnxdom::sequ
 
 static void createLyrics(const MnxMusxMappingPtr& context, mnxdom::sequence::Event& mnxEvent, const EntryInfoPtr& musxEntryInfo)
 {
-    const auto musxEntry = musxEntryInfo->getEntry();
+    const auto& musxEntry = musxEntryInfo->getEntry();
+    const auto lyricIndex = LyricIndex::forDocument(musxEntry->getDocument());
 
     auto createLyricsType = [&](const auto& musxLyrics) {
         using PtrType = typename std::decay_t<decltype(musxLyrics)>::value_type;
         using T = typename PtrType::element_type;
         static_assert(std::is_base_of_v<details::LyricAssign, T>, "musxLyrics must be a subtype of LyricAssign");
         for (const auto& lyr : musxLyrics) {
-            if (auto lyrText = lyr->getLyricText()) {
-                if (lyr->syllable > lyrText->syllables.size()) { // Finale syllable numbers are 1-based.
+            if (const auto syllables = lyricIndex->findText<typename T::TextType>(lyr->lyricNumber)) {
+                if (lyr->syllable == 0 || lyr->syllable > syllables->size()) { // Finale syllable numbers are 1-based.
                     context->logMessage(LogMsg() << " Layer " << musxEntryInfo.getLayerIndex() + 1
                         << " Entry index " << musxEntryInfo.getIndexInFrame() << " has an invalid syllable number ("
                         << lyr->syllable << ").", MessageSeverity::Warning);
                 } else {
                     auto mnxLyrics = mnxEvent.ensure_lyrics();
                     auto mnxLyricsLines = mnxLyrics.ensure_lines();
-                    const size_t sylIndex = size_t(lyr->syllable - 1); // Finale syllable numbers are 1-based.
+                    const auto& syllable = (*syllables)[size_t(lyr->syllable - 1)]; // Finale syllable numbers are 1-based.
                     auto mnxLyricLine = mnxLyricsLines.append(
-                        calcLyricLineId(std::string(T::TextType::XmlNodeName), lyr->lyricNumber),
-                        lyrText->syllables[sylIndex]->syllable);
-                    mnxLyricLine.set_type(mnxLineTypeFromLyric(lyrText->syllables[sylIndex]));
+                        calcLyricLineId(std::string(T::TextType::XmlNodeName), lyr->lyricNumber), syllable.text);
+                    mnxLyricLine.set_type(mnxLineTypeFromLyric(syllable));
                 }
             }
         }
@@ -403,10 +442,10 @@ static void createLyrics(const MnxMusxMappingPtr& context, mnxdom::sequence::Eve
 }
 
 static std::optional<mnxdom::sequence::Event> createEvent(const MnxMusxMappingPtr& context, mnxdom::sequence::SequenceContent content,
-    EntryInfoPtr musxEntryInfo, bool effectiveHidden, bool hasVoice1Voice2,
+    const EntryInfoPtr& musxEntryInfo, bool effectiveHidden, bool hasVoice1Voice2,
     const MusxInstance<details::TupletDef>& tupletDef, bool forTremolo)
 {
-    const auto musxEntry = musxEntryInfo->getEntry();
+    const auto& musxEntry = musxEntryInfo->getEntry();
 
     if (effectiveHidden) {
         /// @todo include hidden entries perhaps, if MNX starts allowing them.
@@ -525,7 +564,7 @@ static EntryInfoPtr::InterpretedIterator addEntryToContent(const MnxMusxMappingP
         }
 
         if (tupletIndex) {
-            auto tuplInfo = next.getEntryInfo().getFrame()->tupletInfo[tupletIndex.value()];
+            const auto& tuplInfo = next.getEntryInfo().getFrame()->tupletInfo[tupletIndex.value()];
             if (tuplInfo.endIndex == next.getEntryInfo().getIndexInFrame()) {
                 auto thisTupletIndex = next.getEntryInfo().calcNextTupletIndex(tupletIndex);
                 if (!thisTupletIndex || next.getEntryInfo().getFrame()->tupletInfo[thisTupletIndex.value()].startIndex != next.getEntryInfo().getIndexInFrame()) {
@@ -539,7 +578,7 @@ static EntryInfoPtr::InterpretedIterator addEntryToContent(const MnxMusxMappingP
         if (!inGrace) {
             auto thisTupletIndex = next.getEntryInfo().calcNextTupletIndex(tupletIndex);
             if (thisTupletIndex != tupletIndex && thisTupletIndex) {
-                auto tuplInfo = next.getEntryInfo().getFrame()->tupletInfo[thisTupletIndex.value()];
+                const auto& tuplInfo = next.getEntryInfo().getFrame()->tupletInfo[thisTupletIndex.value()];
                 if (tuplInfo.calcIsTremolo()) {
                     const auto numBeams = next.getEntryInfo().calcNumberOfBeams();
                     const auto numFlagsInRef = calcNumberOfBeamsInEdu(tuplInfo.tuplet->calcReferenceDuration().calcEduDuration());
@@ -558,12 +597,8 @@ static EntryInfoPtr::InterpretedIterator addEntryToContent(const MnxMusxMappingP
             }
         }
 
-        auto tupletDef = [&]() -> MusxInstance<details::TupletDef> {
-            if (tupletIndex) {
-                return next.getEntryInfo().getFrame()->tupletInfo[tupletIndex.value()].tuplet;
-            }
-            return nullptr;
-        }();
+        static const MusxInstance<details::TupletDef> noTupletDef;
+        const auto& tupletDef = tupletIndex ? next.getEntryInfo().getFrame()->tupletInfo[tupletIndex.value()].tuplet : noTupletDef;
 
         const bool fullMeasureRest = next.getEntryInfo().calcIsFullMeasureRest();
         if (fullMeasureRest) {
@@ -595,6 +630,7 @@ void createSequences(const MnxMusxMappingPtr& context,
     if (!context->current.gfhold || !*context->current.gfhold) {
         return; // nothing to do
     }
+    TraceSpan span("createSequences");
     if (context->current.cueDiscardPlan.discardWholeHold) {
         return;
     }
@@ -604,7 +640,7 @@ void createSequences(const MnxMusxMappingPtr& context,
             continue;
         }
         const int maxVoices = numV2 ? 2 : 1;
-        if (auto entryFrame = context->current.gfhold->createEntryFrame(layer)) {
+        if (auto entryFrame = context->entryFrames.get(*context->current.gfhold, layer)) {
             const bool usesV1V2 = numV2 && entryFrame->getFirstInterpretedIterator(2); // ignore entries the iterator will skip
             auto entries = entryFrame->getEntries();
             if (!entries.empty()) {
@@ -615,6 +651,8 @@ void createSequences(const MnxMusxMappingPtr& context,
                         sequence.set_staff(mnxStaffNumber.value_or(1));
                         sequence.set_voice(context->current.voice);
                         auto elapsedInVoice = musx::util::Fraction(0);
+                        // the frame's entry count bounds the top-level events; trailing spaces are few
+                        reserveJsonArray(context, sequence.content().pointer(), entries.size() + 1);
                         addEntryToContent(context, sequence.content(), firstEntry, elapsedInVoice, usesV1V2, false);
                         appendMeasureRemainderSpaces(sequence.content(), elapsedInVoice, measureDuration);
                         context->current.voice.clear();
@@ -631,19 +669,26 @@ void finalizeJumpTies(const MnxMusxMappingPtr& context)
         return;
     }
 
-    std::unordered_set<std::string> clearedLvTies;
-    std::unordered_map<std::string, std::optional<mnxdom::SlurTieSide>> consensusSides;
+    // Group the ties by start note, keeping first-appearance order, so that each start note is resolved in the
+    // document once rather than once per tie. Ties on the same note keep their relative order.
+    std::vector<std::pair<std::uint64_t, std::vector<const MnxMusxMapping::DeferredJumpTie*>>> tiesByStartNote;
+    std::unordered_map<std::uint64_t, size_t> groupIndexByStartNote;
     for (const auto& deferred : context->deferredJumpTies) {
-        const auto noteIt = context->noteJsonById.find(deferred.startNoteId);
-        if (noteIt == context->noteJsonById.end()) {
+        const auto [it, inserted] = groupIndexByStartNote.try_emplace(deferred.startNoteKey, tiesByStartNote.size());
+        if (inserted) {
+            tiesByStartNote.emplace_back(deferred.startNoteKey, std::vector<const MnxMusxMapping::DeferredJumpTie*>{});
+        }
+        tiesByStartNote[it->second].second.push_back(&deferred);
+    }
+
+    for (const auto& [startNoteKey, deferredTies] : tiesByStartNote) {
+        const auto noteIt = context->noteJsonByKey.find(startNoteKey);
+        if (noteIt == context->noteJsonByKey.end()) {
             continue;
         }
 
         mnxdom::sequence::NoteBase startNote(context->mnxDocument->root(), noteIt->second);
         const auto consensusSide = [&]() -> std::optional<mnxdom::SlurTieSide> {
-            if (const auto cached = consensusSides.find(deferred.startNoteId); cached != consensusSides.end()) {
-                return cached->second;
-            }
             std::optional<mnxdom::SlurTieSide> side;
             bool hasNonLv = false;
             if (auto tiesOpt = startNote.ties()) {
@@ -671,43 +716,42 @@ void finalizeJumpTies(const MnxMusxMappingPtr& context)
             if (!hasNonLv) {
                 side.reset();
             }
-            consensusSides.emplace(deferred.startNoteId, side);
             return side;
         }();
-        if (clearedLvTies.insert(deferred.startNoteId).second) {
-            if (auto tiesOpt = startNote.ties()) {
-                auto ties = tiesOpt.value();
-                for (size_t i = ties.size(); i-- > 0;) {
-                    if (ties.at(i).lv()) {
-                        ties.erase(i);
-                    }
-                }
-                if (ties.size() == 0) {
-                    startNote.clear_ties();
+        if (auto tiesOpt = startNote.ties()) {
+            auto ties = tiesOpt.value();
+            for (size_t i = ties.size(); i-- > 0;) {
+                if (ties.at(i).lv()) {
+                    ties.erase(i);
                 }
             }
+            if (ties.size() == 0) {
+                startNote.clear_ties();
+            }
         }
 
         auto mnxTies = startNote.ensure_ties();
-        bool alreadyLinked = false;
-        for (size_t i = 0; i < mnxTies.size(); i++) {
-            auto tie = mnxTies.at(i);
-            if (tie.target() && tie.target().value() == deferred.endNoteId) {
-                alreadyLinked = true;
-                break;
+        for (const auto* deferred : deferredTies) {
+            bool alreadyLinked = false;
+            for (size_t i = 0; i < mnxTies.size(); i++) {
+                auto tie = mnxTies.at(i);
+                if (tie.target() && tie.target().value() == deferred->endNoteId) {
+                    alreadyLinked = true;
+                    break;
+                }
+            }
+            if (alreadyLinked) {
+                continue;
             }
-        }
-        if (alreadyLinked) {
-            continue;
-        }
 
-        auto mnxTie = mnxTies.append();
-        mnxTie.set_target(deferred.endNoteId);
-        mnxTie.set_targetType(mnxdom::TieTargetType::CrossJump);
-        if (deferred.side) {
-            mnxTie.set_side(deferred.side.value());
-        } else if (consensusSide) {
-            mnxTie.set_side(consensusSide.value());
+            auto mnxTie = mnxTies.append();
+            mnxTie.set_target(deferred->endNoteId);
+            mnxTie.set_targetType(mnxdom::TieTargetType::CrossJump);
+            if (deferred->side) {
+                mnxTie.set_side(deferred->side.value());
+            } else if (consensusSide) {
+                mnxTie.set_side(consensusSide.value());
+            }
         }
     }
 }
@@ -33,13 +33,30 @@ namespace mnx {
 namespace detail {
 
 namespace {
-void appendHairpin(const MnxMusxMappingPtr&, mnxdom::part::Measure& mnxMeasure, std::optional<int> mnxStaffNumber,
+
+/// When a shape ending at endPoint runs past the end of an excerpt, returns the excerpt's last measure and its
+/// duration: the final barline, where the shape is cut off.
+std::optional<std::pair<MeasCmper, mnxdom::FractionValue>> calcExcerptCutoff(const MnxMusxMappingPtr& context,
+    const MusxInstance<smartshape::EndPoint>& endPoint)
+{
+    if (endPoint->measId <= context->excerpt.lastMeasure()) {
+        return std::nullopt;
+    }
+    const auto lastMeasure = context->document->getOthers()->get<others::Measure>(SCORE_PARTID, context->excerpt.lastMeasure());
+    if (!lastMeasure) {
+        return std::nullopt;
+    }
+    return std::make_pair(lastMeasure->getCmper(), mnxFractionFromFraction(lastMeasure->calcDuration()));
+}
+
+void appendHairpin(const MnxMusxMappingPtr& context, mnxdom::part::Measure& mnxMeasure, std::optional<int> mnxStaffNumber,
     const MusxInstance<others::SmartShape>& shape, mnxdom::DynamicWedgeType wedgeType)
 {
     const auto startPos = mnxFractionFromFraction(shape->startTermSeg->endPoint->calcGlobalPosition());
+    const auto cutoff = calcExcerptCutoff(context, shape->endTermSeg->endPoint);
     const auto endPos = mnxdom::MeasureRhythmicPosition::make(
-        calcGlobalMeasureId(shape->endTermSeg->endPoint->measId),
-        mnxFractionFromFraction(shape->endTermSeg->endPoint->calcGlobalPosition()));
+        calcGlobalMeasureId(cutoff ? cutoff->first : shape->endTermSeg->endPoint->measId),
+        cutoff ? cutoff->second : mnxFractionFromFraction(shape->endTermSeg->endPoint->calcGlobalPosition()));
     auto mnxDynamic = mnxMeasure.ensure_dynamics().appendGradual(wedgeType, startPos, endPos);
     /// @todo Perhaps get smarter about setting start/end grace index using situational heuristics
     mnxDynamic.position().set_graceIndex(0);        // always after grace notes
@@ -55,24 +72,12 @@ void processSmartShapes(const MnxMusxMappingPtr& context, const MusxInstance<oth
     mnxdom::part::Measure& mnxMeasure, std::optional<int> mnxStaffNumber)
 {
     if (musxMeasure->hasSmartShape) {
-        const auto assigns = context->document->getOthers()->getArray<others::SmartShapeMeasureAssign>(musxMeasure->getRequestedPartId(), musxMeasure->getCmper());
-        for (const auto& assign : assigns) {
-            MUSX_ASSERT_IF(!assign) {
-                context->logMessage(LogMsg() << "skipping empty smart shape assignment for measure " << musxMeasure->getCmper(), MessageSeverity::Warning);
+        for (const auto& start : context->smartShapeStarts->get(musxMeasure->getCmper(), context->current.staff)) {
+            const auto& shape = start.shape;
+            const auto& classification = start.classification;
+            if (!shape->calcIsValid()) {
                 continue;
             }
-            if (assign->centerShapeNum != 0) {
-                // ignore assignments in the middle of the shape
-                continue;
-            }
-            const auto shape = context->document->getOthers()->get<others::SmartShape>(SCORE_PARTID, assign->shapeNum);
-            if (!shape || !shape->calcIsValid()) {
-                continue;
-            }
-            if (shape->startTermSeg->endPoint->staffId != context->current.staff || shape->startTermSeg->endPoint->measId != musxMeasure->getCmper()) {
-                continue;
-            }
-            const auto classification = denigma::classify::classifySmartShape(shape);
             std::visit([&](const auto& value) {
                 using Value = std::decay_t<decltype(value)>;
                 if constexpr (std::is_same_v<Value, denigma::classify::smartshape::Crescendo>) {
@@ -92,7 +97,7 @@ void processSmartShapes(const MnxMusxMappingPtr& context, const MusxInstance<oth
     }
 }
 
-void processSlurs(const MnxMusxMappingPtr&, mnxdom::sequence::Event& mnxEvent, const EntryInfoPtr& musxEntryInfo)
+void processSlurs(const MnxMusxMappingPtr& context, mnxdom::sequence::Event& mnxEvent, const EntryInfoPtr& musxEntryInfo)
 {
     const auto musxEntry = musxEntryInfo->getEntry();
     const auto currentEntryNumber = musxEntry->getEntryNumber();
@@ -125,6 +130,9 @@ void processSlurs(const MnxMusxMappingPtr&, mnxdom::sequence::Event& mnxEvent, c
                 if (targetEntryNumber == currentEntryNumber) {
                     continue;
                 }
+                if (!context->excerpt.includesMeasure(slur->endEntry.getMeasure())) {
+                    continue; // the slur ends after the excerpt, so its target event does not exist
+                }
 
                 auto mnxSlur = createOneSlur(targetEntryNumber);
                 mnxSlur.set_lineType(shape->calcIsDashed() ? mnxdom::LineType::Dashed : mnxdom::LineType::Solid);
@@ -141,21 +149,26 @@ void createOttavas(const MnxMusxMappingPtr& context, const MusxInstance<others::
 {
     const StaffCmper staffCmper = context->current.staff;
     context->current.ottavasApplicableInMeasure = collectOttavasForMeasureStaff(
-        context->document, musxMeasure->getRequestedPartId(), musxMeasure, staffCmper);
+        *context->ottavaIndex, musxMeasure, staffCmper);
     if (musxMeasure->hasSmartShape) {
-        auto shapeAssigns = context->document->getOthers()->getArray<others::SmartShapeMeasureAssign>(musxMeasure->getRequestedPartId(), musxMeasure->getCmper());
-        for (const auto& asgn : shapeAssigns) {
+        for (const auto& asgn : context->measureIndex->get(musxMeasure->getCmper()).smartShapes) {
             if (auto shape = context->document->getOthers()->get<others::SmartShape>(asgn->getRequestedPartId(), asgn->shapeNum)) {
                 const auto it = context->current.ottavasApplicableInMeasure.find(shape->getCmper());
                 if (it != context->current.ottavasApplicableInMeasure.end()) {
-                    if (!asgn->centerShapeNum && shape->startTermSeg->endPoint->measId == musxMeasure->getCmper()) {
+                    const auto startMeasure = shape->startTermSeg->endPoint->measId;
+                    // an ottava in effect where an excerpt starts restarts at its first beat
+                    const bool carriedIntoExcerpt = context->excerpt.startsMidScore() && startMeasure < context->excerpt.firstMeasure()
+                        && musxMeasure->getCmper() == context->excerpt.firstMeasure();
+                    if (!asgn->centerShapeNum && (startMeasure == musxMeasure->getCmper() || carriedIntoExcerpt)) {
                         // Semantic carriers are emitted even when hidden: a hidden built-in
                         // ottava carries the octave displacement for its visual proxy.
+                        const auto cutoff = calcExcerptCutoff(context, shape->endTermSeg->endPoint);
                         auto mnxOttava = mnxMeasure.ensure_ottavas().append(
                             static_cast<mnxdom::OttavaAmount>(it->second.classification.octaveShift),
-                            mnxFractionFromSmartShapeEndPoint(shape->startTermSeg->endPoint),
-                            mnxdom::MeasureRhythmicPosition::make(calcGlobalMeasureId(shape->endTermSeg->endPoint->measId),
-                                                               mnxFractionFromSmartShapeEndPoint(shape->endTermSeg->endPoint)));
+                            carriedIntoExcerpt ? mnxFractionFromEdu(0) : mnxFractionFromSmartShapeEndPoint(shape->startTermSeg->endPoint),
+                            mnxdom::MeasureRhythmicPosition::make(
+                                calcGlobalMeasureId(cutoff ? cutoff->first : shape->endTermSeg->endPoint->measId),
+                                cutoff ? cutoff->second : mnxFractionFromSmartShapeEndPoint(shape->endTermSeg->endPoint)));
                         mnxOttava.end().position().set_graceIndex(0);   // guarantees inclusion of any grace notes at the end of the ottava
                         if (mnxStaffNumber) {
                             mnxOttava.set_staff(mnxStaffNumber.value());
@@ -25,12 +25,16 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <ostream>
 #include <set>
 #include <span>
 #include <sstream>
+#include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "core/denigma.h"
 
@@ -38,6 +42,8 @@
 #include "mss.h"
 #include "musx/musx.h"
 #include "core/musx_reader.h"
+#include "core/parallel.h"
+#include "core/part_layout.h"
 #include "pugixml.hpp"
 #include "utils/font_names.h"
 #include "utils/stringutils.h"
@@ -96,10 +102,23 @@ static bool fontIsEngravingWithMappedLegacy(const FontInfo* fontInfo)
     return utils::isFinaleLegacyMusicFontMappedToSmufl(fontInfo->getName());
 }
 
+/// Font-metric-derived values shared by every part document of one conversion. Parts are built concurrently.
+class FontMetricsMemo
+{
+public:
+    /// Returns the approximate ascent of fontInfo's digits in spaces, measuring each distinct font only once.
+    double ascentInSpaces(const FontInfo* fontInfo, const DenigmaContext& denigmaContext);
+
+private:
+    std::mutex m_mutex;
+    std::unordered_map<std::string, double> m_ascents;
+};
+
 // MSS preferences:
 struct MssPreferences : public FinaleOptions
 {
     const DenigmaContext* denigmaContext;
+    FontMetricsMemo* fontMetrics;
     DocumentPtr document;
     MusxInstance<others::LayerAttributes> layerOneAttributes;
     //
@@ -108,11 +127,12 @@ struct MssPreferences : public FinaleOptions
 };
 using MssPreferencesPtr = std::shared_ptr<MssPreferences>;
 
-static MssPreferencesPtr getCurrentPrefs(const DocumentPtr& document, Cmper forPartId, const DenigmaContext& denigmaContext)
+static MssPreferencesPtr getCurrentPrefs(const DocumentPtr& document, Cmper forPartId, const DenigmaContext& denigmaContext, FontMetricsMemo& fontMetrics)
 {
     auto retval = std::make_shared<MssPreferences>();
     static_cast<FinaleOptions&>(*retval) = loadFinaleOptions(document, forPartId);
     retval->denigmaContext = &denigmaContext;
+    retval->fontMetrics = &fontMetrics;
     retval->document = document;
     retval->layerOneAttributes = document->getOthers()->get<others::LayerAttributes>(forPartId, 0);
     if (!retval->layerOneAttributes) {
@@ -134,30 +154,48 @@ static MssPreferencesPtr getCurrentPrefs(const DocumentPtr& document, Cmper forP
     return retval;
 }
 
-static std::string formatMuseFloat(double value)
+static utils::NumberText formatMuseFloat(double value)
 {
-    char buffer[512];
-    snprintf(buffer, sizeof(buffer), "%.*g", MUSE_NUMERIC_PRECISION, value);
-    return std::string(buffer);
+    return utils::NumberText::general(value, MUSE_NUMERIC_PRECISION);
 }
 
+/// The Style element of an MSS document, with a handle to every key already written, so that setting a key does not
+/// search the element's several hundred children.
+class StyleElement
+{
+public:
+    explicit StyleElement(XmlElement node) : m_node(node) {}
+
+    explicit operator bool() const { return bool(m_node); }
+
+    /// Returns the key element named nodeName, appending it the first time it is asked for.
+    XmlElement child(const std::string& nodeName)
+    {
+        auto [it, inserted] = m_children.try_emplace(nodeName);
+        if (inserted) {
+            it->second = m_node.append_child(nodeName.c_str());
+        }
+        return it->second;
+    }
+
+private:
+    XmlElement m_node;
+    std::unordered_map<std::string, XmlElement> m_children;
+};
+
 template<typename T>
-static XmlElement setElementValue(XmlElement& styleElement, const std::string& nodeName, const T& value)
+static XmlElement setElementValue(StyleElement& styleElement, const std::string& nodeName, const T& value)
 {
     if (!styleElement) {
         throw std::invalid_argument("styleElement cannot be null");
     }
 
-    XmlElement element = styleElement.child(nodeName.c_str());
-    if (!element) {
-        element = styleElement.append_child(nodeName.c_str());
-    }
+    XmlElement element = styleElement.child(nodeName);
 
     if constexpr (std::is_same_v<T, std::nullptr_t>) {
         static_assert(std::is_same_v<T, std::nullptr_t>, "Incorrect property.");
     } else if constexpr (std::is_floating_point_v<T>) {
-        const std::string formatted = formatMuseFloat(value);
-        element.text().set(formatted.c_str());
+        element.text().set(formatMuseFloat(value).c_str());
     } else if constexpr (std::is_same_v<T, std::string>) {
         element.text().set(value.c_str());
     } else if constexpr (std::is_same_v<T, bool>) {
@@ -169,24 +207,20 @@ static XmlElement setElementValue(XmlElement& styleElement, const std::string& n
     return element;
 }
 
-static void setPointElement(XmlElement& styleElement, const std::string& nodeName, double x, double y)
+static void setPointElement(StyleElement& styleElement, const std::string& nodeName, double x, double y)
 {
     if (!styleElement) {
         throw std::invalid_argument("styleElement cannot be null");
     }
 
-    XmlElement element = styleElement.child(nodeName.c_str());
-    if (!element) {
-        element = styleElement.append_child(nodeName.c_str());
-    }
+    XmlElement element = styleElement.child(nodeName);
 
     auto setAttribute = [&](const char* name, double value) {
         XmlAttribute attribute = element.attribute(name);
         if (!attribute) {
             attribute = element.append_attribute(name);
         }
-        const std::string formatted = formatMuseFloat(value);
-        attribute.set_value(formatted.c_str());
+        attribute.set_value(formatMuseFloat(value).c_str());
     };
 
     element.text().set("");
@@ -226,6 +260,27 @@ static double approximateFontAscentInSpaces(const FontInfo* fontInfo, const Deni
     return ascentEvpu / EVPU_PER_SPACE;
 }
 
+double FontMetricsMemo::ascentInSpaces(const FontInfo* fontInfo, const DenigmaContext& denigmaContext)
+{
+    if (!fontInfo) {
+        return 0.0;
+    }
+    std::string key = fontInfo->getName();
+    key += '\0';
+    key += std::to_string(fontInfo->fontSize);
+    key += fontInfo->absolute ? 'a' : 'r';
+    {
+        std::lock_guard lock(m_mutex);
+        if (const auto it = m_ascents.find(key); it != m_ascents.end()) {
+            return it->second;
+        }
+    }
+    const double ascent = approximateFontAscentInSpaces(fontInfo, denigmaContext);
+    std::lock_guard lock(m_mutex);
+    m_ascents.emplace(std::move(key), ascent);
+    return ascent;
+}
+
 static uint16_t museFontEfx(const FontInfo* fontInfo)
 {
     uint16_t retval = 0;
@@ -301,7 +356,7 @@ static std::optional<EvpuFloat> calcRepeatDotWidth(const MssPreferencesPtr& pref
     return std::nullopt;
 }
 
-static void writeFontPref(XmlElement& styleElement, const std::string& namePrefix, const FontInfo* fontInfo)
+static void writeFontPref(StyleElement& styleElement, const std::string& namePrefix, const FontInfo* fontInfo)
 {
     setElementValue(styleElement, namePrefix + "FontFace", fontInfo->getName());
     setElementValue(styleElement, namePrefix + "FontSize", 
@@ -327,7 +382,7 @@ static double calcMusicalSymbolScale(const MssPreferencesPtr& prefs, const FontI
     return symbolScale;
 }
 
-static void writeDefaultFontPref(XmlElement& styleElement, const MssPreferencesPtr& prefs, const std::string& namePrefix, options::FontOptions::FontType type)
+static void writeDefaultFontPref(StyleElement& styleElement, const MssPreferencesPtr& prefs, const std::string& namePrefix, options::FontOptions::FontType type)
 {
     if (auto fontPrefs = prefs->fontOptions->getFontInfo(type)) {
         // If font is a symbols font, write text settings from TextBlock and set symbol scaling.
@@ -345,7 +400,7 @@ static void writeDefaultFontPref(XmlElement& styleElement, const MssPreferencesP
     }
 }
 
-void writeLinePrefs(XmlElement& styleElement,
+void writeLinePrefs(StyleElement& styleElement,
                     const std::string& namePrefix, 
                     double widthEfix, 
                     double dashLength, 
@@ -361,7 +416,7 @@ void writeLinePrefs(XmlElement& styleElement,
     setElementValue(styleElement, namePrefix + "DashGapLen", dashGap / lineWidthEvpu);
 }
 
-static void writeFramePrefs(XmlElement& styleElement, const std::string& namePrefix, const others::Enclosure* enclosure = nullptr)
+static void writeFramePrefs(StyleElement& styleElement, const std::string& namePrefix, const others::Enclosure* enclosure = nullptr)
 {
     if (!enclosure || enclosure->shape == others::Enclosure::Shape::NoEnclosure || enclosure->lineWidth == 0) {
         setElementValue(styleElement, namePrefix + "FrameType", 0);
@@ -377,7 +432,7 @@ static void writeFramePrefs(XmlElement& styleElement, const std::string& namePre
                     enclosure->roundCorners ? int(lround(enclosure->cornerRadius / EFIX_PER_EVPU)) : 0);
 }
 
-static void writeCategoryTextFontPref(XmlElement& styleElement, const MssPreferencesPtr& prefs, const std::string& namePrefix, others::MarkingCategory::CategoryType categoryType)
+static void writeCategoryTextFontPref(StyleElement& styleElement, const MssPreferencesPtr& prefs, const std::string& namePrefix, others::MarkingCategory::CategoryType categoryType)
 {
     auto cat = prefs->document->getOthers()->get<others::MarkingCategory>(prefs->forPartId, Cmper(categoryType));
     if (!cat) {
@@ -410,7 +465,7 @@ static void writeCategoryTextFontPref(XmlElement& styleElement, const MssPrefere
     }
 }
 
-static void writePagePrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+static void writePagePrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     auto pagePrefs = prefs->effectivePageFormat;
 
@@ -437,8 +492,8 @@ static void writePagePrefs(XmlElement& styleElement, const MssPreferencesPtr& pr
     setElementValue(styleElement, "spatium", (EVPU_PER_SPACE * prefs->spatiumScaling) / EVPU_PER_MM);
 
     // Calculate small staff size and small note size from first system, if any is there
-    if (const auto& firstSystem = prefs->document->getOthers()->get<others::StaffSystem>(prefs->forPartId, 1)) {
-        auto [minSize, maxSize] = firstSystem->calcMinMaxStaffSizes();
+    if (const auto* firstSystem = PartLayout::forPart(prefs->document, prefs->forPartId)->findSystem(1)) {
+        auto [minSize, maxSize] = firstSystem->staffSizes;
         if (minSize < 1) {
             setElementValue(styleElement, "smallStaffMag", minSize.toDouble());
             setElementValue(styleElement, "smallNoteMag", minSize.toDouble());
@@ -450,7 +505,7 @@ static void writePagePrefs(XmlElement& styleElement, const MssPreferencesPtr& pr
     }
 }
 
-static void writeLyricsPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+static void writeLyricsPrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     auto fontInfo = prefs->fontOptions->getFontInfo(options::FontOptions::FontType::LyricVerse);
     for (auto [verseNumber, evenOdd] : {
@@ -468,7 +523,7 @@ static void writeLyricsPrefs(XmlElement& styleElement, const MssPreferencesPtr&
     }
 }
 
-void writeLineMeasurePrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+void writeLineMeasurePrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     using RepeatWingStyle = options::RepeatOptions::WingStyle;
 
@@ -550,7 +605,7 @@ void writeLineMeasurePrefs(XmlElement& styleElement, const MssPreferencesPtr& pr
     setElementValue(styleElement, "repeatPlayCountShow", false);
 }
 
-void writeStemPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+void writeStemPrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     bool useStraightFlags = prefs->flagOptions->straightFlags;
     if (!useStraightFlags && prefs->musicSymbolOptions) {
@@ -572,7 +627,7 @@ void writeStemPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
     setElementValue(styleElement, "stemSlashThickness", prefs->graceOptions->graceSlashWidth / EFIX_PER_SPACE);
 }
 
-void writeMusicSpacingPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+void writeMusicSpacingPrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     setElementValue(styleElement, "minMeasureWidth", prefs->musicSpacing->minWidth / EVPU_PER_SPACE);
     setElementValue(styleElement, "minNoteDistance", prefs->musicSpacing->minDistance / EVPU_PER_SPACE);
@@ -606,7 +661,7 @@ void writeMusicSpacingPrefs(XmlElement& styleElement, const MssPreferencesPtr& p
     setElementValue(styleElement, "articulationKeepTogether", false);
 }
 
-void writeNoteRelatedPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+void writeNoteRelatedPrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     setElementValue(styleElement, "accidentalDistance", prefs->accidentalOptions->acciAcciSpace / EVPU_PER_SPACE);
     setElementValue(styleElement, "accidentalNoteDistance", prefs->accidentalOptions->acciNoteSpace / EVPU_PER_SPACE);
@@ -637,7 +692,7 @@ void writeNoteRelatedPrefs(XmlElement& styleElement, const MssPreferencesPtr& pr
     setElementValue(styleElement, "tremoloStyle", 1); // MuseScore importer writes TremoloStyle::TRADITIONAL.
 }
 
-void writeSmartShapePrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+void writeSmartShapePrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     const auto& smartShapePrefs = prefs->smartShapeOptions;
     const auto& tiePrefs = prefs->tieOptions;
@@ -706,7 +761,7 @@ void writeSmartShapePrefs(XmlElement& styleElement, const MssPreferencesPtr& pre
     }
 }
 
-void writeMeasureNumberPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+void writeMeasureNumberPrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     setElementValue(styleElement, "showMeasureNumber", bool(prefs->effectiveMeasNumScorePart));
     if (prefs->effectiveMeasNumScorePart) {
@@ -768,7 +823,7 @@ void writeMeasureNumberPrefs(XmlElement& styleElement, const MssPreferencesPtr&
             setElementValue(styleElement, prefix + "HPlacement", alignJustifyToHorizontalString(justification));
             setElementValue(styleElement, prefix + "Align", alignJustifyToAlignString(alignment, "baseline"));
             setElementValue(styleElement, prefix + "Position", alignJustifyToHorizontalString(justification));
-            const double textHeightSp = approximateFontAscentInSpaces(fontInfo.get(), *prefs->denigmaContext) * prefs->spatiumScaling;
+            const double textHeightSp = prefs->fontMetrics->ascentInSpaces(fontInfo.get(), *prefs->denigmaContext) * prefs->spatiumScaling;
             const double normalStaffHeightSp = 4.0;
             setPointElement(styleElement, prefix + "PosAbove", horizontalSp, std::min(-verticalSp, 0.0));
             setPointElement(styleElement, prefix + "PosBelow", horizontalSp,
@@ -816,7 +871,7 @@ void writeMeasureNumberPrefs(XmlElement& styleElement, const MssPreferencesPtr&
     setElementValue(styleElement, "mmRestOldStyleSpacing", prefs->mmRestOptions->symSpacing / EVPU_PER_SPACE);
 }
 
-void writeRepeatEndingPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+void writeRepeatEndingPrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     const auto& repeatOptions = prefs->repeatOptions;
     setElementValue(styleElement, "voltaLineWidth", repeatOptions->bracketLineWidth / EFIX_PER_SPACE);
@@ -834,7 +889,7 @@ void writeRepeatEndingPrefs(XmlElement& styleElement, const MssPreferencesPtr& p
     // setElementValue(styleElement, "voltaAlignEndLeftOfBarline", false);
 }
 
-void writeTupletPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+void writeTupletPrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     using TupletOptions = options::TupletOptions;
     const auto& tupletOptions = prefs->tupletOptions;
@@ -904,7 +959,7 @@ void writeTupletPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
                     -(std::max)(tupletOptions->leftHookLen, tupletOptions->rightHookLen) / EVPU_PER_SPACE); /// or use average
 }
 
-void writeMarkingPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
+void writeMarkingPrefs(StyleElement& styleElement, const MssPreferencesPtr& prefs)
 {
     using FontType = options::FontOptions::FontType;
     using CategoryType = others::MarkingCategory::CategoryType;
@@ -1008,10 +1063,11 @@ void writeMarkingPrefs(XmlElement& styleElement, const MssPreferencesPtr& prefs)
     }
 }
 
-static XmlDocument createMssDocument(const DocumentPtr& document, const DenigmaContext& denigmaContext, const MusxInstance<others::PartDefinition>& part = nullptr)
+static XmlDocument createMssDocument(const DocumentPtr& document, const DenigmaContext& denigmaContext, FontMetricsMemo& fontMetrics,
+                                     const MusxInstance<others::PartDefinition>& part = nullptr)
 {
     const Cmper forPartId = part ? part->getCmper() : 0;
-    auto prefs = getCurrentPrefs(document, forPartId, denigmaContext);
+    auto prefs = getCurrentPrefs(document, forPartId, denigmaContext, fontMetrics);
 
     // extract document to mss
     XmlDocument mssDoc; // output
@@ -1020,7 +1076,7 @@ static XmlDocument createMssDocument(const DocumentPtr& document, const DenigmaC
     declaration.append_attribute("encoding") = "UTF-8";
     auto museScoreElement = mssDoc.append_child("museScore");
     museScoreElement.append_attribute("version") = MSS_VERSION;
-    auto styleElement = museScoreElement.append_child("Style");
+    StyleElement styleElement(museScoreElement.append_child("Style"));
     // write prefs from document
     writePagePrefs(styleElement, prefs);
     writeLyricsPrefs(styleElement, prefs);
@@ -1059,16 +1115,17 @@ static std::filesystem::path resolvePartOutputPath(const std::filesystem::path&
     return qualifiedOutputPath;
 }
 
-static void processPart(const DocumentPtr& document,
-                        const DenigmaContext& denigmaContext,
-                        const MultiOutputCallback& outputCallback,
-                        const MusxInstance<others::PartDefinition>& part = nullptr)
+static std::string createMssText(const DocumentPtr& document,
+                                 const DenigmaContext& denigmaContext,
+                                 FontMetricsMemo& fontMetrics,
+                                 const MusxInstance<others::PartDefinition>& part = nullptr)
 {
-    auto mssDoc = createMssDocument(document, denigmaContext, part);
+    TraceSpan span("createMssText");
+    auto mssDoc = createMssDocument(document, denigmaContext, fontMetrics, part);
+    PhaseTimer serializeTimer(denigmaContext, ConversionStats::Phase::Serialize);
     std::ostringstream output;
     mssDoc.save(output, "    ");
-    const auto data = output.str();
-    outputCallback(partOutputName(denigmaContext, part), std::as_bytes(std::span<const char>(data.data(), data.size())));
+    return std::move(output).str();
 }
 
 void convert(const CommandInputData& inputData,
@@ -1081,9 +1138,24 @@ void convert(const CommandInputData& inputData,
         return;
     }
 
-    auto document = DocumentFactory::create<MusxReader>(inputData.primaryBuffer);
+    const auto xml = inputData.primaryXml();
+    recordSourceCounts(xml, denigmaContext);
+    PhaseTimer buildTimer(denigmaContext, ConversionStats::Phase::BuildDom);
+    auto document = DocumentFactory::create<MusxStylesReader>(xml.data(), xml.size()); // styles need no entries or details
+    buildTimer.stop();
+    convert(document, denigmaContext, outputCallback);
+}
+
+void convert(const DocumentPtr& document,
+             const DenigmaContext& denigmaContext,
+             const MultiOutputCallback& outputCallback)
+{
+    MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+
+    // nullptr stands for the score
+    std::vector<MusxInstance<others::PartDefinition>> outputParts;
     if (denigmaContext.allPartsAndScore || !denigmaContext.partName.has_value()) {
-        processPart(document, denigmaContext, outputCallback); // process the score
+        outputParts.push_back(nullptr);
     }
     bool foundPart = false;
     if (denigmaContext.allPartsAndScore || denigmaContext.partName.has_value()) {
@@ -1091,15 +1163,26 @@ void convert(const CommandInputData& inputData,
         for (const auto& part : parts) {
             if (part->getCmper() != SCORE_PARTID) {
                 if (denigmaContext.allPartsAndScore) {
-                    processPart(document, denigmaContext, outputCallback, part);
+                    outputParts.push_back(part);
                 } else if (denigmaContext.partName->empty() || part->getName().rfind(denigmaContext.partName.value(), 0) == 0) {
-                    processPart(document, denigmaContext, outputCallback, part);
+                    outputParts.push_back(part);
                     foundPart = true;
                     break;
                 }
             }
         }
     }
+
+    // each part builds its own pugixml document from its own preferences, so parts can be built concurrently
+    FontMetricsMemo fontMetrics;
+    forEachInOrder<std::string>(outputParts.size(), denigmaContext,
+        [&](const DenigmaContext& workerContext, std::size_t index) {
+            return createMssText(document, workerContext, fontMetrics, outputParts[index]);
+        },
+        [&](std::size_t index, std::string&& data) {
+            outputCallback(partOutputName(denigmaContext, outputParts[index]), std::move(data));
+        });
+
     if (!foundPart && denigmaContext.partName.has_value() && !denigmaContext.allPartsAndScore) {
         if (denigmaContext.partName->empty()) {
             denigmaContext.logMessage(LogMsg() << "No parts were found in document", MessageSeverity::Warning);
@@ -37,6 +37,9 @@ namespace detail {
 void convert(const CommandInputData& inputData,
              const DenigmaContext& denigmaContext,
              const MultiOutputCallback& outputCallback);
+void convert(const musx::dom::DocumentPtr& document,
+             const DenigmaContext& denigmaContext,
+             const MultiOutputCallback& outputCallback);
 void convert(const std::filesystem::path& file, const CommandInputData& inputData, const DenigmaContext& denigmaContext);
 
 } // namespace detail
@@ -23,7 +23,10 @@
 #include <vector>
 
 #include "core/denigma.h"
+#include "core/musx_reader.h"
+#include "denigma/prepared_document.h"
 #include "formats/enigmaxml/enigmaxml.h"
+#include "formats/enigmaxml/prepared_document.h"
 #include "mss.h"
 #include "utils/stringutils.h"
 
@@ -42,21 +45,16 @@ DenigmaContext makeMssContext(const Options& options, const std::filesystem::pat
     context.noValidate = !options.common.validate;
     context.verbose = options.common.verbose;
     context.quiet = options.common.quiet;
+    context.outputJobs = options.common.outputJobs;
+    context.executor = options.common.executor;
+    context.cancellation = options.common.cancellation;
+    context.deadline = options.common.deadline;
+    context.textMetrics = options.common.textMetrics;
     context.allPartsAndScore = options.allPartsAndScore;
     context.partName = options.partName;
     return context;
 }
 
-Buffer copyBytes(std::span<const std::byte> input)
-{
-    Buffer buffer;
-    buffer.reserve(input.size());
-    for (const std::byte value : input) {
-        buffer.push_back(static_cast<char>(value));
-    }
-    return buffer;
-}
-
 } // namespace
 
 ConversionResult EnigmaXmlToMssXmlMultiOutputConverter::convert(std::span<const std::byte> input,
@@ -64,13 +62,19 @@ ConversionResult EnigmaXmlToMssXmlMultiOutputConverter::convert(std::span<const
                                                                 const Options& options) const
 {
     ConversionResult result;
-    auto buffer = copyBytes(input);
     auto context = makeMssContext(options, "input.enigmaxml");
     context.logCallback = options.common.logCallback;
     context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    const auto countedOutputCallback = stats.countOutputs(outputCallback);
     MusxLoggerScope musxLogger(makeMusxLogCallback(context));
 
-    formats::mss::detail::convert(CommandInputData{ std::move(buffer), std::nullopt, {} }, context, outputCallback);
+    try {
+        formats::mss::detail::convert(CommandInputData::fromBorrowedBytes(input), context, countedOutputCallback);
+    } catch (const ConversionCancelled& ex) {
+        context.logMessage(LogMsg() << "MuseScore style conversion stopped (" << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
     return result;
 }
 
@@ -89,9 +93,18 @@ ConversionResult MusxToMssXmlMultiOutputConverter::convert(const IRandomAccessRe
     auto context = makeMssContext(options, "input.musx");
     context.logCallback = options.common.logCallback;
     context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    const auto countedOutputCallback = stats.countOutputs(outputCallback);
     MusxLoggerScope musxLogger(makeMusxLogCallback(context));
 
-    formats::mss::detail::convert(formats::enigmaxml::detail::extractMusxInputData(input, context), context, outputCallback);
+    try {
+        auto inputData = formats::enigmaxml::detail::extractMusxInputData(input, context);
+        MusxReaderBufferHandoff xmlHandoff(inputData.primaryBuffer); // nothing reads the XML after the DOM is built
+        formats::mss::detail::convert(inputData, context, countedOutputCallback);
+    } catch (const ConversionCancelled& ex) {
+        context.logMessage(LogMsg() << "MuseScore style conversion stopped (" << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
     return result;
 }
 
@@ -102,10 +115,43 @@ ConversionResult MusxToMssXmlMultiOutputConverter::convert(const IRandomAccessRe
     return convert(input, outputCallback, optionsFromRequest<Options>(request, "MusxToMssXmlMultiOutputConverter"));
 }
 
+ConversionResult PreparedDocumentToMssXmlConverter::convert(const PreparedDocument& input,
+                                                            const MultiOutputCallback& outputCallback,
+                                                            const Options& options) const
+{
+    ConversionResult result;
+    auto effectiveOptions = options;
+    if (effectiveOptions.common.sourceName.empty()) {
+        effectiveOptions.common.sourceName = input.impl().sourceName;
+    }
+    auto context = makeMssContext(effectiveOptions, "input.musx");
+    context.logCallback = options.common.logCallback;
+    context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    const auto countedOutputCallback = stats.countOutputs(outputCallback);
+    MusxLoggerScope musxLogger(makeMusxLogCallback(context));
+
+    try {
+        formats::mss::detail::convert(input.impl().document(MusxLoadProfile::Styles, context), context, countedOutputCallback);
+    } catch (const ConversionCancelled& ex) {
+        context.logMessage(LogMsg() << "MuseScore style conversion stopped (" << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
+    return result;
+}
+
+ConversionResult PreparedDocumentToMssXmlConverter::convert(const PreparedDocument& input,
+                                                            const MultiOutputCallback& outputCallback,
+                                                            const ConversionRequest& request) const
+{
+    return convert(input, outputCallback, optionsFromRequest<Options>(request, "PreparedDocumentToMssXmlConverter"));
+}
+
 void registerConverters(ConverterRegistry& registry)
 {
     registry.add(std::make_unique<EnigmaXmlToMssXmlMultiOutputConverter>());
     registry.add(std::make_unique<MusxToMssXmlMultiOutputConverter>());
+    registry.add(std::make_unique<PreparedDocumentToMssXmlConverter>());
 }
 
 } // namespace mss
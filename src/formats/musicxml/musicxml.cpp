@@ -20,15 +20,31 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
 #include <span>
 #include <sstream>
 #include <stdexcept>
+#include <streambuf>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "musicxml.h"
+#include "core/buffer_pool.h"
+#include "core/conversion_arena.h"
 #include "core/musx_reader.h"
+#include "core/parallel.h"
 #include "utils/mathutils.h"
+#include "utils/xml_indent.h"
 
 #include "mx/api/DocumentManager.h"
 #include "mx/api/ScoreData.h"
@@ -53,20 +69,44 @@ std::string mxResultMessage(std::string_view operation, const mx::api::ApiError&
     return result;
 }
 
-void createTiming(const MusicXmlMusxMapping& context, MusicXmlTimingPlan& timing)
+/// Chooses the divisions from every measure and entry duration of the part. The entry frames it builds are kept for
+/// the note pass (see EntryFrameCache::Prebuilt), so the entries are only walked once per conversion.
+void createTiming(MusicXmlMusxMapping& context)
 {
     constexpr int MIN_DIVISIONS_PER_QUARTER = 8;
     int baseDivisions = MIN_DIVISIONS_PER_QUARTER;
-    for (const auto& measure : context.document->getOthers()->getArray<others::Measure>(context.forPartId)) {
+    const auto musxMeasures = context.document->getOthers()->getArray<others::Measure>(context.forPartId);
+    for (const auto& measure : musxMeasures) {
         const auto quarterDuration = measure->calcDuration() * 4;
         baseDivisions = utils::checkedLcm(baseDivisions, quarterDuration.denominator());
     }
-    context.document->iterateEntries(context.forPartId, [&](const EntryInfoPtr& entryInfo) -> bool {
-        auto quarterDuration = entryInfo.calcGlobalActualDuration() * 4;
-        baseDivisions = utils::checkedLcm(baseDivisions, quarterDuration.denominator());
-        return true;
-    });
-    timing.divisions = baseDivisions;
+    auto prebuilt = std::make_shared<EntryFrameCache::Prebuilt>();
+    const auto staves = context.document->getScrollViewStaves(context.forPartId);
+    for (const auto& measure : musxMeasures) {
+        context.denigmaContext->checkCancelled();
+        for (const auto& staffItem : staves) {
+            const StaffCmper staffId = staffItem->staffId;
+            details::GFrameHoldContext gfHold(context.document, context.forPartId, staffId, measure->getCmper(),
+                measure->calcMinLegacyPickupSpacer(staffId));
+            if (!gfHold) {
+                continue;
+            }
+            for (const auto& [layer, numVoice2Entries] : gfHold.calcVoices()) {
+                auto frame = gfHold.createEntryFrame(layer);
+                if (!frame) {
+                    continue;
+                }
+                frame->iterateEntries([&](const EntryInfoPtr& entryInfo) -> bool {
+                    const auto quarterDuration = entryInfo.calcGlobalActualDuration() * 4;
+                    baseDivisions = utils::checkedLcm(baseDivisions, quarterDuration.denominator());
+                    return true;
+                });
+                prebuilt->put(gfHold, layer, std::move(frame));
+            }
+        }
+    }
+    context.timing.setDivisions(baseDivisions);
+    context.entryFrames.setPrebuilt(std::move(prebuilt));
 }
 
 namespace {
@@ -74,20 +114,20 @@ namespace {
 mx::api::ScoreData createMusicXmlDocumentFromDocument(
     const musx::dom::DocumentPtr& document,
     const DenigmaContext& denigmaContext,
+    const DocumentConversionPlan& plan,
     const MusxInstance<others::PartDefinition>& part)
 {
-    auto context = MusicXmlMusxMapping(denigmaContext, document, part ? part->getCmper() : SCORE_PARTID);
-    context.musicXmlScore = std::make_unique<mx::api::ScoreData>();
+    // the score starts from the plan's metadata; everything after it depends on the part
+    auto context = MusicXmlMusxMapping(denigmaContext, document, plan, part ? part->getCmper() : SCORE_PARTID);
 
-    createTiming(context, context.timing);
-    createMetaData(context);
+    createTiming(context);
     createDefaults(context);
     createPageTexts(context);
     createParts(context);
     createMeasures(context);
 
     context.musicXmlScore->sort();
-    return *context.musicXmlScore;
+    return std::move(*context.musicXmlScore); // the mapping is discarded, so hand over the tree rather than copy it
 }
 
 std::string partOutputName(const DenigmaContext& denigmaContext, const MusxInstance<others::PartDefinition>& part)
@@ -103,28 +143,414 @@ std::string partOutputName(const DenigmaContext& denigmaContext, const MusxInsta
     return partName;
 }
 
-void writeMusicXmlToCallback(
-    const mx::api::ScoreData& score,
-    const std::string& suggestedName,
-    const MultiOutputCallback& outputCallback)
+/// @brief Lists what the conversion of a linked part reads through the part's own id: its staves, measures, systems,
+/// pages, page texts, repeat endings, and the entries and notes its voicing keeps.
+///
+/// Two parts with the same inputs convert to the same MusicXML apart from their part names. The part name itself and
+/// the positions of linked items moved only in one part are not listed.
+std::vector<std::int64_t> calcPartConversionInputs(const musx::dom::DocumentPtr& document, Cmper partId)
+{
+    std::vector<std::int64_t> inputs;
+    auto addList = [&](std::size_t count) {
+        inputs.push_back(-1); // separates the lists so that one cannot run into the next
+        inputs.push_back(static_cast<std::int64_t>(count));
+    };
+    const auto pool = document->getOthers();
+
+    const auto scrollView = document->getScrollViewStaves(partId);
+    addList(scrollView.size());
+    for (const auto& item : scrollView) {
+        inputs.push_back(item->staffId);
+    }
+    const auto measures = pool->getArray<others::Measure>(partId);
+    addList(measures.size());
+    for (const auto& measure : measures) {
+        inputs.push_back(measure->getCmper());
+    }
+    const auto systems = pool->getArray<others::StaffSystem>(partId);
+    addList(systems.size());
+    for (const auto& system : systems) {
+        inputs.push_back(system->getCmper());
+        const auto systemStaves = pool->getArray<others::StaffUsed>(partId, system->getCmper());
+        addList(systemStaves.size());
+        for (const auto& item : systemStaves) {
+            inputs.push_back(item->staffId);
+        }
+    }
+    addList(pool->getArray<others::SystemLock>(partId).size());
+    addList(pool->getArray<others::Page>(partId).size());
+    addList(pool->getArray<others::RepeatEndingStart>(partId).size());
+    const auto pageTexts = pool->getArray<others::PageTextAssign>(partId);
+    addList(pageTexts.size());
+    for (const auto& assignment : pageTexts) {
+        const auto textBlock = assignment->getTextBlock();
+        inputs.push_back(assignment->hidden);
+        inputs.push_back(textBlock ? textBlock->getCmper() : -1);
+        inputs.push_back(assignment->calcStartPageNumber(partId).value_or(0));
+        inputs.push_back(assignment->calcEndPageNumber(partId).value_or(0));
+    }
+    inputs.push_back(-1);
+    document->iterateEntries(partId, [&](const EntryInfoPtr& entryInfo) -> bool {
+        const auto entry = entryInfo->getEntry();
+        inputs.push_back(entryInfo.getStaff());
+        inputs.push_back(entryInfo.getMeasure());
+        inputs.push_back(static_cast<std::int64_t>(entryInfo.getLayerIndex()));
+        inputs.push_back(entry->getEntryNumber());
+        std::int64_t voicedNotes = 0;
+        for (size_t noteIndex = 0; noteIndex < entry->notes.size() && noteIndex < 63; ++noteIndex) {
+            if (NoteInfoPtr(entryInfo, noteIndex).calcIsIncludedInVoicing()) {
+                voicedNotes |= std::int64_t(1) << noteIndex;
+            }
+        }
+        inputs.push_back(voicedNotes);
+        return true;
+    });
+    return inputs;
+}
+
+/// For each output part, the index of the first earlier output with the same conversion inputs, or its own index.
+/// The score (nullptr) is never shared, since nothing else reads the score's own records.
+///
+/// Reuse stops at whole outputs. A part is not built as a delta of the score's per-staff results because every
+/// pass reads through the part's id: the entry frames and their EntryInfoPtrs (voicing), the staff composites
+/// (part staff styles), hidden flags and assignment positions. A score result carries the score's id into all of
+/// those, so a patched copy could not be told apart from a wrong one without converting the part anyway.
+std::vector<std::size_t> findDuplicateOutputs(
+    const musx::dom::DocumentPtr& document, const std::vector<MusxInstance<others::PartDefinition>>& outputParts)
+{
+    std::vector<std::size_t> sources(outputParts.size());
+    std::map<std::vector<std::int64_t>, std::size_t> firstWithInputs;
+    for (std::size_t index = 0; index < outputParts.size(); ++index) {
+        sources[index] = index;
+        if (outputParts[index]) {
+            const auto [found, inserted] = firstWithInputs.emplace(calcPartConversionInputs(document, outputParts[index]->getCmper()), index);
+            sources[index] = found->second;
+        }
+    }
+    return sources;
+}
+
+/// Renames a reused part: its part-name credits name the part it was converted from.
+void replacePartName(mx::api::ScoreData& score, const std::string& fromName, const std::string& toName)
+{
+    if (fromName.empty() || fromName == toName) {
+        return;
+    }
+    for (auto& pageText : score.pageTextItems) {
+        if (std::find(pageText.creditTypes.begin(), pageText.creditTypes.end(), "part name") == pageText.creditTypes.end()) {
+            continue;
+        }
+        for (auto pos = pageText.text.find(fromName); pos != std::string::npos; pos = pageText.text.find(fromName, pos + toName.size())) {
+            pageText.text.replace(pos, fromName.size(), toName);
+        }
+    }
+}
+
+/// Stream buffer that hands serialized bytes to an IMultiOutputSink in fixed-size chunks, optionally without the
+/// indentation mx writes.
+class SinkStreamBuf final : public std::streambuf
+{
+public:
+    explicit SinkStreamBuf(IMultiOutputSink& sink, bool compact = false) : m_sink(sink), m_buffer(STREAM_CHUNK_SIZE)
+    {
+        if (compact) {
+            m_stripper.emplace();
+        }
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+
+    /// Flushes any pending bytes and rethrows an exception raised by the sink while writing.
+    void finish()
+    {
+        if (flushPending() && m_stripper) {
+            m_stripped.clear();
+            m_stripper->finish(m_stripped);
+            writeToSink(m_stripped);
+        }
+        if (m_sinkError) {
+            std::rethrow_exception(m_sinkError);
+        }
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!flushPending()) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        return flushPending() ? 0 : -1;
+    }
+
+private:
+    bool flushPending()
+    {
+        if (m_sinkError) {
+            return false;
+        }
+        const auto pending = static_cast<std::size_t>(pptr() - pbase());
+        if (pending > 0) {
+            if (m_stripper) {
+                m_stripped.clear();
+                m_stripper->strip(std::string_view(pbase(), pending), m_stripped);
+                writeToSink(m_stripped);
+            } else {
+                writeToSink(std::string_view(pbase(), pending));
+            }
+        }
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+        return !m_sinkError;
+    }
+
+    void writeToSink(std::string_view data)
+    {
+        if (data.empty() || m_sinkError) {
+            return;
+        }
+        try {
+            m_sink.write(std::as_bytes(std::span<const char>(data.data(), data.size())));
+        } catch (...) {
+            // iostreams swallow exceptions from the buffer, so keep this one for finish()
+            m_sinkError = std::current_exception();
+        }
+    }
+
+    static constexpr std::size_t STREAM_CHUNK_SIZE = 64 * 1024;
+
+    IMultiOutputSink& m_sink;
+    std::vector<char> m_buffer;
+    std::optional<utils::XmlIndentStripper> m_stripper;
+    std::string m_stripped;
+    std::exception_ptr m_sinkError;
+};
+
+/// Collects a streamed document and delivers it to a MultiOutputCallback in one piece.
+class CallbackSink final : public IMultiOutputSink
+{
+public:
+    explicit CallbackSink(const MultiOutputCallback& outputCallback) : m_outputCallback(outputCallback) {}
+
+    bool begin(std::string_view suggestedName) override
+    {
+        m_suggestedName = suggestedName;
+        m_data.clear();
+        return true;
+    }
+
+    void write(std::span<const std::byte> data) override
+    {
+        m_data.append(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+
+    void end() override
+    {
+        m_outputCallback(m_suggestedName, std::exchange(m_data, {}));
+    }
+
+private:
+    const MultiOutputCallback& m_outputCallback;
+    std::string m_suggestedName;
+    std::string m_data;
+};
+
+/// @class MxDocumentSession
+/// @brief Owns one mx document for the duration of a write.
+///
+/// mx::api::DocumentManager is a process-wide singleton whose document table is not safe to touch from several
+/// threads at once. Every call into it goes through this class, which holds a denigma-owned lock for the duration of
+/// each call, so part conversions on worker threads and concurrent serve requests can share it. The document is
+/// destroyed when the session ends, including when writing throws.
+class MxDocumentSession
+{
+public:
+    explicit MxDocumentSession(const mx::api::ScoreData& score)
+    {
+        std::lock_guard<std::mutex> lock(managerMutex());
+        const auto idResult = mx::api::DocumentManager::getInstance().createFromScore(score);
+        if (!idResult.ok()) {
+            throw std::runtime_error(mxResultMessage("createFromScore", idResult.error()));
+        }
+        m_documentId = idResult.value();
+    }
+
+    ~MxDocumentSession()
+    {
+        std::lock_guard<std::mutex> lock(managerMutex());
+        mx::api::DocumentManager::getInstance().destroyDocument(m_documentId);
+    }
+
+    MxDocumentSession(const MxDocumentSession&) = delete;
+    MxDocumentSession& operator=(const MxDocumentSession&) = delete;
+
+    void writeToStream(std::ostream& output) const
+    {
+        std::lock_guard<std::mutex> lock(managerMutex());
+        const auto writeResult = mx::api::DocumentManager::getInstance().writeToStream(m_documentId, output);
+        if (!writeResult.ok()) {
+            throw std::runtime_error(mxResultMessage("writeToStream", writeResult.error()));
+        }
+    }
+
+private:
+    static std::mutex& managerMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    int m_documentId{};
+};
+
+/// Serializes score to sink. The score is consumed: it is released as soon as mx has built its own tree from it,
+/// so that the two trees are not both held while the document is written.
+void writeMusicXmlToSink(mx::api::ScoreData&& score, IMultiOutputSink& sink, const DenigmaContext& denigmaContext)
+{
+    TraceSpan span("writeMusicXmlToSink");
+    PhaseTimer serializeTimer(denigmaContext, ConversionStats::Phase::Serialize);
+    std::exception_ptr writeError;
+    {
+        MxDocumentSession session(score);
+        score = mx::api::ScoreData{};
+        SinkStreamBuf streamBuf(sink, denigmaContext.compactXml);
+        std::ostream output(&streamBuf);
+        try {
+            session.writeToStream(output);
+        } catch (...) {
+            writeError = std::current_exception();
+        }
+        streamBuf.finish();
+    }
+    if (writeError) {
+        std::rethrow_exception(writeError);
+    }
+    sink.end();
+}
+
+/// Serializes score with mx and returns the document text.
+std::string serializeMusicXml(const mx::api::ScoreData& score)
 {
-    auto& documentManager = mx::api::DocumentManager::getInstance();
+    MxDocumentSession session(score);
+    std::ostringstream output(acquireStringBuffer(BufferPool<std::string>::MIN_POOLED_BYTES));
+    session.writeToStream(output);
+    return std::move(output).str();
+}
+
+/// Builds the measures of context's parts one part at a time and streams the document to sink as each is finished.
+///
+/// mx only serializes whole documents, so the score is first written without measures to get everything outside the
+/// part elements, and then each part is written as a one-part document whose part element is spliced in. A part's
+/// measures are released once its text is written, so only one part's tree and text are held at a time. Parts share
+/// no measure data, which is what makes this exact: every note a part's bookkeeping touches is in that part.
+void writeMusicXmlPartwiseToSink(MusicXmlMusxMapping& context, IMultiOutputSink& sink, const DenigmaContext& denigmaContext)
+{
+    TraceSpan span("writeMusicXmlPartwiseToSink");
+    constexpr std::string_view PART_START = "<part id=\"";
+    constexpr std::string_view SCORE_END = "</score-partwise>";
+    auto& score = *context.musicXmlScore;
+
+    auto serialize = [&](const mx::api::ScoreData& document) {
+        PhaseTimer serializeTimer(denigmaContext, ConversionStats::Phase::Serialize);
+        return serializeMusicXml(document);
+    };
+    // the part text of a one-part document, from its part element up to the closing root element
+    auto partText = [&](const std::string& text) {
+        const auto start = text.find(PART_START);
+        const auto end = text.rfind(SCORE_END);
+        if (start == std::string::npos || end == std::string::npos || end < start) {
+            throw std::runtime_error("mx wrote a MusicXML document without the expected part element");
+        }
+        return std::string_view(text).substr(start, end - start);
+    };
 
-    const auto idResult = documentManager.createFromScore(score);
-    if (!idResult.ok()) {
-        throw std::runtime_error(mxResultMessage("createFromScore", idResult.error()));
+    const std::string frame = serialize(score);
+    const auto firstPart = frame.find(PART_START);
+    const auto scoreEnd = frame.rfind(SCORE_END);
+    if (firstPart == std::string::npos || scoreEnd == std::string::npos || scoreEnd < firstPart) {
+        throw std::runtime_error("mx wrote a MusicXML document without the expected part elements");
     }
+    const auto lineStart = frame.rfind('\n', firstPart);
+    const std::string_view indent = lineStart == std::string::npos
+        ? std::string_view()
+        : std::string_view(frame).substr(lineStart + 1, firstPart - lineStart - 1);
+
+    // the one-part documents carry the score's header but none of its part groups, which name other parts
+    mx::api::ScoreData partScore = score;
+    partScore.parts.clear();
+    partScore.partGroups.clear();
 
-    const int documentId = idResult.value();
-    std::ostringstream output;
-    const auto writeResult = documentManager.writeToStream(documentId, output);
-    documentManager.destroyDocument(documentId);
-    if (!writeResult.ok()) {
-        throw std::runtime_error(mxResultMessage("writeToStream", writeResult.error()));
+    std::exception_ptr writeError;
+    SinkStreamBuf streamBuf(sink, denigmaContext.compactXml);
+    std::ostream output(&streamBuf);
+    try {
+        output << std::string_view(frame).substr(0, firstPart);
+        for (size_t partIndex = 0; partIndex < score.parts.size(); ++partIndex) {
+            createMeasures(context, partIndex);
+            partScore.parts.push_back(std::move(score.parts[partIndex]));
+            partScore.sort();
+            std::string text = serialize(partScore);
+            // later parts may still read this part's header, but never its measures
+            score.parts[partIndex] = std::move(partScore.parts.front());
+            score.parts[partIndex].measures = {};
+            partScore.parts.clear();
+            if (partIndex > 0) {
+                output << indent;
+            }
+            output << partText(text);
+            recycleStringBuffer(std::move(text)); // the next part serializes into it
+        }
+        output << std::string_view(frame).substr(scoreEnd);
+    } catch (...) {
+        writeError = std::current_exception();
+    }
+    streamBuf.finish();
+    if (writeError) {
+        std::rethrow_exception(writeError);
     }
+    sink.end();
+}
+
+/// Converts the score or part and streams it to sink one MusicXML part at a time.
+void streamMusicXmlDocumentFromDocument(
+    const musx::dom::DocumentPtr& document,
+    const DenigmaContext& denigmaContext,
+    const DocumentConversionPlan& plan,
+    const MusxInstance<others::PartDefinition>& part,
+    IMultiOutputSink& sink)
+{
+    auto context = MusicXmlMusxMapping(denigmaContext, document, plan, part ? part->getCmper() : SCORE_PARTID);
 
-    const auto data = output.str();
-    outputCallback(suggestedName, std::as_bytes(std::span<const char>(data.data(), data.size())));
+    createTiming(context);
+    createDefaults(context);
+    createPageTexts(context);
+    createParts(context);
+    writeMusicXmlPartwiseToSink(context, sink, denigmaContext);
+}
+
+/// Rough size of the mx tree for one measure of one staff, with its notes and directions. It is set high on purpose:
+/// a false switch to streaming costs only the overlap between parts.
+constexpr std::uint64_t MX_BYTES_PER_MEASURE_STAFF = 8 * 1024;
+
+/// Estimates the peak memory of building outputParts in memory, which holds the trees of as many outputs as are built
+/// at once. The largest output stands in for each of them.
+std::uint64_t estimateInMemoryOutputBytes(const musx::dom::DocumentPtr& document, const DenigmaContext& denigmaContext,
+    const std::vector<MusxInstance<others::PartDefinition>>& outputParts)
+{
+    std::uint64_t largest = 0;
+    for (const auto& part : outputParts) {
+        const Cmper partId = part ? part->getCmper() : SCORE_PARTID;
+        const std::uint64_t measureCount = document->getOthers()->getArray<others::Measure>(partId).size();
+        const std::uint64_t staffCount = document->getScrollViewStaves(partId).size();
+        largest = (std::max)(largest, measureCount * staffCount * MX_BYTES_PER_MEASURE_STAFF);
+    }
+    return largest * resolveJobCount(denigmaContext, outputParts.size());
 }
 
 } // namespace
@@ -134,21 +560,52 @@ mx::api::ScoreData createMusicXmlDocument(
     const DenigmaContext& denigmaContext,
     const MusxInstance<others::PartDefinition>& part)
 {
-    auto document = denigma::createMusxDocument<MusxReader>(inputData, denigmaContext, musx::dom::PartVoicingPolicy::Apply);
-    return createMusicXmlDocumentFromDocument(document, denigmaContext, part);
+    auto document = denigma::createMusxDocument<MusxReader>(inputData, denigmaContext, musx::dom::PartVoicingPolicy::Apply, /*withEmbeddedGraphics*/ false);
+    const DocumentConversionPlan plan(denigmaContext, document);
+    return createMusicXmlDocumentFromDocument(document, denigmaContext, plan, part);
 }
 
 void convert(
     const CommandInputData& inputData,
     const DenigmaContext& denigmaContext,
     const MultiOutputCallback& outputCallback)
+{
+    CallbackSink sink(outputCallback);
+    convert(inputData, denigmaContext, sink);
+}
+
+void convert(
+    const CommandInputData& inputData,
+    const DenigmaContext& denigmaContext,
+    IMultiOutputSink& sink)
 {
     MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
-    auto document = denigma::createMusxDocument<MusxReader>(inputData, denigmaContext, musx::dom::PartVoicingPolicy::Apply);
+    auto document = denigma::createMusxDocument<MusxReader>(inputData, denigmaContext, musx::dom::PartVoicingPolicy::Apply, /*withEmbeddedGraphics*/ false);
+    convert(document, denigmaContext, sink);
+}
+
+void convert(
+    const musx::dom::DocumentPtr& document,
+    const DenigmaContext& denigmaContext,
+    const MultiOutputCallback& outputCallback)
+{
+    CallbackSink sink(outputCallback);
+    convert(document, denigmaContext, sink);
+}
 
+void convert(
+    const musx::dom::DocumentPtr& document,
+    const DenigmaContext& denigmaContext,
+    IMultiOutputSink& sink)
+{
+    MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+    ArenaHighWaterScope arenaHighWater(denigmaContext);
+    ClassificationCacheScope classificationCache(document, denigmaContext);
+
+    // nullptr stands for the score
+    std::vector<MusxInstance<others::PartDefinition>> outputParts;
     if (denigmaContext.allPartsAndScore || !denigmaContext.partName.has_value()) {
-        const auto score = createMusicXmlDocumentFromDocument(document, denigmaContext, nullptr);
-        writeMusicXmlToCallback(score, partOutputName(denigmaContext, nullptr), outputCallback);
+        outputParts.push_back(nullptr);
     }
     bool foundPart = false;
     if (denigmaContext.allPartsAndScore || denigmaContext.partName.has_value()) {
@@ -156,17 +613,116 @@ void convert(
         for (const auto& part : parts) {
             if (part->getCmper() != SCORE_PARTID) {
                 if (denigmaContext.allPartsAndScore) {
-                    const auto partScore = createMusicXmlDocumentFromDocument(document, denigmaContext, part);
-                    writeMusicXmlToCallback(partScore, partOutputName(denigmaContext, part), outputCallback);
+                    outputParts.push_back(part);
                 } else if (denigmaContext.partName->empty() || part->getName().rfind(denigmaContext.partName.value(), 0) == 0) {
-                    const auto partScore = createMusicXmlDocumentFromDocument(document, denigmaContext, part);
-                    writeMusicXmlToCallback(partScore, partOutputName(denigmaContext, part), outputCallback);
+                    outputParts.push_back(part);
                     foundPart = true;
                     break;
                 }
             }
         }
     }
+
+    // computed once here so that the score and each part reuse it rather than rebuilding it
+    const DocumentConversionPlan plan(denigmaContext, document);
+    bool streamParts = denigmaContext.musicXmlStreamParts;
+    if (!streamParts && denigmaContext.memoryBudget != 0) {
+        // the in-memory path is faster, so it is left only for a score whose trees would not fit the budget
+        const std::uint64_t estimate = estimateInMemoryOutputBytes(document, denigmaContext, outputParts);
+        if (estimate > denigmaContext.memoryBudget) {
+            denigmaContext.logMessage(LogMsg() << "Streaming MusicXML parts: their estimated " << estimate
+                << " bytes in memory exceed the memory budget", MessageSeverity::Verbose);
+            streamParts = true;
+        }
+    }
+    if (streamParts) {
+        // each output is built while it is written, so outputs run one after another
+        for (const auto& part : outputParts) {
+            if (sink.begin(partOutputName(denigmaContext, part))) {
+                streamMusicXmlDocumentFromDocument(document, denigmaContext, plan, part, sink);
+            }
+        }
+    } else {
+        // sources[index] is the output whose score output index reuses; only sources are converted
+        std::vector<std::size_t> sources(outputParts.size());
+        if (denigmaContext.musicXmlDedupeParts) {
+            sources = findDuplicateOutputs(document, outputParts);
+        } else {
+            for (std::size_t index = 0; index < sources.size(); ++index) {
+                sources[index] = index;
+            }
+        }
+        std::vector<std::size_t> lastUse(outputParts.size());
+        std::vector<std::size_t> converted;
+        for (std::size_t index = 0; index < sources.size(); ++index) {
+            lastUse[sources[index]] = index;
+            if (sources[index] == index) {
+                converted.push_back(index);
+            } else {
+                denigmaContext.logMessage(LogMsg() << "Reusing the MusicXML of part " << outputParts[sources[index]]->getCmper()
+                    << " for identical part " << outputParts[index]->getCmper(), MessageSeverity::Verbose);
+            }
+        }
+        // a source's score is kept only until its last duplicate is written
+        std::vector<std::optional<mx::api::ScoreData>> retained(outputParts.size());
+        std::size_t nextOutput = 0;
+        auto writeDuplicatesBefore = [&](std::size_t end) {
+            for (; nextOutput < end; ++nextOutput) {
+                const std::size_t source = sources[nextOutput];
+                if (!retained[source]) {
+                    continue; // the source's conversion was skipped, and with it this copy
+                }
+                std::optional<mx::api::ScoreData> score;
+                if (lastUse[source] == nextOutput) {
+                    score.swap(retained[source]);
+                } else {
+                    score = *retained[source];
+                }
+                replacePartName(*score, outputParts[source]->getName(), outputParts[nextOutput]->getName());
+                if (sink.begin(partOutputName(denigmaContext, outputParts[nextOutput]))) {
+                    writeMusicXmlToSink(std::move(*score), sink, denigmaContext);
+                }
+            }
+        };
+        auto writeConverted = [&](std::size_t index, bool wanted, mx::api::ScoreData&& score) {
+            if (lastUse[index] > index) {
+                retained[index] = score;
+            }
+            if (wanted) {
+                writeMusicXmlToSink(std::move(score), sink, denigmaContext);
+            }
+            nextOutput = index + 1;
+        };
+
+        if (resolveJobCount(denigmaContext, converted.size()) <= 1) {
+            for (const std::size_t index : converted) {
+                writeDuplicatesBefore(index);
+                const bool wanted = sink.begin(partOutputName(denigmaContext, outputParts[index]));
+                if (!wanted && lastUse[index] == index) {
+                    nextOutput = index + 1;
+                    continue;
+                }
+                writeConverted(index, wanted, createMusicXmlDocumentFromDocument(document, denigmaContext, plan, outputParts[index]));
+            }
+        } else {
+            // Each part builds its own MusicXmlMusxMapping over the shared document and plan, so the builds can overlap.
+            // Serialization stays on this thread because the sink receives the parts in order; the mx calls themselves
+            // are guarded by MxDocumentSession, so other conversions in this process may write at the same time.
+            // forEachInOrder holds at most outputJobs finished scores, and each is released as soon as it is written.
+            forEachInOrder<mx::api::ScoreData>(converted.size(), denigmaContext,
+                [&](const DenigmaContext& workerContext, std::size_t position) {
+                    return createMusicXmlDocumentFromDocument(document, workerContext, plan, outputParts[converted[position]]);
+                },
+                [&](std::size_t position, mx::api::ScoreData&& score) {
+                    const std::size_t index = converted[position];
+                    writeDuplicatesBefore(index);
+                    const bool wanted = sink.begin(partOutputName(denigmaContext, outputParts[index]));
+                    writeConverted(index, wanted, std::move(score));
+                });
+        }
+        writeDuplicatesBefore(outputParts.size());
+    }
+
     if (!foundPart && denigmaContext.partName.has_value() && !denigmaContext.allPartsAndScore) {
         if (denigmaContext.partName->empty()) {
             denigmaContext.logMessage(LogMsg() << "No parts were found in document", MessageSeverity::Warning);
@@ -174,6 +730,11 @@ void convert(
             denigmaContext.logMessage(LogMsg() << "No part name starting with \"" << denigmaContext.partName.value() << "\" was found", MessageSeverity::Warning);
         }
     }
+    const std::size_t peakArenaBytes = arenaHighWater.highWater().peakBytes();
+    if (denigmaContext.conversionResult) {
+        denigmaContext.conversionResult->setPeakArenaBytes(peakArenaBytes);
+    }
+    denigmaContext.logMessage(LogMsg() << "Peak mapping arena memory: " << peakArenaBytes << " bytes", MessageSeverity::Verbose);
 }
 
 } // namespace detail
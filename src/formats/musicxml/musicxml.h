@@ -66,7 +66,7 @@ inline int musicXmlFloatingAnchorVoiceNumber(size_t staffIndex)
     return floatingAnchorVoiceBase + static_cast<int>(staffIndex) + 1;
 }
 
-MusicXmlPitchContext pitchContextForPart(const MusicXmlMusxMapping& context, const std::string& partId);
+MusicXmlPitchContext pitchContextForPart(const MusicXmlMusxMapping& context, size_t partIndex);
 std::optional<mx::api::SoundID> musicXmlSoundIdFromInstrumentUuid(std::string_view instUuid);
 mx::api::MarkData musicXmlMark(mx::api::MarkType type, musx::dom::VerticalPlacement placement);
 mx::api::MarkType musicXmlFermataType(const classify::articulation::Fermata& fermata);
@@ -79,7 +79,8 @@ mx::api::ScoreData createMusicXmlDocument(
 
 void createDefaults(const MusicXmlMusxMapping& context);
 void createMeasures(MusicXmlMusxMapping& context);
-void createMetaData(const MusicXmlMusxMapping& context);
+void createMeasures(MusicXmlMusxMapping& context, size_t partIndex);
+void createMetaData(mx::api::ScoreData& score, const musx::dom::DocumentPtr& document, const DenigmaContext& denigmaContext);
 void createPageTexts(const MusicXmlMusxMapping& context);
 void createNotesForMeasureStaff(
     MusicXmlMusxMapping& context,
@@ -90,13 +91,16 @@ void createNotesForMeasureStaff(
     size_t measureIndex,
     size_t staffIndex);
 void createParts(MusicXmlMusxMapping& context);
+/// Converts a dynamic expression's runs to directions. They carry no position, staff or voice: the caller applies
+/// those of the assignment.
 std::vector<mx::api::DirectionData> createDynamicExpressionDirections(
     MusicXmlMusxMapping& context,
-    size_t staffIndex,
-    const musx::dom::MusxInstance<musx::dom::others::MeasureExprAssign>& assignment,
     const classify::ExpressionClassification& classification,
-    musx::dom::VerticalPlacement placement,
-    bool isStaffValueSpecified = true);
+    musx::dom::VerticalPlacement placement);
+void indexExpressionAssignments(
+    MusicXmlMusxMapping& context,
+    const musx::dom::MusxInstanceList<musx::dom::others::Measure>& musxMeasures,
+    const std::vector<musx::dom::StaffCmper>& staves);
 void processExpressions(
     MusicXmlMusxMapping& context,
     mx::api::MeasureData& measure,
@@ -134,6 +138,29 @@ void convert(
     const DenigmaContext& denigmaContext,
     const MultiOutputCallback& outputCallback);
 
+/// Same as the callback overload, but each document is serialized straight into sink in chunks.
+/// A document is only generated when sink.begin accepts its suggested name. When
+/// denigmaContext.outputJobs allows more than one job, the score and parts are built concurrently
+/// and a document rejected by sink.begin is discarded after it has been built. With a single output,
+/// the notes of its measures are filled in concurrent measure ranges instead.
+void convert(
+    const CommandInputData& inputData,
+    const DenigmaContext& denigmaContext,
+    IMultiOutputSink& sink);
+
+/// Same as the sink overload, but converts an already parsed document. The document must have been
+/// created with musx::dom::PartVoicingPolicy::Apply.
+void convert(
+    const musx::dom::DocumentPtr& document,
+    const DenigmaContext& denigmaContext,
+    IMultiOutputSink& sink);
+
+/// Callback form of the parsed-document overload.
+void convert(
+    const musx::dom::DocumentPtr& document,
+    const DenigmaContext& denigmaContext,
+    const MultiOutputCallback& outputCallback);
+
 } // namespace detail
 } // namespace musicxml
 } // namespace formats
@@ -49,8 +49,8 @@ mx::api::NoteData* findArpeggioBoundaryNote(
         const auto entry = entryInfo->getEntry();
         const auto findAtIndex = [&](size_t noteIndex) -> mx::api::NoteData* {
             const NoteInfoPtr noteInfo(entryInfo, noteIndex);
-            const auto locationIt = context.noteLocations.find(musicXmlNoteKey(entry->getEntryNumber(), noteInfo->getNoteId()));
-            return locationIt == context.noteLocations.end() ? nullptr : noteDataAt(context, locationIt->second);
+            const auto* location = context.noteLocations.find(musicXmlNoteKey(entry->getEntryNumber(), noteInfo->getNoteId()));
+            return location ? noteDataAt(context, *location) : nullptr;
         };
         if (top) {
             for (size_t noteIndex = entry->notes.size(); noteIndex-- > 0; ) {
@@ -78,7 +78,7 @@ mx::api::NoteData* findArpeggioBoundaryNote(
 
 void appendArpeggioCandidate(MusicXmlMusxMapping& context, const ArpeggioSpanCandidate& candidate)
 {
-    if (context.deferredArpeggioCandidateKeys.emplace(candidate.key()).second) {
+    if (context.deferredArpeggioCandidateKeys.emplace(arpeggioSpanKey(candidate)).second) {
         context.deferredArpeggioCandidates.emplace_back(candidate);
     }
 }
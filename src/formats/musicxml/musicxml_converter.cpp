@@ -22,11 +22,19 @@
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "core/denigma.h"
+#include "core/musx_reader.h"
+#include "denigma/prepared_document.h"
 #include "formats/enigmaxml/enigmaxml.h"
+#include "formats/enigmaxml/prepared_document.h"
 #include "musicxml.h"
+#include "utils/text_escape.h"
+#include "utils/ziputils.h"
 
 namespace denigma {
 namespace formats {
@@ -34,16 +42,6 @@ namespace musicxml {
 
 namespace {
 
-Buffer copyBytes(std::span<const std::byte> input)
-{
-    Buffer buffer;
-    buffer.reserve(input.size());
-    for (const std::byte value : input) {
-        buffer.push_back(static_cast<char>(value));
-    }
-    return buffer;
-}
-
 DenigmaContext makeMusicXmlContext(const Options& options, const std::filesystem::path& defaultSourceName)
 {
     DenigmaContext context("denigma");
@@ -53,9 +51,20 @@ DenigmaContext makeMusicXmlContext(const Options& options, const std::filesystem
     context.noValidate = !options.common.validate;
     context.verbose = options.common.verbose;
     context.quiet = options.common.quiet;
+    context.outputJobs = options.common.outputJobs;
+    context.executor = options.common.executor;
+    context.cancellation = options.common.cancellation;
+    context.deadline = options.common.deadline;
+    context.textMetrics = options.common.textMetrics;
+    context.memoryResource = options.common.memoryResource;
     context.includeTempoTool = options.includeTempoTool;
     context.allPartsAndScore = options.allPartsAndScore;
     context.partName = options.partName;
+    context.measureRange = options.measureRange;
+    context.staffFilter = options.staffFilter;
+    context.musicXmlStreamParts = options.streamParts;
+    context.musicXmlDedupeParts = options.dedupeParts;
+    context.compactXml = !options.prettyPrint;
     return context;
 }
 
@@ -66,17 +75,19 @@ ConversionResult EnigmaXmlToMusicXmlMultiOutputConverter::convert(std::span<cons
                                                                    const Options& options) const
 {
     ConversionResult result;
-    auto buffer = copyBytes(input);
     auto context = makeMusicXmlContext(options, "input.enigmaxml");
     context.logCallback = options.common.logCallback;
     context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    const auto countedOutputCallback = stats.countOutputs(outputCallback);
 
     try {
-        detail::convert(CommandInputData{ std::move(buffer), std::nullopt, {} }, context, outputCallback);
+        detail::convert(CommandInputData::fromBorrowedBytes(input), context, countedOutputCallback);
     } catch (const std::exception& ex) {
         context.logMessage(LogMsg() << "unable to convert Enigma XML to MusicXML", MessageSeverity::Error);
         context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
     }
+    stats.finish();
     return result;
 }
 
@@ -87,6 +98,34 @@ ConversionResult EnigmaXmlToMusicXmlMultiOutputConverter::convert(std::span<cons
     return convert(input, outputCallback, optionsFromRequest<Options>(request, "EnigmaXmlToMusicXmlMultiOutputConverter"));
 }
 
+ConversionResult EnigmaXmlToMusicXmlMultiOutputConverter::convert(std::span<const std::byte> input,
+                                                                   IMultiOutputSink& sink,
+                                                                   const Options& options) const
+{
+    ConversionResult result;
+    auto context = makeMusicXmlContext(options, "input.enigmaxml");
+    context.logCallback = options.common.logCallback;
+    context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    auto& countedSink = stats.countOutputs(sink);
+
+    try {
+        detail::convert(CommandInputData::fromBorrowedBytes(input), context, countedSink);
+    } catch (const std::exception& ex) {
+        context.logMessage(LogMsg() << "unable to convert Enigma XML to MusicXML", MessageSeverity::Error);
+        context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
+    return result;
+}
+
+ConversionResult EnigmaXmlToMusicXmlMultiOutputConverter::convert(std::span<const std::byte> input,
+                                                                   IMultiOutputSink& sink,
+                                                                   const ConversionRequest& request) const
+{
+    return convert(input, sink, optionsFromRequest<Options>(request, "EnigmaXmlToMusicXmlMultiOutputConverter"));
+}
+
 ConversionResult MusxToMusicXmlMultiOutputConverter::convert(const IRandomAccessReader& input,
                                                               const MultiOutputCallback& outputCallback,
                                                               const Options& options) const
@@ -95,13 +134,18 @@ ConversionResult MusxToMusicXmlMultiOutputConverter::convert(const IRandomAccess
     auto context = makeMusicXmlContext(options, "input.musx");
     context.logCallback = options.common.logCallback;
     context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    const auto countedOutputCallback = stats.countOutputs(outputCallback);
 
     try {
-        detail::convert(formats::enigmaxml::detail::extractMusxInputData(input, context), context, outputCallback);
+        auto inputData = formats::enigmaxml::detail::extractMusxInputData(input, context);
+        MusxReaderBufferHandoff xmlHandoff(inputData.primaryBuffer); // nothing reads the XML after the DOM is built
+        detail::convert(inputData, context, countedOutputCallback);
     } catch (const std::exception& ex) {
         context.logMessage(LogMsg() << "unable to convert MUSX to MusicXML", MessageSeverity::Error);
         context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
     }
+    stats.finish();
     return result;
 }
 
@@ -112,10 +156,154 @@ ConversionResult MusxToMusicXmlMultiOutputConverter::convert(const IRandomAccess
     return convert(input, outputCallback, optionsFromRequest<Options>(request, "MusxToMusicXmlMultiOutputConverter"));
 }
 
+ConversionResult MusxToMusicXmlMultiOutputConverter::convert(const IRandomAccessReader& input,
+                                                              IMultiOutputSink& sink,
+                                                              const Options& options) const
+{
+    ConversionResult result;
+    auto context = makeMusicXmlContext(options, "input.musx");
+    context.logCallback = options.common.logCallback;
+    context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    auto& countedSink = stats.countOutputs(sink);
+
+    try {
+        auto inputData = formats::enigmaxml::detail::extractMusxInputData(input, context);
+        MusxReaderBufferHandoff xmlHandoff(inputData.primaryBuffer); // nothing reads the XML after the DOM is built
+        detail::convert(inputData, context, countedSink);
+    } catch (const std::exception& ex) {
+        context.logMessage(LogMsg() << "unable to convert MUSX to MusicXML", MessageSeverity::Error);
+        context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
+    return result;
+}
+
+ConversionResult MusxToMusicXmlMultiOutputConverter::convert(const IRandomAccessReader& input,
+                                                              IMultiOutputSink& sink,
+                                                              const ConversionRequest& request) const
+{
+    return convert(input, sink, optionsFromRequest<Options>(request, "MusxToMusicXmlMultiOutputConverter"));
+}
+
+ConversionResult PreparedDocumentToMusicXmlConverter::convert(const PreparedDocument& input,
+                                                               const MultiOutputCallback& outputCallback,
+                                                               const Options& options) const
+{
+    ConversionResult result;
+    auto effectiveOptions = options;
+    if (effectiveOptions.common.sourceName.empty()) {
+        effectiveOptions.common.sourceName = input.impl().sourceName;
+    }
+    auto context = makeMusicXmlContext(effectiveOptions, "input.musx");
+    context.logCallback = options.common.logCallback;
+    context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    const auto countedOutputCallback = stats.countOutputs(outputCallback);
+
+    try {
+        MusxLoggerScope musxLogger(makeMusxLogCallback(context));
+        const auto document = input.impl().document(musx::dom::PartVoicingPolicy::Apply, context);
+        detail::convert(document, context, countedOutputCallback);
+    } catch (const std::exception& ex) {
+        context.logMessage(LogMsg() << "unable to convert prepared document to MusicXML", MessageSeverity::Error);
+        context.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
+    return result;
+}
+
+ConversionResult PreparedDocumentToMusicXmlConverter::convert(const PreparedDocument& input,
+                                                               const MultiOutputCallback& outputCallback,
+                                                               const ConversionRequest& request) const
+{
+    return convert(input, outputCallback, optionsFromRequest<Options>(request, "PreparedDocumentToMusicXmlConverter"));
+}
+
+struct MxlArchiveSink::Impl
+{
+    explicit Impl(const std::filesystem::path& outputPath)
+        : archive(outputPath), entryStem(utils::pathToString(outputPath.stem()))
+    {
+    }
+
+    Impl(std::string& output, std::string stem)
+        : archive(output), entryStem(std::move(stem))
+    {
+    }
+
+    utils::ZipStreamWriter archive;
+    std::string entryStem;
+    bool wroteContainer{};
+    std::size_t documentCount{};
+};
+
+MxlArchiveSink::MxlArchiveSink(const std::filesystem::path& outputPath)
+    : m_impl(std::make_unique<Impl>(outputPath))
+{
+}
+
+MxlArchiveSink::MxlArchiveSink(std::string& output, std::string entryStem)
+    : m_impl(std::make_unique<Impl>(output, std::move(entryStem)))
+{
+}
+
+MxlArchiveSink::~MxlArchiveSink() = default;
+
+bool MxlArchiveSink::begin(std::string_view suggestedName)
+{
+    std::string entryName = m_impl->entryStem;
+    if (!suggestedName.empty()) {
+        entryName += '.';
+        entryName += suggestedName;
+    }
+    entryName += ".musicxml";
+
+    if (!m_impl->wroteContainer) {
+        const std::string escapedName = utils::xmlEscaped(entryName);
+        static const std::string kMimetype = "application/vnd.recordare.musicxml";
+        const std::string containerXml =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<container>\n"
+            "  <rootfiles>\n"
+            "    <rootfile full-path=\"" + escapedName + "\" media-type=\"application/vnd.recordare.musicxml+xml\"/>\n"
+            "  </rootfiles>\n"
+            "</container>\n";
+        // the MXL spec wants mimetype first and stored, so that the archive can be identified by its leading bytes
+        m_impl->archive.writeEntry("mimetype", kMimetype, 0);
+        m_impl->archive.writeEntry("META-INF/container.xml", containerXml);
+        m_impl->wroteContainer = true;
+    }
+    m_impl->archive.beginEntry(entryName);
+    return true;
+}
+
+void MxlArchiveSink::write(std::span<const std::byte> data)
+{
+    m_impl->archive.write(std::span<const char>(reinterpret_cast<const char*>(data.data()), data.size()));
+}
+
+void MxlArchiveSink::end()
+{
+    m_impl->archive.endEntry();
+    ++m_impl->documentCount;
+}
+
+void MxlArchiveSink::finish()
+{
+    m_impl->archive.close();
+}
+
+std::size_t MxlArchiveSink::documentCount() const
+{
+    return m_impl->documentCount;
+}
+
 void registerConverters(ConverterRegistry& registry)
 {
     registry.add(std::make_unique<EnigmaXmlToMusicXmlMultiOutputConverter>());
     registry.add(std::make_unique<MusxToMusicXmlMultiOutputConverter>());
+    registry.add(std::make_unique<PreparedDocumentToMusicXmlConverter>());
 }
 
 } // namespace musicxml
@@ -23,6 +23,7 @@
 #include <array>
 #include <string_view>
 
+#include "core/part_layout.h"
 #include "utils/font_names.h"
 
 using namespace musx::dom;
@@ -83,8 +84,9 @@ void createPageLayoutData(
         context.musicXmlTenthsFromEvpu(pagePrefs.pageWidth, combinedSystemScaling)
     };
 
+    const auto layout = PartLayout::forPart(context.document, context.forPartId);
     bool holdMargins = true;
-    if (const auto firstPage = context.document->getOthers()->get<others::Page>(context.forPartId, 1)) {
+    if (const auto* firstPage = layout->findPage(1)) {
         holdMargins = firstPage->holdMargins;
     }
     const auto pageScaleBackout = holdMargins ? combinedSystemScaling : pagePrefs.calcSystemScaling().toDouble();
@@ -127,7 +129,7 @@ void createSystemLayoutData(
         - (pagePrefs.sysMarginBottom + EVPU_PER_STANDARD_STAFF);
     systemLayout.systemDistance =
         context.musicXmlTenthsFromEvpu(systemDistance, systemScaleBackout);
-    if (const auto firstSystem = context.document->getOthers()->get<others::StaffSystem>(context.forPartId, 1)) {
+    if (const auto* firstSystem = PartLayout::forPart(context.document, context.forPartId)->findSystem(1)) {
         const auto topSystemDistance = -firstSystem->top - firstSystem->distanceToPrev;
         systemLayout.topSystemDistance =
             context.musicXmlTenthsFromEvpu(topSystemDistance, systemScaleBackout);
@@ -39,21 +39,10 @@ namespace detail {
 
 namespace {
 
-mx::api::DirectionData createDynamicDirection(
-    const MusicXmlMusxMapping& context,
-    size_t staffIndex,
-    const MusxInstance<others::MeasureExprAssign>& assignment,
-    VerticalPlacement placement,
-    bool isStaffValueSpecified)
+mx::api::DirectionData createDynamicDirection(VerticalPlacement placement)
 {
     auto direction = mx::api::DirectionData{};
-    direction.tickTimePosition = context.timing.calcNearestMusicXmlDivisions(Fraction::fromEdu(assignment->eduPosition));
     direction.placement = enumConvert<mx::api::Placement>(placement);
-    direction.isStaffValueSpecified = isStaffValueSpecified;
-    if (assignment->layer > 0 || assignment->voice2) {
-        const LayerIndex layer = assignment->layer > 0 ? assignment->layer - 1 : 0;
-        direction.voice = musicXmlVoiceNumber(staffIndex, layer, assignment->voice2 ? 2 : 1);
-    }
     return direction;
 }
 
@@ -78,19 +67,16 @@ std::optional<mx::api::MarkData> createDynamicMark(const classify::dynamics::Mar
 
 std::vector<mx::api::DirectionData> createDynamicExpressionDirections(
     MusicXmlMusxMapping& context,
-    size_t staffIndex,
-    const MusxInstance<others::MeasureExprAssign>& assignment,
     const classify::ExpressionClassification& classification,
-    VerticalPlacement placement,
-    bool isStaffValueSpecified)
+    VerticalPlacement placement)
 {
     std::vector<mx::api::DirectionData> result;
-    mx::api::DirectionData pendingWords = createDynamicDirection(context, staffIndex, assignment, placement, isStaffValueSpecified);
+    mx::api::DirectionData pendingWords = createDynamicDirection(placement);
 
     auto flushPendingWords = [&]() {
         if (!pendingWords.words.empty()) {
             result.emplace_back(std::move(pendingWords));
-            pendingWords = createDynamicDirection(context, staffIndex, assignment, placement, isStaffValueSpecified);
+            pendingWords = createDynamicDirection(placement);
         }
     };
 
@@ -109,7 +95,7 @@ std::vector<mx::api::DirectionData> createDynamicExpressionDirections(
                 continue;
             }
             flushPendingWords();
-            result.emplace_back(createDynamicDirection(context, staffIndex, assignment, placement, isStaffValueSpecified));
+            result.emplace_back(createDynamicDirection(placement));
             result.back().marks.emplace_back(std::move(*mark));
             currentDynamicDirection = &result.back();
         } else if (run.as<classify::expression::GenericText>() || run.as<classify::expression::DynamicQualifier>()) {
@@ -22,9 +22,13 @@
 
 #include "musicxml.h"
 
+#include <cstdint>
 #include <optional>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "denigma/classify/expressions.h"
 #include "musicxml_formatted_text.h"
@@ -60,16 +64,15 @@ void appendTechniquePlayback(mx::api::DirectionData& direction, const classify::
     }
 }
 
-mx::api::DirectionData createExpressionDirection(
+/// Sets the fields of a direction that come from its assignment rather than from the text expression definition.
+void applyExpressionAssignment(
+    mx::api::DirectionData& direction,
     const MusicXmlMusxMapping& context,
     size_t staffIndex,
     const MusxInstance<others::MeasureExprAssign>& assignment,
-    VerticalPlacement placement,
-    bool isStaffValueSpecified = true)
+    bool isStaffValueSpecified)
 {
-    auto direction = mx::api::DirectionData{};
     direction.tickTimePosition = context.timing.calcNearestMusicXmlDivisions(Fraction::fromEdu(assignment->eduPosition));
-    direction.placement = enumConvert<mx::api::Placement>(placement);
     /// @todo When mx::api exposes MusicXML direction system relation, emit standalone
     /// TOP assignments as system="only-top" instead of approximating them by omitting
     /// the explicit staff value.
@@ -78,9 +81,64 @@ mx::api::DirectionData createExpressionDirection(
         const LayerIndex layer = assignment->layer > 0 ? assignment->layer - 1 : 0;
         direction.voice = musicXmlVoiceNumber(staffIndex, layer, assignment->voice2 ? 2 : 1);
     }
+}
+
+mx::api::DirectionData createExpressionDirection(
+    const MusicXmlMusxMapping& context,
+    size_t staffIndex,
+    const MusxInstance<others::MeasureExprAssign>& assignment,
+    VerticalPlacement placement,
+    bool isStaffValueSpecified = true)
+{
+    auto direction = mx::api::DirectionData{};
+    direction.placement = enumConvert<mx::api::Placement>(placement);
+    applyExpressionAssignment(direction, context, staffIndex, assignment, isStaffValueSpecified);
     return direction;
 }
 
+/// Calls visit with each text the directions of classification are converted from.
+template <typename Visit>
+void forEachExpressionSourceText(const classify::ExpressionClassification& classification, Visit&& visit)
+{
+    for (const auto& run : classification.runs) {
+        visit(run.chunk.text);
+    }
+    if (classification.type == classify::ExpressionType::RehearsalMark) {
+        visit(classification.rehearsalMark().text);
+    }
+}
+
+/// Returns the directions build converts from classification, which must not depend on the assignment. They are
+/// converted once per definition, type and placement, and again only if the classified text differs, as text with
+/// inserts can. The caller applies the assignment with applyExpressionAssignment.
+template <typename Build>
+std::vector<mx::api::DirectionData> cachedExpressionDirections(
+    MusicXmlMusxMapping& context,
+    const MusxInstance<others::MeasureExprAssign>& assignment,
+    const classify::ExpressionClassification& classification,
+    VerticalPlacement placement,
+    Build&& build)
+{
+    const std::uint64_t key = (std::uint64_t(static_cast<std::uint8_t>(classification.type)) << 40)
+        | (std::uint64_t(static_cast<std::uint8_t>(placement)) << 32) | std::uint64_t(assignment->textExprId);
+    auto [it, inserted] = context.expressionPrototypes.try_emplace(key);
+    auto& prototype = it->second;
+    bool sameSource = !inserted;
+    size_t index = 0;
+    forEachExpressionSourceText(classification, [&](const std::string& text) {
+        sameSource = sameSource && index < prototype.sourceText.size() && prototype.sourceText[index] == text;
+        ++index;
+    });
+    if (!sameSource || index != prototype.sourceText.size()) {
+        prototype.sourceText.clear();
+        forEachExpressionSourceText(classification, [&](const std::string& text) {
+            prototype.sourceText.push_back(text);
+        });
+        prototype.directions = std::forward<Build>(build)();
+    }
+    return prototype.directions;
+}
+
 bool isTopStaffAssignment(const MusxInstance<others::MeasureExprAssign>& assignment)
 {
     return assignment->staffAssign == static_cast<StaffCmper>(others::StaffList::FloatingValues::TopStaff);
@@ -123,7 +181,8 @@ std::optional<mx::api::DirectionData> createTempoExpressionDirection(
 {
     auto direction = createExpressionDirection(context, staffIndex, assignment, placement, isStaffValueSpecified);
     if (classification.enigmaCtx) {
-        direction.words = musicXmlWordsFromEnigmaText(context, *classification.enigmaCtx);
+        direction.words = cachedMusicXmlWordsFromEnigmaText(context, MusicXmlTextSource::TextExpression,
+            assignment->textExprId, *classification.enigmaCtx);
     }
     const auto enclosure = enclosureForTextExpression(assignment);
     for (auto& words : direction.words) {
@@ -152,7 +211,8 @@ std::optional<mx::api::DirectionData> createWordsExpressionDirection(
 {
     auto direction = createExpressionDirection(context, staffIndex, assignment, placement, isStaffValueSpecified);
     if (classification.enigmaCtx) {
-        direction.words = musicXmlWordsFromEnigmaText(context, *classification.enigmaCtx);
+        direction.words = cachedMusicXmlWordsFromEnigmaText(context, MusicXmlTextSource::TextExpression,
+            assignment->textExprId, *classification.enigmaCtx);
     }
     const auto enclosure = enclosureForTextExpression(assignment);
     for (auto& words : direction.words) {
@@ -164,15 +224,15 @@ std::optional<mx::api::DirectionData> createWordsExpressionDirection(
     return direction;
 }
 
-std::optional<mx::api::DirectionData> createRehearsalExpressionDirection(
+/// Converts a rehearsal mark expression to a direction without the assignment's position, staff or voice.
+mx::api::DirectionData createRehearsalExpressionDirection(
     MusicXmlMusxMapping& context,
-    size_t staffIndex,
     const MusxInstance<others::MeasureExprAssign>& assignment,
     const classify::ExpressionClassification& classification,
-    VerticalPlacement placement,
-    bool isStaffValueSpecified)
+    VerticalPlacement placement)
 {
-    auto direction = createExpressionDirection(context, staffIndex, assignment, placement, isStaffValueSpecified);
+    auto direction = mx::api::DirectionData{};
+    direction.placement = enumConvert<mx::api::Placement>(placement);
 
     mx::api::RehearsalData rehearsal;
     rehearsal.text = classification.rehearsalMark().text;
@@ -214,6 +274,30 @@ double musicXmlQuarterNotesPerMinute(const classify::expression::TempoInfo& temp
     return static_cast<double>(tempo.beatsPerMinute) * static_cast<double>(tempo.beatUnitEdu) / eduPerQuarterNote;
 }
 
+void indexExpressionAssignments(
+    MusicXmlMusxMapping& context,
+    const MusxInstanceList<others::Measure>& musxMeasures,
+    const std::vector<StaffCmper>& staves)
+{
+    // one pass over each measure's assignments, instead of one pass per staff of the part
+    context.expressionsByMeasureStaff.clear();
+    const std::unordered_set<StaffCmper> partStaves(staves.begin(), staves.end());
+    for (const auto& musxMeasure : musxMeasures) {
+        if (!musxMeasure->hasExpression) {
+            continue;
+        }
+        for (const auto& assignment : context.measureIndex->get(musxMeasure->getCmper()).expressions) {
+            if (assignment->hidden || !assignment->calcIsAssignedInRequestedPart()) {
+                continue;
+            }
+            const StaffCmper assignedStaffId = assignment->calcAssignedStaffId(false);
+            if (partStaves.contains(assignedStaffId)) {
+                context.expressionsByMeasureStaff[musicXmlMeasureStaffKey(musxMeasure->getCmper(), assignedStaffId)].push_back(assignment);
+            }
+        }
+    }
+}
+
 void processExpressions(
     MusicXmlMusxMapping& context,
     mx::api::MeasureData& measure,
@@ -232,11 +316,11 @@ void processExpressions(
         if (!entryInfo) {
             return nullptr;
         }
-        const auto locationIt = context.entryNumberToFirstNote.find(entryInfo->getEntry()->getEntryNumber());
-        if (locationIt == context.entryNumberToFirstNote.end()) {
+        const auto* firstNote = context.entryNumberToFirstNote.find(entryInfo->getEntry()->getEntryNumber());
+        if (!firstNote) {
             return nullptr;
         }
-        const auto& location = locationIt->second;
+        const auto& location = *firstNote;
         const auto voiceIndex = static_cast<size_t>(location.userVoiceNumber - 1);
         const auto voiceIt = staff.voices.find(int(voiceIndex));
         ASSERT_IF(voiceIt == staff.voices.end()) {
@@ -265,27 +349,19 @@ void processExpressions(
         bool emittedFromTopStaffAssignment{};
     };
 
-    const auto exprAssigns = context.document->getOthers()->getArray<others::MeasureExprAssign>(
-        musxMeasure->getRequestedPartId(), musxMeasure->getCmper());
-    const auto cuePlanIt = context.cueDiscardPlansByMeasureStaff.find(musicXmlMeasureStaffKey(musxMeasure->getCmper(), staffId));
+    const auto measureStaffKey = musicXmlMeasureStaffKey(musxMeasure->getCmper(), staffId);
+    const auto exprAssignsIt = context.expressionsByMeasureStaff.find(measureStaffKey);
+    if (exprAssignsIt == context.expressionsByMeasureStaff.end()) {
+        return;
+    }
+    const auto* cuePlan = context.cueDiscardPlansByMeasureStaff.find(measureStaffKey);
     /// @todo Export harp pedal diagrams here once mx::api exposes a public harp-pedals direction
     /// model. The generated MX core supports `<harp-pedals>`, but the public api layer does not.
     std::unordered_map<int, DirectionGroupTracking> directionGroups;
-    for (const auto& assignment : exprAssigns) {
-        if (assignment->hidden) {
-            continue;
-        }
-        if (!assignment->calcIsAssignedInRequestedPart()) {
-            continue;
-        }
-
-        const StaffCmper assignedStaffId = assignment->calcAssignedStaffId(false);
-        if (assignedStaffId != staffId) {
-            continue;
-        }
-        if (cuePlanIt != context.cueDiscardPlansByMeasureStaff.end()
+    for (const auto& assignment : exprAssignsIt->second) {
+        if (cuePlan
             && assignment->layer > 0
-            && cuePlanIt->second.skipsLayer(assignment->layer - 1)) {
+            && cuePlan->skipsLayer(assignment->layer - 1)) {
             continue;
         }
 
@@ -329,8 +405,12 @@ void processExpressions(
         
         switch (classification.type) {
         case classify::ExpressionType::Dynamic: {
-            const auto directions = createDynamicExpressionDirections(
-                context, staffIndex, assignment, classification, placement, isStaffValueSpecified);
+            auto directions = cachedExpressionDirections(context, assignment, classification, placement, [&]() {
+                return createDynamicExpressionDirections(context, classification, placement);
+            });
+            for (auto& direction : directions) {
+                applyExpressionAssignment(direction, context, staffIndex, assignment, isStaffValueSpecified);
+            }
             if (directions.empty() || groupedDirectionAction == GroupedDirectionAction::None) {
                 break;
             }
@@ -376,8 +456,11 @@ void processExpressions(
             break;
         }
         case classify::ExpressionType::RehearsalMark: {
-            emitGroupedDirection(createRehearsalExpressionDirection(
-                context, staffIndex, assignment, classification, placement, isStaffValueSpecified));
+            auto directions = cachedExpressionDirections(context, assignment, classification, placement, [&]() {
+                return std::vector<mx::api::DirectionData>{ createRehearsalExpressionDirection(context, assignment, classification, placement) };
+            });
+            applyExpressionAssignment(directions.front(), context, staffIndex, assignment, isStaffValueSpecified);
+            emitGroupedDirection(std::move(directions.front()));
             break;
         }
         case classify::ExpressionType::Fermata: {
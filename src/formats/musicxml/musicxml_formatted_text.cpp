@@ -20,6 +20,8 @@
 #include "musicxml_formatted_text.h"
 
 #include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <stdexcept>
 #include <string_view>
 #include <utility>
@@ -60,9 +62,32 @@ std::string_view musicXmlFontFamilyFallbackName(MusicXmlFontFamilyFallback fallb
 
 } // namespace
 
-mx::api::FontData MusicXmlMusxMapping::musicXmlFontDataFromFontInfo(const musx::dom::FontInfo& fontInfo,
+const mx::api::FontData& MusicXmlMusxMapping::musicXmlFontDataFromFontInfo(const musx::dom::FontInfo& fontInfo,
     MusicXmlFontFamilyFallback fallback) const
 {
+    const bool hasPointSize = !fontInfo.getSizeIsPercent() && fontInfo.fontSize > 0;
+    auto staffScaling = 1.0;
+    if (hasPointSize && !fontInfo.absolute) {
+        constexpr auto kUnscaledMmPerStaff = musx::dom::EVPU_PER_STANDARD_STAFF / musx::dom::EVPU_PER_MM;
+        const bool hasInitializedScaling = musicXmlScore && musicXmlScore->defaults.scalingMillimeters > 0.0;
+        ASSERT_IF(!hasInitializedScaling) {
+            throw std::logic_error("MusicXML font conversion requires initialized score scaling for non-absolute font sizes.");
+        }
+        staffScaling = musicXmlScore->defaults.scalingMillimeters / kUnscaledMmPerStaff;
+    }
+
+    // Words and lyrics repeat a handful of fonts, so each descriptor is built once per font, fallback and scaling.
+    const std::uint64_t fontKey = std::uint64_t(static_cast<std::uint16_t>(fontInfo.fontId))
+        | (std::uint64_t(static_cast<std::uint32_t>(fontInfo.fontSize)) << 16)
+        | (std::uint64_t(fontInfo.bold) << 48) | (std::uint64_t(fontInfo.italic) << 49)
+        | (std::uint64_t(fontInfo.underline) << 50) | (std::uint64_t(fontInfo.strikeout) << 51)
+        | (std::uint64_t(fontInfo.absolute) << 52) | (std::uint64_t(fontInfo.getSizeIsPercent()) << 53)
+        | (std::uint64_t(fallback) << 56);
+    const PackedIdKey key{ fontKey, std::bit_cast<std::uint64_t>(staffScaling) };
+    if (const auto it = fontDataByFont.find(key); it != fontDataByFont.end()) {
+        return it->second;
+    }
+
     mx::api::FontData result;
     const auto fontName = fontInfo.getName();
     if (!fontName.empty()) {
@@ -72,16 +97,7 @@ mx::api::FontData MusicXmlMusxMapping::musicXmlFontDataFromFontInfo(const musx::
         result.fontFamily.emplace_back(fallbackName);
     }
 
-    if (!fontInfo.getSizeIsPercent() && fontInfo.fontSize > 0) {
-        constexpr auto kUnscaledMmPerStaff = musx::dom::EVPU_PER_STANDARD_STAFF / musx::dom::EVPU_PER_MM;
-        auto staffScaling = 1.0;
-        if (!fontInfo.absolute) {
-            const bool hasInitializedScaling = musicXmlScore && musicXmlScore->defaults.scalingMillimeters > 0.0;
-            ASSERT_IF(!hasInitializedScaling) {
-                throw std::logic_error("MusicXML font conversion requires initialized score scaling for non-absolute font sizes.");
-            }
-            staffScaling = musicXmlScore->defaults.scalingMillimeters / kUnscaledMmPerStaff;
-        }
+    if (hasPointSize) {
         result.sizeType = mx::api::FontSizeType::point;
         result.sizePoint = static_cast<double>(fontInfo.fontSize) * staffScaling;
     }
@@ -92,7 +108,7 @@ mx::api::FontData MusicXmlMusxMapping::musicXmlFontDataFromFontInfo(const musx::
     result.weight = fontInfo.bold ? mx::api::FontWeight::bold : mx::api::FontWeight::normal;
     result.underline = fontInfo.underline ? 1 : 0;
     result.lineThrough = fontInfo.strikeout ? 1 : 0;
-    return result;
+    return fontDataByFont.emplace(key, std::move(result)).first->second;
 }
 
 void parseMusicXmlFormattedText(const MusicXmlMusxMapping& context, const musx::util::EnigmaParsingContext& text,
@@ -126,28 +142,21 @@ std::optional<mx::api::WordsData> musicXmlWordsFromEnigmaTextChunk(const MusicXm
 }
 
 mx::api::LyricData musicXmlLyricFromSyllable(const MusicXmlMusxMapping& context,
-    const musx::dom::texts::LyricsTextBase& lyricText, size_t syllableIndex, const MusicXmlFormattedTextOptions& options)
+    const IndexedLyricSyllable& syllable, const MusicXmlFormattedTextOptions& options)
 {
-    ASSERT_IF(syllableIndex >= lyricText.syllables.size()) {
-        throw std::out_of_range("MusicXML lyric syllable index is out of range.");
-    }
-
-    const auto& syllable = lyricText.syllables[syllableIndex];
     mx::api::LyricData result;
-    result.text = syllable->syllable;
+    result.text = syllable.styledText;
     result.syllabic = [&] {
-        if (syllable->hasHyphenBefore && syllable->hasHyphenAfter) {
+        if (syllable.hyphenBefore && syllable.hyphenAfter) {
             return mx::api::LyricSyllabic::middle;
-        } else if (syllable->hasHyphenBefore) {
+        } else if (syllable.hyphenBefore) {
             return mx::api::LyricSyllabic::end;
-        } else if (syllable->hasHyphenAfter) {
+        } else if (syllable.hyphenAfter) {
             return mx::api::LyricSyllabic::begin;
         }
         return mx::api::LyricSyllabic::single;
     }();
 
-    auto fontData = mx::api::FontData{};
-    auto foundFont = false;
     const auto matchesDefaultLyricFont = [&](const mx::api::FontData& candidate) {
         if (!context.musicXmlScore) {
             return false;
@@ -159,32 +168,25 @@ mx::api::LyricData musicXmlLyricFromSyllable(const MusicXmlMusxMapping& context,
         }
         return false;
     };
-    result.text.clear();
-    lyricText.iterateStylesForSyllable(syllableIndex, [&](const std::string& chunk, const musx::util::EnigmaStyles& styles) -> bool {
-        result.text += chunk;
-        if (!foundFont) {
-            ASSERT_IF(!styles.font) {
-                throw std::logic_error("MusicXML lyric syllable chunk has no font data.");
-            }
-            fontData = context.musicXmlFontDataFromFontInfo(*styles.font, options.fallback);
-            if (!matchesDefaultLyricFont(fontData)) {
-                result.printData.fontData = fontData;
-            }
-            foundFont = true;
+    if (syllable.font) {
+        const auto& fontData = context.musicXmlFontDataFromFontInfo(*syllable.font, options.fallback);
+        if (!matchesDefaultLyricFont(fontData)) {
+            result.printData.fontData = fontData;
         }
-        return true;
-    });
+    }
     if (options.onChunk) {
         options.onChunk(result.printData.fontData, result.text);
     }
     return result;
 }
 
-std::vector<mx::api::WordsData> musicXmlWordsFromEnigmaText(const MusicXmlMusxMapping& context,
-    const musx::util::EnigmaParsingContext& text, const MusicXmlFormattedTextOptions& options)
+namespace {
+
+/// Converts text to words, reporting in hasInserts whether the text contained any insert.
+std::vector<mx::api::WordsData> wordsFromEnigmaText(const MusicXmlMusxMapping& context,
+    const musx::util::EnigmaParsingContext& text, const MusicXmlFormattedTextOptions& options, bool& hasInserts)
 {
     std::vector<mx::api::WordsData> result;
-    auto parserOptions = options;
     text.parseEnigmaText([&](const std::string& chunkText, const musx::util::EnigmaStyles& styles) -> bool {
         musx::util::EnigmaTextChunk chunk{ chunkText, styles };
         auto words = musicXmlWordsFromEnigmaTextChunk(context, chunk, options);
@@ -196,10 +198,41 @@ std::vector<mx::api::WordsData> musicXmlWordsFromEnigmaText(const MusicXmlMusxMa
             options.onChunk(result.back().fontData, result.back().text);
         }
         return true;
+    }, [&](const std::vector<std::string>&) -> std::optional<std::string> {
+        hasInserts = true;
+        return std::nullopt; // the parser's own substitution
     }, musx::util::EnigmaString::EnigmaParsingOptions(options.accidentalStyle));
     return result;
 }
 
+} // namespace
+
+std::vector<mx::api::WordsData> musicXmlWordsFromEnigmaText(const MusicXmlMusxMapping& context,
+    const musx::util::EnigmaParsingContext& text, const MusicXmlFormattedTextOptions& options)
+{
+    bool hasInserts = false;
+    return wordsFromEnigmaText(context, text, options, hasInserts);
+}
+
+std::vector<mx::api::WordsData> cachedMusicXmlWordsFromEnigmaText(MusicXmlMusxMapping& context, MusicXmlTextSource source,
+    musx::dom::Cmper sourceId, const musx::util::EnigmaParsingContext& text, const MusicXmlFormattedTextOptions& options)
+{
+    if (options.onChunk) {
+        return musicXmlWordsFromEnigmaText(context, text, options);
+    }
+    const std::uint64_t key = (std::uint64_t(source) << 48) | (std::uint64_t(options.fallback) << 40)
+        | (std::uint64_t(options.accidentalStyle) << 32) | std::uint64_t(sourceId);
+    if (const auto it = context.wordsByTextSource.find(key); it != context.wordsByTextSource.end()) {
+        return it->second;
+    }
+    bool hasInserts = false;
+    auto result = wordsFromEnigmaText(context, text, options, hasInserts);
+    if (!hasInserts) {
+        context.wordsByTextSource.emplace(key, result);
+    }
+    return result;
+}
+
 std::optional<MusicXmlPageTextContent> musicXmlPageTextContentFromEnigmaText(const MusicXmlMusxMapping& context,
     const musx::util::EnigmaParsingContext& text, const MusicXmlFormattedTextOptions& options)
 {
@@ -229,7 +262,7 @@ std::optional<MusicXmlPageTextContent> musicXmlPageTextContentFromEnigmaText(con
         if (styles.font->hidden) {
             return true;
         }
-        const auto fontData = context.musicXmlFontDataFromFontInfo(*styles.font, options.fallback);
+        const auto& fontData = context.musicXmlFontDataFromFontInfo(*styles.font, options.fallback);
         if (!foundVisibleFont) {
             result.fontData = fontData;
             foundVisibleFont = true;
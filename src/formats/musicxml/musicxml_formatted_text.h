@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 
+#include "core/lyric_index.h"
 #include "musicxml_mapping.h"
 #include "mx/api/LyricData.h"
 #include "mx/api/PageTextData.h"
@@ -60,13 +61,23 @@ std::optional<mx::api::WordsData> musicXmlWordsFromEnigmaTextChunk(
     const MusicXmlFormattedTextOptions& options = {});
 mx::api::LyricData musicXmlLyricFromSyllable(
     const MusicXmlMusxMapping& context,
-    const musx::dom::texts::LyricsTextBase& lyricText,
-    size_t syllableIndex,
+    const IndexedLyricSyllable& syllable,
     const MusicXmlFormattedTextOptions& options = {});
 std::vector<mx::api::WordsData> musicXmlWordsFromEnigmaText(
     const MusicXmlMusxMapping& context,
     const musx::util::EnigmaParsingContext& text,
     const MusicXmlFormattedTextOptions& options = {});
+/// @brief musicXmlWordsFromEnigmaText for the text of sourceId, converted once per mapping.
+///
+/// Expressions, measure texts and line texts are referenced from many measures. Text with inserts (such as the
+/// part name or a page number) can convert differently at each reference, so it is converted every time, as is
+/// any text converted with an onChunk callback.
+std::vector<mx::api::WordsData> cachedMusicXmlWordsFromEnigmaText(
+    MusicXmlMusxMapping& context,
+    MusicXmlTextSource source,
+    musx::dom::Cmper sourceId,
+    const musx::util::EnigmaParsingContext& text,
+    const MusicXmlFormattedTextOptions& options = {});
 std::optional<MusicXmlPageTextContent> musicXmlPageTextContentFromEnigmaText(
     const MusicXmlMusxMapping& context,
     const musx::util::EnigmaParsingContext& text,
@@ -22,13 +22,12 @@
 
 #include "musicxml.h"
 
-#include <algorithm>
-#include <array>
 #include <optional>
 #include <string_view>
 
 #include "musx/dom/InstrumentUuids.h"
 #include "mx/api/SoundID.h"
+#include "utils/constexpr_string_map.h"
 
 using namespace musx::dom;
 
@@ -41,17 +40,12 @@ namespace {
 
 using SoundID = mx::api::SoundID;
 
-struct InstrumentSoundMapping
-{
-    std::string_view instUuid;
-    SoundID soundId;
-};
-
 } // namespace
 
 std::optional<mx::api::SoundID> musicXmlSoundIdFromInstrumentUuid(std::string_view instUuid)
 {
-    static constexpr auto table = std::to_array<InstrumentSoundMapping>({
+    // Built by the compiler, which also rejects a uuid that is listed twice.
+    static constexpr auto table = utils::makeConstexprStringMap<SoundID>({
         // { uuid::BlankStaff,                     SoundID:: },
         // { uuid::BlankStaff2,                    SoundID:: },
         // { uuid::GrandStaff,                     SoundID:: },
@@ -857,13 +851,10 @@ std::optional<mx::api::SoundID> musicXmlSoundIdFromInstrumentUuid(std::string_vi
         { uuid::Zills,                          SoundID::metalBellsZills },
     });
 
-    const auto iter = std::find_if(table.begin(), table.end(), [instUuid](const InstrumentSoundMapping& item) {
-        return item.instUuid == instUuid;
-    });
-    if (iter == table.end()) {
-        return std::nullopt;
+    if (const auto* soundId = table.find(instUuid)) {
+        return *soundId;
     }
-    return iter->soundId;
+    return std::nullopt;
 }
 
 } // namespace detail
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "denigma/classify/jumps.h"
+#include "core/part_layout.h"
 #include "musicxml_formatted_text.h"
 #include "musx/util/EnigmaString.h"
 #include "mx/api/CodaData.h"
@@ -48,18 +49,6 @@ std::string jumpTargetId(MeasCmper measureId)
     return std::to_string(measureId);
 }
 
-MusxInstance<others::StaffSystem> systemForMeasure(const MusicXmlMusxMapping& context, MeasCmper measureId)
-{
-    MusxInstance<others::StaffSystem> result;
-    for (const auto& system : context.document->getOthers()->getArray<others::StaffSystem>(context.forPartId)) {
-        if (system->startMeas > measureId) {
-            break;
-        }
-        result = system;
-    }
-    return result;
-}
-
 bool shouldEmitJumpForStaff(
     const MusicXmlMusxMapping& context,
     const MusxInstance<others::TextRepeatAssign>& assignment,
@@ -76,12 +65,12 @@ bool shouldEmitJumpForStaff(
         return true;
     }
 
-    const auto system = systemForMeasure(context, assignment->getCmper());
+    const auto* system = PartLayout::forPart(context.document, context.forPartId)->findSystemForMeasure(assignment->getCmper());
     if (!system) {
         return true;
     }
-    const auto systemStaves = context.document->getOthers()->getArray<others::StaffUsed>(context.forPartId, system->getCmper());
-    const auto staff = others::StaffComposite::createCurrent(context.document, context.forPartId, staffId, assignment->getCmper(), 0);
+    const auto systemStaves = context.document->getOthers()->getArray<others::StaffUsed>(context.forPartId, system->id);
+    const auto staff = context.staffComposites.get(context.document, context.forPartId, staffId, assignment->getCmper(), 0);
     return assignment->createStaffListSet().contains(staffId, systemStaves, staff && staff->hideRepeats);
 }
 
@@ -191,8 +180,7 @@ void processJumps(
         return;
     }
 
-    const auto assignments = context.document->getOthers()->getArray<others::TextRepeatAssign>(context.forPartId, musxMeasure->getCmper());
-    for (const auto& assignment : assignments) {
+    for (const auto& assignment : context.measureIndex->get(musxMeasure->getCmper()).textRepeats) {
         if (!shouldEmitJumpForStaff(context, assignment, staffId, staffIndex)) {
             continue;
         }
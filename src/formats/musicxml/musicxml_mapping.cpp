@@ -27,10 +27,16 @@ namespace formats {
 namespace musicxml {
 namespace detail {
 
-MusicXmlPitchContext pitchContextForPart(const MusicXmlMusxMapping& context, const std::string& partId)
+DocumentConversionPlan::DocumentConversionPlan(const DenigmaContext& context, const musx::dom::DocumentPtr& doc)
+    : finaleOptions(loadFinaleOptions(doc))
 {
-    if (const auto it = context.partIdToPitchContext.find(partId); it != context.partIdToPitchContext.end()) {
-        return it->second;
+    createMetaData(metadata, doc, context);
+}
+
+MusicXmlPitchContext pitchContextForPart(const MusicXmlMusxMapping& context, size_t partIndex)
+{
+    if (partIndex < context.partMappings.size()) {
+        return context.partMappings[partIndex].pitchContext;
     }
     return MusicXmlPitchContext::Concert;
 }
@@ -54,11 +60,15 @@ mx::api::NoteData* noteDataAt(MusicXmlMusxMapping& context, const MusicXmlNoteLo
 
 int MusicXmlTimingPlan::calcNearestMusicXmlDivisions(const musx::util::Fraction& wholeNoteFraction) const
 {
+    if (const auto ticks = calcExactTicks(wholeNoteFraction)) {
+        return *ticks;
+    }
     const auto result = wholeNoteFraction * 4 * divisions;
     if (result.denominator() == 1) {
         return result.numerator();
     }
 
+    countHotPath(ConversionStats::HotPath::ApproximateDivisions);
     const auto rounded = std::llround(static_cast<double>(result.numerator()) / static_cast<double>(result.denominator()));
     ASSERT_IF(rounded < (std::numeric_limits<int>::min)() || rounded > (std::numeric_limits<int>::max)()) {
         throw std::overflow_error("MusicXML position is outside the supported integer range.");
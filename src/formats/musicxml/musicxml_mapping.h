@@ -20,25 +20,40 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "core/conversion_arena.h"
+#include "core/conversion_excerpt.h"
 #include "core/cue_layers.h"
 #include "core/denigma.h"
+#include "core/entry_frame_cache.h"
 #include "core/finale_options.h"
+#include "core/measure_index.h"
 #include "core/ottavas.h"
+#include "core/packed_keys.h"
+#include "core/smartshape_index.h"
+#include "core/staff_composite_cache.h"
+#include "core/staff_content_index.h"
+#include "utils/dense_index_set.h"
+#include "utils/sorted_key_table.h"
 #include "musx/musx.h"
 #include "musx/util/Arpeggio.h"
 #include "mx/api/FontData.h"
 #include "mx/api/CurveData.h"
+#include "mx/api/DirectionData.h"
 #include "mx/api/PartData.h"
 #include "mx/api/PartSymbolData.h"
 #include "mx/api/ScoreData.h"
 #include "mx/api/StaffData.h"
+#include "mx/api/WordsData.h"
 
 namespace denigma {
 namespace formats {
@@ -61,6 +76,22 @@ enum class MusicXmlFontFamilyFallback
     Monospace
 };
 
+/// What a text converted to MusicXML words came from. Ids of different sources may coincide.
+enum class MusicXmlTextSource : std::uint8_t
+{
+    TextExpression, ///< a TextExpressionDef
+    MeasureText,    ///< the TextBlock of a measure text assignment
+    LineStartText,  ///< the left-start text of a SmartShapeCustomLine
+    LineEndText     ///< the right-end text of a SmartShapeCustomLine
+};
+
+/// Directions converted from a text expression definition, before any assignment's position, staff or voice is applied.
+struct MusicXmlExpressionPrototype
+{
+    std::vector<std::string> sourceText;               ///< the classified text the directions were converted from
+    std::vector<mx::api::DirectionData> directions;
+};
+
 enum class MusicXmlPitchContext
 {
     Concert,
@@ -70,9 +101,19 @@ enum class MusicXmlPitchContext
 struct MusicXmlTimingPlan
 {
     int divisions{};
+    std::int64_t ticksPerWholeNote{}; ///< 4 * divisions, kept so that conversions can stay in integers
+
+    void setDivisions(int value)
+    {
+        divisions = value;
+        ticksPerWholeNote = std::int64_t(value) * 4;
+    }
 
     int calcMusicXmlDivisions(const musx::util::Fraction& wholeNoteFraction) const
     {
+        if (const auto ticks = calcExactTicks(wholeNoteFraction)) {
+            return *ticks;
+        }
         const auto result = wholeNoteFraction * 4 * divisions;
         if (result.denominator() != 1) {
             throw std::logic_error("MusicXML duration is not representable with the selected divisions.");
@@ -81,6 +122,25 @@ struct MusicXmlTimingPlan
     }
 
     int calcNearestMusicXmlDivisions(const musx::util::Fraction& wholeNoteFraction) const;
+
+private:
+    /// Returns the tick count using integer arithmetic only. This succeeds whenever the fraction's denominator
+    /// divides ticksPerWholeNote, which holds for every duration the divisions were chosen from. Otherwise
+    /// (or if the result would not fit) it returns std::nullopt and the caller falls back to Fraction.
+    std::optional<int> calcExactTicks(const musx::util::Fraction& wholeNoteFraction) const
+    {
+        const std::int64_t denominator = wholeNoteFraction.denominator();
+        if (denominator <= 0 || ticksPerWholeNote % denominator != 0) {
+            return std::nullopt;
+        }
+        const std::int64_t ticksPerUnit = ticksPerWholeNote / denominator;
+        const std::int64_t numerator = wholeNoteFraction.numerator();
+        constexpr std::int64_t maxTicks = (std::numeric_limits<int>::max)();
+        if (ticksPerUnit == 0 || numerator > maxTicks / ticksPerUnit || numerator < -maxTicks / ticksPerUnit) {
+            return std::nullopt;
+        }
+        return static_cast<int>(numerator * ticksPerUnit);
+    }
 };
 
 struct MusicXmlCurrentLocation
@@ -89,7 +149,6 @@ struct MusicXmlCurrentLocation
     musx::dom::StaffCmper staff{};
     musx::dom::LayerIndex layer{};
     int voice{};
-    musx::util::Fraction positionInMeasure;
     OttavaShapeMap ottavasApplicableInMeasure;
 
     void clear()
@@ -98,7 +157,6 @@ struct MusicXmlCurrentLocation
         staff = 0;
         layer = 0;
         voice = 0;
-        positionInMeasure = {};
         ottavasApplicableInMeasure.clear();
     }
 };
@@ -133,6 +191,23 @@ struct MusicXmlNoteLocation
     size_t noteIndex{};
 };
 
+/// Part-level mapping state, kept in the same order as ScoreData::parts.
+struct MusicXmlPartMapping
+{
+    std::vector<musx::dom::StaffCmper> staves;
+    std::optional<mx::api::PartSymbolData> partSymbol;
+    MusicXmlPitchContext pitchContext{ MusicXmlPitchContext::Concert };
+};
+
+inline constexpr std::size_t MUSICXML_NO_PART_INDEX = static_cast<std::size_t>(-1);
+
+/// A SortedKeyTable whose entries live in a mapping's arena.
+template <typename Key, typename Value>
+using MusicXmlNoteTable = utils::SortedKeyTable<Key, Value, std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+
+/// A set of entry numbers whose bits live in a mapping's arena.
+using MusicXmlEntrySet = utils::DenseIndexSet<musx::dom::EntryNumber, std::pmr::polymorphic_allocator<std::uint64_t>>;
+
 inline std::uint64_t musicXmlNoteKey(musx::dom::EntryNumber entryNumber, musx::dom::NoteNumber noteId)
 {
     return (std::uint64_t(entryNumber) << 32) | std::uint64_t(noteId);
@@ -143,41 +218,102 @@ inline std::uint64_t musicXmlMeasureStaffKey(musx::dom::MeasCmper measure, musx:
     return (std::uint64_t(measure) << 32) | std::uint64_t(static_cast<std::uint32_t>(staff));
 }
 
+/// Results that depend only on the document. They are computed once and shared, read-only, by the score
+/// and every part conversion of that document.
+struct DocumentConversionPlan
+{
+    FinaleOptions finaleOptions;
+    mx::api::ScoreData metadata; ///< a score holding only what createMetaData fills in
+
+    DocumentConversionPlan(const DenigmaContext& context, const musx::dom::DocumentPtr& doc);
+};
+
 struct MusicXmlMusxMapping
 {
-    MusicXmlMusxMapping(const DenigmaContext& context, const musx::dom::DocumentPtr& doc, musx::dom::Cmper partId)
-        : denigmaContext(&context),
+    MusicXmlMusxMapping(const DenigmaContext& context, const musx::dom::DocumentPtr& doc,
+        const DocumentConversionPlan& plan, musx::dom::Cmper partId)
+        : arena(context),
+          denigmaContext(&context),
           document(doc),
-          finaleOptions(loadFinaleOptions(doc)),
-          forPartId(partId)
+          finaleOptions(plan.finaleOptions),
+          musicXmlScore(std::make_unique<mx::api::ScoreData>(plan.metadata)),
+          forPartId(partId),
+          measureIndex(std::make_shared<const MeasureIndex>(doc, partId)),
+          ottavaIndex(std::make_shared<const OttavaIndex>(*measureIndex)),
+          smartShapeStarts(std::make_shared<const SmartShapeStartIndex>(*measureIndex)),
+          staffContent(std::make_shared<const StaffContentIndex>(doc, partId)),
+          excerpt(context, doc, partId)
     {
     }
 
+    /// Creates a mapping that fills the notes of a measure range of source's current part on a worker thread.
+    /// It shares source's read-only part state and collects its note bookkeeping for source to merge afterwards.
+    MusicXmlMusxMapping(const DenigmaContext& context, const MusicXmlMusxMapping& source)
+        : arena(context),
+          denigmaContext(&context),
+          document(source.document),
+          finaleOptions(source.finaleOptions),
+          musicXmlScore(std::make_unique<mx::api::ScoreData>()),
+          forPartId(source.forPartId),
+          measureIndex(source.measureIndex),
+          ottavaIndex(source.ottavaIndex),
+          smartShapeStarts(source.smartShapeStarts),
+          staffContent(source.staffContent),
+          excerpt(source.excerpt),
+          currentPart(source.currentPart),
+          currentPartIndex(source.currentPartIndex),
+          timing(source.timing),
+          partMappings(source.partMappings),
+          staffToPartIndex(source.staffToPartIndex),
+          fillsMeasureRange(true)
+    {
+        musicXmlScore->defaults = source.musicXmlScore->defaults;
+        entryFrames.setPrebuilt(source.entryFrames.prebuilt());
+    }
+
+    ConversionArena arena; ///< backs the scratch containers below; declared first so that it outlives them
     const DenigmaContext* denigmaContext;
     musx::dom::DocumentPtr document;
     FinaleOptions finaleOptions;
     std::unique_ptr<mx::api::ScoreData> musicXmlScore;
     musx::dom::Cmper forPartId;
+    std::shared_ptr<const MeasureIndex> measureIndex; ///< measure assignments of forPartId, shared with worker mappings
+    std::shared_ptr<const OttavaIndex> ottavaIndex; ///< carrier ottavas of measureIndex, shared with worker mappings
+    std::shared_ptr<const SmartShapeStartIndex> smartShapeStarts; ///< smart shapes of measureIndex by start, shared with worker mappings
+    std::shared_ptr<const StaffContentIndex> staffContent; ///< measures with frames of each staff of forPartId, shared with worker mappings
+    ConversionExcerpt excerpt; ///< the measures and staves of forPartId being converted; part.measures starts at its first measure
     mx::api::PartData* currentPart{};
+    std::size_t currentPartIndex{}; ///< index of currentPart in ScoreData::parts and partMappings
 
     MusicXmlTimingPlan timing;
     MusicXmlCurrentLocation current;
     MusicXmlLayoutState layout;
 
-    std::unordered_map<musx::dom::StaffCmper, std::string> staffToPartId;
-    std::unordered_map<std::string, std::vector<musx::dom::StaffCmper>> partIdToStaves;
-    std::unordered_map<std::string, mx::api::PartSymbolData> partIdToPartSymbol;
-    std::unordered_map<std::string, MusicXmlPitchContext> partIdToPitchContext;
-    std::unordered_map<musx::dom::EntryNumber, MusicXmlNoteLocation> entryNumberToFirstNote;
-    std::unordered_map<std::uint64_t, MusicXmlNoteLocation> noteLocations;
-    std::unordered_map<std::uint64_t, CueLayerPlan> cueDiscardPlansByMeasureStaff;
-    std::unordered_set<musx::dom::EntryNumber> beamedEntries;
-    std::unordered_set<std::uint64_t> pendingTieStopKeys;
-    std::unordered_set<musx::dom::EntryNumber> processedPseudoLvTieEntries;
-    std::vector<musx::dom::EntryInfoPtr> deferredPseudoLvTieEntries;
-    std::unordered_set<musx::dom::EntryNumber> deferredPseudoLvTieEntryNumbers;
-    std::vector<musx::util::ArpeggioSpanCandidate> deferredArpeggioCandidates;
-    std::unordered_set<std::string> deferredArpeggioCandidateKeys;
+    std::vector<MusicXmlPartMapping> partMappings; ///< indexed like ScoreData::parts
+    std::vector<std::size_t> staffToPartIndex; ///< indexed by staff cmper; MUSICXML_NO_PART_INDEX for unmapped staves
+    /// The note tables are appended while notes are filled and sealed before anything looks them up.
+    MusicXmlNoteTable<musx::dom::EntryNumber, MusicXmlNoteLocation> entryNumberToFirstNote{ &arena };
+    MusicXmlNoteTable<std::uint64_t, MusicXmlNoteLocation> noteLocations{ &arena };
+    MusicXmlNoteTable<std::uint64_t, CueLayerPlan> cueDiscardPlansByMeasureStaff{ &arena };
+    /// Visible expression assignments of the current part, keyed by musicXmlMeasureStaffKey of the staff they are assigned to.
+    std::pmr::unordered_map<std::uint64_t, std::vector<musx::dom::MusxInstance<musx::dom::others::MeasureExprAssign>>> expressionsByMeasureStaff{ &arena };
+    std::pmr::unordered_set<std::uint64_t> pendingTieStopKeys{ &arena };
+    MusicXmlEntrySet processedPseudoLvTieEntries{ &arena };
+    std::pmr::vector<musx::dom::EntryInfoPtr> deferredPseudoLvTieEntries{ &arena };
+    MusicXmlEntrySet deferredPseudoLvTieEntryNumbers{ &arena };
+    std::pmr::vector<musx::util::ArpeggioSpanCandidate> deferredArpeggioCandidates{ &arena };
+    std::pmr::unordered_set<PackedIdKey, PackedIdKeyHash> deferredArpeggioCandidateKeys{ &arena }; ///< arpeggioSpanKey of each deferred candidate
+    mutable StaffCompositeCache staffComposites; ///< composites built for this conversion, shared by every pass
+    EntryFrameCache entryFrames; ///< entry frames of the current part, taken from createTiming's or built by the note pass and read by the later ones
+    bool fillsMeasureRange{}; ///< true for a worker mapping that fills only some of the current part's measures
+    /// Tie-end notes a measure-range worker emitted without seeing their tie start, keyed like pendingTieStopKeys.
+    std::pmr::unordered_map<std::uint64_t, MusicXmlNoteLocation> unmatchedTieStops{ &arena };
+    /// Words already converted from texts without inserts, keyed by source, id and options (see cachedMusicXmlWordsFromEnigmaText).
+    std::pmr::unordered_map<std::uint64_t, std::vector<mx::api::WordsData>> wordsByTextSource{ &arena };
+    /// Directions of text expressions converted once per definition, type and placement (see cachedExpressionDirections).
+    std::pmr::unordered_map<std::uint64_t, MusicXmlExpressionPrototype> expressionPrototypes{ &arena };
+    /// Font descriptors built by musicXmlFontDataFromFontInfo, keyed by font, effects and fallback, then staff scaling.
+    mutable std::pmr::unordered_map<PackedIdKey, mx::api::FontData, PackedIdKeyHash> fontDataByFont{ &arena };
 
     void clearCurrent()
     {
@@ -187,6 +323,8 @@ struct MusicXmlMusxMapping
         entryNumberToFirstNote.clear();
         noteLocations.clear();
         cueDiscardPlansByMeasureStaff.clear();
+        entryFrames.clear();
+        expressionsByMeasureStaff.clear();
         processedPseudoLvTieEntries.clear();
         deferredPseudoLvTieEntries.clear();
         deferredPseudoLvTieEntryNumbers.clear();
@@ -194,8 +332,21 @@ struct MusicXmlMusxMapping
         deferredArpeggioCandidateKeys.clear();
     }
 
+    /// Returns the index of the part that staffId belongs to, or MUSICXML_NO_PART_INDEX.
+    std::size_t partIndexForStaff(musx::dom::StaffCmper staffId) const
+    {
+        const auto index = static_cast<std::size_t>(staffId);
+        return staffId >= 0 && index < staffToPartIndex.size() ? staffToPartIndex[index] : MUSICXML_NO_PART_INDEX;
+    }
+
+    const MusicXmlPartMapping& currentPartMapping() const
+    {
+        return partMappings.at(currentPartIndex);
+    }
+
     double musicXmlTenthsFromEvpu(double evpu, double backoutScaling = 1.0) const;
-    mx::api::FontData musicXmlFontDataFromFontInfo(
+    /// Returns the font descriptor of fontInfo, built on first use and kept for the life of the mapping.
+    const mx::api::FontData& musicXmlFontDataFromFontInfo(
         const musx::dom::FontInfo& fontInfo,
         MusicXmlFontFamilyFallback fallback = MusicXmlFontFamilyFallback::None) const;
 
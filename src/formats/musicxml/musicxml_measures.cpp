@@ -21,17 +21,20 @@
 #include "musicxml_formatted_text.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdlib>
-#include <iomanip>
 #include <optional>
 #include <set>
-#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "denigma/classify/barlines.h"
 #include "denigma/classify/chords.h"
 #include "denigma/classify/clefs.h"
+#include "core/attribute_timeline.h"
+#include "core/parallel.h"
+#include "core/part_layout.h"
 
 #include "mx/api/BarlineData.h"
 #include "mx/api/ClefData.h"
@@ -165,9 +168,13 @@ void assignRepeatEndings(
     const MusicXmlMusxMapping& context,
     mx::api::PartData& part)
 {
+    const auto& excerpt = context.excerpt;
     const auto endingStarts = context.document->getOthers()->getArray<others::RepeatEndingStart>(context.forPartId);
     for (const auto& ending : endingStarts) {
-        const auto measureIndex = static_cast<size_t>(ending->getCmper() - 1);
+        if (!excerpt.includesMeasure(ending->getCmper())) {
+            continue; // an excerpt leaves out endings that start outside it
+        }
+        const auto measureIndex = static_cast<size_t>(ending->getCmper() - excerpt.firstMeasure());
         ASSERT_IF(measureIndex >= part.measures.size()) {
             continue;
         }
@@ -184,7 +191,9 @@ void assignRepeatEndings(
         }
         const auto endingNumber = startBarline.endingNumber;
 
-        const auto endMeasureIndex = static_cast<size_t>(ending->getCmper() + ending->calcEndingLength() - 2);
+        // an ending that runs past the excerpt stops at its last measure
+        const auto endMeasureId = (std::min)(int(ending->getCmper() + ending->calcEndingLength() - 1), int(excerpt.lastMeasure()));
+        const auto endMeasureIndex = static_cast<size_t>(endMeasureId - excerpt.firstMeasure());
         ASSERT_IF(endMeasureIndex >= part.measures.size()) {
             continue;
         }
@@ -226,17 +235,8 @@ std::string musicXmlDecimalText(const Fraction& value)
     }
 
     constexpr int timeSignatureDecimalPlaces = 6;
-    std::ostringstream stream;
-    stream << std::fixed << std::setprecision(timeSignatureDecimalPlaces)
-        << static_cast<double>(value.numerator()) / static_cast<double>(value.denominator());
-    auto result = stream.str();
-    while (!result.empty() && result.back() == '0') {
-        result.pop_back();
-    }
-    if (!result.empty() && result.back() == '.') {
-        result.pop_back();
-    }
-    return result;
+    return utils::NumberText::fixedTrimmed(static_cast<double>(value.numerator()) / static_cast<double>(value.denominator()),
+                                           timeSignatureDecimalPlaces).str();
 }
 
 std::optional<mx::api::TimeFraction> musicXmlTimeFraction(const TimeSignature::TimeSigComponent& componentIn)
@@ -283,9 +283,8 @@ void processTempoChanges(
     }
 
     std::optional<NoteType> tempoUnit;
-    const auto tempoChanges = musxMeasure->getDocument()->getOthers()->getArray<others::TempoChange>(SCORE_PARTID, musxMeasure->getCmper());
     auto& directions = measure.staves.front().directions;
-    for (const auto& tempoChange : tempoChanges) {
+    for (const auto& tempoChange : context.measureIndex->get(musxMeasure->getCmper()).tempoChanges) {
         if (tempoChange->isRelative) {
             continue;
         }
@@ -440,8 +439,14 @@ void assignKeySignatures(
     const MusxInstance<others::Measure>& musxMeasure,
     const std::vector<StaffCmper>& staves,
     MusicXmlPitchContext pitchContext,
+    const AttributeTimeline& timeline,
     std::vector<std::optional<mx::api::KeyData>>& prevKeyData)
 {
+    const bool forceEmit = musxMeasure->showKey == others::Measure::ShowKeySigMode::Always;
+    if (!forceEmit && !timeline.changesAtAnyStaff(AttributeTimeline::Attribute::Key, musxMeasure->getCmper())) {
+        return;
+    }
+
     std::vector<mx::api::KeyData> currentKeyData;
     currentKeyData.reserve(staves.size());
     for (size_t staffIndex = 0; staffIndex < staves.size(); ++staffIndex) {
@@ -454,7 +459,6 @@ void assignKeySignatures(
         currentKeyData.emplace_back(key);
     }
 
-    const bool forceEmit = musxMeasure->showKey == others::Measure::ShowKeySigMode::Always;
     bool shouldEmit = forceEmit;
     /// @note MusicXML <cancel> is intentionally not exported yet. If we need Finale-style
     /// explicit cancellation naturals later, this previous/current key comparison is the
@@ -514,16 +518,21 @@ void assignTimeSignature(
     mx::api::MeasureData& measure,
     const MusxInstance<others::Measure>& musxMeasure,
     const std::vector<StaffCmper>& staves,
+    const AttributeTimeline& timeline,
     std::vector<std::optional<mx::api::TimeChoice>>& prevTimeSigs)
 {
     ASSERT_IF(staves.empty()) {
         return;
     }
+    const bool measureAlwaysShows = musxMeasure->showTime == others::Measure::ShowTimeSigMode::Always;
+    if (!measureAlwaysShows && !timeline.changesAtAnyStaff(AttributeTimeline::Attribute::Time, musxMeasure->getCmper())) {
+        return;
+    }
 
     // Staff-level hiding trumps the measure's show mode: a staff that hides time signatures
     // never shows one, even for ShowTimeSigMode::Always.
     const auto staffHidesTimeSignature = [&](StaffCmper staffId) {
-        const auto staff = others::StaffComposite::createCurrent(context.document, context.forPartId, staffId,
+        const auto staff = context.staffComposites.get(context.document, context.forPartId, staffId,
             musxMeasure->getCmper(), 0);
         if (!staff) {
             return false;
@@ -531,7 +540,6 @@ void assignTimeSignature(
         return context.forPartId == SCORE_PARTID ? staff->hideTimeSigs : staff->hideTimeSigsInParts;
     };
     const bool measureNeverShows = musxMeasure->showTime == others::Measure::ShowTimeSigMode::Never;
-    const bool measureAlwaysShows = musxMeasure->showTime == others::Measure::ShowTimeSigMode::Always;
 
     // The base choices carry only staff-level visibility and drive the measure-to-measure
     // carry-forward comparison. Measure-scoped visibility (Never/Always) is applied only to
@@ -593,10 +601,15 @@ void assignClefs(
     StaffCmper staffId,
     const MusxInstance<others::Measure>& musxMeasure,
     MusicXmlPitchContext pitchContext,
+    bool clefMayChange,
     std::optional<ClefIndex>& prevClefIndex)
 {
+    const bool restatesExcerptClef = context.excerpt.startsMidScore() && musxMeasure->getCmper() == context.excerpt.firstMeasure() && !prevClefIndex;
+    if (!clefMayChange && !restatesExcerptClef) {
+        return;
+    }
     const auto& musxDocument = musxMeasure->getDocument();
-    const auto measureStartStaff = others::StaffComposite::createCurrent(musxDocument, context.forPartId, staffId,
+    const auto measureStartStaff = context.staffComposites.get(musxDocument, context.forPartId, staffId,
         musxMeasure->getCmper(), 0);
     if (!measureStartStaff) {
         context.logMessage(LogMsg() << "No staff information found for staff " << staffId << ".",
@@ -604,6 +617,13 @@ void assignClefs(
         return;
     }
 
+    if (restatesExcerptClef) {
+        // an excerpt restates the clef in effect where it starts
+        const auto clefIndex = measureStartStaff->calcClefIndex(pitchContext == MusicXmlPitchContext::Written);
+        staff.clefs.emplace_back(musicXmlClefFromMusxClef(context.finaleOptions.clefOptions->getClefDef(clefIndex), measureStartStaff));
+        prevClefIndex = clefIndex;
+    }
+
     auto addClef = [&](const others::Staff::ClefChange& clefChange) {
         const auto clefIndex = clefChange.clefIndex;
         const auto location = clefChange.position;
@@ -612,7 +632,7 @@ void assignClefs(
         }
         auto musxStaff = measureStartStaff;
         if (location && clefChange.showClefMode == ShowClefMode::WhenNeeded) {
-            musxStaff = others::StaffComposite::createCurrent(musxDocument, context.forPartId, staffId,
+            musxStaff = context.staffComposites.get(musxDocument, context.forPartId, staffId,
                 musxMeasure->getCmper(), location.calcEduDuration());
         }
         if (!musxStaff) {
@@ -654,21 +674,20 @@ void assignStaffAttributes(
     }
 
     const MeasCmper finaleMeasureId = musxMeasures.back()->getCmper();
-    const auto systems = context.document->getOthers()->getArray<others::StaffSystem>(context.forPartId);
-    const auto systemForMeasure = [&systems](MeasCmper measureId) -> MusxInstance<others::StaffSystem> {
-        MusxInstance<others::StaffSystem> result;
-        for (const auto& system : systems) {
-            if (system->startMeas > measureId) {
-                break;
-            }
-            result = system;
-        }
-        return result;
+    const auto layout = PartLayout::forPart(context.document, context.forPartId);
+    const auto systemForMeasure = [&](MeasCmper measureId) -> MusxInstance<others::StaffSystem> {
+        const auto* system = layout->findSystemForMeasure(measureId);
+        return system ? context.document->getOthers()->get<others::StaffSystem>(context.forPartId, system->id) : nullptr;
     };
 
+    const auto& excerpt = context.excerpt;
+    const MusicPoint excerptStart{ excerpt.firstMeasure(), Fraction{} };
     for (size_t staffIndex = 0; staffIndex < staves.size(); ++staffIndex) {
         const auto staffId = staves[staffIndex];
         std::set<MusicPoint> attributeChanges{ MusicPoint{} };
+        if (excerpt.startsMidScore()) {
+            attributeChanges.emplace(excerptStart); // restates the staff as it is where the excerpt starts
+        }
         if (const auto rawStaff = context.document->getOthers()->get<others::Staff>(context.forPartId, staffId); rawStaff && rawStaff->hasStyles) {
             const auto styleAssigns = context.document->getOthers()->getArray<others::StaffStyleAssign>(context.forPartId, staffId);
             for (const auto& styleAssign : styleAssigns) {
@@ -678,21 +697,20 @@ void assignStaffAttributes(
                 }
             }
         }
-        for (const auto& system : systems) {
-            const auto systemStaves = context.document->getOthers()->getArray<others::StaffUsed>(context.forPartId, system->getCmper());
-            if (systemStaves.getIndexForStaff(staffId).has_value()) {
-                attributeChanges.emplace(system->startMeas, Fraction{});
+        for (const auto& system : layout->getSystems()) {
+            if (system.containsStaff(staffId)) {
+                attributeChanges.emplace(system.startMeas, Fraction{});
             }
         }
 
         int prevStaffLines = music_theory::STANDARD_NUMBER_OF_STAFFLINES;
         std::optional<mx::api::TransposeData> prevTransposition;
         for (const auto& point : attributeChanges) {
-            if (point.measureId <= 0 || size_t(point.measureId) > part.measures.size()) {
+            if (point.measureId <= 0 || !excerpt.includesMeasure(point.measureId)) {
                 continue;
             }
 
-            const auto pointStaff = others::StaffComposite::createCurrent(context.document, context.forPartId, staffId,
+            const auto pointStaff = context.staffComposites.get(context.document, context.forPartId, staffId,
                 point.measureId, point.position.calcEduDuration());
             ASSERT_IF(!pointStaff) {
                 context.logMessage(LogMsg() << "No staff composite found for staff " << staffId
@@ -706,7 +724,7 @@ void assignStaffAttributes(
                     return pointStaff;
                 }
                 if (point.measureId < finaleMeasureId) {
-                    return others::StaffComposite::createCurrent(context.document, context.forPartId, staffId, point.measureId + 1, 0);
+                    return context.staffComposites.get(context.document, context.forPartId, staffId, point.measureId + 1, 0);
                 }
                 return nullptr;
             }();
@@ -714,7 +732,7 @@ void assignStaffAttributes(
             if (measureStartStaff) {
                 // items here can only be changed at start of measure in musicxml/mx::api
                 const auto measureId = measureStartStaff->getMeasureId();
-                auto& measure = part.measures[size_t(measureId - 1)];
+                auto& measure = part.measures[size_t(measureId - excerpt.firstMeasure())];
                 ASSERT_IF(measure.staves.size() != staves.size()) {
                     context.logMessage(LogMsg() << "Measure " << measureId << " in part " << part.uniqueId
                         << " has " << measure.staves.size() << " staves, expected " << staves.size()
@@ -742,10 +760,10 @@ void assignStaffAttributes(
             const auto currentTransposition = createTransposeData(context, pointStaff);
             if (!transposeDataEqualIgnoringStaffAndTick(prevTransposition, currentTransposition)) {
                 const bool initialPointCoveredByPart =
-                    point == MusicPoint{}
+                    (point == MusicPoint{} || (excerpt.startsMidScore() && point == excerptStart))
                     && transposeDataEqualIgnoringStaffAndTick(currentTransposition, part.transposition);
                 if (!initialPointCoveredByPart) {
-                    auto& measure = part.measures[size_t(point.measureId - 1)];
+                    auto& measure = part.measures[size_t(point.measureId - excerpt.firstMeasure())];
                     ASSERT_IF(measure.staves.size() != staves.size()) {
                         context.logMessage(LogMsg() << "Measure " << point.measureId << " in part " << part.uniqueId
                             << " has " << measure.staves.size() << " staves, expected " << staves.size()
@@ -780,7 +798,7 @@ void processMeasureText(
         if (assignment->hidden) {
             continue;
         }
-        const auto currentStaff = others::StaffComposite::createCurrent(
+        const auto currentStaff = context.staffComposites.get(
             context.document, context.forPartId, staffId, musxMeasure->getCmper(), assignment->xDispEdu);
         if (!currentStaff) {
             continue;
@@ -791,14 +809,16 @@ void processMeasureText(
             continue;
         }
 
+        const auto textBlock = assignment->getTextBlock();
         auto direction = mx::api::DirectionData{};
         direction.tickTimePosition = context.timing.calcNearestMusicXmlDivisions(Fraction::fromEdu((std::max)(Edu{}, assignment->xDispEdu)));
-        direction.words = musicXmlWordsFromEnigmaText(context, rawText);
+        direction.words = textBlock
+            ? cachedMusicXmlWordsFromEnigmaText(context, MusicXmlTextSource::MeasureText, textBlock->getCmper(), rawText)
+            : musicXmlWordsFromEnigmaText(context, rawText);
         if (direction.words.empty()) {
             continue;
         }
 
-        const auto textBlock = assignment->getTextBlock();
         const auto horizontalAlignment = textBlock ? enumConvert<mx::api::HorizontalAlignment>(textBlock->justify)
                                                    : mx::api::HorizontalAlignment::unspecified;
         const bool useStandardFrameEnclosure = textBlock && textBlock->shapeId == 0 && textBlock->stdLineThickness > 0;
@@ -863,9 +883,7 @@ void processChords(
         auto chord = mx::api::ChordData{};
         chord.root = enumConvert<mx::api::Step>(root.noteName);
         chord.rootAlter = root.alteration;
-        const auto suffix = assignment->showSuffix
-            ? classify::classifyChordSuffix(assignment->getChordSuffix())
-            : classify::classifyChordSuffix();
+        const auto suffix = classify::classifyChordSuffix(assignment);
         chord.chordKind = suffix.quality
             ? enumConvert<mx::api::ChordKind>(*suffix.quality)
             : mx::api::ChordKind::other;
@@ -936,7 +954,7 @@ void addMeasureNumber(
         }
         if (measureId == musxMeasureNumberRegion->calcFirstDisplayedMeasureId()) {
             const bool partDisplaysMeasureNumbers = std::ranges::any_of(staves, [&](StaffCmper staffId) {
-                const auto staff = others::StaffComposite::createCurrent(
+                const auto staff = context.staffComposites.get(
                     context.document, context.forPartId, staffId, measureId, 0);
                 if (!staff) {
                     context.logMessage(LogMsg() << "Cannot determine measure-number visibility for staff " << staffId
@@ -1000,63 +1018,139 @@ void addMeasureNumber(
     }
 }
 
-void createMeasuresForPart(MusicXmlMusxMapping& context, mx::api::PartData& part)
+/// Measures per range when a part's notes are filled on several threads.
+constexpr std::size_t MEASURES_PER_NOTE_RANGE = 16;
+
+/// Folds the note bookkeeping of a finished measure range into context, in range order.
+void mergeMeasureRange(MusicXmlMusxMapping& context, MusicXmlMusxMapping& rangeContext)
+{
+    // ties that start in earlier ranges stop here; the range could not see their pending stop keys
+    for (const auto& [key, location] : rangeContext.unmatchedTieStops) {
+        if (context.pendingTieStopKeys.erase(key) > 0) {
+            if (auto* note = noteDataAt(context, location)) {
+                note->isTieStop = true;
+            }
+        }
+    }
+    // earlier ranges keep their entries for duplicate keys, which matches the first-wins emplacement of a serial fill
+    // not merge(): the two sets allocate from different arenas
+    context.pendingTieStopKeys.insert(rangeContext.pendingTieStopKeys.begin(), rangeContext.pendingTieStopKeys.end());
+    context.entryNumberToFirstNote.appendFrom(std::move(rangeContext.entryNumberToFirstNote));
+    context.noteLocations.appendFrom(std::move(rangeContext.noteLocations));
+    context.cueDiscardPlansByMeasureStaff.appendFrom(std::move(rangeContext.cueDiscardPlansByMeasureStaff));
+    context.entryFrames.mergeFrom(std::move(rangeContext.entryFrames));
+}
+
+/// Fills the notes of every measure of part. The measures must already exist with their staves.
+///
+/// The only state notes carry across measures is the note bookkeeping (ties and note locations), so when
+/// denigmaContext.outputJobs allows it, ranges of measures are filled concurrently by worker mappings, each
+/// writing only its own measures, and their bookkeeping is merged in measure order. The note tables are sealed
+/// for lookup at the end.
+void fillMeasureNotes(MusicXmlMusxMapping& context, mx::api::PartData& part,
+    const MusxInstanceList<others::Measure>& musxMeasures, const std::vector<StaffCmper>& staves)
+{
+    const std::size_t rangeCount = (musxMeasures.size() + MEASURES_PER_NOTE_RANGE - 1) / MEASURES_PER_NOTE_RANGE;
+    auto fillRange = [&](MusicXmlMusxMapping& rangeContext, std::size_t rangeIndex) {
+        const std::size_t endIndex = (std::min)(musxMeasures.size(), (rangeIndex + 1) * MEASURES_PER_NOTE_RANGE);
+        for (std::size_t measureIndex = rangeIndex * MEASURES_PER_NOTE_RANGE; measureIndex < endIndex; ++measureIndex) {
+            rangeContext.denigmaContext->checkCancelled();
+            auto& measure = part.measures[measureIndex];
+            for (size_t staffIndex = 0; staffIndex < staves.size(); ++staffIndex) {
+                createNotesForMeasureStaff(rangeContext, measure, measure.staves[staffIndex], musxMeasures[measureIndex],
+                    staves[staffIndex], measureIndex, staffIndex);
+            }
+        }
+    };
+
+    if (resolveJobCount(*context.denigmaContext, rangeCount) <= 1) {
+        for (std::size_t rangeIndex = 0; rangeIndex < rangeCount; ++rangeIndex) {
+            fillRange(context, rangeIndex);
+        }
+    } else {
+        forEachInOrder<MusicXmlMusxMappingPtr>(rangeCount, *context.denigmaContext,
+            [&](const DenigmaContext& workerContext, std::size_t rangeIndex) {
+                auto rangeContext = std::make_shared<MusicXmlMusxMapping>(workerContext, context);
+                fillRange(*rangeContext, rangeIndex);
+                return rangeContext;
+            },
+            [&](std::size_t, MusicXmlMusxMappingPtr&& rangeContext) {
+                mergeMeasureRange(context, *rangeContext);
+            });
+    }
+    context.entryNumberToFirstNote.seal();
+    context.noteLocations.seal();
+    context.cueDiscardPlansByMeasureStaff.seal();
+}
+
+void createMeasuresForPart(MusicXmlMusxMapping& context, size_t partIndex)
 {
+    TraceSpan span("createMeasuresForPart");
+    auto& part = context.musicXmlScore->parts[partIndex];
     context.clearCurrent();
     context.currentPart = &part;
+    context.currentPartIndex = partIndex;
 
-    const auto stavesIt = context.partIdToStaves.find(part.uniqueId);
-    if (stavesIt == context.partIdToStaves.end() || stavesIt->second.empty()) {
+    const auto& partMapping = context.partMappings.at(partIndex);
+    const auto& partStaves = partMapping.staves;
+    if (partStaves.empty()) {
         context.logMessage(LogMsg() << "MusicXML part " << part.uniqueId << " is not mapped to any Finale staves.", MessageSeverity::Warning);
         return;
     }
 
-    const auto musxMeasures = context.document->getOthers()->getArray<others::Measure>(context.forPartId);
+    auto musxMeasures = context.document->getOthers()->getArray<others::Measure>(context.forPartId);
+    context.excerpt.restrict(musxMeasures);
     auto scoreStaves = std::vector<StaffCmper>{};
     for (const auto& item : context.document->getScrollViewStaves(context.forPartId)) {
         scoreStaves.emplace_back(item->staffId);
     }
     part.measures.reserve(musxMeasures.size());
-    std::vector<std::optional<mx::api::KeyData>> prevKeyData(stavesIt->second.size());
-    std::vector<std::optional<ClefIndex>> prevClefIndices(stavesIt->second.size());
-    std::vector<std::optional<mx::api::TimeChoice>> prevTimeSigs(stavesIt->second.size());
-    const auto pitchContext = pitchContextForPart(context, part.uniqueId);
+    std::vector<std::optional<mx::api::KeyData>> prevKeyData(partStaves.size());
+    std::vector<std::optional<ClefIndex>> prevClefIndices(partStaves.size());
+    std::vector<std::optional<mx::api::TimeChoice>> prevTimeSigs(partStaves.size());
+    const auto pitchContext = partMapping.pitchContext;
+    const AttributeTimeline attributeTimeline(context.document, context.forPartId, musxMeasures, partStaves);
     for (size_t measureIndex = 0; measureIndex < musxMeasures.size(); ++measureIndex) {
+        context.denigmaContext->checkCancelled();
         const auto& musxMeasure = musxMeasures[measureIndex];
-        const bool isFinalMeasure = measureIndex + 1 == musxMeasures.size();
+        const bool isFinalMeasure = musxMeasure->getCmper() == context.excerpt.measureCount(); // not the last of an excerpt
         auto& measure = part.measures.emplace_back(mx::api::MeasureData{});
         /// @todo Export the matching part-scoped others::MultimeasureRest here by setting
         /// MeasureData::multiMeasureRest once mx::api writes <measure-style><multiple-rest>.
         /// @todo Export effective staff alternate-notation starts/stops here once mx::api exposes
         /// staff-scoped measure styles for measure repeats and slash notation.
-        addMeasureNumber(context, measure, musxMeasure, stavesIt->second, scoreStaves);
-        assignKeySignatures(context, measure, musxMeasure, stavesIt->second, pitchContext, prevKeyData);
-        assignTimeSignature(context, measure, musxMeasure, stavesIt->second, prevTimeSigs);
-        if (const auto partSymbolIt = context.partIdToPartSymbol.find(part.uniqueId); partSymbolIt != context.partIdToPartSymbol.end()) {
-            measure.partSymbol = partSymbolIt->second;
+        addMeasureNumber(context, measure, musxMeasure, partStaves, scoreStaves);
+        assignKeySignatures(context, measure, musxMeasure, partStaves, pitchContext, attributeTimeline, prevKeyData);
+        assignTimeSignature(context, measure, musxMeasure, partStaves, attributeTimeline, prevTimeSigs);
+        if (partMapping.partSymbol) {
+            measure.partSymbol = *partMapping.partSymbol;
         }
 
-        measure.staves.resize(stavesIt->second.size());
-        for (size_t staffIndex = 0; staffIndex < stavesIt->second.size(); ++staffIndex) {
-            const StaffCmper staffId = stavesIt->second[staffIndex];
+        measure.staves.resize(partStaves.size());
+        for (size_t staffIndex = 0; staffIndex < partStaves.size(); ++staffIndex) {
+            const StaffCmper staffId = partStaves[staffIndex];
             auto& staff = measure.staves[staffIndex];
-            assignClefs(context, staff, staffId, musxMeasure, pitchContext, prevClefIndices[staffIndex]);
-            const auto musxStaffAtEnd = others::StaffComposite::createCurrent(context.document, context.forPartId, staffId,
+            assignClefs(context, staff, staffId, musxMeasure, pitchContext,
+                attributeTimeline.changesAt(AttributeTimeline::Attribute::Clef, staffIndex, musxMeasure->getCmper()),
+                prevClefIndices[staffIndex]);
+            const auto musxStaffAtEnd = context.staffComposites.get(context.document, context.forPartId, staffId,
                 musxMeasure->getCmper(), musxMeasure->calcDuration(staffId).calcEduDuration());
             assignBarlines(context, measure, musxMeasure, isFinalMeasure, musxStaffAtEnd);
-            createNotesForMeasureStaff(context, measure, staff, musxMeasure, staffId, measureIndex, staffIndex);
         }
     }
+    fillMeasureNotes(context, part, musxMeasures, partStaves);
 
     assignRepeatEndings(context, part);
-    processSmartShapes(context, musxMeasures, stavesIt->second);
+    processSmartShapes(context, musxMeasures, partStaves);
+    indexExpressionAssignments(context, musxMeasures, partStaves);
 
     for (size_t measureIndex = 0; measureIndex < musxMeasures.size(); ++measureIndex) {
+        context.denigmaContext->checkCancelled();
         const auto& musxMeasure = musxMeasures[measureIndex];
         auto& measure = part.measures[measureIndex];
         processTempoChanges(context, measure, musxMeasure);
-        for (size_t staffIndex = 0; staffIndex < stavesIt->second.size(); ++staffIndex) {
-            const StaffCmper staffId = stavesIt->second[staffIndex];
+        for (size_t staffIndex = 0; staffIndex < partStaves.size(); ++staffIndex) {
+            const StaffCmper staffId = partStaves[staffIndex];
             auto& staff = measure.staves[staffIndex];
             processChords(context, staff, musxMeasure, staffId, pitchContext);
             processMeasureText(context, staff, musxMeasure, staffId);
@@ -1068,18 +1162,23 @@ void createMeasuresForPart(MusicXmlMusxMapping& context, mx::api::PartData& part
     finalizePseudoLvTies(context);
     finalizeArpeggioCandidates(context);
 
-    assignStaffAttributes(context, part, musxMeasures, stavesIt->second);
+    assignStaffAttributes(context, part, musxMeasures, partStaves);
 }
 
 } // namespace
 
 void createMeasures(MusicXmlMusxMapping& context)
 {
-    for (auto& part : context.musicXmlScore->parts) {
-        createMeasuresForPart(context, part);
+    for (size_t partIndex = 0; partIndex < context.musicXmlScore->parts.size(); ++partIndex) {
+        createMeasuresForPart(context, partIndex);
     }
 }
 
+void createMeasures(MusicXmlMusxMapping& context, size_t partIndex)
+{
+    createMeasuresForPart(context, partIndex);
+}
+
 } // namespace detail
 } // namespace musicxml
 } // namespace formats
@@ -145,9 +145,8 @@ mx::api::PositionData pageTextPosition(const MusicXmlMusxMapping& context,
 
 } // namespace
 
-void createMetaData(const MusicXmlMusxMapping& context)
+void createMetaData(mx::api::ScoreData& score, const musx::dom::DocumentPtr& document, const DenigmaContext& denigmaContext)
 {
-    auto& score = *context.musicXmlScore;
     score.encoding.software.push_back(std::string(DENIGMA_NAME) + " " + DENIGMA_VERSION);
     score.encoding.encodingDate = mx::api::EncodingDate::today();
     const auto addSupportedElement = [&score](std::string elementName, bool supported = true) {
@@ -161,13 +160,13 @@ void createMetaData(const MusicXmlMusxMapping& context)
     addSupportedElement("beam");
     addSupportedElement("stem", false);
 
-    if (const auto header = context.document->getHeader()) {
+    if (const auto header = document->getHeader()) {
         if (hasValidDate(header->created)) {
             addMiscellaneousField(score.encoding, "original-creation-date", formatDate(header->created));
         }
     }
 
-    const MusxInstanceList<FileInfoText> fileInfoTexts = context.document->getTexts()->getArray<FileInfoText>();
+    const MusxInstanceList<FileInfoText> fileInfoTexts = document->getTexts()->getArray<FileInfoText>();
     for (const MusxInstance<FileInfoText>& fileInfoText : fileInfoTexts) {
         setFileInfoText(score, fileInfoText->getTextType(), fileInfoTextValue(fileInfoText));
     }
@@ -176,7 +175,7 @@ void createMetaData(const MusicXmlMusxMapping& context)
     addMiscellaneousField(score.encoding, "denigma-version", DENIGMA_VERSION);
     addMiscellaneousField(score.encoding, "denigma-commit", gitCommit());
 
-    const auto& inputFilePath = context.denigmaContext->inputFilePath;
+    const auto& inputFilePath = denigmaContext.inputFilePath;
     const std::u8string sourceFormat = utils::normalizedPathExtension(inputFilePath);
     addMiscellaneousField(score.encoding, "source-format",
         sourceFormat.empty() ? std::string("unknown") : utils::utf8ToString(sourceFormat));
@@ -28,6 +28,7 @@
 #include <vector>
 
 #include "core/cue_layers.h"
+#include "core/lyric_index.h"
 #include "musicxml_formatted_text.h"
 #include "mx/api/DurationData.h"
 #include "mx/api/MarkData.h"
@@ -213,7 +214,7 @@ void applyRestPositionIfNeeded(mx::api::NoteData& rest, const EntryInfoPtr& entr
     if (!entryInfo) {
         return;
     }
-    const auto entry = entryInfo->getEntry();
+    const auto& entry = entryInfo->getEntry();
     if (entry->floatRest || entry->notes.empty()) {
         return;
     }
@@ -230,11 +231,11 @@ void applyRestPositionIfNeeded(mx::api::NoteData& rest, const EntryInfoPtr& entr
 
 MusicXmlPitchContext pitchContextForStaff(const MusicXmlMusxMapping& context, StaffCmper staffId)
 {
-    const auto partIt = context.staffToPartId.find(staffId);
-    if (partIt == context.staffToPartId.end()) {
+    const auto partIndex = context.partIndexForStaff(staffId);
+    if (partIndex == MUSICXML_NO_PART_INDEX) {
         return MusicXmlPitchContext::Written;
     }
-    return pitchContextForPart(context, partIt->second);
+    return pitchContextForPart(context, partIndex);
 }
 
 mx::api::PitchData createPitchData(MusicXmlMusxMapping& context, const NoteInfoPtr& noteInfo, MusicXmlPitchContext pitchContext)
@@ -286,6 +287,9 @@ void applyMusicXmlTies(MusicXmlMusxMapping& context, mx::api::NoteData& note, co
 {
     if (context.pendingTieStopKeys.erase(noteKey(noteInfo)) > 0) {
         note.isTieStop = true;
+    } else if (noteInfo->tieEnd && context.excerpt.startsMidScore()
+               && noteInfo.getEntryInfo().getMeasure() == context.excerpt.firstMeasure()) {
+        note.isTieStop = true; // tied from before the excerpt, so its start was never converted
     }
 
     if (!noteInfo->tieStart) {
@@ -306,7 +310,8 @@ void applyMusicXmlTies(MusicXmlMusxMapping& context, mx::api::NoteData& note, co
 
 void applyLyrics(MusicXmlMusxMapping& context, mx::api::NoteData& note, const EntryInfoPtr& entryInfo)
 {
-    const auto entry = entryInfo->getEntry();
+    const auto& entry = entryInfo->getEntry();
+    const auto lyricIndex = LyricIndex::forDocument(entry->getDocument());
 
     auto applyLyricType = [&](const auto& lyricAssignments) {
         using PtrType = typename std::decay_t<decltype(lyricAssignments)>::value_type;
@@ -314,22 +319,22 @@ void applyLyrics(MusicXmlMusxMapping& context, mx::api::NoteData& note, const En
         static_assert(std::is_base_of_v<details::LyricAssign, T>, "lyricAssignments must contain LyricAssign subtypes");
 
         for (const auto& assignment : lyricAssignments) {
-            const auto lyricText = assignment->getLyricText();
-            if (!lyricText) {
+            const auto syllables = lyricIndex->findText<typename T::TextType>(assignment->lyricNumber);
+            if (!syllables) {
                 continue;
             }
-            if (assignment->syllable == 0 || assignment->syllable > lyricText->syllables.size()) {
+            if (assignment->syllable == 0 || assignment->syllable > syllables->size()) {
                 context.logMessage(LogMsg() << "Layer " << entryInfo.getLayerIndex() + 1
                     << " entry index " << entryInfo.getIndexInFrame() << " has an invalid syllable number ("
                     << assignment->syllable << ").", MessageSeverity::Warning);
                 continue;
             }
 
-            const size_t syllableIndex = size_t(assignment->syllable - 1);
-            auto lyric = musicXmlLyricFromSyllable(context, *lyricText, syllableIndex);
+            const auto& syllable = (*syllables)[size_t(assignment->syllable - 1)];
+            auto lyric = musicXmlLyricFromSyllable(context, syllable);
             /// @todo Check whether Finale exports displayVerseNum by prepending the verse number to lyric text.
             lyric.verseNumber = std::string(T::TextType::XmlNodeName.substr(0, 1)) + std::to_string(assignment->lyricNumber);
-            lyric.hasExtend = assignment->wext != 0 || lyricText->syllables[syllableIndex]->strippedUnderscores > 0;
+            lyric.hasExtend = assignment->wext != 0 || syllable.hasExtender;
             if (assignment->horzOffset != 0) {
                 lyric.positionData.relativeX = context.musicXmlTenthsFromEvpu(assignment->horzOffset);
                 lyric.positionData.isRelativeXSpecified = true;
@@ -419,7 +424,7 @@ mx::api::NoteData createRestData(
     rest.userRequestedVoiceNumber = userVoiceNumber;
 
     if (entryInfo) {
-        const auto entry = entryInfo->getEntry();
+        const auto& entry = entryInfo->getEntry();
         rest.isGrace = entry->graceNote;
         rest.durationData = createDurationData(context, entryInfo, entryIt.getEffectiveActualDuration(/*global*/ true));
     } else {
@@ -458,7 +463,7 @@ void addSyntheticFullMeasureRest(
     size_t staffIndex)
 {
     const int userVoiceNumber = musicXmlVoiceNumber(staffIndex, 0, 1);
-    const auto measureStartStaff = others::StaffComposite::createCurrent(context.document, context.forPartId, staffId, musxMeasure->getCmper(), 0);
+    const auto measureStartStaff = context.staffComposites.get(context.document, context.forPartId, staffId, musxMeasure->getCmper(), 0);
     auto rest = createRestData(context, EntryInfoPtr::InterpretedIterator{}, musxMeasure, measureStartStaff, userVoiceNumber);
 
     auto& voice = staff.voices[userVoiceNumber - 1];
@@ -478,9 +483,9 @@ void appendEntryNotes(
     MusicXmlPitchContext pitchContext)
 {
     const auto& entryInfo = entryIt.getEntryInfo();
-    const auto entry = entryInfo->getEntry();
+    const auto& entry = entryInfo->getEntry();
     auto rememberFirstNote = [&](size_t noteIndex) {
-        context.entryNumberToFirstNote.try_emplace(entry->getEntryNumber(), MusicXmlNoteLocation{
+        context.entryNumberToFirstNote.append(entry->getEntryNumber(), MusicXmlNoteLocation{
             .measureIndex = measureIndex,
             .staffIndex = staffIndex,
             .userVoiceNumber = userVoiceNumber,
@@ -488,7 +493,7 @@ void appendEntryNotes(
         });
     };
     auto rememberExactNote = [&](const NoteInfoPtr& noteInfo, size_t noteIndex) {
-        context.noteLocations.try_emplace(
+        context.noteLocations.append(
             musicXmlNoteKey(entry->getEntryNumber(), noteInfo->getNoteId()),
             MusicXmlNoteLocation{
                 .measureIndex = measureIndex,
@@ -515,6 +520,9 @@ void appendEntryNotes(
             includedNoteIndices.push_back(noteIndex);
         }
     }
+    // every note of the chord shares the entry's position and duration, so they are converted to ticks once
+    const int entryTickPosition = context.timing.calcMusicXmlDivisions(entryIt.getEffectiveElapsedDuration(/*global*/ true));
+    const auto entryDurationData = createDurationData(context, entryInfo, entryIt.getEffectiveActualDuration(/*global*/ true));
     for (size_t includedPosition = 0; includedPosition < includedNoteIndices.size(); ++includedPosition) {
         const size_t noteIndex = includedNoteIndices[includedPosition];
         NoteInfoPtr noteInfo(entryInfo, noteIndex);
@@ -528,18 +536,19 @@ void appendEntryNotes(
                 : mx::api::Bool::no;
         }
         note.userRequestedVoiceNumber = userVoiceNumber;
-        note.tickTimePosition = context.timing.calcMusicXmlDivisions(entryIt.getEffectiveElapsedDuration(/*global*/ true));
-        note.durationData = createDurationData(context, entryInfo, entryIt.getEffectiveActualDuration(/*global*/ true));
+        note.tickTimePosition = entryTickPosition;
+        note.durationData = entryDurationData;
         note.pitchData = createPitchData(context, noteInfo, pitchContext);
-        if (const auto stavesIt = context.partIdToStaves.find(context.currentPart->uniqueId); stavesIt != context.partIdToStaves.end()) {
-            ASSERT_IF(staffIndex >= stavesIt->second.size()) {
+        {
+            const auto& partStaves = context.currentPartMapping().staves;
+            ASSERT_IF(staffIndex >= partStaves.size()) {
                 throw std::logic_error("Containing staff index is outside the current MusicXML part staff list.");
             }
-            const auto containingStaffId = stavesIt->second[staffIndex];
+            const auto containingStaffId = partStaves[staffIndex];
             if (const auto noteStaffId = noteInfo.calcStaff(); noteStaffId != containingStaffId) {
-                const auto noteStaffIt = std::find(stavesIt->second.begin(), stavesIt->second.end(), noteStaffId);
-                if (noteStaffIt != stavesIt->second.end()) {
-                    note.crossStaffIndex = static_cast<int>(std::distance(stavesIt->second.begin(), noteStaffIt));
+                const auto noteStaffIt = std::find(partStaves.begin(), partStaves.end(), noteStaffId);
+                if (noteStaffIt != partStaves.end()) {
+                    note.crossStaffIndex = static_cast<int>(std::distance(partStaves.begin(), noteStaffIt));
                 } else {
                     context.logMessage(LogMsg() << "Cross-staff note in entry " << entry->getEntryNumber()
                         << " points to staff " << noteStaffId << ", which is not included in MusicXML part "
@@ -566,6 +575,15 @@ void appendEntryNotes(
             }
         }
         applyMusicXmlTies(context, note, noteInfo);
+        if (context.fillsMeasureRange && !note.isTieStop && noteInfo->tieEnd) {
+            // the tie may start in an earlier range; the merge resolves it against that range's pending stops
+            context.unmatchedTieStops.try_emplace(noteKey(noteInfo), MusicXmlNoteLocation{
+                .measureIndex = measureIndex,
+                .staffIndex = staffIndex,
+                .userVoiceNumber = userVoiceNumber,
+                .noteIndex = voice.notes.size()
+            });
+        }
         if (entryIt.getEffectiveHidden()) {
             note.printData.printObject = mx::api::Bool::no;
         }
@@ -584,18 +602,18 @@ void applyPseudoLvTies(MusicXmlMusxMapping& context, const EntryInfoPtr& entryIn
     if (!entryInfo) {
         return;
     }
-    const auto entry = entryInfo->getEntry();
-    if (!context.processedPseudoLvTieEntries.emplace(entry->getEntryNumber()).second) {
+    const auto& entry = entryInfo->getEntry();
+    if (!context.processedPseudoLvTieEntries.insert(entry->getEntryNumber())) {
         return;
     }
 
     for (size_t noteIndex = 0; noteIndex < entry->notes.size(); ++noteIndex) {
         const NoteInfoPtr noteInfo(entryInfo, noteIndex);
-        const auto locationIt = context.noteLocations.find(musicXmlNoteKey(entry->getEntryNumber(), noteInfo->getNoteId()));
-        if (locationIt == context.noteLocations.end()) {
+        const auto* location = context.noteLocations.find(musicXmlNoteKey(entry->getEntryNumber(), noteInfo->getNoteId()));
+        if (!location) {
             continue;
         }
-        auto* note = noteDataAt(context, locationIt->second);
+        auto* note = noteDataAt(context, *location);
         if (!note || note->isTieStart || note->tieLetRing || noteInfo->tieStart || noteInfo.calcArpeggiatedTieInfo()) {
             continue;
         }
@@ -614,7 +632,7 @@ void deferPseudoLvTies(MusicXmlMusxMapping& context, const EntryInfoPtr& entryIn
         return;
     }
     const auto entryNumber = entryInfo->getEntry()->getEntryNumber();
-    if (context.deferredPseudoLvTieEntryNumbers.emplace(entryNumber).second) {
+    if (context.deferredPseudoLvTieEntryNumbers.insert(entryNumber)) {
         context.deferredPseudoLvTieEntries.emplace_back(entryInfo);
     }
 }
@@ -637,8 +655,13 @@ void createNotesForMeasureStaff(
 {
     (void)measure;
 
+    if (!context.staffContent->hasFrames(musxMeasure->getCmper(), staffId)) {
+        context.current.ottavasApplicableInMeasure.clear();
+        addSyntheticFullMeasureRest(context, staff, musxMeasure, staffId, staffIndex);
+        return;
+    }
     context.current.ottavasApplicableInMeasure = collectOttavasForMeasureStaff(
-        context.document, context.forPartId, musxMeasure, staffId);
+        *context.ottavaIndex, musxMeasure, staffId);
     const Fraction legacyPickupSpacer = musxMeasure->calcMinLegacyPickupSpacer(staffId);
     musx::dom::details::GFrameHoldContext gfHold(context.document, context.forPartId, staffId, musxMeasure->getCmper(), legacyPickupSpacer);
     if (!gfHold) {
@@ -652,15 +675,16 @@ void createNotesForMeasureStaff(
     /// @todo Honor Blank/BlankWithRests alternate notation by suppressing the affected entries and
     /// their attachments with print-object once its layer semantics have been mapped to MusicXML.
     const auto cueLayerPlan = createCueLayerPlan(gfHold, context.denigmaContext->cueLayer);
-    context.cueDiscardPlansByMeasureStaff.emplace(musicXmlMeasureStaffKey(musxMeasure->getCmper(), staffId), cueLayerPlan);
+    context.cueDiscardPlansByMeasureStaff.append(musicXmlMeasureStaffKey(musxMeasure->getCmper(), staffId), cueLayerPlan);
     const auto layerVoices = gfHold.calcVoices();
     const bool hasMultipleLayers = layerVoices.size() > 1;
     for (const auto& [layer, numVoice2Entries] : layerVoices) {
         if (cueLayerPlan.skipsLayer(layer)) {
+            context.denigmaContext->countHotPath(ConversionStats::HotPath::DiscardedCueFrame);
             continue;
         }
         const int maxVoice = numVoice2Entries ? 2 : 1;
-        const auto entryFrame = gfHold.createEntryFrame(layer);
+        const auto entryFrame = context.entryFrames.get(gfHold, layer);
         ASSERT_IF(!entryFrame) {
             continue;
         }
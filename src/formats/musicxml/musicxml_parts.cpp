@@ -43,25 +43,38 @@ namespace detail {
 
 namespace {
 
-void mapPartToInstrumentStaves(MusicXmlMusxMapping& context, const std::string& id, const InstrumentInfo& instInfo)
+void mapPartToInstrumentStaves(MusicXmlMusxMapping& context, size_t partIndex, const InstrumentInfo& instInfo)
 {
     const auto staves = instInfo.getSequentialStaves();
     if (staves.empty()) {
         return;
     }
-    auto& mappedStaves = context.partIdToStaves[id];
+    auto& mappedStaves = context.partMappings[partIndex].staves;
     mappedStaves.reserve(staves.size());
     for (StaffCmper staffId : staves) {
-        context.staffToPartId.emplace(staffId, id);
+        if (!context.excerpt.includesStaff(staffId)) {
+            continue;
+        }
+        if (staffId >= 0) {
+            const auto staffIndex = static_cast<size_t>(staffId);
+            if (staffIndex >= context.staffToPartIndex.size()) {
+                context.staffToPartIndex.resize(staffIndex + 1, MUSICXML_NO_PART_INDEX);
+            }
+            // a staff keeps the first part it was mapped to
+            if (context.staffToPartIndex[staffIndex] == MUSICXML_NO_PART_INDEX) {
+                context.staffToPartIndex[staffIndex] = partIndex;
+            }
+        }
         mappedStaves.emplace_back(staffId);
     }
 }
 
-void populatePartMetadata(MusicXmlMusxMapping& context, mx::api::PartData& part, const std::string& id, const MusxInstance<others::StaffComposite>& staff)
+void populatePartMetadata(MusicXmlMusxMapping& context, mx::api::PartData& part, MusicXmlPartMapping& partMapping,
+    const std::string& id, const MusxInstance<others::StaffComposite>& staff)
 {
     part.uniqueId = id;
     part.instrumentData.uniqueId = id + "-I1";
-    context.partIdToPitchContext[id] = MusicXmlPitchContext::Concert;
+    partMapping.pitchContext = MusicXmlPitchContext::Concert;
     if (const auto soundId = musicXmlSoundIdFromInstrumentUuid(staff->instUuid)) {
         part.instrumentData.soundID = *soundId;
     }
@@ -75,7 +88,7 @@ void populatePartMetadata(MusicXmlMusxMapping& context, mx::api::PartData& part,
             part.transposition = mx::api::TransposeData(
                 -music_theory::calc12EdoHalfstepsInInterval(transpositionDisp, transpositionAlt),
                 -transpositionDisp);
-            context.partIdToPitchContext[id] = MusicXmlPitchContext::Written;
+            partMapping.pitchContext = MusicXmlPitchContext::Written;
         }
     }
 
@@ -116,28 +129,12 @@ void sortGroups(std::vector<details::StaffGroupInfo>& groups)
     });
 }
 
-std::unordered_map<StaffCmper, int> createStaffToPartIndex(const MusicXmlMusxMapping& context)
-{
-    std::unordered_map<StaffCmper, int> result;
-    for (int partIndex = 0; partIndex < static_cast<int>(context.musicXmlScore->parts.size()); ++partIndex) {
-        const auto& part = context.musicXmlScore->parts.at(static_cast<size_t>(partIndex));
-        const auto stavesIt = context.partIdToStaves.find(part.uniqueId);
-        if (stavesIt == context.partIdToStaves.end()) {
-            continue;
-        }
-        for (StaffCmper staffId : stavesIt->second) {
-            result.emplace(staffId, partIndex);
-        }
-    }
-    return result;
-}
-
 std::unordered_map<StaffCmper, int> createStaffToLocalStaffNumber(const MusicXmlMusxMapping& context)
 {
     std::unordered_map<StaffCmper, int> result;
-    for (const auto& [partId, staves] : context.partIdToStaves) {
-        for (size_t index = 0; index < staves.size(); ++index) {
-            result.emplace(staves[index], static_cast<int>(index + 1));
+    for (const auto& partMapping : context.partMappings) {
+        for (size_t index = 0; index < partMapping.staves.size(); ++index) {
+            result.emplace(partMapping.staves[index], static_cast<int>(index + 1));
         }
     }
     return result;
@@ -166,13 +163,14 @@ void createPartGroups(MusicXmlMusxMapping& context)
 {
     auto& score = *context.musicXmlScore;
     score.partGroups.clear();
-    context.partIdToPartSymbol.clear();
+    for (auto& partMapping : context.partMappings) {
+        partMapping.partSymbol.reset();
+    }
 
     const auto scrollView = context.document->getScrollViewStaves(context.forPartId);
     auto groups = details::StaffGroupInfo::getGroupsAtMeasure(1, context.forPartId, scrollView);
     sortGroups(groups);
 
-    const auto staffToPartIndex = createStaffToPartIndex(context);
     const auto staffToLocalStaffNumber = createStaffToLocalStaffNumber(context);
     int groupNumber = 0;
     for (const auto& groupInfo : groups) {
@@ -190,22 +188,20 @@ void createPartGroups(MusicXmlMusxMapping& context)
 
         const auto startStaffId = scrollView[startSlot]->staffId;
         const auto endStaffId = scrollView[endSlot]->staffId;
-        const auto startPartIt = staffToPartIndex.find(startStaffId);
-        const auto endPartIt = staffToPartIndex.find(endStaffId);
-        if (startPartIt == staffToPartIndex.end() || endPartIt == staffToPartIndex.end()) {
+        const auto startPartIndex = context.partIndexForStaff(startStaffId);
+        const auto endPartIndex = context.partIndexForStaff(endStaffId);
+        if (startPartIndex == MUSICXML_NO_PART_INDEX || endPartIndex == MUSICXML_NO_PART_INDEX) {
             continue;
         }
-        if (startPartIt->second == endPartIt->second) {
-            const auto startPartIdIt = context.staffToPartId.find(startStaffId);
-            const auto endPartIdIt = context.staffToPartId.find(endStaffId);
+        if (startPartIndex == endPartIndex) {
             const auto topStaffIt = staffToLocalStaffNumber.find(startStaffId);
             const auto bottomStaffIt = staffToLocalStaffNumber.find(endStaffId);
-            if (startPartIdIt != context.staffToPartId.end()
-                && endPartIdIt != context.staffToPartId.end()
-                && startPartIdIt->second == endPartIdIt->second
-                && topStaffIt != staffToLocalStaffNumber.end()
-                && bottomStaffIt != staffToLocalStaffNumber.end()) {
-                auto& partSymbol = context.partIdToPartSymbol[startPartIdIt->second];
+            if (topStaffIt != staffToLocalStaffNumber.end() && bottomStaffIt != staffToLocalStaffNumber.end()) {
+                auto& mappedSymbol = context.partMappings[startPartIndex].partSymbol;
+                if (!mappedSymbol) {
+                    mappedSymbol.emplace();
+                }
+                auto& partSymbol = *mappedSymbol;
                 partSymbol.value = enumConvert<mx::api::BracketType>(groupInfo.group->bracket->style);
                 partSymbol.topStaff = topStaffIt->second;
                 partSymbol.bottomStaff = bottomStaffIt->second;
@@ -214,8 +210,8 @@ void createPartGroups(MusicXmlMusxMapping& context)
         }
 
         auto& partGroup = score.partGroups.emplace_back(mx::api::PartGroupData{});
-        partGroup.firstPartIndex = startPartIt->second;
-        partGroup.lastPartIndex = endPartIt->second;
+        partGroup.firstPartIndex = static_cast<int>(startPartIndex);
+        partGroup.lastPartIndex = static_cast<int>(endPartIndex);
         partGroup.number = ++groupNumber;
         partGroup.bracketType = enumConvert<mx::api::BracketType>(groupInfo.group->bracket->style);
         partGroup.groupBarline = enumConvert<mx::api::GroupBarline>(groupInfo.group->drawBarlines);
@@ -230,9 +226,8 @@ void createParts(MusicXmlMusxMapping& context)
     auto& parts = context.musicXmlScore->parts;
     parts.clear();
     context.musicXmlScore->partGroups.clear();
-    context.staffToPartId.clear();
-    context.partIdToStaves.clear();
-    context.partIdToPitchContext.clear();
+    context.partMappings.clear();
+    context.staffToPartIndex.clear();
 
     const auto scrollView = context.document->getScrollViewStaves(context.forPartId);
     const std::string scorePartGroup = context.forPartId == SCORE_PARTID ? "score" : "part";
@@ -246,11 +241,17 @@ void createParts(MusicXmlMusxMapping& context)
 
         const auto& [topStaffId, instInfo] = *instIt;
         static_cast<void>(topStaffId);
+        const auto instrumentStaves = instInfo.getSequentialStaves();
+        if (std::ranges::none_of(instrumentStaves, [&](StaffCmper staffId) { return context.excerpt.includesStaff(staffId); })) {
+            continue;
+        }
         const std::string id = createPartId(++partNumber);
+        const size_t partIndex = parts.size();
         auto& part = parts.emplace_back(mx::api::PartData{});
-        populatePartMetadata(context, part, id, staff);
+        auto& partMapping = context.partMappings.emplace_back();
+        populatePartMetadata(context, part, partMapping, id, staff);
         part.groups.emplace_back(scorePartGroup);
-        mapPartToInstrumentStaves(context, id, instInfo);
+        mapPartToInstrumentStaves(context, partIndex, instInfo);
     }
 
     createPartGroups(context);
@@ -83,15 +83,13 @@ std::optional<MusicXmlNoteLocation> findEntryNoteLocation(
 
     const auto entryNumber = entryInfo->getEntry()->getEntryNumber();
     if (noteId != 0) {
-        const auto noteIt = context.noteLocations.find(musicXmlNoteKey(entryNumber, noteId));
-        if (noteIt != context.noteLocations.end()) {
-            return noteIt->second;
+        if (const auto* location = context.noteLocations.find(musicXmlNoteKey(entryNumber, noteId))) {
+            return *location;
         }
     }
 
-    const auto entryIt = context.entryNumberToFirstNote.find(entryNumber);
-    if (entryIt != context.entryNumberToFirstNote.end()) {
-        return entryIt->second;
+    if (const auto* location = context.entryNumberToFirstNote.find(entryNumber)) {
+        return *location;
     }
     return std::nullopt;
 }
@@ -101,6 +99,17 @@ int calcEndpointTick(const MusicXmlMusxMapping& context, const std::shared_ptr<s
     return context.timing.calcNearestMusicXmlDivisions(endpoint->calcGlobalPosition());
 }
 
+/// Returns the entry endpoint is attached to, taken from the frames the note pass built whenever it is in one.
+EntryInfoPtr calcEndpointEntry(const MusicXmlMusxMapping& context, const std::shared_ptr<smartshape::EndPoint>& endpoint)
+{
+    if (endpoint->entryNumber != 0) {
+        if (auto entryInfo = context.entryFrames.findEntry(endpoint->entryNumber)) {
+            return entryInfo;
+        }
+    }
+    return endpoint->calcAssociatedEntry();
+}
+
 int calcTickAfterEntriesStartingAt(const mx::api::StaffData& staff, int tick)
 {
     auto adjustedTick = tick;
@@ -177,17 +186,14 @@ std::optional<MusicXmlEndpointStaffLocation> staffLocationForEndpoint(
         return std::nullopt;
     }
 
-    const auto stavesIt = context.partIdToStaves.find(context.currentPart->uniqueId);
-    if (stavesIt == context.partIdToStaves.end()) {
-        return std::nullopt;
-    }
-    const auto staffIt = std::ranges::find(stavesIt->second, endpoint->staffId);
-    if (staffIt == stavesIt->second.end()) {
+    const auto& partStaves = context.currentPartMapping().staves;
+    const auto staffIt = std::ranges::find(partStaves, endpoint->staffId);
+    if (staffIt == partStaves.end()) {
         return std::nullopt;
     }
 
     const auto measureIndex = static_cast<size_t>(std::distance(measures.begin(), measureIt));
-    const auto staffIndex = static_cast<size_t>(std::distance(stavesIt->second.begin(), staffIt));
+    const auto staffIndex = static_cast<size_t>(std::distance(partStaves.begin(), staffIt));
     if (staffIndex >= measureIt->staves.size()) {
         return std::nullopt;
     }
@@ -467,7 +473,8 @@ void appendOttava(
     StaffCmper staffId,
     size_t staffIndex,
     const MusxInstance<others::SmartShape>& shape,
-    const classify::smartshape::Ottava& ottava)
+    const classify::smartshape::Ottava& ottava,
+    bool carriedIntoExcerpt = false)
 {
     if (!ottava.calcIsSemanticCarrier()) {
         // A paired visual custom line: its hidden counterpart carries the octave shift.
@@ -494,8 +501,9 @@ void appendOttava(
     const auto placement = shape->hidden
         ? (ottava.octaveShift > 0 ? VerticalPlacement::Above : VerticalPlacement::Below)
         : shape->calcVerticalPlacementForBeatAttached();
+    // an ottava in effect where an excerpt starts restarts at its first beat
     auto startDirection = createSmartShapeDirection(
-        context, startPoint, staffId, staffIndex, placement, calcOttavaStartTick(context, startPoint));
+        context, startPoint, staffId, staffIndex, placement, carriedIntoExcerpt ? 0 : calcOttavaStartTick(context, startPoint));
     auto ottavaStart = mx::api::OttavaStart{};
     ottavaStart.ottavaType = *ottavaType;
     ottavaStart.spannerStart.tickTimePosition = startDirection.tickTimePosition;
@@ -503,9 +511,19 @@ void appendOttava(
     startDirection.ottavaStarts.emplace_back(std::move(ottavaStart));
     staff.directions.emplace_back(std::move(startDirection));
 
-    if (auto* stopStaff = staffDataForEndpoint(context, endPoint)) {
+    auto* stopStaff = staffDataForEndpoint(context, endPoint);
+    std::optional<int> stopTick;
+    if (!stopStaff && endPoint->measId > context.excerpt.lastMeasure() && !context.currentPart->measures.empty()) {
+        // the excerpt ends inside the ottava, so it stops at the excerpt's final barline
+        const auto lastMeasure = context.document->getOthers()->get<others::Measure>(context.forPartId, context.excerpt.lastMeasure());
+        if (lastMeasure && staffIndex < context.currentPart->measures.back().staves.size()) {
+            stopStaff = &context.currentPart->measures.back().staves[staffIndex];
+            stopTick = context.timing.calcMusicXmlDivisions(lastMeasure->calcDuration());
+        }
+    }
+    if (stopStaff) {
         auto stopDirection = createSmartShapeDirection(
-            context, endPoint, staffId, staffIndex, placement, calcOttavaStopTick(context, endPoint, *stopStaff));
+            context, endPoint, staffId, staffIndex, placement, stopTick ? *stopTick : calcOttavaStopTick(context, endPoint, *stopStaff));
         auto ottavaStop = mx::api::OttavaStop{};
         ottavaStop.spannerStop.tickTimePosition = stopDirection.tickTimePosition;
         ottavaStop.spannerStop.number = smartShapeSpannerNumber(shape);
@@ -675,8 +693,12 @@ void appendGeneralLine(
     const auto placement = shape->calcVerticalPlacementForBeatAttached();
     auto startDirection = createSmartShapeDirection(context, startPoint, staffId, staffIndex, placement);
     auto stopDirection = createSmartShapeDirection(context, endPoint, endPoint->staffId, staffIndex, placement);
-    startDirection.words = musicXmlWordsFromEnigmaText(context, line.startText);
-    stopDirection.words = musicXmlWordsFromEnigmaText(context, line.endText);
+    if (line.customLine) {
+        startDirection.words = cachedMusicXmlWordsFromEnigmaText(context, MusicXmlTextSource::LineStartText,
+            line.customLine->getCmper(), line.startText);
+        stopDirection.words = cachedMusicXmlWordsFromEnigmaText(context, MusicXmlTextSource::LineEndText,
+            line.customLine->getCmper(), line.endText);
+    }
 
     if (line.lineVisible) {
         const bool hasCaps = line.startCap.type != classify::smartshape::LineCap::Type::None
@@ -740,7 +762,7 @@ void appendTrillLine(
             << " because mx::api cannot pair wavy-line start/stop.", MessageSeverity::Verbose);
         return;
     }
-    const auto startEntry = shape->startTermSeg->endPoint->calcAssociatedEntry();
+    const auto startEntry = calcEndpointEntry(context, shape->startTermSeg->endPoint);
     const auto location = findEntryNoteLocation(context, startEntry, shape->startNoteId);
     auto* note = location ? noteDataAt(context, *location) : nullptr;
     if (!note) {
@@ -764,25 +786,9 @@ void processSmartShapesForStaff(
         return;
     }
 
-    const auto assigns = context.document->getOthers()->getArray<others::SmartShapeMeasureAssign>(
-        musxMeasure->getRequestedPartId(), musxMeasure->getCmper());
-    for (const auto& assign : assigns) {
-        MUSX_ASSERT_IF(!assign) {
-            continue;
-        }
-        if (assign->centerShapeNum != 0) {
-            continue;
-        }
-        const auto shape = context.document->getOthers()->get<others::SmartShape>(SCORE_PARTID, assign->shapeNum);
-        ASSERT_IF(!shape) {
-            continue;
-        }
-        if (shape->startTermSeg->endPoint->staffId != staffId
-            || shape->startTermSeg->endPoint->measId != musxMeasure->getCmper()) {
-            continue;
-        }
-
-        const auto classification = classify::classifySmartShape(shape);
+    for (const auto& start : context.smartShapeStarts->get(musxMeasure->getCmper(), staffId)) {
+        const auto& shape = start.shape;
+        const auto& classification = start.classification;
         if (shape->hidden && !std::holds_alternative<classify::smartshape::Ottava>(classification.value)) {
             // Hidden ottavas can be semantic carriers for visible custom lines and
             // must be processed; all other hidden shapes are skipped.
@@ -815,7 +821,7 @@ void processSmartShapesForStaff(
                 processArpeggiatedTie(context, value);
             } else if constexpr (std::is_same_v<Value, classify::PseudoTie>) {
                 if (value.type == classify::PseudoTie::Type::LaissezVibrer) {
-                    applyPseudoLvTies(context, shape->startTermSeg->endPoint->calcAssociatedEntry());
+                    applyPseudoLvTies(context, calcEndpointEntry(context, shape->startTermSeg->endPoint));
                 }
             } else if constexpr (std::is_same_v<Value, classify::smartshape::NonArpeggio>) {
                 appendArpeggioCandidate(context, value.candidate);
@@ -835,6 +841,20 @@ void processSmartShapes(
         return;
     }
 
+    if (context.excerpt.startsMidScore() && !musxMeasures.empty()) {
+        // ottavas that start before the excerpt still shift the notes of its first measure
+        auto& measure = context.currentPart->measures.front();
+        for (size_t staffIndex = 0; staffIndex < staves.size(); ++staffIndex) {
+            for (const auto& [shapeId, ottava] : collectOttavasForMeasureStaff(*context.ottavaIndex, musxMeasures.front(), staves[staffIndex])) {
+                static_cast<void>(shapeId);
+                if (ottava.shape->startTermSeg->endPoint->measId < context.excerpt.firstMeasure()) {
+                    appendOttava(context, measure.staves[staffIndex], staves[staffIndex], staffIndex, ottava.shape,
+                        ottava.classification, /*carriedIntoExcerpt*/ true);
+                }
+            }
+        }
+    }
+
     for (size_t measureIndex = 0; measureIndex < musxMeasures.size(); ++measureIndex) {
         auto& measure = context.currentPart->measures[measureIndex];
         for (size_t staffIndex = 0; staffIndex < staves.size(); ++staffIndex) {
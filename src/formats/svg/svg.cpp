@@ -21,16 +21,29 @@
  */
 #include "svg.h"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <fstream>
+#include <optional>
 #include <span>
+#include <sstream>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "pugixml.hpp"
+
 #include "musx/musx.h"
 #include "core/musx_reader.h"
+#include "core/parallel.h"
 #include "utils/stringutils.h"
 #include "utils/textmetrics.h"
 
@@ -97,6 +110,236 @@ std::vector<MusxInstance<others::ShapeDef>> selectShapes(const DocumentPtr& docu
     return result;
 }
 
+/// Repeated drawing elements shorter than this stay inline: they are barely larger than the <use> that would replace them.
+constexpr std::size_t MIN_SHARED_ELEMENT_LENGTH = 96;
+
+std::string serializeNode(const pugi::xml_node& node)
+{
+    std::ostringstream output;
+    node.print(output, "", pugi::format_raw);
+    return std::move(output).str();
+}
+
+/// True for a leaf drawing element that may be moved into <defs> and drawn through <use>.
+bool isShareableElement(const pugi::xml_node& node)
+{
+    static constexpr auto drawingElements = std::to_array<std::string_view>({
+        "path", "rect", "circle", "ellipse", "line", "polyline", "polygon", "text", "image"
+    });
+    const std::string_view name = node.name();
+    if (node.type() != pugi::node_element || node.attribute("id")
+        || std::find(drawingElements.begin(), drawingElements.end(), name) == drawingElements.end()) {
+        return false;
+    }
+    if (name == "text") {
+        return true; // its <tspan> children travel with it
+    }
+    for (auto child = node.first_child(); child; child = child.next_sibling()) {
+        if (child.type() == pugi::node_element) {
+            return false; // e.g. <animate>
+        }
+    }
+    return true;
+}
+
+/// Calls func for every shareable element under root. Content that is only referenced (definitions, clip paths,
+/// masks) is left where it is, because moving it would break the references.
+template <typename Func>
+void forEachShareableElement(const pugi::xml_node& root, Func&& func)
+{
+    static constexpr auto referencedContainers = std::to_array<std::string_view>({
+        "defs", "clipPath", "mask", "pattern", "marker", "symbol"
+    });
+    for (auto child = root.first_child(); child; ) {
+        const auto next = child.next_sibling(); // func may replace child
+        if (isShareableElement(child)) {
+            func(child);
+        } else if (child.type() == pugi::node_element
+                   && std::find(referencedContainers.begin(), referencedContainers.end(), std::string_view(child.name())) == referencedContainers.end()) {
+            forEachShareableElement(child, func);
+        }
+        child = next;
+    }
+}
+
+template <typename Func>
+void forEachElement(const pugi::xml_node& root, Func&& func)
+{
+    for (auto child = root.first_child(); child; child = child.next_sibling()) {
+        if (child.type() == pugi::node_element) {
+            func(child);
+            forEachElement(child, func);
+        }
+    }
+}
+
+/// Prefixes every id under root so that shapes can share one document, and rewrites the "#id" and "url(#id)"
+/// references to them.
+void prefixIds(const pugi::xml_node& root, const std::string& prefix)
+{
+    std::unordered_set<std::string> ids;
+    forEachElement(root, [&](const pugi::xml_node& node) {
+        if (const auto id = node.attribute("id")) {
+            ids.emplace(id.value());
+        }
+    });
+    if (ids.empty()) {
+        return;
+    }
+    forEachElement(root, [&](const pugi::xml_node& node) {
+        for (auto attribute = node.first_attribute(); attribute; attribute = attribute.next_attribute()) {
+            const std::string_view value = attribute.value();
+            if (std::string_view(attribute.name()) == "id") {
+                attribute.set_value((prefix + attribute.value()).c_str());
+                continue;
+            }
+            if (value.find('#') == std::string_view::npos) {
+                continue;
+            }
+            std::string rewritten;
+            std::size_t copied = 0;
+            for (auto hash = value.find('#'); hash != std::string_view::npos; hash = value.find('#', hash + 1)) {
+                const auto end = (std::min)(value.find_first_of(") \t\"'", hash + 1), value.size());
+                if (ids.contains(std::string(value.substr(hash + 1, end - hash - 1)))) {
+                    rewritten.append(value.substr(copied, hash + 1 - copied));
+                    rewritten.append(prefix);
+                    copied = hash + 1;
+                }
+            }
+            if (copied > 0) {
+                rewritten.append(value.substr(copied));
+                attribute.set_value(rewritten.c_str());
+            }
+        }
+    });
+}
+
+/// Splits an SVG length such as "7.964mm" into its number and unit.
+std::optional<std::pair<double, std::string>> parseSvgLength(std::string_view text)
+{
+    const std::string value(text);
+    char* end = nullptr;
+    const double number = std::strtod(value.c_str(), &end);
+    if (end == value.c_str()) {
+        return std::nullopt;
+    }
+    return std::make_pair(number, std::string(end));
+}
+
+/// @brief Combines per-shape SVG documents into one sprite sheet.
+///
+/// Each shape becomes a <symbol id="shape-N"> drawn by a <use>, stacked vertically. Leaf drawing elements that occur
+/// more than once across the batch (the same glyph or sub-shape in many shapes) are moved into <defs> once and
+/// replaced by <use> references. Ids inside each shape are prefixed with its symbol id so that they cannot collide.
+std::string buildSpriteSheet(const std::vector<std::pair<Cmper, std::string>>& shapeSvgs, const DenigmaContext& denigmaContext)
+{
+    struct ShapeDocument
+    {
+        Cmper cmper{};
+        pugi::xml_document document;
+        pugi::xml_node root;
+        double width{};
+        double height{};
+    };
+    std::deque<ShapeDocument> shapes;
+    std::string unit;
+    for (const auto& [cmper, svgData] : shapeSvgs) {
+        auto& shape = shapes.emplace_back();
+        shape.cmper = cmper;
+        if (!shape.document.load_buffer(svgData.data(), svgData.size()) || !(shape.root = shape.document.child("svg"))) {
+            denigmaContext.logMessage(LogMsg() << "ShapeDef cmper " << cmper << " produced unreadable SVG and was left out of the sprite sheet.",
+                                      MessageSeverity::Warning);
+            shapes.pop_back();
+            continue;
+        }
+        const auto width = parseSvgLength(shape.root.attribute("width").value());
+        const auto height = parseSvgLength(shape.root.attribute("height").value());
+        double viewBox[4]{};
+        const bool hasViewBox = std::sscanf(shape.root.attribute("viewBox").value(), "%lf %lf %lf %lf", &viewBox[0], &viewBox[1], &viewBox[2], &viewBox[3]) == 4;
+        shape.width = width ? width->first : viewBox[2];
+        shape.height = height ? height->first : viewBox[3];
+        if (unit.empty() && width) {
+            unit = width->second;
+        }
+        if (!hasViewBox) {
+            shape.root.append_attribute("viewBox") = ("0 0 " + utils::NumberText::shortest(shape.width).str() + " " + utils::NumberText::shortest(shape.height).str()).c_str();
+        }
+        prefixIds(shape.root, "shape-" + std::to_string(cmper) + "-");
+    }
+
+    // elements that repeat are shared
+    std::unordered_map<std::string, std::size_t> occurrences;
+    for (const auto& shape : shapes) {
+        forEachShareableElement(shape.root, [&](const pugi::xml_node& node) {
+            auto text = serializeNode(node);
+            if (text.size() >= MIN_SHARED_ELEMENT_LENGTH) {
+                ++occurrences[std::move(text)];
+            }
+        });
+    }
+
+    pugi::xml_document sheet;
+    auto declaration = sheet.append_child(pugi::node_declaration);
+    declaration.append_attribute("version") = "1.0";
+    declaration.append_attribute("encoding") = "UTF-8";
+    auto root = sheet.append_child("svg");
+    root.append_attribute("version") = "1.1";
+    root.append_attribute("xmlns") = "http://www.w3.org/2000/svg";
+    root.append_attribute("xmlns:xlink") = "http://www.w3.org/1999/xlink";
+    auto defs = root.append_child("defs");
+    std::unordered_map<std::string, std::string> sharedIds; // serialized element -> id in <defs>
+    pugi::xml_node lastShared;
+    double sheetWidth = 0.0;
+    double sheetHeight = 0.0;
+    for (const auto& shape : shapes) {
+        const std::string symbolId = "shape-" + std::to_string(shape.cmper);
+        auto symbol = defs.append_child("symbol");
+        symbol.append_attribute("id") = symbolId.c_str();
+        symbol.append_attribute("viewBox") = shape.root.attribute("viewBox").value();
+        if (const auto aspect = shape.root.attribute("preserveAspectRatio")) {
+            symbol.append_attribute("preserveAspectRatio") = aspect.value();
+        }
+        for (auto child = shape.root.first_child(); child; child = child.next_sibling()) {
+            symbol.append_copy(child);
+        }
+        forEachShareableElement(symbol, [&](pugi::xml_node node) {
+            auto text = serializeNode(node);
+            const auto counted = occurrences.find(text);
+            if (counted == occurrences.end() || counted->second < 2) {
+                return;
+            }
+            auto [shared, inserted] = sharedIds.try_emplace(std::move(text));
+            if (inserted) {
+                shared->second = "shared-" + std::to_string(sharedIds.size());
+                // shared definitions stay ahead of the symbols, in first-use order
+                lastShared = lastShared ? defs.insert_copy_after(node, lastShared) : defs.prepend_copy(node);
+                lastShared.append_attribute("id") = shared->second.c_str();
+            }
+            auto use = node.parent().insert_child_before("use", node);
+            use.append_attribute("xlink:href") = ("#" + shared->second).c_str();
+            node.parent().remove_child(node);
+        });
+
+        auto use = root.append_child("use");
+        use.append_attribute("xlink:href") = ("#" + symbolId).c_str();
+        use.append_attribute("x") = 0;
+        use.append_attribute("y") = utils::NumberText::shortest(sheetHeight).c_str();
+        use.append_attribute("width") = utils::NumberText::shortest(shape.width).c_str();
+        use.append_attribute("height") = utils::NumberText::shortest(shape.height).c_str();
+        sheetWidth = (std::max)(sheetWidth, shape.width);
+        sheetHeight += shape.height;
+    }
+    const auto width = utils::NumberText::shortest(sheetWidth);
+    const auto height = utils::NumberText::shortest(sheetHeight);
+    root.insert_attribute_after("width", root.attribute("xmlns:xlink")) = (width.str() + unit).c_str();
+    root.insert_attribute_after("height", root.attribute("width")) = (height.str() + unit).c_str();
+    root.insert_attribute_after("viewBox", root.attribute("height")) = ("0 0 " + width.str() + " " + height.str()).c_str();
+
+    std::ostringstream output;
+    sheet.save(output, "  ");
+    return std::move(output).str();
+}
+
 } // namespace
 
 void convert(const CommandInputData& inputData,
@@ -109,7 +352,14 @@ void convert(const CommandInputData& inputData,
         return;
     }
 
-    auto document = denigma::createMusxDocument<MusxReader>(inputData, denigmaContext);
+    convert(denigma::createMusxDocument<MusxShapesReader>(inputData, denigmaContext), denigmaContext, outputCallback); // shapes live in others
+}
+
+void convert(const DocumentPtr& document,
+             const DenigmaContext& denigmaContext,
+             const MultiOutputCallback& outputCallback)
+{
+    MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
     const auto shapes = selectShapes(document, denigmaContext);
     if (shapes.empty()) {
         denigmaContext.logMessage(LogMsg() << "No ShapeDef entries matched the SVG export filters.", MessageSeverity::Warning);
@@ -118,25 +368,45 @@ void convert(const CommandInputData& inputData,
 
     const bool usePageFormatScaling = denigmaContext.svgUsePageScale;
     const double svgScale = denigmaContext.svgScale;
-    const auto glyphMetrics = textmetrics::makeSvgGlyphMetricsCallback(denigmaContext);
     denigmaContext.logMessage(LogMsg() << "SVG scaling pageScale=" << (usePageFormatScaling ? "on" : "off")
                                        << " user=" << svgScale
                                        << " path=" << (usePageFormatScaling ? "toSvgWithPageFormatScaling" : "toSvg"),
                               MessageSeverity::Verbose);
 
+    // Shapes render independently, so up to denigmaContext.outputJobs workers render them while output
+    // keeps the selection order. The glyph-metrics callback logs through the context it is given, so each
+    // render creates its own; the metrics themselves are shared by the whole batch.
+    textmetrics::SvgGlyphMetricsCache glyphMetricsCache;
     size_t generatedCount = 0;
-    for (const auto& shape : shapes) {
-        const std::string svgData = usePageFormatScaling
-            ? musx::util::SvgConvert::toSvgWithPageFormatScaling(*shape, denigmaContext.svgUnit, glyphMetrics)
-            : musx::util::SvgConvert::toSvg(*shape, svgScale, denigmaContext.svgUnit, glyphMetrics);
-        if (svgData.empty()) {
-            denigmaContext.logMessage(LogMsg() << "ShapeDef cmper " << shape->getCmper()
-                                               << " could not be converted to SVG (likely unresolved external graphic).",
-                                      MessageSeverity::Warning);
-            continue;
-        }
-        const std::string suggestedName = "shape-" + std::to_string(shape->getCmper()) + ".svg";
-        outputCallback(suggestedName, std::as_bytes(std::span<const char>(svgData.data(), svgData.size())));
+    std::vector<std::pair<Cmper, std::string>> spriteSheetShapes;
+    forEachInOrder<std::string>(shapes.size(), denigmaContext,
+        [&](const DenigmaContext& workerContext, std::size_t index) {
+            TraceSpan span("renderShapeSvg");
+            const auto glyphMetrics = textmetrics::makeSvgGlyphMetricsCallback(workerContext, &glyphMetricsCache);
+            const auto& shape = shapes[index];
+            return usePageFormatScaling
+                ? musx::util::SvgConvert::toSvgWithPageFormatScaling(*shape, workerContext.svgUnit, glyphMetrics)
+                : musx::util::SvgConvert::toSvg(*shape, svgScale, workerContext.svgUnit, glyphMetrics);
+        },
+        [&](std::size_t index, std::string&& svgData) {
+            const auto& shape = shapes[index];
+            if (svgData.empty()) {
+                denigmaContext.logMessage(LogMsg() << "ShapeDef cmper " << shape->getCmper()
+                                                   << " could not be converted to SVG (likely unresolved external graphic).",
+                                          MessageSeverity::Warning);
+                return;
+            }
+            if (denigmaContext.svgSpriteSheet) {
+                spriteSheetShapes.emplace_back(shape->getCmper(), std::move(svgData));
+                return;
+            }
+            const std::string suggestedName = "shape-" + std::to_string(shape->getCmper()) + ".svg";
+            outputCallback(suggestedName, std::move(svgData));
+            ++generatedCount;
+        });
+
+    if (!spriteSheetShapes.empty()) {
+        outputCallback("shapes.svg", buildSpriteSheet(spriteSheetShapes, denigmaContext));
         ++generatedCount;
     }
 
@@ -183,7 +453,9 @@ void convert(const std::filesystem::path& outputPath, const CommandInputData& in
     const bool multipleShapes = pendingSvgs.size() > 1;
     size_t generatedCount = 0;
     for (const auto& pendingSvg : pendingSvgs) {
-        const auto resolvedOutputPath = resolveOutputPath(outputPath, pendingSvg.shapeCmper, denigmaContext.outputIsFilename, multipleShapes);
+        const auto resolvedOutputPath = denigmaContext.svgSpriteSheet
+            ? outputPath // the sheet holds every shape
+            : resolveOutputPath(outputPath, pendingSvg.shapeCmper, denigmaContext.outputIsFilename, multipleShapes);
         if (!denigmaContext.validatePathsAndOptions(resolvedOutputPath)) {
             continue;
         }
@@ -34,6 +34,9 @@ namespace detail {
 void convert(const CommandInputData& inputData,
              const DenigmaContext& denigmaContext,
              const MultiOutputCallback& outputCallback);
+void convert(const musx::dom::DocumentPtr& document,
+             const DenigmaContext& denigmaContext,
+             const MultiOutputCallback& outputCallback);
 void convert(const std::filesystem::path& outputPath, const CommandInputData& inputData, const DenigmaContext& denigmaContext);
 
 } // namespace detail
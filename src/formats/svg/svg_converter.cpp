@@ -23,7 +23,10 @@
 #include <vector>
 
 #include "core/denigma.h"
+#include "core/musx_reader.h"
+#include "denigma/prepared_document.h"
 #include "formats/enigmaxml/enigmaxml.h"
+#include "formats/enigmaxml/prepared_document.h"
 #include "svg.h"
 #include "utils/stringutils.h"
 
@@ -59,9 +62,15 @@ void applySvgOptions(DenigmaContext& context, const Options& options)
     context.noValidate = !options.common.validate;
     context.verbose = options.common.verbose;
     context.quiet = options.common.quiet;
+    context.outputJobs = options.common.outputJobs;
+    context.executor = options.common.executor;
+    context.cancellation = options.common.cancellation;
+    context.deadline = options.common.deadline;
+    context.textMetrics = options.common.textMetrics;
     context.svgUnit = toMusxSvgUnit(options.unit);
     context.svgScale = options.scale;
     context.svgUsePageScale = options.usePageScale;
+    context.svgSpriteSheet = options.spriteSheet;
     context.svgShapeDefs.reserve(options.shapeDefs.size());
     for (const int shapeDef : options.shapeDefs) {
         context.svgShapeDefs.push_back(static_cast<musx::dom::Cmper>(shapeDef));
@@ -75,11 +84,6 @@ ConversionResult EnigmaXmlToSvgConverter::convert(std::span<const std::byte> inp
                                                   const Options& options) const
 {
     ConversionResult result;
-    Buffer buffer;
-    buffer.reserve(input.size());
-    for (const std::byte value : input) {
-        buffer.push_back(static_cast<char>(value));
-    }
 
     DenigmaContext context(DENIGMA_NAME);
     context.inputFilePath = options.common.sourceName.empty()
@@ -87,10 +91,17 @@ ConversionResult EnigmaXmlToSvgConverter::convert(std::span<const std::byte> inp
         : utils::utf8ToPath(options.common.sourceName);
     context.logCallback = options.common.logCallback;
     context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    const auto countedOutputCallback = stats.countOutputs(outputCallback);
     applySvgOptions(context, options);
     MusxLoggerScope musxLogger(makeMusxLogCallback(context));
 
-    formats::svg::detail::convert(CommandInputData{ std::move(buffer), std::nullopt, {} }, context, outputCallback);
+    try {
+        formats::svg::detail::convert(CommandInputData::fromBorrowedBytes(input), context, countedOutputCallback);
+    } catch (const ConversionCancelled& ex) {
+        context.logMessage(LogMsg() << "SVG conversion stopped (" << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
     return result;
 }
 
@@ -112,10 +123,19 @@ ConversionResult MusxToSvgConverter::convert(const IRandomAccessReader& input,
         : utils::utf8ToPath(options.common.sourceName);
     context.logCallback = options.common.logCallback;
     context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    const auto countedOutputCallback = stats.countOutputs(outputCallback);
     applySvgOptions(context, options);
     MusxLoggerScope musxLogger(makeMusxLogCallback(context));
 
-    formats::svg::detail::convert(formats::enigmaxml::detail::extractMusxInputData(input, context), context, outputCallback);
+    try {
+        auto inputData = formats::enigmaxml::detail::extractMusxInputData(input, context);
+        MusxReaderBufferHandoff xmlHandoff(inputData.primaryBuffer); // nothing reads the XML after the DOM is built
+        formats::svg::detail::convert(inputData, context, countedOutputCallback);
+    } catch (const ConversionCancelled& ex) {
+        context.logMessage(LogMsg() << "SVG conversion stopped (" << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
     return result;
 }
 
@@ -126,10 +146,44 @@ ConversionResult MusxToSvgConverter::convert(const IRandomAccessReader& input,
     return convert(input, outputCallback, optionsFromRequest<Options>(request, "MusxToSvgConverter"));
 }
 
+ConversionResult PreparedDocumentToSvgConverter::convert(const PreparedDocument& input,
+                                                         const MultiOutputCallback& outputCallback,
+                                                         const Options& options) const
+{
+    ConversionResult result;
+    const auto& sourceName = options.common.sourceName.empty() ? input.impl().sourceName : options.common.sourceName;
+    DenigmaContext context(DENIGMA_NAME);
+    context.inputFilePath = sourceName.empty()
+        ? std::filesystem::path("input.musx")
+        : utils::utf8ToPath(sourceName);
+    context.logCallback = options.common.logCallback;
+    context.conversionResult = &result;
+    ConversionStatsScope stats(context, options.common);
+    const auto countedOutputCallback = stats.countOutputs(outputCallback);
+    applySvgOptions(context, options);
+    MusxLoggerScope musxLogger(makeMusxLogCallback(context));
+
+    try {
+        formats::svg::detail::convert(input.impl().document(MusxLoadProfile::Shapes, context), context, countedOutputCallback);
+    } catch (const ConversionCancelled& ex) {
+        context.logMessage(LogMsg() << "SVG conversion stopped (" << ex.what() << ")", MessageSeverity::Error);
+    }
+    stats.finish();
+    return result;
+}
+
+ConversionResult PreparedDocumentToSvgConverter::convert(const PreparedDocument& input,
+                                                         const MultiOutputCallback& outputCallback,
+                                                         const ConversionRequest& request) const
+{
+    return convert(input, outputCallback, optionsFromRequest<Options>(request, "PreparedDocumentToSvgConverter"));
+}
+
 void registerConverters(ConverterRegistry& registry)
 {
     registry.add(std::make_unique<EnigmaXmlToSvgConverter>());
     registry.add(std::make_unique<MusxToSvgConverter>());
+    registry.add(std::make_unique<PreparedDocumentToSvgConverter>());
 }
 
 } // namespace svg
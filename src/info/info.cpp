@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <array>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "info/info.h"
+#include "info/score_info.h"
+#include "formats/enigmaxml/enigmaxml.h"
+
+namespace denigma {
+
+// Input format processors
+constexpr auto inputProcessors = []() {
+    struct InputProcessor
+    {
+        std::u8string_view extension;
+        CommandInputData(*processor)(const std::filesystem::path&, const DenigmaContext&);
+    };
+
+    return std::to_array<InputProcessor>({
+            { MUSX_EXTENSION, formats::enigmaxml::detail::extractMusxInputData },
+            { ENIGMAXML_EXTENSION, formats::enigmaxml::detail::readEnigmaXmlInputData },
+        });
+    }();
+
+int InfoCommand::showHelpPage(const std::string_view& programName, const std::string& indentSpaces) const
+{
+    std::string fullCommand = std::string(programName) + " " + std::string(commandName());
+    // Print usage
+    std::cout << indentSpaces << "Writes the catalog metadata of Finale files as JSON Lines, one object per input:" << std::endl;
+    std::cout << indentSpaces << "source, title, subtitle, composer, arranger, lyricist, copyright, description, parts," << std::endl;
+    std::cout << indentSpaces << "measures, pages, fileVersion and creator. Nothing is converted, so this is much faster than export." << std::endl;
+    std::cout << std::endl;
+    std::cout << indentSpaces << "Usage: " << fullCommand << " <input-pattern> [--jsonl [file-path]]" << std::endl;
+    std::cout << std::endl;
+
+    // Supported input formats
+    std::cout << indentSpaces << "Supported input formats:" << std::endl;
+    for (const auto& input : inputProcessors) {
+        std::cout << indentSpaces << "  *." << utils::utf8ToString(input.extension);
+        if (input.extension == defaultInputFormat()) {
+            std::cout << " (default input format)";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::endl;
+
+    // Supported output formats
+    std::cout << indentSpaces << "Supported output options:" << std::endl;
+    std::cout << indentSpaces << "  --jsonl [optional filepath]     Append every record to this one file (default: standard output)." << std::endl;
+    std::cout << indentSpaces << "                                  With --jobs, records are written in the order inputs finish." << std::endl;
+    std::cout << indentSpaces << std::endl;
+
+    // Example usage
+    std::cout << indentSpaces << "Examples:" << std::endl;
+    std::cout << indentSpaces << "  " << fullCommand << " myfile.musx" << std::endl;
+    std::cout << indentSpaces << "  " << fullCommand << " myfolder --recursive --jobs --jsonl catalog.jsonl" << std::endl;
+
+    return 1;
+}
+
+bool InfoCommand::canProcess(const std::filesystem::path& inputPath) const
+{
+    try {
+        findProcessor(inputProcessors, formatExtension(inputPath));
+        return true;
+    } catch (...) {}
+    return false;
+}
+
+CommandInputData InfoCommand::processInput(const std::filesystem::path& inputPath, const DenigmaContext& denigmaContext) const
+{
+    MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+    auto inputProcessor = findProcessor(inputProcessors, formatExtension(inputPath));
+    return inputProcessor(inputPath, denigmaContext);
+}
+
+void InfoCommand::processOutput(const CommandInputData& inputData, const std::filesystem::path& outputPath, const std::filesystem::path& inputPath, const DenigmaContext& denigmaContext) const
+{
+    MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+    if (utils::normalizedPathExtension(outputPath) != JSONL_EXTENSION) {
+        throw std::invalid_argument("Unsupported format: " + utils::utf8ToString(utils::normalizedPathExtension(outputPath)));
+    }
+    // A named file collects the records of the whole run; otherwise they go to standard output.
+    const std::filesystem::path destination = denigmaContext.outputIsFilename ? outputPath : std::filesystem::path{};
+    const auto record = info::toJsonLine(info::probeScoreInfo(inputData, denigmaContext), inputPath);
+    denigmaContext.sharedOutputFiles->append(destination, record, denigmaContext);
+}
+
+} // namespace denigma
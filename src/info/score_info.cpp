@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "info/score_info.h"
+
+#include <string_view>
+
+#include "nlohmann/json.hpp"
+
+#include "musx/musx.h"
+#include "core/musx_reader.h"
+#include "utils/xml_header_probe.h"
+
+namespace denigma {
+namespace info {
+
+using namespace musx::dom;
+
+ScoreInfo probeScoreInfo(const CommandInputData& inputData, const DenigmaContext& denigmaContext)
+{
+    ScoreInfo result;
+    const auto xml = inputData.primaryXml();
+    result.fileVersion = utils::probeEnigmaXmlFileVersion(std::string_view(xml.data(), xml.size()));
+    if (inputData.notationMetadata) {
+        const utils::XmlHeaderProbe metadata(std::string_view(inputData.notationMetadata->data(), inputData.notationMetadata->size()),
+                                             "metadata/fileInfo");
+        if (const auto creator = metadata.text("metadata/fileInfo/creatorString")) {
+            result.creator = std::string(*creator);
+        }
+    }
+
+    const auto document = createMusxDocument<MusxMetadataReader>(inputData, denigmaContext, PartVoicingPolicy::Ignore, false);
+    for (const auto& fileInfoText : document->getTexts()->getArray<texts::FileInfoText>()) {
+        std::string value = musx::util::EnigmaString::trimTags(fileInfoText->text);
+        switch (fileInfoText->getTextType()) {
+        case texts::FileInfoText::TextType::Title: result.title = std::move(value); break;
+        case texts::FileInfoText::TextType::Subtitle: result.subtitle = std::move(value); break;
+        case texts::FileInfoText::TextType::Composer: result.composer = std::move(value); break;
+        case texts::FileInfoText::TextType::Arranger: result.arranger = std::move(value); break;
+        case texts::FileInfoText::TextType::Lyricist: result.lyricist = std::move(value); break;
+        case texts::FileInfoText::TextType::Copyright: result.copyright = std::move(value); break;
+        case texts::FileInfoText::TextType::Description: result.description = std::move(value); break;
+        default: break;
+        }
+    }
+    for (const auto& part : document->getOthers()->getArray<others::PartDefinition>(SCORE_PARTID)) {
+        if (part->getCmper() != SCORE_PARTID) {
+            result.parts.push_back(part->getName());
+        }
+    }
+    result.measureCount = document->getOthers()->getArray<others::Measure>(SCORE_PARTID).size();
+    result.pageCount = document->getOthers()->getArray<others::Page>(SCORE_PARTID).size();
+    return result;
+}
+
+std::string toJsonLine(const ScoreInfo& info, const std::filesystem::path& source)
+{
+    nlohmann::ordered_json json;
+    json["source"] = utils::pathToString(source);
+    json["title"] = info.title;
+    json["subtitle"] = info.subtitle;
+    json["composer"] = info.composer;
+    json["arranger"] = info.arranger;
+    json["lyricist"] = info.lyricist;
+    json["copyright"] = info.copyright;
+    json["description"] = info.description;
+    json["parts"] = info.parts;
+    json["measures"] = info.measureCount;
+    json["pages"] = info.pageCount;
+    json["fileVersion"] = info.fileVersion
+        ? nlohmann::ordered_json(std::to_string(info.fileVersion->first) + "." + std::to_string(info.fileVersion->second))
+        : nlohmann::ordered_json(nullptr);
+    json["creator"] = info.creator;
+    // Finale text may carry stray bytes that are not UTF-8; replace them rather than lose the record.
+    return json.dump(-1, ' ', false, nlohmann::ordered_json::error_handler_t::replace) + "\n";
+}
+
+} // namespace info
+} // namespace denigma
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/denigma.h"
+
+namespace denigma {
+namespace info {
+
+/// @struct ScoreInfo
+/// @brief The catalog metadata of one Finale document, as read by probeScoreInfo.
+struct ScoreInfo
+{
+    std::string title;
+    std::string subtitle;
+    std::string composer;
+    std::string arranger;
+    std::string lyricist;
+    std::string copyright;
+    std::string description;
+    std::vector<std::string> parts;                 ///< linked part names, in part order (the score itself is omitted)
+    std::size_t measureCount{};
+    std::size_t pageCount{};                        ///< pages of the score
+    std::optional<std::pair<int, int>> fileVersion; ///< Finale (major, minor) file version from the EnigmaXML header
+    std::string creator;                            ///< creatorString from NotationMetadata.xml, if the archive has one
+};
+
+/// @brief Reads the catalog metadata of a Finale document without converting it.
+///
+/// The version comes from the EnigmaXML header and the creator from NotationMetadata.xml, both probed without a
+/// full parse. The rest comes from a DOM built with MusxMetadataReader, which drops the entries and details (the
+/// bulk of any score) before parsing. Embedded graphics are never inflated.
+ScoreInfo probeScoreInfo(const CommandInputData& inputData, const DenigmaContext& denigmaContext);
+
+/// @brief Formats info as a single-line JSON object terminated by a newline, for JSON Lines output.
+/// @param source the input path recorded in the "source" field.
+std::string toJsonLine(const ScoreInfo& info, const std::filesystem::path& source);
+
+} // namespace info
+} // namespace denigma
@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "denigma/io/http_random_access_reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include <curl/curl.h>
+
+namespace denigma {
+
+namespace {
+
+constexpr long HTTP_OK = 200;
+constexpr long HTTP_PARTIAL_CONTENT = 206;
+
+struct HttpResponse
+{
+    long status{};
+    std::vector<std::byte> body;
+    std::optional<std::uint64_t> totalSize; ///< from `Content-Range: bytes first-last/total`
+};
+
+size_t appendBody(char* data, size_t size, size_t count, void* userData)
+{
+    auto* response = static_cast<HttpResponse*>(userData);
+    const auto* bytes = reinterpret_cast<const std::byte*>(data);
+    response->body.insert(response->body.end(), bytes, bytes + size * count);
+    return size * count;
+}
+
+size_t readHeader(char* data, size_t size, size_t count, void* userData)
+{
+    constexpr std::string_view CONTENT_RANGE = "content-range:";
+    const std::string_view line(data, size * count);
+    const bool isContentRange = line.size() > CONTENT_RANGE.size()
+        && std::equal(CONTENT_RANGE.begin(), CONTENT_RANGE.end(), line.begin(), [](char expected, char actual) {
+               return expected == std::tolower(static_cast<unsigned char>(actual));
+           });
+    if (isContentRange) {
+        if (const auto slash = line.find('/'); slash != std::string_view::npos) {
+            std::uint64_t total{};
+            const auto* first = line.data() + slash + 1;
+            const auto [end, ec] = std::from_chars(first, line.data() + line.size(), total);
+            if (ec == std::errc() && end != first) {
+                static_cast<HttpResponse*>(userData)->totalSize = total;
+            }
+        }
+    }
+    return size * count;
+}
+
+} // namespace
+
+struct HttpRandomAccessReader::State
+{
+    std::string url;
+    Options options;
+    curl_slist* headers{};
+    std::uint64_t size{};
+    std::atomic<std::uint64_t> requests{};
+
+    std::mutex handleMutex;
+    std::vector<CURL*> idleHandles; ///< reused so that connections stay open between requests
+
+    std::mutex segmentMutex;
+    std::map<std::uint64_t, std::vector<std::byte>> segments; ///< prefetched bytes, keyed by offset
+
+    ~State()
+    {
+        for (CURL* handle : idleHandles) {
+            curl_easy_cleanup(handle);
+        }
+        curl_slist_free_all(headers);
+    }
+
+    /// Issues one GET with the given Range value (without the `bytes=` prefix).
+    HttpResponse get(const std::string& range)
+    {
+        CURL* handle = nullptr;
+        {
+            std::lock_guard lock(handleMutex);
+            if (!idleHandles.empty()) {
+                handle = idleHandles.back();
+                idleHandles.pop_back();
+            }
+        }
+        if (!handle && !(handle = curl_easy_init())) {
+            throw std::runtime_error("unable to create HTTP request");
+        }
+        struct Lease
+        {
+            State& state;
+            CURL* handle;
+            ~Lease()
+            {
+                curl_easy_reset(handle);
+                std::lock_guard lock(state.handleMutex);
+                state.idleHandles.push_back(handle);
+            }
+        } lease{ *this, handle };
+
+        HttpResponse response;
+        curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+        if (headers) {
+            curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+        }
+        curl_easy_setopt(handle, CURLOPT_RANGE, range.c_str());
+        curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(handle, CURLOPT_TIMEOUT, options.timeoutSeconds);
+        curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, appendBody);
+        curl_easy_setopt(handle, CURLOPT_WRITEDATA, &response);
+        curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, readHeader);
+        curl_easy_setopt(handle, CURLOPT_HEADERDATA, &response);
+        requests++;
+        const CURLcode rc = curl_easy_perform(handle);
+        if (rc != CURLE_OK) {
+            throw std::runtime_error(std::string("HTTP range request failed: ") + curl_easy_strerror(rc));
+        }
+        curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response.status);
+        return response;
+    }
+
+    void store(std::uint64_t offset, std::vector<std::byte>&& data)
+    {
+        std::lock_guard lock(segmentMutex);
+        auto& segment = segments[offset];
+        if (data.size() > segment.size()) {
+            segment = std::move(data);
+        }
+    }
+
+    /// Fetches exactly length bytes at offset, which must lie within the object.
+    std::vector<std::byte> fetch(std::uint64_t offset, std::uint64_t length)
+    {
+        HttpResponse response = get(std::to_string(offset) + "-" + std::to_string(offset + length - 1));
+        if (response.status == HTTP_OK) {
+            // The server ignored the range and sent the whole object, so keep it and serve every read from it.
+            if (response.body.size() != size) {
+                throw std::runtime_error("HTTP object changed size while it was being read");
+            }
+            std::vector<std::byte> slice(response.body.begin() + static_cast<std::ptrdiff_t>(offset),
+                                         response.body.begin() + static_cast<std::ptrdiff_t>(offset + length));
+            store(0, std::move(response.body));
+            return slice;
+        }
+        if (response.status != HTTP_PARTIAL_CONTENT || response.body.size() != length) {
+            throw std::runtime_error("HTTP server returned an unexpected response to a range request");
+        }
+        return std::move(response.body);
+    }
+
+    bool copyFromSegments(std::uint64_t offset, std::span<std::byte> output)
+    {
+        std::lock_guard lock(segmentMutex);
+        auto it = segments.upper_bound(offset);
+        if (it == segments.begin()) {
+            return false;
+        }
+        --it;
+        if (it->first + it->second.size() < offset + output.size()) {
+            return false;
+        }
+        std::memcpy(output.data(), it->second.data() + (offset - it->first), output.size());
+        return true;
+    }
+};
+
+HttpRandomAccessReader::HttpRandomAccessReader(const std::string& url)
+    : HttpRandomAccessReader(url, Options{})
+{
+}
+
+HttpRandomAccessReader::HttpRandomAccessReader(const std::string& url, const Options& options)
+    : m_state(std::make_unique<State>())
+{
+    static std::once_flag curlInitialized;
+    std::call_once(curlInitialized, [] {
+        if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+            throw std::runtime_error("unable to initialize libcurl");
+        }
+    });
+
+    m_state->url = url;
+    m_state->options = options;
+    for (const auto& header : options.headers) {
+        curl_slist* appended = curl_slist_append(m_state->headers, header.c_str());
+        if (!appended) {
+            throw std::runtime_error("unable to add HTTP request header");
+        }
+        m_state->headers = appended;
+    }
+
+    // A suffix range returns the tail (and with it a zip central directory) together with the object size.
+    HttpResponse response = m_state->get("-" + std::to_string((std::max<std::size_t>)(options.tailBytes, 1)));
+    if (response.status == HTTP_OK) {
+        m_state->size = response.body.size();
+        m_state->store(0, std::move(response.body));
+    } else if (response.status == HTTP_PARTIAL_CONTENT && response.totalSize) {
+        m_state->size = *response.totalSize;
+        if (response.body.size() > m_state->size) {
+            throw std::runtime_error("HTTP server returned more bytes than the object holds");
+        }
+        m_state->store(m_state->size - response.body.size(), std::move(response.body));
+    } else {
+        throw std::runtime_error("HTTP server did not report the size of " + url);
+    }
+}
+
+HttpRandomAccessReader::~HttpRandomAccessReader() = default;
+
+std::uint64_t HttpRandomAccessReader::size() const
+{
+    return m_state->size;
+}
+
+std::uint64_t HttpRandomAccessReader::requestCount() const
+{
+    return m_state->requests;
+}
+
+std::size_t HttpRandomAccessReader::readAt(std::uint64_t offset, std::span<std::byte> output) const
+{
+    if (offset >= m_state->size || output.empty()) {
+        return 0;
+    }
+
+    const auto available = static_cast<std::size_t>(std::min<std::uint64_t>(m_state->size - offset, output.size()));
+    const auto target = output.first(available);
+    if (!m_state->copyFromSegments(offset, target)) {
+        const auto data = m_state->fetch(offset, available);
+        std::memcpy(target.data(), data.data(), available);
+    }
+    return available;
+}
+
+void HttpRandomAccessReader::prefetch(std::span<const ByteRange> ranges) const
+{
+    // Clamp, sort and merge the hints so that nearby entries cost one request.
+    std::vector<ByteRange> pending;
+    for (const auto& range : ranges) {
+        if (range.offset < m_state->size && range.length > 0) {
+            pending.push_back({ range.offset, (std::min)(range.length, m_state->size - range.offset) });
+        }
+    }
+    std::sort(pending.begin(), pending.end(), [](const ByteRange& a, const ByteRange& b) { return a.offset < b.offset; });
+    std::vector<ByteRange> merged;
+    for (const auto& range : pending) {
+        if (!merged.empty() && range.offset <= merged.back().offset + merged.back().length + m_state->options.coalesceGapBytes) {
+            const std::uint64_t end = (std::max)(merged.back().offset + merged.back().length, range.offset + range.length);
+            merged.back().length = end - merged.back().offset;
+        } else {
+            merged.push_back(range);
+        }
+    }
+    std::erase_if(merged, [&](const ByteRange& range) {
+        std::lock_guard lock(m_state->segmentMutex);
+        auto it = m_state->segments.upper_bound(range.offset);
+        return it != m_state->segments.begin()
+            && std::prev(it)->first + std::prev(it)->second.size() >= range.offset + range.length;
+    });
+    if (merged.empty()) {
+        return;
+    }
+
+    std::atomic<std::size_t> nextRange{};
+    auto worker = [&] {
+        for (std::size_t index = nextRange++; index < merged.size(); index = nextRange++) {
+            try {
+                m_state->store(merged[index].offset, m_state->fetch(merged[index].offset, merged[index].length));
+            } catch (...) {
+                // a prefetch is only a hint; the read itself will retry and report the failure
+            }
+        }
+    };
+    const std::size_t workerCount = (std::clamp<std::size_t>)(m_state->options.maxParallelRequests, 1, merged.size());
+    std::vector<std::jthread> workers;
+    workers.reserve(workerCount - 1);
+    for (std::size_t i = 1; i < workerCount; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+}
+
+} // namespace denigma
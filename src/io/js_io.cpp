@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "denigma/io/js_io.h"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__EMSCRIPTEN_PTHREADS__)
+#include <emscripten/proxying.h>
+#endif
+
+namespace denigma {
+
+namespace {
+
+/// Runs function on owner, the thread whose JavaScript values it touches, and waits for it. Exceptions are rethrown
+/// on the calling thread.
+void runOnOwnerThread(pthread_t owner, const std::function<void()>& function)
+{
+#if defined(__EMSCRIPTEN_PTHREADS__)
+    if (!pthread_equal(pthread_self(), owner)) {
+        struct Call
+        {
+            const std::function<void()>* function{};
+            std::exception_ptr error;
+        } call{ &function, {} };
+        // the call runs when the owner returns to its event loop or waits on a lock inside the library
+        const int proxied = emscripten_proxy_sync(emscripten_proxy_get_system_queue(), owner, [](void* arg) {
+            auto* call = static_cast<Call*>(arg);
+            try {
+                (*call->function)();
+            } catch (...) {
+                call->error = std::current_exception();
+            }
+        }, &call);
+        if (!proxied) {
+            throw std::runtime_error("the thread that owns a JavaScript I/O object has exited");
+        }
+        if (call.error) {
+            std::rethrow_exception(call.error);
+        }
+        return;
+    }
+#else
+    (void)owner;
+#endif
+    function();
+}
+
+emscripten::val memoryView(std::span<const std::byte> data)
+{
+    return emscripten::val(emscripten::typed_memory_view(data.size(), reinterpret_cast<const unsigned char*>(data.data())));
+}
+
+} // namespace
+
+JsRandomAccessReader::JsRandomAccessReader(emscripten::val source)
+    : m_source(std::move(source)), m_owner(pthread_self())
+{
+    if (!m_source["readInto"].isUndefined() && m_source["size"].isNumber()) {
+        const double size = m_source["size"].as<double>();
+        m_size = size > 0 ? static_cast<std::uint64_t>(size) : 0;
+    } else {
+        throw std::invalid_argument("JsRandomAccessReader requires a source with a numeric size and a readInto method");
+    }
+}
+
+std::uint64_t JsRandomAccessReader::size() const
+{
+    return m_size;
+}
+
+std::size_t JsRandomAccessReader::readAt(std::uint64_t offset, std::span<std::byte> output) const
+{
+    if (offset >= m_size || output.empty()) {
+        return 0;
+    }
+
+    const auto available = static_cast<std::size_t>(std::min<std::uint64_t>(m_size - offset, output.size()));
+    std::size_t bytesRead = 0;
+    runOnOwnerThread(m_owner, [&]() {
+        const emscripten::val copied = m_source.call<emscripten::val>("readInto", static_cast<double>(offset),
+                                                                      memoryView(output.first(available)));
+        const double count = copied.isNumber() ? copied.as<double>() : 0.0;
+        bytesRead = count > 0 ? (std::min)(static_cast<std::size_t>(count), available) : 0;
+    });
+    return bytesRead;
+}
+
+void JsRandomAccessReader::prefetch(std::span<const ByteRange> ranges) const
+{
+    if (ranges.empty()) {
+        return;
+    }
+    runOnOwnerThread(m_owner, [&]() {
+        if (m_source["prefetch"].isUndefined()) {
+            return;
+        }
+        emscripten::val jsRanges = emscripten::val::array();
+        for (const ByteRange& range : ranges) {
+            emscripten::val jsRange = emscripten::val::object();
+            jsRange.set("offset", static_cast<double>(range.offset));
+            jsRange.set("length", static_cast<double>(range.length));
+            jsRanges.call<void>("push", jsRange);
+        }
+        m_source.call<void>("prefetch", jsRanges);
+    });
+}
+
+JsMultiOutputSink::JsMultiOutputSink(emscripten::val target)
+    : m_target(std::move(target)), m_owner(pthread_self())
+{
+    if (m_target["begin"].isUndefined() || m_target["write"].isUndefined() || m_target["end"].isUndefined()) {
+        throw std::invalid_argument("JsMultiOutputSink requires a target with begin, write and end methods");
+    }
+}
+
+bool JsMultiOutputSink::begin(std::string_view suggestedName)
+{
+    bool accepted = true;
+    runOnOwnerThread(m_owner, [&]() {
+        const emscripten::val result = m_target.call<emscripten::val>("begin", std::string(suggestedName));
+        accepted = !(result.isFalse());
+    });
+    return accepted;
+}
+
+void JsMultiOutputSink::write(std::span<const std::byte> data)
+{
+    if (data.empty()) {
+        return;
+    }
+    runOnOwnerThread(m_owner, [&]() { m_target.call<void>("write", memoryView(data)); });
+}
+
+void JsMultiOutputSink::end()
+{
+    runOnOwnerThread(m_owner, [&]() { m_target.call<void>("end"); });
+}
+
+} // namespace denigma
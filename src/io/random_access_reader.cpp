@@ -20,24 +20,63 @@
 
 #include <algorithm>
 #include <cstring>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace denigma {
 
 FileRandomAccessReader::FileRandomAccessReader(const std::filesystem::path& path)
-    : m_file(path, std::ios::binary)
 {
-    if (!m_file) {
+#ifdef _WIN32
+    // FILE_FLAG_OVERLAPPED is deliberately omitted: synchronous handles still honor the OVERLAPPED offset
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
         throw std::runtime_error("unable to open random-access input file");
     }
-
-    m_file.seekg(0, std::ios::end);
-    const auto end = m_file.tellg();
-    if (end < 0) {
+    LARGE_INTEGER fileSize{};
+    if (!::GetFileSizeEx(file, &fileSize)) {
+        ::CloseHandle(file);
+        throw std::runtime_error("unable to determine random-access input file size");
+    }
+    m_handle = file;
+    m_size = static_cast<std::uint64_t>(fileSize.QuadPart);
+#else
+    m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        throw std::runtime_error("unable to open random-access input file");
+    }
+    struct stat fileStat{};
+    if (::fstat(m_fd, &fileStat) != 0) {
+        ::close(m_fd);
         throw std::runtime_error("unable to determine random-access input file size");
     }
-    m_size = static_cast<std::uint64_t>(end);
-    m_file.seekg(0, std::ios::beg);
+    m_size = static_cast<std::uint64_t>(fileStat.st_size);
+#endif
+}
+
+FileRandomAccessReader::~FileRandomAccessReader()
+{
+#ifdef _WIN32
+    ::CloseHandle(static_cast<HANDLE>(m_handle));
+#else
+    ::close(m_fd);
+#endif
 }
 
 std::uint64_t FileRandomAccessReader::size() const
@@ -52,16 +91,127 @@ std::size_t FileRandomAccessReader::readAt(std::uint64_t offset, std::span<std::
     }
 
     const auto available = static_cast<std::size_t>(std::min<std::uint64_t>(m_size - offset, output.size()));
-    m_file.clear();
-    m_file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
-    if (!m_file) {
-        throw std::runtime_error("unable to seek random-access input file");
+    std::size_t totalRead = 0;
+    while (totalRead < available) {
+        const std::uint64_t position = offset + totalRead;
+#ifdef _WIN32
+        constexpr std::size_t kMaxChunk = (std::numeric_limits<DWORD>::max)();
+        const DWORD chunk = static_cast<DWORD>((std::min)(available - totalRead, kMaxChunk));
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFFu);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        DWORD bytesRead{};
+        if (!::ReadFile(static_cast<HANDLE>(m_handle), output.data() + totalRead, chunk, &bytesRead, &overlapped)) {
+            if (::GetLastError() == ERROR_HANDLE_EOF) {
+                break;
+            }
+            throw std::runtime_error("unable to read random-access input file");
+        }
+#else
+        const ssize_t bytesRead = ::pread(m_fd, output.data() + totalRead, available - totalRead, static_cast<off_t>(position));
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("unable to read random-access input file");
+        }
+#endif
+        if (bytesRead == 0) {
+            break; // file was truncated after it was opened
+        }
+        totalRead += static_cast<std::size_t>(bytesRead);
     }
-    m_file.read(reinterpret_cast<char*>(output.data()), static_cast<std::streamsize>(available));
-    if (m_file.bad()) {
-        throw std::runtime_error("unable to read random-access input file");
+    return totalRead;
+}
+
+MappedFileRandomAccessReader::MappedFileRandomAccessReader(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("unable to open memory-mapped input file");
     }
-    return static_cast<std::size_t>(m_file.gcount());
+    LARGE_INTEGER fileSize{};
+    if (!::GetFileSizeEx(file, &fileSize)) {
+        ::CloseHandle(file);
+        throw std::runtime_error("unable to determine memory-mapped input file size");
+    }
+    m_size = static_cast<std::uint64_t>(fileSize.QuadPart);
+    if (m_size > 0) {
+        HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            ::CloseHandle(file);
+            throw std::runtime_error("unable to create memory mapping for input file");
+        }
+        // the view keeps the mapping object and the file alive after their handles are closed
+        const void* view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        ::CloseHandle(mapping);
+        if (!view) {
+            ::CloseHandle(file);
+            throw std::runtime_error("unable to map input file into memory");
+        }
+        m_data = static_cast<const std::byte*>(view);
+    }
+    ::CloseHandle(file);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("unable to open memory-mapped input file");
+    }
+    struct stat fileStat{};
+    if (::fstat(fd, &fileStat) != 0) {
+        ::close(fd);
+        throw std::runtime_error("unable to determine memory-mapped input file size");
+    }
+    m_size = static_cast<std::uint64_t>(fileStat.st_size);
+    if (m_size > (std::numeric_limits<std::size_t>::max)()) {
+        ::close(fd);
+        throw std::runtime_error("memory-mapped input file is too large for this platform");
+    }
+    if (m_size > 0) {
+        // the mapping remains valid after the descriptor is closed
+        void* view = ::mmap(nullptr, static_cast<std::size_t>(m_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("unable to map input file into memory");
+        }
+        m_data = static_cast<const std::byte*>(view);
+    }
+    ::close(fd);
+#endif
+}
+
+MappedFileRandomAccessReader::~MappedFileRandomAccessReader()
+{
+    if (!m_data) {
+        return;
+    }
+#ifdef _WIN32
+    ::UnmapViewOfFile(m_data);
+#else
+    ::munmap(const_cast<std::byte*>(m_data), static_cast<std::size_t>(m_size));
+#endif
+}
+
+std::uint64_t MappedFileRandomAccessReader::size() const
+{
+    return m_size;
+}
+
+std::size_t MappedFileRandomAccessReader::readAt(std::uint64_t offset, std::span<std::byte> output) const
+{
+    if (offset >= m_size || output.empty()) {
+        return 0;
+    }
+
+    const auto available = static_cast<std::size_t>(std::min<std::uint64_t>(m_size - offset, output.size()));
+    std::memcpy(output.data(), m_data + offset, available);
+    return available;
+}
+
+std::span<const std::byte> MappedFileRandomAccessReader::data() const
+{
+    return { m_data, static_cast<std::size_t>(m_size) };
 }
 
 BufferRandomAccessReader::BufferRandomAccessReader(std::span<const std::byte> data)
@@ -85,4 +235,154 @@ std::size_t BufferRandomAccessReader::readAt(std::uint64_t offset, std::span<std
     return available;
 }
 
+CallbackRandomAccessReader::CallbackRandomAccessReader(std::uint64_t size, ReadFunction read, PrefetchFunction prefetch)
+    : m_size(size), m_read(std::move(read)), m_prefetch(std::move(prefetch))
+{
+    if (!m_read) {
+        throw std::invalid_argument("CallbackRandomAccessReader requires a read function");
+    }
+}
+
+std::uint64_t CallbackRandomAccessReader::size() const
+{
+    return m_size;
+}
+
+std::size_t CallbackRandomAccessReader::readAt(std::uint64_t offset, std::span<std::byte> output) const
+{
+    if (offset >= m_size || output.empty()) {
+        return 0;
+    }
+
+    const auto available = static_cast<std::size_t>(std::min<std::uint64_t>(m_size - offset, output.size()));
+    return (std::min)(m_read(offset, output.first(available)), available);
+}
+
+void CallbackRandomAccessReader::prefetch(std::span<const ByteRange> ranges) const
+{
+    if (m_prefetch) {
+        m_prefetch(ranges);
+    }
+}
+
+struct CachingRandomAccessReader::Cache
+{
+    struct Block
+    {
+        std::uint64_t index{};
+        std::vector<std::byte> data;
+    };
+
+    std::mutex mutex;
+    std::list<Block> blocks; ///< most recently used first
+    std::unordered_map<std::uint64_t, std::list<Block>::iterator> blocksByIndex;
+    std::uint64_t lastBlockRead{ (std::numeric_limits<std::uint64_t>::max)() };
+    std::uint64_t sourceReads{};
+};
+
+CachingRandomAccessReader::CachingRandomAccessReader(const IRandomAccessReader& source)
+    : CachingRandomAccessReader(source, Options{})
+{
+}
+
+CachingRandomAccessReader::CachingRandomAccessReader(const IRandomAccessReader& source, const Options& options)
+    : m_source(source), m_options(options), m_cache(std::make_unique<Cache>())
+{
+    if (m_options.blockSize == 0 || m_options.maxCachedBlocks == 0) {
+        throw std::invalid_argument("caching reader block size and cache size must be non-zero");
+    }
+}
+
+CachingRandomAccessReader::~CachingRandomAccessReader() = default;
+
+std::uint64_t CachingRandomAccessReader::size() const
+{
+    return m_source.size();
+}
+
+void CachingRandomAccessReader::prefetch(std::span<const ByteRange> ranges) const
+{
+    m_source.prefetch(ranges);
+}
+
+std::uint64_t CachingRandomAccessReader::sourceReadCount() const
+{
+    std::lock_guard lock(m_cache->mutex);
+    return m_cache->sourceReads;
+}
+
+std::size_t CachingRandomAccessReader::readAt(std::uint64_t offset, std::span<std::byte> output) const
+{
+    const std::uint64_t sourceSize = m_source.size();
+    if (offset >= sourceSize || output.empty()) {
+        return 0;
+    }
+
+    const auto available = static_cast<std::size_t>(std::min<std::uint64_t>(sourceSize - offset, output.size()));
+    const std::uint64_t blockSize = m_options.blockSize;
+    const std::uint64_t blockCount = (sourceSize + blockSize - 1) / blockSize;
+    const std::uint64_t firstBlock = offset / blockSize;
+    const std::uint64_t lastBlock = (offset + available - 1) / blockSize;
+
+    std::lock_guard lock(m_cache->mutex);
+    Cache& cache = *m_cache;
+    const bool sequential = cache.lastBlockRead != (std::numeric_limits<std::uint64_t>::max)()
+        && (firstBlock == cache.lastBlockRead || firstBlock == cache.lastBlockRead + 1);
+
+    // Fetches the run of missing blocks starting at block in one read of the source, extending it past lastBlock
+    // for read-ahead when this read continues the previous one.
+    auto fetchRun = [&](std::uint64_t block) {
+        std::uint64_t runEnd = block + 1;
+        const std::uint64_t readAheadEnd = (std::min)(blockCount, lastBlock + 1 + (sequential ? m_options.readAheadBlocks : 0));
+        while (runEnd < readAheadEnd && !cache.blocksByIndex.contains(runEnd)) {
+            runEnd++;
+        }
+        const std::uint64_t runOffset = block * blockSize;
+        const auto runBytes = static_cast<std::size_t>((std::min)(runEnd * blockSize, sourceSize) - runOffset);
+        std::vector<std::byte> run(runBytes);
+        std::size_t runRead = 0;
+        while (runRead < runBytes) {
+            cache.sourceReads++;
+            const std::size_t bytesRead = m_source.readAt(runOffset + runRead, std::span<std::byte>(run).subspan(runRead));
+            if (bytesRead == 0) {
+                break; // the source is shorter than it reported
+            }
+            runRead += bytesRead;
+        }
+        for (std::uint64_t next = block; next < runEnd; next++) {
+            const auto begin = static_cast<std::size_t>((std::min<std::uint64_t>)((next - block) * blockSize, runRead));
+            const auto end = static_cast<std::size_t>((std::min<std::uint64_t>)((next - block + 1) * blockSize, runRead));
+            cache.blocks.push_front({ next, std::vector<std::byte>(run.begin() + begin, run.begin() + end) });
+            cache.blocksByIndex[next] = cache.blocks.begin();
+        }
+    };
+
+    std::size_t copied = 0;
+    for (std::uint64_t block = firstBlock; block <= lastBlock; block++) {
+        auto it = cache.blocksByIndex.find(block);
+        if (it == cache.blocksByIndex.end()) {
+            fetchRun(block);
+            it = cache.blocksByIndex.find(block);
+        }
+        cache.blocks.splice(cache.blocks.begin(), cache.blocks, it->second);
+        const auto& data = it->second->data;
+        const std::uint64_t blockOffset = block * blockSize;
+        const auto start = static_cast<std::size_t>(offset + copied - blockOffset);
+        if (start >= data.size()) {
+            break; // short block from a truncated source
+        }
+        const std::size_t count = (std::min)(data.size() - start, available - copied);
+        std::memcpy(output.data() + copied, data.data() + start, count);
+        copied += count;
+    }
+    cache.lastBlockRead = lastBlock;
+
+    // Every block of this read was just moved to the front, so eviction only drops older ones.
+    while (cache.blocks.size() > (std::max)(m_options.maxCachedBlocks, static_cast<std::size_t>(lastBlock - firstBlock + 1))) {
+        cache.blocksByIndex.erase(cache.blocks.back().index);
+        cache.blocks.pop_back();
+    }
+    return copied;
+}
+
 } // namespace denigma
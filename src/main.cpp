@@ -20,30 +20,59 @@
  * THE SOFTWARE.
  */
 #include <iostream>
+#include <deque>
+#include <limits>
 #include <map>
 #include <unordered_set>
 #include <optional>
 #include <memory>
 #include <chrono>
 #include <fstream>
-#include <regex>
 #include <stdexcept>
 #include <clocale>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <span>
 
+#include "core/batch_manifest.h"
 #include "core/denigma.h"
+#include "core/directory_walker.h"
+#include "core/duplicate_inputs.h"
+#include "core/forked_workers.h"
+#include "core/host_resources.h"
 #include "export/export.h"
+#include "info/info.h"
 #include "massage/massage.h"
+#include "serve/serve.h"
+#include "utils/output_archive.h"
+#include "utils/smufl_support.h"
 #include "utils/stringutils.h"
+#include "utils/textmetrics.h"
+#include "utils/ziputils.h"
 
-static const auto registeredCommands = []()
-    {
-        std::map <std::string, std::shared_ptr <denigma::ICommand>> retval;
-        auto exportCmd = std::make_shared<denigma::ExportCommand>();
-        retval.emplace(exportCmd->commandName(), exportCmd);
-        auto massageCommand = std::make_shared<denigma::MassageCommand>();
-        retval.emplace(massageCommand->commandName(), massageCommand);
-        return retval;
-    }();
+/// The commands by name, built on first use rather than during static initialization, so that runs which never
+/// reach a command (--version, --help) do not pay for them.
+static const std::map<std::string, std::shared_ptr<denigma::ICommand>>& registeredCommands()
+{
+    static const auto commands = []()
+        {
+            std::map <std::string, std::shared_ptr <denigma::ICommand>> retval;
+            auto exportCmd = std::make_shared<denigma::ExportCommand>();
+            retval.emplace(exportCmd->commandName(), exportCmd);
+            auto massageCommand = std::make_shared<denigma::MassageCommand>();
+            retval.emplace(massageCommand->commandName(), massageCommand);
+            auto infoCommand = std::make_shared<denigma::InfoCommand>();
+            retval.emplace(infoCommand->commandName(), infoCommand);
+            return retval;
+        }();
+    return commands;
+}
 
 static int showHelpPage(const std::string_view& programName)
 {
@@ -53,17 +82,38 @@ static int showHelpPage(const std::string_view& programName)
     // General options
     std::cout << "General options:" << std::endl;
     std::cout << "  --about                         Show acknowledgements and exit" << std::endl;
+    std::cout << "  --cache-dir folder-name         Cache the EnigmaXML inflated from each musx here and reuse it for unchanged files" << std::endl;
     std::cout << "  --exclude folder-name           Exclude the specified folder name from recursive searches" << std::endl;
     std::cout << "  --help                          Show this help message and exit" << std::endl;
+    std::cout << "  --incremental [manifest-path]   Skip inputs unchanged since the last run (manifest default: .denigma-manifest in the input folder)" << std::endl;
     std::cout << "  --force                         Overwrite existing file(s)" << std::endl;
+    std::cout << "  --jobs [optional-count]         Process up to count input files in parallel (all available cores if count is omitted or 0)" << std::endl;
+    std::cout << "  --isolate [optional-seconds]    Convert each input in a worker process, replacing any that crashes or runs past the timeout (default 600, 0 for none)" << std::endl;
+    std::cout << "  --file-timeout <seconds>        Cancel and report as an error any input still converting after seconds (with --isolate, replaces its worker)" << std::endl;
+    std::cout << "  --prefetch [depth]              Convert one input at a time, reading and inflating up to depth inputs ahead (default 1)" << std::endl;
+    std::cout << "  --pipeline [read-count]         Read and inflate inputs on count threads (default 2) ahead of the --jobs converting workers" << std::endl;
+    std::cout << "  --dedupe [copy|link]            Convert byte-identical inputs once and copy (or hard-link) the outputs for the others" << std::endl;
+    std::cout << "  --memory-budget <n>             With --jobs, start a file only while the estimated memory of the files in progress fits n bytes (K, M or G suffix allowed)" << std::endl;
+    std::cout << "  --output-jobs [optional-count]  Build up to count outputs of one file (output formats, score/parts, MusicXML measure ranges, SVG shapes, musx blocks) in parallel" << std::endl;
+    std::cout << "  --output-archive file-name      Write every export output into one zip archive (with an index) instead of separate files" << std::endl;
+    std::cout << "  --output-archive-shard-size <n> Start a new archive shard once one holds n bytes (K, M or G suffix allowed)" << std::endl;
+    std::cout << "  --write-behind                  Write output files from a background thread so conversion does not wait on the disk" << std::endl;
+    std::cout << "  --write-behind-queue-size <n>   Same, holding at most n bytes of unwritten output (default 64M)" << std::endl;
     std::cout << "  --part [optional-part-name]     Process named part or first part if name is omitted" << std::endl;
     std::cout << "  --recursive                     Recursively search subdirectories of the input directory" << std::endl;
     std::cout << "  --all-parts                     Process all parts and score" << std::endl;
+    std::cout << "  --text-metrics fonts|heuristic  Measure text with the installed fonts (default) or estimate it without loading any" << std::endl;
+    std::cout << "  --trace file-name               Write timing spans of the run to file-name in Chrome trace format (chrome://tracing, Perfetto)" << std::endl;
+    std::cout << "  --trace-slow <threshold>        Convert again with tracing each input slower than threshold: seconds, n times the median (10x) or both (2,10x)" << std::endl;
+    std::cout << "                                  The trace is written next to the log file, or next to the input without one" << std::endl;
+    std::cout << "  --fingerprint-manifest <file>   Append the XXH64 hash, size and name of every output to file, one tab-separated line each" << std::endl;
     std::cout << "  --version                       Show program version and exit" << std::endl;
     std::cout << "  --no-validate                   Skip validation of output results (currently applies only to MNX exports)" << std::endl;
+    std::cout << "  --validate-concurrently         Validate on a worker thread while the output is written" << std::endl;
+    std::cout << "  --validate-every <count>        Validate only the first and every count-th output (default: 1, every output)" << std::endl;
     std::cout << std::endl;
     
-    for (const auto& command : registeredCommands) {
+    for (const auto& command : registeredCommands()) {
         std::string commandStr = "Command " + command.first;
         std::string sepStr(commandStr.size(), '=');
         std::cout << std::endl;
@@ -73,6 +123,16 @@ static int showHelpPage(const std::string_view& programName)
         std::cout << std::endl;
         command.second->showHelpPage(programName, "    ");
     }
+    {
+        const std::string commandStr = "Command serve";
+        const std::string sepStr(commandStr.size(), '=');
+        std::cout << std::endl;
+        std::cout << sepStr << std::endl;
+        std::cout << commandStr << std::endl;
+        std::cout << sepStr << std::endl;
+        std::cout << std::endl;
+        denigma::showServeHelpPage(programName, "    ");
+    }
 
     std::cout << std::endl;
     std::cout << "By default, messages are sent to std::cerr." << std::endl;
@@ -106,6 +166,416 @@ static std::string fileToString(const std::filesystem::path& pathToRead)
 
 using namespace denigma;
 
+static constexpr char DEFAULT_MANIFEST_NAME[] = ".denigma-manifest";
+static constexpr unsigned DIRECTORY_LISTING_THREADS = 4; ///< recursive searches list this many subdirectories at once
+
+using ProcessPathFunc = std::function<void(DenigmaContext& context, const std::filesystem::path& path)>;
+/// Reads a batch input ahead of its conversion, or returns nothing when the conversion will not need it.
+using ReadAheadFunc = std::function<std::optional<DenigmaContext::PrefetchedInput>(const DenigmaContext& context, const std::filesystem::path& path)>;
+
+/// SMuFL fonts whose metadata is loaded before worker processes are forked, since most Finale scores use one of them.
+static constexpr const char* PRELOADED_SMUFL_FONTS[] = { "Finale Maestro", "Finale Broadway", "Finale Jazz", "Finale Engraver",
+    "Finale Ash", "Finale Legacy", "Bravura" };
+
+/// Loads the caches conversions fill on first use, so that worker processes forked afterwards share them.
+static void warmUpSharedCaches(const DenigmaContext& denigmaContext)
+{
+    (void)defaultConverterRegistry();
+    if (denigmaContext.textMetrics == TextMetricsMode::Fonts) {
+        textmetrics::warmUpTextMetrics();
+    }
+    for (const char* fontName : PRELOADED_SMUFL_FONTS) {
+        utils::preloadSmuflMetadata(fontName);
+    }
+}
+
+/// Bytes of peak memory a conversion is assumed to need per byte of its gzip-compressed EnigmaXML (score.dat):
+/// roughly ten times that much XML, plus the parsed document and the musx DOM built from it.
+static constexpr std::uint64_t MEMORY_PER_SCORE_DAT_BYTE = 40;
+/// Bytes of peak memory assumed per byte of an uncompressed input (EnigmaXML, MusicXML or MNX).
+static constexpr std::uint64_t MEMORY_PER_INPUT_BYTE = 4;
+
+/// Reads the zip directory entry of score.dat in the musx file at path, without reporting a file that cannot be read
+/// (its conversion reports it).
+static std::optional<utils::ZipArchiveIndex::Entry> probeScoreDat(const DenigmaContext& denigmaContext, const std::filesystem::path& path)
+{
+    if (!utils::pathExtensionEquals(path, MUSX_EXTENSION)) {
+        return std::nullopt;
+    }
+    DenigmaContext probeContext(denigmaContext);
+    std::vector<DenigmaContext::BufferedLogMessage> discarded;
+    probeContext.logBuffer = &discarded;
+    try {
+        const utils::ZipArchiveIndex archive(path, probeContext);
+        if (const auto* scoreDat = archive.find("score.dat")) {
+            return *scoreDat;
+        }
+    } catch (const std::exception&) {
+    }
+    return std::nullopt;
+}
+
+/// Estimates the peak memory of converting the file at path. For a musx file only the zip central directory is read,
+/// for the stored and compressed sizes of score.dat; the larger is used, since a deflated entry inflates to the
+/// stored gzip stream. Anything that cannot be read that way is estimated from its file size.
+static std::uint64_t estimateConversionBytes(const DenigmaContext& denigmaContext, const std::filesystem::path& path)
+{
+    if (const auto scoreDat = probeScoreDat(denigmaContext, path)) {
+        return (std::max)(scoreDat->uncompressedSize, scoreDat->compressedSize) * MEMORY_PER_SCORE_DAT_BYTE;
+    }
+    std::error_code ec;
+    const auto fileSize = std::filesystem::file_size(path, ec);
+    return ec ? 0 : std::uint64_t(fileSize) * MEMORY_PER_INPUT_BYTE;
+}
+
+/// The key DuplicateInputs groups inputs by before hashing them in full: the file size, mixed with the CRC of
+/// score.dat for a musx file.
+static std::uint64_t quickContentKey(const DenigmaContext& denigmaContext, const std::filesystem::path& path)
+{
+    std::error_code ec;
+    const std::uint64_t fileSize = std::filesystem::file_size(path, ec);
+    const auto scoreDat = probeScoreDat(denigmaContext, path);
+    return (ec ? 0 : fileSize) ^ (std::uint64_t(scoreDat ? scoreDat->crc : 0) << 32);
+}
+
+/// Gives inputPath copies (or hard links) of the outputs written for original, each named for inputPath the way it
+/// was named for the original. Returns false without writing anything if an output was not written next to the
+/// original under the original's name, since where this input's counterpart belongs is then unknown.
+static bool copyDuplicateOutputs(DenigmaContext& context, const DuplicateInputs::Original& original, const std::filesystem::path& inputPath)
+{
+    const auto originalStem = original.inputPath.stem().native();
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> copies;
+    for (const auto& output : original.outputs) {
+        const auto fileName = output.filename().native();
+        if (output.parent_path().lexically_normal() != original.inputPath.parent_path().lexically_normal()
+            || !fileName.starts_with(originalStem)) {
+            return false;
+        }
+        copies.emplace_back(output, inputPath.parent_path() / (inputPath.stem().native() + fileName.substr(originalStem.size())));
+    }
+
+    context.logMessage(LogMsg() << "Processing File: " << utils::asUtf8Bytes(inputPath) << " (same content as "
+        << utils::asUtf8Bytes(original.inputPath) << ")", true);
+    context.inputFilePath = inputPath;
+    for (const auto& [from, to] : copies) {
+        if (!context.validatePathsAndOptions(to)) {
+            continue;
+        }
+        std::error_code ec;
+        if (context.dedupeInputs == DuplicateOutputs::HardLink) {
+            std::filesystem::remove(to, ec); // validation allowed replacing it
+            std::filesystem::create_hard_link(from, to, ec);
+            if (!ec) {
+                continue;
+            }
+            ec.clear(); // e.g. a different volume: fall back to a copy
+        }
+        std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, ec);
+        if (ec) {
+            context.logMessage(LogMsg() << "unable to copy " << utils::asUtf8Bytes(from) << " to " << utils::asUtf8Bytes(to)
+                << " (" << ec.message() << ")", MessageSeverity::Error);
+        }
+    }
+    return true;
+}
+
+/// Swallows the outputs of a conversion that is repeated only to trace it.
+class DiscardedOutputs : public OutputArchive
+{
+public:
+    bool reserve(const std::filesystem::path&) override { return true; }
+    void add(const std::filesystem::path&, std::span<const char>) override {}
+};
+
+/// Converts path again under a trace recorder of its own (--trace-slow), discarding the outputs and messages of the
+/// repeat, since the first conversion already wrote and reported them.
+static void traceSlowFile(DenigmaContext& context, SlowFileTracer& tracer, const std::filesystem::path& path,
+    std::chrono::steady_clock::duration elapsed, const std::function<void(DenigmaContext&)>& convert)
+{
+    std::lock_guard lock(tracer.traceMutex());
+    const auto tracePath = tracer.nextTracePath(path);
+    DenigmaContext traceContext(context);
+    std::vector<DenigmaContext::BufferedLogMessage> discardedLog;
+    traceContext.logBuffer = &discardedLog;
+    traceContext.conversionResult = nullptr;
+    traceContext.prefetchedInput = nullptr;
+    traceContext.outputsWritten = nullptr;
+    traceContext.outputValidated = nullptr;
+    traceContext.outputArchive = std::make_shared<DiscardedOutputs>();
+    traceContext.outputWriter = nullptr;
+    TraceRecorder recorder(tracePath);
+    {
+        TraceFileScope traceFile(path);
+        TraceSpan span("processFile");
+        try {
+            convert(traceContext);
+        } catch (...) {
+            // the first conversion already reported whatever this one throws
+        }
+    }
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    if (recorder.finish()) {
+        context.logMessage(LogMsg() << utils::asUtf8Bytes(path) << " took " << seconds << "s; traced a second conversion to "
+            << utils::asUtf8Bytes(tracePath));
+    } else {
+        context.logMessage(LogMsg() << "Unable to write trace file " << utils::asUtf8Bytes(tracePath), MessageSeverity::Warning);
+    }
+}
+
+/// @class BatchDispatcher
+/// @brief Converts input files as they are submitted, while the caller is still discovering more.
+///
+/// With more than one job, submitted files are queued for jobCount worker threads, which take the queued file with
+/// the largest estimated memory cost first so that a big score found late does not stretch the whole run. With a
+/// memory budget, a worker starts a file only while the estimates of the files in progress plus its own fit the
+/// budget, taking the largest queued file that fits; a file is always started when nothing else is running, so one
+/// larger than the whole budget still runs, alone. Each file's messages are buffered and replayed as one block, in
+/// submission order, on the submitting thread. With a single job each file is converted on the submitting thread as
+/// it is submitted.
+///
+/// With a read-ahead function (--pipeline), reading and inflating a file is a stage of its own: readJobs reader
+/// threads take queued files (largest first, within the memory budget) and hand what they read to the jobCount
+/// converting workers through a ready queue holding at most jobCount files, so one file's disk reads overlap
+/// another's conversion. Output writes overlap it too when the context has an output writer (--write-behind).
+/// readyLimit, when not 0, replaces jobCount as the bound of the ready queue. With a single converting worker
+/// (--prefetch) the files are read and converted in submission order, as they would be without the read stage.
+class BatchDispatcher
+{
+public:
+    BatchDispatcher(DenigmaContext& denigmaContext, const ProcessPathFunc& processPath, unsigned jobCount,
+            ReadAheadFunc readAhead = {}, unsigned readJobs = 0, unsigned readyLimit = 0)
+        : m_denigmaContext(denigmaContext), m_processPath(processPath), m_readAhead(std::move(readAhead)),
+          m_memoryBudget(denigmaContext.memoryBudget), m_readyLimit(readyLimit ? readyLimit : (std::max)(jobCount, 1u)),
+          m_readJobs(m_readAhead ? readJobs : 0), m_inSubmissionOrder(m_readJobs > 0 && jobCount <= 1)
+    {
+        if (m_readJobs > 0) {
+            const unsigned convertJobs = (std::max)(jobCount, 1u);
+            m_workers.reserve(m_readJobs + convertJobs);
+            for (unsigned x = 0; x < m_readJobs; x++) {
+                m_workers.emplace_back([this]() { readerLoop(); });
+            }
+            for (unsigned x = 0; x < convertJobs; x++) {
+                m_workers.emplace_back([this]() { convertLoop(); });
+            }
+        } else if (jobCount > 1) {
+            m_workers.reserve(jobCount);
+            for (unsigned x = 0; x < jobCount; x++) {
+                m_workers.emplace_back([this]() { workerLoop(); });
+            }
+        }
+    }
+
+    ~BatchDispatcher()
+    {
+        finish();
+    }
+
+    BatchDispatcher(const BatchDispatcher&) = delete;
+    BatchDispatcher& operator=(const BatchDispatcher&) = delete;
+
+    void submit(const std::filesystem::path& path)
+    {
+        if (m_workers.empty()) {
+            m_processPath(m_denigmaContext, path);
+            return;
+        }
+        const auto cost = m_inSubmissionOrder ? 0 : estimateConversionBytes(m_denigmaContext, path);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& item = m_items.emplace_back();
+            item.path = path;
+            item.cost = cost;
+            // in submission order, the key counts down so that the earliest file comes first
+            m_queue.emplace(m_inSubmissionOrder ? (std::numeric_limits<std::uint64_t>::max)() - m_submittedCount++ : cost, &item);
+        }
+        m_queueChanged.notify_one();
+        replayFinished(false);
+    }
+
+    /// Waits for every submitted file and replays the remaining messages. Safe to call more than once.
+    void finish()
+    {
+        if (m_workers.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_queueChanged.notify_all();
+        m_readyChanged.notify_all();
+        replayFinished(true);
+        m_workers.clear(); // joins
+    }
+
+private:
+    struct BatchItem;
+    using BatchQueue = std::multimap<std::uint64_t, BatchItem*, std::greater<>>; ///< by cost, largest first
+
+    struct BatchItem
+    {
+        std::filesystem::path path;
+        std::uint64_t cost{};   ///< estimated peak memory of converting it
+        std::vector<DenigmaContext::BufferedLogMessage> log;
+        std::optional<DenigmaContext::PrefetchedInput> prefetched; ///< what the read stage read, when pipelined
+        bool done{};
+    };
+
+    /// The largest queued item that may start now, or end. Must be called with m_mutex held.
+    BatchQueue::iterator admissibleItem()
+    {
+        if (m_memoryBudget == 0 || m_costInProgress == 0 || m_queue.empty() || m_inSubmissionOrder) {
+            return m_queue.begin();
+        }
+        if (m_costInProgress >= m_memoryBudget) {
+            return m_queue.end();
+        }
+        return m_queue.lower_bound(m_memoryBudget - m_costInProgress); // the first cost that is not greater
+    }
+
+    /// Takes the next queued item that may start, waiting until there is one. Returns nullptr once the queue is
+    /// closed and empty. With pipelined set, also waits for room in the ready queue.
+    BatchItem* takeQueuedItem(bool pipelined)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto next = m_queue.end();
+        m_queueChanged.wait(lock, [&]() {
+            if (pipelined && m_ready.size() + m_reading >= m_readyLimit) {
+                return false;
+            }
+            next = admissibleItem();
+            return next != m_queue.end() || (m_closed && m_queue.empty());
+        });
+        if (next == m_queue.end()) {
+            return nullptr;
+        }
+        BatchItem* item = next->second;
+        m_queue.erase(next);
+        m_costInProgress += item->cost;
+        m_reading += pipelined ? 1 : 0;
+        return item;
+    }
+
+    /// Converts item on a copy of the context that captures its messages, then marks it done.
+    void convertItem(BatchItem* item)
+    {
+        try {
+            DenigmaContext workerContext(m_denigmaContext);
+            workerContext.logBuffer = &item->log;
+            workerContext.inputFilePath = "";
+            workerContext.prefetchedInput = item->prefetched ? &item->prefetched.value() : nullptr;
+            m_processPath(workerContext, item->path);
+        } catch (const std::exception& e) {
+            item->log.push_back({ MessageSeverity::Error, e.what(), item->path });
+        }
+        item->prefetched.reset(); // frees the input before the item waits to be replayed
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            item->done = true;
+            m_costInProgress -= item->cost;
+        }
+        m_itemDone.notify_all();
+        if (m_memoryBudget != 0 || m_readJobs != 0) {
+            m_queueChanged.notify_all(); // the freed budget may admit more than one waiting file
+        }
+    }
+
+    void readerLoop()
+    {
+        nameTraceThread("batch reader");
+        while (BatchItem* item = takeQueuedItem(true)) {
+            try {
+                item->prefetched = m_readAhead(m_denigmaContext, item->path);
+            } catch (const std::exception& e) {
+                item->log.push_back({ MessageSeverity::Error, e.what(), item->path });
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_reading--;
+                m_ready.push_back(item);
+            }
+            m_readyChanged.notify_one();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_readersDone++;
+        }
+        m_readyChanged.notify_all();
+    }
+
+    void convertLoop()
+    {
+        nameTraceThread("batch worker");
+        while (true) {
+            BatchItem* item = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_readyChanged.wait(lock, [&]() { return !m_ready.empty() || m_readersDone == m_readJobs; });
+                if (m_ready.empty()) {
+                    return;
+                }
+                item = m_ready.front();
+                m_ready.pop_front();
+            }
+            m_queueChanged.notify_one(); // room in the ready queue for a reader
+            convertItem(item);
+        }
+    }
+
+    void workerLoop()
+    {
+        nameTraceThread("batch worker");
+        while (BatchItem* item = takeQueuedItem(false)) {
+            convertItem(item);
+        }
+    }
+
+    /// Emits the messages of each finished file at the front of the submission order. With wait set, keeps
+    /// waiting until every submitted file has been emitted.
+    void replayFinished(bool wait)
+    {
+        while (true) {
+            BatchItem* item = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if (m_items.empty()) {
+                    return;
+                }
+                item = &m_items.front();
+                if (wait) {
+                    m_itemDone.wait(lock, [item]() { return item->done; });
+                } else if (!item->done) {
+                    return;
+                }
+            }
+            m_denigmaContext.replayBufferedLog(item->log);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_items.pop_front(); // references to the other items stay valid
+        }
+    }
+
+    DenigmaContext& m_denigmaContext;
+    const ProcessPathFunc& m_processPath;
+    const ReadAheadFunc m_readAhead;
+    std::mutex m_mutex;
+    std::condition_variable m_queueChanged;
+    std::condition_variable m_readyChanged;
+    std::condition_variable m_itemDone;
+    std::deque<BatchItem> m_items;          ///< submitted and not yet replayed, in submission order
+    BatchQueue m_queue;                     ///< not yet started
+    std::deque<BatchItem*> m_ready;         ///< read and waiting for a converting worker, when pipelined
+    const std::uint64_t m_memoryBudget;     ///< 0 means unlimited
+    const unsigned m_readyLimit;            ///< files read or being read ahead of the converting workers, at most
+    std::uint64_t m_costInProgress{};       ///< summed estimates of the files being read or converted (none in submission order)
+    unsigned m_reading{};                   ///< files the read stage is reading
+    const unsigned m_readJobs;              ///< reader threads, 0 unless pipelined
+    const bool m_inSubmissionOrder;         ///< whether the queue is keyed by submission rather than cost
+    std::uint64_t m_submittedCount{};
+    unsigned m_readersDone{};               ///< reader threads that have found the queue closed and empty
+    bool m_closed{};
+    std::vector<std::jthread> m_workers;    ///< declared last so the workers are joined before the rest is destroyed
+};
+
 int _MAIN(int argc, arg_char* argv[])
 {
 #ifndef DENIGMA_TEST
@@ -144,15 +614,30 @@ int _MAIN(int argc, arg_char* argv[])
         return 0;
     }
 
+    if (!args.empty() && arg_view(args[0]) == _ARG("serve")) {
+        args.erase(args.begin());
+        MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+        int result = 1;
+        try {
+            denigmaContext.startLogging(std::filesystem::current_path(), argc, argv);
+            result = runServeCommand(denigmaContext, args);
+        } catch (const std::exception& e) {
+            denigmaContext.logMessage(LogMsg() << e.what(), MessageSeverity::Error);
+        }
+        denigmaContext.endLogging();
+        return result;
+    }
+
     const auto currentCommand = [&]() -> std::shared_ptr<ICommand> {
         if (args.empty()) return nullptr;
-        auto it = registeredCommands.find(arg_string(args[0]));
-        if (it != registeredCommands.end()) {
+        const auto& commands = registeredCommands();
+        auto it = commands.find(arg_string(args[0]));
+        if (it != commands.end()) {
             args.erase(args.begin());
             return it->second;
         }
-        it = registeredCommands.find(arg_string(std::string(denigma::ExportCommand().commandName())));
-        ASSERT_IF(it == registeredCommands.end()) {
+        it = commands.find(arg_string(std::string(denigma::ExportCommand().commandName())));
+        ASSERT_IF(it == commands.end()) {
             std::cerr << "Export command is missing!" << std::endl;
             return nullptr;
         }
@@ -164,6 +649,10 @@ int _MAIN(int argc, arg_char* argv[])
     }
 
     MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+    std::optional<TraceRecorder> traceRecorder;
+    if (denigmaContext.traceFilePath.has_value()) {
+        traceRecorder.emplace(denigmaContext.traceFilePath.value());
+    }
 
     // stupid omission from C++17 standard
     // see https://stackoverflow.com/questions/73555606/stdunordered-setstdfilesystempath-compile-error-on-clang-and-g-below
@@ -173,12 +662,35 @@ int _MAIN(int argc, arg_char* argv[])
             return std::filesystem::hash_value(p);
         }
     };
-    // collect files to process first
-    // this avoids potential infinite recursion if input and output are the same format
-    std::unordered_set<std::filesystem::path, PathHash> pathsToProcess;
+    // Inputs are converted while the walk is still finding more. Every output this run writes is registered before
+    // it is created, so the walk never picks one up as a new input, which avoids potential infinite recursion if
+    // input and output are the same format.
+    std::mutex outputPathsMutex;
+    std::unordered_set<std::filesystem::path, PathHash> outputPaths;
+    auto normalizedPath = [](const std::filesystem::path& path) {
+        std::error_code ec;
+        const auto absolutePath = std::filesystem::absolute(path, ec);
+        return (ec ? path : absolutePath).lexically_normal();
+    };
+    denigmaContext.outputValidated = [&](const std::filesystem::path& outputPath) {
+        std::lock_guard<std::mutex> lock(outputPathsMutex);
+        outputPaths.insert(normalizedPath(outputPath));
+    };
+    auto isOutputOfThisRun = [&](const std::filesystem::path& path) {
+        std::lock_guard<std::mutex> lock(outputPathsMutex);
+        return outputPaths.contains(normalizedPath(path));
+    };
+    std::unordered_set<std::filesystem::path, PathHash> submittedPaths;
     std::optional<std::filesystem::path> defaultLogPath;
 
     try {
+        struct InputPattern
+        {
+            std::filesystem::path filePattern;
+            std::filesystem::path directory;
+            bool walkDirectory{};
+        };
+        std::vector<InputPattern> inputPatterns;
         std::optional<std::string> optionBeforeInput;
         for (size_t x = 0; x < args.size(); x++) {
             arg_view option = args[x];
@@ -211,67 +723,228 @@ int _MAIN(int argc, arg_char* argv[])
             if (inputDirectoryExists && !defaultLogPath.has_value()) {
                 defaultLogPath = inputDir;
             }
-            // convert wildcard pattern to regex
-            auto wildcardPattern = inputFilePattern.filename().native(); // native format avoids encoding issues
-#ifdef _WIN32
-            auto regexPattern = std::regex_replace(wildcardPattern, std::wregex(LR"(\*)"), L".*");
-            regexPattern = std::regex_replace(regexPattern, std::wregex(LR"(\?)"), L".");
-            std::wregex regex(regexPattern);
-#else
-            auto regexPattern = std::regex_replace(wildcardPattern, std::regex(R"(\*)"), R"(.*)");
-            regexPattern = std::regex_replace(regexPattern, std::regex(R"(\?)"), R"(.)");
-            std::regex regex(regexPattern);
-#endif
-
-            auto iterate = [&](auto& iterator) {
-                for (auto it = iterator; it != std::filesystem::end(iterator); ++it) {
-                    const auto& entry = *it;
-                    if constexpr (std::is_same_v<std::remove_reference_t<decltype(iterator)>, std::filesystem::recursive_directory_iterator>) {
-                        if (entry.is_directory()) {
-                            if (entry.path().filename() == denigmaContext.excludeFolder) {
-                                it.disable_recursion_pending(); // Skip this folder and its subdirectories
-                                continue;
-                            }
-                        }
-                    }
-                    if (!entry.is_directory()) {
-                        denigmaContext.logMessage(LogMsg() << "considered file " << utils::asUtf8Bytes(entry.path()), MessageSeverity::Verbose);
+            inputPatterns.push_back({ std::move(inputFilePattern), std::move(inputDir), inputDirectoryExists && !isSpecificFile });
+        }
+        if (inputPatterns.empty() && optionBeforeInput.has_value()) {
+            throw std::invalid_argument("Unknown or misplaced option: " + optionBeforeInput.value());
+        }
+        denigmaContext.startLogging(defaultLogPath.value_or(std::filesystem::current_path()), argc, argv);
+        if (denigmaContext.mnxSchemaPath.has_value() && !denigmaContext.mnxSchema.has_value()) {
+            denigmaContext.mnxSchema = fileToString(denigmaContext.mnxSchemaPath.value());
+        }
+        std::shared_ptr<utils::ZipOutputArchive> outputArchive;
+        if (denigmaContext.outputArchivePath.has_value()) {
+            if (currentCommand->commandName() != ExportCommand().commandName()) {
+                throw std::invalid_argument("--output-archive applies only to the export command");
+            }
+            // entries are named by their output paths relative to the current directory
+            outputArchive = std::make_shared<utils::ZipOutputArchive>(denigmaContext.outputArchivePath.value(),
+                std::filesystem::current_path(), denigmaContext.outputArchiveShardBytes);
+            denigmaContext.outputArchive = outputArchive;
+        }
+        if (denigmaContext.writeBehindBytes.has_value() && !outputArchive) {
+            denigmaContext.outputWriter = std::make_shared<OutputWriter>(denigmaContext.writeBehindBytes.value());
+        }
+        const unsigned jobCount = denigmaContext.jobs != 0 ? denigmaContext.jobs : availableCpuCount();
+        std::optional<BatchManifest> manifest;
+        std::uint64_t optionsHash = 0;
+        if (denigmaContext.incrementalManifestPath.has_value()) {
+            auto manifestPath = denigmaContext.incrementalManifestPath.value();
+            if (manifestPath.empty()) {
+                manifestPath = DEFAULT_MANIFEST_NAME;
+            }
+            if (manifestPath.is_relative()) {
+                manifestPath = defaultLogPath.value_or(std::filesystem::current_path()) / manifestPath;
+            }
+            manifest.emplace(manifestPath);
+            optionsHash = BatchManifest::hashText(currentCommand->commandName());
+            optionsHash = BatchManifest::hashText(denigmaContext.outputOptionsFingerprint(), optionsHash);
+            for (const auto arg : args) {
+                // the output format options (--mnx, --svg, output paths) are the ones left after the inputs
+                optionsHash = BatchManifest::hashText(std::string(arg_string(arg)) + '\n', optionsHash);
+            }
+        }
+        std::optional<DuplicateInputs> duplicates;
+        if (denigmaContext.dedupeInputs.has_value()) {
+            if (outputArchive || denigmaContext.outputWriter) {
+                throw std::invalid_argument("--dedupe cannot be combined with --output-archive or --write-behind");
+            }
+            duplicates.emplace();
+        }
+        if (denigmaContext.pipelineReadJobs.has_value() && (denigmaContext.isolateTimeoutSeconds.has_value() || duplicates)) {
+            throw std::invalid_argument("--pipeline cannot be combined with --isolate or --dedupe");
+        }
+        if (denigmaContext.prefetchDepth.has_value()) {
+            if (denigmaContext.isolateTimeoutSeconds.has_value() || duplicates || denigmaContext.pipelineReadJobs.has_value()) {
+                throw std::invalid_argument("--prefetch cannot be combined with --isolate, --dedupe or --pipeline");
+            }
+            if (jobCount > 1) {
+                throw std::invalid_argument("--prefetch applies to serial runs; use --pipeline with --jobs");
+            }
+        }
+        std::optional<ForkedWorkerPool> isolatedWorkers;
+        if (denigmaContext.isolateTimeoutSeconds.has_value()) {
+            if (outputArchive || denigmaContext.outputWriter || duplicates) {
+                throw std::invalid_argument("--isolate cannot be combined with --output-archive, --write-behind or --dedupe");
+            }
+            warmUpSharedCaches(denigmaContext);
+            isolatedWorkers.emplace(denigmaContext, [&](DenigmaContext& context, const std::filesystem::path& path) {
+                context.processFile(currentCommand, path, args);
+            }, std::chrono::seconds(denigmaContext.fileTimeoutSeconds ? denigmaContext.fileTimeoutSeconds
+                                                                      : denigmaContext.isolateTimeoutSeconds.value()));
+        }
+        std::optional<SlowFileTracer> slowTracer;
+        if (denigmaContext.slowTraceThreshold.has_value()) {
+            if (traceRecorder || denigmaContext.isolateTimeoutSeconds.has_value()) {
+                throw std::invalid_argument("--trace-slow cannot be combined with --trace or --isolate");
+            }
+            std::filesystem::path traceDirectory;
+            std::string namePrefix;
+            if (denigmaContext.logFile && denigmaContext.logFilePath.has_value()) {
+                traceDirectory = denigmaContext.logFilePath->parent_path();
+                namePrefix = utils::pathToString(denigmaContext.logFilePath->stem()) + "-";
+            }
+            slowTracer.emplace(denigmaContext.slowTraceThreshold.value(), std::move(traceDirectory), std::move(namePrefix));
+        }
+        auto convertFileOnce = [&](DenigmaContext& context, const std::filesystem::path& path) {
+            if (isolatedWorkers) {
+                isolatedWorkers->convert(context, path);
+            } else if (context.fileTimeoutSeconds) {
+                // the conversion's own cancellation checks unwind it, leaving the worker free for the next input
+                const auto previousDeadline = context.deadline;
+                context.deadline = std::chrono::steady_clock::now() + std::chrono::seconds(context.fileTimeoutSeconds);
+                if (previousDeadline && *previousDeadline < *context.deadline) {
+                    context.deadline = previousDeadline;
+                }
+                context.processFile(currentCommand, path, args);
+                context.deadline = previousDeadline;
+            } else {
+                context.processFile(currentCommand, path, args);
+            }
+        };
+        auto convertFile = [&](DenigmaContext& context, const std::filesystem::path& path) {
+            if (!slowTracer) {
+                convertFileOnce(context, path);
+                return;
+            }
+            // only converted inputs are timed, so inputs skipped by --incremental or --dedupe do not drag the median down
+            const auto started = std::chrono::steady_clock::now();
+            convertFileOnce(context, path);
+            const auto elapsed = std::chrono::steady_clock::now() - started;
+            if (slowTracer->observe(elapsed)) {
+                traceSlowFile(context, *slowTracer, path, elapsed, [&](DenigmaContext& traceContext) {
+                    convertFileOnce(traceContext, path);
+                });
+            }
+        };
+        const ProcessPathFunc processPath = [&](DenigmaContext& context, const std::filesystem::path& path) {
+            TraceFileScope traceFile(path);
+            TraceSpan span("processFile");
+            context.inputFilePath = "";
+            if (!manifest && !duplicates) {
+                convertFile(context, path);
+                return;
+            }
+            if (manifest && manifest->isUpToDate(path, optionsHash)) {
+                context.logMessage(LogMsg() << "Skipping unchanged " << utils::asUtf8Bytes(path));
+                return;
+            }
+            std::vector<std::filesystem::path> outputs;
+            const bool errorBefore = context.errorOccurred;
+            context.errorOccurred = false;
+            context.outputsWritten = &outputs;
+            const auto original = duplicates ? duplicates->claim(path, quickContentKey(context, path)) : std::nullopt;
+            if (!original || !copyDuplicateOutputs(context, *original, path)) {
+                try {
+                    convertFile(context, path);
+                } catch (...) {
+                    if (duplicates) {
+                        duplicates->finish(path, false, {}); // copies waiting on this input convert themselves
                     }
-                    if (entry.is_regular_file() && std::regex_match(entry.path().filename().native(), regex)) {
-                        auto inputFilePath = entry.path();
-                        if (currentCommand->canProcess(inputFilePath)) {
-                            pathsToProcess.emplace(inputFilePath);
-                        }
+                    throw;
+                }
+                if (duplicates) {
+                    duplicates->finish(path, !context.errorOccurred, outputs);
+                }
+            }
+            context.outputsWritten = nullptr;
+            if (manifest && !context.errorOccurred && !outputs.empty()) {
+                manifest->record(path, optionsHash, std::move(outputs));
+            }
+            context.errorOccurred = context.errorOccurred || errorBefore;
+        };
+
+        // process files as they are found, each pattern's matches in sorted path order
+        {
+            ReadAheadFunc readAhead;
+            if (denigmaContext.pipelineReadJobs.has_value() || denigmaContext.prefetchDepth.has_value()) {
+                readAhead = [&](const DenigmaContext& context, const std::filesystem::path& path) -> std::optional<DenigmaContext::PrefetchedInput> {
+                    if (manifest && manifest->isUpToDate(path, optionsHash)) {
+                        return std::nullopt; // processPath skips it
                     }
+                    TraceFileScope traceFile(path);
+                    TraceSpan span("readAhead");
+                    return context.readAhead(currentCommand, path);
+                };
+            }
+            // --prefetch is a pipeline of one reader and one converting worker, reading at most its depth ahead
+            BatchDispatcher dispatcher(denigmaContext, processPath, jobCount, std::move(readAhead),
+                denigmaContext.prefetchDepth ? 1u : denigmaContext.pipelineReadJobs.value_or(0), denigmaContext.prefetchDepth.value_or(0));
+            DirectoryWalker walker(denigmaContext.recursiveSearch ? DIRECTORY_LISTING_THREADS : 0);
+            auto submit = [&](const std::filesystem::path& path) {
+                if (submittedPaths.insert(path).second) {
+                    dispatcher.submit(path);
                 }
             };
-            if (inputDirectoryExists && !isSpecificFile) {
-                if (denigmaContext.recursiveSearch) {
-                    std::filesystem::recursive_directory_iterator it(inputDir);
-                    iterate(it);
-                } else {
-                    std::filesystem::directory_iterator it(inputDir);
-                    iterate(it);
+            for (const auto& pattern : inputPatterns) {
+                if (!pattern.walkDirectory) {
+                    submit(pattern.filePattern);
+                    continue;
                 }
-            } else {
-                pathsToProcess.emplace(inputFilePattern);
+                const auto wildcardPattern = pattern.filePattern.filename().native(); // native format avoids encoding issues
+                using PathStringView = std::basic_string_view<std::filesystem::path::value_type>;
+                walker.walk(pattern.directory, denigmaContext.recursiveSearch, denigmaContext.excludeFolder, [&](const std::filesystem::directory_entry& entry) {
+                    if (entry.is_directory()) {
+                        return;
+                    }
+                    denigmaContext.logMessage([&](LogMsg& msg) { msg << "considered file " << utils::asUtf8Bytes(entry.path()); }, MessageSeverity::Verbose);
+                    if (entry.is_regular_file() && utils::wildcardMatch(PathStringView(wildcardPattern), PathStringView(entry.path().filename().native()))) {
+                        if (isOutputOfThisRun(entry.path())) {
+                            denigmaContext.logMessage([&](LogMsg& msg) { msg << "skipped " << utils::asUtf8Bytes(entry.path()) << " (written by this run)"; },
+                                MessageSeverity::Verbose);
+                        } else if (currentCommand->canProcess(entry.path())) {
+                            submit(entry.path());
+                        }
+                    }
+                });
             }
+            dispatcher.finish();
         }
-        if (pathsToProcess.empty() && optionBeforeInput.has_value()) {
-            throw std::invalid_argument("Unknown or misplaced option: " + optionBeforeInput.value());
+        if (outputArchive) {
+            outputArchive->finish();
+            denigmaContext.logMessage(LogMsg() << "Wrote " << outputArchive->entryCount() << " outputs in " << outputArchive->shardCount()
+                << " archive shard(s) starting at " << utils::asUtf8Bytes(denigmaContext.outputArchivePath.value()));
         }
-        denigmaContext.startLogging(defaultLogPath.value_or(std::filesystem::current_path()), argc, argv);
-        if (denigmaContext.mnxSchemaPath.has_value() && !denigmaContext.mnxSchema.has_value()) {
-            denigmaContext.mnxSchema = fileToString(denigmaContext.mnxSchemaPath.value());
+        if (denigmaContext.outputWriter) {
+            // every output must be on disk before the manifest records it
+            denigmaContext.outputWriter->close();
+            for (const auto& failure : denigmaContext.outputWriter->failures()) {
+                denigmaContext.logMessage(LogMsg() << "unable to write " << utils::asUtf8Bytes(failure.path)
+                    << " (exception: " << failure.message << ")", MessageSeverity::Error);
+            }
         }
-        // process files
-        for (const auto& path : pathsToProcess) {
-            denigmaContext.inputFilePath = "";
-            denigmaContext.processFile(currentCommand, path, args);
+        if (submittedPaths.empty() && optionBeforeInput.has_value()) {
+            throw std::invalid_argument("Unknown or misplaced option: " + optionBeforeInput.value());
+        }
+        if (manifest) {
+            manifest->save();
         }
     } catch (const std::exception& e) {
         denigmaContext.logMessage(LogMsg() << e.what(), MessageSeverity::Error);
     }
+    if (traceRecorder && !traceRecorder->finish()) {
+        denigmaContext.logMessage(LogMsg() << "Unable to write trace file " << utils::asUtf8Bytes(denigmaContext.traceFilePath.value()), MessageSeverity::Error);
+    }
 
     denigmaContext.endLogging();
 
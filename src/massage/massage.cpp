@@ -38,11 +38,6 @@ static CommandInputData nullFunc(const std::filesystem::path&, const DenigmaCont
     return CommandInputData{};
 }
 
-static CommandInputData readMusicXml(const std::filesystem::path& inputPath, const DenigmaContext& denigmaContext)
-{
-    return formats::enigmaxml::detail::readEnigmaXmlInputData(inputPath, denigmaContext);
-}
-
 // Input format processors
 constexpr auto inputProcessors = []() {
     struct InputProcessor
@@ -53,7 +48,7 @@ constexpr auto inputProcessors = []() {
 
     return std::to_array<InputProcessor>({
             { MXL_EXTENSION, nullFunc },
-            { MUSICXML_EXTENSION, readMusicXml },
+            { MUSICXML_EXTENSION, nullFunc }, // musicxml::massage reads the file into a buffer it can parse in place
         });
     }();
 
@@ -20,13 +20,13 @@
  * THE SOFTWARE.
  */
 #include <string>
+#include <string_view>
 #include <filesystem>
 #include <array>
 #include <vector>
+#include <optional>
 #include <iostream>
-#include <sstream>
 #include <functional>
-#include <regex>
 
 #include "musx/musx.h"
 #include "core/musx_reader.h"
@@ -67,8 +67,24 @@ struct MassageMusicXmlContext
         currentMusicXmlPart = currentXmlMeasure = currentMeasure = currentStaff = currentStaffOffset = errorCount = 0;
     }
 
+    /// Returns the scroll-view staff list of musxPartId, fetching it only when the document or part changes.
+    const MusxInstanceList<others::StaffUsed>& getScrollViewStaves()
+    {
+        if (!scrollViewStaves || scrollViewStavesDocument != musxDocument || scrollViewStavesPartId != musxPartId) {
+            scrollViewStaves = musxDocument->getScrollViewStaves(musxPartId);
+            scrollViewStavesDocument = musxDocument;
+            scrollViewStavesPartId = musxPartId;
+        }
+        return *scrollViewStaves;
+    }
+
     void logMessage(LogMsg&& msg, MessageSeverity severity = MessageSeverity::Info);
     void logXmlNode(pugi::xml_node node);
+
+private:
+    std::optional<MusxInstanceList<others::StaffUsed>> scrollViewStaves;
+    musx::dom::DocumentPtr scrollViewStavesDocument;
+    Cmper scrollViewStavesPartId{};
 };
 
 void MassageMusicXmlContext::logMessage(LogMsg&& msg, MessageSeverity severity)
@@ -76,13 +92,16 @@ void MassageMusicXmlContext::logMessage(LogMsg&& msg, MessageSeverity severity)
     if (severity == MessageSeverity::Error) {
         ++errorCount;
     }
+    if (!denigmaContext->shouldLog(severity)) {
+        return; // before the staff name lookup
+    }
     std::string logEntry;
     if (currentStaff >= 0 && currentMeasure > 0) {
         std::string staffText = "p" + std::to_string(currentMusicXmlPart);
         auto staffNumber = Cmper(currentStaff + currentStaffOffset);
         std::string staffName = [&]() -> std::string {
             if (musxDocument) {
-                const auto iuList = musxDocument->getScrollViewStaves(musxPartId);
+                const auto& iuList = getScrollViewStaves();
                 if (!iuList.empty()) {
                     if (auto staff = iuList.getStaffInstanceAtIndex(staffNumber)) {
                         return staff->getFullName();
@@ -119,116 +138,103 @@ static int staffNumberFromNote(pugi::xml_node xmlNote) {
     return 1; // Default to 1 if no <staff> node or invalid content.
 }
 
-// This iterator function finds the next matching direction *before* sending the current one to the callback.
-// This allows the callback to move the direction without perturbing the iteration sequence.
-void feedDirectionsOfType(pugi::xml_node node, const std::string& nodeName, const std::function<void(pugi::xml_node)>& processNode)
+/// A fixup that the measure pass hands each child of a measure, along with the measure.
+using MeasureChildFixup = std::function<void(pugi::xml_node xmlMeasure, pugi::xml_node child)>;
+
+// Every fixup sees each child in one walk of the measure, so adding a fixup does not add a traversal. The children are
+// taken before any fixup runs, so a fixup may move the child it is handed: the copy it inserts is not visited again.
+static void visitMeasureChildren(pugi::xml_node xmlMeasure, const std::vector<MeasureChildFixup>& fixups, std::vector<pugi::xml_node>& children)
 {
-    // Local function to find the next matching <direction> node
-    auto findNextMatchingDirection = [&](pugi::xml_node& currentNode) {
-        while (currentNode) {
-            if (auto nodeForType = currentNode.child("direction-type").child(nodeName.c_str())) {
-                return; // Found a matching node, return to caller
-            }
-            currentNode = currentNode.next_sibling("direction");
+    children.clear();
+    for (auto child = xmlMeasure.first_child(); child; child = child.next_sibling()) {
+        children.push_back(child);
+    }
+    for (const auto child : children) {
+        for (const auto& fixup : fixups) {
+            fixup(xmlMeasure, child);
         }
-    };
-
-    // Start with the first <direction> node
-    auto child = node.child("direction");
-    findNextMatchingDirection(child); // Initialize by finding the first match
-
-    // Process each matching <direction> node
-    while (child) {
-        pugi::xml_node currentNode = child; // Store the current node
-        child = child.next_sibling("direction"); // Move to the next sibling
-        findNextMatchingDirection(child); // Find the next matching node
-        processNode(currentNode); // Process the current node
     }
 }
 
-static void fixDirectionBrackets(pugi::xml_node xmlMeasure, const std::string& directionType, const std::shared_ptr<MassageMusicXmlContext>& context)
+static void fixDirectionBracket(pugi::xml_node xmlMeasure, pugi::xml_node currentDirection, const std::string& directionType, const std::shared_ptr<MassageMusicXmlContext>& context)
 {
     const DenigmaContext& denigmaContext = *context->denigmaContext;
-    if (!(denigmaContext.extendOttavasLeft || denigmaContext.extendOttavasRight)) return;
-
-    feedDirectionsOfType(xmlMeasure, directionType, [&](pugi::xml_node currentDirection) {
-        auto xmlDirectionType = currentDirection.child("direction-type");
-        if (!xmlDirectionType) return;
-
-        auto nodeForType = xmlDirectionType.child(directionType.c_str());
-        if (!nodeForType) return;
-
-        auto directionCopy = currentDirection; // Shallow copy
-        std::string shiftType = nodeForType.attribute("type").value();
-
-        if (shiftType == "stop") {
-            if (denigmaContext.extendOttavasRight) {
-                auto nextNote = currentDirection.next_sibling("note");
-                // Find the next note, skipping over extra notes in chords
-                if (nextNote) {
-                    auto chordCheck = nextNote.next_sibling("note");
-                    while (chordCheck && chordCheck.child("chord")) {
-                        nextNote = chordCheck;
-                        chordCheck = chordCheck.next_sibling("note");
-                    }
+    if (std::string_view(currentDirection.name()) != "direction") return;
+
+    auto xmlDirectionType = currentDirection.child("direction-type");
+    if (!xmlDirectionType) return;
+
+    auto nodeForType = xmlDirectionType.child(directionType.c_str());
+    if (!nodeForType) return;
+
+    auto directionCopy = currentDirection; // Shallow copy
+    std::string shiftType = nodeForType.attribute("type").value();
+
+    if (shiftType == "stop") {
+        if (denigmaContext.extendOttavasRight) {
+            auto nextNote = currentDirection.next_sibling("note");
+            // Find the next note, skipping over extra notes in chords
+            if (nextNote) {
+                auto chordCheck = nextNote.next_sibling("note");
+                while (chordCheck && chordCheck.child("chord")) {
+                    nextNote = chordCheck;
+                    chordCheck = chordCheck.next_sibling("note");
                 }
-                if (nextNote && !nextNote.child("rest")) {
-                    xmlMeasure.remove_child(currentDirection);
-                    xmlMeasure.insert_copy_after(directionCopy, nextNote);
-                    context->currentStaffOffset = staffNumberFromNote(nextNote) - 1;
-                    if (directionType == "octave-shift") {
-                        context->logMessage(LogMsg() << "Extended octave-shift element of size " << std::to_string(nodeForType.attribute("size").as_int(8)) << " by one note/chord.");
-                    } else {
-                        context->logMessage(LogMsg() << "Extended " << directionType << " element by one note/chord.");
-                    }
+            }
+            if (nextNote && !nextNote.child("rest")) {
+                xmlMeasure.remove_child(currentDirection);
+                xmlMeasure.insert_copy_after(directionCopy, nextNote);
+                context->currentStaffOffset = staffNumberFromNote(nextNote) - 1;
+                if (directionType == "octave-shift") {
+                    context->logMessage(LogMsg() << "Extended octave-shift element of size " << std::to_string(nodeForType.attribute("size").as_int(8)) << " by one note/chord.");
+                } else {
+                    context->logMessage(LogMsg() << "Extended " << directionType << " element by one note/chord.");
                 }
             }
-        } else if (directionType == "octave-shift" && (shiftType == "up" || shiftType == "down")) {
-            if (denigmaContext.extendOttavasLeft) {
-                int sign = (shiftType == "down") ? 1 : -1;
-                int octaves = (nodeForType.attribute("size").as_int(8) - 1) / 7;
-
-                auto prevNote = currentDirection.previous_sibling("note");
-                pugi::xml_node prevGraceNote;
-
-                while (prevNote) {
-                    if (!prevNote.child("rest") && prevNote.child("grace")) {
-                        prevGraceNote = prevNote;
-                        auto pitch = prevNote.child("pitch");
-                        auto octave = pitch.child("octave");
-                        if (octave) {
-                            octave.text().set(octave.text().as_int() + sign * octaves);
-                        }
-                    } else {
-                        break;
+        }
+    } else if (directionType == "octave-shift" && (shiftType == "up" || shiftType == "down")) {
+        if (denigmaContext.extendOttavasLeft) {
+            int sign = (shiftType == "down") ? 1 : -1;
+            int octaves = (nodeForType.attribute("size").as_int(8) - 1) / 7;
+
+            auto prevNote = currentDirection.previous_sibling("note");
+            pugi::xml_node prevGraceNote;
+
+            while (prevNote) {
+                if (!prevNote.child("rest") && prevNote.child("grace")) {
+                    prevGraceNote = prevNote;
+                    auto pitch = prevNote.child("pitch");
+                    auto octave = pitch.child("octave");
+                    if (octave) {
+                        octave.text().set(octave.text().as_int() + sign * octaves);
                     }
-                    prevNote = prevNote.previous_sibling("note");
+                } else {
+                    break;
                 }
+                prevNote = prevNote.previous_sibling("note");
+            }
 
-                if (prevGraceNote) {
-                    xmlMeasure.remove_child(currentDirection);
-                    auto prevElement = prevGraceNote.previous_sibling();
-                    if (prevElement) {
-                        xmlMeasure.insert_copy_after(directionCopy, prevElement);
-                    } else {
-                        xmlMeasure.prepend_copy(directionCopy);
-                    }
-                    context->currentStaffOffset = staffNumberFromNote(prevGraceNote) - 1;
-                    context->logMessage(LogMsg() << "Adjusted octave-shift element of size "
-                                                 << std::to_string(nodeForType.attribute("size").as_int(8))
-                                                 << " to include preceding grace notes.");
+            if (prevGraceNote) {
+                xmlMeasure.remove_child(currentDirection);
+                auto prevElement = prevGraceNote.previous_sibling();
+                if (prevElement) {
+                    xmlMeasure.insert_copy_after(directionCopy, prevElement);
+                } else {
+                    xmlMeasure.prepend_copy(directionCopy);
                 }
+                context->currentStaffOffset = staffNumberFromNote(prevGraceNote) - 1;
+                context->logMessage(LogMsg() << "Adjusted octave-shift element of size "
+                                             << std::to_string(nodeForType.attribute("size").as_int(8))
+                                             << " to include preceding grace notes.");
             }
         }
-    });
+    }
 }
 
-static void fixFermataWholeRests(pugi::xml_node xmlMeasure, const std::shared_ptr<MassageMusicXmlContext>& context)
+static void fixFermataWholeRest(pugi::xml_node noteNode, const std::shared_ptr<MassageMusicXmlContext>& context)
 {
-    assert(xmlMeasure);
+    assert(noteNode);
 
-    auto noteNode = xmlMeasure.child("note");
-    if (!noteNode) return;
     auto restNode = noteNode.child("rest");
     if (!restNode) return;
     auto typeNode = noteNode.child("type");
@@ -253,6 +259,27 @@ static void fixFermataWholeRests(pugi::xml_node xmlMeasure, const std::shared_pt
     }
 }
 
+/// Returns the fixups the context's options enable, in the order each is applied to a child.
+static std::vector<MeasureChildFixup> createMeasureChildFixups(const std::shared_ptr<MassageMusicXmlContext>& context)
+{
+    const DenigmaContext& denigmaContext = *context->denigmaContext;
+    std::vector<MeasureChildFixup> fixups;
+    if (denigmaContext.extendOttavasLeft || denigmaContext.extendOttavasRight) {
+        fixups.emplace_back([context](pugi::xml_node xmlMeasure, pugi::xml_node child) {
+            fixDirectionBracket(xmlMeasure, child, "octave-shift", context);
+        });
+    }
+    if (denigmaContext.fermataWholeRests) {
+        // only the measure's first note can be a whole rest under a fermata
+        fixups.emplace_back([context, measureWithNote = pugi::xml_node()](pugi::xml_node xmlMeasure, pugi::xml_node child) mutable {
+            if (measureWithNote == xmlMeasure || std::string_view(child.name()) != "note") return;
+            measureWithNote = xmlMeasure;
+            fixFermataWholeRest(child, context);
+        });
+    }
+    return fixups;
+}
+
 // this table maps musicxml note types to enigma note types
 constexpr auto durationTypeMap = std::to_array<std::pair<std::string_view, NoteType>>({
     { "maxima", NoteType::Maxima },
@@ -290,13 +317,38 @@ static int log2_exact(uint32_t value)
     return log;
 }
 
-static void massageXmlWithFinaleDocument(pugi::xml_node xmlMeasure,
+/// The <note> nodes of one XML measure, gathered in one pass and bucketed by staff number.
+struct MeasureNotes
+{
+    std::vector<pugi::xml_node> notes;              ///< every <note> of the measure, in document order
+    std::vector<size_t> chordEnd;                   ///< for each note, the index of the last note of the chord that follows it
+    std::vector<std::vector<size_t>> notesByStaff;  ///< indices into notes, indexed by staff number - 1
+
+    MeasureNotes(pugi::xml_node xmlMeasure, int stavesUsed)
+        : notesByStaff(size_t(stavesUsed))
+    {
+        for (auto note = xmlMeasure.child("note"); note; note = note.next_sibling("note")) {
+            const int staffNum = staffNumberFromNote(note);
+            if (staffNum >= 1 && staffNum <= stavesUsed) {
+                notesByStaff[size_t(staffNum - 1)].push_back(notes.size());
+            }
+            notes.push_back(note);
+        }
+        chordEnd.resize(notes.size());
+        for (size_t index = notes.size(); index-- > 0;) {
+            const size_t next = index + 1;
+            chordEnd[index] = (next < notes.size() && notes[next].child("chord")) ? chordEnd[next] : index;
+        }
+    }
+};
+
+static void massageXmlWithFinaleDocument(const MeasureNotes& measureNotes,
     int staffSlot, MeasCmper measure, double /*durationUnit*/, StaffCmper staffNum,
     const std::shared_ptr<MassageMusicXmlContext>& context)
 {
     // This call to getScrollViewStaves may need to take account of Special Part Extraction, but this is how it has
     // been, so we will not change it unless it is proven to be broken.
-    const auto iuList = context->musxDocument->getScrollViewStaves(context->musxPartId);
+    const auto& iuList = context->getScrollViewStaves();
     if (iuList.empty()) {
         context->logMessage(LogMsg() << "no staff list found for part", MessageSeverity::Warning);
         return;
@@ -308,28 +360,20 @@ static void massageXmlWithFinaleDocument(pugi::xml_node xmlMeasure,
     }
     auto gfHold = details::GFrameHoldContext(context->musxDocument, context->musxPartId, staff->getCmper(), measure);
     if (gfHold) {
-        pugi::xml_node nextNote;
+        const auto& staffNotes = measureNotes.notesByStaff[size_t(staffNum - 1)];
+        size_t staffNoteIndex = 0;
         gfHold.iterateEntries([&](const EntryInfoPtr& entryInfo) -> bool {
             auto entry = entryInfo->getEntry();
             if (entry->isHidden) { // Dolet does not create note elements for invisible entries
                 return true;
             }
             // Find the next note corresponding to this entry
-            auto findNextNote = [&](pugi::xml_node currentNote) -> pugi::xml_node {
-                pugi::xml_node note = currentNote ? currentNote.next_sibling("note") : xmlMeasure.child("note");
-                while (note) {
-                    if (staffNum == staffNumberFromNote(note)) {
-                        break;
-                    }
-                    note = note.next_sibling("note");
-                }
-                return note;
-            };
-            nextNote = findNextNote(nextNote);
-            if (!nextNote) {
+            if (staffNoteIndex >= staffNotes.size()) {
                 context->logMessage(LogMsg() << "xml notes do not match Finale file", MessageSeverity::Warning);
                 return false;
             }
+            const size_t noteIndex = staffNotes[staffNoteIndex];
+            pugi::xml_node nextNote = measureNotes.notes[noteIndex];
 
             auto* durationType = findDurationType(nextNote.child("type").text().get());
             if (!durationType) {
@@ -396,10 +440,9 @@ static void massageXmlWithFinaleDocument(pugi::xml_node xmlMeasure,
             }
 
             // Skip over extra notes in chords
-            pugi::xml_node chordCheck = nextNote.next_sibling("note");
-            while (chordCheck && chordCheck.child("chord")) {
-                nextNote = chordCheck;
-                chordCheck = chordCheck.next_sibling("note");
+            const size_t chordEnd = measureNotes.chordEnd[noteIndex];
+            while (staffNoteIndex < staffNotes.size() && staffNotes[staffNoteIndex] <= chordEnd) {
+                ++staffNoteIndex;
             }
 
             return true; // Continue iteration
@@ -415,6 +458,8 @@ void massageXml(pugi::xml_node scorePartWiseNode, const std::shared_ptr<MassageM
 
     context->initCounts();
     context->currentMusicXmlPart = 1;
+    const auto measureChildFixups = createMeasureChildFixups(context);
+    std::vector<pugi::xml_node> measureChildren;
 
     for (auto xmlPart = scorePartWiseNode.child("part"); xmlPart; xmlPart = xmlPart.next_sibling("part")) {
         context->currentMeasure = 0;
@@ -443,10 +488,11 @@ void massageXml(pugi::xml_node scorePartWiseNode, const std::shared_ptr<MassageM
             context->currentMeasure++;
 
             if (context->musxDocument && context->denigmaContext->refloatRests) {
+                const MeasureNotes measureNotes(xmlMeasure, stavesUsed);
                 for (StaffCmper staffNum = 1; staffNum <= stavesUsed; ++staffNum) {
                     context->currentStaffOffset = staffNum - 1;
                     massageXmlWithFinaleDocument(
-                        xmlMeasure,
+                        measureNotes,
                         context->currentStaff + context->currentStaffOffset,
                         MeasCmper(context->currentMeasure),
                         durationUnit,
@@ -456,10 +502,8 @@ void massageXml(pugi::xml_node scorePartWiseNode, const std::shared_ptr<MassageM
                 }
             }
 
-            fixDirectionBrackets(xmlMeasure, "octave-shift", context);
-
-            if (context->denigmaContext->fermataWholeRests) {
-                fixFermataWholeRests(xmlMeasure, context);
+            if (!measureChildFixups.empty()) {
+                visitMeasureChildren(xmlMeasure, measureChildFixups, measureChildren);
             }
         }
 
@@ -596,16 +640,23 @@ Cmper getMusxPartIdFromPartFileName(const std::string& partFileName, const std::
         return 0;
     }
     
-    std::regex pattern(R"(p(\d+)\.musicxml)");
-    std::smatch match;
-
-    Cmper partNumber = 0;
-    if (std::regex_search(partFileName, match, pattern)) {
-        partNumber = Cmper(std::stoi(match[1].str()));
-    } else {
+    // find the first "p<digits>.musicxml" in the name
+    constexpr std::string_view suffix = ".musicxml";
+    std::optional<Cmper> partNumber;
+    for (std::size_t pos = partFileName.find('p'); pos != std::string::npos && !partNumber; pos = partFileName.find('p', pos + 1)) {
+        std::size_t digitsEnd = pos + 1;
+        while (digitsEnd < partFileName.size() && partFileName[digitsEnd] >= '0' && partFileName[digitsEnd] <= '9') {
+            ++digitsEnd;
+        }
+        if (digitsEnd > pos + 1 && std::string_view(partFileName).substr(digitsEnd, suffix.size()) == suffix) {
+            partNumber = Cmper(std::stoi(partFileName.substr(pos + 1, digitsEnd - pos - 1)));
+        }
+    }
+    if (!partNumber) {
         context->denigmaContext->logMessage(LogMsg() << "Unable to get part number from " << partFileName << ". Using score instead.", MessageSeverity::Warning);
+        return 0;
     }
-    return partNumber;
+    return *partNumber;
 }
 
 std::optional<std::filesystem::path> findFinaleFile(const std::filesystem::path& inputPath, const DenigmaContext& denigmaContext)
@@ -693,7 +744,7 @@ static std::shared_ptr<MassageMusicXmlContext> createContext(const std::filesyst
             if (utils::pathExtensionEquals(path, MUSX_EXTENSION)) {
                 return formats::enigmaxml::detail::extractMusxInputData(path, denigmaContext).primaryBuffer;
             } else if (utils::pathExtensionEquals(path, ENIGMAXML_EXTENSION)) {
-                return formats::enigmaxml::detail::readEnigmaXmlInputData(path, denigmaContext).primaryBuffer;
+                return formats::enigmaxml::detail::readEnigmaXmlInputData(path, denigmaContext).takePrimaryBuffer();
             }
             assert(false); // bug in findFinaleFile if here
             return {};
@@ -716,6 +767,32 @@ pugi::xml_document openXmlDocument(const T& xmlData)
     return xmlDocument;
 };
 
+/// Parses xmlData in place, so the document references it rather than holding a copy. The caller must keep
+/// xmlData alive and unmodified for as long as the document is in use.
+template <typename T>
+pugi::xml_document openXmlDocumentInPlace(T& xmlData)
+{
+    pugi::xml_document xmlDocument;
+    auto parseResult = xmlDocument.load_buffer_inplace(xmlData.data(), xmlData.size(), pugi::parse_full | pugi::parse_ws_pcdata_single);
+    if (parseResult.status != pugi::xml_parse_status::status_ok) {
+        throw std::invalid_argument(std::string("Error parsing xml: ") + parseResult.description());
+    }
+    return xmlDocument;
+}
+
+/// Appends serialized xml directly to a string, without an intermediate stream.
+struct XmlStringWriter : pugi::xml_writer
+{
+    std::string& output;
+
+    explicit XmlStringWriter(std::string& out) : output(out) {}
+
+    void write(const void* data, size_t size) override
+    {
+        output.append(static_cast<const char*>(data), size);
+    }
+};
+
 void massage(const std::filesystem::path& inputPath, const std::filesystem::path& outputPath, const Buffer& xmlBuffer, const DenigmaContext& denigmaContext)
 {
     MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
@@ -729,11 +806,16 @@ void massage(const std::filesystem::path& inputPath, const std::filesystem::path
     auto context = createContext(inputPath, denigmaContext);
 
     if ((!utils::pathExtensionEquals(inputPath, MXL_EXTENSION)) || !xmlBuffer.empty()) {
-        processFile(openXmlDocument(xmlBuffer), outputPath, context);
+        // The input is read into a buffer owned here and parsed in place, so only one copy of the xml is held.
+        Buffer ownedBuffer = xmlBuffer.empty()
+                           ? formats::enigmaxml::detail::readEnigmaXmlInputData(inputPath, denigmaContext).takePrimaryBuffer()
+                           : xmlBuffer;
+        processFile(openXmlDocumentInPlace(ownedBuffer), outputPath, context);
         return;
     }
 
-    auto xmlScore = openXmlDocument(utils::getMusicXmlScoreFile(inputPath, denigmaContext));
+    const utils::ZipArchiveIndex archive(inputPath, denigmaContext); // shared by the score and part passes
+    auto xmlScore = openXmlDocument(utils::getMusicXmlScoreFile(archive, denigmaContext));
     auto partFileName = !denigmaContext.allPartsAndScore && denigmaContext.partName.has_value() && !denigmaContext.partName.value().empty()
                       ? findPartFileNameByPartName(xmlScore, denigmaContext.partName.value())
                       : std::nullopt;
@@ -761,7 +843,7 @@ void massage(const std::filesystem::path& inputPath, const std::filesystem::path
 
     if (denigmaContext.allPartsAndScore || denigmaContext.partName.has_value()) {
         if (!partFileName.has_value() || !partFileName.value().empty()) {
-            utils::iterateMusicXmlPartFiles(inputPath, denigmaContext, partFileName, processPartOrScore);
+            utils::iterateMusicXmlPartFiles(archive, denigmaContext, partFileName, processPartOrScore);
             if (denigmaContext.allPartsAndScore) {
                 processFile(std::move(xmlScore), outputPath, context); // must do score last, because std::move
             }
@@ -803,9 +885,14 @@ void massageMxl(const std::filesystem::path& inputPath, const std::filesystem::p
         denigmaContext.logMessage(LogMsg() << "ignoring input buffer", MessageSeverity::Warning);
     }
 
-    auto context = createContext(inputPath, denigmaContext);
-    utils::iterateModifyFilesInPlace(inputPath, qualifiedOutputPath, denigmaContext, [&](const std::filesystem::path& fileName, std::string& fileContents, bool isScore) {
+    // The Finale document is parsed once for the archive and shared read-only. Each file is massaged on its own
+    // context and xml document, so the score and part files can be processed concurrently.
+    const auto sharedContext = createContext(inputPath, denigmaContext);
+    utils::iterateModifyFilesConcurrently(inputPath, qualifiedOutputPath, denigmaContext,
+        [&](const DenigmaContext& workerContext, const std::filesystem::path& fileName, std::string& fileContents, bool isScore) {
         if (utils::pathExtensionEquals(fileName, MUSICXML_EXTENSION)) {
+            auto context = std::make_shared<MassageMusicXmlContext>(workerContext);
+            context->musxDocument = sharedContext->musxDocument;
             context->musxPartId = !isScore ? getMusxPartIdFromPartFileName(utils::utf8ToString(fileName.u8string()), context) : 0;
             auto partName = [&]() -> std::string {
                 std::string retval;
@@ -819,16 +906,18 @@ void massageMxl(const std::filesystem::path& inputPath, const std::filesystem::p
                 }
                 return retval;
             }();
-            denigmaContext.logMessage(LogMsg() << ">>>>>>>>>> Processing zipped file " << utils::asUtf8Bytes(fileName) << " (" << partName << ") <<<<<<<<<<");
+            workerContext.logMessage(LogMsg() << ">>>>>>>>>> Processing zipped file " << utils::asUtf8Bytes(fileName) << " (" << partName << ") <<<<<<<<<<");
 
-            auto xmlDocument = openXmlDocument(fileContents);
+            auto xmlDocument = openXmlDocumentInPlace(fileContents);
             processXml(xmlDocument, context);
-            std::stringstream ss;
-            pugi::xml_writer_stream writer(ss);
+            std::string massagedContents;
+            massagedContents.reserve(fileContents.size());
+            XmlStringWriter writer(massagedContents);
             xmlDocument.save(writer, INDENT_SPACES);
-            fileContents = ss.str();
+            xmlDocument.reset(); // releases its references into fileContents
+            fileContents = std::move(massagedContents);
         } else {
-            denigmaContext.logMessage(LogMsg() << ">>>>>>>>>> Processing zipped file " << utils::asUtf8Bytes(fileName) << " <<<<<<<<<<");
+            workerContext.logMessage(LogMsg() << ">>>>>>>>>> Processing zipped file " << utils::asUtf8Bytes(fileName) << " <<<<<<<<<<");
         }
         return true; // always save the file back, even if we didn't modify it
     });
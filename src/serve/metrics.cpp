@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "serve/metrics.h"
+#include "serve/result_cache.h"
+#include "serve/scheduler.h"
+
+#include "denigma/process_caches.h"
+#include "utils/stringutils.h"
+
+namespace denigma {
+
+namespace {
+
+/// Writes the `# HELP` and `# TYPE` lines that precede a metric family.
+void writeFamily(std::ostream& out, std::string_view name, std::string_view type, std::string_view help)
+{
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << ' ' << type << '\n';
+}
+
+/// Returns the shortest text that reads back as value.
+std::string formatValue(double value)
+{
+    std::array<char, 32> buffer{};
+    const auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+    return std::string(buffer.data(), result.ptr);
+}
+
+/// Escapes a label value as the exposition format requires.
+std::string labelValue(std::string_view value)
+{
+    std::string result;
+    for (const char c : value) {
+        switch (c) {
+        case '\\': result += "\\\\"; break;
+        case '"': result += "\\\""; break;
+        case '\n': result += "\\n"; break;
+        default: result += c; break;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+void ServeMetrics::Histogram::observe(double seconds)
+{
+    for (std::size_t index = 0; index < LATENCY_BUCKETS.size(); ++index) {
+        if (seconds <= LATENCY_BUCKETS[index]) {
+            ++buckets[index];
+            break;
+        }
+    }
+    ++count;
+    sum += seconds;
+}
+
+void ServeMetrics::requestStarted(std::size_t inputBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_activeRequests;
+    m_inputBytes += inputBytes;
+}
+
+void ServeMetrics::requestFinished(std::chrono::nanoseconds duration, std::size_t responseBytes, bool hasError, bool fromCache)
+{
+    bool exportDue = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_activeRequests;
+        m_responseBytes += responseBytes;
+        ++(hasError ? m_failedRequests : fromCache ? m_cachedRequests : m_convertedRequests);
+        m_requestLatency.observe(std::chrono::duration<double>(duration).count());
+        const auto now = std::chrono::steady_clock::now();
+        if (!m_exportFile.empty() && now - m_lastExport >= EXPORT_INTERVAL) {
+            m_lastExport = now;
+            exportDue = true;
+        }
+    }
+    if (exportDue) {
+        exportNow();
+    }
+}
+
+void ServeMetrics::conversionFinished(std::string_view target, const ConversionStats& stats, bool hasError)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_targets.find(target);
+    if (it == m_targets.end()) {
+        it = m_targets.emplace(std::string(target), TargetCounts{}).first;
+    }
+    ++(hasError ? it->second.failed : it->second.succeeded);
+    it->second.bytesWritten += stats.bytesWritten;
+    addPhases(stats);
+    for (std::size_t index = 0; index < ConversionStats::HOT_PATH_COUNT; ++index) {
+        m_hotPaths[index] += stats.hotPathCounts[index];
+    }
+    m_conversionCacheHits += stats.cacheHits;
+    m_conversionCacheMisses += stats.cacheMisses;
+}
+
+void ServeMetrics::preparationFinished(const ConversionStats& stats)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    addPhases(stats);
+}
+
+void ServeMetrics::connectionOpened()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_openConnections;
+}
+
+void ServeMetrics::connectionClosed()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_openConnections;
+}
+
+void ServeMetrics::addPhases(const ConversionStats& stats)
+{
+    // a phase the conversion did not run is not a zero-second sample of it
+    for (std::size_t index = 0; index < ConversionStats::PHASE_COUNT; ++index) {
+        if (stats.phaseTimes[index].count() > 0) {
+            m_phaseLatency[index].observe(std::chrono::duration<double>(stats.phaseTimes[index]).count());
+        }
+    }
+}
+
+void ServeMetrics::exportNow() const
+{
+    if (m_exportFile.empty()) {
+        return;
+    }
+    const std::string text = render();
+    std::lock_guard<std::mutex> lock(m_exportMutex);
+    auto tempPath = m_exportFile;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(text.data(), static_cast<std::streamsize>(text.size())) || !file.flush()) {
+            throw std::runtime_error("Unable to write metrics file: " + utils::pathToString(m_exportFile));
+        }
+    }
+    std::filesystem::rename(tempPath, m_exportFile);
+}
+
+std::string ServeMetrics::render() const
+{
+    std::ostringstream out;
+    auto writeHistogram = [&](std::string_view name, std::string_view labels, const Histogram& histogram) {
+        const std::string prefix = labels.empty() ? "{" : "{" + std::string(labels) + ",";
+        std::uint64_t cumulative = 0;
+        for (std::size_t index = 0; index < LATENCY_BUCKETS.size(); ++index) {
+            cumulative += histogram.buckets[index];
+            out << name << "_bucket" << prefix << "le=\"" << formatValue(LATENCY_BUCKETS[index]) << "\"} " << cumulative << '\n';
+        }
+        out << name << "_bucket" << prefix << "le=\"+Inf\"} " << histogram.count << '\n';
+        const std::string suffix = labels.empty() ? "" : "{" + std::string(labels) + "}";
+        out << name << "_sum" << suffix << ' ' << formatValue(histogram.sum) << '\n';
+        out << name << "_count" << suffix << ' ' << histogram.count << '\n';
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        writeFamily(out, "denigma_serve_requests_total", "counter", "Requests answered, by outcome.");
+        out << "denigma_serve_requests_total{outcome=\"converted\"} " << m_convertedRequests << '\n';
+        out << "denigma_serve_requests_total{outcome=\"cached\"} " << m_cachedRequests << '\n';
+        out << "denigma_serve_requests_total{outcome=\"error\"} " << m_failedRequests << '\n';
+        writeFamily(out, "denigma_serve_active_requests", "gauge", "Requests being answered now, one per busy connection thread.");
+        out << "denigma_serve_active_requests " << m_activeRequests << '\n';
+        writeFamily(out, "denigma_serve_open_connections", "gauge", "Socket connections open now.");
+        out << "denigma_serve_open_connections " << m_openConnections << '\n';
+        writeFamily(out, "denigma_serve_input_bytes_total", "counter", "Bytes of request payloads read.");
+        out << "denigma_serve_input_bytes_total " << m_inputBytes << '\n';
+        writeFamily(out, "denigma_serve_response_bytes_total", "counter", "Bytes of response frames written.");
+        out << "denigma_serve_response_bytes_total " << m_responseBytes << '\n';
+        writeFamily(out, "denigma_serve_request_duration_seconds", "histogram", "Time from reading a request to its result frame.");
+        writeHistogram("denigma_serve_request_duration_seconds", {}, m_requestLatency);
+
+        writeFamily(out, "denigma_conversions_total", "counter", "Conversions run, by target format and outcome.");
+        for (const auto& [target, counts] : m_targets) {
+            out << "denigma_conversions_total{target=\"" << labelValue(target) << "\",outcome=\"ok\"} " << counts.succeeded << '\n';
+            out << "denigma_conversions_total{target=\"" << labelValue(target) << "\",outcome=\"error\"} " << counts.failed << '\n';
+        }
+        writeFamily(out, "denigma_conversion_output_bytes_total", "counter", "Bytes of output documents, by target format.");
+        for (const auto& [target, counts] : m_targets) {
+            out << "denigma_conversion_output_bytes_total{target=\"" << labelValue(target) << "\"} " << counts.bytesWritten << '\n';
+        }
+        writeFamily(out, "denigma_conversion_phase_seconds", "histogram", "Wall time of each conversion phase that ran.");
+        for (std::size_t index = 0; index < ConversionStats::PHASE_COUNT; ++index) {
+            const std::string labels = "phase=\"" + std::string(ConversionStats::phaseName(static_cast<ConversionStats::Phase>(index))) + "\"";
+            writeHistogram("denigma_conversion_phase_seconds", labels, m_phaseLatency[index]);
+        }
+        writeFamily(out, "denigma_conversion_hot_paths_total", "counter", "Times conversions fell back to a slow or approximate path.");
+        for (std::size_t index = 0; index < ConversionStats::HOT_PATH_COUNT; ++index) {
+            out << "denigma_conversion_hot_paths_total{path=\""
+                << ConversionStats::hotPathName(static_cast<ConversionStats::HotPath>(index)) << "\"} " << m_hotPaths[index] << '\n';
+        }
+        writeFamily(out, "denigma_conversion_cache_lookups_total", "counter", "XML and classification cache lookups made by conversions.");
+        out << "denigma_conversion_cache_lookups_total{result=\"hit\"} " << m_conversionCacheHits << '\n';
+        out << "denigma_conversion_cache_lookups_total{result=\"miss\"} " << m_conversionCacheMisses << '\n';
+    }
+
+    if (m_resultCache) {
+        const auto stats = m_resultCache->stats();
+        writeFamily(out, "denigma_serve_result_cache_lookups_total", "counter", "Result cache lookups, by how they were answered.");
+        out << "denigma_serve_result_cache_lookups_total{result=\"hit\"} " << stats.hits << '\n';
+        out << "denigma_serve_result_cache_lookups_total{result=\"coalesced\"} " << stats.coalesced << '\n';
+        out << "denigma_serve_result_cache_lookups_total{result=\"miss\"} " << stats.misses << '\n';
+        writeFamily(out, "denigma_serve_result_cache_entries", "gauge", "Responses kept by the result cache.");
+        out << "denigma_serve_result_cache_entries " << stats.entries << '\n';
+    }
+    if (m_scheduler) {
+        const auto stats = m_scheduler->stats();
+        writeFamily(out, "denigma_serve_workers", "gauge", "Conversions the scheduler runs at once.");
+        out << "denigma_serve_workers " << stats.workers << '\n';
+        writeFamily(out, "denigma_serve_queued_requests", "gauge", "Requests waiting for a worker, by priority.");
+        out << "denigma_serve_queued_requests{priority=\"interactive\"} " << stats.queuedInteractive << '\n';
+        out << "denigma_serve_queued_requests{priority=\"bulk\"} " << stats.queuedBulk << '\n';
+        writeFamily(out, "denigma_serve_running_requests", "gauge", "Requests holding a worker, by priority.");
+        out << "denigma_serve_running_requests{priority=\"interactive\"} " << stats.runningInteractive << '\n';
+        out << "denigma_serve_running_requests{priority=\"bulk\"} " << stats.runningBulk << '\n';
+        writeFamily(out, "denigma_serve_preemptions_total", "counter", "Bulk conversions cancelled to make room for interactive requests.");
+        out << "denigma_serve_preemptions_total " << stats.preemptions << '\n';
+    }
+    const auto caches = processCacheUsage();
+    writeFamily(out, "denigma_process_cache_bytes", "gauge", "Estimated bytes held by each process-wide cache.");
+    for (const auto& usage : caches) {
+        out << "denigma_process_cache_bytes{cache=\"" << labelValue(usage.name) << "\"} " << usage.bytes << '\n';
+    }
+    writeFamily(out, "denigma_process_cache_evictions_total", "counter", "Entries dropped to keep the process caches within their budget.");
+    for (const auto& usage : caches) {
+        out << "denigma_process_cache_evictions_total{cache=\"" << labelValue(usage.name) << "\"} " << usage.evictions << '\n';
+    }
+    writeFamily(out, "denigma_process_cache_budget_bytes", "gauge", "The process cache budget, or 0 when there is none.");
+    out << "denigma_process_cache_budget_bytes " << processCacheBudget() << '\n';
+    return out.str();
+}
+
+} // namespace denigma
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "denigma/conversion.h"
+
+namespace denigma {
+
+class ServeResultCache;
+class ServeScheduler;
+
+/**
+ * @class ServeMetrics
+ * @brief Counts what a `serve` process has done, for scraping in the Prometheus text exposition format.
+ *
+ * Requests are counted as they start and end, each conversion by its target and outcome, and the phase times and hot
+ * path counts of every ConversionStats it is given are added up. #render also reports the result cache and the
+ * process-wide caches, and the scheduler's queues and workers, as they are at that moment. Safe to use from every connection at once.
+ *
+ * With an export file, #requestFinished also rewrites that file with #render at most once per EXPORT_INTERVAL, for
+ * a scraper's text file collector to pick up. It is replaced by rename, so a reader never sees half of it.
+ */
+class ServeMetrics
+{
+public:
+    static constexpr std::chrono::seconds EXPORT_INTERVAL{ 1 };
+
+    explicit ServeMetrics(const ServeResultCache* resultCache = nullptr, const ServeScheduler* scheduler = nullptr,
+                          std::filesystem::path exportFile = {})
+        : m_resultCache(resultCache), m_scheduler(scheduler), m_exportFile(std::move(exportFile))
+    {
+    }
+
+    /// Upper bounds, in seconds, of the latency histogram buckets. A final `+Inf` bucket holds the rest.
+    static constexpr std::array<double, 12> LATENCY_BUCKETS{ 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30 };
+
+    /// A request was read and is about to be answered.
+    void requestStarted(std::size_t inputBytes);
+
+    /// A request counted by requestStarted was answered, converted or from the result cache.
+    void requestFinished(std::chrono::nanoseconds duration, std::size_t responseBytes, bool hasError, bool fromCache);
+
+    /// A conversion to target ended, successfully or not, with these stats.
+    void conversionFinished(std::string_view target, const ConversionStats& stats, bool hasError);
+
+    /// Adds the phase times of a source's preparation, which no single target's stats include.
+    void preparationFinished(const ConversionStats& stats);
+
+    void connectionOpened();
+    void connectionClosed();
+
+    /// Returns every metric in the Prometheus text exposition format (version 0.0.4).
+    std::string render() const;
+
+    /// Writes #render to the export file now, if there is one.
+    /// @throws std::filesystem::filesystem_error or std::runtime_error if it cannot be written.
+    void exportNow() const;
+
+private:
+    struct Histogram
+    {
+        std::array<std::uint64_t, LATENCY_BUCKETS.size()> buckets{};   ///< not cumulative; render sums them
+        std::uint64_t count{};
+        double sum{};
+
+        void observe(double seconds);
+    };
+
+    struct TargetCounts
+    {
+        std::uint64_t succeeded{};
+        std::uint64_t failed{};
+        std::uint64_t bytesWritten{};
+    };
+
+    void addPhases(const ConversionStats& stats);
+
+    const ServeResultCache* m_resultCache;
+    const ServeScheduler* m_scheduler;
+    std::filesystem::path m_exportFile;
+    mutable std::mutex m_exportMutex;
+    std::chrono::steady_clock::time_point m_lastExport{};   ///< guarded by m_mutex
+
+    mutable std::mutex m_mutex;
+    std::uint64_t m_convertedRequests{};
+    std::uint64_t m_failedRequests{};
+    std::uint64_t m_cachedRequests{};
+    std::uint64_t m_inputBytes{};
+    std::uint64_t m_responseBytes{};
+    std::uint64_t m_activeRequests{};
+    std::uint64_t m_openConnections{};
+    Histogram m_requestLatency;
+    std::array<Histogram, ConversionStats::PHASE_COUNT> m_phaseLatency;
+    std::array<std::uint64_t, ConversionStats::HOT_PATH_COUNT> m_hotPaths{};
+    std::uint64_t m_conversionCacheHits{};
+    std::uint64_t m_conversionCacheMisses{};
+    std::map<std::string, TargetCounts, std::less<>> m_targets;
+};
+
+} // namespace denigma
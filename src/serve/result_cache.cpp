@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "serve/result_cache.h"
+
+namespace denigma {
+
+ServeResultCache::ServeResultCache(std::size_t capacityBytes)
+    : m_capacityBytes(capacityBytes),
+      m_account("serve-results",
+          [this]() -> std::optional<std::uint64_t> {
+              std::lock_guard<std::mutex> lock(m_mutex);
+              if (m_entries.empty()) {
+                  return std::nullopt;
+              }
+              return m_entries.back().lastUse;
+          },
+          [this]() -> std::size_t {
+              std::lock_guard<std::mutex> lock(m_mutex);
+              return m_entries.empty() ? 0 : dropOldest();
+          })
+{
+}
+
+std::shared_ptr<const ServeResultCache::Response> ServeResultCache::get(const std::string& key,
+    const std::function<Response()>& produce, bool& produced)
+{
+    produced = false;
+    std::promise<std::shared_ptr<const Response>> promise;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (const auto entry = m_entryIndex.find(key); entry != m_entryIndex.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, entry->second);
+            entry->second->lastUse = utils::CacheBudget::tick();
+            ++m_stats.hits;
+            return entry->second->response;
+        }
+        if (const auto inFlight = m_inFlight.find(key); inFlight != m_inFlight.end()) {
+            auto future = inFlight->second;
+            ++m_stats.coalesced;
+            lock.unlock();
+            return future.get();
+        }
+        m_inFlight.emplace(key, promise.get_future().share());
+        ++m_stats.misses;
+    }
+
+    std::shared_ptr<const Response> response;
+    try {
+        response = std::make_shared<const Response>(produce());
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_inFlight.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inFlight.erase(key);
+        if (!response->hasError) {
+            keep(key, response);
+        }
+    }
+    utils::CacheBudget::instance().enforce();
+    promise.set_value(response);
+    produced = true;
+    return response;
+}
+
+ServeResultCache::Stats ServeResultCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void ServeResultCache::keep(const std::string& key, std::shared_ptr<const Response> response)
+{
+    const std::size_t bytes = key.size() + response->frames.size();
+    if (bytes > m_capacityBytes) {
+        return; // it would only push out everything else and then itself
+    }
+    m_entries.push_front({ key, std::move(response), utils::CacheBudget::tick() });
+    m_entryIndex.emplace(key, m_entries.begin());
+    m_stats.bytes += bytes;
+    m_account.charge(bytes);
+    while (m_stats.bytes > m_capacityBytes) {
+        m_account.credit(dropOldest());
+    }
+    m_stats.entries = m_entries.size();
+}
+
+std::size_t ServeResultCache::dropOldest()
+{
+    const auto& oldest = m_entries.back();
+    const std::size_t bytes = oldest.bytes();
+    m_stats.bytes -= bytes;
+    m_entryIndex.erase(oldest.key);
+    m_entries.pop_back();
+    m_stats.entries = m_entries.size();
+    return bytes;
+}
+
+} // namespace denigma
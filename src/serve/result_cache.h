@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "utils/cache_budget.h"
+
+namespace denigma {
+
+/**
+ * @class ServeResultCache
+ * @brief Keeps the responses of recent `serve` requests and lets identical concurrent requests share one conversion.
+ *
+ * A response is the exact bytes of its frames, so a hit is answered by writing them out again. Responses are kept
+ * least recently used first out, until the keys and frames held reach the byte capacity. A capacity of 0 keeps
+ * nothing but still coalesces requests that are in flight at the same time. The kept responses are also charged to
+ * the process cache budget, which may drop the least recently used of them sooner.
+ */
+class ServeResultCache
+{
+public:
+    /// @brief The frames written for one request and whether any of them reported an error.
+    struct Response
+    {
+        std::string frames;
+        bool hasError{};
+    };
+
+    /// @brief Counts since the cache was created.
+    struct Stats
+    {
+        std::uint64_t hits{};       ///< answered from a kept response
+        std::uint64_t coalesced{};  ///< answered by waiting for an identical request already being converted
+        std::uint64_t misses{};     ///< converted
+        std::size_t entries{};      ///< responses kept now
+        std::size_t bytes{};        ///< bytes of keys and frames kept now
+    };
+
+    explicit ServeResultCache(std::size_t capacityBytes);
+
+    /// Returns the response for key: a kept one, the one an identical request in flight produces, or else the one
+    /// produce returns, which is kept unless it has an error. produced is set to true only in the last case.
+    /// If produce throws, the exception reaches every request that waited for it and nothing is kept.
+    std::shared_ptr<const Response> get(const std::string& key, const std::function<Response()>& produce, bool& produced);
+
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        std::shared_ptr<const Response> response;
+        std::uint64_t lastUse{};    ///< CacheBudget::tick() when last written or answered
+
+        std::size_t bytes() const { return key.size() + response->frames.size(); }
+    };
+    using Entries = std::list<Entry>;
+
+    void keep(const std::string& key, std::shared_ptr<const Response> response);
+    /// Drops the least recently used entry and returns its bytes. Requires m_mutex.
+    std::size_t dropOldest();
+
+    std::size_t m_capacityBytes;
+    mutable std::mutex m_mutex;
+    Entries m_entries;  ///< most recently used first
+    std::unordered_map<std::string, Entries::iterator> m_entryIndex;
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<const Response>>> m_inFlight;
+    Stats m_stats;
+    utils::CacheBudget::Account m_account;  ///< last, so it is unregistered before the entries go
+};
+
+} // namespace denigma
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "core/host_resources.h"
+#include "serve/scheduler.h"
+
+namespace denigma {
+
+struct ServeScheduler::Ticket::Slot
+{
+    ServePriority priority{};
+    std::uint64_t cost{};
+    bool preemptible{};
+    CancellationToken cancellation;
+    std::atomic<bool> preempted{};
+};
+
+ServeScheduler::Ticket::~Ticket()
+{
+    if (m_slot) {
+        m_scheduler->release(m_slot);
+    }
+}
+
+const CancellationToken& ServeScheduler::Ticket::cancellation() const
+{
+    return m_slot->cancellation;
+}
+
+bool ServeScheduler::Ticket::preempted() const
+{
+    return m_slot->preempted.load(std::memory_order_relaxed);
+}
+
+ServeScheduler::ServeScheduler(const Limits& limits) : m_limits(limits)
+{
+    if (m_limits.workers == 0) {
+        m_limits.workers = availableCpuCount();
+    }
+}
+
+ServePriority ServeScheduler::classify(std::optional<ServePriority> requested, std::uint64_t cost) const
+{
+    if (requested) {
+        return *requested;
+    }
+    return cost <= m_limits.interactiveCostLimit ? ServePriority::Interactive : ServePriority::Bulk;
+}
+
+ServeScheduler::Ticket ServeScheduler::admit(ServePriority priority, std::uint64_t cost, bool preemptible)
+{
+    auto slot = std::make_shared<Ticket::Slot>();
+    slot->priority = priority;
+    slot->cost = cost;
+    slot->preemptible = priority == ServePriority::Bulk && preemptible;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const std::uint64_t arrival = m_nextArrival++;
+    auto running = [&]() { return m_runningInteractive + m_runningBulk.size(); };
+    if (priority == ServePriority::Interactive) {
+        m_interactiveQueue.push_back(arrival);
+        bool preemptionRequested = false;
+        while (m_interactiveQueue.front() != arrival || running() >= m_limits.workers) {
+            if (m_interactiveQueue.front() == arrival && !preemptionRequested) {
+                preemptionRequested = preemptNewestBulk();
+            }
+            m_changed.wait(lock);
+        }
+        m_interactiveQueue.pop_front();
+        ++m_runningInteractive;
+    } else {
+        const unsigned bulkWorkers = m_limits.workers > m_limits.reservedInteractive ? m_limits.workers - m_limits.reservedInteractive : 1;
+        auto withinBudget = [&]() {
+            return m_runningBulk.empty() || m_limits.bulkCostBudget == 0 || m_runningBulkCost + cost <= m_limits.bulkCostBudget;
+        };
+        m_bulkQueue.push_back(arrival);
+        while (m_bulkQueue.front() != arrival || !m_interactiveQueue.empty() || running() >= m_limits.workers
+               || m_runningBulk.size() >= bulkWorkers || !withinBudget()) {
+            m_changed.wait(lock);
+        }
+        m_bulkQueue.pop_front();
+        m_runningBulk.push_back(slot);
+        m_runningBulkCost += cost;
+    }
+    // the next request of either class may now be at the front of its queue
+    m_changed.notify_all();
+    return Ticket(*this, std::move(slot));
+}
+
+ServeScheduler::Stats ServeScheduler::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return { m_limits.workers, m_interactiveQueue.size(), m_bulkQueue.size(), m_runningInteractive, m_runningBulk.size(),
+             m_preemptions };
+}
+
+void ServeScheduler::release(const std::shared_ptr<Ticket::Slot>& slot)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (slot->priority == ServePriority::Interactive) {
+            --m_runningInteractive;
+        } else {
+            m_runningBulk.erase(std::find(m_runningBulk.begin(), m_runningBulk.end(), slot));
+            m_runningBulkCost -= slot->cost;
+        }
+    }
+    m_changed.notify_all();
+}
+
+bool ServeScheduler::preemptNewestBulk()
+{
+    for (auto it = m_runningBulk.rbegin(); it != m_runningBulk.rend(); ++it) {
+        auto& slot = **it;
+        if (slot.preemptible && !slot.preempted.load(std::memory_order_relaxed)) {
+            slot.preempted.store(true, std::memory_order_relaxed);
+            slot.cancellation.cancel();
+            ++m_preemptions;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace denigma
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "denigma/conversion.h"
+
+namespace denigma {
+
+/// @brief Which share of the `serve` workers a request competes for.
+enum class ServePriority
+{
+    Interactive,    ///< previews and excerpts: admitted first, into reserved capacity, and may preempt bulk work
+    Bulk            ///< re-conversions: admitted when no interactive request waits, within the bulk cost budget
+};
+
+/**
+ * @class ServeScheduler
+ * @brief Admits `serve` conversions from every connection into a fixed number of workers, by priority and cost.
+ *
+ * Each class is first come, first served. Bulk work never holds the reserved workers, and is held back while any
+ * interactive request waits or while the bulk work already running would exceed the bulk cost budget; a bulk request
+ * larger than the whole budget still runs alone. An interactive request that finds every worker busy cancels the most
+ * recently admitted preemptible bulk conversion, which stops at its next cancellation check and is run again later.
+ * Cost is the caller's estimate of the uncompressed source bytes.
+ */
+class ServeScheduler
+{
+public:
+    struct Limits
+    {
+        unsigned workers{};                     ///< conversions run at once; 0 uses availableCpuCount()
+        unsigned reservedInteractive{ 1 };      ///< workers bulk conversions never take (at least one is left to them)
+        std::uint64_t bulkCostBudget{};         ///< total cost of bulk conversions run at once; 0 is no limit
+        std::uint64_t interactiveCostLimit{ std::uint64_t(1) << 20 }; ///< most cost of a request that does not state its priority and is still interactive
+        unsigned maxPreemptions{ 2 };           ///< times one bulk request may be preempted before it runs to the end
+    };
+
+    /// @brief Counts at one moment, and preemptions since the scheduler was created.
+    struct Stats
+    {
+        unsigned workers{};
+        std::size_t queuedInteractive{};
+        std::size_t queuedBulk{};
+        std::size_t runningInteractive{};
+        std::size_t runningBulk{};
+        std::uint64_t preemptions{};
+    };
+
+    /// @class Ticket
+    /// @brief One admitted conversion's worker, released when the ticket is destroyed.
+    class Ticket
+    {
+    public:
+        Ticket(Ticket&&) noexcept = default;
+        ~Ticket();
+
+        /// Cancelled when the scheduler preempts this conversion. Pass it in CommonOptions::cancellation.
+        const CancellationToken& cancellation() const;
+
+        /// True once the scheduler has preempted this conversion.
+        bool preempted() const;
+
+    private:
+        friend class ServeScheduler;
+        struct Slot;
+
+        Ticket(ServeScheduler& scheduler, std::shared_ptr<Slot> slot) : m_scheduler(&scheduler), m_slot(std::move(slot)) {}
+
+        ServeScheduler* m_scheduler;
+        std::shared_ptr<Slot> m_slot;
+    };
+
+    explicit ServeScheduler(const Limits& limits);
+
+    const Limits& limits() const { return m_limits; }
+
+    /// Returns requested if given, otherwise the class a request of this cost falls in.
+    ServePriority classify(std::optional<ServePriority> requested, std::uint64_t cost) const;
+
+    /// Blocks until the request may run. preemptible is ignored for interactive requests.
+    Ticket admit(ServePriority priority, std::uint64_t cost, bool preemptible);
+
+    Stats stats() const;
+
+private:
+    void release(const std::shared_ptr<Ticket::Slot>& slot);
+    bool preemptNewestBulk();
+
+    Limits m_limits;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<std::uint64_t> m_interactiveQueue;   ///< waiting requests, by arrival number
+    std::deque<std::uint64_t> m_bulkQueue;
+    std::uint64_t m_nextArrival{};
+    std::size_t m_runningInteractive{};
+    std::vector<std::shared_ptr<Ticket::Slot>> m_runningBulk;   ///< in order of admission
+    std::uint64_t m_runningBulkCost{};
+    std::uint64_t m_preemptions{};
+};
+
+} // namespace denigma
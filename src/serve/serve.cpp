@@ -0,0 +1,873 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "denigma/io/random_access_reader.h"
+#include "denigma/prepared_document.h"
+#include "denigma/process_caches.h"
+#include "core/host_resources.h"
+#include "core/xxhash64.h"
+#include "export/export.h"
+#include "serve/serve.h"
+#include "utils/stringutils.h"
+#include "utils/ziputils.h"
+
+namespace denigma {
+
+namespace {
+
+constexpr std::uint32_t MAX_FRAME_SIZE = std::uint32_t(1) << 30;
+constexpr size_t FRAME_LENGTH_BYTES = sizeof(std::uint32_t);  ///< every frame and every length-prefixed field starts with one
+constexpr size_t FRAME_TYPE_BYTES = 1;
+constexpr std::size_t DEFAULT_RESULT_CACHE_BYTES = std::size_t(256) << 20;
+
+struct ServeTarget
+{
+    std::string_view name;
+    FormatId format;
+};
+
+constexpr std::array<ServeTarget, 4> SERVE_TARGETS = { {
+    { "mnx", FormatId::MnxJson },
+    { "musicxml", FormatId::MusicXml },
+    { "mss", FormatId::MssXml },
+    { "svg", FormatId::Svg },
+} };
+
+/// The target that asks for the server's metrics rather than a conversion.
+constexpr std::string_view METRICS_TARGET = "metrics";
+
+struct ServeRequest
+{
+    bool metrics{};     ///< answer with ServeMetrics::render; there is no source or input
+    std::vector<ServeTarget> targets;
+    std::optional<FormatId> source;
+    std::optional<ServePriority> priority;
+    std::string name;
+    std::vector<std::string> args;
+    std::string_view input;
+};
+
+/// The buffered-log replay is shared by every connection.
+std::mutex& serveContextMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::string readTextFile(const std::filesystem::path& path)
+{
+    std::ifstream file;
+    file.exceptions(std::ios::failbit | std::ios::badbit);
+    file.open(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/// Returns the next frame payload, or std::nullopt if input ends before a new frame starts.
+std::optional<std::string> readFrame(std::istream& input)
+{
+    std::array<unsigned char, FRAME_LENGTH_BYTES> prefix{};
+    input.read(reinterpret_cast<char*>(prefix.data()), static_cast<std::streamsize>(prefix.size()));
+    if (input.gcount() == 0 && input.eof()) {
+        return std::nullopt;
+    }
+    if (input.gcount() != static_cast<std::streamsize>(prefix.size())) {
+        throw std::runtime_error("Request stream ended inside a frame header.");
+    }
+    const std::uint32_t size = (std::uint32_t(prefix[0]) << 24) | (std::uint32_t(prefix[1]) << 16)
+                             | (std::uint32_t(prefix[2]) << 8) | std::uint32_t(prefix[3]);
+    if (size > MAX_FRAME_SIZE) {
+        throw std::runtime_error("Request frame of " + std::to_string(size) + " bytes exceeds the maximum frame size.");
+    }
+    std::string payload(size, '\0');
+    if (size > 0 && !input.read(payload.data(), static_cast<std::streamsize>(size))) {
+        throw std::runtime_error("Request stream ended inside a frame.");
+    }
+    return payload;
+}
+
+class ResponseWriter
+{
+public:
+    explicit ResponseWriter(std::ostream& output) : m_output(output) {}
+
+    /// Also appends every frame written from now on to record, or stops doing so if it is nullptr.
+    void setRecord(std::string* record) { m_record = record; }
+
+    /// Bytes of all frames written so far.
+    std::uint64_t bytesWritten() const { return m_bytesWritten; }
+
+    /// Writes frames recorded earlier.
+    void replay(std::string_view frames)
+    {
+        write(frames.data(), frames.size());
+        m_output.flush();
+    }
+
+    void output(std::string_view target, std::string_view suggestedName, std::span<const std::byte> data)
+    {
+        writeLength(FRAME_TYPE_BYTES + FRAME_LENGTH_BYTES + target.size() + FRAME_LENGTH_BYTES + suggestedName.size() + data.size());
+        put('O');
+        writeLength(target.size());
+        write(target.data(), target.size());
+        writeLength(suggestedName.size());
+        write(suggestedName.data(), suggestedName.size());
+        write(reinterpret_cast<const char*>(data.data()), data.size());
+        m_output.flush();
+    }
+
+    void diagnostic(MessageSeverity severity, std::string_view message)
+    {
+        writeLength(FRAME_TYPE_BYTES + 1 + message.size());
+        put('D');
+        put(severityCode(severity));
+        write(message.data(), message.size());
+    }
+
+    void diagnostics(const ConversionResult& result)
+    {
+        for (const auto& item : result.diagnostics()) {
+            diagnostic(item.severity, item.message);
+        }
+    }
+
+    void result(bool hasError)
+    {
+        writeLength(FRAME_TYPE_BYTES + 1);
+        put('R');
+        put(hasError ? '\1' : '\0');
+        m_output.flush();
+    }
+
+private:
+    static char severityCode(MessageSeverity severity)
+    {
+        switch (severity) {
+        case MessageSeverity::Warning: return 'W';
+        case MessageSeverity::Error: return 'E';
+        case MessageSeverity::Verbose: return 'V';
+        default:
+        case MessageSeverity::Info: return 'I';
+        }
+    }
+
+    void writeLength(size_t length)
+    {
+        if (length > MAX_FRAME_SIZE) {
+            throw std::runtime_error("Response frame of " + std::to_string(length) + " bytes exceeds the maximum frame size.");
+        }
+        const auto value = static_cast<std::uint32_t>(length);
+        const std::array<char, FRAME_LENGTH_BYTES> prefix = { static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+                                             static_cast<char>(value >> 8), static_cast<char>(value) };
+        write(prefix.data(), prefix.size());
+    }
+
+    void put(char value) { write(&value, 1); }
+
+    void write(const char* data, size_t size)
+    {
+        m_output.write(data, static_cast<std::streamsize>(size));
+        m_bytesWritten += size;
+        if (m_record) {
+            m_record->append(data, size);
+        }
+    }
+
+    std::ostream& m_output;
+    std::string* m_record{};
+    std::uint64_t m_bytesWritten{};
+};
+
+ServeRequest parseRequest(std::string_view payload)
+{
+    ServeRequest request;
+    std::optional<size_t> inputStart;
+    size_t lineStart = 0;
+    while (lineStart < payload.size()) {
+        const size_t lineEnd = payload.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            break;
+        }
+        std::string_view line = payload.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            inputStart = lineStart;
+            break;
+        }
+        const size_t equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            throw std::invalid_argument("Invalid request header line: " + std::string(line));
+        }
+        const auto key = line.substr(0, equals);
+        const auto value = line.substr(equals + 1);
+        if (key == "target") {
+            size_t start = 0;
+            while (start <= value.size()) {
+                const size_t comma = (std::min)(value.find(',', start), value.size());
+                const auto targetName = value.substr(start, comma - start);
+                if (targetName == METRICS_TARGET) {
+                    request.metrics = true;
+                    start = comma + 1;
+                    continue;
+                }
+                const auto it = std::find_if(SERVE_TARGETS.begin(), SERVE_TARGETS.end(), [&](const ServeTarget& target) {
+                    return target.name == targetName;
+                });
+                if (it == SERVE_TARGETS.end()) {
+                    throw std::invalid_argument("Unsupported target format: " + std::string(targetName));
+                }
+                request.targets.push_back(*it);
+                start = comma + 1;
+            }
+        } else if (key == "source") {
+            if (value == "musx") {
+                request.source = FormatId::Musx;
+            } else if (value == "enigmaxml") {
+                request.source = FormatId::EnigmaXml;
+            } else if (value == "enigmabin") {
+                request.source = FormatId::EnigmaBinary;
+            } else {
+                throw std::invalid_argument("Unsupported source format: " + std::string(value));
+            }
+        } else if (key == "priority") {
+            if (value == "interactive") {
+                request.priority = ServePriority::Interactive;
+            } else if (value == "bulk") {
+                request.priority = ServePriority::Bulk;
+            } else {
+                throw std::invalid_argument("Unsupported priority: " + std::string(value));
+            }
+        } else if (key == "name") {
+            request.name = std::string(value);
+        } else if (key == "arg") {
+            request.args.emplace_back(value);
+        } else {
+            throw std::invalid_argument("Unknown request header: " + std::string(key));
+        }
+    }
+    if (!inputStart) {
+        throw std::invalid_argument("Request header is not terminated by an empty line.");
+    }
+    if (request.metrics) {
+        if (!request.targets.empty()) {
+            throw std::invalid_argument("The metrics target cannot be combined with conversion targets.");
+        }
+        return request;
+    }
+    if (request.targets.empty()) {
+        throw std::invalid_argument("Request does not specify a target format.");
+    }
+    if (!request.source && !request.name.empty()) {
+        const auto namePath = utils::utf8ToPath(request.name);
+        if (utils::pathExtensionEquals(namePath, MUSX_EXTENSION)) {
+            request.source = FormatId::Musx;
+        } else if (utils::pathExtensionEquals(namePath, ENIGMAXML_EXTENSION)) {
+            request.source = FormatId::EnigmaXml;
+        } else if (utils::pathExtensionEquals(namePath, ENIGMABIN_EXTENSION)) {
+            request.source = FormatId::EnigmaBinary;
+        }
+    }
+    if (!request.source) {
+        throw std::invalid_argument("Request does not specify a source format.");
+    }
+    request.input = payload.substr(*inputStart);
+    return request;
+}
+
+/// Applies the request's option tokens on top of the server's options.
+DenigmaContext makeRequestContext(const DenigmaContext& serverContext, const ServeRequest& request)
+{
+    DenigmaContext requestContext = [&]() {
+        std::lock_guard<std::mutex> lock(serveContextMutex());
+        return serverContext;
+    }();
+    std::vector<arg_string> argStrings;
+    argStrings.emplace_back(requestContext.programName);
+    for (const auto& arg : request.args) {
+        argStrings.emplace_back(arg);
+    }
+    std::vector<arg_char*> argv;
+    for (auto& argString : argStrings) {
+        argv.push_back(argString.data());
+    }
+    const auto remaining = requestContext.parseOptions(static_cast<int>(argv.size()), argv.data());
+    if (!remaining.empty()) {
+        throw std::invalid_argument("Unknown or misplaced option: " + std::string(arg_string(remaining.front())));
+    }
+    if (requestContext.mnxSchemaPath && requestContext.mnxSchemaPath != serverContext.mnxSchemaPath) {
+        requestContext.mnxSchema = readTextFile(requestContext.mnxSchemaPath.value());
+    }
+    if (request.name.empty()) {
+        requestContext.inputFilePath = request.source == FormatId::Musx ? "input.musx" : "input.enigmaxml";
+    } else {
+        requestContext.inputFilePath = utils::utf8ToPath(request.name);
+    }
+    requestContext.conversionResult = nullptr;
+    requestContext.logCallback = nullptr;
+    requestContext.errorOccurred = false;
+    return requestContext;
+}
+
+/// Returns what identifies the response to request: the hash and size of its input, then every header but the input.
+/// Option tokens are kept in order, since a value belongs to the token before it.
+std::string calcRequestCacheKey(const ServeRequest& request)
+{
+    const auto inputBytes = std::as_bytes(std::span<const char>(request.input.data(), request.input.size()));
+    std::string key = std::to_string(Xxh64::hash(inputBytes)) + ":" + std::to_string(request.input.size());
+    key += "\nsource=" + std::to_string(static_cast<int>(request.source.value_or(FormatId::Musx)));
+    key += "\nname=" + request.name;
+    for (const auto& target : request.targets) {
+        key += "\ntarget=";
+        key += target.name;
+    }
+    for (const auto& arg : request.args) {
+        key += "\narg=" + arg;
+    }
+    return key;
+}
+
+/// Returns the scheduling cost of request: the uncompressed size of the files in a musx archive, read from its central
+/// directory without inflating anything, or else the size of the input.
+std::uint64_t estimateRequestCost(const ServeRequest& request)
+{
+    if (request.source == FormatId::Musx) {
+        try {
+            const auto inputBytes = std::as_bytes(std::span<const char>(request.input.data(), request.input.size()));
+            const BufferRandomAccessReader reader(inputBytes);
+            DenigmaContext probeContext(DENIGMA_NAME);
+            probeContext.quiet = true;
+            const utils::ZipArchiveIndex archive(reader, probeContext);
+            std::uint64_t cost = 0;
+            for (const auto& entry : archive.entries()) {
+                cost += entry.uncompressedSize;
+            }
+            return cost;
+        } catch (const std::exception&) {
+            // the conversion reports what is wrong with the archive
+        }
+    }
+    return request.input.size();
+}
+
+struct ServeOutcome
+{
+    bool hasError{};
+    bool cancelled{};   ///< a conversion stopped at a cancellation check
+};
+
+/// Converts one request, writing its outputs and diagnostics. Each conversion stops early once cancellation is cancelled.
+ServeOutcome serveRequest(const ServeRequest& request, const DenigmaContext& requestContext, ResponseWriter& writer,
+                          ServeMetrics* metrics, const CancellationToken* cancellation)
+{
+    ServeOutcome outcome;
+    const auto inputBytes = std::as_bytes(std::span<const char>(request.input.data(), request.input.size()));
+    const auto prepared = [&]() {
+        auto options = makeCommonOptions(requestContext);
+        if (cancellation) {
+            options.cancellation = *cancellation;
+        }
+        if (request.source == FormatId::Musx) {
+            return PreparedDocument::fromMusx(BufferRandomAccessReader(inputBytes), options);
+        }
+        return PreparedDocument::fromEnigmaXml(inputBytes, options); // a binary cache is recognized by the reader
+    }();
+    writer.diagnostics(prepared.preparationResult());
+    if (metrics) {
+        metrics->preparationFinished(prepared.preparationResult().stats());
+    }
+    if (prepared.preparationResult().hasError()) {
+        outcome.hasError = true;
+        outcome.cancelled = prepared.preparationResult().cancelled();
+        return outcome;
+    }
+
+    for (const auto& target : request.targets) {
+        const auto* converter = defaultConverterRegistry().findPrepared(target.format);
+        if (!converter) {
+            throw std::logic_error("No prepared-document converter is registered for " + std::string(target.name) + ".");
+        }
+        const MultiOutputCallback outputCallback = [&](std::string_view suggestedName, std::span<const std::byte> data) {
+            writer.output(target.name, suggestedName, data);
+        };
+        const auto convert = [&](auto options) {
+            if (cancellation) {
+                options.common.cancellation = *cancellation;
+            }
+            return converter->convert(prepared, outputCallback, ConversionRequest{ &options });
+        };
+        try {
+            ConversionResult result;
+            switch (target.format) {
+            case FormatId::MnxJson: result = convert(makeMnxOptions(requestContext)); break;
+            case FormatId::MusicXml: result = convert(makeMusicXmlOptions(requestContext)); break;
+            case FormatId::MssXml: result = convert(makeMssOptions(requestContext)); break;
+            case FormatId::Svg: result = convert(makeSvgOptions(requestContext)); break;
+            default:
+                throw std::logic_error("Unsupported target format: " + std::string(target.name));
+            }
+            writer.diagnostics(result);
+            outcome.hasError = outcome.hasError || result.hasError();
+            if (result.cancelled()) {
+                outcome.cancelled = true;
+                return outcome; // the remaining targets would stop at their first check
+            }
+            if (metrics) {
+                metrics->conversionFinished(target.name, result.stats(), result.hasError());
+            }
+        } catch (const std::exception& e) {
+            writer.diagnostic(MessageSeverity::Error, e.what());
+            requestContext.logMessage(LogMsg() << e.what(), MessageSeverity::Error);
+            outcome.hasError = true;
+            if (metrics) {
+                metrics->conversionFinished(target.name, {}, true);
+            }
+        }
+    }
+    return outcome;
+}
+
+/// Converts request once scheduler admits it. A bulk request's frames are held back until it has finished, so one
+/// preempted by interactive work is run again from the start without its client seeing the abandoned attempt.
+/// Returns true if any error was reported.
+bool serveScheduledRequest(const ServeRequest& request, const DenigmaContext& requestContext, ResponseWriter& writer,
+                           ServeMetrics* metrics, ServeScheduler& scheduler)
+{
+    const auto cost = estimateRequestCost(request);
+    const auto priority = scheduler.classify(request.priority, cost);
+    for (unsigned attempt = 0; ; ++attempt) {
+        auto ticket = scheduler.admit(priority, cost, attempt < scheduler.limits().maxPreemptions);
+        if (priority == ServePriority::Interactive) {
+            return serveRequest(request, requestContext, writer, metrics, nullptr).hasError;
+        }
+        std::ostringstream held;
+        ResponseWriter heldWriter(held);
+        const auto outcome = serveRequest(request, requestContext, heldWriter, metrics, &ticket.cancellation());
+        if (!outcome.cancelled || !ticket.preempted()) {
+            writer.replay(held.str());
+            return outcome.hasError;
+        }
+        requestContext.logMessage(LogMsg() << "Preempted by interactive work; converting again.", MessageSeverity::Verbose);
+    }
+}
+
+#ifndef _WIN32
+
+/// Buffered stream over a connected socket, used for both directions of a connection.
+class SocketStreamBuf final : public std::streambuf
+{
+public:
+    explicit SocketStreamBuf(int socket) : m_socket(socket)
+    {
+        setg(m_input.data(), m_input.data(), m_input.data());
+        setp(m_output.data(), m_output.data() + m_output.size());
+    }
+
+protected:
+    int_type underflow() override
+    {
+        ssize_t received = 0;
+        do {
+            received = ::recv(m_socket, m_input.data(), m_input.size(), 0);
+        } while (received < 0 && errno == EINTR);
+        if (received <= 0) {
+            return traits_type::eof();
+        }
+        setg(m_input.data(), m_input.data(), m_input.data() + received);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    int_type overflow(int_type ch) override
+    {
+        if (!flushOutput()) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        return flushOutput() ? 0 : -1;
+    }
+
+private:
+    bool flushOutput()
+    {
+#ifdef MSG_NOSIGNAL
+        constexpr int sendFlags = MSG_NOSIGNAL; // a client that hangs up must not kill the server
+#else
+        constexpr int sendFlags = 0;
+#endif
+        const char* data = pbase();
+        size_t remaining = static_cast<size_t>(pptr() - pbase());
+        while (remaining > 0) {
+            const ssize_t sent = ::send(m_socket, data, remaining, sendFlags);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += sent;
+            remaining -= static_cast<size_t>(sent);
+        }
+        setp(m_output.data(), m_output.data() + m_output.size());
+        return true;
+    }
+
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    int m_socket;
+    std::array<char, BUFFER_SIZE> m_input{};
+    std::array<char, BUFFER_SIZE> m_output{};
+};
+
+#endif // _WIN32
+
+} // namespace
+
+int serveConversions(std::istream& input, std::ostream& output, DenigmaContext& denigmaContext, ServeResultCache* resultCache,
+                     ServeMetrics* metrics, ServeScheduler* scheduler)
+{
+    ResponseWriter writer(output);
+    while (true) {
+        std::optional<std::string> payload;
+        try {
+            payload = readFrame(input);
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(serveContextMutex());
+            denigmaContext.logMessage(LogMsg() << e.what(), MessageSeverity::Error);
+            return 1;
+        }
+        if (!payload) {
+            if (resultCache) {
+                const auto stats = resultCache->stats();
+                std::lock_guard<std::mutex> lock(serveContextMutex());
+                denigmaContext.logMessage(LogMsg() << "Result cache: " << stats.hits << " hits, " << stats.coalesced
+                    << " coalesced, " << stats.misses << " misses, " << stats.entries << " responses kept ("
+                    << stats.bytes << " bytes).", MessageSeverity::Verbose);
+            }
+            for (const auto& usage : processCacheUsage()) {
+                std::lock_guard<std::mutex> lock(serveContextMutex());
+                denigmaContext.logMessage(LogMsg() << "Process cache " << usage.name << ": " << usage.bytes << " bytes, "
+                    << usage.evictions << " evictions.", MessageSeverity::Verbose);
+            }
+            if (metrics) {
+                try {
+                    metrics->exportNow();
+                } catch (const std::exception& e) {
+                    std::lock_guard<std::mutex> lock(serveContextMutex());
+                    denigmaContext.logMessage(LogMsg() << e.what(), MessageSeverity::Warning);
+                }
+            }
+            return 0;
+        }
+
+        std::vector<DenigmaContext::BufferedLogMessage> log;
+        bool hasError = false;
+        bool fromCache = false;
+        const auto requestStart = std::chrono::steady_clock::now();
+        const auto responseStart = writer.bytesWritten();
+        if (metrics) {
+            metrics->requestStarted(payload->size());
+        }
+        try {
+            const auto request = parseRequest(*payload);
+            if (request.metrics) {
+                if (!metrics) {
+                    throw std::invalid_argument("This server does not collect metrics.");
+                }
+                const auto text = metrics->render();
+                writer.output(METRICS_TARGET, "metrics.prom", std::as_bytes(std::span<const char>(text.data(), text.size())));
+            } else {
+                auto requestContext = makeRequestContext(denigmaContext, request);
+                requestContext.logBuffer = &log;
+                const auto convert = [&](ResponseWriter& responseWriter) {
+                    if (scheduler) {
+                        return serveScheduledRequest(request, requestContext, responseWriter, metrics, *scheduler);
+                    }
+                    return serveRequest(request, requestContext, responseWriter, metrics, nullptr).hasError;
+                };
+                if (resultCache) {
+                    // the conversion streams its frames as usual while they are recorded for later identical requests
+                    bool produced = false;
+                    const auto response = resultCache->get(calcRequestCacheKey(request), [&]() {
+                        ServeResultCache::Response recorded;
+                        writer.setRecord(&recorded.frames);
+                        try {
+                            recorded.hasError = convert(writer);
+                        } catch (...) {
+                            writer.setRecord(nullptr);
+                            throw;
+                        }
+                        writer.setRecord(nullptr);
+                        return recorded;
+                    }, produced);
+                    if (!produced) {
+                        fromCache = true;
+                        writer.replay(response->frames);
+                        requestContext.logMessage(LogMsg() << "Answered from the result cache.", MessageSeverity::Verbose);
+                    }
+                    hasError = response->hasError;
+                } else {
+                    hasError = convert(writer);
+                }
+            }
+        } catch (const std::exception& e) {
+            writer.diagnostic(MessageSeverity::Error, e.what());
+            log.push_back({ MessageSeverity::Error, e.what(), {} });
+            hasError = true;
+        }
+        writer.result(hasError);
+        if (metrics) {
+            try {
+                metrics->requestFinished(std::chrono::steady_clock::now() - requestStart,
+                    static_cast<std::size_t>(writer.bytesWritten() - responseStart), hasError, fromCache);
+            } catch (const std::exception& e) {
+                log.push_back({ MessageSeverity::Warning, e.what(), {} });
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(serveContextMutex());
+            denigmaContext.replayBufferedLog(log);
+        }
+        if (!output) {
+            return 1;
+        }
+    }
+}
+
+int serveConversionsOnSocket(const std::filesystem::path& socketPath, DenigmaContext& denigmaContext, ServeResultCache* resultCache,
+                             ServeMetrics* metrics, ServeScheduler* scheduler)
+{
+#ifdef _WIN32
+    (void)socketPath;
+    (void)denigmaContext;
+    (void)resultCache;
+    (void)metrics;
+    (void)scheduler;
+    throw std::runtime_error("--socket is not supported on this platform.");
+#else
+    const auto socketPathString = socketPath.native();
+    sockaddr_un address{};
+    if (socketPathString.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path is too long: " + utils::pathToString(socketPath));
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPathString.c_str(), socketPathString.size() + 1);
+
+    // a socket left behind by an earlier server would make bind fail; never remove anything else
+    std::error_code ec;
+    if (std::filesystem::is_socket(socketPath, ec)) {
+        std::filesystem::remove(socketPath, ec);
+    }
+
+    const int listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket < 0) {
+        throw std::system_error(errno, std::generic_category(), "Unable to create socket");
+    }
+    if (::bind(listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listenSocket, SOMAXCONN) != 0) {
+        const int error = errno;
+        ::close(listenSocket);
+        throw std::system_error(error, std::generic_category(), "Unable to listen on " + utils::pathToString(socketPath));
+    }
+    {
+        std::lock_guard<std::mutex> lock(serveContextMutex());
+        denigmaContext.logMessage(LogMsg() << "Listening on " << utils::asUtf8Bytes(socketPath));
+    }
+
+    struct Connection
+    {
+        std::shared_ptr<std::atomic<bool>> finished;
+        std::jthread thread;
+    };
+    std::vector<Connection> connections;
+    while (true) {
+        const int connectionSocket = ::accept(listenSocket, nullptr, nullptr);
+        if (connectionSocket < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        std::erase_if(connections, [](const Connection& connection) { return connection.finished->load(); });
+        auto finished = std::make_shared<std::atomic<bool>>(false);
+        connections.push_back(Connection{ finished, std::jthread([connectionSocket, finished, &denigmaContext, resultCache, metrics, scheduler]() {
+            MusxLoggerScope musxLogger(makeMusxLogCallback(denigmaContext));
+            SocketStreamBuf streamBuf(connectionSocket);
+            std::istream input(&streamBuf);
+            std::ostream output(&streamBuf);
+            if (metrics) {
+                metrics->connectionOpened();
+            }
+            serveConversions(input, output, denigmaContext, resultCache, metrics, scheduler);
+            if (metrics) {
+                metrics->connectionClosed();
+            }
+            ::close(connectionSocket);
+            finished->store(true);
+        }) });
+    }
+    const int error = errno;
+    ::close(listenSocket);
+    throw std::system_error(error, std::generic_category(), "Unable to accept connections on " + utils::pathToString(socketPath));
+#endif
+}
+
+int runServeCommand(DenigmaContext& denigmaContext, const std::vector<const arg_char*>& args)
+{
+    std::optional<std::filesystem::path> socketPath;
+    std::filesystem::path metricsFile;
+    std::optional<std::size_t> cacheBytes;
+    std::optional<std::size_t> cacheBudget;
+    ServeScheduler::Limits schedulerLimits;
+    auto readCount = [&](size_t& x, const std::string& option) -> std::size_t {
+        if (x + 1 >= args.size()) {
+            throw std::invalid_argument("Missing value for " + option);
+        }
+        const std::string value(arg_string(args[++x]));
+        try {
+            size_t parsed = 0;
+            const auto result = static_cast<std::size_t>(std::stoull(value, &parsed));
+            if (parsed != value.size()) {
+                throw std::invalid_argument(value);
+            }
+            return result;
+        } catch (const std::logic_error&) {
+            throw std::invalid_argument("Invalid value for " + option + ": " + value);
+        }
+    };
+    for (size_t x = 0; x < args.size(); x++) {
+        const arg_view arg(args[x]);
+        if (arg == _ARG("--socket")) {
+            if (x + 1 >= args.size()) {
+                throw std::invalid_argument("Missing value for --socket");
+            }
+            socketPath = std::filesystem::path(args[++x]);
+        } else if (arg == _ARG("--metrics-file")) {
+            if (x + 1 >= args.size()) {
+                throw std::invalid_argument("Missing value for --metrics-file");
+            }
+            metricsFile = std::filesystem::path(args[++x]);
+        } else if (arg == _ARG("--cache-bytes")) {
+            cacheBytes = readCount(x, "--cache-bytes");
+        } else if (arg == _ARG("--cache-budget")) {
+            cacheBudget = readCount(x, "--cache-budget");
+        } else if (arg == _ARG("--workers")) {
+            schedulerLimits.workers = static_cast<unsigned>(readCount(x, "--workers"));
+        } else if (arg == _ARG("--reserve-interactive")) {
+            schedulerLimits.reservedInteractive = static_cast<unsigned>(readCount(x, "--reserve-interactive"));
+        } else if (arg == _ARG("--bulk-cost-budget")) {
+            schedulerLimits.bulkCostBudget = readCount(x, "--bulk-cost-budget");
+        } else if (arg == _ARG("--interactive-cost")) {
+            schedulerLimits.interactiveCostLimit = readCount(x, "--interactive-cost");
+        } else {
+            throw std::invalid_argument("Unknown or misplaced option: " + std::string(arg_string(arg)));
+        }
+    }
+    if (denigmaContext.mnxSchemaPath.has_value() && !denigmaContext.mnxSchema.has_value()) {
+        denigmaContext.mnxSchema = readTextFile(denigmaContext.mnxSchemaPath.value());
+    }
+    // in a memory-limited container the defaults take a share of the limit rather than assume the host's memory
+    const auto memoryLimit = hostResources().memoryLimit;
+    if (!cacheBytes) {
+        cacheBytes = DEFAULT_RESULT_CACHE_BYTES;
+        if (memoryLimit) {
+            cacheBytes = static_cast<std::size_t>((std::min)(std::uint64_t(*cacheBytes), *memoryLimit / 8));
+        }
+    }
+    if (!cacheBudget && memoryLimit) {
+        cacheBudget = static_cast<std::size_t>(*memoryLimit / 4);
+    }
+    if (cacheBudget) {
+        setProcessCacheBudget(*cacheBudget);
+    }
+    ServeResultCache resultCache(*cacheBytes);
+    ServeScheduler scheduler(schedulerLimits);
+    ServeMetrics metrics(&resultCache, &scheduler, metricsFile);
+    if (socketPath) {
+        return serveConversionsOnSocket(socketPath.value(), denigmaContext, &resultCache, &metrics, &scheduler);
+    }
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    std::cin.tie(nullptr);
+    return serveConversions(std::cin, std::cout, denigmaContext, &resultCache, &metrics, &scheduler);
+}
+
+void showServeHelpPage(const std::string_view& programName, const std::string& indentSpaces)
+{
+    std::cout << indentSpaces << "Keeps one process running and converts each request it receives, so fonts, SMuFL metadata" << std::endl;
+    std::cout << indentSpaces << "and other caches are loaded once rather than once per file." << std::endl;
+    std::cout << indentSpaces << "Requests are read from stdin and responses are written to stdout unless --socket is given." << std::endl;
+    std::cout << indentSpaces << "Each frame is a 4-byte big-endian length followed by its payload. A request payload is" << std::endl;
+    std::cout << indentSpaces << "`key=value` header lines (target, source, name, arg), an empty line, and the input bytes." << std::endl;
+    std::cout << std::endl;
+    std::cout << indentSpaces << "Usage: " << programName << " serve [--socket path] [--options]" << std::endl;
+    std::cout << std::endl;
+    std::cout << indentSpaces << "Serve options:" << std::endl;
+    std::cout << indentSpaces << "  --socket path                   Listen on a Unix domain socket instead of stdin/stdout" << std::endl;
+    std::cout << indentSpaces << "  --metrics-file path             Keep Prometheus text-format metrics in this file, rewritten at most once a second" << std::endl;
+    std::cout << indentSpaces << "  --cache-bytes n                 Keep up to n bytes of recent responses for identical requests (default 256 MiB or an eighth of a container memory limit, 0 keeps none)" << std::endl;
+    std::cout << indentSpaces << "  --cache-budget n                Hold at most n bytes across all process-wide caches, dropping the least recently used (default a quarter of a container memory limit, else no limit)" << std::endl;
+    std::cout << indentSpaces << "  --workers n                     Run at most n conversions at once across all connections (default: all available cores)" << std::endl;
+    std::cout << indentSpaces << "  --reserve-interactive n         Keep n of those workers for interactive requests (default 1)" << std::endl;
+    std::cout << indentSpaces << "  --bulk-cost-budget n            Hold bulk requests back while those running have n estimated source bytes (default 0, no limit)" << std::endl;
+    std::cout << indentSpaces << "  --interactive-cost n            Treat requests without a priority header as interactive up to n estimated source bytes (default 1 MiB)" << std::endl;
+    std::cout << indentSpaces << "General and export options given here apply to every request." << std::endl;
+}
+
+} // namespace denigma
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <filesystem>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/denigma.h"
+#include "serve/metrics.h"
+#include "serve/result_cache.h"
+#include "serve/scheduler.h"
+
+namespace denigma {
+
+/**
+ * @brief Serves conversion requests read from input until it is exhausted, writing responses to output.
+ *
+ * Every message in either direction is a frame: a 4-byte big-endian payload length followed by the payload.
+ *
+ * A request payload is a block of UTF-8 `key=value` lines ending with an empty line, followed by the input bytes.
+ *  - `target=<list>`: required comma-separated targets: `mnx`, `musicxml`, `mss` or `svg`. The lone target
+ *    `metrics` instead asks for the server's metrics, in one `O` frame in the Prometheus text format; such a
+ *    request has no source or input.
+ *  - `source=<format>`: `musx` or `enigmaxml`. May be omitted when `name` has one of those extensions.
+ *  - `name=<file name>`: source name used for diagnostics and metadata.
+ *  - `priority=<class>`: `interactive` or `bulk` (see ServeScheduler). Without it, the scheduler classes the request
+ *    by its estimated cost.
+ *  - `arg=<token>`: one command-line token, such as `--all-parts` or `--shape-def` followed by another
+ *    `arg=` line with its value. Options are applied on top of those given to `serve`.
+ *
+ * Each request is answered with zero or more output and diagnostic frames, then one result frame.
+ * The first payload byte gives the frame type:
+ *  - `O`: an output document: target name and suggested name, each as a 4-byte big-endian length and
+ *    UTF-8 text, then the document bytes.
+ *  - `D`: a diagnostic: one severity byte (`I`, `W`, `E` or `V`) followed by the message text.
+ *  - `R`: the end of the response: one status byte, 0 on success or 1 if any error was reported.
+ *
+ * Output frames are written as each document is produced.
+ *
+ * With a resultCache, a request identical to one answered before (same input bytes, headers and option tokens) is
+ * answered with the same frames without converting, and one identical to a request still being converted waits for
+ * its frames.
+ *
+ * With metrics, every request and conversion is counted there (see ServeMetrics). With a scheduler, each conversion
+ * waits for it to admit the request; a bulk request's frames are then written only once it has finished.
+ *
+ * @return 0 when input ended cleanly, or 1 if it ended inside a frame.
+ */
+int serveConversions(std::istream& input, std::ostream& output, DenigmaContext& denigmaContext,
+                     ServeResultCache* resultCache = nullptr, ServeMetrics* metrics = nullptr,
+                     ServeScheduler* scheduler = nullptr);
+
+/// @brief Accepts connections on a Unix domain socket and serves each one with #serveConversions on its own thread.
+/// Every connection shares resultCache, metrics and scheduler.
+/// @throws std::runtime_error if the socket cannot be created, or on platforms without Unix domain sockets.
+int serveConversionsOnSocket(const std::filesystem::path& socketPath, DenigmaContext& denigmaContext,
+                             ServeResultCache* resultCache = nullptr, ServeMetrics* metrics = nullptr,
+                             ServeScheduler* scheduler = nullptr);
+
+/// @brief Runs the `serve` command with the arguments that follow it on the command line.
+int runServeCommand(DenigmaContext& denigmaContext, const std::vector<const arg_char*>& args);
+
+/// @brief Shows help for the `serve` command.
+void showServeHelpPage(const std::string_view& programName, const std::string& indentSpaces = {});
+
+} // namespace denigma
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <utility>
+
+#include "utils/cache_budget.h"
+
+#include "denigma/process_caches.h"
+
+namespace utils {
+
+CacheBudget::Account::Account(std::string name, OldestUse oldestUse, EvictOldest evictOldest)
+    : m_name(std::move(name)), m_oldestUse(std::move(oldestUse)), m_evictOldest(std::move(evictOldest))
+{
+    auto& budget = CacheBudget::instance();
+    std::lock_guard<std::mutex> lock(budget.m_registryMutex);
+    budget.m_accounts.push_back(this);
+}
+
+CacheBudget::Account::~Account()
+{
+    auto& budget = CacheBudget::instance();
+    std::lock_guard<std::mutex> lock(budget.m_registryMutex);
+    budget.m_accounts.erase(std::remove(budget.m_accounts.begin(), budget.m_accounts.end(), this), budget.m_accounts.end());
+    budget.m_used.fetch_sub(m_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void CacheBudget::Account::charge(std::size_t bytes)
+{
+    m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    CacheBudget::instance().m_used.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void CacheBudget::Account::credit(std::size_t bytes)
+{
+    m_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    CacheBudget::instance().m_used.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+CacheBudget& CacheBudget::instance()
+{
+    static CacheBudget budget;
+    return budget;
+}
+
+std::uint64_t CacheBudget::tick()
+{
+    static std::atomic<std::uint64_t> counter{};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void CacheBudget::setLimit(std::size_t bytes)
+{
+    m_limit.store(bytes, std::memory_order_relaxed);
+    enforce();
+}
+
+void CacheBudget::enforce()
+{
+    auto overLimit = [this]() {
+        const std::size_t limitBytes = limit();
+        return limitBytes > 0 && used() > limitBytes;
+    };
+    if (!overLimit()) {
+        return;
+    }
+    std::unique_lock<std::mutex> enforcing(m_enforceMutex, std::try_to_lock);
+    if (!enforcing.owns_lock()) {
+        return; // the thread already evicting will see this cache's charge too
+    }
+    std::lock_guard<std::mutex> lock(m_registryMutex);
+    while (overLimit()) {
+        Account* oldestAccount = nullptr;
+        std::uint64_t oldestUse = 0;
+        for (Account* account : m_accounts) {
+            if (const auto use = account->m_oldestUse(); use && (!oldestAccount || *use < oldestUse)) {
+                oldestAccount = account;
+                oldestUse = *use;
+            }
+        }
+        if (!oldestAccount) {
+            return; // everything left is in use or being loaded
+        }
+        oldestAccount->credit(oldestAccount->m_evictOldest());
+        oldestAccount->m_evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::vector<CacheBudget::Usage> CacheBudget::usage() const
+{
+    std::lock_guard<std::mutex> lock(m_registryMutex);
+    std::vector<Usage> result;
+    result.reserve(m_accounts.size());
+    for (const Account* account : m_accounts) {
+        result.push_back({ account->m_name, account->bytes(), account->m_evictions.load(std::memory_order_relaxed) });
+    }
+    return result;
+}
+
+} // namespace utils
+
+namespace denigma {
+
+void setProcessCacheBudget(std::size_t bytes)
+{
+    utils::CacheBudget::instance().setLimit(bytes);
+}
+
+std::size_t processCacheBudget()
+{
+    return utils::CacheBudget::instance().limit();
+}
+
+std::vector<ProcessCacheUsage> processCacheUsage()
+{
+    std::vector<ProcessCacheUsage> result;
+    for (auto& usage : utils::CacheBudget::instance().usage()) {
+        result.push_back({ std::move(usage.name), usage.bytes, usage.evictions });
+    }
+    return result;
+}
+
+} // namespace denigma
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+/// @class CacheBudget
+/// @brief One memory budget shared by the caches that live as long as the process.
+///
+/// Each such cache opens an Account, charges it for what it keeps and stamps every entry with tick() when the entry
+/// is used. When the charged total exceeds the limit, enforce() evicts the least recently used entry across all
+/// accounts, one at a time, until the total is back under the limit. A limit of 0 means no limit.
+///
+/// The account callbacks are called with the budget's registry lock held and take the cache's own lock, so a
+/// cache must not call enforce(), open or close an account while holding its own lock.
+class CacheBudget
+{
+public:
+    /// @brief The memory one account holds.
+    struct Usage
+    {
+        std::string name;
+        std::size_t bytes{};
+        std::uint64_t evictions{};
+    };
+
+    /// @class Account
+    /// @brief One cache's share of the budget. Registered for its lifetime.
+    class Account
+    {
+    public:
+        /// Returns the tick of the cache's least recently used evictable entry, or std::nullopt if there is none.
+        using OldestUse = std::function<std::optional<std::uint64_t>()>;
+        /// Drops the cache's least recently used evictable entry and returns the bytes it was charged.
+        using EvictOldest = std::function<std::size_t()>;
+
+        Account(std::string name, OldestUse oldestUse, EvictOldest evictOldest);
+        ~Account();
+
+        Account(const Account&) = delete;
+        Account& operator=(const Account&) = delete;
+
+        void charge(std::size_t bytes);
+        void credit(std::size_t bytes);
+
+        std::size_t bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+
+    private:
+        friend class CacheBudget;
+
+        std::string m_name;
+        OldestUse m_oldestUse;
+        EvictOldest m_evictOldest;
+        std::atomic<std::size_t> m_bytes{};
+        std::atomic<std::uint64_t> m_evictions{};
+    };
+
+    static CacheBudget& instance();
+
+    /// Returns a value that increases with every call, for stamping entry use.
+    static std::uint64_t tick();
+
+    void setLimit(std::size_t bytes);
+    std::size_t limit() const { return m_limit.load(std::memory_order_relaxed); }
+    std::size_t used() const { return m_used.load(std::memory_order_relaxed); }
+
+    /// Evicts least recently used entries until the total is within the limit. Returns at once if another thread
+    /// is already evicting.
+    void enforce();
+
+    std::vector<Usage> usage() const;
+
+private:
+    CacheBudget() = default;
+
+    mutable std::mutex m_registryMutex;
+    std::mutex m_enforceMutex;
+    std::vector<Account*> m_accounts;
+    std::atomic<std::size_t> m_limit{};
+    std::atomic<std::size_t> m_used{};
+};
+
+} // namespace utils
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+namespace utils {
+
+/**
+ * @class ConstexprStringMap
+ * @brief A read-only map from string keys, built at compile time and searched by hash.
+ *
+ * Meant for fixed lookup tables (such as SMuFL glyph names) declared `constexpr`, so that they are built by the
+ * compiler: a lookup needs no static-initialization guard and no heap allocation. Entries are ordered by the 64-bit
+ * FNV-1a hash of their keys, so a lookup hashes the key once, binary-searches the hashes and compares one key.
+ * Create one with makeConstexprStringMap, which rejects duplicate keys (and hash collisions) at compile time.
+ */
+template <typename Value, std::size_t N>
+class ConstexprStringMap
+{
+public:
+    using value_type = std::pair<std::string_view, Value>;
+
+    consteval explicit ConstexprStringMap(const value_type (&entries)[N])
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            m_hashes[i] = hash(entries[i].first);
+            m_entries[i] = entries[i];
+        }
+        // heapsort on the integer hashes keeps constant evaluation well inside compilers' step limits
+        for (std::size_t i = N / 2; i > 0; --i) {
+            siftDown(i - 1, N);
+        }
+        for (std::size_t end = N; end > 1; --end) {
+            swapEntries(0, end - 1);
+            siftDown(0, end - 1);
+        }
+        for (std::size_t i = 1; i < N; ++i) {
+            if (m_hashes[i - 1] == m_hashes[i]) {
+                throw "ConstexprStringMap has a duplicate key"; // not a constant expression, so compilation fails
+            }
+        }
+    }
+
+    /// Returns the value for key, or nullptr if there is none.
+    constexpr const Value* find(std::string_view key) const
+    {
+        const std::uint64_t keyHash = hash(key);
+        std::size_t low = 0;
+        std::size_t high = N;
+        while (low < high) {
+            const std::size_t middle = low + (high - low) / 2;
+            if (m_hashes[middle] < keyHash) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low < N && m_hashes[low] == keyHash && m_entries[low].first == key ? &m_entries[low].second : nullptr;
+    }
+
+    constexpr bool contains(std::string_view key) const { return find(key) != nullptr; }
+    constexpr std::size_t size() const { return N; }
+
+    /// Entries in hash order, which is unrelated to key order.
+    constexpr const value_type* begin() const { return m_entries.data(); }
+    constexpr const value_type* end() const { return m_entries.data() + N; }
+
+private:
+    static constexpr std::uint64_t hash(std::string_view key)
+    {
+        std::uint64_t result = 14695981039346656037ull;
+        for (const char c : key) {
+            result = (result ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return result;
+    }
+
+    constexpr void swapEntries(std::size_t a, std::size_t b)
+    {
+        const std::uint64_t hashA = m_hashes[a];
+        m_hashes[a] = m_hashes[b];
+        m_hashes[b] = hashA;
+        const value_type entryA = m_entries[a];
+        m_entries[a] = m_entries[b];
+        m_entries[b] = entryA;
+    }
+
+    constexpr void siftDown(std::size_t root, std::size_t count)
+    {
+        while (true) {
+            std::size_t largest = root;
+            const std::size_t left = 2 * root + 1;
+            const std::size_t right = left + 1;
+            if (left < count && m_hashes[left] > m_hashes[largest]) {
+                largest = left;
+            }
+            if (right < count && m_hashes[right] > m_hashes[largest]) {
+                largest = right;
+            }
+            if (largest == root) {
+                return;
+            }
+            swapEntries(root, largest);
+            root = largest;
+        }
+    }
+
+    std::array<std::uint64_t, N> m_hashes{};
+    std::array<value_type, N> m_entries{};
+};
+
+/// Builds a ConstexprStringMap from a braced list of { key, value } pairs, in any order.
+template <typename Value, std::size_t N>
+consteval ConstexprStringMap<Value, N> makeConstexprStringMap(const std::pair<std::string_view, Value> (&entries)[N])
+{
+    return ConstexprStringMap<Value, N>(entries);
+}
+
+} // namespace utils
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @class DenseIndexSet
+ * @brief A set of small non-negative integers stored as a growable bitset.
+ *
+ * Meant for ids that are dense within a document, such as entry numbers. insert() and contains() are a shift
+ * and a mask; the storage grows to the largest index inserted and is never shrunk, so clear() only zeroes it and
+ * a set reused across parts stops allocating once it has seen the largest id.
+ */
+template <typename Index, typename Allocator = std::allocator<std::uint64_t>>
+class DenseIndexSet
+{
+    static_assert(std::is_integral_v<Index>, "DenseIndexSet requires an integral index type");
+
+public:
+    using allocator_type = Allocator;
+
+    DenseIndexSet() = default;
+    explicit DenseIndexSet(const Allocator& allocator) : m_words(allocator) {}
+
+    /// Adds index and returns true if it was not already present, like the second member of std::set::insert.
+    bool insert(Index index)
+    {
+        const std::size_t position = checkedPosition(index);
+        const std::size_t word = position / BITS_PER_WORD;
+        if (word >= m_words.size()) {
+            m_words.resize((std::max)(word + 1, m_words.size() * 2), 0);
+        }
+        const std::uint64_t mask = std::uint64_t(1) << (position % BITS_PER_WORD);
+        if (m_words[word] & mask) {
+            return false;
+        }
+        m_words[word] |= mask;
+        return true;
+    }
+
+    bool contains(Index index) const
+    {
+        if (isNegative(index)) {
+            return false;
+        }
+        const std::size_t position = static_cast<std::size_t>(index);
+        const std::size_t word = position / BITS_PER_WORD;
+        return word < m_words.size() && (m_words[word] & (std::uint64_t(1) << (position % BITS_PER_WORD))) != 0;
+    }
+
+    /// Grows the storage so that indices up to maxIndex can be inserted without allocating.
+    void reserve(Index maxIndex)
+    {
+        const std::size_t words = checkedPosition(maxIndex) / BITS_PER_WORD + 1;
+        if (words > m_words.size()) {
+            m_words.resize(words, 0);
+        }
+    }
+
+    void clear() { std::fill(m_words.begin(), m_words.end(), 0); }
+
+private:
+    static constexpr std::size_t BITS_PER_WORD = 64;
+
+    static constexpr bool isNegative(Index index)
+    {
+        if constexpr (std::is_signed_v<Index>) {
+            return index < 0;
+        } else {
+            return false;
+        }
+    }
+
+    static std::size_t checkedPosition(Index index)
+    {
+        if (isNegative(index)) {
+            throw std::out_of_range("DenseIndexSet indices must not be negative.");
+        }
+        return static_cast<std::size_t>(index);
+    }
+
+    std::vector<std::uint64_t, Allocator> m_words;
+};
+
+} // namespace utils
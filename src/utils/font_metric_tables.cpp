@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "font_metric_tables.h"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+#include "utils/font_names.h"
+
+namespace utils {
+
+const FontMetricGlyph* FontMetricTable::findGlyph(char32_t codePoint) const
+{
+    const auto it = std::lower_bound(glyphs.begin(), glyphs.end(), codePoint,
+        [](const FontMetricGlyph& glyph, char32_t value) { return glyph.codePoint < value; });
+    return (it != glyphs.end() && it->codePoint == codePoint) ? &*it : nullptr;
+}
+
+std::int32_t FontMetricTable::findKerning(char32_t left, char32_t right) const
+{
+    const auto it = std::lower_bound(kerning.begin(), kerning.end(), std::make_pair(left, right),
+        [](const FontMetricKerning& pair, const std::pair<char32_t, char32_t>& value) {
+            return std::tie(pair.left, pair.right) < std::tie(value.first, value.second);
+        });
+    return (it != kerning.end() && it->left == left && it->right == right) ? it->value : 0;
+}
+
+const FontMetricTable* findFontMetricTable(std::span<const FontMetricTable> tables, std::string_view fontName, bool bold, bool italic)
+{
+    if (tables.empty()) {
+        return nullptr;
+    }
+    const std::string normalized = normalizedFontName(fontName);
+    for (const auto& table : tables) {
+        if (table.normalizedFamily == normalized && table.bold == bold && table.italic == italic) {
+            return &table;
+        }
+    }
+    return nullptr;
+}
+
+std::optional<FontMetricsPoints> measureTextWithTable(const FontMetricTable& table, std::u32string_view text, double pointSize)
+{
+    if (table.unitsPerEm <= 0) {
+        return std::nullopt;
+    }
+    const double scale = (pointSize > 0.0 ? pointSize : 12.0) / static_cast<double>(table.unitsPerEm);
+
+    double penX = 0.0;
+    bool hasBounds = false;
+    double maxY = 0.0;
+    double minY = 0.0;
+    char32_t previous = 0;
+    for (const char32_t codePoint : text) {
+        if (codePoint == U'\n' || codePoint == U'\r') {
+            previous = 0;
+            continue;
+        }
+        const FontMetricGlyph* glyph = table.findGlyph(codePoint);
+        if (!glyph) {
+            return std::nullopt;
+        }
+        if (previous) {
+            penX += table.findKerning(previous, codePoint) * scale;
+        }
+        if (glyph->xMax > glyph->xMin || glyph->yMax > glyph->yMin) {
+            const double glyphMaxY = glyph->yMax * scale;
+            const double glyphMinY = glyph->yMin * scale;
+            maxY = hasBounds ? (std::max)(maxY, glyphMaxY) : glyphMaxY;
+            minY = hasBounds ? (std::min)(minY, glyphMinY) : glyphMinY;
+            hasBounds = true;
+        }
+        penX += glyph->advance * scale;
+        previous = codePoint;
+    }
+
+    FontMetricsPoints result;
+    result.advance = (std::max)(0.0, penX);
+    if (hasBounds) {
+        result.ascent = (std::max)(0.0, maxY);
+        result.descent = (std::max)(0.0, -minY);
+    }
+    return result;
+}
+
+} // namespace utils
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace utils {
+
+/// One glyph of a FontMetricTable, in font units. The box is the glyph's ink extent, as FreeType reports it unhinted.
+struct FontMetricGlyph
+{
+    char32_t codePoint{};
+    std::int32_t advance{};
+    std::int32_t xMin{};
+    std::int32_t yMin{};
+    std::int32_t xMax{};
+    std::int32_t yMax{};
+};
+
+/// One kerning pair of a FontMetricTable, from the font's legacy `kern` table (the only one FT_Get_Kerning reads).
+struct FontMetricKerning
+{
+    char32_t left{};
+    char32_t right{};
+    std::int32_t value{};
+};
+
+/// @brief Compiled-in metrics of one face of a font, generated offline by scripts/generate_font_metric_tables.py.
+///
+/// Text measured from a table needs no font file, so the fonts most scores use measure the same with or without
+/// the fonts installed, and in builds with no font backend at all.
+struct FontMetricTable
+{
+    std::string_view normalizedFamily;  ///< the family name as utils::normalizedFontName returns it
+    bool bold{};
+    bool italic{};
+    std::int32_t unitsPerEm{};
+    std::int32_t ascender{};    ///< hhea ascender, as FreeType's face->ascender
+    std::int32_t descender{};   ///< hhea descender (negative below the baseline)
+    std::span<const FontMetricGlyph> glyphs;        ///< sorted by code point
+    std::span<const FontMetricKerning> kerning;     ///< sorted by left, then right
+
+    /// Returns the glyph mapped to codePoint, or nullptr if the face has none.
+    [[nodiscard]] const FontMetricGlyph* findGlyph(char32_t codePoint) const;
+    /// Returns the kerning between left and right, or 0.
+    [[nodiscard]] std::int32_t findKerning(char32_t left, char32_t right) const;
+};
+
+/// Advance and ink extent above and below the baseline, in points.
+struct FontMetricsPoints
+{
+    double advance{};
+    double ascent{};
+    double descent{};
+};
+
+/// The tables compiled into this build.
+std::span<const FontMetricTable> builtInFontMetricTables();
+
+/// Returns the table among tables for fontName in the given style, or nullptr. Names are compared normalized.
+const FontMetricTable* findFontMetricTable(std::span<const FontMetricTable> tables, std::string_view fontName, bool bold, bool italic);
+
+/// Returns the built-in table for fontName in the given style, or nullptr.
+inline const FontMetricTable* findFontMetricTable(std::string_view fontName, bool bold, bool italic)
+{
+    return findFontMetricTable(builtInFontMetricTables(), fontName, bold, italic);
+}
+
+/// @brief Measures text set at pointSize in the face of table, the way the FreeType backend measures it unhinted.
+///
+/// The advance includes kerning; ascent and descent are the union of the glyphs' ink boxes. Line breaks reset
+/// kerning and add nothing.
+/// @return nullopt if the table lacks a glyph of text, so that the caller can measure the real font instead.
+std::optional<FontMetricsPoints> measureTextWithTable(const FontMetricTable& table, std::u32string_view text, double pointSize);
+
+} // namespace utils
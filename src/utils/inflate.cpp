@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "utils/inflate.h"
+
+#ifdef DENIGMA_INFLATE_LIBDEFLATE
+#include "libdeflate.h"
+#endif
+
+namespace utils {
+
+#ifdef DENIGMA_INFLATE_LIBDEFLATE
+
+namespace {
+
+/// libdeflate decompressors are not thread-safe, but are cheap to keep one per thread.
+struct DecompressorHandle
+{
+    libdeflate_decompressor* decompressor{ libdeflate_alloc_decompressor() };
+    ~DecompressorHandle() { libdeflate_free_decompressor(decompressor); }
+};
+
+} // namespace
+
+std::string_view inflateBackendName()
+{
+    return "libdeflate";
+}
+
+bool hasAcceleratedInflate()
+{
+    return true;
+}
+
+bool inflateKnownSize(std::span<const char> input, DeflateFormat format, std::span<char> output)
+{
+    thread_local DecompressorHandle handle;
+    if (!handle.decompressor) {
+        return false;
+    }
+    std::size_t produced = 0;
+    const libdeflate_result result = format == DeflateFormat::Gzip
+        ? libdeflate_gzip_decompress(handle.decompressor, input.data(), input.size(), output.data(), output.size(), &produced)
+        : libdeflate_deflate_decompress(handle.decompressor, input.data(), input.size(), output.data(), output.size(), &produced);
+    return result == LIBDEFLATE_SUCCESS && produced == output.size();
+}
+
+#else // zlib: the streaming readers already use it, so there is nothing to accelerate
+
+std::string_view inflateBackendName()
+{
+    return "zlib";
+}
+
+bool hasAcceleratedInflate()
+{
+    return false;
+}
+
+bool inflateKnownSize(std::span<const char>, DeflateFormat, std::span<char>)
+{
+    return false;
+}
+
+#endif
+
+} // namespace utils
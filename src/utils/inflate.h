@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <span>
+#include <string_view>
+
+namespace utils {
+
+/// @brief The framing around a deflate stream.
+enum class DeflateFormat
+{
+    Raw,    ///< bare deflate data, as stored in zip entries
+    Gzip    ///< a single gzip member, as in musx score.dat
+};
+
+/// Name of the whole-buffer inflate backend selected with the DENIGMA_INFLATE_BACKEND CMake option.
+std::string_view inflateBackendName();
+
+/// True if the selected backend decompresses known-size buffers faster than streaming zlib. When it is false,
+/// #inflateKnownSize always returns false and callers should not prepare input for it.
+bool hasAcceleratedInflate();
+
+/**
+ * @brief Inflates a complete deflate stream whose inflated size is known up front.
+ * @param input [in] the whole compressed stream.
+ * @param format [in] the framing of input.
+ * @param output [out] a buffer of exactly the expected inflated size (from a zip directory or a gzip trailer).
+ * @return true if input inflated to exactly output.size() bytes. False if no accelerated backend is selected, or if
+ * the stream is invalid or has a different size; callers then fall back to streaming zlib.
+ */
+bool inflateKnownSize(std::span<const char> input, DeflateFormat format, std::span<char> output);
+
+} // namespace utils
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "utils/output_archive.h"
+
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+#include "utils/stringutils.h"
+#include "utils/ziputils.h"
+
+namespace utils {
+
+namespace {
+
+/// Bytes a stored entry adds besides its contents and two copies of its name: the local header and the central
+/// directory record, with room for zip64 extra fields.
+constexpr std::uint64_t ENTRY_OVERHEAD_BYTES = 128;
+
+std::filesystem::path shardPath(const std::filesystem::path& archivePath, std::size_t shard)
+{
+    if (shard == 0) {
+        return archivePath;
+    }
+    std::filesystem::path result = archivePath;
+    result.replace_filename(std::filesystem::path(archivePath.stem().u8string() + u8"." + utils::stringToUtf8(std::to_string(shard))
+        + archivePath.extension().u8string()));
+    return result;
+}
+
+} // namespace
+
+struct ZipOutputArchive::Impl
+{
+    std::filesystem::path archivePath;
+    std::filesystem::path baseDirectory;
+    std::uint64_t shardBytes{};
+
+    mutable std::mutex mutex;
+    std::optional<ZipStreamWriter> zip;
+    std::ofstream index;
+    std::unordered_set<std::string> reservedNames;
+    std::size_t shard{};
+    std::uint64_t bytesInShard{};
+    std::size_t entriesInShard{};
+    std::size_t entryCount{};
+    bool finished{};
+};
+
+ZipOutputArchive::ZipOutputArchive(const std::filesystem::path& archivePath, const std::filesystem::path& baseDirectory, std::uint64_t shardBytes)
+    : m_impl(std::make_unique<Impl>())
+{
+    m_impl->archivePath = archivePath;
+    m_impl->baseDirectory = baseDirectory.lexically_normal();
+    m_impl->shardBytes = shardBytes;
+    m_impl->zip.emplace(archivePath);
+    auto indexPath = archivePath;
+    indexPath += u8".index.tsv";
+    m_impl->index.exceptions(std::ios::failbit | std::ios::badbit);
+    m_impl->index.open(indexPath, std::ios::out | std::ios::binary | std::ios::trunc);
+}
+
+ZipOutputArchive::~ZipOutputArchive()
+{
+    try {
+        finish();
+    } catch (...) {
+    }
+}
+
+std::string ZipOutputArchive::entryName(const std::filesystem::path& outputPath) const
+{
+    std::filesystem::path relative = outputPath.lexically_normal().lexically_relative(m_impl->baseDirectory);
+    if (relative.empty() || *relative.begin() == "..") {
+        relative = outputPath.lexically_normal().relative_path();
+    }
+    return utils::utf8ToString(relative.generic_u8string());
+}
+
+bool ZipOutputArchive::reserve(const std::filesystem::path& outputPath)
+{
+    std::string name = entryName(outputPath);
+    std::lock_guard lock(m_impl->mutex);
+    return m_impl->reservedNames.insert(std::move(name)).second;
+}
+
+void ZipOutputArchive::add(const std::filesystem::path& outputPath, std::span<const char> contents)
+{
+    const std::string name = entryName(outputPath);
+    const std::uint64_t entryBytes = contents.size() + 2 * name.size() + ENTRY_OVERHEAD_BYTES;
+
+    std::lock_guard lock(m_impl->mutex);
+    Impl& impl = *m_impl;
+    if (impl.finished) {
+        throw std::logic_error("entry added to an output archive after it was finished");
+    }
+    if (impl.shardBytes > 0 && impl.entriesInShard > 0 && impl.bytesInShard + entryBytes > impl.shardBytes) {
+        impl.zip->close();
+        impl.zip.reset();
+        impl.zip.emplace(shardPath(impl.archivePath, ++impl.shard));
+        impl.bytesInShard = 0;
+        impl.entriesInShard = 0;
+    }
+    impl.zip->writeEntry(name, contents, 0);
+    impl.bytesInShard += entryBytes;
+    ++impl.entriesInShard;
+    ++impl.entryCount;
+    const auto shardName = utils::utf8ToString(shardPath(impl.archivePath, impl.shard).filename().u8string());
+    impl.index << name << '\t' << shardName << '\t' << contents.size() << '\n';
+}
+
+void ZipOutputArchive::finish()
+{
+    std::lock_guard lock(m_impl->mutex);
+    if (std::exchange(m_impl->finished, true)) {
+        return;
+    }
+    m_impl->zip->close();
+    m_impl->index.close();
+}
+
+std::size_t ZipOutputArchive::entryCount() const
+{
+    std::lock_guard lock(m_impl->mutex);
+    return m_impl->entryCount;
+}
+
+std::size_t ZipOutputArchive::shardCount() const
+{
+    std::lock_guard lock(m_impl->mutex);
+    return m_impl->shard + 1;
+}
+
+} // namespace utils
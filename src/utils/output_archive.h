@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "core/output_file.h"
+
+namespace utils {
+
+/**
+ * @class ZipOutputArchive
+ * @brief OutputArchive that stores each entry uncompressed in a zip archive, sharded by size if asked.
+ *
+ * An entry is named by its output path relative to baseDirectory, with '/' separators; a path outside baseDirectory
+ * is named by the path without its root. Entries are stored rather than deflated so that the lock serializing the
+ * concurrent jobs is held only for the copy. The formats that compress (mxl, musx) are already compressed.
+ *
+ * With shardBytes set, a shard that would grow past it is closed before the next entry. A shard holds at least one
+ * entry, so a larger document still gets written. Shards after the first are named like the archive with the shard
+ * number before the extension (batch.zip, batch.1.zip, batch.2.zip, ...). An index beside the first shard,
+ * `<archive>.index.tsv`, gets one tab-separated line per entry as it is added: entry name, shard file name, size.
+ */
+class ZipOutputArchive final : public denigma::OutputArchive
+{
+public:
+    /// Creates (or replaces) archivePath and its index. Throws if either cannot be created.
+    ZipOutputArchive(const std::filesystem::path& archivePath, const std::filesystem::path& baseDirectory, std::uint64_t shardBytes = 0);
+    /// Finishes the archive if #finish was not called, discarding any error.
+    ~ZipOutputArchive() override;
+
+    ZipOutputArchive(const ZipOutputArchive&) = delete;
+    ZipOutputArchive& operator=(const ZipOutputArchive&) = delete;
+
+    bool reserve(const std::filesystem::path& outputPath) override;
+    void add(const std::filesystem::path& outputPath, std::span<const char> contents) override;
+
+    /// Closes the current shard and the index. Throws if that fails. Safe to call more than once.
+    void finish();
+
+    /// The entry name that stands for outputPath.
+    [[nodiscard]] std::string entryName(const std::filesystem::path& outputPath) const;
+    /// The number of entries added so far.
+    [[nodiscard]] std::size_t entryCount() const;
+    /// The number of shards created so far.
+    [[nodiscard]] std::size_t shardCount() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace utils
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "smufl_metadata_tables.h"
+
+#include <algorithm>
+#include <string>
+
+#include "utils/font_names.h"
+
+namespace utils {
+
+const SmuflMetadataGlyph* SmuflMetadataTable::findGlyph(std::string_view name) const
+{
+    const auto it = std::lower_bound(glyphs.begin(), glyphs.end(), name,
+        [](const SmuflMetadataGlyph& glyph, std::string_view value) { return glyph.name < value; });
+    return (it != glyphs.end() && it->name == name) ? &*it : nullptr;
+}
+
+std::string_view SmuflMetadataTable::findOptionalGlyphName(char32_t codePoint) const
+{
+    const auto it = std::lower_bound(optionalGlyphs.begin(), optionalGlyphs.end(), codePoint,
+        [](const SmuflMetadataOptionalGlyph& glyph, char32_t value) { return glyph.codePoint < value; });
+    return (it != optionalGlyphs.end() && it->codePoint == codePoint) ? it->name : std::string_view{};
+}
+
+const SmuflMetadataTable* findSmuflMetadataTable(std::span<const SmuflMetadataTable> tables, std::string_view fontName)
+{
+    if (tables.empty()) {
+        return nullptr;
+    }
+    const std::string normalized = normalizedFontName(fontName);
+    for (const auto& table : tables) {
+        if (table.normalizedFamily == normalized) {
+            return &table;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace utils
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <array>
+#include <span>
+#include <string_view>
+
+namespace utils {
+
+/// One named glyph of a SmuflMetadataTable, in staff spaces as the font's metadata JSON gives them.
+struct SmuflMetadataGlyph
+{
+    std::string_view name;
+    bool hasAdvance{};
+    double advance{};                   ///< glyphAdvanceWidths entry, if hasAdvance
+    bool hasBBox{};
+    std::array<double, 4> bbox{};       ///< glyphBBoxes entry as { bBoxSW x, bBoxSW y, bBoxNE x, bBoxNE y }, if hasBBox
+};
+
+/// One entry of the font's optionalGlyphs: a private-use code point and its glyph name.
+struct SmuflMetadataOptionalGlyph
+{
+    char32_t codePoint{};
+    std::string_view name;
+};
+
+/// @brief Compiled-in SMuFL metadata of one font, generated offline by scripts/generate_smufl_metadata_tables.py.
+///
+/// Glyph names and metrics looked up from a table need neither the metadata file nor a JSON parse, so the fonts
+/// most scores use resolve the same with or without the fonts installed.
+struct SmuflMetadataTable
+{
+    std::string_view normalizedFamily;  ///< the font name as utils::normalizedFontName returns it
+    std::span<const SmuflMetadataGlyph> glyphs;                 ///< sorted by name
+    std::span<const SmuflMetadataOptionalGlyph> optionalGlyphs; ///< sorted by code point
+
+    /// Returns the glyph named name, or nullptr if the metadata has neither an advance nor a box for it.
+    [[nodiscard]] const SmuflMetadataGlyph* findGlyph(std::string_view name) const;
+    /// Returns the name of the optional glyph at codePoint, or an empty view.
+    [[nodiscard]] std::string_view findOptionalGlyphName(char32_t codePoint) const;
+};
+
+/// The tables compiled into this build.
+std::span<const SmuflMetadataTable> builtInSmuflMetadataTables();
+
+/// Returns the table among tables for fontName, or nullptr. Names are compared normalized.
+const SmuflMetadataTable* findSmuflMetadataTable(std::span<const SmuflMetadataTable> tables, std::string_view fontName);
+
+/// Returns the built-in table for fontName, or nullptr.
+inline const SmuflMetadataTable* findSmuflMetadataTable(std::string_view fontName)
+{
+    return findSmuflMetadataTable(builtInSmuflMetadataTables(), fontName);
+}
+
+} // namespace utils
@@ -20,12 +20,20 @@
  * THE SOFTWARE.
  */
 #include <istream>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
+#include <system_error>
 #include <unordered_map>
+#include <vector>
 
 #include "smufl_support.h"
 
@@ -33,6 +41,8 @@
 
 #include "musx/musx.h"
 #include "smufl_mapping.h"
+#include "utils/cache_budget.h"
+#include "utils/smufl_metadata_tables.h"
 #include "utils/stringutils.h"
 #include "utils/utf8_iterator.h"
 
@@ -102,34 +112,380 @@ static SmuflFontMetadata parseSmuflMetadata(std::istream& jsonFile)
     return metadata;
 }
 
-static const SmuflFontMetadata* metadataForFont(const std::filesystem::path& fontMetadataPath)
+/// Estimates the heap a parsed metadata set holds, for the process cache budget.
+static std::size_t estimateMetadataBytes(const SmuflFontMetadata& metadata)
 {
-    static std::unordered_map<std::u8string, SmuflFontMetadata> metadataCache;
-    const auto cacheKey = fontMetadataPath.u8string();
-    auto it = metadataCache.find(cacheKey);
-    if (it != metadataCache.end()) {
-        return &it->second;
+    constexpr std::size_t NODE_OVERHEAD = 4 * sizeof(void*); // hash node links, cached hash and bucket slot
+    std::size_t bytes = sizeof(SmuflFontMetadata);
+    for (const auto& [codepoint, glyphName] : metadata.optionalGlyphNames) {
+        bytes += NODE_OVERHEAD + sizeof(codepoint) + sizeof(glyphName) + glyphName.capacity();
     }
+    for (const auto& [glyphName, advance] : metadata.glyphAdvanceWidths) {
+        bytes += NODE_OVERHEAD + sizeof(glyphName) + glyphName.capacity() + sizeof(advance);
+    }
+    for (const auto& [glyphName, bbox] : metadata.glyphBBoxes) {
+        bytes += NODE_OVERHEAD + sizeof(glyphName) + glyphName.capacity() + sizeof(bbox);
+    }
+    return bytes;
+}
+
+/// Identifies the metadata file contents a cache entry was parsed from, so snapshots can be checked for staleness.
+struct SmuflSourceStamp
+{
+    std::int64_t modified{};
+    std::uint64_t size{};
+
+    bool operator==(const SmuflSourceStamp&) const = default;
+};
+
+static std::optional<SmuflSourceStamp> sourceStampForFile(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    const auto modified = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return SmuflSourceStamp{ static_cast<std::int64_t>(modified.time_since_epoch().count()), static_cast<std::uint64_t>(size) };
+}
+
+/// One cache slot per metadata path. The JSON is parsed at most once per slot, outside the cache lock,
+/// so threads asking for different fonts do not wait on each other. If parsing throws, the next caller retries.
+struct SmuflMetadataEntry
+{
+    std::once_flag loaded;
+    std::shared_ptr<const SmuflFontMetadata> metadata;
+    std::optional<SmuflSourceStamp> stamp;
+    std::size_t bytes{};            ///< charged to the cache budget once ready
+    std::atomic<std::uint64_t> lastUse{};
+    std::atomic<bool> ready{};  ///< set once metadata and stamp are final, for readers that do not go through call_once
+};
+
+/// Slots are evicted under the process cache budget only once they are ready. A caller holding an evicted slot's
+/// metadata keeps it alive; the next lookup of that font parses it again.
+class SmuflMetadataCache
+{
+public:
+    SmuflMetadataCache()
+        : m_account("smufl-metadata", [this]() { return oldestUse(); }, [this]() { return evictOldest(); })
+    {
+    }
+
+    std::shared_ptr<SmuflMetadataEntry> entry(const std::u8string& key)
+    {
+        std::shared_ptr<SmuflMetadataEntry> result;
+        {
+            std::shared_lock lock(m_mutex);
+            if (auto it = m_entries.find(key); it != m_entries.end()) {
+                result = it->second;
+            }
+        }
+        if (!result) {
+            std::unique_lock lock(m_mutex);
+            auto& slot = m_entries[key];
+            if (!slot) {
+                slot = std::make_shared<SmuflMetadataEntry>();
+            }
+            result = slot;
+        }
+        result->lastUse.store(utils::CacheBudget::tick(), std::memory_order_relaxed);
+        return result;
+    }
+
+    /// Finishes loading entry: charges it to the budget and makes it visible to snapshots and eviction.
+    /// Called from within the entry's call_once.
+    void install(SmuflMetadataEntry& entry, std::shared_ptr<const SmuflFontMetadata> metadata, std::optional<SmuflSourceStamp> stamp)
+    {
+        entry.bytes = estimateMetadataBytes(*metadata);
+        entry.stamp = stamp;
+        entry.metadata = std::move(metadata);
+        m_account.charge(entry.bytes);
+        entry.ready.store(true, std::memory_order_release);
+    }
+
+    /// Evicts to the budget. Must be called outside any call_once, since eviction takes the cache lock.
+    static void enforceBudget()
+    { utils::CacheBudget::instance().enforce(); }
+
+    /// Returns the parsed entries, keyed by path.
+    std::vector<std::pair<std::u8string, std::shared_ptr<SmuflMetadataEntry>>> loadedEntries() const
+    {
+        std::shared_lock lock(m_mutex);
+        std::vector<std::pair<std::u8string, std::shared_ptr<SmuflMetadataEntry>>> result;
+        for (const auto& [key, entry] : m_entries) {
+            result.emplace_back(key, entry);
+        }
+        return result;
+    }
+
+private:
+    std::optional<std::uint64_t> oldestUse() const
+    {
+        std::shared_lock lock(m_mutex);
+        std::optional<std::uint64_t> result;
+        for (const auto& [key, entry] : m_entries) {
+            if (entry->ready.load(std::memory_order_acquire)) {
+                const auto use = entry->lastUse.load(std::memory_order_relaxed);
+                result = result ? std::min(*result, use) : use;
+            }
+        }
+        return result;
+    }
+
+    std::size_t evictOldest()
+    {
+        std::unique_lock lock(m_mutex);
+        auto oldest = m_entries.end();
+        std::uint64_t oldestUse = 0;
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (!it->second->ready.load(std::memory_order_acquire)) {
+                continue;
+            }
+            if (const auto use = it->second->lastUse.load(std::memory_order_relaxed); oldest == m_entries.end() || use < oldestUse) {
+                oldest = it;
+                oldestUse = use;
+            }
+        }
+        if (oldest == m_entries.end()) {
+            return 0;
+        }
+        const std::size_t bytes = oldest->second->bytes;
+        m_entries.erase(oldest);
+        return bytes;
+    }
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::u8string, std::shared_ptr<SmuflMetadataEntry>> m_entries;
+    utils::CacheBudget::Account m_account;  ///< last, so it is unregistered before the entries go
+};
 
-    std::ifstream jsonFile;
-    jsonFile.exceptions(std::ios::failbit | std::ios::badbit);
-    jsonFile.open(fontMetadataPath);
-    if (!jsonFile.is_open()) {
-        throw std::runtime_error("Unable to open JSON file: " + utils::utf8ToString(fontMetadataPath.u8string()));
+static SmuflMetadataCache& metadataCache()
+{
+    static SmuflMetadataCache cache;
+    return cache;
+}
+
+static std::shared_ptr<const SmuflFontMetadata> metadataForFont(const std::filesystem::path& fontMetadataPath)
+{
+    auto entry = metadataCache().entry(fontMetadataPath.u8string());
+    bool loadedNow = false;
+    std::call_once(entry->loaded, [&]() {
+        std::ifstream jsonFile;
+        jsonFile.exceptions(std::ios::failbit | std::ios::badbit);
+        jsonFile.open(fontMetadataPath);
+        if (!jsonFile.is_open()) {
+            throw std::runtime_error("Unable to open JSON file: " + utils::utf8ToString(fontMetadataPath.u8string()));
+        }
+        const auto stamp = sourceStampForFile(fontMetadataPath);
+        metadataCache().install(*entry, std::make_shared<const SmuflFontMetadata>(parseSmuflMetadata(jsonFile)), stamp);
+        loadedNow = true;
+    });
+    if (loadedNow) {
+        SmuflMetadataCache::enforceBudget();
     }
-    auto [newIt, _] = metadataCache.emplace(cacheKey, parseSmuflMetadata(jsonFile));
-    return &newIt->second;
+    return entry->metadata;
 }
 
+// Snapshot layout, all integers and doubles in native byte order:
+//   magic, version, byte-order marker, entry count, then per entry:
+//   path, stamp (modified, size), optional glyph names, advance widths, bounding boxes.
+// Every string is a uint32 length followed by UTF-8 bytes; every map is a uint32 count followed by its items.
+constexpr std::array<char, 8> SNAPSHOT_MAGIC = { 'D', 'N', 'G', 'S', 'M', 'F', 'L', '\0' };
+constexpr std::uint32_t SNAPSHOT_VERSION = 1;
+constexpr std::uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+class SnapshotWriter
+{
+public:
+    explicit SnapshotWriter(std::ostream& stream) : m_stream(stream) {}
+
+    template <typename T>
+    void write(const T& value)
+    {
+        m_stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writeString(std::string_view value)
+    {
+        write(static_cast<std::uint32_t>(value.size()));
+        m_stream.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+private:
+    std::ostream& m_stream;
+};
+
+class SnapshotReader
+{
+public:
+    explicit SnapshotReader(std::istream& stream) : m_stream(stream) {}
+
+    template <typename T>
+    T read()
+    {
+        T value{};
+        if (!m_stream.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+            throw std::runtime_error("SMuFL metadata snapshot is truncated.");
+        }
+        return value;
+    }
+
+    std::string readString()
+    {
+        const auto size = read<std::uint32_t>();
+        std::string value(size, '\0');
+        if (size > 0 && !m_stream.read(value.data(), static_cast<std::streamsize>(size))) {
+            throw std::runtime_error("SMuFL metadata snapshot is truncated.");
+        }
+        return value;
+    }
+
+private:
+    std::istream& m_stream;
+};
+
 } // namespace
 
+bool preloadSmuflMetadata(const std::string& fontName)
+{
+    if (findSmuflMetadataTable(fontName)) {
+        return true;
+    }
+    if (auto metaDataPath = FontInfo::calcSMuFLMetaDataPath(fontName)) {
+        return metadataForFont(metaDataPath.value()) != nullptr;
+    }
+    return false;
+}
+
+void saveSmuflMetadataSnapshot(const std::filesystem::path& snapshotPath)
+{
+    auto tempPath = snapshotPath;
+    tempPath += ".tmp";
+    {
+        std::ofstream output(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!output) {
+            throw std::runtime_error("Unable to write SMuFL metadata snapshot: " + utils::utf8ToString(snapshotPath.u8string()));
+        }
+        std::vector<std::pair<std::u8string, std::shared_ptr<SmuflMetadataEntry>>> entries;
+        for (auto& [key, entry] : metadataCache().loadedEntries()) {
+            if (entry->ready.load(std::memory_order_acquire) && entry->stamp) {
+                entries.emplace_back(key, entry);
+            }
+        }
+
+        SnapshotWriter writer(output);
+        output.write(SNAPSHOT_MAGIC.data(), SNAPSHOT_MAGIC.size());
+        writer.write(SNAPSHOT_VERSION);
+        writer.write(SNAPSHOT_BYTE_ORDER);
+        writer.write(static_cast<std::uint32_t>(entries.size()));
+        for (const auto& [key, entry] : entries) {
+            const auto& metadata = *entry->metadata;
+            writer.writeString(std::string_view(reinterpret_cast<const char*>(key.data()), key.size()));
+            writer.write(entry->stamp->modified);
+            writer.write(entry->stamp->size);
+            writer.write(static_cast<std::uint32_t>(metadata.optionalGlyphNames.size()));
+            for (const auto& [codepoint, glyphName] : metadata.optionalGlyphNames) {
+                writer.write(static_cast<std::uint32_t>(codepoint));
+                writer.writeString(glyphName);
+            }
+            writer.write(static_cast<std::uint32_t>(metadata.glyphAdvanceWidths.size()));
+            for (const auto& [glyphName, advance] : metadata.glyphAdvanceWidths) {
+                writer.writeString(glyphName);
+                writer.write(static_cast<double>(advance));
+            }
+            writer.write(static_cast<std::uint32_t>(metadata.glyphBBoxes.size()));
+            for (const auto& [glyphName, bbox] : metadata.glyphBBoxes) {
+                writer.writeString(glyphName);
+                for (const auto value : bbox) {
+                    writer.write(static_cast<double>(value));
+                }
+            }
+        }
+        if (!output.flush()) {
+            throw std::runtime_error("Unable to write SMuFL metadata snapshot: " + utils::utf8ToString(snapshotPath.u8string()));
+        }
+    }
+    std::filesystem::rename(tempPath, snapshotPath);
+}
+
+size_t loadSmuflMetadataSnapshot(const std::filesystem::path& snapshotPath)
+{
+    std::ifstream input(snapshotPath, std::ios::in | std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Unable to open SMuFL metadata snapshot: " + utils::utf8ToString(snapshotPath.u8string()));
+    }
+    std::array<char, SNAPSHOT_MAGIC.size()> magic{};
+    if (!input.read(magic.data(), magic.size()) || magic != SNAPSHOT_MAGIC) {
+        throw std::runtime_error("Not a SMuFL metadata snapshot: " + utils::utf8ToString(snapshotPath.u8string()));
+    }
+    SnapshotReader reader(input);
+    if (reader.read<std::uint32_t>() != SNAPSHOT_VERSION || reader.read<std::uint32_t>() != SNAPSHOT_BYTE_ORDER) {
+        throw std::runtime_error("Unsupported SMuFL metadata snapshot: " + utils::utf8ToString(snapshotPath.u8string()));
+    }
+
+    size_t installed = 0;
+    const auto entryCount = reader.read<std::uint32_t>();
+    for (std::uint32_t entryIndex = 0; entryIndex < entryCount; entryIndex++) {
+        const auto path = reader.readString();
+        SmuflSourceStamp stamp;
+        stamp.modified = reader.read<std::int64_t>();
+        stamp.size = reader.read<std::uint64_t>();
+        auto metadata = std::make_unique<SmuflFontMetadata>();
+        for (auto count = reader.read<std::uint32_t>(); count > 0; count--) {
+            const auto codepoint = static_cast<char32_t>(reader.read<std::uint32_t>());
+            metadata->optionalGlyphNames.emplace(codepoint, reader.readString());
+        }
+        for (auto count = reader.read<std::uint32_t>(); count > 0; count--) {
+            auto glyphName = reader.readString();
+            metadata->glyphAdvanceWidths.emplace(std::move(glyphName), static_cast<EvpuFloat>(reader.read<double>()));
+        }
+        for (auto count = reader.read<std::uint32_t>(); count > 0; count--) {
+            auto glyphName = reader.readString();
+            std::array<EvpuFloat, 4> bbox{};
+            for (auto& value : bbox) {
+                value = static_cast<EvpuFloat>(reader.read<double>());
+            }
+            metadata->glyphBBoxes.emplace(std::move(glyphName), bbox);
+        }
+
+        // skip fonts whose metadata file has changed or vanished since the snapshot was taken
+        const auto metadataPath = utils::utf8ToPath(path);
+        if (sourceStampForFile(metadataPath) != stamp) {
+            continue;
+        }
+        auto entry = metadataCache().entry(metadataPath.u8string());
+        std::call_once(entry->loaded, [&]() {
+            metadataCache().install(*entry, std::move(metadata), stamp);
+            installed++;
+        });
+    }
+    SmuflMetadataCache::enforceBudget();
+    return installed;
+}
+
+/// Returns the compiled-in metadata table for the font of fontInfo, or nullptr if this build has none.
+static const SmuflMetadataTable* builtInTableFor(const FontInfo& fontInfo)
+{
+    if (builtInSmuflMetadataTables().empty()) {
+        return nullptr;
+    }
+    try {
+        return findSmuflMetadataTable(fontInfo.getName());
+    } catch (...) {
+        return nullptr;
+    }
+}
+
 static std::optional<std::string> smuflGlyphNameForFont(const std::filesystem::path& fontMetadataPath, char32_t codepoint)
 {
     if (auto glyphName = smufl_mapping::getGlyphName(codepoint)) {
         return std::string(*glyphName);
     }
 
-    if (const auto* metadata = metadataForFont(fontMetadataPath)) {
+    if (const auto metadata = metadataForFont(fontMetadataPath)) {
         auto it = metadata->optionalGlyphNames.find(codepoint);
         if (it != metadata->optionalGlyphNames.end()) {
             return it->second;
@@ -140,6 +496,18 @@ static std::optional<std::string> smuflGlyphNameForFont(const std::filesystem::p
 
 std::optional<std::string> smuflGlyphNameForFont(const MusxInstance<FontInfo>& fontInfo, char32_t codepoint)
 {
+    if (const auto* table = builtInTableFor(*fontInfo)) {
+        if (auto glyphName = smufl_mapping::getGlyphName(codepoint, smufl_mapping::SmuflGlyphSource::Finale)) {
+            return std::string(*glyphName);
+        }
+        if (auto glyphName = smufl_mapping::getGlyphName(codepoint)) {
+            return std::string(*glyphName);
+        }
+        if (const auto glyphName = table->findOptionalGlyphName(codepoint); !glyphName.empty()) {
+            return std::string(glyphName);
+        }
+        return std::nullopt;
+    }
     if (auto metaDataPath = fontInfo->calcSMuFLMetaDataPath()) {
         if (auto glyphName = smufl_mapping::getGlyphName(codepoint, smufl_mapping::SmuflGlyphSource::Finale)) {
             return std::string(*glyphName);
@@ -161,6 +529,12 @@ std::optional<std::string> smuflGlyphNameForFont(const MusxInstance<FontInfo>& f
 
 std::optional<EvpuFloat> smuflGlyphWidthForFont(const std::string& fontName, const std::string& glyphName)
 {
+    if (const auto* table = findSmuflMetadataTable(fontName)) {
+        if (const auto* glyph = table->findGlyph(glyphName)) {
+            return (glyph->hasBBox ? glyph->bbox[2] - glyph->bbox[0] : glyph->advance) * EVPU_PER_SPACE;
+        }
+        return std::nullopt;
+    }
 #if defined(MUSX_RUNNING_ON_WASM)
     // No local SMuFL font metadata is available in a wasm sandbox, so there is no
     // bbox/advance-width data to look up. Skip the lookup explicitly rather than relying
@@ -169,7 +543,7 @@ std::optional<EvpuFloat> smuflGlyphWidthForFont(const std::string& fontName, con
     (void)glyphName;
 #else
     if (auto metaDataPath = FontInfo::calcSMuFLMetaDataPath(fontName)) {
-        if (const auto* metadata = metadataForFont(metaDataPath.value())) {
+        if (const auto metadata = metadataForFont(metaDataPath.value())) {
             auto bboxIt = metadata->glyphBBoxes.find(glyphName);
             if (bboxIt != metadata->glyphBBoxes.end()) {
                 const auto& bbox = bboxIt->second;
@@ -185,8 +559,35 @@ std::optional<EvpuFloat> smuflGlyphWidthForFont(const std::string& fontName, con
     return std::nullopt;
 }
 
+/// Scales a glyph's metadata, in staff spaces, to the point size of fontInfo.
+static SmuflGlyphMetricsEvpu scaleGlyphMetrics(const FontInfo& fontInfo, std::optional<EvpuFloat> advanceInSpaces, const std::array<EvpuFloat, 4>& bbox)
+{
+    const EvpuFloat pointSize = fontInfo.fontSize > 0 ? static_cast<EvpuFloat>(fontInfo.fontSize) : 12.0;
+    const EvpuFloat evpuPerSpaceAtSize = pointSize * EVPU_PER_POINT / 4.0;
+
+    SmuflGlyphMetricsEvpu result;
+    result.advance = advanceInSpaces.value_or(bbox[2] - bbox[0]) * evpuPerSpaceAtSize;
+    result.top = bbox[3] * evpuPerSpaceAtSize;
+    result.bottom = bbox[1] * evpuPerSpaceAtSize;
+    return result;
+}
+
 std::optional<SmuflGlyphMetricsEvpu> smuflGlyphMetricsForFont(const FontInfo& fontInfo, char32_t codepoint)
 {
+    if (const auto* table = builtInTableFor(fontInfo)) {
+        std::optional<std::string> glyphName;
+        if (auto standardName = smufl_mapping::getGlyphName(codepoint)) {
+            glyphName = std::string(*standardName);
+        } else if (const auto optionalName = table->findOptionalGlyphName(codepoint); !optionalName.empty()) {
+            glyphName = std::string(optionalName);
+        }
+        const auto* glyph = glyphName ? table->findGlyph(*glyphName) : nullptr;
+        if (!glyph || !glyph->hasBBox) {
+            return std::nullopt;
+        }
+        return scaleGlyphMetrics(fontInfo, glyph->hasAdvance ? std::optional<EvpuFloat>(glyph->advance) : std::nullopt, glyph->bbox);
+    }
+
     auto metadataPath = fontInfo.calcSMuFLMetaDataPath();
     if (!metadataPath) {
         return std::nullopt;
@@ -197,7 +598,7 @@ std::optional<SmuflGlyphMetricsEvpu> smuflGlyphMetricsForFont(const FontInfo& fo
         return std::nullopt;
     }
 
-    const auto* metadata = metadataForFont(metadataPath.value());
+    const auto metadata = metadataForFont(metadataPath.value());
     if (!metadata) {
         return std::nullopt;
     }
@@ -206,19 +607,10 @@ std::optional<SmuflGlyphMetricsEvpu> smuflGlyphMetricsForFont(const FontInfo& fo
         return std::nullopt;
     }
 
-    const EvpuFloat pointSize = fontInfo.fontSize > 0 ? static_cast<EvpuFloat>(fontInfo.fontSize) : 12.0;
-    const EvpuFloat evpuPerSpaceAtSize = pointSize * EVPU_PER_POINT / 4.0;
-    const auto& bbox = bboxIt->second;
-
-    SmuflGlyphMetricsEvpu result;
     auto advanceIt = metadata->glyphAdvanceWidths.find(glyphName.value());
-    const EvpuFloat advanceInSpaces = (advanceIt != metadata->glyphAdvanceWidths.end())
-                                      ? advanceIt->second
-                                      : (bbox[2] - bbox[0]);
-    result.advance = advanceInSpaces * evpuPerSpaceAtSize;
-    result.top = bbox[3] * evpuPerSpaceAtSize;
-    result.bottom = bbox[1] * evpuPerSpaceAtSize;
-    return result;
+    return scaleGlyphMetrics(fontInfo,
+                             advanceIt != metadata->glyphAdvanceWidths.end() ? std::optional<EvpuFloat>(advanceIt->second) : std::nullopt,
+                             bboxIt->second);
 }
 
 } // namespace utils
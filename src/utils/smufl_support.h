@@ -21,6 +21,7 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <filesystem>
 #include <optional>
@@ -45,4 +46,18 @@ std::optional<musx::dom::EvpuFloat> smuflGlyphWidthForFont(const std::string& fo
 
 std::optional<SmuflGlyphMetricsEvpu> smuflGlyphMetricsForFont(const musx::dom::FontInfo& fontInfo, char32_t codepoint);
 
+/// @brief Parses and caches the SMuFL metadata for a font now rather than on first lookup.
+/// @return true if metadata was found for the font.
+bool preloadSmuflMetadata(const std::string& fontName);
+
+/// @brief Writes every SMuFL metadata file parsed so far to a compact binary snapshot.
+/// @throws std::runtime_error if the snapshot cannot be written.
+void saveSmuflMetadataSnapshot(const std::filesystem::path& snapshotPath);
+
+/// @brief Installs metadata from a snapshot written by saveSmuflMetadataSnapshot, skipping fonts
+/// already loaded and fonts whose metadata file has changed since the snapshot was taken.
+/// @return The number of fonts installed.
+/// @throws std::runtime_error if the snapshot cannot be read or is malformed.
+size_t loadSmuflMetadataSnapshot(const std::filesystem::path& snapshotPath);
+
 } // namespace utils
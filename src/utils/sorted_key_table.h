@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @class SortedKeyTable
+ * @brief An append-then-query map stored as one sorted vector of key/value pairs.
+ *
+ * Entries are appended while a structure is being built and sorted once by seal(), after which find() is a
+ * binary search over contiguous memory. When a key is appended more than once, the first value wins, as with
+ * std::unordered_map::try_emplace. Appending after seal() is allowed but requires another seal() before the
+ * next lookup.
+ */
+template <typename Key, typename Value, typename Allocator = std::allocator<std::pair<Key, Value>>>
+class SortedKeyTable
+{
+public:
+    using value_type = std::pair<Key, Value>;
+    using allocator_type = Allocator;
+
+    SortedKeyTable() = default;
+    explicit SortedKeyTable(const Allocator& allocator) : m_entries(allocator) {}
+
+    void append(Key key, Value value)
+    {
+        m_entries.emplace_back(std::move(key), std::move(value));
+        m_sealed = false;
+    }
+
+    /// Appends every entry of other after the entries already here, so that entries here win duplicate keys.
+    void appendFrom(SortedKeyTable&& other)
+    {
+        if (m_entries.empty()) {
+            m_entries = std::move(other.m_entries);
+        } else {
+            m_entries.insert(m_entries.end(), std::make_move_iterator(other.m_entries.begin()),
+                std::make_move_iterator(other.m_entries.end()));
+        }
+        other.clear();
+        m_sealed = m_entries.empty();
+    }
+
+    /// Sorts the entries by key and drops the later duplicates of each key.
+    void seal()
+    {
+        if (m_sealed) {
+            return;
+        }
+        std::stable_sort(m_entries.begin(), m_entries.end(), [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first < rhs.first;
+        });
+        const auto last = std::unique(m_entries.begin(), m_entries.end(), [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first == rhs.first;
+        });
+        m_entries.erase(last, m_entries.end());
+        m_sealed = true;
+    }
+
+    /// Returns the value for key, or nullptr. The table must be sealed.
+    const Value* find(const Key& key) const
+    {
+        const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key, [](const value_type& entry, const Key& value) {
+            return entry.first < value;
+        });
+        return it != m_entries.end() && it->first == key ? &it->second : nullptr;
+    }
+
+    bool isSealed() const { return m_sealed; }
+    std::size_t size() const { return m_entries.size(); }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_sealed = true;
+    }
+
+private:
+    std::vector<value_type, Allocator> m_entries;
+    bool m_sealed{ true };
+};
+
+} // namespace utils
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "zlib.h"
+#ifdef DENIGMA_ZSTD
+#include "zstd.h"
+#endif
+
+#include "utils/stream_compression.h"
+
+namespace utils {
+
+namespace {
+
+constexpr std::size_t MIN_GROWTH = 16384;
+
+/// Grows output by half again (at least MIN_GROWTH) once produced has filled it.
+void growIfFull(std::vector<char>& output, std::size_t produced)
+{
+    if (produced == output.size()) {
+        output.resize(output.size() + (std::max)(output.size() / 2, MIN_GROWTH));
+    }
+}
+
+std::vector<char> gunzip(std::span<const char> input)
+{
+    // the ISIZE trailer of the last member is only a hint: it wraps at 4 GB and counts just that member
+    constexpr std::size_t MAX_DEFLATE_RATIO = 1032;
+    std::size_t sizeHint = 0;
+    if (input.size() >= 18) {
+        const auto* trailer = reinterpret_cast<const unsigned char*>(input.data() + input.size() - 4);
+        sizeHint = static_cast<std::size_t>(trailer[0]) | (static_cast<std::size_t>(trailer[1]) << 8)
+            | (static_cast<std::size_t>(trailer[2]) << 16) | (static_cast<std::size_t>(trailer[3]) << 24);
+        sizeHint = (std::min)(sizeHint, input.size() * MAX_DEFLATE_RATIO);
+    }
+
+    z_stream stream{};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) { // 16 + MAX_WBITS = gzip stream
+        throw std::runtime_error("unable to initialize zlib inflate");
+    }
+    std::vector<char> output(sizeHint + 1); // the extra byte lets inflate report the end without a growth step
+    std::size_t produced = 0;
+    std::size_t consumed = 0;
+    while (true) {
+        if (stream.avail_in == 0) {
+            const std::size_t chunk = (std::min<std::size_t>)(input.size() - consumed, (std::numeric_limits<uInt>::max)());
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data() + consumed));
+            stream.avail_in = static_cast<uInt>(chunk);
+            consumed += chunk;
+        }
+        growIfFull(output, produced);
+        const std::size_t outputChunk = (std::min<std::size_t>)(output.size() - produced, (std::numeric_limits<uInt>::max)());
+        stream.next_out = reinterpret_cast<Bytef*>(output.data() + produced);
+        stream.avail_out = static_cast<uInt>(outputChunk);
+        const int rc = inflate(&stream, Z_NO_FLUSH);
+        const std::size_t written = outputChunk - stream.avail_out;
+        produced += written;
+        if (rc == Z_STREAM_END) {
+            if (stream.avail_in == 0 && consumed == input.size()) {
+                break;
+            }
+            inflateReset(&stream); // another member follows, as `cat a.gz b.gz` produces
+            continue;
+        }
+        const bool inputExhausted = stream.avail_in == 0 && consumed == input.size();
+        if (rc != Z_OK || (inputExhausted && written == 0)) {
+            inflateEnd(&stream);
+            throw std::runtime_error(rc == Z_OK || (rc == Z_BUF_ERROR && inputExhausted)
+                ? "unexpected end of gzip stream" : "unable to decompress gzip stream");
+        }
+    }
+    inflateEnd(&stream);
+    output.resize(produced);
+    return output;
+}
+
+std::vector<char> gzip(std::span<const char> input)
+{
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("unable to initialize zlib deflate");
+    }
+    std::vector<char> output(static_cast<std::size_t>(deflateBound(&stream, static_cast<uLong>((std::min<std::size_t>)(input.size(), (std::numeric_limits<uLong>::max)())))));
+    std::size_t produced = 0;
+    std::size_t consumed = 0;
+    int rc = Z_OK;
+    while (rc != Z_STREAM_END) {
+        if (stream.avail_in == 0 && consumed < input.size()) {
+            const std::size_t chunk = (std::min<std::size_t>)(input.size() - consumed, (std::numeric_limits<uInt>::max)());
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data() + consumed));
+            stream.avail_in = static_cast<uInt>(chunk);
+            consumed += chunk;
+        }
+        growIfFull(output, produced);
+        const std::size_t outputChunk = (std::min<std::size_t>)(output.size() - produced, (std::numeric_limits<uInt>::max)());
+        stream.next_out = reinterpret_cast<Bytef*>(output.data() + produced);
+        stream.avail_out = static_cast<uInt>(outputChunk);
+        rc = deflate(&stream, consumed == input.size() ? Z_FINISH : Z_NO_FLUSH);
+        if (rc == Z_STREAM_ERROR) {
+            deflateEnd(&stream);
+            throw std::runtime_error("unable to compress gzip stream");
+        }
+        produced += outputChunk - stream.avail_out;
+    }
+    deflateEnd(&stream);
+    output.resize(produced);
+    return output;
+}
+
+#ifdef DENIGMA_ZSTD
+
+std::vector<char> unzstd(std::span<const char> input)
+{
+    std::size_t sizeHint = 0;
+    const auto contentSize = ZSTD_getFrameContentSize(input.data(), input.size());
+    if (contentSize != ZSTD_CONTENTSIZE_UNKNOWN && contentSize != ZSTD_CONTENTSIZE_ERROR) {
+        constexpr std::size_t MAX_ZSTD_HINT_RATIO = 4096; // a forged header must not allocate far beyond the input
+        sizeHint = static_cast<std::size_t>((std::min<unsigned long long>)(contentSize, input.size() * MAX_ZSTD_HINT_RATIO));
+    }
+    ZSTD_DCtx* context = ZSTD_createDCtx();
+    if (!context) {
+        throw std::runtime_error("unable to initialize zstd decompression");
+    }
+    std::vector<char> output(sizeHint + 1);
+    ZSTD_inBuffer in{ input.data(), input.size(), 0 };
+    std::size_t produced = 0;
+    std::size_t remaining = 0; // nonzero while a frame is unfinished
+    while (in.pos < in.size || remaining != 0) {
+        growIfFull(output, produced);
+        ZSTD_outBuffer out{ output.data() + produced, output.size() - produced, 0 };
+        const std::size_t previousPos = in.pos;
+        remaining = ZSTD_decompressStream(context, &out, &in);
+        produced += out.pos;
+        if (ZSTD_isError(remaining)) {
+            ZSTD_freeDCtx(context);
+            throw std::runtime_error(std::string("unable to decompress zstd stream: ") + ZSTD_getErrorName(remaining));
+        }
+        if (in.pos == in.size && remaining != 0 && out.pos == 0 && in.pos == previousPos) {
+            ZSTD_freeDCtx(context);
+            throw std::runtime_error("unexpected end of zstd stream");
+        }
+    }
+    ZSTD_freeDCtx(context);
+    output.resize(produced);
+    return output;
+}
+
+std::vector<char> zstd(std::span<const char> input)
+{
+    std::vector<char> output(ZSTD_compressBound(input.size()));
+    const std::size_t written = ZSTD_compress(output.data(), output.size(), input.data(), input.size(), ZSTD_CLEVEL_DEFAULT);
+    if (ZSTD_isError(written)) {
+        throw std::runtime_error(std::string("unable to compress zstd stream: ") + ZSTD_getErrorName(written));
+    }
+    output.resize(written);
+    return output;
+}
+
+#endif // DENIGMA_ZSTD
+
+#ifndef DENIGMA_ZSTD
+[[noreturn]] void throwNoZstd()
+{
+    throw std::runtime_error("zstd compression is not available in this build (DENIGMA_ZSTD is off)");
+}
+#endif
+
+} // namespace
+
+bool hasZstdCompression()
+{
+#ifdef DENIGMA_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+StreamCompression compressionForExtension(std::u8string_view extension)
+{
+    if (extension == u8"gz") {
+        return StreamCompression::Gzip;
+    }
+    if (extension == u8"zst") {
+        return StreamCompression::Zstd;
+    }
+    return StreamCompression::None;
+}
+
+StreamCompression detectCompression(std::span<const char> data)
+{
+    auto startsWith = [&](std::initializer_list<unsigned char> magic) {
+        return data.size() >= magic.size()
+            && std::equal(magic.begin(), magic.end(), data.begin(), [](unsigned char m, char c) { return m == static_cast<unsigned char>(c); });
+    };
+    if (startsWith({ 0x1f, 0x8b })) {
+        return StreamCompression::Gzip;
+    }
+    if (startsWith({ 0x28, 0xb5, 0x2f, 0xfd })) {
+        return StreamCompression::Zstd;
+    }
+    return StreamCompression::None;
+}
+
+std::vector<char> decompress(std::span<const char> input, StreamCompression compression)
+{
+    switch (compression) {
+    case StreamCompression::Gzip:
+        return gunzip(input);
+    case StreamCompression::Zstd:
+#ifdef DENIGMA_ZSTD
+        return unzstd(input);
+#else
+        throwNoZstd();
+#endif
+    case StreamCompression::None:
+        break;
+    }
+    return std::vector<char>(input.begin(), input.end());
+}
+
+std::vector<char> compress(std::span<const char> input, StreamCompression compression)
+{
+    switch (compression) {
+    case StreamCompression::Gzip:
+        return gzip(input);
+    case StreamCompression::Zstd:
+#ifdef DENIGMA_ZSTD
+        return zstd(input);
+#else
+        throwNoZstd();
+#endif
+    case StreamCompression::None:
+        break;
+    }
+    return std::vector<char>(input.begin(), input.end());
+}
+
+} // namespace utils
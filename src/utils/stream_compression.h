@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+/// @brief A whole-file compression wrapper around another format, as in `score.enigmaxml.zst`.
+enum class StreamCompression
+{
+    None,
+    Gzip,   ///< gzip members (`.gz`)
+    Zstd    ///< zstd frames (`.zst`); available only when built with DENIGMA_ZSTD
+};
+
+/// True if this build reads and writes StreamCompression::Zstd.
+bool hasZstdCompression();
+
+/// Returns the compression named by a normalized file extension (`gz` or `zst`), or StreamCompression::None.
+StreamCompression compressionForExtension(std::u8string_view extension);
+
+/// Recognizes compressed data by its magic number, or returns StreamCompression::None.
+StreamCompression detectCompression(std::span<const char> data);
+
+/**
+ * @brief Decompresses every gzip member or zstd frame of input.
+ *
+ * The output is sized from the size the stream records (the gzip trailer or the zstd frame header) and grown only if
+ * that is missing or wrong, so a large file inflates straight into its final buffer.
+ * @throws std::runtime_error if input is corrupt or truncated, or if the compression is not built in.
+ */
+std::vector<char> decompress(std::span<const char> input, StreamCompression compression);
+
+/// @brief Compresses input as one gzip member or zstd frame at the library's default level.
+/// @throws std::runtime_error if compression fails or is not built in.
+std::vector<char> compress(std::span<const char> input, StreamCompression compression);
+
+} // namespace utils
@@ -21,6 +21,9 @@
  */
 #pragma once
 
+#include <array>
+#include <charconv>
+#include <cstdio>
 #include <string>
 #include <string_view>
 #include <ostream>
@@ -36,6 +39,11 @@
 #include <windows.h>
 #endif
 
+// Floating-point std::to_chars is missing from older standard libraries, including Apple's before macOS 13.3.
+#if defined(__cpp_lib_to_chars) && !defined(__APPLE__)
+#define STRINGUTILS_HAS_FLOAT_TO_CHARS 1
+#endif
+
 #if !defined(CP_UTF8) && !defined(CP_ACP) && !defined(STRINGUTILS_DEFINED_CPS)
 #define CP_UTF8 65001
 #define CP_ACP  0
@@ -254,6 +262,132 @@ inline std::string trimAscii(std::string_view text)
     return std::string(text);
 }
 
+/// @brief Matches text against a file-name wildcard pattern, where `*` matches any run of characters and `?` any
+/// single character. All other characters match themselves.
+///
+/// Uses the greedy star-backtracking walk, so it runs in O(text * pattern) worst case and usually linear.
+template <typename CharT>
+inline bool wildcardMatch(std::basic_string_view<CharT> pattern, std::basic_string_view<CharT> text)
+{
+    std::size_t patternIndex = 0;
+    std::size_t textIndex = 0;
+    std::size_t starIndex = std::basic_string_view<CharT>::npos;
+    std::size_t starTextIndex = 0;
+    while (textIndex < text.size()) {
+        if (patternIndex < pattern.size() && (pattern[patternIndex] == CharT('?') || pattern[patternIndex] == text[textIndex])) {
+            ++patternIndex;
+            ++textIndex;
+        } else if (patternIndex < pattern.size() && pattern[patternIndex] == CharT('*')) {
+            starIndex = patternIndex++;
+            starTextIndex = textIndex;
+        } else if (starIndex != std::basic_string_view<CharT>::npos) {
+            patternIndex = starIndex + 1;
+            textIndex = ++starTextIndex;
+        } else {
+            return false;
+        }
+    }
+    while (patternIndex < pattern.size() && pattern[patternIndex] == CharT('*')) {
+        ++patternIndex;
+    }
+    return patternIndex == pattern.size();
+}
+
+/// @brief A number formatted into a fixed stack buffer, so that writers can pass it to an XML or stream API without
+/// allocating. Formatting does not depend on the C locale (the decimal separator is always '.').
+class NumberText
+{
+public:
+    /// Formats like printf's "%.*g": at most precision significant digits, without trailing zeros.
+    static NumberText general(double value, int precision)
+    {
+        NumberText result;
+#if defined(STRINGUTILS_HAS_FLOAT_TO_CHARS)
+        result.assign(std::to_chars(result.begin(), result.end(), value, std::chars_format::general, precision));
+#else
+        result.print("%.*g", precision, value);
+#endif
+        return result;
+    }
+
+    /// Formats the shortest text that reads back as exactly value.
+    static NumberText shortest(double value)
+    {
+        NumberText result;
+#if defined(STRINGUTILS_HAS_FLOAT_TO_CHARS)
+        result.assign(std::to_chars(result.begin(), result.end(), value));
+#else
+        result.print("%.*g", 15, value);
+        if (std::strtod(result.c_str(), nullptr) != value) {
+            result.print("%.*g", 17, value);
+        }
+#endif
+        return result;
+    }
+
+    /// Formats with at most decimals digits after the point, dropping trailing zeros and a trailing point.
+    static NumberText fixedTrimmed(double value, int decimals)
+    {
+        NumberText result;
+#if defined(STRINGUTILS_HAS_FLOAT_TO_CHARS)
+        const auto converted = std::to_chars(result.begin(), result.end(), value, std::chars_format::fixed, decimals);
+        if (converted.ec != std::errc{}) {
+            return shortest(value); // too large for the buffer in fixed notation
+        }
+        result.assign(converted);
+#else
+        if (!result.print("%.*f", decimals, value)) {
+            return shortest(value);
+        }
+#endif
+        const std::string_view text = result.view();
+        if (text.find('.') != std::string_view::npos) {
+            while (result.m_length > 0 && result.m_buffer[result.m_length - 1] == '0') {
+                --result.m_length;
+            }
+            if (result.m_length > 0 && result.m_buffer[result.m_length - 1] == '.') {
+                --result.m_length;
+            }
+            result.m_buffer[result.m_length] = '\0';
+        }
+        return result;
+    }
+
+    std::string_view view() const { return { m_buffer.data(), m_length }; }
+    const char* c_str() const { return m_buffer.data(); }
+    std::string str() const { return std::string(view()); }
+
+private:
+    NumberText() = default;
+
+    char* begin() { return m_buffer.data(); }
+    char* end() { return m_buffer.data() + m_buffer.size() - 1; } // keeps room for the terminator
+
+    void assign(const std::to_chars_result& converted)
+    {
+        m_length = converted.ec == std::errc{} ? static_cast<std::size_t>(converted.ptr - m_buffer.data()) : 0;
+        m_buffer[m_length] = '\0';
+    }
+
+    /// Returns false if the text was truncated.
+    template <typename... Args>
+    bool print(const char* format, Args... args)
+    {
+        const int written = std::snprintf(m_buffer.data(), m_buffer.size(), format, args...);
+        m_length = written < 0 ? 0 : (std::min)(static_cast<std::size_t>(written), m_buffer.size() - 1);
+        m_buffer[m_length] = '\0';
+        return written >= 0 && static_cast<std::size_t>(written) < m_buffer.size();
+    }
+
+    std::array<char, 48> m_buffer{};
+    std::size_t m_length{};
+};
+
+inline std::ostream& operator<<(std::ostream& os, const NumberText& number)
+{
+    return os << number.view();
+}
+
 #if defined(STRINGUTILS_DEFINED_CPS)
 #undef CP_UTF8
 #undef CP_ACP
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "text_escape.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DENIGMA_TEXT_ESCAPE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace utils {
+
+namespace {
+
+enum class EscapeSet : std::uint8_t
+{
+    Xml = 1,
+    Json = 2,
+};
+
+constexpr std::array<std::uint8_t, 256> makeEscapeTable()
+{
+    std::array<std::uint8_t, 256> table{};
+    for (unsigned c : { '&', '<', '>', '"', '\'' }) {
+        table[c] |= static_cast<std::uint8_t>(EscapeSet::Xml);
+    }
+    for (unsigned c = 0; c < 0x20; ++c) {
+        table[c] |= static_cast<std::uint8_t>(EscapeSet::Json);
+    }
+    table[static_cast<unsigned char>('"')] |= static_cast<std::uint8_t>(EscapeSet::Json);
+    table[static_cast<unsigned char>('\\')] |= static_cast<std::uint8_t>(EscapeSet::Json);
+    return table;
+}
+
+constexpr auto ESCAPE_TABLE = makeEscapeTable();
+
+template <EscapeSet Set>
+std::size_t findScalar(std::string_view text, std::size_t from)
+{
+    for (; from < text.size(); ++from) {
+        if (ESCAPE_TABLE[static_cast<unsigned char>(text[from])] & static_cast<std::uint8_t>(Set)) {
+            break;
+        }
+    }
+    return from;
+}
+
+#ifdef DENIGMA_TEXT_ESCAPE_SSE2
+
+template <EscapeSet Set>
+inline unsigned escapeMask(__m128i block)
+{
+    const auto eq = [block](char c) { return _mm_cmpeq_epi8(block, _mm_set1_epi8(c)); };
+    __m128i hits;
+    if constexpr (Set == EscapeSet::Xml) {
+        hits = _mm_or_si128(_mm_or_si128(eq('&'), eq('<')), _mm_or_si128(_mm_or_si128(eq('>'), eq('"')), eq('\'')));
+    } else {
+        // unsigned c <= 0x1F exactly when min(c, 0x1F) == c
+        const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(block, _mm_set1_epi8(0x1F)), block);
+        hits = _mm_or_si128(control, _mm_or_si128(eq('"'), eq('\\')));
+    }
+    return static_cast<unsigned>(_mm_movemask_epi8(hits));
+}
+
+template <EscapeSet Set>
+std::size_t findEscape(std::string_view text, std::size_t from)
+{
+    // clean 16-byte runs are skipped with one compare; only a block with a hit falls to the bit scan
+    while (from + 16 <= text.size()) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + from));
+        if (const unsigned mask = escapeMask<Set>(block)) {
+            return from + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+        from += 16;
+    }
+    return findScalar<Set>(text, from);
+}
+
+#else
+
+template <EscapeSet Set>
+std::size_t findEscape(std::string_view text, std::size_t from)
+{
+    return findScalar<Set>(text, from);
+}
+
+#endif
+
+std::string_view xmlReplacement(char c)
+{
+    switch (c) {
+    case '&': return "&amp;";
+    case '<': return "&lt;";
+    case '>': return "&gt;";
+    case '"': return "&quot;";
+    default: return "&apos;";
+    }
+}
+
+void appendJsonReplacement(std::string& out, char c)
+{
+    switch (c) {
+    case '"': out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\n': out += "\\n"; break;
+    case '\r': out += "\\r"; break;
+    case '\t': out += "\\t"; break;
+    case '\b': out += "\\b"; break;
+    case '\f': out += "\\f"; break;
+    default: {
+        static constexpr char HEX[] = "0123456789abcdef";
+        const auto value = static_cast<unsigned char>(c);
+        const char escaped[] = { '\\', 'u', '0', '0', HEX[value >> 4], HEX[value & 0xF] };
+        out.append(escaped, sizeof(escaped));
+        break;
+    }
+    }
+}
+
+} // namespace
+
+namespace detail {
+
+std::size_t findXmlEscape(std::string_view text, std::size_t from)
+{
+    return findEscape<EscapeSet::Xml>(text, from);
+}
+
+std::size_t findJsonEscape(std::string_view text, std::size_t from)
+{
+    return findEscape<EscapeSet::Json>(text, from);
+}
+
+} // namespace detail
+
+void appendXmlEscaped(std::string& out, std::string_view text)
+{
+    std::size_t start = 0;
+    while (start < text.size()) {
+        const std::size_t next = detail::findXmlEscape(text, start);
+        out.append(text.data() + start, next - start);
+        if (next == text.size()) {
+            break;
+        }
+        out += xmlReplacement(text[next]);
+        start = next + 1;
+    }
+}
+
+void appendJsonEscaped(std::string& out, std::string_view text)
+{
+    std::size_t start = 0;
+    while (start < text.size()) {
+        const std::size_t next = detail::findJsonEscape(text, start);
+        out.append(text.data() + start, next - start);
+        if (next == text.size()) {
+            break;
+        }
+        appendJsonReplacement(out, text[next]);
+        start = next + 1;
+    }
+}
+
+} // namespace utils
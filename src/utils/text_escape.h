@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+/// Appends text to out with the XML markup characters (`&`, `<`, `>`, `"`, `'`) replaced by entity references.
+/// The result is valid both as element content and inside a quoted attribute value.
+void appendXmlEscaped(std::string& out, std::string_view text);
+
+/// Appends text to out escaped for the inside of a JSON string literal (no surrounding quotes): `"`, `\` and the
+/// control characters below 0x20 are escaped; everything else, including UTF-8 sequences, is copied as is.
+void appendJsonEscaped(std::string& out, std::string_view text);
+
+/// Returns the escaped form of text as appendXmlEscaped writes it.
+inline std::string xmlEscaped(std::string_view text)
+{
+    std::string result;
+    appendXmlEscaped(result, text);
+    return result;
+}
+
+/// Returns the escaped form of text as appendJsonEscaped writes it.
+inline std::string jsonEscaped(std::string_view text)
+{
+    std::string result;
+    appendJsonEscaped(result, text);
+    return result;
+}
+
+namespace detail {
+
+/// Returns the index of the first character at or after from that appendXmlEscaped must replace, or text.size().
+std::size_t findXmlEscape(std::string_view text, std::size_t from);
+
+/// Returns the index of the first character at or after from that appendJsonEscaped must replace, or text.size().
+std::size_t findJsonEscape(std::string_view text, std::size_t from);
+
+} // namespace detail
+
+} // namespace utils
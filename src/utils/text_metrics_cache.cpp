@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "utils/text_metrics_cache.h"
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include "core/mapped_input_file.h"
+#include "core/xxhash64.h"
+#include "utils/stringutils.h"
+
+namespace denigma {
+namespace textmetrics {
+
+namespace {
+
+// File layout, all integers and doubles in native byte order:
+//   magic, version, byte-order marker, then records of
+//   body size (uint32), XXH64 of the body (uint64), body.
+// A body is the encoded key followed by advance, ascent and descent as doubles.
+constexpr std::array<char, 8> FILE_MAGIC = { 'D', 'N', 'G', 'T', 'X', 'T', 'M', '\0' };
+constexpr std::uint32_t FILE_VERSION = 1;
+constexpr std::uint32_t FILE_BYTE_ORDER = 0x01020304;
+constexpr std::size_t HEADER_BYTES = FILE_MAGIC.size() + 2 * sizeof(std::uint32_t);
+constexpr std::size_t RECORD_PREFIX_BYTES = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+constexpr std::size_t METRICS_BYTES = 3 * sizeof(double);
+
+template <typename T>
+void appendValue(std::string& out, const T& value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readValue(const char* data)
+{
+    T value{};
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/// The key as stored: fixed fields, then the length-prefixed font path, then the text's code points.
+std::string encodeKey(const TextMetricsDiskKey& key)
+{
+    std::string result;
+    result.reserve(40 + key.fontFile.size() + key.text.size() * sizeof(char32_t));
+    appendValue(result, static_cast<std::uint32_t>(key.measurement));
+    appendValue(result, static_cast<std::int32_t>(key.faceIndex));
+    appendValue(result, static_cast<std::int64_t>(key.fontModified));
+    appendValue(result, key.fontSize);
+    appendValue(result, key.charSize26d6);
+    appendValue(result, static_cast<std::uint32_t>(key.fontFile.size()));
+    result.append(key.fontFile);
+    result.append(reinterpret_cast<const char*>(key.text.data()), key.text.size() * sizeof(char32_t));
+    return result;
+}
+
+std::uint64_t checksum(std::string_view body)
+{
+    return Xxh64::hash(std::as_bytes(std::span<const char>(body.data(), body.size())));
+}
+
+std::string fileHeader()
+{
+    std::string header(FILE_MAGIC.data(), FILE_MAGIC.size());
+    appendValue(header, FILE_VERSION);
+    appendValue(header, FILE_BYTE_ORDER);
+    return header;
+}
+
+std::string encodeRecord(std::string_view encodedKey, const TextMetricsEvpu& metrics)
+{
+    std::string body(encodedKey);
+    appendValue(body, metrics.advance);
+    appendValue(body, metrics.ascent);
+    appendValue(body, metrics.descent);
+    std::string record;
+    record.reserve(RECORD_PREFIX_BYTES + body.size());
+    appendValue(record, static_cast<std::uint32_t>(body.size()));
+    appendValue(record, checksum(body));
+    record.append(body);
+    return record;
+}
+
+/// Replaces the file with header followed by records, through a temporary file so that no process mapping the old
+/// file sees it shrink. Failures leave the old file in place.
+void rewriteFile(const std::filesystem::path& path, std::string_view records)
+{
+    auto tempPath = path;
+    tempPath += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream output(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!output) {
+            return;
+        }
+        const std::string header = fileHeader();
+        output.write(header.data(), static_cast<std::streamsize>(header.size()));
+        output.write(records.data(), static_cast<std::streamsize>(records.size()));
+        if (!output.flush()) {
+            output.close();
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+} // namespace
+
+TextMetricsDiskCache::TextMetricsDiskCache(std::filesystem::path path)
+    : m_path(std::move(path))
+{
+    load();
+}
+
+TextMetricsDiskCache::~TextMetricsDiskCache() = default;
+
+void TextMetricsDiskCache::load()
+{
+    std::error_code ec;
+    const auto fileSize = std::filesystem::file_size(m_path, ec);
+    if (ec) {
+        return; // created on the first insert
+    }
+    if (fileSize > MAX_FILE_BYTES) {
+        rewriteFile(m_path, {});
+        return;
+    }
+    try {
+        m_mapping = std::make_unique<MappedInputFile>(m_path);
+    } catch (const std::exception&) {
+        return;
+    }
+    const auto data = m_mapping->data();
+    const std::string header = fileHeader();
+    if (data.size() < HEADER_BYTES || std::memcmp(data.data(), header.data(), HEADER_BYTES) != 0) {
+        m_mapping.reset();
+        rewriteFile(m_path, {});
+        return;
+    }
+
+    std::size_t offset = HEADER_BYTES;
+    while (data.size() - offset >= RECORD_PREFIX_BYTES) {
+        const auto bodySize = readValue<std::uint32_t>(data.data() + offset);
+        const auto bodyChecksum = readValue<std::uint64_t>(data.data() + offset + sizeof(std::uint32_t));
+        const std::size_t bodyOffset = offset + RECORD_PREFIX_BYTES;
+        if (bodySize < METRICS_BYTES || data.size() - bodyOffset < bodySize) {
+            break;
+        }
+        const std::string_view body(data.data() + bodyOffset, bodySize);
+        if (checksum(body) != bodyChecksum) {
+            break;
+        }
+        const char* metrics = body.data() + bodySize - METRICS_BYTES;
+        m_entries.insert_or_assign(body.substr(0, bodySize - METRICS_BYTES),
+                                   TextMetricsEvpu{ readValue<double>(metrics),
+                                                    readValue<double>(metrics + sizeof(double)),
+                                                    readValue<double>(metrics + 2 * sizeof(double)) });
+        offset = bodyOffset + bodySize;
+    }
+    if (offset != data.size()) {
+        // a torn or corrupt record: keep what precedes it, or later appends would land after it and be lost
+        rewriteFile(m_path, std::string_view(data.data() + HEADER_BYTES, offset - HEADER_BYTES));
+    }
+}
+
+std::optional<TextMetricsEvpu> TextMetricsDiskCache::find(const TextMetricsDiskKey& key) const
+{
+    const std::string encodedKey = encodeKey(key);
+    std::shared_lock lock(m_mutex);
+    if (const auto it = m_entries.find(encodedKey); it != m_entries.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+void TextMetricsDiskCache::insert(const TextMetricsDiskKey& key, const TextMetricsEvpu& metrics)
+{
+    std::string encodedKey = encodeKey(key);
+    std::unique_lock lock(m_mutex);
+    if (m_entries.size() >= MAX_ENTRIES || m_entries.contains(encodedKey)) {
+        return;
+    }
+    const std::string record = encodeRecord(encodedKey, metrics);
+    const std::string_view storedKey = m_insertedKeys.emplace_back(std::move(encodedKey));
+    m_entries.emplace(storedKey, metrics);
+
+    if (m_outputFailed) {
+        return;
+    }
+    if (!m_output.is_open()) {
+        std::error_code ec;
+        if (!std::filesystem::exists(m_path, ec)) {
+            std::filesystem::create_directories(m_path.parent_path(), ec);
+            rewriteFile(m_path, {});
+        }
+        m_output.open(m_path, std::ios::out | std::ios::binary | std::ios::app);
+    }
+    // one write per record, so that records appended by other processes are not interleaved with it
+    if (!m_output || !m_output.write(record.data(), static_cast<std::streamsize>(record.size())) || !m_output.flush()) {
+        m_outputFailed = true;
+    }
+}
+
+std::size_t TextMetricsDiskCache::size() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_entries.size();
+}
+
+TextMetricsDiskCache* textMetricsDiskCache()
+{
+    static const std::unique_ptr<TextMetricsDiskCache> cache = []() -> std::unique_ptr<TextMetricsDiskCache> {
+        const auto path = utils::getEnvironmentValue("DENIGMA_TEXT_METRICS_CACHE");
+        if (!path || path->empty()) {
+            return nullptr;
+        }
+        return std::make_unique<TextMetricsDiskCache>(utils::utf8ToPath(*path));
+    }();
+    return cache.get();
+}
+
+} // namespace textmetrics
+} // namespace denigma
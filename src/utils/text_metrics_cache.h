@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "utils/textmetrics.h"
+
+namespace denigma {
+class MappedInputFile;
+namespace textmetrics {
+
+/// What a TextMetricsDiskCache entry measured.
+enum class DiskCachedMeasurement : std::uint32_t
+{
+    Text = 1,       ///< measureTextEvpu of the key's text
+    GlyphWidth = 2  ///< measureGlyphWidthEvpu of the key's single code point, stored as the advance
+};
+
+/// Identifies one measurement: the font file it was made with, the file's size and modification time when it was
+/// made, the character size and the text. A font file that changes no longer matches its old entries.
+struct TextMetricsDiskKey
+{
+    DiskCachedMeasurement measurement{ DiskCachedMeasurement::Text };
+    std::string_view fontFile;      ///< UTF-8 path of the font file
+    int faceIndex{};
+    long long fontModified{};
+    std::uint64_t fontSize{};
+    std::int64_t charSize26d6{};    ///< the size the face was set to, in 26.6 points
+    std::u32string_view text;
+};
+
+/**
+ * @class TextMetricsDiskCache
+ * @brief An append-only file of text measurements shared by every process that names the same file.
+ *
+ * The existing file is memory-mapped and indexed when the cache is opened, so entries are looked up without being
+ * copied. New measurements are appended one checksummed record at a time, so concurrent processes can add to the
+ * same file and a record torn by a crash is dropped on the next open. The file is rewritten (to a temporary file
+ * renamed into place, never truncated under another process's mapping) when it has a torn tail or has grown past
+ * #MAX_FILE_BYTES; entries of fonts that have since changed are never looked up again and go with the next restart.
+ * It may be shared by threads.
+ */
+class TextMetricsDiskCache
+{
+public:
+    /// The file is started over once it grows past this.
+    static constexpr std::uintmax_t MAX_FILE_BYTES = 64 * 1024 * 1024;
+    /// No more entries are recorded once this many are indexed.
+    static constexpr std::size_t MAX_ENTRIES = 1u << 20;
+
+    /// Opens (or creates on first insert) the cache at path. A missing or unreadable file gives an empty cache.
+    explicit TextMetricsDiskCache(std::filesystem::path path);
+    ~TextMetricsDiskCache();
+
+    TextMetricsDiskCache(const TextMetricsDiskCache&) = delete;
+    TextMetricsDiskCache& operator=(const TextMetricsDiskCache&) = delete;
+
+    /// Returns the stored measurement for key, if any.
+    std::optional<TextMetricsEvpu> find(const TextMetricsDiskKey& key) const;
+
+    /// Records metrics for key and appends them to the file. Write failures are ignored.
+    void insert(const TextMetricsDiskKey& key, const TextMetricsEvpu& metrics);
+
+    /// The number of measurements indexed.
+    std::size_t size() const;
+
+private:
+    void load();
+
+    std::filesystem::path m_path;
+    std::unique_ptr<MappedInputFile> m_mapping;         ///< the file as it was when opened; keys point into it
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string_view, TextMetricsEvpu> m_entries;
+    std::deque<std::string> m_insertedKeys;             ///< storage of keys added since opening
+    std::ofstream m_output;                             ///< opened on the first insert
+    bool m_outputFailed{};
+};
+
+/// @brief Returns the process's persistent measurement cache, or nullptr when none is configured.
+///
+/// DENIGMA_TEXT_METRICS_CACHE names the file; unset or empty disables the cache.
+TextMetricsDiskCache* textMetricsDiskCache();
+
+} // namespace textmetrics
+} // namespace denigma
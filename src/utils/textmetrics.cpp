@@ -25,22 +25,29 @@
 #include <cmath>
 #include <cwchar>
 #include <cwctype>
+#include <cstdint>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <set>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "core/denigma.h"
+#include "utils/font_metric_tables.h"
 #include "utils/font_names.h"
 #include "utils/stringutils.h"
+#include "utils/text_metrics_cache.h"
 
 #if defined(DENIGMA_USE_DIRECTWRITE)
 #include <windows.h>
@@ -67,6 +74,7 @@ namespace {
 
 [[maybe_unused]] void warnMissingBackend(const DenigmaContext& denigmaContext)
 {
+    denigmaContext.countHotPath(ConversionStats::HotPath::TextMetricsFallback); // every call is a fallback, though only the first warns
     static std::once_flag warningOnce;
     std::call_once(warningOnce, [&denigmaContext]() {
         denigmaContext.logMessage(LogMsg() << "FreeType text metrics backend is not enabled in this build. Falling back to heuristic text metrics.",
@@ -89,10 +97,164 @@ bool styleLooksItalic(std::string_view style)
         || normalized.find("oblique") != std::string::npos;
 }
 
-#if defined(DENIGMA_USE_FREETYPE)
-
 constexpr double EVPU_PER_POINT = musx::dom::EVPU_PER_POINT;
 
+/// Returns the compiled-in metric table for the face of fontInfo, or nullptr if this build has none.
+const utils::FontMetricTable* builtInTableFor(const musx::dom::FontInfo& fontInfo)
+{
+    if (utils::builtInFontMetricTables().empty()) {
+        return nullptr;
+    }
+    std::string familyName;
+    try {
+        familyName = fontInfo.getName();
+    } catch (...) {
+        return nullptr;
+    }
+    return utils::findFontMetricTable(familyName, fontInfo.bold, fontInfo.italic);
+}
+
+/// The face's ascent and descent at pointSize, from a table, as calcFaceVerticalMetricsEvpu computes them from a face.
+TextMetricsEvpu tableVerticalMetricsEvpu(const utils::FontMetricTable& table, double pointSize)
+{
+    TextMetricsEvpu result;
+    if (table.unitsPerEm > 0) {
+        const double scale = (pointSize > 0.0 ? pointSize : 12.0) / static_cast<double>(table.unitsPerEm) * EVPU_PER_POINT;
+        result.ascent = (std::max)(0.0, table.ascender * scale);
+        result.descent = (std::max)(0.0, -table.descender * scale);
+    }
+    return result;
+}
+
+/// Horizontal proportions of a family, judged from its name, for TextMetricsMode::Heuristic.
+enum class WidthClass
+{
+    Sans,       ///< Helvetica and Arial proportions, the basis of heuristicAdvanceEm
+    Serif,      ///< Times and its relatives set about a tenth narrower
+    Condensed,
+    Wide,       ///< Verdana, Tahoma and other screen or extended faces
+    Monospace,
+    Symbol      ///< music and other symbol fonts, whose glyphs have no Latin proportions
+};
+
+WidthClass widthClassFor(const musx::dom::FontInfo& fontInfo)
+{
+    std::string name;
+    bool isSymbol = false;
+    try {
+        name = utils::normalizedFontName(fontInfo.getName());
+        isSymbol = fontInfo.calcIsSymbolFont();
+    } catch (...) {
+        return WidthClass::Sans;
+    }
+    if (isSymbol || utils::isFinaleLegacyMusicFontMappedToSmufl(name)) {
+        return WidthClass::Symbol;
+    }
+    auto contains = [&name](std::string_view part) { return name.find(part) != std::string::npos; };
+    if (contains("mono") || contains("courier") || contains("consolas") || contains("menlo")) {
+        return WidthClass::Monospace;
+    }
+    if (contains("narrow") || contains("condensed") || contains("compressed")) {
+        return WidthClass::Condensed;
+    }
+    if (contains("verdana") || contains("tahoma") || contains("geneva") || contains("extended") || contains("wide")) {
+        return WidthClass::Wide;
+    }
+    if (contains("times") || contains("georgia") || contains("garamond") || contains("palatino") || contains("bookantiqua")
+        || contains("baskerville") || contains("century") || contains("serif") || contains("cambria")) {
+        return contains("sansserif") ? WidthClass::Sans : WidthClass::Serif;
+    }
+    return WidthClass::Sans;
+}
+
+/// Advance of codePoint in ems, from Helvetica's widths for printable ASCII.
+double heuristicAdvanceEm(char32_t codePoint, WidthClass widthClass)
+{
+    // Helvetica advances in thousandths of an em, ' ' through '~'
+    static constexpr std::uint16_t ASCII_WIDTHS[] = {
+        278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333, 278, 278,
+        556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278, 584, 584, 584, 556,
+        1015, 667, 667, 722, 722, 667, 611, 778, 722, 278, 500, 667, 556, 833, 722, 778,
+        667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 278, 278, 278, 469, 556,
+        333, 556, 556, 500, 556, 556, 278, 556, 556, 222, 222, 500, 222, 833, 556, 556,
+        556, 556, 333, 500, 278, 556, 500, 722, 500, 500, 500, 334, 260, 334, 584
+    };
+    if (codePoint < U' ' || (codePoint >= 0x0300 && codePoint < 0x0370) || codePoint == 0x200B) {
+        return 0.0; // controls, combining marks and zero-width space
+    }
+    if (widthClass == WidthClass::Monospace) {
+        return 0.6;
+    }
+    if (widthClass == WidthClass::Symbol) {
+        return 0.5;
+    }
+    if ((codePoint >= 0x2E80 && codePoint < 0xA000) || (codePoint >= 0xAC00 && codePoint < 0xD7A4)
+        || (codePoint >= 0xF900 && codePoint < 0xFB00) || (codePoint >= 0xFF00 && codePoint < 0xFF61)) {
+        return 1.0; // CJK and full-width forms are square in every class
+    }
+    double width = codePoint <= U'~' ? ASCII_WIDTHS[codePoint - U' '] / 1000.0 : 0.556;
+    switch (widthClass) {
+    case WidthClass::Serif:
+        width *= 0.9;
+        break;
+    case WidthClass::Condensed:
+        width *= 0.82;
+        break;
+    case WidthClass::Wide:
+        width *= 1.12;
+        break;
+    default:
+        break;
+    }
+    return width;
+}
+
+double heuristicEmEvpu(const musx::dom::FontInfo& fontInfo, std::optional<double> pointSizeOverride)
+{
+    const double pointSize = pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize));
+    return (pointSize > 0.0 ? pointSize : 12.0) * EVPU_PER_POINT;
+}
+
+/// Estimates text the way measureTextWithTable measures it: advance of the longest line, ink above and below.
+TextMetricsEvpu heuristicTextMetricsEvpu(const musx::dom::FontInfo& fontInfo, std::u32string_view text,
+                                         std::optional<double> pointSizeOverride)
+{
+    const WidthClass widthClass = widthClassFor(fontInfo);
+    const double em = heuristicEmEvpu(fontInfo, pointSizeOverride);
+    TextMetricsEvpu result;
+    double lineAdvance = 0.0;
+    bool hasInk = false;
+    bool hasDescender = false;
+    for (const char32_t codePoint : text) {
+        if (codePoint == U'\n' || codePoint == U'\r') {
+            result.advance = (std::max)(result.advance, lineAdvance);
+            lineAdvance = 0.0;
+            continue;
+        }
+        lineAdvance += heuristicAdvanceEm(codePoint, widthClass) * em;
+        hasInk = hasInk || (codePoint > U' ' && codePoint != 0x00A0);
+        hasDescender = hasDescender || std::u32string_view(U"gjpqy,;()[]{}|_$@Q").find(codePoint) != std::u32string_view::npos;
+    }
+    result.advance = (std::max)(result.advance, lineAdvance);
+    if (hasInk) {
+        result.ascent = (widthClass == WidthClass::Symbol ? 0.5 : 0.73) * em;
+        result.descent = (widthClass == WidthClass::Symbol ? 0.5 : (hasDescender ? 0.21 : 0.0)) * em;
+    }
+    return result;
+}
+
+/// Estimates the face's ascent and descent (its line spacing, not the ink of any text).
+TextMetricsEvpu heuristicVerticalMetricsEvpu(const musx::dom::FontInfo& fontInfo, std::optional<double> pointSizeOverride)
+{
+    const double em = heuristicEmEvpu(fontInfo, pointSizeOverride);
+    TextMetricsEvpu result;
+    result.ascent = 0.905 * em;
+    result.descent = 0.212 * em;
+    return result;
+}
+
+#if defined(DENIGMA_USE_FREETYPE)
+
 struct ResolvedFace
 {
     std::string filePath;
@@ -126,6 +288,351 @@ struct IndexedFace
     bool italic{};
 };
 
+struct ResolveKey
+{
+    std::string familyName;
+    bool bold{};
+    bool italic{};
+
+    bool operator==(const ResolveKey& other) const
+    {
+        return bold == other.bold && italic == other.italic && familyName == other.familyName;
+    }
+};
+
+struct ResolveKeyHash
+{
+    std::size_t operator()(const ResolveKey& value) const
+    {
+        return std::hash<std::string>()(value.familyName) ^ (static_cast<std::size_t>(value.bold) << 1) ^ (static_cast<std::size_t>(value.italic) << 2);
+    }
+};
+
+/// Glyph metrics as loaded by measureText, in 26.6 units at the owning cache's character size.
+struct CachedGlyph
+{
+    FT_UInt glyphIndex{};
+    bool loaded{};
+    FT_Pos horiBearingX{};
+    FT_Pos horiBearingY{};
+    FT_Pos width{};
+    FT_Pos height{};
+    FT_Fixed linearHoriAdvance{};
+};
+
+struct U32StringHash
+{
+    using is_transparent = void;
+
+    std::size_t operator()(std::u32string_view value) const
+    {
+        return std::hash<std::u32string_view>()(value);
+    }
+};
+
+/// Measurement results for one face at one character size. Expression and lyric strings repeat heavily
+/// within a score, so whole strings are cached as well as individual glyphs and kerning pairs.
+struct SizedFaceMetrics
+{
+    /// Bounds the whole-string cache; it is simply cleared when full.
+    static constexpr std::size_t MAX_CACHED_STRINGS = 4096;
+
+    std::unordered_map<char32_t, CachedGlyph> glyphs;
+    std::unordered_map<std::uint64_t, FT_Pos> kerning;  ///< keyed by (left glyph << 32) | right glyph
+    std::unordered_map<std::u32string, TextMetricsEvpu, U32StringHash, std::equal_to<>> strings;
+};
+
+/// The face handed to measurement code: this thread's FT_Face, already set to the requested size,
+/// and the metrics cache for that size.
+struct SizedFace
+{
+    FT_Face face{};
+    SizedFaceMetrics* metrics{};
+};
+
+/// FreeType libraries and the faces created from them must not be used by two threads at once,
+/// so each thread measures with its own library and faces. Nothing here is shared, so no locking is needed.
+class ThreadFaceCache
+{
+public:
+    ThreadFaceCache()
+    {
+        if (FT_Init_FreeType(&m_library) != 0) {
+            m_library = nullptr;
+        }
+    }
+
+    ~ThreadFaceCache()
+    {
+        for (auto& it : m_faces) {
+            if (it.second.face) {
+                FT_Done_Face(it.second.face);
+            }
+        }
+        if (m_library) {
+            FT_Done_FreeType(m_library);
+        }
+    }
+
+    ThreadFaceCache(const ThreadFaceCache&) = delete;
+    ThreadFaceCache& operator=(const ThreadFaceCache&) = delete;
+
+    struct OpenFace
+    {
+        FT_Face face{};
+        FT_F26Dot6 charSize{};  ///< size last passed to FT_Set_Char_Size, or 0 if none
+        std::unordered_map<FT_F26Dot6, SizedFaceMetrics> sizes;
+    };
+
+    /// Returns this thread's face for key, opening it on first use, or nullptr if it cannot be opened.
+    /// The face stays open, at the same address, for the life of the thread.
+    OpenFace* open(const FaceKey& key)
+    {
+        auto cacheIt = m_faces.find(key);
+        if (cacheIt == m_faces.end()) {
+            FT_Face face = nullptr;
+            if (!m_library || FT_New_Face(m_library, key.filePath.c_str(), key.faceIndex, &face) != 0 || !face) {
+                return nullptr;
+            }
+            cacheIt = m_faces.emplace(key, OpenFace{ face, 0, {} }).first;
+        }
+        return &cacheIt->second;
+    }
+
+    /// Returns openFace set to size26d6, or std::nullopt if it cannot be sized.
+    static std::optional<SizedFace> sized(OpenFace& openFace, FT_F26Dot6 size26d6)
+    {
+        if (openFace.charSize != size26d6) {
+            if (FT_Set_Char_Size(openFace.face, 0, size26d6, 72, 72) != 0) {
+                openFace.charSize = 0;
+                return std::nullopt;
+            }
+            openFace.charSize = size26d6;
+        }
+        return SizedFace{ openFace.face, &openFace.sizes[size26d6] };
+    }
+
+    /// @brief Returns the face this thread last resolved for fontInfo's font id and effects.
+    ///
+    /// Font ids only identify a font within their document, so the memo starts over whenever a font of another
+    /// document is measured; a document that has since been destroyed never matches, even at the same address.
+    /// @return std::nullopt if fontInfo has not been resolved, otherwise its face (nullptr if it could not be opened).
+    std::optional<OpenFace*> findFontInfoFace(const musx::dom::FontInfo& fontInfo)
+    {
+        const auto document = fontInfo.getDocument();
+        if (!document || m_fontInfoDocument.owner_before(document) || document.owner_before(m_fontInfoDocument)) {
+            return std::nullopt;
+        }
+        if (const auto it = m_fontInfoFaces.find(fontInfoKey(fontInfo)); it != m_fontInfoFaces.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    /// Records openFace as the face of fontInfo's font id and effects for findFontInfoFace.
+    void rememberFontInfoFace(const musx::dom::FontInfo& fontInfo, OpenFace* openFace)
+    {
+        const auto document = fontInfo.getDocument();
+        if (!document) {
+            return;
+        }
+        if (m_fontInfoDocument.owner_before(document) || document.owner_before(m_fontInfoDocument)) {
+            m_fontInfoDocument = document;
+            m_fontInfoFaces.clear();
+        }
+        m_fontInfoFaces[fontInfoKey(fontInfo)] = openFace;
+    }
+
+private:
+    static std::uint32_t fontInfoKey(const musx::dom::FontInfo& fontInfo)
+    {
+        return static_cast<std::uint32_t>(fontInfo.fontId) | (fontInfo.bold ? 1u << 16 : 0u) | (fontInfo.italic ? 1u << 17 : 0u);
+    }
+
+    FT_Library m_library{};
+    std::unordered_map<FaceKey, OpenFace, FaceKeyHash> m_faces;
+    std::weak_ptr<const musx::dom::Document> m_fontInfoDocument;
+    std::unordered_map<std::uint32_t, OpenFace*> m_fontInfoFaces;
+};
+
+ThreadFaceCache& threadFaceCache()
+{
+    thread_local ThreadFaceCache cache;
+    return cache;
+}
+
+/// The character size, in 26.6 points, a face is set to for pointSize.
+std::int64_t charSize26d6(double pointSize)
+{
+    return std::llround((pointSize > 0.0 ? pointSize : 12.0) * 64.0);
+}
+
+/// On-disk snapshot of the font index, so later processes can skip probing every font file with FreeType.
+struct FontIndexCache
+{
+    struct FontFile
+    {
+        long long modified{};
+        std::uintmax_t size{};
+        std::vector<IndexedFace> faces;
+    };
+
+    std::vector<std::string> roots;                          ///< candidate font directories, in search order
+    std::vector<std::pair<std::string, long long>> directories;  ///< every directory walked, with its modification time
+    std::unordered_map<std::string, FontFile> files;         ///< keyed by UTF-8 file path
+};
+
+constexpr std::string_view FONT_INDEX_CACHE_HEADER = "denigma-font-index\t1";
+
+std::optional<long long> modificationTime(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    const auto modified = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return static_cast<long long>(modified.time_since_epoch().count());
+}
+
+/// Returns the cache file location, or std::nullopt when caching is disabled.
+/// DENIGMA_FONT_INDEX_CACHE overrides the location; setting it to an empty value disables the cache.
+std::optional<std::filesystem::path> fontIndexCachePath()
+{
+    if (const auto overridePath = utils::getEnvironmentValue("DENIGMA_FONT_INDEX_CACHE")) {
+        if (overridePath->empty()) {
+            return std::nullopt;
+        }
+        return utils::utf8ToPath(*overridePath);
+    }
+    std::filesystem::path cacheDir;
+#if defined(MUSX_RUNNING_ON_MACOS)
+    if (const auto home = utils::getEnvironmentValue("HOME")) {
+        cacheDir = utils::utf8ToPath(*home) / "Library/Caches";
+    }
+#elif defined(MUSX_RUNNING_ON_WINDOWS)
+    if (const auto localAppData = utils::getEnvironmentValue("LOCALAPPDATA")) {
+        cacheDir = utils::utf8ToPath(*localAppData);
+    }
+#else
+    if (const auto xdgCache = utils::getEnvironmentValue("XDG_CACHE_HOME"); xdgCache && !xdgCache->empty()) {
+        cacheDir = utils::utf8ToPath(*xdgCache);
+    } else if (const auto home = utils::getEnvironmentValue("HOME")) {
+        cacheDir = utils::utf8ToPath(*home) / ".cache";
+    }
+#endif
+    if (cacheDir.empty()) {
+        return std::nullopt;
+    }
+    return cacheDir / "denigma" / "font-index.txt";
+}
+
+std::vector<std::string_view> splitTabs(std::string_view line)
+{
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while (true) {
+        const size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string_view::npos ? std::string_view::npos : tab - start));
+        if (tab == std::string_view::npos) {
+            break;
+        }
+        start = tab + 1;
+    }
+    return fields;
+}
+
+/// Loads a cache written by saveFontIndexCache. Returns an empty cache if the file is missing or malformed.
+FontIndexCache loadFontIndexCache(const std::filesystem::path& cachePath)
+{
+    FontIndexCache cache;
+    std::ifstream input(cachePath, std::ios::in | std::ios::binary);
+    std::string line;
+    if (!input || !std::getline(input, line) || line != FONT_INDEX_CACHE_HEADER) {
+        return {};
+    }
+    FontIndexCache::FontFile* currentFile = nullptr;
+    std::string currentPath;
+    try {
+        while (std::getline(input, line)) {
+            const auto fields = splitTabs(line);
+            if (fields[0] == "R" && fields.size() == 2) {
+                cache.roots.emplace_back(fields[1]);
+            } else if (fields[0] == "D" && fields.size() == 3) {
+                cache.directories.emplace_back(std::string(fields[2]), std::stoll(std::string(fields[1])));
+            } else if (fields[0] == "F" && fields.size() == 4) {
+                currentPath = std::string(fields[3]);
+                FontIndexCache::FontFile file;
+                file.modified = std::stoll(std::string(fields[1]));
+                file.size = static_cast<std::uintmax_t>(std::stoull(std::string(fields[2])));
+                currentFile = &cache.files.insert_or_assign(currentPath, std::move(file)).first->second;
+            } else if (fields[0] == "X" && fields.size() == 5 && currentFile) {
+                currentFile->faces.push_back(IndexedFace{
+                    ResolvedFace{ currentPath, std::stoi(std::string(fields[1])) },
+                    std::string(fields[4]),
+                    fields[2] == "1",
+                    fields[3] == "1"
+                });
+            } else {
+                return {};
+            }
+        }
+    } catch (const std::exception&) {
+        return {};
+    }
+    return cache;
+}
+
+/// Writes the cache to a temporary file and renames it into place. Failures leave any previous cache untouched.
+void saveFontIndexCache(const std::filesystem::path& cachePath, const FontIndexCache& cache)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(cachePath.parent_path(), ec);
+    auto tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream output(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!output) {
+            return;
+        }
+        output << FONT_INDEX_CACHE_HEADER << '\n';
+        for (const auto& root : cache.roots) {
+            output << "R\t" << root << '\n';
+        }
+        for (const auto& [path, modified] : cache.directories) {
+            output << "D\t" << modified << '\t' << path << '\n';
+        }
+        for (const auto& [path, file] : cache.files) {
+            output << "F\t" << file.modified << '\t' << file.size << '\t' << path << '\n';
+            for (const auto& face : file.faces) {
+                output << "X\t" << face.resolved.faceIndex << '\t' << (face.bold ? 1 : 0) << '\t' << (face.italic ? 1 : 0)
+                       << '\t' << face.familyNormalized << '\n';
+            }
+        }
+        if (!output.flush()) {
+            output.close();
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+/// The cache is trusted without walking the font directories when the search roots are unchanged and
+/// no walked directory has been modified since it was written. Fonts added, removed or renamed in place
+/// change their directory's modification time.
+bool fontIndexCacheIsCurrent(const FontIndexCache& cache, const std::vector<std::string>& roots)
+{
+    if (cache.roots != roots || cache.directories.empty()) {
+        return false;
+    }
+    return std::all_of(cache.directories.begin(), cache.directories.end(), [](const auto& directory) {
+        return modificationTime(utils::utf8ToPath(directory.first)) == directory.second;
+    });
+}
+
 class FreeTypeTextMetricsBackend
 {
 public:
@@ -134,37 +641,144 @@ public:
         if (FT_Init_FreeType(&m_library) == 0) {
             m_initialized = true;
         }
-#if defined(DENIGMA_USE_FONTCONFIG)
-        m_fontconfigAvailable = FcInit() != FcFalse;
-#endif
     }
 
     ~FreeTypeTextMetricsBackend()
     {
-        std::scoped_lock<std::mutex> lock(m_mutex);
-        for (auto& it : m_faces) {
-            if (it.second) {
-                FT_Done_Face(it.second);
-            }
-        }
         if (m_library) {
             FT_Done_FreeType(m_library);
         }
     }
 
+    void warmUp()
+    {
+        if (!m_initialized) {
+            return;
+        }
+        std::unique_lock<std::shared_mutex> lock(m_resolveMutex);
+        ensureIndexBuiltLocked();
+    }
+
     std::optional<TextMetricsEvpu> measureText(const musx::dom::FontInfo& fontInfo,
                                                std::u32string_view text,
                                                std::optional<double> pointSizeOverride,
                                                const DenigmaContext& denigmaContext)
     {
-        std::scoped_lock<std::mutex> lock(m_mutex);
         const double pointSize = pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize));
-        auto face = resolveFaceLocked(fontInfo,
-                                      pointSize,
-                                      denigmaContext);
+        auto* diskCache = textMetricsDiskCache();
+        const auto fontFile = diskCache ? resolveFontFile(fontInfo, denigmaContext) : std::nullopt;
+        const auto diskKey = fontFile ? std::optional(fontFile->diskKey(DiskCachedMeasurement::Text, pointSize, text)) : std::nullopt;
+        if (diskKey) {
+            if (auto cached = diskCache->find(*diskKey)) {
+                return cached;
+            }
+        }
+        auto face = resolveFace(fontInfo,
+                                pointSize,
+                                denigmaContext);
         if (!face) {
             return std::nullopt;
         }
+        const auto result = measureTextOnFace(*face, text, pointSize);
+        if (diskKey) {
+            diskCache->insert(*diskKey, result);
+        }
+        return result;
+    }
+
+    std::optional<GlyphRunMetricsEvpu> measureGlyphRun(const musx::dom::FontInfo& fontInfo,
+                                                       std::u32string_view codePoints,
+                                                       std::optional<double> pointSizeOverride,
+                                                       const DenigmaContext& denigmaContext)
+    {
+        const double pointSize = pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize));
+        auto face = resolveFace(fontInfo,
+                                pointSize,
+                                denigmaContext);
+        if (!face) {
+            return std::nullopt;
+        }
+        GlyphRunMetricsEvpu result;
+        result.glyphs.reserve(codePoints.size());
+        for (std::size_t index = 0; index < codePoints.size(); index++) {
+            result.glyphs.push_back(measureTextOnFace(*face, codePoints.substr(index, 1), pointSize));
+        }
+        result.face = calcFaceVerticalMetricsEvpu(face->face, pointSize);
+        return result;
+    }
+
+    std::optional<double> measureGlyphWidth(const musx::dom::FontInfo& fontInfo,
+                                            char32_t codePoint,
+                                            std::optional<double> pointSizeOverride,
+                                            const DenigmaContext& denigmaContext)
+    {
+        const double pointSize = pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize));
+        auto* diskCache = textMetricsDiskCache();
+        const auto fontFile = diskCache ? resolveFontFile(fontInfo, denigmaContext) : std::nullopt;
+        const auto diskKey = fontFile
+                             ? std::optional(fontFile->diskKey(DiskCachedMeasurement::GlyphWidth, pointSize, std::u32string_view(&codePoint, 1)))
+                             : std::nullopt;
+        if (diskKey) {
+            if (const auto cached = diskCache->find(*diskKey)) {
+                return cached->advance;
+            }
+        }
+        auto face = resolveFace(fontInfo,
+                                pointSize,
+                                denigmaContext);
+        if (!face) {
+            return std::nullopt;
+        }
+
+        const FT_UInt glyphIndex = FT_Get_Char_Index(face->face, static_cast<FT_ULong>(codePoint));
+        if (!glyphIndex) {
+            return std::nullopt;
+        }
+        if (FT_Load_Glyph(face->face, glyphIndex, FT_LOAD_DEFAULT) != 0) {
+            return std::nullopt;
+        }
+        const double width = (std::max)(0.0, static_cast<double>(face->face->glyph->metrics.width) / 64.0 * EVPU_PER_POINT);
+        if (diskKey) {
+            diskCache->insert(*diskKey, TextMetricsEvpu{ width, 0.0, 0.0 });
+        }
+        return width;
+    }
+
+    std::optional<double> measureHeight(const musx::dom::FontInfo& fontInfo,
+                                        double pointSize,
+                                        const DenigmaContext& denigmaContext)
+    {
+        auto face = resolveFace(fontInfo, pointSize, denigmaContext);
+        if (!face) {
+            return std::nullopt;
+        }
+        const auto vertical = calcFaceVerticalMetricsEvpu(face->face, pointSize);
+        return vertical.ascent + vertical.descent;
+    }
+
+    std::optional<TextMetricsEvpu> measureAscentDescent(const musx::dom::FontInfo& fontInfo,
+                                                        std::optional<double> pointSizeOverride,
+                                                        const DenigmaContext& denigmaContext)
+    {
+        const double pointSize = pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize));
+        auto face = resolveFace(fontInfo,
+                                pointSize,
+                                denigmaContext);
+        if (!face) {
+            return std::nullopt;
+        }
+
+        return calcFaceVerticalMetricsEvpu(face->face, pointSize);
+    }
+
+private:
+    /// Measures text on a face already resolved for pointSize, through the face's string and glyph caches.
+    static TextMetricsEvpu measureTextOnFace(SizedFace& face, std::u32string_view text, double pointSize)
+    {
+        auto& stringCache = face.metrics->strings;
+        if (auto cachedIt = stringCache.find(text); cachedIt != stringCache.end()) {
+            return cachedIt->second;
+        }
 
         TextMetricsEvpu result;
         bool hasMeasuredGlyphBounds = false;
@@ -177,27 +791,45 @@ public:
         constexpr FT_Int32 glyphLoadFlags = FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP;
 
         FT_UInt previousGlyph = 0;
-        const bool hasKerning = FT_HAS_KERNING(*face);
+        const bool hasKerning = FT_HAS_KERNING(face.face);
         for (char32_t codePoint : text) {
             if (codePoint == U'\n' || codePoint == U'\r') {
                 previousGlyph = 0;
                 continue;
             }
-            const FT_UInt glyphIndex = FT_Get_Char_Index(*face, static_cast<FT_ULong>(codePoint));
+            auto [glyphIt, glyphInserted] = face.metrics->glyphs.try_emplace(codePoint);
+            CachedGlyph& glyph = glyphIt->second;
+            if (glyphInserted) {
+                glyph.glyphIndex = FT_Get_Char_Index(face.face, static_cast<FT_ULong>(codePoint));
+                if (FT_Load_Glyph(face.face, glyph.glyphIndex, glyphLoadFlags) == 0) {
+                    const auto& glyphMetrics = face.face->glyph->metrics;
+                    glyph.loaded = true;
+                    glyph.horiBearingX = glyphMetrics.horiBearingX;
+                    glyph.horiBearingY = glyphMetrics.horiBearingY;
+                    glyph.width = glyphMetrics.width;
+                    glyph.height = glyphMetrics.height;
+                    glyph.linearHoriAdvance = face.face->glyph->linearHoriAdvance;
+                }
+            }
+            const FT_UInt glyphIndex = glyph.glyphIndex;
             if (hasKerning && previousGlyph && glyphIndex) {
-                FT_Vector kerning{};
-                if (FT_Get_Kerning(*face, previousGlyph, glyphIndex, FT_KERNING_UNFITTED, &kerning) == 0) {
-                    penXEvpu += (static_cast<double>(kerning.x) / 64.0) * EVPU_PER_POINT;
+                const auto pairKey = (static_cast<std::uint64_t>(previousGlyph) << 32) | glyphIndex;
+                auto [kerningIt, kerningInserted] = face.metrics->kerning.try_emplace(pairKey, 0);
+                if (kerningInserted) {
+                    FT_Vector kerning{};
+                    if (FT_Get_Kerning(face.face, previousGlyph, glyphIndex, FT_KERNING_UNFITTED, &kerning) == 0) {
+                        kerningIt->second = kerning.x;
+                    }
                 }
+                penXEvpu += (static_cast<double>(kerningIt->second) / 64.0) * EVPU_PER_POINT;
             }
-            if (FT_Load_Glyph(*face, glyphIndex, glyphLoadFlags) == 0) {
+            if (glyph.loaded) {
                 loadedAnyGlyph = true;
-                const auto& glyphMetrics = (*face)->glyph->metrics;
-                const double glyphMinX = penXEvpu + (static_cast<double>(glyphMetrics.horiBearingX) / 64.0) * EVPU_PER_POINT;
-                const double glyphMaxX = glyphMinX + (static_cast<double>(glyphMetrics.width) / 64.0) * EVPU_PER_POINT;
-                const double glyphMaxY = (static_cast<double>(glyphMetrics.horiBearingY) / 64.0) * EVPU_PER_POINT;
-                const double glyphMinY = glyphMaxY - (static_cast<double>(glyphMetrics.height) / 64.0) * EVPU_PER_POINT;
-                if (glyphMetrics.width > 0 || glyphMetrics.height > 0) {
+                const double glyphMinX = penXEvpu + (static_cast<double>(glyph.horiBearingX) / 64.0) * EVPU_PER_POINT;
+                const double glyphMaxX = glyphMinX + (static_cast<double>(glyph.width) / 64.0) * EVPU_PER_POINT;
+                const double glyphMaxY = (static_cast<double>(glyph.horiBearingY) / 64.0) * EVPU_PER_POINT;
+                const double glyphMinY = glyphMaxY - (static_cast<double>(glyph.height) / 64.0) * EVPU_PER_POINT;
+                if (glyph.width > 0 || glyph.height > 0) {
                     if (!hasMeasuredGlyphBounds) {
                         boundsMinXEvpu = glyphMinX;
                         boundsMaxXEvpu = glyphMaxX;
@@ -211,7 +843,7 @@ public:
                         boundsMaxYEvpu = (std::max)(boundsMaxYEvpu, glyphMaxY);
                     }
                 }
-                penXEvpu += (static_cast<double>((*face)->glyph->linearHoriAdvance) / 65536.0) * EVPU_PER_POINT;
+                penXEvpu += (static_cast<double>(glyph.linearHoriAdvance) / 65536.0) * EVPU_PER_POINT;
             }
             previousGlyph = glyphIndex;
         }
@@ -225,67 +857,18 @@ public:
             result.advance = (std::max)(0.0, penXEvpu);
         } else if (!text.empty()) {
             // Fallback only when glyph loading failed for the whole run.
-            const auto vertical = calcFaceVerticalMetricsEvpu(*face, pointSize);
+            const auto vertical = calcFaceVerticalMetricsEvpu(face.face, pointSize);
             result.ascent = vertical.ascent;
             result.descent = vertical.descent;
         }
 
-        return result;
-    }
-
-    std::optional<double> measureGlyphWidth(const musx::dom::FontInfo& fontInfo,
-                                            char32_t codePoint,
-                                            std::optional<double> pointSizeOverride,
-                                            const DenigmaContext& denigmaContext)
-    {
-        std::scoped_lock<std::mutex> lock(m_mutex);
-        auto face = resolveFaceLocked(fontInfo,
-                                      pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize)),
-                                      denigmaContext);
-        if (!face) {
-            return std::nullopt;
-        }
-
-        const FT_UInt glyphIndex = FT_Get_Char_Index(*face, static_cast<FT_ULong>(codePoint));
-        if (!glyphIndex) {
-            return std::nullopt;
-        }
-        if (FT_Load_Glyph(*face, glyphIndex, FT_LOAD_DEFAULT) != 0) {
-            return std::nullopt;
+        if (stringCache.size() >= SizedFaceMetrics::MAX_CACHED_STRINGS) {
+            stringCache.clear();
         }
-        return (std::max)(0.0, static_cast<double>((*face)->glyph->metrics.width) / 64.0 * EVPU_PER_POINT);
-    }
-
-    std::optional<double> measureHeight(const musx::dom::FontInfo& fontInfo,
-                                        double pointSize,
-                                        const DenigmaContext& denigmaContext)
-    {
-        std::scoped_lock<std::mutex> lock(m_mutex);
-        auto face = resolveFaceLocked(fontInfo, pointSize, denigmaContext);
-        if (!face) {
-            return std::nullopt;
-        }
-        const auto vertical = calcFaceVerticalMetricsEvpu(*face, pointSize);
-        return vertical.ascent + vertical.descent;
-    }
-
-    std::optional<TextMetricsEvpu> measureAscentDescent(const musx::dom::FontInfo& fontInfo,
-                                                        std::optional<double> pointSizeOverride,
-                                                        const DenigmaContext& denigmaContext)
-    {
-        std::scoped_lock<std::mutex> lock(m_mutex);
-        const double pointSize = pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize));
-        auto face = resolveFaceLocked(fontInfo,
-                                      pointSize,
-                                      denigmaContext);
-        if (!face) {
-            return std::nullopt;
-        }
-
-        return calcFaceVerticalMetricsEvpu(*face, pointSize);
+        stringCache.emplace(std::u32string(text), result);
+        return result;
     }
 
-private:
     static TextMetricsEvpu calcFaceVerticalMetricsEvpu(FT_Face face, double pointSize)
     {
         TextMetricsEvpu result;
@@ -319,8 +902,9 @@ private:
         }
     }
 
-    void warnBackendUnavailableLocked(const DenigmaContext& denigmaContext)
+    void warnBackendUnavailable(const DenigmaContext& denigmaContext)
     {
+        std::scoped_lock<std::mutex> lock(m_warningMutex);
         if (m_warnedBackendUnavailable) {
             return;
         }
@@ -329,8 +913,9 @@ private:
                                   MessageSeverity::Warning);
     }
 
-    void warnUnresolvedFamilyLocked(const DenigmaContext& denigmaContext, const std::string& familyName)
+    void warnUnresolvedFamily(const DenigmaContext& denigmaContext, const std::string& familyName)
     {
+        std::scoped_lock<std::mutex> lock(m_warningMutex);
         const std::string key = familyName.empty() ? std::string("<unknown font>") : familyName;
         if (!m_warnedUnresolvedFamilies.insert(key).second) {
             return;
@@ -392,7 +977,7 @@ private:
         return ext == u8".ttf" || ext == u8".otf" || ext == u8".ttc" || ext == u8".otc" || ext == u8".pfa" || ext == u8".pfb";
     }
 
-    void indexFontFaceLocked(const std::filesystem::path& filePath, long faceIndex)
+    void indexFontFaceLocked(const std::filesystem::path& filePath, long faceIndex, std::vector<IndexedFace>& faces)
     {
         FT_Face face = nullptr;
         const auto fontPathUtf8 = filePath.u8string();
@@ -405,7 +990,7 @@ private:
         const bool bold = (face->style_flags & FT_STYLE_FLAG_BOLD) != 0 || styleLooksBold(style);
         const bool italic = (face->style_flags & FT_STYLE_FLAG_ITALIC) != 0 || styleLooksItalic(style);
 
-        m_faceIndex.push_back(IndexedFace{
+        faces.push_back(IndexedFace{
             ResolvedFace{ utils::utf8ToString(fontPathUtf8), static_cast<int>(faceIndex) },
             utils::normalizedFontName(family),
             bold,
@@ -415,12 +1000,8 @@ private:
         FT_Done_Face(face);
     }
 
-    void indexFontFileLocked(const std::filesystem::path& filePath)
+    void indexFontFileLocked(const std::filesystem::path& filePath, std::vector<IndexedFace>& faces)
     {
-        if (!hasSupportedExtension(filePath)) {
-            return;
-        }
-
         FT_Face probeFace = nullptr;
         const auto fontPathUtf8 = filePath.u8string();
         if (FT_New_Face(m_library, reinterpret_cast<const char*>(fontPathUtf8.c_str()), 0, &probeFace) != 0 || !probeFace) {
@@ -430,7 +1011,7 @@ private:
         FT_Done_Face(probeFace);
 
         for (long faceIndex = 0; faceIndex < numFaces; ++faceIndex) {
-            indexFontFaceLocked(filePath, faceIndex);
+            indexFontFaceLocked(filePath, faceIndex, faces);
         }
     }
 
@@ -441,18 +1022,61 @@ private:
         }
         m_indexBuilt = true;
         const auto dirs = candidateFontDirectories();
+        std::vector<std::string> roots;
+        roots.reserve(dirs.size());
         for (const auto& dir : dirs) {
+            roots.push_back(utils::utf8ToString(dir.u8string()));
+        }
+
+        const auto cachePath = fontIndexCachePath();
+        const FontIndexCache cached = cachePath ? loadFontIndexCache(*cachePath) : FontIndexCache{};
+        if (fontIndexCacheIsCurrent(cached, roots)) {
+            for (const auto& [path, file] : cached.files) {
+                m_faceIndex.insert(m_faceIndex.end(), file.faces.begin(), file.faces.end());
+            }
+            return;
+        }
+
+        // Walk the directories, reusing cached faces for files whose size and modification time are unchanged.
+        FontIndexCache updated;
+        updated.roots = roots;
+        for (const auto& dir : dirs) {
+            if (const auto modified = modificationTime(dir)) {
+                updated.directories.emplace_back(utils::utf8ToString(dir.u8string()), *modified);
+            }
             std::error_code ec;
             std::filesystem::recursive_directory_iterator it(dir, ec);
             if (ec) {
                 continue;
             }
             for (const auto& entry : it) {
-                if (entry.is_regular_file(ec)) {
-                    indexFontFileLocked(entry.path());
+                if (entry.is_directory(ec)) {
+                    if (const auto modified = modificationTime(entry.path())) {
+                        updated.directories.emplace_back(utils::utf8ToString(entry.path().u8string()), *modified);
+                    }
+                    continue;
+                }
+                if (!entry.is_regular_file(ec) || !hasSupportedExtension(entry.path())) {
+                    continue;
                 }
+                const auto path = utils::utf8ToString(entry.path().u8string());
+                FontIndexCache::FontFile file;
+                file.modified = modificationTime(entry.path()).value_or(0);
+                file.size = entry.file_size(ec);
+                const auto cachedIt = cached.files.find(path);
+                if (cachedIt != cached.files.end()
+                    && std::tie(cachedIt->second.modified, cachedIt->second.size) == std::tie(file.modified, file.size)) {
+                    file.faces = cachedIt->second.faces;
+                } else {
+                    indexFontFileLocked(entry.path(), file.faces);
+                }
+                m_faceIndex.insert(m_faceIndex.end(), file.faces.begin(), file.faces.end());
+                updated.files.emplace(path, std::move(file));
             }
         }
+        if (cachePath) {
+            saveFontIndexCache(*cachePath, updated);
+        }
     }
 
 #if defined(DENIGMA_USE_FONTCONFIG)
@@ -460,7 +1084,12 @@ private:
                                                             bool bold,
                                                             bool italic) const
     {
+        // loading the fontconfig configuration is a noticeable part of a short run, so it waits for the first
+        // family that has to be looked up rather than being done when the backend is created
         if (!m_fontconfigAvailable) {
+            m_fontconfigAvailable = FcInit() != FcFalse;
+        }
+        if (!*m_fontconfigAvailable) {
             return std::nullopt;
         }
         FcPattern* pattern = FcPatternCreate();
@@ -986,68 +1615,157 @@ private:
         return bestMatch;
     }
 
-    std::optional<FT_Face> resolveFaceLocked(const musx::dom::FontInfo& fontInfo,
-                                             double pointSize,
-                                             const DenigmaContext& denigmaContext)
+    /// Returns the shared resolution of a family/style to a font file, resolving it on first request.
+    std::optional<ResolvedFace> resolveFamily(const std::string& familyName, bool bold, bool italic, const DenigmaContext& denigmaContext)
+    {
+        ResolveKey key{ familyName, bold, italic };
+        {
+            std::shared_lock<std::shared_mutex> lock(m_resolveMutex);
+            if (auto it = m_resolvedFaces.find(key); it != m_resolvedFaces.end()) {
+                return it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(m_resolveMutex);
+        if (auto it = m_resolvedFaces.find(key); it != m_resolvedFaces.end()) {
+            return it->second;
+        }
+        auto resolved = resolveWithNativeLocked(familyName, bold, italic);
+        if (!resolved) {
+            resolved = resolveWithIndexLocked(familyName, bold, italic);
+        }
+        if (!resolved) {
+            warnUnresolvedFamily(denigmaContext, familyName);
+        }
+        m_resolvedFaces.emplace(std::move(key), resolved);
+        return resolved;
+    }
+
+    /// The font file fontInfo resolves to, as the persistent measurement cache identifies it.
+    struct FontFile
+    {
+        ResolvedFace resolved;
+        long long modified{};
+        std::uintmax_t size{};
+
+        TextMetricsDiskKey diskKey(DiskCachedMeasurement measurement, double pointSize, std::u32string_view text) const
+        {
+            return TextMetricsDiskKey{ measurement, resolved.filePath, resolved.faceIndex, modified,
+                                       static_cast<std::uint64_t>(size), charSize26d6(pointSize), text };
+        }
+    };
+
+    /// Resolves fontInfo to its font file without opening a face, so that measurements found in the persistent
+    /// cache need no FreeType work. Each file's size and modification time are read once per process.
+    std::optional<FontFile> resolveFontFile(const musx::dom::FontInfo& fontInfo, const DenigmaContext& denigmaContext)
     {
         if (!m_initialized || !m_library) {
-            warnBackendUnavailableLocked(denigmaContext);
             return std::nullopt;
         }
-
         std::string familyName;
         try {
             familyName = fontInfo.getName();
         } catch (...) {
-            familyName.clear();
+            return std::nullopt;
         }
         if (familyName.empty()) {
-            warnUnresolvedFamilyLocked(denigmaContext, familyName);
             return std::nullopt;
         }
-
-        auto resolved = resolveWithNativeLocked(familyName, fontInfo.bold, fontInfo.italic);
+        const auto resolved = resolveFamily(familyName, fontInfo.bold, fontInfo.italic, denigmaContext);
         if (!resolved) {
-            resolved = resolveWithIndexLocked(familyName, fontInfo.bold, fontInfo.italic);
+            return std::nullopt;
         }
-        if (!resolved) {
-            warnUnresolvedFamilyLocked(denigmaContext, familyName);
+        std::scoped_lock<std::mutex> lock(m_fontFileMutex);
+        auto [it, inserted] = m_fontFileStamps.try_emplace(resolved->filePath);
+        if (inserted) {
+            const auto path = utils::utf8ToPath(resolved->filePath);
+            std::error_code ec;
+            const auto size = std::filesystem::file_size(path, ec);
+            const auto modified = modificationTime(path);
+            if (!ec && modified) {
+                it->second = std::make_pair(*modified, static_cast<std::uintmax_t>(size));
+            }
+        }
+        if (!it->second) {
             return std::nullopt;
         }
+        return FontFile{ *resolved, it->second->first, it->second->second };
+    }
 
-        const FaceKey key{ resolved->filePath, resolved->faceIndex };
-        FT_Face face = nullptr;
-        auto cacheIt = m_faces.find(key);
-        if (cacheIt == m_faces.end()) {
-            if (FT_New_Face(m_library, resolved->filePath.c_str(), resolved->faceIndex, &face) != 0 || !face) {
-                warnUnresolvedFamilyLocked(denigmaContext, familyName);
-                return std::nullopt;
+    /// Resolves the face fontInfo is measured on; without one the caller falls back to heuristic metrics.
+    std::optional<SizedFace> resolveFace(const musx::dom::FontInfo& fontInfo,
+                                       double pointSize,
+                                       const DenigmaContext& denigmaContext)
+    {
+        auto result = resolveFaceUncounted(fontInfo, pointSize, denigmaContext);
+        if (!result) {
+            denigmaContext.countHotPath(ConversionStats::HotPath::TextMetricsFallback);
+        }
+        return result;
+    }
+
+    std::optional<SizedFace> resolveFaceUncounted(const musx::dom::FontInfo& fontInfo,
+                                                double pointSize,
+                                                const DenigmaContext& denigmaContext)
+    {
+        if (!m_initialized || !m_library) {
+            warnBackendUnavailable(denigmaContext);
+            return std::nullopt;
+        }
+
+        const auto size26d6 = static_cast<FT_F26Dot6>(charSize26d6(pointSize));
+        auto& faces = threadFaceCache();
+        if (const auto remembered = faces.findFontInfoFace(fontInfo)) {
+            if (!*remembered) {
+                return std::nullopt; // already warned when it first failed
             }
-            cacheIt = m_faces.emplace(key, face).first;
-        } else {
-            face = cacheIt->second;
+            return ThreadFaceCache::sized(**remembered, size26d6);
         }
 
-        const double sizePoints = pointSize > 0.0 ? pointSize : 12.0;
-        const auto size26d6 = static_cast<FT_F26Dot6>(std::llround(sizePoints * 64.0));
-        if (FT_Set_Char_Size(face, 0, size26d6, 72, 72) != 0) {
+        std::string familyName;
+        try {
+            familyName = fontInfo.getName();
+        } catch (...) {
+            familyName.clear();
+        }
+        if (familyName.empty()) {
+            warnUnresolvedFamily(denigmaContext, familyName);
+            return std::nullopt;
+        }
+
+        const auto resolved = resolveFamily(familyName, fontInfo.bold, fontInfo.italic, denigmaContext);
+        if (!resolved) {
+            faces.rememberFontInfoFace(fontInfo, nullptr);
             return std::nullopt;
         }
+
+        auto* openFace = faces.open(FaceKey{ resolved->filePath, resolved->faceIndex });
+        faces.rememberFontInfoFace(fontInfo, openFace);
+        auto face = openFace ? ThreadFaceCache::sized(*openFace, size26d6) : std::nullopt;
+        if (!face) {
+            warnUnresolvedFamily(denigmaContext, familyName);
+        }
         return face;
     }
 
-    mutable std::mutex m_mutex;
+    // m_library is only used for resolution and indexing, under an exclusive m_resolveMutex lock.
+    // Measurement uses the calling thread's ThreadFaceCache.
+    std::shared_mutex m_resolveMutex;
     FT_Library m_library{};
     bool m_initialized{};
+    std::unordered_map<ResolveKey, std::optional<ResolvedFace>, ResolveKeyHash> m_resolvedFaces;
+
+    std::mutex m_fontFileMutex;
+    std::unordered_map<std::string, std::optional<std::pair<long long, std::uintmax_t>>> m_fontFileStamps;  ///< modified, size
+
+    std::mutex m_warningMutex;
     bool m_warnedBackendUnavailable{};
     std::unordered_set<std::string> m_warnedUnresolvedFamilies;
-    std::unordered_map<FaceKey, FT_Face, FaceKeyHash> m_faces;
 
     bool m_indexBuilt{};
     std::vector<IndexedFace> m_faceIndex;
 
 #if defined(DENIGMA_USE_FONTCONFIG)
-    bool m_fontconfigAvailable{};
+    mutable std::optional<bool> m_fontconfigAvailable; ///< set by the first fontconfig lookup, under m_resolveMutex
 #endif
 };
 
@@ -1066,6 +1784,17 @@ std::optional<TextMetricsEvpu> measureTextEvpu(const musx::dom::FontInfo& fontIn
                                                std::optional<double> pointSizeOverride,
                                                const DenigmaContext& denigmaContext)
 {
+    TraceSpan span("measureTextEvpu");
+    if (const auto* table = builtInTableFor(fontInfo)) {
+        const double pointSize = pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize));
+        if (const auto measured = utils::measureTextWithTable(*table, text, pointSize)) {
+            return TextMetricsEvpu{ measured->advance * EVPU_PER_POINT, measured->ascent * EVPU_PER_POINT,
+                                    measured->descent * EVPU_PER_POINT };
+        }
+    }
+    if (denigmaContext.textMetrics == TextMetricsMode::Heuristic) {
+        return heuristicTextMetricsEvpu(fontInfo, text, pointSizeOverride);
+    }
 #if defined(DENIGMA_USE_FREETYPE)
     return backend().measureText(fontInfo, text, pointSizeOverride, denigmaContext);
 #else
@@ -1082,6 +1811,22 @@ std::optional<double> measureGlyphWidthEvpu(const musx::dom::FontInfo& fontInfo,
                                             std::optional<double> pointSizeOverride,
                                             const DenigmaContext& denigmaContext)
 {
+    TraceSpan span("measureGlyphWidthEvpu");
+    if (const auto* table = builtInTableFor(fontInfo); table && table->unitsPerEm > 0) {
+        if (const auto* glyph = table->findGlyph(codePoint)) {
+            const double pointSize = pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize));
+            const double scale = (pointSize > 0.0 ? pointSize : 12.0) / static_cast<double>(table->unitsPerEm) * EVPU_PER_POINT;
+            return (std::max)(0.0, (glyph->xMax - glyph->xMin) * scale);
+        }
+    }
+    if (denigmaContext.textMetrics == TextMetricsMode::Heuristic) {
+        const WidthClass widthClass = widthClassFor(fontInfo);
+        if (widthClass == WidthClass::Symbol) {
+            return std::nullopt; // a guess at a music glyph is worse than the caller's default
+        }
+        // ink width: the advance less typical side bearings
+        return 0.85 * heuristicAdvanceEm(codePoint, widthClass) * heuristicEmEvpu(fontInfo, pointSizeOverride);
+    }
 #if defined(DENIGMA_USE_FREETYPE)
     return backend().measureGlyphWidth(fontInfo, codePoint, pointSizeOverride, denigmaContext);
 #else
@@ -1097,6 +1842,15 @@ std::optional<double> measureFontHeightEvpu(const musx::dom::FontInfo& fontInfo,
                                             double pointSize,
                                             const DenigmaContext& denigmaContext)
 {
+    TraceSpan span("measureFontHeightEvpu");
+    if (const auto* table = builtInTableFor(fontInfo)) {
+        const auto vertical = tableVerticalMetricsEvpu(*table, pointSize);
+        return vertical.ascent + vertical.descent;
+    }
+    if (denigmaContext.textMetrics == TextMetricsMode::Heuristic) {
+        const auto vertical = heuristicVerticalMetricsEvpu(fontInfo, pointSize);
+        return vertical.ascent + vertical.descent;
+    }
 #if defined(DENIGMA_USE_FREETYPE)
     return backend().measureHeight(fontInfo, pointSize, denigmaContext);
 #else
@@ -1111,6 +1865,13 @@ std::optional<TextMetricsEvpu> measureFontAscentDescentEvpu(const musx::dom::Fon
                                                             std::optional<double> pointSizeOverride,
                                                             const DenigmaContext& denigmaContext)
 {
+    TraceSpan span("measureFontAscentDescentEvpu");
+    if (const auto* table = builtInTableFor(fontInfo)) {
+        return tableVerticalMetricsEvpu(*table, pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize)));
+    }
+    if (denigmaContext.textMetrics == TextMetricsMode::Heuristic) {
+        return heuristicVerticalMetricsEvpu(fontInfo, pointSizeOverride);
+    }
 #if defined(DENIGMA_USE_FREETYPE)
     return backend().measureAscentDescent(fontInfo, pointSizeOverride, denigmaContext);
 #else
@@ -1121,19 +1882,92 @@ std::optional<TextMetricsEvpu> measureFontAscentDescentEvpu(const musx::dom::Fon
 #endif
 }
 
-musx::util::SvgConvert::GlyphMetricsFn makeSvgGlyphMetricsCallback(const DenigmaContext& denigmaContext)
+std::optional<GlyphRunMetricsEvpu> measureGlyphRunEvpu(const musx::dom::FontInfo& fontInfo,
+                                                       std::u32string_view codePoints,
+                                                       std::optional<double> pointSizeOverride,
+                                                       const DenigmaContext& denigmaContext)
+{
+    TraceSpan span("measureGlyphRunEvpu");
+    const double pointSize = pointSizeOverride.value_or(static_cast<double>(fontInfo.fontSize));
+    if (const auto* table = builtInTableFor(fontInfo)) {
+        GlyphRunMetricsEvpu result;
+        result.glyphs.reserve(codePoints.size());
+        for (std::size_t index = 0; index < codePoints.size(); index++) {
+            const auto measured = utils::measureTextWithTable(*table, codePoints.substr(index, 1), pointSize);
+            if (!measured) {
+                break; // the whole run falls back to the font
+            }
+            result.glyphs.push_back(TextMetricsEvpu{ measured->advance * EVPU_PER_POINT, measured->ascent * EVPU_PER_POINT,
+                                                     measured->descent * EVPU_PER_POINT });
+        }
+        if (result.glyphs.size() == codePoints.size()) {
+            result.face = tableVerticalMetricsEvpu(*table, pointSize);
+            return result;
+        }
+    }
+    if (denigmaContext.textMetrics == TextMetricsMode::Heuristic) {
+        GlyphRunMetricsEvpu result;
+        result.glyphs.reserve(codePoints.size());
+        for (std::size_t index = 0; index < codePoints.size(); index++) {
+            result.glyphs.push_back(heuristicTextMetricsEvpu(fontInfo, codePoints.substr(index, 1), pointSizeOverride));
+        }
+        result.face = heuristicVerticalMetricsEvpu(fontInfo, pointSizeOverride);
+        return result;
+    }
+#if defined(DENIGMA_USE_FREETYPE)
+    return backend().measureGlyphRun(fontInfo, codePoints, pointSizeOverride, denigmaContext);
+#else
+    (void)pointSize;
+    warnMissingBackend(denigmaContext);
+    return std::nullopt;
+#endif
+}
+
+std::u32string SvgGlyphMetricsCache::makeKey(const musx::dom::FontInfo& font, std::u32string_view text)
+{
+    // font fields that select the face and its size, then the text itself
+    std::u32string key;
+    key.reserve(text.size() + 3);
+    key.push_back(static_cast<char32_t>(font.fontId));
+    key.push_back(static_cast<char32_t>(font.fontSize));
+    key.push_back(static_cast<char32_t>((font.bold ? 1 : 0) | (font.italic ? 2 : 0) | (font.absolute ? 4 : 0)));
+    key.append(text);
+    return key;
+}
+
+void warmUpTextMetrics()
+{
+#if defined(DENIGMA_USE_FREETYPE)
+    backend().warmUp();
+#endif
+}
+
+musx::util::SvgConvert::GlyphMetricsFn makeSvgGlyphMetricsCallback(const DenigmaContext& denigmaContext,
+                                                                   SvgGlyphMetricsCache* cache)
 {
     const DenigmaContext* contextPtr = &denigmaContext;
-    return [contextPtr](const musx::dom::FontInfo& font,
-                        std::u32string_view text) -> std::optional<musx::util::SvgConvert::GlyphMetrics> {
+    auto measure = [contextPtr](const musx::dom::FontInfo& font,
+                                std::u32string_view text) -> std::optional<musx::util::SvgConvert::GlyphMetrics> {
         if (!contextPtr) {
             return std::nullopt;
         }
-        auto measured = measureTextEvpu(font, text, std::nullopt, *contextPtr);
+        // SvgConvert asks for one glyph at a time, which one run measures under a single font lookup
+        std::optional<TextMetricsEvpu> measured;
+        std::optional<TextMetricsEvpu> verticalMetrics;
+        if (text.size() == 1) {
+            if (auto run = measureGlyphRunEvpu(font, text, std::nullopt, *contextPtr)) {
+                measured = run->glyphs.front();
+                verticalMetrics = run->face;
+            }
+        } else {
+            measured = measureTextEvpu(font, text, std::nullopt, *contextPtr);
+            if (measured) {
+                verticalMetrics = measureFontAscentDescentEvpu(font, std::nullopt, *contextPtr);
+            }
+        }
         if (!measured) {
             return std::nullopt;
         }
-        auto verticalMetrics = measureFontAscentDescentEvpu(font, std::nullopt, *contextPtr);
         const bool useMeasuredVerticals = (measured->ascent != 0.0) || (measured->descent != 0.0);
         const double glyphAscent = useMeasuredVerticals
             ? measured->ascent
@@ -1141,25 +1975,33 @@ musx::util::SvgConvert::GlyphMetricsFn makeSvgGlyphMetricsCallback(const Denigma
         const double glyphDescent = useMeasuredVerticals
             ? measured->descent
             : (verticalMetrics ? verticalMetrics->descent : measured->descent);
-        std::string fontName;
-        try {
-            fontName = font.getName();
-        } catch (...) {
-            fontName.clear();
-        }
-        const uint32_t cp = text.empty() ? 0 : static_cast<uint32_t>(text.front());
-        contextPtr->logMessage(LogMsg() << "SVG metrics callback [freetype]"
-                                        << " font=\"" << fontName << "\""
-                                        << " sizePt=" << font.fontSize
-                                        << " cpDec=" << cp
-                                        << " measuredAdvance=" << measured->advance
-                                        << " measuredAscent=" << measured->ascent
-                                        << " measuredDescent=" << measured->descent
-                                        << " finalAscent=" << glyphAscent
-                                        << " finalDescent=" << glyphDescent,
-                             MessageSeverity::Verbose);
+        contextPtr->logMessage([&](LogMsg& msg) {
+            std::string fontName;
+            try {
+                fontName = font.getName();
+            } catch (...) {
+                fontName.clear();
+            }
+            const uint32_t cp = text.empty() ? 0 : static_cast<uint32_t>(text.front());
+            msg << (contextPtr->textMetrics == TextMetricsMode::Heuristic ? "SVG metrics callback [heuristic]" : "SVG metrics callback [freetype]")
+                << " font=\"" << fontName << "\""
+                << " sizePt=" << font.fontSize
+                << " cpDec=" << cp
+                << " measuredAdvance=" << measured->advance
+                << " measuredAscent=" << measured->ascent
+                << " measuredDescent=" << measured->descent
+                << " finalAscent=" << glyphAscent
+                << " finalDescent=" << glyphDescent;
+        }, MessageSeverity::Verbose);
         return musx::util::SvgConvert::GlyphMetrics{ measured->advance, glyphAscent, glyphDescent };
     };
+    if (!cache) {
+        return measure;
+    }
+    return [cache, measure](const musx::dom::FontInfo& font,
+                            std::u32string_view text) -> std::optional<musx::util::SvgConvert::GlyphMetrics> {
+        return cache->get(font, text, [&]() { return measure(font, text); });
+    };
 }
 
 } // namespace textmetrics
@@ -21,8 +21,12 @@
  */
 #pragma once
 
+#include <mutex>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "musx/musx.h"
 
@@ -55,7 +59,63 @@ std::optional<TextMetricsEvpu> measureFontAscentDescentEvpu(const musx::dom::Fon
                                                             std::optional<double> pointSizeOverride,
                                                             const DenigmaContext& denigmaContext);
 
-musx::util::SvgConvert::GlyphMetricsFn makeSvgGlyphMetricsCallback(const DenigmaContext& denigmaContext);
+/// Metrics of each glyph of a run set in one font and size, and of the face itself.
+struct GlyphRunMetricsEvpu
+{
+    std::vector<TextMetricsEvpu> glyphs; ///< one per code point, as measureTextEvpu measures that code point alone
+    TextMetricsEvpu face;                ///< as measureFontAscentDescentEvpu returns it
+};
+
+/// @brief Measures every code point of codePoints under one font lookup, rather than one lookup per glyph.
+/// @return nullopt if the font cannot be measured.
+std::optional<GlyphRunMetricsEvpu> measureGlyphRunEvpu(const musx::dom::FontInfo& fontInfo,
+                                                       std::u32string_view codePoints,
+                                                       std::optional<double> pointSizeOverride,
+                                                       const DenigmaContext& denigmaContext);
+
+/// Glyph metrics shared by the SVG callbacks of one batch, so that a glyph repeated across many shapes is measured
+/// once. It may be shared by callbacks running on different threads.
+class SvgGlyphMetricsCache
+{
+public:
+    using Metrics = std::optional<musx::util::SvgConvert::GlyphMetrics>;
+
+    /// Returns the metrics for font and text, measuring them with measure on first use.
+    template <typename MeasureFunc>
+    Metrics get(const musx::dom::FontInfo& font, std::u32string_view text, MeasureFunc&& measure)
+    {
+        auto key = makeKey(font, text);
+        {
+            std::scoped_lock lock(m_mutex);
+            if (const auto it = m_metrics.find(key); it != m_metrics.end()) {
+                return it->second;
+            }
+        }
+        Metrics result = measure();
+        std::scoped_lock lock(m_mutex);
+        if (m_metrics.size() >= MAX_CACHED_ENTRIES) {
+            m_metrics.clear(); // simply cleared when full
+        }
+        m_metrics.emplace(std::move(key), result);
+        return result;
+    }
+
+private:
+    static constexpr std::size_t MAX_CACHED_ENTRIES = 16384;
+
+    static std::u32string makeKey(const musx::dom::FontInfo& font, std::u32string_view text);
+
+    std::mutex m_mutex;
+    std::unordered_map<std::u32string, Metrics> m_metrics;
+};
+
+/// Creates the glyph-metrics callback for SvgConvert. When cache is supplied, results are shared through it.
+musx::util::SvgConvert::GlyphMetricsFn makeSvgGlyphMetricsCallback(const DenigmaContext& denigmaContext,
+                                                                   SvgGlyphMetricsCache* cache = nullptr);
+
+/// @brief Starts the font backend and builds its font index now rather than on the first measurement, so that
+/// worker processes forked afterwards inherit them.
+void warmUpTextMetrics();
 
 } // namespace textmetrics
 } // namespace denigma
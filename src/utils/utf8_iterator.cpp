@@ -21,6 +21,9 @@
  */
 #include "utf8_iterator.h"
 
+#include <cstdint>
+#include <cstring>
+
 namespace utils {
 namespace {
 std::optional<Utf8Codepoint> decodeUtf8Codepoint(const char* bytes, size_t remaining)
@@ -87,6 +90,15 @@ std::optional<Utf8Codepoint> decodeUtf8Codepoint(const char* bytes, size_t remai
 
     return Utf8Codepoint{ codepoint, byteCount };
 }
+
+constexpr std::uint64_t HIGH_BITS = 0x8080808080808080ull;
+
+std::uint64_t loadWord(const char* bytes) noexcept
+{
+    std::uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+}
 } // namespace
 
 Utf8Iterator::Utf8Iterator(std::string_view text)
@@ -112,6 +124,12 @@ void Utf8Iterator::decodeCurrent()
         return;
     }
 
+    if (const auto byte = static_cast<unsigned char>(m_text[m_offset]); byte <= 0x7F) {
+        m_current = Utf8Codepoint{ byte, 1 };
+        m_atEnd = false;
+        return;
+    }
+
     auto decoded = decodeUtf8Codepoint(
         m_text.data() + m_offset,
         m_text.size() - m_offset
@@ -144,4 +162,50 @@ std::optional<char32_t> utf8ToCodepoint(const std::string& utf8)
     }
 
     return result;
-}} // namespace utils
+}
+
+size_t asciiPrefixLength(std::string_view text) noexcept
+{
+    size_t offset = 0;
+    // two words per step, so long runs of Latin text cost one test per 16 bytes
+    for (; offset + 2 * sizeof(std::uint64_t) <= text.size(); offset += 2 * sizeof(std::uint64_t)) {
+        if ((loadWord(text.data() + offset) | loadWord(text.data() + offset + sizeof(std::uint64_t))) & HIGH_BITS) {
+            break;
+        }
+    }
+    for (; offset + sizeof(std::uint64_t) <= text.size(); offset += sizeof(std::uint64_t)) {
+        if (loadWord(text.data() + offset) & HIGH_BITS) {
+            break;
+        }
+    }
+    while (offset < text.size() && static_cast<unsigned char>(text[offset]) <= 0x7F) {
+        ++offset;
+    }
+    return offset;
+}
+
+bool decodeToU32(std::string_view utf8, std::u32string& out)
+{
+    out.clear();
+    out.reserve(utf8.size()); // never more codepoints than bytes
+    size_t offset = 0;
+    while (offset < utf8.size()) {
+        const size_t asciiLength = asciiPrefixLength(utf8.substr(offset));
+        for (size_t index = 0; index < asciiLength; index++) {
+            out.push_back(static_cast<unsigned char>(utf8[offset + index]));
+        }
+        offset += asciiLength;
+        if (offset >= utf8.size()) {
+            break;
+        }
+        const auto decoded = decodeUtf8Codepoint(utf8.data() + offset, utf8.size() - offset);
+        if (!decoded) {
+            return false;
+        }
+        out.push_back(decoded->codepoint);
+        offset += decoded->byteCount;
+    }
+    return true;
+}
+
+} // namespace utils
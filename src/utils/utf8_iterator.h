@@ -60,4 +60,13 @@ private:
 
 /// @brief Converts a string to a utf32 codepoint if it represents exactly one codepoing.
 std::optional<char32_t> utf8ToCodepoint(const std::string& utf8);
+
+/// @brief Returns the length of the leading run of ASCII bytes in text, scanned a word at a time.
+size_t asciiPrefixLength(std::string_view text) noexcept;
+
+/// @brief Replaces the contents of out with the codepoints of utf8.
+///
+/// Runs of ASCII are copied without decoding. Like Utf8Iterator, decoding stops at the first invalid sequence.
+/// @return false if utf8 is not valid UTF-8, in which case out holds the codepoints before the invalid sequence.
+bool decodeToU32(std::string_view utf8, std::u32string& out);
 } //namespace utils
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "xml_header_probe.h"
+
+#include <charconv>
+#include <vector>
+
+namespace utils {
+
+namespace {
+
+bool isXmlSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isNameEnd(char c)
+{
+    return isXmlSpace(c) || c == '>' || c == '/' || c == '=';
+}
+
+std::string_view trimXmlSpace(std::string_view value)
+{
+    while (!value.empty() && isXmlSpace(value.front())) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && isXmlSpace(value.back())) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+} // namespace
+
+XmlHeaderProbe::XmlHeaderProbe(std::string_view xml, std::string_view stopAfterPath, std::size_t byteBudget)
+{
+    const std::string_view input = xml.substr(0, byteBudget);
+    constexpr std::string_view UTF8_BOM = "\xEF\xBB\xBF";
+    std::size_t pos = input.starts_with(UTF8_BOM) ? UTF8_BOM.size() : 0;
+
+    struct OpenElement
+    {
+        std::size_t pathLength{};   // length of the path before this element was appended
+        std::size_t textStart{};    // offset just past the start tag
+        bool hasChildren{};
+    };
+    std::vector<OpenElement> stack;
+    std::string path;
+
+    // Returns the offset of the '>' ending a tag that starts at from, skipping quoted attribute values.
+    auto findTagEnd = [&](std::size_t from) -> std::size_t {
+        char quote = 0;
+        for (std::size_t i = from; i < input.size(); i++) {
+            const char c = input[i];
+            if (quote) {
+                if (c == quote) quote = 0;
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                return i;
+            }
+        }
+        return std::string_view::npos;
+    };
+    auto skipPast = [&](std::size_t from, std::string_view terminator) -> std::size_t {
+        const std::size_t found = input.find(terminator, from);
+        return (found == std::string_view::npos) ? found : found + terminator.size();
+    };
+    auto readRootAttributes = [&](std::string_view tag) {
+        std::size_t i = 0;
+        while (i < tag.size()) {
+            while (i < tag.size() && isXmlSpace(tag[i])) i++;
+            const std::size_t nameStart = i;
+            while (i < tag.size() && !isNameEnd(tag[i])) i++;
+            const std::string_view name = tag.substr(nameStart, i - nameStart);
+            while (i < tag.size() && isXmlSpace(tag[i])) i++;
+            if (name.empty() || i >= tag.size() || tag[i] != '=') {
+                break;
+            }
+            i++;
+            while (i < tag.size() && isXmlSpace(tag[i])) i++;
+            if (i >= tag.size() || (tag[i] != '"' && tag[i] != '\'')) {
+                break;
+            }
+            const char quote = tag[i++];
+            const std::size_t valueEnd = tag.find(quote, i);
+            if (valueEnd == std::string_view::npos) {
+                break;
+            }
+            m_rootAttributes.emplace(std::string(name), tag.substr(i, valueEnd - i));
+            i = valueEnd + 1;
+        }
+    };
+
+    while (pos < input.size()) {
+        const std::size_t tagStart = input.find('<', pos);
+        if (tagStart == std::string_view::npos || tagStart + 1 >= input.size()) {
+            break;
+        }
+        const std::string_view rest = input.substr(tagStart);
+        if (rest.starts_with("<?")) {
+            pos = skipPast(tagStart, "?>");
+        } else if (rest.starts_with("<!--")) {
+            pos = skipPast(tagStart, "-->");
+        } else if (rest.starts_with("<![CDATA[")) {
+            if (!stack.empty()) stack.back().hasChildren = true; // mixed content is not reported as leaf text
+            pos = skipPast(tagStart, "]]>");
+        } else if (rest.starts_with("<!")) {
+            const std::size_t subsetEnd = rest.find('[') < rest.find('>') ? skipPast(tagStart, "]") : tagStart;
+            pos = (subsetEnd == std::string_view::npos) ? subsetEnd : skipPast(subsetEnd, ">");
+        } else if (rest[1] == '/') {
+            const std::size_t tagEnd = input.find('>', tagStart);
+            if (tagEnd == std::string_view::npos || stack.empty()) {
+                break;
+            }
+            const OpenElement element = stack.back();
+            stack.pop_back();
+            if (!element.hasChildren) {
+                m_leafText.emplace(path, trimXmlSpace(input.substr(element.textStart, tagStart - element.textStart)));
+            }
+            if (!stopAfterPath.empty() && path == stopAfterPath) {
+                m_reachedStopPath = true;
+                break;
+            }
+            path.resize(element.pathLength);
+            pos = tagEnd + 1;
+        } else {
+            const std::size_t tagEnd = findTagEnd(tagStart + 1);
+            if (tagEnd == std::string_view::npos) {
+                break;
+            }
+            const bool selfClosing = input[tagEnd - 1] == '/';
+            const std::string_view tag = input.substr(tagStart + 1, tagEnd - tagStart - (selfClosing ? 2 : 1));
+            std::size_t nameLength = 0;
+            while (nameLength < tag.size() && !isNameEnd(tag[nameLength])) nameLength++;
+            const std::string_view name = tag.substr(0, nameLength);
+            if (stack.empty()) {
+                if (!m_rootElement.empty()) {
+                    break; // a second document element means this is not well-formed XML
+                }
+                m_rootElement = std::string(name);
+                readRootAttributes(tag.substr(nameLength));
+            } else {
+                stack.back().hasChildren = true;
+            }
+            const std::size_t pathLength = path.size();
+            if (!path.empty()) path += '/';
+            path += name;
+            if (selfClosing) {
+                m_leafText.emplace(path, std::string_view{});
+                if (!stopAfterPath.empty() && path == stopAfterPath) {
+                    m_reachedStopPath = true;
+                    break;
+                }
+                path.resize(pathLength);
+            } else {
+                stack.push_back({ pathLength, tagEnd + 1, false });
+            }
+            pos = tagEnd + 1;
+        }
+    }
+}
+
+std::optional<std::string_view> XmlHeaderProbe::rootAttribute(std::string_view name) const
+{
+    if (const auto it = m_rootAttributes.find(std::string(name)); it != m_rootAttributes.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string_view> XmlHeaderProbe::text(std::string_view path) const
+{
+    if (const auto it = m_leafText.find(std::string(path)); it != m_leafText.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<int> XmlHeaderProbe::intValue(std::string_view path) const
+{
+    const auto value = text(path);
+    if (!value || value->empty()) {
+        return std::nullopt;
+    }
+    int result = 0;
+    const auto [end, ec] = std::from_chars(value->data(), value->data() + value->size(), result);
+    if (ec != std::errc{} || end != value->data() + value->size()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<std::pair<int, int>> probeEnigmaXmlFileVersion(std::string_view xml)
+{
+    const XmlHeaderProbe probe(xml, "finale/header");
+    for (const std::string_view stamp : { "modified", "created" }) {
+        const std::string prefix = "finale/header/headerData/" + std::string(stamp) + "/fileVersion/";
+        const auto major = probe.intValue(prefix + "major");
+        const auto minor = probe.intValue(prefix + "minor");
+        if (major && minor) {
+            return std::make_pair(*major, *minor);
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace utils
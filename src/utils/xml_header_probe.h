@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace utils {
+
+/// @class XmlHeaderProbe
+/// @brief Reads the leading elements of an XML document without parsing the whole of it.
+///
+/// The probe scans at most a fixed number of bytes, or up to the end of a chosen element, and records the
+/// document element's attributes and the text of each leaf element it passes, keyed by slash-separated path
+/// (for example `finale/header/headerData/created/fileVersion/major`). Only the first occurrence of a path is
+/// kept. Values are raw views into the probed buffer (entities are not expanded), so the buffer must outlive the probe.
+/// It is meant for cheap format and version detection, not as a validating parser.
+class XmlHeaderProbe
+{
+public:
+    static constexpr std::size_t DEFAULT_BYTE_BUDGET = 64 * 1024; ///< enough for any header this project reads
+
+    /// Probes xml up to byteBudget bytes, stopping early at the end tag of stopAfterPath if it is given.
+    explicit XmlHeaderProbe(std::string_view xml, std::string_view stopAfterPath = {},
+                            std::size_t byteBudget = DEFAULT_BYTE_BUDGET);
+
+    /// Name of the document element, or empty if it was not reached.
+    const std::string& rootElement() const { return m_rootElement; }
+
+    /// Value of an attribute of the document element.
+    std::optional<std::string_view> rootAttribute(std::string_view name) const;
+
+    /// Trimmed text of the first leaf element at path.
+    std::optional<std::string_view> text(std::string_view path) const;
+
+    /// Text of the first leaf element at path, if it is a decimal integer.
+    std::optional<int> intValue(std::string_view path) const;
+
+    /// True if the end tag of stopAfterPath was reached within the byte budget.
+    bool reachedStopPath() const { return m_reachedStopPath; }
+
+private:
+    std::string m_rootElement;
+    std::unordered_map<std::string, std::string_view> m_rootAttributes;
+    std::unordered_map<std::string, std::string_view> m_leafText;
+    bool m_reachedStopPath{};
+};
+
+/// Returns the (major, minor) Finale file version recorded in an EnigmaXML header, preferring
+/// the last-modified version over the created version, or std::nullopt if neither is in the header.
+std::optional<std::pair<int, int>> probeEnigmaXmlFileVersion(std::string_view xml);
+
+} // namespace utils
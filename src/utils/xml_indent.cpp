@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "utils/xml_indent.h"
+
+namespace utils {
+
+namespace {
+
+bool isXmlSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+void XmlIndentStripper::strip(std::string_view text, std::string& out)
+{
+    out.reserve(out.size() + text.size());
+    for (const char c : text) {
+        if (m_openHeld) {
+            // c decides whether the whitespace before the held '<' was indentation
+            const bool isElementContent = m_lastTagKind == TagKind::Start && c == '/';
+            if (!m_pendingHasLineBreak || isElementContent) {
+                out += m_pending;
+            }
+            m_pending.clear();
+            m_pendingHasLineBreak = false;
+            m_openHeld = false;
+            out += '<';
+        }
+        if (m_inTag) {
+            out += c;
+            if (m_tagKindPending) {
+                m_tagKind = (c == '/' || c == '?' || c == '!') ? TagKind::Other : TagKind::Start;
+                m_tagKindPending = false;
+            } else if (m_quote) {
+                m_quote = c == m_quote ? 0 : m_quote;
+            } else if (c == '"' || c == '\'') {
+                m_quote = c;
+            } else if (c == '>') {
+                m_inTag = false;
+                m_lastTagKind = m_previous == '/' ? TagKind::Other : m_tagKind;
+                m_afterTag = true;
+            }
+            m_previous = c;
+            continue;
+        }
+        if (m_afterTag && isXmlSpace(c)) {
+            m_pending += c;
+            m_pendingHasLineBreak = m_pendingHasLineBreak || c == '\n' || c == '\r';
+            continue;
+        }
+        m_afterTag = false;
+        if (c == '<') {
+            m_inTag = true;
+            m_tagKindPending = true;
+            m_previous = c;
+            if (!m_pending.empty()) {
+                m_openHeld = true;
+                continue;
+            }
+            out += c;
+            continue;
+        }
+        out += m_pending;
+        m_pending.clear();
+        m_pendingHasLineBreak = false;
+        out += c;
+    }
+}
+
+void XmlIndentStripper::finish(std::string& out)
+{
+    out += m_pending;
+    if (m_openHeld) {
+        out += '<';
+    }
+    *this = {};
+}
+
+std::string stripXmlIndentation(std::string_view xml)
+{
+    std::string result;
+    XmlIndentStripper stripper;
+    stripper.strip(xml, result);
+    stripper.finish(result);
+    return result;
+}
+
+} // namespace utils
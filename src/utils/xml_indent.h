@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+/// @class XmlIndentStripper
+/// @brief Removes pretty-print indentation from XML text as it streams through, chunk by chunk.
+///
+/// A whitespace run that follows a tag and contains a line break is dropped when the next character starts a tag,
+/// unless it is the whole content of an element (a start tag followed directly by its end tag). Everything else,
+/// including whitespace inside text and attribute values, is passed through unchanged. The output parses to the same
+/// elements, attributes and non-indentation text as the input.
+class XmlIndentStripper
+{
+public:
+    /// Appends the stripped form of the next chunk of input to out. Some trailing whitespace may be held back until
+    /// the next chunk shows whether it is indentation.
+    void strip(std::string_view text, std::string& out);
+
+    /// Appends whatever was held back at the end of the input to out.
+    void finish(std::string& out);
+
+private:
+    enum class TagKind : std::uint8_t
+    {
+        Start,  ///< a start tag that is not self-closing
+        Other,  ///< an end tag, an empty-element tag, a declaration, comment or processing instruction
+    };
+
+    std::string m_pending;          ///< whitespace after a tag that may be indentation
+    bool m_pendingHasLineBreak{};
+    bool m_afterTag{};              ///< nothing but m_pending has followed the last tag
+    bool m_inTag{};
+    bool m_tagKindPending{};        ///< a '<' was read and the character that decides the tag's kind was not
+    bool m_openHeld{};              ///< the '<' that ended m_pending is held until its tag's kind is known
+    char m_quote{};                 ///< the quote of the attribute value being read, or 0
+    char m_previous{};
+    TagKind m_tagKind{ TagKind::Other };
+    TagKind m_lastTagKind{ TagKind::Other };
+};
+
+/// Returns xml without its pretty-print indentation (see XmlIndentStripper).
+std::string stripXmlIndentation(std::string_view xml);
+
+} // namespace utils
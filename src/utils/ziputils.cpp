@@ -19,12 +19,27 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "utils/ziputils.h"
+#include "utils/inflate.h"
+#include "core/buffer_pool.h"
+#include "core/parallel.h"
 
 #include "pugixml.hpp"
 #include "unzip.h"
@@ -40,6 +55,9 @@ using namespace denigma;
 
 namespace {
 
+constexpr std::uint64_t MAX_PRESIZED_ENTRY_BYTES = std::uint64_t(1) << 30; // the recorded size is not trusted beyond this
+constexpr std::size_t MAX_ZIP_READ_BYTES = std::size_t(1) << 30;          // unzReadCurrentFile takes an unsigned length
+
 struct RandomAccessZipStream
 {
     const IRandomAccessReader* reader{};
@@ -233,6 +251,107 @@ static unzFile openZipForRead(const IRandomAccessReader& reader, const DenigmaCo
     return zip;
 }
 
+struct MemoryZipStream
+{
+    std::string* data{};
+    std::size_t position{};
+};
+
+static voidpf ZCALLBACK memoryOpen64(voidpf opaque, const void*, int mode)
+{
+    if ((mode & ZLIB_FILEFUNC_MODE_CREATE) == 0 || !opaque) {
+        return nullptr;
+    }
+    auto* data = static_cast<std::string*>(opaque);
+    data->clear();
+    return new MemoryZipStream{ data, 0 };
+}
+
+static uLong ZCALLBACK memoryRead(voidpf, voidpf stream, void* buffer, uLong size)
+{
+    auto* zipStream = static_cast<MemoryZipStream*>(stream);
+    if (!zipStream || !buffer || zipStream->position >= zipStream->data->size()) {
+        return 0;
+    }
+    const std::size_t count = (std::min)(static_cast<std::size_t>(size), zipStream->data->size() - zipStream->position);
+    std::memcpy(buffer, zipStream->data->data() + zipStream->position, count);
+    zipStream->position += count;
+    return static_cast<uLong>(count);
+}
+
+static uLong ZCALLBACK memoryWrite(voidpf, voidpf stream, const void* buffer, uLong size)
+{
+    auto* zipStream = static_cast<MemoryZipStream*>(stream);
+    if (!zipStream || !buffer) {
+        return 0;
+    }
+    std::string& data = *zipStream->data;
+    const auto* bytes = static_cast<const char*>(buffer);
+    const std::size_t count = static_cast<std::size_t>(size);
+    const std::size_t overwritten = (std::min)(count, data.size() - (std::min)(zipStream->position, data.size()));
+    if (zipStream->position > data.size()) {
+        data.resize(zipStream->position);
+    }
+    data.replace(zipStream->position, overwritten, bytes, count); // minizip seeks back to patch local headers
+    zipStream->position += count;
+    return size;
+}
+
+static ZPOS64_T ZCALLBACK memoryTell64(voidpf, voidpf stream)
+{
+    auto* zipStream = static_cast<MemoryZipStream*>(stream);
+    return zipStream ? static_cast<ZPOS64_T>(zipStream->position) : static_cast<ZPOS64_T>(0);
+}
+
+static long ZCALLBACK memorySeek64(voidpf, voidpf stream, ZPOS64_T offset, int origin)
+{
+    auto* zipStream = static_cast<MemoryZipStream*>(stream);
+    if (!zipStream) {
+        return -1;
+    }
+    std::uint64_t base{};
+    switch (origin) {
+    case ZLIB_FILEFUNC_SEEK_SET:
+        base = 0;
+        break;
+    case ZLIB_FILEFUNC_SEEK_CUR:
+        base = zipStream->position;
+        break;
+    case ZLIB_FILEFUNC_SEEK_END:
+        base = zipStream->data->size();
+        break;
+    default:
+        return -1;
+    }
+    zipStream->position = static_cast<std::size_t>(base + static_cast<std::uint64_t>(offset));
+    return 0;
+}
+
+static int ZCALLBACK memoryClose(voidpf, voidpf stream)
+{
+    delete static_cast<MemoryZipStream*>(stream);
+    return 0;
+}
+
+static int ZCALLBACK memoryError(voidpf, voidpf)
+{
+    return 0;
+}
+
+static zipFile openZipForWrite(std::string& output)
+{
+    zlib_filefunc64_def fileFuncs{};
+    fileFuncs.zopen64_file = memoryOpen64;
+    fileFuncs.zread_file = memoryRead;
+    fileFuncs.zwrite_file = memoryWrite;
+    fileFuncs.ztell64_file = memoryTell64;
+    fileFuncs.zseek64_file = memorySeek64;
+    fileFuncs.zclose_file = memoryClose;
+    fileFuncs.zerror_file = memoryError;
+    fileFuncs.opaque = &output;
+    return zipOpen2_64("", APPEND_STATUS_CREATE, nullptr, &fileFuncs);
+}
+
 static zipFile openZipForWrite(const std::filesystem::path& outputPath)
 {
 #ifdef _WIN32
@@ -246,6 +365,25 @@ static zipFile openZipForWrite(const std::filesystem::path& outputPath)
 #endif
 }
 
+static zip_fileinfo makeCurrentZipFileInfo()
+{
+    zip_fileinfo info{};
+    const std::time_t now = std::time(nullptr);
+    std::tm localTime{};
+#ifdef _WIN32
+    localtime_s(&localTime, &now);
+#else
+    localtime_r(&now, &localTime);
+#endif
+    info.tmz_date.tm_sec = localTime.tm_sec;
+    info.tmz_date.tm_min = localTime.tm_min;
+    info.tmz_date.tm_hour = localTime.tm_hour;
+    info.tmz_date.tm_mday = localTime.tm_mday;
+    info.tmz_date.tm_mon = localTime.tm_mon;
+    info.tmz_date.tm_year = localTime.tm_year + 1900;
+    return info;
+}
+
 static ZipEntryInfo getCurrentEntryInfo(unzFile zip)
 {
     ZipEntryInfo entry{};
@@ -274,18 +412,151 @@ static ZipEntryInfo getCurrentEntryInfo(unzFile zip)
     return entry;
 }
 
+/// An entry's compressed bytes together with what the zip headers need to describe them.
+struct CompressedZipEntry
+{
+    std::string data;
+    int method{};
+    int level{};
+    ZPOS64_T uncompressedSize{};
+    uLong crc{};
+};
+
+/// Reads the current entry's compressed bytes as they are, without inflating them.
+static CompressedZipEntry readCurrentEntryRaw(unzFile inputZip, const ZipEntryInfo& fileInfo)
+{
+    CompressedZipEntry entry;
+    entry.uncompressedSize = fileInfo.info.uncompressed_size;
+    entry.crc = fileInfo.info.crc;
+    int rc = unzOpenCurrentFile2(inputZip, &entry.method, &entry.level, 1);
+    if (rc != UNZ_OK) {
+        throw std::runtime_error("unable to open raw entry in zip archive");
+    }
+    entry.data.resize(static_cast<std::size_t>((std::min<std::uint64_t>)(fileInfo.info.compressed_size, MAX_PRESIZED_ENTRY_BYTES)));
+    std::size_t used = 0;
+    while (true) {
+        if (used == entry.data.size()) {
+            entry.data.resize(entry.data.size() + (std::max<std::size_t>)(entry.data.size() / 2, 16384));
+        }
+        const std::size_t available = (std::min<std::size_t>)(entry.data.size() - used, MAX_ZIP_READ_BYTES);
+        const int readRc = unzReadCurrentFile(inputZip, entry.data.data() + used, static_cast<unsigned>(available));
+        if (readRc < 0) {
+            unzCloseCurrentFile(inputZip);
+            throw std::runtime_error("unable to read raw entry from zip archive");
+        }
+        if (readRc == 0) {
+            break;
+        }
+        used += static_cast<std::size_t>(readRc);
+    }
+    entry.data.resize(used);
+    unzCloseCurrentFile(inputZip); // raw reads are not CRC-checked, so there is no result to check here
+    return entry;
+}
+
+static uLong crc32Of(std::span<const char> contents)
+{
+    uLong crc = crc32(0L, Z_NULL, 0);
+    for (std::size_t offset = 0; offset < contents.size();) {
+        const std::size_t chunkSize = (std::min<std::size_t>)(contents.size() - offset, MAX_ZIP_READ_BYTES);
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(contents.data() + offset), static_cast<uInt>(chunkSize));
+        offset += chunkSize;
+    }
+    return crc;
+}
+
+/// Inflates the current deflated entry in one call to the accelerated backend, or returns std::nullopt so that the
+/// caller streams it through zlib instead.
+static std::optional<std::string> inflateCurrentEntryWhole(unzFile zip, const unz_file_info64& info)
+{
+    if (!utils::hasAcceleratedInflate() || info.compression_method != Z_DEFLATED
+        || info.uncompressed_size > MAX_PRESIZED_ENTRY_BYTES || info.compressed_size > MAX_PRESIZED_ENTRY_BYTES) {
+        return std::nullopt;
+    }
+    ZipEntryInfo entryInfo{};
+    entryInfo.info = info;
+    const CompressedZipEntry compressed = readCurrentEntryRaw(zip, entryInfo);
+    std::string output = denigma::acquireStringBuffer(static_cast<std::size_t>(info.uncompressed_size));
+    output.resize(static_cast<std::size_t>(info.uncompressed_size));
+    if (!utils::inflateKnownSize(compressed.data, utils::DeflateFormat::Raw, output) || crc32Of(output) != info.crc) {
+        denigma::recycleStringBuffer(std::move(output));
+        return std::nullopt;
+    }
+    return output;
+}
+
+/// Inflates an entry read by readCurrentEntryRaw into output, which must be exactly its inflated size.
+static void inflateRawEntry(const CompressedZipEntry& entry, std::span<char> output)
+{
+    if (entry.uncompressedSize != output.size()) {
+        throw std::runtime_error("zip entry size does not match its directory record");
+    }
+    if (entry.method == 0) {
+        if (entry.data.size() != output.size()) {
+            throw std::runtime_error("stored zip entry is truncated");
+        }
+        std::copy(entry.data.begin(), entry.data.end(), output.begin());
+    } else if (entry.method != Z_DEFLATED) {
+        throw std::runtime_error("unsupported zip compression method " + std::to_string(entry.method));
+    } else if (!utils::inflateKnownSize(entry.data, utils::DeflateFormat::Raw, output)) {
+        z_stream stream{};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            throw std::runtime_error("unable to initialize zlib inflate");
+        }
+        std::size_t consumed = 0;
+        std::size_t produced = 0;
+        int rc = Z_OK;
+        while (rc == Z_OK) {
+            const std::size_t inputChunk = (std::min<std::size_t>)(entry.data.size() - consumed, std::numeric_limits<uInt>::max());
+            const std::size_t outputChunk = (std::min<std::size_t>)(output.size() - produced, std::numeric_limits<uInt>::max());
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(entry.data.data() + consumed));
+            stream.avail_in = static_cast<uInt>(inputChunk);
+            stream.next_out = reinterpret_cast<Bytef*>(output.data() + produced);
+            stream.avail_out = static_cast<uInt>(outputChunk);
+            rc = inflate(&stream, Z_NO_FLUSH);
+            consumed += inputChunk - stream.avail_in;
+            produced += outputChunk - stream.avail_out;
+            if (rc == Z_OK && inputChunk == stream.avail_in && outputChunk == stream.avail_out) {
+                rc = Z_BUF_ERROR; // no progress: truncated input or more output than recorded
+            }
+        }
+        inflateEnd(&stream);
+        if (rc != Z_STREAM_END || produced != output.size()) {
+            throw std::runtime_error("unable to inflate zip entry");
+        }
+    }
+    if (crc32Of(output) != entry.crc) {
+        throw std::runtime_error("zip entry failed its CRC check");
+    }
+}
+
 static std::string readCurrentFile(unzFile zip)
 {
+    // The central directory records each entry's size, so read straight into a buffer of that size rather than
+    // growing it a chunk at a time. The recorded size is only a hint: a larger entry still grows the buffer.
+    std::string output;
+    unz_file_info64 info{};
+    if (unzGetCurrentFileInfo64(zip, &info, nullptr, 0, nullptr, 0, nullptr, 0) == UNZ_OK) {
+        if (auto inflated = inflateCurrentEntryWhole(zip, info)) {
+            return std::move(*inflated);
+        }
+        output = denigma::acquireStringBuffer(static_cast<std::size_t>((std::min<std::uint64_t>)(info.uncompressed_size, MAX_PRESIZED_ENTRY_BYTES)));
+        output.resize(static_cast<std::size_t>((std::min<std::uint64_t>)(info.uncompressed_size, MAX_PRESIZED_ENTRY_BYTES)));
+    }
+
     int rc = unzOpenCurrentFile(zip);
     if (rc != UNZ_OK) {
         throw std::runtime_error("unable to open entry in zip archive");
     }
-
-    std::string output;
+    std::size_t used = 0;
     std::array<char, 16384> chunk{};
 
     while (true) {
-        int readRc = unzReadCurrentFile(zip, chunk.data(), static_cast<unsigned>(chunk.size()));
+        // Once the buffer is full, read into the chunk so that an entry of exactly the recorded size never grows it.
+        const bool full = used == output.size();
+        char* target = full ? chunk.data() : output.data() + used;
+        const std::size_t available = full ? chunk.size() : output.size() - used;
+        int readRc = unzReadCurrentFile(zip, target, static_cast<unsigned>((std::min<std::size_t>)(available, MAX_ZIP_READ_BYTES)));
         if (readRc < 0) {
             unzCloseCurrentFile(zip);
             throw std::runtime_error("unable to read entry from zip archive");
@@ -293,8 +564,12 @@ static std::string readCurrentFile(unzFile zip)
         if (readRc == 0) {
             break;
         }
-        output.append(chunk.data(), static_cast<std::size_t>(readRc));
+        if (full) {
+            output.append(chunk.data(), static_cast<std::size_t>(readRc));
+        }
+        used += static_cast<std::size_t>(readRc);
     }
+    output.resize(used);
 
     rc = unzCloseCurrentFile(zip);
     if (rc != UNZ_OK) {
@@ -337,7 +612,17 @@ static bool iterateFiles(unzFile zip, const std::optional<std::string>& searchFo
     return calledIterator;
 }
 
-static void writeEntryToZip(zipFile outputZip, const ZipEntryInfo& fileInfo, const std::string& fileContents)
+/// The bytes of the current entry's local header and data. The local header's extra field is not recorded in the
+/// central directory, so an allowance is added for it.
+static ByteRange currentEntryRange(unzFile zip, const ZipEntryInfo& fileInfo)
+{
+    constexpr std::uint64_t LOCAL_HEADER_SIZE = 30;
+    constexpr std::uint64_t LOCAL_EXTRA_ALLOWANCE = 1024;
+    return { static_cast<std::uint64_t>(unzGetOffset64(zip)),
+             LOCAL_HEADER_SIZE + fileInfo.info.size_filename + LOCAL_EXTRA_ALLOWANCE + fileInfo.info.compressed_size };
+}
+
+static zip_fileinfo makeZipFileInfo(const ZipEntryInfo& fileInfo)
 {
     zip_fileinfo zipInfo{};
     zipInfo.tmz_date.tm_sec = fileInfo.info.tmu_date.tm_sec;
@@ -348,10 +633,61 @@ static void writeEntryToZip(zipFile outputZip, const ZipEntryInfo& fileInfo, con
     zipInfo.tmz_date.tm_year = fileInfo.info.tmu_date.tm_year;
     zipInfo.internal_fa = fileInfo.info.internal_fa;
     zipInfo.external_fa = fileInfo.info.external_fa;
+    return zipInfo;
+}
 
-    const int method = (fileInfo.info.compression_method == 0) ? 0 : Z_DEFLATED;
-    const int useZip64 = fileContents.size() >= 0xffffffffULL ? 1 : 0;
-    int rc = zipOpenNewFileInZip64(
+/// Compresses contents the way zipWriteInFileInZip would (raw deflate, or stored if the entry was stored),
+/// so that the result can be built off the writing thread and then written with writeRawEntryToZip.
+static CompressedZipEntry compressZipEntry(const ZipEntryInfo& fileInfo, const std::string& contents)
+{
+    CompressedZipEntry entry;
+    entry.uncompressedSize = contents.size();
+    entry.crc = crc32Of(contents);
+    if (fileInfo.info.compression_method == 0) {
+        entry.data = contents;
+        return entry;
+    }
+
+    entry.method = Z_DEFLATED;
+    entry.level = Z_DEFAULT_COMPRESSION;
+    z_stream stream{};
+    int rc = deflateInit2(&stream, entry.level, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (rc != Z_OK) {
+        throw std::runtime_error("unable to initialize zlib deflate");
+    }
+    entry.data.reserve(contents.size() / 2);
+    std::array<char, 16384> chunk{};
+    const auto* nextInput = reinterpret_cast<const Bytef*>(contents.data());
+    std::size_t remainingInput = contents.size();
+    while (true) {
+        if (stream.avail_in == 0 && remainingInput > 0) {
+            const std::size_t inputChunk = (std::min<std::size_t>)(remainingInput, std::numeric_limits<uInt>::max());
+            stream.next_in = const_cast<Bytef*>(nextInput);
+            stream.avail_in = static_cast<uInt>(inputChunk);
+            nextInput += inputChunk;
+            remainingInput -= inputChunk;
+        }
+        stream.next_out = reinterpret_cast<Bytef*>(chunk.data());
+        stream.avail_out = static_cast<uInt>(chunk.size());
+        rc = deflate(&stream, (remainingInput == 0 && stream.avail_in == 0) ? Z_FINISH : Z_NO_FLUSH);
+        if (rc != Z_OK && rc != Z_STREAM_END) {
+            deflateEnd(&stream);
+            throw std::runtime_error("unable to compress zip entry");
+        }
+        entry.data.append(chunk.data(), chunk.size() - stream.avail_out);
+        if (rc == Z_STREAM_END) {
+            break;
+        }
+    }
+    deflateEnd(&stream);
+    return entry;
+}
+
+/// Writes already-compressed entry data to outputZip with the entry's original name, date and attributes.
+static void writeRawEntryToZip(zipFile outputZip, const ZipEntryInfo& fileInfo, const CompressedZipEntry& entry)
+{
+    zip_fileinfo zipInfo = makeZipFileInfo(fileInfo);
+    int rc = zipOpenNewFileInZip2_64(
         outputZip,
         fileInfo.filename.c_str(),
         &zipInfo,
@@ -360,55 +696,50 @@ static void writeEntryToZip(zipFile outputZip, const ZipEntryInfo& fileInfo, con
         nullptr,
         0,
         nullptr,
-        method,
-        Z_DEFAULT_COMPRESSION,
-        useZip64
+        entry.method,
+        entry.level,
+        1,
+        entry.uncompressedSize >= 0xffffffffULL ? 1 : 0
     );
     if (rc != ZIP_OK) {
         throw std::runtime_error("unable to create entry in output zip archive");
     }
-
     std::size_t offset = 0;
-    while (offset < fileContents.size()) {
-        const std::size_t chunkSize = std::min<std::size_t>(fileContents.size() - offset, std::numeric_limits<unsigned>::max());
-        rc = zipWriteInFileInZip(outputZip, fileContents.data() + offset, static_cast<unsigned>(chunkSize));
+    while (offset < entry.data.size()) {
+        const std::size_t chunkSize = (std::min<std::size_t>)(entry.data.size() - offset, MAX_ZIP_READ_BYTES);
+        rc = zipWriteInFileInZip(outputZip, entry.data.data() + offset, static_cast<unsigned>(chunkSize));
         if (rc < 0) {
-            zipCloseFileInZip(outputZip);
+            zipCloseFileInZipRaw64(outputZip, entry.uncompressedSize, entry.crc);
             throw std::runtime_error("unable to write entry data to output zip archive");
         }
         offset += chunkSize;
     }
-
-    rc = zipCloseFileInZip(outputZip);
+    rc = zipCloseFileInZipRaw64(outputZip, entry.uncompressedSize, entry.crc);
     if (rc != ZIP_OK) {
         throw std::runtime_error("unable to finalize entry in output zip archive");
     }
 }
 
-static std::string getMusicXmlScoreName(const std::filesystem::path& zipFilePath, unzFile zip, const denigma::DenigmaContext& denigmaContext)
+static std::string getMusicXmlScoreName(const ZipArchiveIndex& archive, const denigma::DenigmaContext& denigmaContext)
 {
-    std::filesystem::path defaultName = zipFilePath.filename();
+    std::filesystem::path defaultName = archive.path().filename();
     defaultName.replace_extension(MUSICXML_EXTENSION);
     auto fileName = defaultName.filename().u8string();
     try {
-        iterateFiles(zip, std::nullopt, [&](const ZipEntryInfo& entry) {
-            if (entry.filename == "META-INF/container.xml") {
-                pugi::xml_document containerXml;
-                const std::string xmlBuffer = readCurrentFile(zip);
-                auto parseResult = containerXml.load_buffer(xmlBuffer.data(), xmlBuffer.size());
-                if (!parseResult) {
-                    throw std::runtime_error("Error parsing container.xml: " + std::string(parseResult.description()));
-                }
-                if (auto path = containerXml.child("container").child("rootfiles").child("rootfile").attribute("full-path")) {
-                    fileName = utils::stringToUtf8(path.value());
-                }
-                return false;
+        if (const auto* entry = archive.find("META-INF/container.xml")) {
+            pugi::xml_document containerXml;
+            const std::string xmlBuffer = archive.read(*entry);
+            auto parseResult = containerXml.load_buffer(xmlBuffer.data(), xmlBuffer.size());
+            if (!parseResult) {
+                throw std::runtime_error("Error parsing container.xml: " + std::string(parseResult.description()));
             }
-            return true;
-        });
+            if (auto path = containerXml.child("container").child("rootfiles").child("rootfile").attribute("full-path")) {
+                fileName = utils::stringToUtf8(path.value());
+            }
+        }
         return utils::utf8ToString(fileName);
     } catch (const std::exception& ex) {
-        denigmaContext.logMessage(LogMsg() << "unable to extract META-INF/container.xml from file " << utils::asUtf8Bytes(zipFilePath), MessageSeverity::Error);
+        denigmaContext.logMessage(LogMsg() << "unable to extract META-INF/container.xml from file " << utils::asUtf8Bytes(archive.path()), MessageSeverity::Error);
         denigmaContext.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
         throw;
     }
@@ -416,9 +747,230 @@ static std::string getMusicXmlScoreName(const std::filesystem::path& zipFilePath
 
 } // namespace
 
+struct ZipArchiveIndex::Impl
+{
+    std::filesystem::path path;
+    unzFile zip{};
+    std::vector<Entry> entries;
+    std::vector<ZipEntryInfo> entryInfo;
+    std::vector<unz64_file_pos> positions;
+    std::unordered_map<std::string, std::size_t> entriesByName;
+    std::mutex mutex;               // guards the unzFile cursor
+    std::mutex scoreNameMutex;
+    std::optional<std::string> scoreName;
+
+    ~Impl()
+    {
+        if (zip) {
+            unzClose(zip);
+        }
+    }
+
+    void load()
+    {
+        iterateFiles(zip, std::nullopt, [&](const ZipEntryInfo& fileInfo) {
+            unz64_file_pos position{};
+            if (unzGetFilePos64(zip, &position) != UNZ_OK) {
+                throw std::runtime_error("unable to record zip entry position");
+            }
+            Entry entry;
+            entry.ordinal = entries.size();
+            entry.filename = fileInfo.filename;
+            entry.compressedSize = fileInfo.info.compressed_size;
+            entry.uncompressedSize = fileInfo.info.uncompressed_size;
+            entry.crc = static_cast<std::uint32_t>(fileInfo.info.crc);
+            entry.method = static_cast<int>(fileInfo.info.compression_method);
+            entry.isFile = fileInfo.isFile;
+            entry.isDirectory = fileInfo.isDirectory;
+            entriesByName.emplace(entry.filename, entry.ordinal); // like unzLocateFile, the first of any duplicates wins
+            entries.emplace_back(std::move(entry));
+            entryInfo.emplace_back(fileInfo);
+            positions.emplace_back(position);
+            return true;
+        });
+    }
+
+    /// Moves the archive cursor to the entry at ordinal. The caller must hold #mutex.
+    void seek(std::size_t ordinal)
+    {
+        if (ordinal >= positions.size() || unzGoToFilePos64(zip, &positions[ordinal]) != UNZ_OK) {
+            throw std::runtime_error("unable to seek to entry in zip archive");
+        }
+    }
+
+    std::string read(std::size_t ordinal)
+    {
+        std::lock_guard lock(mutex);
+        seek(ordinal);
+        return readCurrentFile(zip);
+    }
+
+    CompressedZipEntry readRaw(std::size_t ordinal)
+    {
+        std::lock_guard lock(mutex);
+        seek(ordinal);
+        return readCurrentEntryRaw(zip, entryInfo[ordinal]);
+    }
+};
+
+/// Gives the archive rewriting code access to an index's raw entries.
+struct ZipArchiveAccess
+{
+    static ZipArchiveIndex::Impl& impl(const ZipArchiveIndex& archive) { return *archive.m_impl; }
+};
+
+ZipArchiveIndex::ZipArchiveIndex(const std::filesystem::path& zipFilePath, const DenigmaContext& denigmaContext)
+    : m_impl(std::make_unique<Impl>())
+{
+    m_impl->path = zipFilePath;
+    m_impl->zip = openZipForRead(zipFilePath, denigmaContext);
+    m_impl->load();
+}
+
+ZipArchiveIndex::ZipArchiveIndex(const IRandomAccessReader& reader, const DenigmaContext& denigmaContext)
+    : m_impl(std::make_unique<Impl>())
+{
+    m_impl->zip = openZipForRead(reader, denigmaContext);
+    m_impl->load();
+}
+
+ZipArchiveIndex::~ZipArchiveIndex() = default;
+
+const std::filesystem::path& ZipArchiveIndex::path() const
+{
+    return m_impl->path;
+}
+
+const std::vector<ZipArchiveIndex::Entry>& ZipArchiveIndex::entries() const
+{
+    return m_impl->entries;
+}
+
+const ZipArchiveIndex::Entry* ZipArchiveIndex::find(const std::string& fileName) const
+{
+    const auto it = m_impl->entriesByName.find(fileName);
+    return it == m_impl->entriesByName.end() ? nullptr : &m_impl->entries[it->second];
+}
+
+std::string ZipArchiveIndex::read(const Entry& entry) const
+{
+    return m_impl->read(entry.ordinal);
+}
+
+const std::string& ZipArchiveIndex::musicXmlScoreName(const DenigmaContext& denigmaContext) const
+{
+    std::lock_guard lock(m_impl->scoreNameMutex);
+    if (!m_impl->scoreName) {
+        m_impl->scoreName = getMusicXmlScoreName(*this, denigmaContext);
+    }
+    return *m_impl->scoreName;
+}
+
+struct ZipStreamWriter::Impl
+{
+    zipFile zip{};
+    bool entryOpen{};
+};
+
+ZipStreamWriter::ZipStreamWriter(const std::filesystem::path& outputPath)
+    : m_impl(std::make_unique<Impl>())
+{
+    m_impl->zip = openZipForWrite(outputPath);
+    if (!m_impl->zip) {
+        throw std::runtime_error("unable to create output zip archive");
+    }
+}
+
+ZipStreamWriter::ZipStreamWriter(std::string& output)
+    : m_impl(std::make_unique<Impl>())
+{
+    m_impl->zip = openZipForWrite(output);
+    if (!m_impl->zip) {
+        throw std::runtime_error("unable to create in-memory zip archive");
+    }
+}
+
+ZipStreamWriter::~ZipStreamWriter()
+{
+    if (m_impl->zip) {
+        if (m_impl->entryOpen) {
+            zipCloseFileInZip(m_impl->zip);
+        }
+        zipClose(m_impl->zip, nullptr);
+    }
+}
+
+void ZipStreamWriter::beginEntry(const std::string& fileName, int level)
+{
+    if (!m_impl->zip || m_impl->entryOpen) {
+        throw std::logic_error("zip entry started while another is open or after the archive was closed");
+    }
+    zip_fileinfo zipInfo = makeCurrentZipFileInfo();
+    const int rc = zipOpenNewFileInZip64(
+        m_impl->zip,
+        fileName.c_str(),
+        &zipInfo,
+        nullptr,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        level == 0 ? 0 : Z_DEFLATED,
+        level,
+        0
+    );
+    if (rc != ZIP_OK) {
+        throw std::runtime_error("unable to create " + fileName + " in output zip archive");
+    }
+    m_impl->entryOpen = true;
+}
+
+void ZipStreamWriter::write(std::span<const char> data)
+{
+    if (!m_impl->entryOpen) {
+        throw std::logic_error("zip entry data written with no open entry");
+    }
+    while (!data.empty()) {
+        const std::size_t chunkSize = (std::min<std::size_t>)(data.size(), MAX_ZIP_READ_BYTES);
+        if (zipWriteInFileInZip(m_impl->zip, data.data(), static_cast<unsigned>(chunkSize)) < 0) {
+            throw std::runtime_error("unable to write entry data to output zip archive");
+        }
+        data = data.subspan(chunkSize);
+    }
+}
+
+void ZipStreamWriter::endEntry()
+{
+    if (!m_impl->entryOpen) {
+        throw std::logic_error("zip entry finished with no open entry");
+    }
+    m_impl->entryOpen = false;
+    if (zipCloseFileInZip(m_impl->zip) != ZIP_OK) {
+        throw std::runtime_error("unable to finalize entry in output zip archive");
+    }
+}
+
+void ZipStreamWriter::writeEntry(const std::string& fileName, std::span<const char> contents, int level)
+{
+    beginEntry(fileName, level);
+    write(contents);
+    endEntry();
+}
+
+void ZipStreamWriter::close()
+{
+    if (m_impl->entryOpen) {
+        throw std::logic_error("zip archive closed with an open entry");
+    }
+    zipFile zip = std::exchange(m_impl->zip, nullptr);
+    if (zip && zipClose(zip, nullptr) != ZIP_OK) {
+        throw std::runtime_error("unable to finalize output zip archive");
+    }
+}
+
 std::string readFile(const std::filesystem::path& zipFilePath, const std::string& fileName, const DenigmaContext& denigmaContext)
 {
-    FileRandomAccessReader reader(zipFilePath);
+    MappedFileRandomAccessReader reader(zipFilePath);
     return readFile(reader, fileName, denigmaContext);
 }
 
@@ -439,9 +991,63 @@ std::string readFile(const IRandomAccessReader& reader, const std::string& fileN
     }
 }
 
+std::string readFile(const ZipArchiveIndex& archive, const std::string& fileName)
+{
+    const auto* entry = archive.find(fileName);
+    if (!entry) {
+        throw std::runtime_error("unable to locate file in zip archive: " + fileName);
+    }
+    return archive.read(*entry);
+}
+
+void readFileInChunks(const IRandomAccessReader& reader, const std::string& fileName, std::size_t chunkSize,
+    const std::function<void(std::span<char>)>& consumer, const DenigmaContext& denigmaContext)
+{
+    if (chunkSize == 0 || chunkSize > MAX_ZIP_READ_BYTES) {
+        throw std::invalid_argument("zip read chunk size is out of range");
+    }
+    unzFile zip = openZipForRead(reader, denigmaContext);
+    try {
+        if (unzLocateFile(zip, fileName.c_str(), 1) != UNZ_OK) {
+            throw std::runtime_error("unable to locate file in zip archive: " + fileName);
+        }
+        if (unzOpenCurrentFile(zip) != UNZ_OK) {
+            throw std::runtime_error("unable to open entry in zip archive");
+        }
+        std::vector<char> chunk(chunkSize);
+        bool atEnd = false;
+        while (!atEnd) {
+            denigmaContext.checkCancelled();
+            std::size_t used = 0;
+            while (used < chunk.size()) {
+                const int readRc = unzReadCurrentFile(zip, chunk.data() + used, static_cast<unsigned>(chunk.size() - used));
+                if (readRc < 0) {
+                    unzCloseCurrentFile(zip);
+                    throw std::runtime_error("unable to read entry from zip archive");
+                }
+                if (readRc == 0) {
+                    atEnd = true;
+                    break;
+                }
+                used += static_cast<std::size_t>(readRc);
+            }
+            if (used > 0) {
+                consumer(std::span<char>(chunk.data(), used));
+            }
+        }
+        if (unzCloseCurrentFile(zip) != UNZ_OK) {
+            throw std::runtime_error("unable to close entry in zip archive"); // includes a CRC mismatch
+        }
+        unzClose(zip);
+    } catch (...) {
+        unzClose(zip);
+        throw;
+    }
+}
+
 MusxArchiveFiles readMusxArchiveFiles(const std::filesystem::path& zipFilePath, const DenigmaContext& denigmaContext)
 {
-    FileRandomAccessReader reader(zipFilePath);
+    MappedFileRandomAccessReader reader(zipFilePath);
     return readMusxArchiveFiles(reader, denigmaContext);
 }
 
@@ -451,11 +1057,27 @@ MusxArchiveFiles readMusxArchiveFiles(const IRandomAccessReader& reader, const D
     constexpr char kNotationMetadataName[] = "NotationMetadata.xml";
     constexpr char8_t kGraphicsDirName[] = u8"graphics";
 
+    auto isGraphicsEntry = [&](const ZipEntryInfo& fileInfo) {
+        const std::filesystem::path entryPath = utils::utf8ToPath(fileInfo.filename);
+        return fileInfo.isFile && entryPath.parent_path().u8string() == kGraphicsDirName && entryPath.has_filename();
+    };
+
     unzFile zip = openZipForRead(reader, denigmaContext);
     try {
+        // Tell the reader which entries are about to be read, so that a remote reader can fetch them together.
+        std::vector<ByteRange> entryRanges;
+        iterateFiles(zip, std::nullopt, [&](const ZipEntryInfo& fileInfo) {
+            if (fileInfo.filename == kScoreDatName || fileInfo.filename == kNotationMetadataName || isGraphicsEntry(fileInfo)) {
+                entryRanges.emplace_back(currentEntryRange(zip, fileInfo));
+            }
+            return true;
+        });
+        reader.prefetch(entryRanges);
+
         MusxArchiveFiles result;
         bool foundScoreDat = false;
         iterateFiles(zip, std::nullopt, [&](const ZipEntryInfo& fileInfo) {
+            denigmaContext.checkCancelled();
             if (fileInfo.filename == kScoreDatName) {
                 result.scoreDat = readCurrentFile(zip);
                 foundScoreDat = true;
@@ -467,16 +1089,18 @@ MusxArchiveFiles readMusxArchiveFiles(const IRandomAccessReader& reader, const D
                 return true;
             }
 
-            const std::filesystem::path entryPath = utils::utf8ToPath(fileInfo.filename);
-            if (!fileInfo.isFile
-                || entryPath.parent_path().u8string() != kGraphicsDirName
-                || !entryPath.has_filename()) {
+            if (!isGraphicsEntry(fileInfo)) {
                 return true;
             }
 
             denigma::CommandInputData::EmbeddedGraphicFile graphicFile;
-            graphicFile.filename = utils::utf8ToString(entryPath.filename().u8string());
-            graphicFile.blob = readCurrentFile(zip);
+            graphicFile.filename = utils::utf8ToString(utils::utf8ToPath(fileInfo.filename).filename().u8string());
+            // Keep the graphic compressed until a converter asks for it; most never do.
+            auto rawEntry = std::make_shared<const CompressedZipEntry>(readCurrentEntryRaw(zip, fileInfo));
+            graphicFile.size = static_cast<std::size_t>(rawEntry->uncompressedSize);
+            graphicFile.inflateInto = [rawEntry](std::span<std::byte> output) {
+                inflateRawEntry(*rawEntry, std::span<char>(reinterpret_cast<char*>(output.data()), output.size()));
+            };
             result.embeddedGraphics.emplace_back(std::move(graphicFile));
             return true;
         });
@@ -495,83 +1119,162 @@ MusxArchiveFiles readMusxArchiveFiles(const IRandomAccessReader& reader, const D
 
 std::string getMusicXmlScoreFile(const std::filesystem::path& zipFilePath, const denigma::DenigmaContext& denigmaContext)
 {
-    unzFile zip = openZipForRead(zipFilePath, denigmaContext);
-    try {
-        std::string scoreName = getMusicXmlScoreName(zipFilePath, zip, denigmaContext);
-        const int rc = unzLocateFile(zip, scoreName.c_str(), 1);
-        if (rc != UNZ_OK) {
-            throw std::runtime_error("unable to locate score in zip archive: " + scoreName);
-        }
-        std::string output = readCurrentFile(zip);
-        unzClose(zip);
-        return output;
-    } catch (...) {
-        unzClose(zip);
-        throw;
+    const ZipArchiveIndex archive(zipFilePath, denigmaContext);
+    return getMusicXmlScoreFile(archive, denigmaContext);
+}
+
+std::string getMusicXmlScoreFile(const ZipArchiveIndex& archive, const denigma::DenigmaContext& denigmaContext)
+{
+    const std::string& scoreName = archive.musicXmlScoreName(denigmaContext);
+    const auto* entry = archive.find(scoreName);
+    if (!entry) {
+        throw std::runtime_error("unable to locate score in zip archive: " + scoreName);
     }
+    return archive.read(*entry);
 }
 
 bool iterateMusicXmlPartFiles(const std::filesystem::path& zipFilePath, const denigma::DenigmaContext& denigmaContext, const std::optional<std::string>& fileName, IteratorFunc iterator)
 {
-    unzFile zip = openZipForRead(zipFilePath, denigmaContext);
+    const ZipArchiveIndex archive(zipFilePath, denigmaContext);
+    return iterateMusicXmlPartFiles(archive, denigmaContext, fileName, std::move(iterator));
+}
+
+bool iterateMusicXmlPartFiles(const ZipArchiveIndex& archive, const denigma::DenigmaContext& denigmaContext, const std::optional<std::string>& fileName, IteratorFunc iterator)
+{
+    const std::string& scoreName = archive.musicXmlScoreName(denigmaContext);
+    for (const auto& entry : archive.entries()) {
+        if (!entry.isFile) {
+            continue;
+        }
+        if (scoreName == entry.filename) {
+            continue; // skip score
+        }
+        if (fileName.has_value() && fileName.value() != entry.filename) {
+            continue; // skip parts that aren't the one we are looking for
+        }
+        std::filesystem::path nextPath = utils::utf8ToPath(entry.filename);
+        if (utils::pathExtensionEquals(nextPath, MUSICXML_EXTENSION) && !iterator(nextPath, archive.read(entry))) {
+            break;
+        }
+    }
+    return !archive.entries().empty();
+}
+
+bool iterateModifyFilesInPlace(const std::filesystem::path& zipFilePath, const std::filesystem::path& outputPath, const denigma::DenigmaContext& denigmaContext, ModifyIteratorFunc iterator)
+{
+    const ZipArchiveIndex archive(zipFilePath, denigmaContext);
+    return iterateModifyFilesInPlace(archive, outputPath, denigmaContext, std::move(iterator));
+}
+
+bool iterateModifyFilesInPlace(const ZipArchiveIndex& archive, const std::filesystem::path& outputPath, const denigma::DenigmaContext& denigmaContext, ModifyIteratorFunc iterator)
+{
+    zipFile outputZip = openZipForWrite(outputPath);
+    if (!outputZip) {
+        denigmaContext.logMessage(LogMsg() << "unable to save data to file " << utils::asUtf8Bytes(outputPath), MessageSeverity::Error);
+        throw std::runtime_error("unable to create output zip archive");
+    }
+
     try {
-        const std::string scoreName = getMusicXmlScoreName(zipFilePath, zip, denigmaContext);
-        bool retval = iterateFiles(zip, std::nullopt, [&](const ZipEntryInfo& fileInfo) {
-            if (!fileInfo.isFile) {
-                return true;
-            }
-            if (scoreName == fileInfo.filename) {
-                return true; // skip score
-            }
-            if (fileName.has_value() && fileName.value() != fileInfo.filename) {
-                return true; // skip parts that aren't the one we are looking for
+        auto& archiveImpl = ZipArchiveAccess::impl(archive);
+        const std::string& scoreName = archive.musicXmlScoreName(denigmaContext);
+        // The iterator runs serially, in archive order. Entries it changed are compressed afterwards on up to
+        // denigmaContext.outputJobs threads and written in the original order; unchanged ones keep their
+        // compressed bytes.
+        struct PendingEntry
+        {
+            ZipEntryInfo fileInfo;
+            std::optional<std::string> changedContents;
+            std::optional<CompressedZipEntry> rawEntry;
+        };
+        std::vector<PendingEntry> pendingEntries;
+        for (const auto& entry : archive.entries()) {
+            if (!entry.isFile) {
+                continue;
             }
-            std::filesystem::path nextPath = utils::utf8ToPath(fileInfo.filename);
-            if (utils::pathExtensionEquals(nextPath, MUSICXML_EXTENSION)) {
-                return iterator(nextPath, readCurrentFile(zip));
+            std::filesystem::path nextPath = utils::utf8ToPath(entry.filename);
+            std::string buffer = archive.read(entry);
+            const std::string original = buffer;
+            if (iterator(nextPath, buffer, scoreName == entry.filename)) {
+                PendingEntry pending{ archiveImpl.entryInfo[entry.ordinal], std::nullopt, std::nullopt };
+                if (buffer == original) {
+                    pending.rawEntry = archiveImpl.readRaw(entry.ordinal);
+                } else {
+                    pending.changedContents = std::move(buffer);
+                }
+                pendingEntries.emplace_back(std::move(pending));
             }
-            return true;
-        });
-        unzClose(zip);
-        return retval;
-    } catch (...) {
-        unzClose(zip);
+        }
+
+        denigma::forEachInOrder<CompressedZipEntry>(pendingEntries.size(), denigmaContext,
+            [&](const DenigmaContext&, std::size_t index) {
+                PendingEntry& pending = pendingEntries[index];
+                if (pending.rawEntry) {
+                    return std::move(*pending.rawEntry);
+                }
+                CompressedZipEntry entry = compressZipEntry(pending.fileInfo, *pending.changedContents);
+                pending.changedContents.reset();
+                return entry;
+            },
+            [&](std::size_t index, CompressedZipEntry&& entry) {
+                writeRawEntryToZip(outputZip, pendingEntries[index].fileInfo, entry);
+            });
+
+        zipClose(outputZip, nullptr);
+        return !archive.entries().empty();
+    } catch (const std::exception& ex) {
+        denigmaContext.logMessage(LogMsg() << "unable to save data to file " << utils::asUtf8Bytes(outputPath), MessageSeverity::Error);
+        denigmaContext.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
+        zipClose(outputZip, nullptr);
         throw;
     }
 }
 
-bool iterateModifyFilesInPlace(const std::filesystem::path& zipFilePath, const std::filesystem::path& outputPath, const denigma::DenigmaContext& denigmaContext, ModifyIteratorFunc iterator)
+bool iterateModifyFilesConcurrently(const std::filesystem::path& zipFilePath, const std::filesystem::path& outputPath, const denigma::DenigmaContext& denigmaContext, ConcurrentModifyIteratorFunc iterator)
 {
-    unzFile inputZip = openZipForRead(zipFilePath, denigmaContext);
+    const ZipArchiveIndex archive(zipFilePath, denigmaContext);
     zipFile outputZip = openZipForWrite(outputPath);
     if (!outputZip) {
-        unzClose(inputZip);
         denigmaContext.logMessage(LogMsg() << "unable to save data to file " << utils::asUtf8Bytes(outputPath), MessageSeverity::Error);
         throw std::runtime_error("unable to create output zip archive");
     }
 
     try {
-        const std::string scoreName = getMusicXmlScoreName(zipFilePath, inputZip, denigmaContext);
-        bool retval = iterateFiles(inputZip, std::nullopt, [&](const ZipEntryInfo& fileInfo) {
-            if (!fileInfo.isFile) {
-                return true;
-            }
-            std::filesystem::path nextPath = utils::utf8ToPath(fileInfo.filename);
-            std::string buffer = readCurrentFile(inputZip);
-            if (iterator(nextPath, buffer, scoreName == fileInfo.filename)) {
-                writeEntryToZip(outputZip, fileInfo, buffer);
+        auto& archiveImpl = ZipArchiveAccess::impl(archive);
+        const std::string& scoreName = archive.musicXmlScoreName(denigmaContext);
+        std::vector<const ZipArchiveIndex::Entry*> fileEntries;
+        for (const auto& entry : archive.entries()) {
+            if (entry.isFile) {
+                fileEntries.push_back(&entry);
             }
-            return true;
-        });
+        }
+
+        // Each file is read, modified and, if it changed, compressed on a worker; unchanged files keep their
+        // compressed bytes. Skipped files produce nothing.
+        denigma::forEachInOrder<std::optional<CompressedZipEntry>>(fileEntries.size(), denigmaContext,
+            [&](const DenigmaContext& workerContext, std::size_t index) -> std::optional<CompressedZipEntry> {
+                const auto& entry = *fileEntries[index];
+                std::string buffer = archive.read(entry);
+                const std::string original = buffer;
+                if (!iterator(workerContext, utils::utf8ToPath(entry.filename), buffer, scoreName == entry.filename)) {
+                    return std::nullopt;
+                }
+                if (buffer == original) {
+                    return archiveImpl.readRaw(entry.ordinal);
+                }
+                return compressZipEntry(archiveImpl.entryInfo[entry.ordinal], buffer);
+            },
+            [&](std::size_t index, std::optional<CompressedZipEntry>&& entry) {
+                if (entry) {
+                    writeRawEntryToZip(outputZip, archiveImpl.entryInfo[fileEntries[index]->ordinal], *entry);
+                }
+            });
 
         zipClose(outputZip, nullptr);
-        unzClose(inputZip);
-        return retval;
+        return !archive.entries().empty();
     } catch (const std::exception& ex) {
         denigmaContext.logMessage(LogMsg() << "unable to save data to file " << utils::asUtf8Bytes(outputPath), MessageSeverity::Error);
         denigmaContext.logMessage(LogMsg() << " (exception: " << ex.what() << ")", MessageSeverity::Error);
         zipClose(outputZip, nullptr);
-        unzClose(inputZip);
         throw;
     }
 }
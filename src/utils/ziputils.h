@@ -21,9 +21,15 @@
  */
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <filesystem>
 #include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
 
 #include "denigma/io/random_access_reader.h"
 #include "core/denigma.h"
@@ -37,6 +43,91 @@ struct MusxArchiveFiles
     std::vector<denigma::CommandInputData::EmbeddedGraphicFile> embeddedGraphics;
 };
 
+/**
+ * @class ZipArchiveIndex
+ * @brief An open zip archive whose central directory has been read once.
+ *
+ * Several passes over one archive (for example the MusicXML score and then its parts) can share an index instead of
+ * each reopening the archive and walking its central directory: entries are then read directly from their recorded
+ * positions. Reads are serialized internally, so an index may be shared between threads.
+ */
+class ZipArchiveIndex
+{
+public:
+    /// @brief One entry of the central directory.
+    struct Entry
+    {
+        std::size_t ordinal{};              ///< position of this entry in #entries
+        std::string filename;               ///< utf-8 encoded name within the archive
+        std::uint64_t compressedSize{};     ///< stored size in bytes
+        std::uint64_t uncompressedSize{};   ///< inflated size in bytes
+        std::uint32_t crc{};                ///< CRC-32 of the inflated data
+        int method{};                       ///< zip compression method (0 = stored, 8 = deflated)
+        bool isFile{};                      ///< regular file (not a directory or symlink)
+        bool isDirectory{};                 ///< directory entry
+    };
+
+    /// Opens the archive at zipFilePath and reads its central directory. Throws if it cannot be read.
+    ZipArchiveIndex(const std::filesystem::path& zipFilePath, const denigma::DenigmaContext& denigmaContext);
+    /// Reads the central directory of an archive supplied by reader, which must outlive the index.
+    ZipArchiveIndex(const denigma::IRandomAccessReader& reader, const denigma::DenigmaContext& denigmaContext);
+    ~ZipArchiveIndex();
+
+    ZipArchiveIndex(const ZipArchiveIndex&) = delete;
+    ZipArchiveIndex& operator=(const ZipArchiveIndex&) = delete;
+
+    /// The path given to the constructor, or empty for a reader-backed archive.
+    const std::filesystem::path& path() const;
+    /// All entries, in central-directory order.
+    const std::vector<Entry>& entries() const;
+    /// The entry named fileName (utf-8), or nullptr.
+    const Entry* find(const std::string& fileName) const;
+    /// Inflates and returns the contents of entry.
+    std::string read(const Entry& entry) const;
+    /// The MusicXML score file named by META-INF/container.xml (or derived from #path), resolved on first use.
+    const std::string& musicXmlScoreName(const denigma::DenigmaContext& denigmaContext) const;
+
+private:
+    struct Impl;
+    friend struct ZipArchiveAccess;
+    std::unique_ptr<Impl> m_impl;
+};
+
+/**
+ * @class ZipStreamWriter
+ * @brief Writes a new zip archive one entry at a time, deflating each entry as its bytes arrive.
+ *
+ * Callers never hold a whole entry in memory. Entries are dated with the current local time.
+ */
+class ZipStreamWriter
+{
+public:
+    /// Creates (or replaces) the archive at outputPath. Throws if it cannot be created.
+    explicit ZipStreamWriter(const std::filesystem::path& outputPath);
+    /// Builds the archive in output, replacing its contents. output must outlive the writer and is complete after #close.
+    explicit ZipStreamWriter(std::string& output);
+    /// Closes the archive if #close was not called, discarding any error. Call #close to see errors.
+    ~ZipStreamWriter();
+
+    ZipStreamWriter(const ZipStreamWriter&) = delete;
+    ZipStreamWriter& operator=(const ZipStreamWriter&) = delete;
+
+    /// Starts a new entry named fileName (utf-8), deflated at level (-1 = zlib default) or stored if level is 0.
+    void beginEntry(const std::string& fileName, int level = -1);
+    /// Appends data to the current entry.
+    void write(std::span<const char> data);
+    /// Finishes the current entry.
+    void endEntry();
+    /// Writes an entry whose complete contents are already in memory.
+    void writeEntry(const std::string& fileName, std::span<const char> contents, int level = -1);
+    /// Writes the central directory and closes the archive. Throws if that fails.
+    void close();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
 /**
  * @brief Reads a specific filename from the input zip archive.
  * @param zipFilePath [in] the zip archive to search.
@@ -45,6 +136,19 @@ struct MusxArchiveFiles
  */
 std::string readFile(const std::filesystem::path& zipFilePath, const std::string& fileName, const denigma::DenigmaContext& denigmaContext);
 std::string readFile(const denigma::IRandomAccessReader& reader, const std::string& fileName, const denigma::DenigmaContext& denigmaContext);
+std::string readFile(const ZipArchiveIndex& archive, const std::string& fileName);
+
+/**
+ * @brief Streams a file from the input zip archive in fixed-size chunks, never holding all of it.
+ * @param reader [in] the zip archive to search.
+ * @param fileName [in] the utf8-encoded file name to search for within the archive.
+ * @param chunkSize [in] the size of every chunk but the last.
+ * @param consumer [in] called with each inflated chunk in order. It may modify the chunk in place.
+ * @param denigmaContext [in] the DenigmaContext (for logging).
+ */
+void readFileInChunks(const denigma::IRandomAccessReader& reader, const std::string& fileName, std::size_t chunkSize,
+    const std::function<void(std::span<char>)>& consumer, const denigma::DenigmaContext& denigmaContext);
+
 MusxArchiveFiles readMusxArchiveFiles(const std::filesystem::path& zipFilePath, const denigma::DenigmaContext& denigmaContext);
 MusxArchiveFiles readMusxArchiveFiles(const denigma::IRandomAccessReader& reader, const denigma::DenigmaContext& denigmaContext);
 
@@ -57,6 +161,7 @@ using IteratorFunc = std::function<bool(const std::filesystem::path& fileName, c
  * @param denigmaContext [in] the DenigmaContext (for logging).
  */
 std::string getMusicXmlScoreFile(const std::filesystem::path& zipFilePath, const denigma::DenigmaContext& denigmaContext);
+std::string getMusicXmlScoreFile(const ZipArchiveIndex& archive, const denigma::DenigmaContext& denigmaContext);
 
 /**
  * @brief Iterates through each music xml part file in a compressed MusicXml file. (The score is skipped.)
@@ -66,6 +171,7 @@ std::string getMusicXmlScoreFile(const std::filesystem::path& zipFilePath, const
  * @param iterator an iterator function that feeds the next filename and xmldata. Return `false` from this function to stop iterating.
  */
 bool iterateMusicXmlPartFiles(const std::filesystem::path& zipFilePath, const denigma::DenigmaContext& denigmaContext, const std::optional<std::string>& fileName, IteratorFunc iterator);
+bool iterateMusicXmlPartFiles(const ZipArchiveIndex& archive, const denigma::DenigmaContext& denigmaContext, const std::optional<std::string>& fileName, IteratorFunc iterator);
 
 using ModifyIteratorFunc = std::function<bool(const std::filesystem::path& fileName, std::string& fileContents, bool isScore)>;
 
@@ -77,5 +183,20 @@ using ModifyIteratorFunc = std::function<bool(const std::filesystem::path& fileN
  * @param iterator an iterator function that feeds the next filename and xmldata. You can modify the xmldata. You can skip a file by returning false.
  */
 bool iterateModifyFilesInPlace(const std::filesystem::path& zipFilePath, const std::filesystem::path& outputPath, const denigma::DenigmaContext& denigmaContext, ModifyIteratorFunc iterator);
+bool iterateModifyFilesInPlace(const ZipArchiveIndex& archive, const std::filesystem::path& outputPath, const denigma::DenigmaContext& denigmaContext, ModifyIteratorFunc iterator);
+
+using ConcurrentModifyIteratorFunc = std::function<bool(const denigma::DenigmaContext& workerContext, const std::filesystem::path& fileName, std::string& fileContents, bool isScore)>;
+
+/**
+ * @brief Like #iterateModifyFilesInPlace, but calls the iterator for up to denigmaContext.outputJobs files concurrently.
+ *
+ * The iterator must log through workerContext, whose messages are replayed in archive order, and must not share
+ * mutable state between calls. Files are written in their original order.
+ * @param zipFilePath [in] the compressed MusicXml archive to modify.
+ * @param outputPath [in] the path of the modified archive.
+ * @param denigmaContext [in] the DenigmaContext (for logging and the job count).
+ * @param iterator an iterator function that feeds the next filename and xmldata. You can modify the xmldata. You can skip a file by returning false.
+ */
+bool iterateModifyFilesConcurrently(const std::filesystem::path& zipFilePath, const std::filesystem::path& outputPath, const denigma::DenigmaContext& denigmaContext, ConcurrentModifyIteratorFunc iterator);
 
 } // namespace utils
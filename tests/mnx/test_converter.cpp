@@ -19,6 +19,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <sstream>
@@ -103,6 +104,136 @@ TEST(ConverterApi, MusxToMnxJsonWritesToStream)
     EXPECT_EQ(source["filename"], "notAscii-其れ.musx");
 }
 
+TEST(ConverterApi, MusxToMnxBinaryEncodingsMatchJson)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mnx::registerConverters(registry);
+    const auto* converter = registry.findReader(denigma::FormatId::Musx, denigma::FormatId::MnxJson);
+    ASSERT_NE(converter, nullptr);
+
+    auto convertWith = [&](denigma::formats::mnx::Encoding encoding) {
+        denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+        std::ostringstream output;
+        denigma::formats::mnx::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.validate = false;
+        options.encoding = encoding;
+        const auto result = converter->convert(input, output, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        return output.str();
+    };
+
+    const auto json = nlohmann::json::parse(convertWith(denigma::formats::mnx::Encoding::Json));
+    const std::string cbor = convertWith(denigma::formats::mnx::Encoding::Cbor);
+    const std::string msgpack = convertWith(denigma::formats::mnx::Encoding::MessagePack);
+    const std::string bson = convertWith(denigma::formats::mnx::Encoding::Bson);
+    ASSERT_FALSE(cbor.empty());
+    ASSERT_FALSE(msgpack.empty());
+    ASSERT_FALSE(bson.empty());
+    EXPECT_LT(cbor.size(), json.dump().size());
+    EXPECT_EQ(nlohmann::json::from_cbor(cbor), json);
+    EXPECT_EQ(nlohmann::json::from_msgpack(msgpack), json);
+    EXPECT_EQ(nlohmann::json::from_bson(bson), json);
+}
+
+TEST(ConverterApi, MusxToMnxConcurrentValidationMatchesSerial)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mnx::registerConverters(registry);
+    const auto* converter = registry.findReader(denigma::FormatId::Musx, denigma::FormatId::MnxJson);
+    ASSERT_NE(converter, nullptr);
+
+    struct Run
+    {
+        std::string output;
+        std::vector<std::string> messages;
+        std::size_t diagnosticCount{};
+    };
+    auto convertWith = [&](bool concurrently) {
+        Run run;
+        denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+        std::ostringstream output;
+        denigma::formats::mnx::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.validateConcurrently = concurrently;
+        options.common.logCallback = [&run](denigma::MessageSeverity, std::string_view message) {
+            run.messages.emplace_back(message);
+        };
+        const auto result = converter->convert(input, output, denigma::ConversionRequest{ &options });
+        run.output = output.str();
+        run.diagnosticCount = result.diagnostics().size();
+        return run;
+    };
+
+    const Run serial = convertWith(false);
+    const Run concurrent = convertWith(true);
+    ASSERT_FALSE(concurrent.output.empty());
+    EXPECT_EQ(concurrent.output, serial.output);
+    EXPECT_EQ(concurrent.messages, serial.messages);
+    EXPECT_EQ(concurrent.diagnosticCount, serial.diagnosticCount);
+    EXPECT_NE(std::find_if(concurrent.messages.begin(), concurrent.messages.end(),
+                           [](const std::string& message) { return message.starts_with("Schema validation"); }),
+              concurrent.messages.end());
+}
+
+TEST(ConverterApi, MusxToMnxParallelPartsMatchSerial)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mnx::registerConverters(registry);
+    const auto* converter = registry.findReader(denigma::FormatId::Musx, denigma::FormatId::MnxJson);
+    ASSERT_NE(converter, nullptr);
+
+    auto convertWithJobs = [&](unsigned outputJobs) {
+        denigma::FileRandomAccessReader input(getInputPath() / "large_orchestra.musx");
+        std::ostringstream output;
+        denigma::formats::mnx::Options options;
+        options.common.sourceName = "large_orchestra.musx";
+        options.common.validate = false;
+        options.common.outputJobs = outputJobs;
+        const auto result = converter->convert(input, output, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        return output.str();
+    };
+
+    const std::string serial = convertWithJobs(1);
+    const std::string parallel = convertWithJobs(4);
+    ASSERT_FALSE(serial.empty());
+    EXPECT_EQ(parallel, serial);
+}
+
+TEST(ConverterApi, MusxToMnxValidateEverySamplesConversions)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mnx::registerConverters(registry);
+    const auto* converter = registry.findReader(denigma::FormatId::Musx, denigma::FormatId::MnxJson);
+    ASSERT_NE(converter, nullptr);
+
+    int validatedCount = 0;
+    for (int run = 0; run < 2; run++) {
+        denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+        std::ostringstream output;
+        denigma::formats::mnx::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.validateEvery = 2;
+        options.common.logCallback = [&validatedCount](denigma::MessageSeverity, std::string_view message) {
+            if (message.starts_with("Schema validation")) {
+                validatedCount++;
+            }
+        };
+        converter->convert(input, output, denigma::ConversionRequest{ &options });
+        EXPECT_FALSE(output.str().empty());
+    }
+    EXPECT_EQ(validatedCount, 1);
+}
+
 TEST(ConverterApi, EnigmaXmlToMnxJsonCollectsErrorDiagnosticsForInvalidXml)
 {
     denigma::ConverterRegistry registry;
@@ -41,6 +41,18 @@ TEST(Schema, InputSchemaValid)
     });
 }
 
+TEST(Schema, InputSchemaValidWithOutputJobs)
+{
+    setupTestDataPaths();
+    std::filesystem::path inputPath;
+    copyInputToOutput("notAscii-其れ.musx", inputPath);
+    const std::filesystem::path schemaPath = MNX_W3C_SCHEMA_PATH;
+    ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), "--mnx", "--mnx-schema", pathString(schemaPath), "--output-jobs", "4" };
+    checkStderr({ "Processing", pathString(inputPath.filename()), "!Schema validation errors" }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "validate by section " << pathString(inputPath);
+    });
+}
+
 TEST(Schema, InputSchemaNotValid)
 {
     setupTestDataPaths();
@@ -62,3 +74,17 @@ TEST(Schema, EmbeddedSchemaValid)
         EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "validate " << pathString(inputPath);
     });
 }
+
+TEST(Schema, InputSchemaReusedAcrossFiles)
+{
+    setupTestDataPaths();
+    std::filesystem::path firstInputPath;
+    copyInputToOutput("notAscii-其れ.musx", firstInputPath);
+    std::filesystem::path secondInputPath;
+    copyInputToOutput("multimeas_beam.musx", secondInputPath);
+    const std::filesystem::path schemaPath = MNX_W3C_SCHEMA_PATH;
+    ArgList args = { DENIGMA_NAME, "export", pathString(firstInputPath), pathString(secondInputPath), "--mnx", "--mnx-schema", pathString(schemaPath) };
+    checkStderr({ pathString(firstInputPath.filename()), pathString(secondInputPath.filename()), "!Schema validation errors" }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "validate " << pathString(firstInputPath) << " and " << pathString(secondInputPath);
+    });
+}
@@ -16,10 +16,18 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstring>
+#include <functional>
+#include <future>
+#include <memory_resource>
+#include <mutex>
 #include <span>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -30,6 +38,45 @@
 #include "musicxml_test.h"
 #include "test_utils.h"
 
+namespace {
+
+// stands in for a host application's pool: one thread per task, joined when the test finishes
+class ThreadPerTaskExecutor final : public denigma::IExecutor
+{
+public:
+    ~ThreadPerTaskExecutor() override
+    {
+        while (true) {
+            std::vector<std::thread> threads;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                threads.swap(m_threads);
+            }
+            if (threads.empty()) {
+                break;
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+    }
+    void submit(std::function<void()> task) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_submitted.fetch_add(1);
+        m_threads.emplace_back(std::move(task));
+    }
+    unsigned concurrency() const override { return 3; }
+    int submitted() const { return m_submitted.load(); }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::thread> m_threads;
+    std::atomic<int> m_submitted{};
+};
+
+} // namespace
+
 TEST(ConverterApi, EnigmaXmlToMusicXmlWritesToStream)
 {
     setupTestDataPaths();
@@ -130,6 +177,425 @@ TEST(ConverterApi, MusxToMusicXmlInvokesOutputCallbackForParts)
     EXPECT_TRUE(foundNamedPart);
 }
 
+TEST(ConverterApi, MusxToMusicXmlStreamsIntoSink)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    class RecordingSink final : public denigma::IMultiOutputSink
+    {
+    public:
+        bool begin(std::string_view suggestedName) override
+        {
+            EXPECT_FALSE(inDocument);
+            inDocument = true;
+            names.emplace_back(suggestedName);
+            documents.emplace_back();
+            // skip every linked part except the first one offered
+            return suggestedName.empty() || names.size() == 2;
+        }
+
+        void write(std::span<const std::byte> data) override
+        {
+            EXPECT_TRUE(inDocument);
+            documents.back().append(reinterpret_cast<const char*>(data.data()), data.size());
+            ++writeCount;
+        }
+
+        void end() override
+        {
+            EXPECT_TRUE(inDocument);
+            inDocument = false;
+        }
+
+        bool inDocument{};
+        size_t writeCount{};
+        std::vector<std::string> names;
+        std::vector<std::string> documents;
+    };
+
+    RecordingSink sink;
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    denigma::formats::musicxml::Options options;
+    options.common.sourceName = "notAscii-其れ.musx";
+    options.allPartsAndScore = true;
+    const auto result = converter->convert(input, sink, denigma::ConversionRequest{ &options });
+
+    EXPECT_TRUE(result.diagnostics().empty());
+    ASSERT_GE(sink.names.size(), 2);
+    EXPECT_EQ(sink.names.front(), "");
+    EXPECT_GE(sink.writeCount, 2u);
+    for (size_t x = 0; x < sink.documents.size(); x++) {
+        if (x >= 2) {
+            EXPECT_TRUE(sink.documents[x].empty()) << "skipped document " << sink.names[x] << " received data";
+            continue;
+        }
+        pugi::xml_document document;
+        const auto parseResult = document.load_string(sink.documents[x].c_str());
+        ASSERT_TRUE(parseResult) << parseResult.description();
+        EXPECT_TRUE(document.child("score-partwise"));
+    }
+}
+
+TEST(ConverterApi, MusxToMusicXmlParallelPartsMatchSerialOrder)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    auto convertWithJobs = [&](unsigned outputJobs) {
+        std::vector<std::pair<std::string, std::string>> outputs;
+        denigma::formats::musicxml::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.outputJobs = outputJobs;
+        options.allPartsAndScore = true;
+        const auto result = converter->convert(input, [&](std::string_view suggestedName, std::span<const std::byte> data) {
+            outputs.emplace_back(std::string(suggestedName), std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        return outputs;
+    };
+
+    const auto serialOutputs = convertWithJobs(1);
+    const auto parallelOutputs = convertWithJobs(4);
+    ASSERT_GE(serialOutputs.size(), 2);
+    ASSERT_EQ(parallelOutputs.size(), serialOutputs.size());
+    for (size_t x = 0; x < serialOutputs.size(); x++) {
+        EXPECT_EQ(parallelOutputs[x].first, serialOutputs[x].first);
+        EXPECT_EQ(parallelOutputs[x].second, serialOutputs[x].second) << "output " << x << " differs";
+    }
+}
+
+TEST(ConverterApi, MusxToMusicXmlDedupedPartsMatchConvertedParts)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    auto convertWith = [&](bool dedupeParts, unsigned outputJobs) {
+        std::vector<std::pair<std::string, std::string>> outputs;
+        denigma::formats::musicxml::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.outputJobs = outputJobs;
+        options.allPartsAndScore = true;
+        options.dedupeParts = dedupeParts;
+        const auto result = converter->convert(input, [&](std::string_view suggestedName, std::span<const std::byte> data) {
+            outputs.emplace_back(std::string(suggestedName), std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        return outputs;
+    };
+
+    const auto convertedOutputs = convertWith(false, 1);
+    ASSERT_GE(convertedOutputs.size(), 2);
+    for (const unsigned outputJobs : { 1u, 4u }) {
+        const auto dedupedOutputs = convertWith(true, outputJobs);
+        ASSERT_EQ(dedupedOutputs.size(), convertedOutputs.size());
+        for (size_t x = 0; x < convertedOutputs.size(); x++) {
+            EXPECT_EQ(dedupedOutputs[x].first, convertedOutputs[x].first);
+            EXPECT_EQ(dedupedOutputs[x].second, convertedOutputs[x].second) << "output " << x << " differs with " << outputJobs << " jobs";
+        }
+    }
+}
+
+TEST(ConverterApi, MusxToMusicXmlRunsPartsOnCallerExecutor)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    auto convertWith = [&](unsigned outputJobs, denigma::IExecutor* executor) {
+        std::vector<std::pair<std::string, std::string>> outputs;
+        denigma::formats::musicxml::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.outputJobs = outputJobs;
+        options.common.executor = executor;
+        options.allPartsAndScore = true;
+        const auto result = converter->convert(input, [&](std::string_view suggestedName, std::span<const std::byte> data) {
+            outputs.emplace_back(std::string(suggestedName), std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        return outputs;
+    };
+
+    ThreadPerTaskExecutor executor;
+    const auto serialOutputs = convertWith(1, nullptr);
+    const auto executorOutputs = convertWith(0, &executor);
+    EXPECT_GT(executor.submitted(), 0);
+    ASSERT_EQ(executorOutputs.size(), serialOutputs.size());
+    for (size_t x = 0; x < serialOutputs.size(); x++) {
+        EXPECT_EQ(executorOutputs[x].first, serialOutputs[x].first);
+        EXPECT_EQ(executorOutputs[x].second, serialOutputs[x].second) << "output " << x << " differs";
+    }
+}
+
+TEST(ConverterApi, MusxToMusicXmlStopsWhenCancelledOrPastDeadline)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    auto convertWith = [&](const denigma::formats::musicxml::Options& options) {
+        std::size_t outputCount = 0;
+        auto result = converter->convert(input, [&](std::string_view, std::span<const std::byte>) {
+            ++outputCount;
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_EQ(outputCount, 0u);
+        return result;
+    };
+
+    denigma::formats::musicxml::Options cancelledOptions;
+    cancelledOptions.common.outputJobs = 2;
+    cancelledOptions.common.cancellation.cancel();
+    const auto cancelled = convertWith(cancelledOptions);
+    EXPECT_TRUE(cancelled.hasError());
+    EXPECT_TRUE(cancelled.cancelled());
+
+    denigma::formats::musicxml::Options lateOptions;
+    lateOptions.common.deadline = std::chrono::steady_clock::now();
+    const auto late = convertWith(lateOptions);
+    EXPECT_TRUE(late.hasError());
+    EXPECT_TRUE(late.cancelled());
+
+    denigma::formats::musicxml::Options generousOptions;
+    generousOptions.common.deadline = std::chrono::steady_clock::now() + std::chrono::hours(1);
+    std::size_t outputCount = 0;
+    const auto completed = converter->convert(input, [&](std::string_view, std::span<const std::byte>) {
+        ++outputCount;
+    }, denigma::ConversionRequest{ &generousOptions });
+    EXPECT_FALSE(completed.hasError());
+    EXPECT_FALSE(completed.cancelled());
+    EXPECT_EQ(outputCount, 1u);
+}
+
+TEST(ConverterApi, MusxToMusicXmlConvertAsyncMatchesConvert)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    denigma::formats::musicxml::Options options;
+    options.common.sourceName = "notAscii-其れ.musx";
+    options.allPartsAndScore = true;
+    std::vector<std::string> expected;
+    converter->convert(input, [&](std::string_view, std::span<const std::byte> data) {
+        expected.emplace_back(reinterpret_cast<const char*>(data.data()), data.size());
+    }, denigma::ConversionRequest{ &options });
+    ASSERT_GE(expected.size(), 2);
+
+    auto convertAsync = [&](const denigma::formats::musicxml::Options& asyncOptions) {
+        std::vector<std::string> outputs;
+        auto pending = converter->convertAsync(input, [&](std::string_view, std::span<const std::byte> data) {
+            outputs.emplace_back(reinterpret_cast<const char*>(data.data()), data.size());
+        }, denigma::ConversionRequest{ &asyncOptions });
+        const auto result = pending.get();
+        EXPECT_TRUE(result.diagnostics().empty());
+        return outputs;
+    };
+
+    EXPECT_EQ(convertAsync(options), expected);
+
+    ThreadPerTaskExecutor executor;
+    auto executorOptions = options;
+    executorOptions.common.executor = &executor;
+    executorOptions.common.outputJobs = 0;
+    EXPECT_EQ(convertAsync(executorOptions), expected);
+    EXPECT_GT(executor.submitted(), 1); // the conversion itself, then its parts
+}
+
+TEST(ConverterApi, MusxToMusicXmlParallelMeasureRangesMatchSerial)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / "large_orchestra.musx");
+    auto convertWithJobs = [&](unsigned outputJobs) {
+        std::vector<std::string> outputs;
+        denigma::formats::musicxml::Options options;
+        options.common.sourceName = "large_orchestra.musx";
+        options.common.outputJobs = outputJobs;
+        const auto result = converter->convert(input, [&](std::string_view, std::span<const std::byte> data) {
+            outputs.emplace_back(reinterpret_cast<const char*>(data.data()), data.size());
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        return outputs;
+    };
+
+    const auto serialOutputs = convertWithJobs(1);
+    const auto parallelOutputs = convertWithJobs(4);
+    ASSERT_EQ(serialOutputs.size(), 1);
+    ASSERT_EQ(parallelOutputs.size(), 1);
+    EXPECT_EQ(parallelOutputs[0], serialOutputs[0]);
+}
+
+TEST(ConverterApi, MusxToMusicXmlConvertsMeasureRangeAndStaffSubset)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / "large_orchestra.musx");
+    std::string xmlText;
+    denigma::formats::musicxml::Options options;
+    options.common.sourceName = "large_orchestra.musx";
+    options.measureRange = denigma::MeasureRange{ 3, 5 };
+    options.staffFilter = { 1, 2 };
+    const auto result = converter->convert(input, [&](std::string_view, std::span<const std::byte> data) {
+        xmlText.assign(reinterpret_cast<const char*>(data.data()), data.size());
+    }, denigma::ConversionRequest{ &options });
+    EXPECT_TRUE(result.diagnostics().empty());
+
+    pugi::xml_document document;
+    const auto parseResult = document.load_string(xmlText.c_str());
+    ASSERT_TRUE(parseResult) << parseResult.description();
+    const auto scorePartwise = document.child("score-partwise");
+    size_t partCount = 0;
+    for (const auto part : scorePartwise.children("part")) {
+        partCount++;
+        size_t measureCount = 0;
+        for ([[maybe_unused]] const auto measure : part.children("measure")) {
+            measureCount++;
+        }
+        EXPECT_EQ(measureCount, 3u) << part.attribute("id").value();
+    }
+    EXPECT_GE(partCount, 1u);
+    EXPECT_LE(partCount, 2u);
+}
+
+TEST(ConverterApi, MusxToMusicXmlStreamedPartsMatchWholeScore)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / "large_orchestra.musx");
+    auto convertStreaming = [&](bool streamParts) {
+        std::vector<std::string> outputs;
+        denigma::formats::musicxml::Options options;
+        options.common.sourceName = "large_orchestra.musx";
+        options.streamParts = streamParts;
+        const auto result = converter->convert(input, [&](std::string_view, std::span<const std::byte> data) {
+            outputs.emplace_back(reinterpret_cast<const char*>(data.data()), data.size());
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        return outputs;
+    };
+
+    const auto wholeOutputs = convertStreaming(false);
+    const auto streamedOutputs = convertStreaming(true);
+    ASSERT_EQ(wholeOutputs.size(), 1);
+    ASSERT_EQ(streamedOutputs.size(), 1);
+    EXPECT_EQ(streamedOutputs[0], wholeOutputs[0]);
+}
+
+TEST(ConverterApi, MusxToMusicXmlUsesCallerMemoryResource)
+{
+    setupTestDataPaths();
+
+    class CountingResource final : public std::pmr::memory_resource
+    {
+    public:
+        size_t allocations{};
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    auto convertWith = [&](std::pmr::memory_resource* memoryResource) {
+        std::string xmlText;
+        denigma::formats::musicxml::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.memoryResource = memoryResource;
+        const auto result = converter->convert(input, [&](std::string_view, std::span<const std::byte> data) {
+            xmlText.assign(reinterpret_cast<const char*>(data.data()), data.size());
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        return xmlText;
+    };
+
+    CountingResource resource;
+    const auto withResource = convertWith(&resource);
+    EXPECT_GT(resource.allocations, 0u);
+    EXPECT_EQ(withResource, convertWith(nullptr));
+}
+
+TEST(ConverterApi, MusxToMusicXmlReportsPeakArenaBytes)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::musicxml::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MusicXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    for (const unsigned outputJobs : { 1u, 4u }) {
+        size_t outputCount = 0;
+        denigma::formats::musicxml::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.outputJobs = outputJobs;
+        options.allPartsAndScore = true;
+        const auto result = converter->convert(input, [&](std::string_view, std::span<const std::byte>) {
+            ++outputCount;
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        EXPECT_GE(outputCount, 2u);
+        EXPECT_GT(result.peakArenaBytes(), 0u) << "outputJobs " << outputJobs;
+    }
+}
+
 TEST(MusicXmlChordFixture, ExportsChordsForInspection)
 {
     setupTestDataPaths();
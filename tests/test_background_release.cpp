@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.h"
+#include "core/background_release.h"
+
+using namespace denigma;
+
+namespace {
+
+/// Reports the thread it is destroyed on.
+struct ReleaseProbe
+{
+    explicit ReleaseProbe(std::promise<std::thread::id>* promise) : destroyedOn(promise) {}
+    ~ReleaseProbe() { destroyedOn->set_value(std::this_thread::get_id()); }
+
+    ReleaseProbe(const ReleaseProbe&) = delete;
+    ReleaseProbe& operator=(const ReleaseProbe&) = delete;
+
+    std::promise<std::thread::id>* destroyedOn;
+};
+
+class RecordingExecutor : public IExecutor
+{
+public:
+    void submit(std::function<void()> task) override { tasks.push_back(std::move(task)); }
+    unsigned concurrency() const override { return 1; }
+
+    std::vector<std::function<void()>> tasks;
+};
+
+} // namespace
+
+TEST(BackgroundRelease, ReleasesOffTheCallingThread)
+{
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    std::promise<std::thread::id> destroyedOn;
+    auto destroyed = destroyedOn.get_future();
+    releaseInBackground(denigmaContext, std::make_unique<ReleaseProbe>(&destroyedOn));
+    ASSERT_EQ(destroyed.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+#if defined(DENIGMA_SINGLE_THREADED)
+    EXPECT_EQ(destroyed.get(), std::this_thread::get_id());
+#else
+    EXPECT_NE(destroyed.get(), std::this_thread::get_id());
+#endif
+}
+
+TEST(BackgroundRelease, ReleasesAsAnExecutorTask)
+{
+    RecordingExecutor executor;
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    denigmaContext.executor = &executor;
+    std::promise<std::thread::id> destroyedOn;
+    auto destroyed = destroyedOn.get_future();
+    releaseInBackground(denigmaContext, std::make_unique<ReleaseProbe>(&destroyedOn));
+    ASSERT_EQ(executor.tasks.size(), 1u);
+    EXPECT_NE(destroyed.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    executor.tasks.front()();
+    EXPECT_EQ(destroyed.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "core/buffer_pool.h"
+
+using namespace denigma;
+
+TEST(BufferPool, ReusesRecycledCapacity)
+{
+    BufferPool<std::vector<char>> pool;
+    std::vector<char> buffer(1024 * 1024, 'x');
+    const char* const storage = buffer.data();
+    pool.recycle(std::move(buffer));
+    EXPECT_EQ(pool.size(), 1u);
+
+    auto reused = pool.acquire(512 * 1024);
+    EXPECT_TRUE(reused.empty());
+    EXPECT_EQ(reused.data(), storage);
+    EXPECT_EQ(pool.size(), 0u);
+    EXPECT_EQ(pool.retainedBytes(), 0u);
+
+    pool.recycle(std::move(reused));
+    const auto fresh = pool.acquire(2 * 1024 * 1024);
+    EXPECT_GE(fresh.capacity(), 2u * 1024 * 1024);
+    EXPECT_EQ(pool.size(), 1u) << "a pooled buffer too small for the request stays pooled";
+}
+
+TEST(BufferPool, BoundsWhatItKeeps)
+{
+    using Pool = BufferPool<std::string>;
+    Pool pool;
+    pool.recycle(std::string(100, 'a'));
+    EXPECT_EQ(pool.size(), 0u) << "small buffers are not pooled";
+
+    for (std::size_t x = 1; x <= Pool::MAX_POOLED_BUFFERS + 2; ++x) {
+        std::string buffer;
+        buffer.reserve(x * Pool::MIN_POOLED_BYTES);
+        pool.recycle(std::move(buffer));
+    }
+    EXPECT_EQ(pool.size(), Pool::MAX_POOLED_BUFFERS);
+    EXPECT_LE(pool.retainedBytes(), Pool::MAX_RETAINED_BYTES);
+    EXPECT_GE(pool.acquire(Pool::MIN_POOLED_BYTES).capacity(), 3 * Pool::MIN_POOLED_BYTES) << "the smallest were dropped first";
+
+    pool.clear();
+    EXPECT_EQ(pool.size(), 0u);
+    EXPECT_EQ(pool.retainedBytes(), 0u);
+}
+
+TEST(BufferPool, EachThreadHasItsOwnPool)
+{
+    recycleByteBuffer(std::vector<char>(256 * 1024));
+    const auto* mainPool = &BufferPool<std::vector<char>>::forThisThread();
+    EXPECT_GE(mainPool->size(), 1u);
+    std::thread([&]() {
+        EXPECT_NE(&BufferPool<std::vector<char>>::forThisThread(), mainPool);
+        EXPECT_EQ(BufferPool<std::vector<char>>::forThisThread().size(), 0u);
+    }).join();
+    BufferPool<std::vector<char>>::forThisThread().clear();
+}
@@ -26,6 +26,7 @@
 #include <string>
 #include <vector>
 
+#include "classify/classification_cache.h"
 #include "core/denigma.h"
 #include "core/musx_reader.h"
 #include "denigma/classify/chords.h"
@@ -262,3 +263,27 @@ TEST(ChordSuffixClassifierFixture, RetainsInternalParenthesesAndStackedStrings)
         return string.position != denigma::classify::chord::SuffixString::Position::Inline;
     }));
 }
+
+TEST(ChordSuffixClassifierFixture, ClassifiesEachAssignedSuffixOncePerDocument)
+{
+    const auto document = loadChordsFixture();
+    ASSERT_TRUE(document);
+    const auto cache = denigma::classify::detail::ClassificationCache::forDocument(document);
+    ASSERT_TRUE(cache);
+
+    const auto assignments = document->getDetails()->getArray<details::ChordAssign>(SCORE_PARTID);
+    for (const auto& assignment : assignments) {
+        const auto cached = denigma::classify::classifyChordSuffix(assignment);
+        const auto direct = assignment->showSuffix
+            ? denigma::classify::classifyChordSuffix(assignment->getChordSuffix())
+            : denigma::classify::classifyChordSuffix();
+        EXPECT_EQ(cached.calcText(), direct.calcText());
+        EXPECT_EQ(cached.quality, direct.quality);
+    }
+
+    const auto before = cache->lookupCounts();
+    for (const auto& assignment : assignments) {
+        (void)denigma::classify::classifyChordSuffix(assignment);
+    }
+    EXPECT_EQ(cache->lookupCounts().misses, before.misses);
+}
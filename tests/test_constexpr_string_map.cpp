@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string_view>
+
+#include "gtest/gtest.h"
+
+#include "utils/constexpr_string_map.h"
+
+namespace {
+
+constexpr auto testMap = utils::makeConstexprStringMap<int>({
+    { "noteheadBlack", 1 },
+    { "articAccentAbove", 2 },
+    { "dynamicForte", 3 },
+    { "", 4 },
+});
+
+static_assert(testMap.size() == 4);
+static_assert(testMap.find("articAccentAbove") && *testMap.find("articAccentAbove") == 2);
+static_assert(!testMap.contains("articAccentBelow"));
+
+} // namespace
+
+TEST(ConstexprStringMap, FindsEveryKeyAndOnlyThoseKeys)
+{
+    for (const auto& [key, value] : testMap) {
+        const int* found = testMap.find(key);
+        ASSERT_NE(found, nullptr) << key;
+        EXPECT_EQ(*found, value) << key;
+    }
+    EXPECT_EQ(testMap.find("noteheadBlac"), nullptr);
+    EXPECT_EQ(testMap.find("noteheadBlackX"), nullptr);
+    ASSERT_NE(testMap.find(std::string_view{}), nullptr);
+    EXPECT_EQ(*testMap.find(std::string_view{}), 4);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "core/conversion_arena.h"
+
+using namespace denigma;
+
+static std::vector<void*> fillArena(ConversionArena& arena)
+{
+    std::vector<void*> blocks;
+    for (int x = 0; x < 64; ++x) {
+        blocks.push_back(arena.allocate(16 * 1024, alignof(std::max_align_t)));
+    }
+    return blocks;
+}
+
+TEST(ConversionArena, NextConversionReusesBlocks)
+{
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    auto& cache = *ArenaBlockCache::forThisThread();
+    cache.release();
+
+    std::vector<void*> first;
+    {
+        ConversionArena arena(denigmaContext);
+        first = fillArena(arena);
+    }
+    const auto retained = cache.retainedBytes();
+    EXPECT_GT(retained, 0u);
+    EXPECT_LE(retained, ArenaBlockCache::MAX_RETAINED_BYTES);
+    {
+        ConversionArena arena(denigmaContext);
+        EXPECT_EQ(fillArena(arena), first) << "the same run of blocks comes back in the same order";
+        EXPECT_EQ(cache.retainedBytes(), 0u);
+    }
+    EXPECT_EQ(cache.retainedBytes(), retained);
+    cache.release();
+    EXPECT_EQ(cache.retainedBytes(), 0u);
+}
+
+TEST(ConversionArena, ExplicitResourceBypassesCache)
+{
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    std::pmr::unsynchronized_pool_resource upstream;
+    denigmaContext.memoryResource = &upstream;
+    auto& cache = *ArenaBlockCache::forThisThread();
+    cache.release();
+    {
+        ConversionArena arena(denigmaContext);
+        fillArena(arena);
+    }
+    EXPECT_EQ(cache.retainedBytes(), 0u);
+}
+
+TEST(ConversionArena, BlocksReturnToTheCreatingThreadsCache)
+{
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    std::unique_ptr<ConversionArena> arena;
+    std::shared_ptr<ArenaBlockCache> workerCache;
+    std::thread([&]() {
+        workerCache = ArenaBlockCache::forThisThread();
+        arena = std::make_unique<ConversionArena>(denigmaContext);
+        fillArena(*arena);
+    }).join();
+    arena.reset(); // released after the worker thread has ended
+    EXPECT_GT(workerCache->retainedBytes(), 0u);
+}
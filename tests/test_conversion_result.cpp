@@ -19,10 +19,12 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <chrono>
 #include <string>
 
 #include "gtest/gtest.h"
 
+#include "core/hot_path_counters.h"
 #include "denigma/conversion.h"
 
 TEST(ConversionResult, TracksDiagnosticsAndErrorState)
@@ -47,3 +49,70 @@ TEST(ConversionResult, TracksDiagnosticsAndErrorState)
     EXPECT_EQ(result.diagnostics().back().severity, denigma::MessageSeverity::Error);
     EXPECT_EQ(result.diagnostics().back().message, "error");
 }
+
+TEST(ConversionResult, FormatsStats)
+{
+    using Phase = denigma::ConversionStats::Phase;
+    denigma::ConversionResult result;
+    auto& stats = result.stats();
+    stats.addPhaseTime(Phase::Unzip, std::chrono::microseconds(1500));
+    stats.addPhaseTime(Phase::Serialize, std::chrono::milliseconds(2));
+    stats.addPhaseTime(Phase::Serialize, std::chrono::milliseconds(1));
+    stats.outputs = 2;
+    stats.cacheHits = 3;
+    stats.cacheMisses = 1;
+
+    EXPECT_EQ(result.stats().phaseTime(Phase::Serialize), std::chrono::milliseconds(3));
+    EXPECT_EQ(result.stats().totalTime(), std::chrono::microseconds(4500));
+    EXPECT_DOUBLE_EQ(result.stats().cacheHitRate(), 0.75);
+    EXPECT_EQ(denigma::ConversionStats::phaseName(Phase::BuildDom), "buildDom");
+    EXPECT_EQ(result.stats().toJson(),
+        "{\"phaseMicroseconds\":{\"unzip\":1500,\"decode\":0,\"inflate\":0,\"buildDom\":0,\"convert\":0,"
+        "\"serialize\":3000,\"validate\":0},\"totalMicroseconds\":4500,\"measures\":0,\"entries\":0,\"notes\":0,"
+        "\"outputs\":2,\"bytesWritten\":0,\"cacheHits\":3,\"cacheMisses\":1,\"hotPaths\":{\"textMetricsFallback\":0,"
+        "\"unmatchedGlyph\":0,\"approximateDivisions\":0,\"cueHeuristic\":0,\"discardedCueFrame\":0}}");
+    EXPECT_EQ(result.stats().summary(),
+        "total 4 ms (unzip 1, decode 0, inflate 0, buildDom 0, convert 0, serialize 3, validate 0), measures 0, "
+        "entries 0, notes 0, outputs 2, bytesWritten 0, cacheHits 3, cacheMisses 1");
+}
+
+TEST(ConversionResult, FormatsHotPathCounts)
+{
+    using HotPath = denigma::ConversionStats::HotPath;
+    denigma::HotPathCounters counters;
+    counters.count(HotPath::UnmatchedGlyph);
+    counters.count(HotPath::UnmatchedGlyph);
+    {
+        denigma::HotPathThreadScope bound(&counters);
+        denigma::countHotPath(HotPath::DiscardedCueFrame);
+    }
+    denigma::countHotPath(HotPath::DiscardedCueFrame); // no longer bound to this thread
+
+    denigma::ConversionStats stats;
+    counters.addTo(stats);
+    EXPECT_EQ(stats.hotPathCount(HotPath::UnmatchedGlyph), 2u);
+    EXPECT_EQ(stats.hotPathCount(HotPath::DiscardedCueFrame), 1u);
+    EXPECT_EQ(stats.hotPathCount(HotPath::CueHeuristic), 0u);
+    EXPECT_NE(stats.toJson().find(",\"hotPaths\":{\"textMetricsFallback\":0,\"unmatchedGlyph\":2,\"approximateDivisions\":0,"
+        "\"cueHeuristic\":0,\"discardedCueFrame\":1}"), std::string::npos);
+    EXPECT_NE(stats.summary().find(", hot paths (unmatchedGlyph 2, discardedCueFrame 1)"), std::string::npos);
+}
+
+TEST(ConversionResult, FormatsCountedMemory)
+{
+    using Phase = denigma::ConversionStats::Phase;
+    denigma::ConversionStats stats;
+    stats.memoryCounted = true;
+    stats.addPhaseMemory(Phase::BuildDom, { 4096, 2048, 3072 });
+    stats.addPhaseMemory(Phase::BuildDom, { 1024, -512, 1024 });
+
+    EXPECT_EQ(stats.phaseMemory[static_cast<std::size_t>(Phase::BuildDom)].allocatedBytes, 5120u);
+    EXPECT_EQ(stats.phaseMemory[static_cast<std::size_t>(Phase::BuildDom)].liveBytes, 1536);
+    EXPECT_EQ(stats.phaseMemory[static_cast<std::size_t>(Phase::BuildDom)].peakBytes, 3072u);
+    EXPECT_NE(stats.toJson().find(",\"phaseMemory\":{\"unzip\":{\"allocatedBytes\":0,\"liveBytes\":0,\"peakBytes\":0},"
+        "\"decode\":{\"allocatedBytes\":0,\"liveBytes\":0,\"peakBytes\":0},"
+        "\"inflate\":{\"allocatedBytes\":0,\"liveBytes\":0,\"peakBytes\":0},"
+        "\"buildDom\":{\"allocatedBytes\":5120,\"liveBytes\":1536,\"peakBytes\":3072},"), std::string::npos);
+    EXPECT_NE(stats.summary().find(", peak KiB (unzip 0, decode 0, inflate 0, buildDom 3, convert 0, serialize 0, validate 0)"),
+        std::string::npos);
+}
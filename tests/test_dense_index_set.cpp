@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <cstdint>
+#include <memory_resource>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+#include "utils/dense_index_set.h"
+
+TEST(DenseIndexSet, InsertReportsWhetherTheIndexWasNew)
+{
+    utils::DenseIndexSet<int> set;
+    EXPECT_FALSE(set.contains(5));
+    EXPECT_TRUE(set.insert(5));
+    EXPECT_FALSE(set.insert(5));
+    EXPECT_TRUE(set.contains(5));
+    EXPECT_FALSE(set.contains(4));
+    EXPECT_FALSE(set.contains(6));
+
+    EXPECT_TRUE(set.insert(1000));
+    EXPECT_TRUE(set.contains(1000));
+    EXPECT_TRUE(set.contains(5));
+    EXPECT_FALSE(set.contains(100000));
+}
+
+TEST(DenseIndexSet, ClearKeepsTheSetUsable)
+{
+    utils::DenseIndexSet<int> set;
+    set.reserve(200);
+    set.insert(0);
+    set.insert(63);
+    set.insert(64);
+    set.insert(200);
+    set.clear();
+    EXPECT_FALSE(set.contains(0));
+    EXPECT_FALSE(set.contains(63));
+    EXPECT_FALSE(set.contains(64));
+    EXPECT_FALSE(set.contains(200));
+    EXPECT_TRUE(set.insert(64));
+    EXPECT_TRUE(set.contains(64));
+}
+
+TEST(DenseIndexSet, RejectsNegativeIndices)
+{
+    utils::DenseIndexSet<int> set;
+    EXPECT_FALSE(set.contains(-1));
+    EXPECT_THROW(set.insert(-1), std::out_of_range);
+}
+
+TEST(DenseIndexSet, UsesTheGivenAllocator)
+{
+    std::pmr::monotonic_buffer_resource resource;
+    utils::DenseIndexSet<std::uint32_t, std::pmr::polymorphic_allocator<std::uint64_t>> set{ &resource };
+    EXPECT_TRUE(set.insert(77u));
+    EXPECT_TRUE(set.contains(77u));
+}
@@ -16,16 +16,26 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
 #include <sstream>
 #include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
 
+#include "core/musx_reader.h"
+#include "core/xxhash64.h"
 #include "denigma/formats/enigmaxml.h"
 #include "denigma/io/random_access_reader.h"
+#include "musx/musx.h"
 #include "test_utils.h"
 
 TEST(ConverterApi, MusxToEnigmaXmlWritesToStream)
@@ -52,10 +62,248 @@ TEST(ConverterApi, MusxToEnigmaXmlWritesToStream)
     const auto bufferResult = converter->convert(bufferReader, bufferOutput, denigma::ConversionRequest{ &options });
     EXPECT_TRUE(bufferResult.diagnostics().empty());
 
+    denigma::MappedFileRandomAccessReader mappedReader(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    ASSERT_EQ(mappedReader.size(), musxInput.size());
+    ASSERT_EQ(mappedReader.data().size(), musxInput.size());
+    EXPECT_EQ(std::memcmp(mappedReader.data().data(), musxInput.data(), musxInput.size()), 0);
+    std::ostringstream mappedOutput;
+    const auto mappedResult = converter->convert(mappedReader, mappedOutput, denigma::ConversionRequest{ &options });
+    EXPECT_TRUE(mappedResult.diagnostics().empty());
+
     std::vector<char> reference;
     readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), reference);
     const std::string referenceText(reference.begin(), reference.end());
 
     EXPECT_EQ(fileOutput.str(), referenceText);
     EXPECT_EQ(bufferOutput.str(), referenceText);
+    EXPECT_EQ(mappedOutput.str(), referenceText);
+}
+
+TEST(ConverterApi, MusxToEnigmaXmlStreamsAcrossRecodeBlocks)
+{
+    setupTestDataPaths();
+    const std::string inputFile = "large_orchestra"; // score.dat spans more than one 0x20000-byte recode block
+    std::filesystem::path inputPath;
+    copyInputToOutput(inputFile + ".musx", inputPath);
+
+    const auto cliOutputPath = getOutputPath() / (inputFile + ".cli.enigmaxml");
+    ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), "--enigmaxml", pathString(cliOutputPath), "--force" };
+    checkStderr({ "Processing", inputFile + ".musx" }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "export " << pathString(inputPath);
+    });
+    std::vector<char> cliOutput;
+    readFile(cliOutputPath, cliOutput);
+    ASSERT_FALSE(cliOutput.empty());
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::enigmaxml::registerConverters(registry);
+    const auto* converter = registry.findReader(denigma::FormatId::Musx, denigma::FormatId::EnigmaXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::formats::enigmaxml::Options options;
+    options.common.sourceName = inputFile + ".musx";
+    denigma::FileRandomAccessReader reader(inputPath);
+    std::ostringstream streamed;
+    const auto result = converter->convert(reader, streamed, denigma::ConversionRequest{ &options });
+    EXPECT_TRUE(result.diagnostics().empty());
+    EXPECT_EQ(streamed.str(), std::string(cliOutput.begin(), cliOutput.end()));
+}
+
+TEST(ConverterApi, FingerprintsStreamOutput)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::enigmaxml::registerConverters(registry);
+    const auto* converter = registry.findReader(denigma::FormatId::Musx, denigma::FormatId::EnigmaXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::formats::enigmaxml::Options options;
+    options.common.sourceName = "notAscii-其れ.musx";
+    options.common.fingerprintOutputs = true;
+
+    denigma::FileRandomAccessReader reader(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    std::ostringstream output;
+    const auto result = converter->convert(reader, output, denigma::ConversionRequest{ &options });
+    EXPECT_TRUE(result.diagnostics().empty());
+
+    const std::string text = output.str();
+    ASSERT_EQ(result.outputFingerprints().size(), 1u);
+    EXPECT_EQ(result.outputFingerprints()[0].bytes, text.size());
+    EXPECT_EQ(result.outputFingerprints()[0].xxh64, denigma::Xxh64::hash(std::as_bytes(std::span<const char>(text.data(), text.size()))));
+    EXPECT_EQ(result.stats().bytesWritten, text.size());
+}
+
+TEST(ConverterApi, FileReaderSupportsConcurrentReads)
+{
+    setupTestDataPaths();
+
+    const auto musxPath = getInputPath() / utils::utf8ToPath("notAscii-其れ.musx");
+    std::vector<char> expected;
+    readFile(musxPath, expected);
+
+    const denigma::FileRandomAccessReader reader(musxPath);
+    ASSERT_EQ(reader.size(), expected.size());
+
+    constexpr std::size_t kThreadCount = 4;
+    constexpr std::size_t kChunkSize = 97; // deliberately unaligned
+    std::array<bool, kThreadCount> matched{};
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t t = 0; t < kThreadCount; t++) {
+            threads.emplace_back([&, t]() {
+                bool allMatched = true;
+                std::vector<std::byte> chunk(kChunkSize);
+                for (std::size_t offset = t; offset < expected.size(); offset += kChunkSize) {
+                    const std::size_t bytesRead = reader.readAt(offset, chunk);
+                    const std::size_t expectedCount = (std::min)(kChunkSize, expected.size() - offset);
+                    if (bytesRead != expectedCount || std::memcmp(chunk.data(), expected.data() + offset, bytesRead) != 0) {
+                        allMatched = false;
+                    }
+                }
+                matched[t] = allMatched;
+            });
+        }
+    }
+    for (std::size_t t = 0; t < kThreadCount; t++) {
+        EXPECT_TRUE(matched[t]) << "thread " << t << " read mismatched bytes";
+    }
+}
+
+TEST(ConverterApi, CallbackReaderServesOnlyTheRangesRead)
+{
+    setupTestDataPaths();
+
+    std::vector<char> musxInput;
+    readFile(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"), musxInput);
+    std::size_t calls = 0;
+    denigma::CallbackRandomAccessReader reader(musxInput.size(), [&](std::uint64_t offset, std::span<std::byte> output) {
+        calls++;
+        const std::size_t count = (std::min)(output.size(), std::size_t(4096)); // short reads, as from a host source
+        std::memcpy(output.data(), musxInput.data() + offset, count);
+        return count;
+    });
+    ASSERT_EQ(reader.size(), musxInput.size());
+    std::array<std::byte, 8> scratch{};
+    EXPECT_EQ(reader.readAt(musxInput.size(), scratch), 0u);
+    EXPECT_EQ(calls, 0u);
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::enigmaxml::registerConverters(registry);
+    const auto* converter = registry.findReader(denigma::FormatId::Musx, denigma::FormatId::EnigmaXml);
+    ASSERT_NE(converter, nullptr);
+    denigma::formats::enigmaxml::Options options;
+    options.common.sourceName = "notAscii-其れ.musx";
+    std::ostringstream output;
+    const auto result = converter->convert(reader, output, denigma::ConversionRequest{ &options });
+    EXPECT_TRUE(result.diagnostics().empty());
+    EXPECT_GT(calls, 0u);
+
+    std::vector<char> reference;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), reference);
+    EXPECT_EQ(output.str(), std::string(reference.begin(), reference.end()));
+}
+
+TEST(ConverterApi, RegistryFindsFirstRegisteredConverterPerFormatPair)
+{
+    denigma::ConverterRegistry registry;
+    denigma::formats::enigmaxml::registerConverters(registry);
+    const auto* first = registry.findReader(denigma::FormatId::Musx, denigma::FormatId::EnigmaXml);
+    ASSERT_NE(first, nullptr);
+
+    denigma::formats::enigmaxml::registerConverters(registry);
+    EXPECT_EQ(registry.findReader(denigma::FormatId::Musx, denigma::FormatId::EnigmaXml), first);
+    EXPECT_EQ(registry.findReader(denigma::FormatId::EnigmaXml, denigma::FormatId::Musx), nullptr);
+    EXPECT_EQ(registry.find(denigma::FormatId::Musx, denigma::FormatId::EnigmaXml), nullptr);
+    EXPECT_EQ(registry.findReader(static_cast<denigma::FormatId>(255), denigma::FormatId::EnigmaXml), nullptr);
+    EXPECT_EQ(registry.findPrepared(static_cast<denigma::FormatId>(255)), nullptr);
+}
+
+TEST(MusxReader, ParsesHandedOffBufferInPlace)
+{
+    setupTestDataPaths();
+
+    denigma::Buffer xml;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), xml);
+    ASSERT_FALSE(xml.empty());
+
+    auto partCount = [](const musx::dom::DocumentPtr& document) {
+        return document->getOthers()->getArray<musx::dom::others::PartDefinition>(musx::dom::SCORE_PARTID).size();
+    };
+
+    // a buffer that is not offered is copied and left untouched
+    const denigma::Buffer original = xml;
+    const auto copiedDocument = musx::factory::DocumentFactory::create<denigma::MusxReader>(xml.data(), xml.size());
+    EXPECT_EQ(xml, original);
+
+    denigma::Buffer unrelated = original;
+    denigma::Buffer handedOff = original;
+    musx::dom::DocumentPtr inPlaceDocument;
+    {
+        denigma::MusxReaderBufferHandoff unrelatedHandoff(unrelated);
+        denigma::MusxReaderBufferHandoff handoff(handedOff);
+        inPlaceDocument = musx::factory::DocumentFactory::create<denigma::MusxReader>(handedOff.data(), handedOff.size());
+    }
+    EXPECT_TRUE(handedOff.empty());
+    EXPECT_EQ(unrelated, original);
+
+    ASSERT_TRUE(copiedDocument);
+    ASSERT_TRUE(inPlaceDocument);
+    EXPECT_EQ(partCount(inPlaceDocument), partCount(copiedDocument));
+    EXPECT_GT(partCount(inPlaceDocument), 1u);
+}
+
+TEST(MusxReader, ParsesHandedOffMappingInPlace)
+{
+    setupTestDataPaths();
+
+    const auto inputPath = getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml");
+    denigma::Buffer original;
+    readFile(inputPath, original);
+    ASSERT_FALSE(original.empty());
+
+    denigma::CommandInputData inputData;
+    inputData.mappedPrimaryBuffer = std::make_shared<denigma::MappedInputFile>(inputPath);
+    const auto xml = inputData.primaryXml();
+    ASSERT_EQ(xml.size(), original.size());
+    musx::dom::DocumentPtr document;
+    {
+        denigma::MusxReaderBufferHandoff handoff(inputData);
+        document = musx::factory::DocumentFactory::create<denigma::MusxReader>(xml.data(), xml.size());
+    }
+    EXPECT_FALSE(inputData.mappedPrimaryBuffer) << "the reader keeps the mapping its strings point into";
+    ASSERT_TRUE(document);
+    EXPECT_GT(document->getOthers()->getArray<musx::dom::others::PartDefinition>(musx::dom::SCORE_PARTID).size(), 1u);
+
+    denigma::Buffer afterParse;
+    readFile(inputPath, afterParse);
+    EXPECT_EQ(afterParse, original) << "the in-place parse must not write through to the file";
+}
+
+TEST(MusxReader, LoadProfilesKeepTheFamiliesTheyName)
+{
+    setupTestDataPaths();
+
+    denigma::Buffer xml;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), xml);
+    ASSERT_FALSE(xml.empty());
+
+    const auto full = musx::factory::DocumentFactory::create<denigma::MusxReader>(xml.data(), xml.size());
+    const auto styles = musx::factory::DocumentFactory::create<denigma::MusxStylesReader>(xml.data(), xml.size());
+    const auto shapes = musx::factory::DocumentFactory::create<denigma::MusxShapesReader>(xml.data(), xml.size());
+    ASSERT_TRUE(full);
+    ASSERT_TRUE(styles);
+    ASSERT_TRUE(shapes);
+
+    auto partCount = [](const musx::dom::DocumentPtr& document) {
+        return document->getOthers()->getArray<musx::dom::others::PartDefinition>(musx::dom::SCORE_PARTID).size();
+    };
+    auto shapeCount = [](const musx::dom::DocumentPtr& document) {
+        return document->getOthers()->getArray<musx::dom::others::ShapeDef>(musx::dom::SCORE_PARTID).size();
+    };
+    EXPECT_EQ(partCount(styles), partCount(full));
+    EXPECT_EQ(partCount(shapes), partCount(full));
+    EXPECT_EQ(shapeCount(shapes), shapeCount(full));
+    EXPECT_TRUE(styles->getOptions()->get<musx::dom::options::PageFormatOptions>());
+    EXPECT_TRUE(shapes->getOptions()->get<musx::dom::options::PageFormatOptions>());
 }
@@ -22,16 +22,25 @@
 #include <string>
 #include <ctime>
 #include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
 #include <iterator>
+#include <map>
 #include <span>
+#include <stdexcept>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "denigma/io/random_access_reader.h"
 #include "core/denigma.h"
 #include "test_utils.h"
 #include "unzip.h"
+#include "zip.h"
+#include "utils/inflate.h"
+#include "utils/stream_compression.h"
 #include "utils/ziputils.h"
 
 using namespace denigma;
@@ -142,6 +151,47 @@ TEST(Export, OutputFilename)
     }
 }
 
+TEST(Export, CompressedEnigmaXml)
+{
+    setupTestDataPaths();
+    std::string inputFile = "notAscii-其れ";
+    std::filesystem::path inputPath;
+    copyInputToOutput(inputFile + ".musx", inputPath);
+    std::vector<char> referenceXml;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath(inputFile + ".enigmaxml"), referenceXml);
+    std::vector<std::string> extensions = { "gz" };
+    if (utils::hasZstdCompression()) {
+        extensions.push_back("zst");
+    }
+    for (const auto& extension : extensions) {
+        const std::string compressedName = "output.enigmaxml." + extension;
+        const std::filesystem::path compressedPath = std::filesystem::current_path() / "-exports" / compressedName;
+        {
+            ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), "--enigmaxml", "-exports/" + compressedName };
+            checkStderr({ "Processing", pathString(inputPath.filename()) }, [&]() {
+                EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create " << compressedName;
+            });
+            ASSERT_TRUE(std::filesystem::exists(compressedPath));
+            std::vector<char> compressed;
+            readFile(compressedPath, compressed);
+            EXPECT_NE(utils::detectCompression(compressed), utils::StreamCompression::None);
+            EXPECT_LT(compressed.size(), referenceXml.size());
+            EXPECT_EQ(utils::decompress(compressed, utils::detectCompression(compressed)), referenceXml) << compressedName;
+        }
+        // the compressed intermediate reads back like the plain one, and its outputs drop the compression suffix
+        {
+            ArgList args = { DENIGMA_NAME, "export", pathString(compressedPath), "--mss" };
+            checkStderr({ "Processing", compressedName }, [&]() {
+                EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "read " << compressedName;
+            });
+            const std::filesystem::path mssPath = std::filesystem::current_path() / "-exports" / "output.mss";
+            EXPECT_TRUE(std::filesystem::exists(mssPath));
+            compareFiles(getInputPath() / "reference" / utils::utf8ToPath(inputFile + ".mss"), mssPath);
+            std::filesystem::remove(mssPath);
+        }
+    }
+}
+
 TEST(Export, SvgOutput)
 {
     setupTestDataPaths();
@@ -313,6 +363,310 @@ TEST(Export, MusicXmlParts)
     }
 }
 
+TEST(Export, MusicXmlCompressedArchive)
+{
+    setupTestDataPaths();
+    std::string inputFile = "notAscii-其れ";
+    std::filesystem::path inputPath;
+    copyInputToOutput(inputFile + ".musx", inputPath);
+
+    const auto exportsPath = std::filesystem::current_path() / "-mxl-exports";
+    for (const char* format : { "--musicxml", "--mxl" }) {
+        ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), format, "-mxl-exports", "--all-parts", "--force" };
+        checkStderr({ "Processing", pathString(inputPath.filename()) }, [&]() {
+            EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create from " << pathString(inputPath);
+        });
+    }
+
+    const auto mxlPath = exportsPath / utils::utf8ToPath(inputFile + ".mxl");
+    ASSERT_TRUE(std::filesystem::exists(mxlPath));
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    const utils::ZipArchiveIndex archive(mxlPath, denigmaContext);
+    ASSERT_FALSE(archive.entries().empty());
+    EXPECT_EQ(archive.entries().front().filename, "mimetype");
+    EXPECT_EQ(archive.entries().front().method, 0);
+    EXPECT_EQ(archive.read(archive.entries().front()), "application/vnd.recordare.musicxml");
+    EXPECT_EQ(archive.musicXmlScoreName(denigmaContext), inputFile + ".musicxml");
+
+    auto readExported = [&](const std::string& fileName) {
+        std::vector<char> contents;
+        readFile(exportsPath / utils::utf8ToPath(fileName), contents);
+        return std::string(contents.begin(), contents.end());
+    };
+    EXPECT_EQ(utils::getMusicXmlScoreFile(archive, denigmaContext), readExported(inputFile + ".musicxml"));
+
+    std::vector<std::string> parts;
+    utils::iterateMusicXmlPartFiles(archive, denigmaContext, std::nullopt, [&](const std::filesystem::path& fileName, const std::string& contents) {
+        const auto name = utils::utf8ToString(fileName.u8string());
+        EXPECT_EQ(contents, readExported(name)) << name;
+        parts.push_back(name);
+        return true;
+    });
+    EXPECT_EQ(parts, std::vector<std::string>{ inputFile + ".オボえ.musicxml" });
+}
+
+TEST(Export, OutputArchiveHoldsEveryOutput)
+{
+    setupTestDataPaths();
+    std::string inputFile = "notAscii-其れ";
+    std::filesystem::path inputPath;
+    copyInputToOutput(inputFile + ".musx", inputPath);
+    const auto archivePath = getOutputPath() / "batch.zip";
+    const auto secondShardPath = getOutputPath() / "batch.1.zip";
+    std::filesystem::remove(secondShardPath);
+    std::filesystem::remove(getOutputPath() / utils::utf8ToPath(inputFile + ".enigmaxml"));
+    std::filesystem::remove(getOutputPath() / utils::utf8ToPath(inputFile + ".mxl"));
+
+    // a one-byte shard size puts each output in a shard of its own
+    ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), "--enigmaxml", "--mxl", "--output-archive", pathString(archivePath),
+        "--output-archive-shard-size", "1" };
+    checkStderr({ "Processing", pathString(inputPath.filename()) }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create from " << pathString(inputPath);
+    });
+    EXPECT_FALSE(std::filesystem::exists(getOutputPath() / utils::utf8ToPath(inputFile + ".enigmaxml")));
+    EXPECT_FALSE(std::filesystem::exists(getOutputPath() / utils::utf8ToPath(inputFile + ".mxl")));
+    ASSERT_TRUE(std::filesystem::exists(secondShardPath));
+
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    std::map<std::string, std::string> entries;
+    for (const auto& shardPath : { archivePath, secondShardPath }) {
+        const utils::ZipArchiveIndex shard(shardPath, denigmaContext);
+        ASSERT_EQ(shard.entries().size(), 1u) << pathString(shardPath);
+        EXPECT_EQ(shard.entries().front().method, 0);
+        entries.emplace(shard.entries().front().filename, shard.read(shard.entries().front()));
+    }
+    auto entryEndingWith = [&](const std::string& suffix) -> const std::string* {
+        for (const auto& [name, contents] : entries) {
+            if (name.ends_with(suffix)) {
+                return &contents;
+            }
+        }
+        return nullptr;
+    };
+    const auto* enigmaXml = entryEndingWith(inputFile + ".enigmaxml");
+    ASSERT_NE(enigmaXml, nullptr);
+    std::vector<char> reference;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath(inputFile + ".enigmaxml"), reference);
+    EXPECT_EQ(*enigmaXml, std::string(reference.begin(), reference.end()));
+    const auto* mxl = entryEndingWith(inputFile + ".mxl");
+    ASSERT_NE(mxl, nullptr);
+    denigma::BufferRandomAccessReader mxlReader(std::as_bytes(std::span<const char>(mxl->data(), mxl->size())));
+    EXPECT_EQ(utils::readFile(mxlReader, "mimetype", denigmaContext), "application/vnd.recordare.musicxml");
+
+    std::ifstream index(getOutputPath() / "batch.zip.index.tsv");
+    std::string line;
+    std::size_t lineCount = 0;
+    while (std::getline(index, line)) {
+        EXPECT_TRUE(entries.contains(line.substr(0, line.find('\t')))) << line;
+        ++lineCount;
+    }
+    EXPECT_EQ(lineCount, 2u);
+}
+
+TEST(Export, WriteBehindWritesEveryOutput)
+{
+    setupTestDataPaths();
+    std::string inputFile = "notAscii-其れ";
+    std::filesystem::path inputPath;
+    copyInputToOutput(inputFile + ".musx", inputPath);
+    const auto enigmaXmlPath = getOutputPath() / utils::utf8ToPath(inputFile + ".enigmaxml");
+    const auto mxlPath = getOutputPath() / utils::utf8ToPath(inputFile + ".mxl");
+    std::filesystem::remove(enigmaXmlPath);
+    std::filesystem::remove(mxlPath);
+
+    // a one-byte queue makes every output wait for the one before it to reach the disk
+    ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), "--enigmaxml", "--mxl", "--write-behind-queue-size", "1" };
+    checkStderr({ "Processing", pathString(inputPath.filename()) }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create from " << pathString(inputPath);
+    });
+    std::vector<char> written;
+    readFile(enigmaXmlPath, written);
+    std::vector<char> reference;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath(inputFile + ".enigmaxml"), reference);
+    EXPECT_EQ(written, reference);
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    denigma::FileRandomAccessReader mxlReader(mxlPath);
+    EXPECT_EQ(utils::readFile(mxlReader, "mimetype", denigmaContext), "application/vnd.recordare.musicxml");
+}
+
+TEST(Export, PipelineConvertsEveryInput)
+{
+    setupTestDataPaths();
+    const std::string inputFile = "notAscii-其れ";
+    const auto batchPath = getOutputPath() / "pipeline";
+    std::filesystem::remove_all(batchPath);
+    std::filesystem::create_directories(batchPath);
+    const auto source = getInputPath() / utils::utf8ToPath(inputFile + ".musx");
+    constexpr int INPUT_COUNT = 5;
+    for (int x = 0; x < INPUT_COUNT; x++) {
+        std::filesystem::copy_file(source, batchPath / ("input" + std::to_string(x) + ".musx"));
+    }
+
+    // one reader feeding two converting workers keeps the ready queue full
+    ArgList args = { DENIGMA_NAME, "export", pathString(batchPath), "--enigmaxml", "--pipeline", "1", "--jobs", "2" };
+    checkStderr({ "Processing", "input4.musx" }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "export from " << pathString(batchPath);
+    });
+    std::vector<char> reference;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath(inputFile + ".enigmaxml"), reference);
+    for (int x = 0; x < INPUT_COUNT; x++) {
+        const auto output = batchPath / ("input" + std::to_string(x) + ".enigmaxml");
+        std::vector<char> written;
+        readFile(output, written);
+        EXPECT_EQ(written, reference) << pathString(output);
+    }
+}
+
+TEST(Export, PrefetchConvertsInSubmissionOrder)
+{
+    setupTestDataPaths();
+    const std::string inputFile = "notAscii-其れ";
+    const auto batchPath = getOutputPath() / "prefetch";
+    std::filesystem::remove_all(batchPath);
+    std::filesystem::create_directories(batchPath);
+    const auto source = getInputPath() / utils::utf8ToPath(inputFile + ".musx");
+    constexpr int INPUT_COUNT = 3;
+    for (int x = 0; x < INPUT_COUNT; x++) {
+        std::filesystem::copy_file(source, batchPath / ("input" + std::to_string(x) + ".musx"));
+    }
+
+    ArgList args = { DENIGMA_NAME, "export", pathString(batchPath), "--enigmaxml", "--prefetch", "2" };
+    checkStderr({ "input0.musx", "input1.musx", "input2.musx" }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "export from " << pathString(batchPath);
+    });
+    std::vector<char> reference;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath(inputFile + ".enigmaxml"), reference);
+    std::filesystem::file_time_type previousWrite{};
+    for (int x = 0; x < INPUT_COUNT; x++) {
+        const auto output = batchPath / ("input" + std::to_string(x) + ".enigmaxml");
+        std::vector<char> written;
+        readFile(output, written);
+        EXPECT_EQ(written, reference) << pathString(output);
+        const auto writeTime = std::filesystem::last_write_time(output);
+        EXPECT_GE(writeTime, previousWrite) << "converted in submission order: " << pathString(output);
+        previousWrite = writeTime;
+    }
+}
+
+TEST(Export, DedupeCopiesOutputsOfIdenticalInputs)
+{
+    setupTestDataPaths();
+    const std::string inputFile = "notAscii-其れ";
+    const auto batchPath = getOutputPath() / "dedupe";
+    std::filesystem::remove_all(batchPath);
+    std::filesystem::create_directories(batchPath / "a");
+    std::filesystem::create_directories(batchPath / "b");
+    const auto source = getInputPath() / utils::utf8ToPath(inputFile + ".musx");
+    std::filesystem::copy_file(source, batchPath / "a" / utils::utf8ToPath(inputFile + ".musx"));
+    std::filesystem::copy_file(source, batchPath / "b" / "copy.musx");
+
+    ArgList args = { DENIGMA_NAME, "export", pathString(batchPath), "--recursive", "--enigmaxml", "--dedupe" };
+    checkStderr({ "Processing", "same content as" }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "export from " << pathString(batchPath);
+    });
+    std::vector<char> reference;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath(inputFile + ".enigmaxml"), reference);
+    for (const auto& output : { batchPath / "a" / utils::utf8ToPath(inputFile + ".enigmaxml"), batchPath / "b" / "copy.enigmaxml" }) {
+        std::vector<char> written;
+        readFile(output, written);
+        EXPECT_EQ(written, reference) << pathString(output);
+    }
+}
+
+#ifndef _WIN32
+TEST(Export, IsolateConvertsInWorkerProcesses)
+{
+    setupTestDataPaths();
+    std::string inputFile = "notAscii-其れ";
+    std::filesystem::path inputPath;
+    copyInputToOutput(inputFile + ".musx", inputPath);
+    const auto outputPath = getOutputPath() / utils::utf8ToPath(inputFile + ".enigmaxml");
+    std::filesystem::remove(outputPath);
+
+    ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), "--enigmaxml", "--isolate", "60" };
+    checkStderr({ "Processing", pathString(inputPath.filename()) }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create from " << pathString(inputPath);
+    });
+    std::vector<char> written;
+    readFile(outputPath, written);
+    std::vector<char> reference;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath(inputFile + ".enigmaxml"), reference);
+    EXPECT_EQ(written, reference);
+}
+#endif
+
+TEST(Export, XmlCacheReusesInflatedScore)
+{
+    setupTestDataPaths();
+    std::string inputFile = "notAscii-其れ";
+    std::filesystem::path inputPath;
+    copyInputToOutput(inputFile + ".musx", inputPath);
+    const auto cacheDir = getOutputPath() / "xml-cache";
+    std::filesystem::remove_all(cacheDir);
+
+    const std::filesystem::path enigmaFilename = utils::utf8ToPath(inputFile + ".enigmaxml");
+    const auto referencePath = getInputPath() / "reference" / enigmaFilename;
+    ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), "--enigmaxml", "--force", "--cache-dir", pathString(cacheDir) };
+    auto exportWithCache = [&]() {
+        checkStderr({ "Processing", pathString(inputPath.filename()) }, [&]() {
+            EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create from " << pathString(inputPath);
+        });
+    };
+
+    exportWithCache();
+    compareFiles(referencePath, getOutputPath() / enigmaFilename);
+    std::vector<std::filesystem::path> cacheFiles;
+    for (const auto& entry : std::filesystem::directory_iterator(cacheDir)) {
+        cacheFiles.push_back(entry.path());
+    }
+    ASSERT_EQ(cacheFiles.size(), 1u);
+    compareFiles(referencePath, cacheFiles.front());
+
+    // a hit is served from the cache, not from score.dat
+    {
+        std::ofstream cacheFile(cacheFiles.front(), std::ios::binary | std::ios::app);
+        cacheFile << "<!-- from cache -->";
+    }
+    exportWithCache();
+    assertStringInFile("<!-- from cache -->", getOutputPath() / enigmaFilename);
+}
+
+TEST(Export, IncrementalSkipsUnchangedInputs)
+{
+    setupTestDataPaths();
+    std::string inputFile = "pageDiffThanOpts";
+    std::filesystem::path inputPath;
+    copyInputToOutput(inputFile + ".musx", inputPath);
+    const auto manifestPath = getOutputPath() / "incremental.manifest";
+    std::filesystem::remove(manifestPath);
+    const auto outputPath = getOutputPath() / (inputFile + ".enigmaxml");
+
+    auto exportIncremental = [&](const std::string& expectedMessage, const std::vector<std::string>& extraArgs) {
+        ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), "--enigmaxml", "--force", "--incremental", pathString(manifestPath) };
+        for (const auto& arg : extraArgs) {
+            args.add(arg);
+        }
+        checkStderr({ expectedMessage, pathString(inputPath.filename()) }, [&]() {
+            EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create from " << pathString(inputPath);
+        });
+    };
+
+    exportIncremental("Processing", {});
+    ASSERT_TRUE(std::filesystem::exists(manifestPath));
+    exportIncremental("Skipping unchanged", {});
+
+    // touching the input without changing it is still a skip, but options and missing outputs are not
+    std::filesystem::last_write_time(inputPath, std::filesystem::last_write_time(inputPath) + std::chrono::seconds(10));
+    exportIncremental("Skipping unchanged", {});
+    exportIncremental("Processing", { "--no-validate" });
+    std::filesystem::remove(outputPath);
+    exportIncremental("Processing", { "--no-validate" });
+    EXPECT_TRUE(std::filesystem::exists(outputPath));
+
+    std::filesystem::copy_file(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"), inputPath, std::filesystem::copy_options::overwrite_existing);
+    exportIncremental("Processing", { "--no-validate" });
+}
+
 TEST(Export, CalcPageFormat)
 {
     setupTestDataPaths();
@@ -425,6 +779,53 @@ TEST(Export, ReverseMusxTimestamp)
     EXPECT_LE(fileInfo.tmu_date.tm_mday, 31);
 }
 
+TEST(Export, ReverseMusxParallelCompressionRoundTrips)
+{
+    setupTestDataPaths();
+    std::filesystem::path inputMusxPath;
+    copyInputToOutput("pageDiffThanOpts.musx", inputMusxPath);
+
+    std::filesystem::path enigmaxmlPath = getOutputPath() / "pageDiffThanOpts.enigmaxml";
+    {
+        ArgList args = { DENIGMA_NAME, "export", pathString(inputMusxPath), "--enigmaxml", "--force" };
+        checkStderr({ "Processing", pathString(inputMusxPath.filename()) }, [&]() {
+            EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create " << pathString(enigmaxmlPath);
+        });
+    }
+
+    std::filesystem::path reverseMusxPath = getOutputPath() / "pageDiffThanOpts.parallel.musx";
+    {
+        ArgList args = { DENIGMA_NAME, "export", pathString(enigmaxmlPath), "--musx", pathString(reverseMusxPath),
+                         "--output-jobs", "4", "--musx-compression-level", "9", "--force" };
+        checkStderr({ "Processing", pathString(enigmaxmlPath.filename()) }, [&]() {
+            EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create " << pathString(reverseMusxPath);
+        });
+    }
+    ASSERT_TRUE(std::filesystem::exists(reverseMusxPath));
+
+    const std::string zipPath = pathString(reverseMusxPath);
+    unzFile zip = unzOpen64(zipPath.c_str());
+    ASSERT_NE(zip, nullptr) << "unable to open " << zipPath;
+    ASSERT_EQ(unzLocateFile(zip, "score.dat", 1), UNZ_OK) << "unable to locate score.dat in " << zipPath;
+    unz_file_info64 fileInfo{};
+    ASSERT_EQ(unzGetCurrentFileInfo64(zip, &fileInfo, nullptr, 0, nullptr, 0, nullptr, 0), UNZ_OK);
+    unzClose(zip);
+    EXPECT_EQ(fileInfo.compression_method, 0u) << "score.dat is already gzip and should be stored";
+
+    std::filesystem::path roundTripPath = getOutputPath() / "pageDiffThanOpts.parallel.enigmaxml";
+    {
+        ArgList args = { DENIGMA_NAME, "export", pathString(reverseMusxPath), "--enigmaxml", pathString(roundTripPath), "--force" };
+        checkStderr({ "Processing", pathString(reverseMusxPath.filename()) }, [&]() {
+            EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create " << pathString(roundTripPath);
+        });
+    }
+    std::vector<char> original;
+    std::vector<char> roundTrip;
+    readFile(enigmaxmlPath, original);
+    readFile(roundTripPath, roundTrip);
+    EXPECT_EQ(roundTrip, original);
+}
+
 TEST(Export, ReverseDefaultOutputMusx)
 {
     setupTestDataPaths();
@@ -472,7 +873,236 @@ TEST(ZipUtils, ReadMusxArchiveFiles)
     const auto bufferReaderArchiveFiles = utils::readMusxArchiveFiles(bufferReader, DenigmaContext(DENIGMA_NAME));
     EXPECT_EQ(bufferReaderArchiveFiles.scoreDat, archiveFiles.scoreDat);
     EXPECT_EQ(bufferReaderArchiveFiles.notationMetadata, archiveFiles.notationMetadata);
-    EXPECT_EQ(bufferReaderArchiveFiles.embeddedGraphics.size(), archiveFiles.embeddedGraphics.size());
+    ASSERT_EQ(bufferReaderArchiveFiles.embeddedGraphics.size(), archiveFiles.embeddedGraphics.size());
+    for (std::size_t i = 0; i < archiveFiles.embeddedGraphics.size(); i++) {
+        const auto& graphic = archiveFiles.embeddedGraphics[i];
+        const std::string blob = graphic.blob(); // graphics stay compressed until asked for
+        EXPECT_EQ(blob.size(), graphic.size) << graphic.filename;
+        EXPECT_EQ(blob, utils::readFile(inputPath, "graphics/" + graphic.filename, DenigmaContext(DENIGMA_NAME))) << graphic.filename;
+        EXPECT_EQ(bufferReaderArchiveFiles.embeddedGraphics[i].blob(), blob) << graphic.filename;
+    }
+}
+
+TEST(ZipUtils, CachingReaderCoalescesArchiveReads)
+{
+    setupTestDataPaths();
+    std::filesystem::path inputPath;
+    copyInputToOutput("pageDiffThanOpts.musx", inputPath);
+
+    class CountingReader final : public denigma::IRandomAccessReader
+    {
+    public:
+        explicit CountingReader(const denigma::IRandomAccessReader& source) : m_source(source) {}
+        std::uint64_t size() const override { return m_source.size(); }
+        std::size_t readAt(std::uint64_t offset, std::span<std::byte> output) const override
+        {
+            reads++;
+            return m_source.readAt(offset, output);
+        }
+        mutable std::size_t reads{};
+    private:
+        const denigma::IRandomAccessReader& m_source;
+    };
+
+    denigma::FileRandomAccessReader fileReader(inputPath);
+    CountingReader direct(fileReader);
+    const auto expected = utils::readMusxArchiveFiles(direct, DenigmaContext(DENIGMA_NAME));
+
+    CountingReader cached(fileReader);
+    denigma::CachingRandomAccessReader::Options options;
+    options.blockSize = 4096;
+    options.maxCachedBlocks = 8;
+    const denigma::CachingRandomAccessReader cachingReader(cached, options);
+    const auto archiveFiles = utils::readMusxArchiveFiles(cachingReader, DenigmaContext(DENIGMA_NAME));
+    EXPECT_EQ(archiveFiles.scoreDat, expected.scoreDat);
+    EXPECT_EQ(archiveFiles.notationMetadata, expected.notationMetadata);
+    EXPECT_EQ(cached.reads, cachingReader.sourceReadCount());
+    EXPECT_LT(cached.reads, direct.reads);
+
+    EXPECT_THROW(denigma::CachingRandomAccessReader(fileReader, denigma::CachingRandomAccessReader::Options{ 0, 1, 0 }), std::invalid_argument);
+}
+
+TEST(ZipUtils, MusxReadHintsEntryRangesToReader)
+{
+    setupTestDataPaths();
+    std::filesystem::path inputPath;
+    copyInputToOutput("pageDiffThanOpts.musx", inputPath);
+
+    class RecordingReader final : public denigma::IRandomAccessReader
+    {
+    public:
+        explicit RecordingReader(const denigma::IRandomAccessReader& source) : m_source(source) {}
+        std::uint64_t size() const override { return m_source.size(); }
+        std::size_t readAt(std::uint64_t offset, std::span<std::byte> output) const override { return m_source.readAt(offset, output); }
+        void prefetch(std::span<const denigma::ByteRange> ranges) const override { hints.insert(hints.end(), ranges.begin(), ranges.end()); }
+        mutable std::vector<denigma::ByteRange> hints;
+    private:
+        const denigma::IRandomAccessReader& m_source;
+    };
+
+    denigma::FileRandomAccessReader fileReader(inputPath);
+    RecordingReader recorder(fileReader);
+    const denigma::CachingRandomAccessReader cachingReader(recorder); // forwards the hints
+    const auto archiveFiles = utils::readMusxArchiveFiles(cachingReader, DenigmaContext(DENIGMA_NAME));
+    const std::size_t entriesRead = 1 + (archiveFiles.notationMetadata ? 1 : 0) + archiveFiles.embeddedGraphics.size();
+    ASSERT_EQ(recorder.hints.size(), entriesRead);
+    for (const auto& hint : recorder.hints) {
+        EXPECT_LT(hint.offset, fileReader.size());
+        EXPECT_GT(hint.length, 0u);
+    }
+}
+
+TEST(ZipUtils, EmbeddedGraphicsInflateOnDemand)
+{
+    setupTestDataPaths();
+    const std::filesystem::path archivePath = getOutputPath() / "lazy_graphics.musx";
+    std::string graphic;
+    for (int i = 0; i < 4096; i++) {
+        graphic.push_back(static_cast<char>((i * 7) % 13));
+    }
+    {
+        const std::string zipPath = pathString(archivePath);
+        zipFile zip = zipOpen64(zipPath.c_str(), APPEND_STATUS_CREATE);
+        ASSERT_NE(zip, nullptr);
+        auto addEntry = [&](const char* name, const std::string& contents, int method) {
+            zip_fileinfo info{};
+            ASSERT_EQ(zipOpenNewFileInZip64(zip, name, &info, nullptr, 0, nullptr, 0, nullptr, method, Z_DEFAULT_COMPRESSION, 0), ZIP_OK);
+            ASSERT_EQ(zipWriteInFileInZip(zip, contents.data(), static_cast<unsigned>(contents.size())), ZIP_OK);
+            ASSERT_EQ(zipCloseFileInZip(zip), ZIP_OK);
+        };
+        addEntry("score.dat", "not a real score", 0);
+        addEntry("graphics/1.png", graphic, Z_DEFLATED);
+        addEntry("graphics/2.png", graphic.substr(7), 0);
+        ASSERT_EQ(zipClose(zip, nullptr), ZIP_OK);
+    }
+
+    const auto archiveFiles = utils::readMusxArchiveFiles(archivePath, DenigmaContext(DENIGMA_NAME));
+    ASSERT_EQ(archiveFiles.embeddedGraphics.size(), 2u);
+    EXPECT_EQ(archiveFiles.embeddedGraphics[0].filename, "1.png");
+    EXPECT_EQ(archiveFiles.embeddedGraphics[0].size, graphic.size());
+    EXPECT_EQ(archiveFiles.embeddedGraphics[0].blob(), graphic);
+    EXPECT_EQ(archiveFiles.embeddedGraphics[1].filename, "2.png");
+    EXPECT_EQ(archiveFiles.embeddedGraphics[1].blob(), graphic.substr(7));
+}
+
+TEST(ZipUtils, ModifyInPlaceCopiesUnchangedEntriesRaw)
+{
+    setupTestDataPaths();
+    std::filesystem::path inputPath;
+    copyInputToOutput("notAscii-其れ.mxl", inputPath);
+    const std::filesystem::path outputPath = getOutputPath() / "notAscii-其れ.rawcopy.mxl";
+
+    struct EntryStamp
+    {
+        uLong crc{};
+        ZPOS64_T compressedSize{};
+        uLong method{};
+    };
+    auto readStamps = [](const std::filesystem::path& zipFilePath) {
+        std::map<std::string, EntryStamp> stamps;
+        const std::string zipPath = pathString(zipFilePath);
+        unzFile zip = unzOpen64(zipPath.c_str());
+        EXPECT_NE(zip, nullptr) << "unable to open " << zipPath;
+        if (!zip) return stamps;
+        for (int rc = unzGoToFirstFile(zip); rc == UNZ_OK; rc = unzGoToNextFile(zip)) {
+            std::array<char, 512> name{};
+            unz_file_info64 info{};
+            unzGetCurrentFileInfo64(zip, &info, name.data(), static_cast<uLong>(name.size()), nullptr, 0, nullptr, 0);
+            stamps[name.data()] = { info.crc, info.compressed_size, info.compression_method };
+        }
+        unzClose(zip);
+        return stamps;
+    };
+
+    std::string changedEntry;
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    denigmaContext.outputJobs = 0; // compress changed entries on all cores
+    utils::iterateModifyFilesInPlace(inputPath, outputPath, denigmaContext,
+        [&](const std::filesystem::path& fileName, std::string& fileContents, bool isScore) {
+            if (isScore) {
+                changedEntry = utils::utf8ToString(fileName.u8string());
+                fileContents += "<!-- modified -->\n";
+            }
+            return true;
+        });
+    ASSERT_FALSE(changedEntry.empty());
+    EXPECT_TRUE(utils::readFile(outputPath, changedEntry, denigmaContext).ends_with("<!-- modified -->\n"));
+
+    const auto inputStamps = readStamps(inputPath);
+    const auto outputStamps = readStamps(outputPath);
+    ASSERT_FALSE(inputStamps.empty());
+    for (const auto& [name, stamp] : inputStamps) {
+        if (name.ends_with('/')) {
+            continue; // directory entries are not rewritten
+        }
+        const auto it = outputStamps.find(name);
+        ASSERT_NE(it, outputStamps.end()) << name;
+        if (name == changedEntry) {
+            EXPECT_NE(it->second.crc, stamp.crc) << name;
+        } else {
+            EXPECT_EQ(it->second.crc, stamp.crc) << name;
+            EXPECT_EQ(it->second.compressedSize, stamp.compressedSize) << name << " should be copied raw";
+            EXPECT_EQ(it->second.method, stamp.method) << name;
+        }
+    }
+}
+
+TEST(ZipUtils, ArchiveIndexServesEntriesByName)
+{
+    setupTestDataPaths();
+    std::filesystem::path inputPath;
+    copyInputToOutput("notAscii-其れ.mxl", inputPath);
+
+    DenigmaContext denigmaContext(DENIGMA_NAME);
+    const utils::ZipArchiveIndex archive(inputPath, denigmaContext);
+    ASSERT_FALSE(archive.entries().empty());
+    EXPECT_EQ(archive.musicXmlScoreName(denigmaContext), "notAscii-其れ.musicxml");
+    EXPECT_EQ(archive.find("no-such-entry.xml"), nullptr);
+
+    for (const auto& entry : archive.entries()) {
+        ASSERT_EQ(archive.find(entry.filename), &entry) << entry.filename;
+        if (!entry.isFile) {
+            continue;
+        }
+        const std::string contents = archive.read(entry);
+        EXPECT_EQ(contents.size(), entry.uncompressedSize) << entry.filename;
+        EXPECT_EQ(contents, utils::readFile(inputPath, entry.filename, denigmaContext)) << entry.filename;
+    }
+    EXPECT_EQ(utils::getMusicXmlScoreFile(archive, denigmaContext), utils::getMusicXmlScoreFile(inputPath, denigmaContext));
+
+    std::vector<std::string> parts;
+    utils::iterateMusicXmlPartFiles(archive, denigmaContext, std::nullopt, [&](const std::filesystem::path& fileName, const std::string&) {
+        parts.push_back(utils::utf8ToString(fileName.u8string()));
+        return true;
+    });
+    EXPECT_EQ(parts, std::vector<std::string>{ "p1.musicxml" });
+}
+
+TEST(ZipUtils, InflateKnownSizeMatchesZlib)
+{
+    std::string original;
+    for (int i = 0; i < 2000; i++) {
+        original += "<entry id=\"" + std::to_string(i) + "\">denigma</entry>\n";
+    }
+    z_stream stream{};
+    ASSERT_EQ(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY), Z_OK);
+    std::string compressed(deflateBound(&stream, static_cast<uLong>(original.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(original.data());
+    stream.avail_in = static_cast<uInt>(original.size());
+    stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+    stream.avail_out = static_cast<uInt>(compressed.size());
+    ASSERT_EQ(deflate(&stream, Z_FINISH), Z_STREAM_END);
+    compressed.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    std::string inflated(original.size(), '\0');
+    const bool accelerated = utils::inflateKnownSize(compressed, utils::DeflateFormat::Raw, inflated);
+    EXPECT_EQ(accelerated, utils::hasAcceleratedInflate()) << utils::inflateBackendName();
+    if (accelerated) {
+        EXPECT_EQ(inflated, original);
+    }
+    std::string tooLarge(original.size() + 1, '\0');
+    EXPECT_FALSE(utils::inflateKnownSize(compressed, utils::DeflateFormat::Raw, tooLarge));
 }
 
 TEST(Export, MnxFromEnigmaxmlNoMetadataStillWorks)
@@ -26,7 +26,9 @@
 
 #include "gtest/gtest.h"
 
+#include "classify/classification_cache.h"
 #include "core/musx_reader.h"
+#include "denigma/classify/batch.h"
 #include "denigma/classify/expressions.h"
 #include "musx/musx.h"
 #include "utils/stringutils.h"
@@ -640,6 +642,27 @@ TEST(ExpressionClassification, BatchClassificationPropagatesTopStaffSystemTextBy
     EXPECT_EQ(rehearsalResults[1].classification.basis, ClassificationBasis::Heuristic);
 }
 
+TEST(ExpressionClassification, ColumnBatchMatchesAssignmentBatch)
+{
+    const auto context = makeTextExpressionContext("rit.", ExpressionCategoryType::Misc, {}, true);
+    MusxInstanceList<others::MeasureExprAssign> assignments(context.document, SCORE_PARTID);
+    assignments.push_back(makeStaffTextAssignment(context.document, 1, 1));
+    assignments.push_back(context.assignment);
+
+    const auto columns = classifyExpressionColumns(assignments);
+    ASSERT_EQ(columns.size(), 2u);
+    ASSERT_EQ(columns.bases.size(), 2u);
+    ASSERT_EQ(columns.subtypes.size(), 2u);
+    ASSERT_EQ(columns.texts.size(), 2u);
+    for (std::size_t row = 0; row < columns.size(); ++row) {
+        EXPECT_EQ(columns.types[row], ExpressionType::TempoAlteration);
+        EXPECT_EQ(columns.bases[row], ClassificationBasis::Heuristic);
+        EXPECT_EQ(columns.strings.at(columns.texts[row]), "rit.");
+    }
+    EXPECT_EQ(columns.texts[0], columns.texts[1]);
+    EXPECT_EQ(columns.strings.size(), 1u);
+}
+
 TEST(ExpressionClassification, ClassifiesSystemExpressionWithRehearsalMarkStyleAsRehearsalMark)
 {
     const auto rehearsalContext = makeTextExpressionContext(
@@ -707,3 +730,24 @@ TEST(ExpressionClassification, SuppressesUnrecognizedShapeExpression)
 
     EXPECT_EQ(result.type, ExpressionType::Suppress);
 }
+
+TEST(ExpressionClassification, SharedDefinitionIsClassifiedOncePerDocumentAndUse)
+{
+    const auto context = makeTextExpressionContext("rit.", ExpressionCategoryType::Misc, {}, true);
+    const auto cache = denigma::classify::detail::ClassificationCache::forDocument(context.document);
+    ASSERT_TRUE(cache);
+    EXPECT_EQ(cache, denigma::classify::detail::ClassificationCache::forDocument(context.document));
+    const auto otherContext = makeTextExpressionContext("rit.", ExpressionCategoryType::Misc, {}, true);
+    EXPECT_NE(cache, denigma::classify::detail::ClassificationCache::forDocument(otherContext.document));
+
+    // the cached result for one use of the definition must not leak into another use of it
+    const auto firstStaff = classifyExpression(makeStaffTextAssignment(context.document, 1, 1));
+    const auto topStaff = classifyExpression(context.assignment);
+    const auto secondStaff = classifyExpression(makeStaffTextAssignment(context.document, 1, 2, Inci{ 2 }));
+    EXPECT_EQ(firstStaff.type, ExpressionType::GenericText);
+    EXPECT_EQ(topStaff.type, ExpressionType::TempoAlteration);
+    EXPECT_EQ(secondStaff.type, ExpressionType::GenericText);
+    EXPECT_EQ(secondStaff.genericText().text, firstStaff.genericText().text);
+    EXPECT_TRUE(firstStaff.enigmaCtx.has_value());
+    EXPECT_TRUE(secondStaff.enigmaCtx.has_value());
+}
@@ -21,7 +21,9 @@
  */
 #include "gtest/gtest.h"
 
+#include "utils/font_metric_tables.h"
 #include "utils/font_names.h"
+#include "utils/smufl_metadata_tables.h"
 
 TEST(FontNames, NormalizedFontNameKeepsOnlyAsciiAlphanumerics)
 {
@@ -54,3 +56,81 @@ TEST(FontNames, DoesNotMapUnknownFonts)
     EXPECT_FALSE(utils::mappedSmuflFontForFinaleLegacyFont("Times New Roman").has_value());
     EXPECT_FALSE(utils::isFinaleLegacyMusicFontMappedToSmufl("Times New Roman"));
 }
+
+namespace {
+
+constexpr utils::FontMetricGlyph TEST_GLYPHS[] = {
+    { U'A', 600, 0, -100, 600, 700 },
+    { U'V', 500, 10, 0, 490, 700 },
+};
+constexpr utils::FontMetricKerning TEST_KERNING[] = {
+    { U'A', U'V', -80 },
+};
+constexpr utils::FontMetricTable TEST_TABLES[] = {
+    { "testfont", false, false, 1000, 800, -200, TEST_GLYPHS, TEST_KERNING },
+    { "testfont", true, false, 1000, 800, -200, TEST_GLYPHS, {} },
+};
+
+} // namespace
+
+TEST(FontMetricTables, FindsTablesByNormalizedNameAndStyle)
+{
+    EXPECT_EQ(utils::findFontMetricTable(TEST_TABLES, "Test Font", false, false), &TEST_TABLES[0]);
+    EXPECT_EQ(utils::findFontMetricTable(TEST_TABLES, "Test-Font", true, false), &TEST_TABLES[1]);
+    EXPECT_EQ(utils::findFontMetricTable(TEST_TABLES, "Test Font", false, true), nullptr);
+    EXPECT_EQ(utils::findFontMetricTable(TEST_TABLES, "Other Font", false, false), nullptr);
+}
+
+TEST(FontMetricTables, MeasuresTextWithKerningAndInkExtent)
+{
+    const auto measured = utils::measureTextWithTable(TEST_TABLES[0], U"AV", 10.0);
+    ASSERT_TRUE(measured.has_value());
+    EXPECT_DOUBLE_EQ(measured->advance, (600 - 80 + 500) / 100.0);
+    EXPECT_DOUBLE_EQ(measured->ascent, 7.0);
+    EXPECT_DOUBLE_EQ(measured->descent, 1.0);
+
+    const auto unkerned = utils::measureTextWithTable(TEST_TABLES[1], U"AV", 10.0);
+    ASSERT_TRUE(unkerned.has_value());
+    EXPECT_DOUBLE_EQ(unkerned->advance, 11.0);
+}
+
+TEST(FontMetricTables, MissingGlyphFallsBackToTheFont)
+{
+    EXPECT_FALSE(utils::measureTextWithTable(TEST_TABLES[0], U"AB", 10.0).has_value());
+}
+
+namespace {
+
+constexpr utils::SmuflMetadataGlyph TEST_SMUFL_GLYPHS[] = {
+    { "accidentalFlat", true, 0.904, false, {} },
+    { "gClef", false, 0.0, true, { 0.0, -2.632, 2.684, 4.392 } },
+};
+constexpr utils::SmuflMetadataOptionalGlyph TEST_SMUFL_OPTIONAL_GLYPHS[] = {
+    { 0xF427, "accidentalFlatSmall" },
+    { 0xF472, "gClefAlt" },
+};
+constexpr utils::SmuflMetadataTable TEST_SMUFL_TABLES[] = {
+    { "testmusic", TEST_SMUFL_GLYPHS, TEST_SMUFL_OPTIONAL_GLYPHS },
+};
+
+} // namespace
+
+TEST(SmuflMetadataTables, FindsTablesByNormalizedName)
+{
+    EXPECT_EQ(utils::findSmuflMetadataTable(TEST_SMUFL_TABLES, "Test Music"), &TEST_SMUFL_TABLES[0]);
+    EXPECT_EQ(utils::findSmuflMetadataTable(TEST_SMUFL_TABLES, "Other Music"), nullptr);
+}
+
+TEST(SmuflMetadataTables, FindsGlyphsByNameAndOptionalGlyphsByCodePoint)
+{
+    const auto& table = TEST_SMUFL_TABLES[0];
+    const auto* clef = table.findGlyph("gClef");
+    ASSERT_NE(clef, nullptr);
+    EXPECT_FALSE(clef->hasAdvance);
+    ASSERT_TRUE(clef->hasBBox);
+    EXPECT_DOUBLE_EQ(clef->bbox[3], 4.392);
+    EXPECT_EQ(table.findGlyph("noteheadBlack"), nullptr);
+
+    EXPECT_EQ(table.findOptionalGlyphName(0xF472), "gClefAlt");
+    EXPECT_TRUE(table.findOptionalGlyphName(0xF473).empty());
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <optional>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "core/host_resources.h"
+
+using namespace denigma;
+
+TEST(HostResources, FindsCgroupPathForControllerOrUnifiedHierarchy)
+{
+    const std::string v1 = "12:memory:/docker/abc\n11:cpu,cpuacct:/docker/abc/cpu\n0::/init.scope\n";
+    EXPECT_EQ(detail::findCgroupPath(v1, "memory"), std::optional<std::string>("/docker/abc"));
+    EXPECT_EQ(detail::findCgroupPath(v1, "cpu"), std::optional<std::string>("/docker/abc/cpu"));
+    EXPECT_EQ(detail::findCgroupPath(v1, "cpuacct"), std::optional<std::string>("/docker/abc/cpu"));
+    EXPECT_EQ(detail::findCgroupPath(v1, ""), std::optional<std::string>("/init.scope"));
+    EXPECT_FALSE(detail::findCgroupPath(v1, "pids").has_value());
+    EXPECT_EQ(detail::findCgroupPath("0::/\n", ""), std::optional<std::string>("/"));
+}
+
+TEST(HostResources, ParsesCgroupLimits)
+{
+    EXPECT_EQ(detail::parseCgroupV2CpuMax("200000 100000\n"), std::optional<double>(2.0));
+    EXPECT_EQ(detail::parseCgroupV2CpuMax("50000 100000"), std::optional<double>(0.5));
+    EXPECT_FALSE(detail::parseCgroupV2CpuMax("max 100000\n").has_value());
+    EXPECT_FALSE(detail::parseCgroupV2CpuMax("").has_value());
+
+    EXPECT_EQ(detail::parseCgroupMemoryLimit("536870912\n"), std::optional<std::uint64_t>(536870912));
+    EXPECT_FALSE(detail::parseCgroupMemoryLimit("max\n").has_value());
+    EXPECT_FALSE(detail::parseCgroupMemoryLimit("9223372036854771712\n").has_value()); // v1's "unlimited"
+}
+
+TEST(HostResources, ReportsAtLeastOneCpu)
+{
+    EXPECT_GE(availableCpuCount(), 1u);
+    EXPECT_GE(hostResources().cpus, 1u);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
+#include "core/denigma.h"
+#include "test_utils.h"
+
+using namespace denigma;
+
+TEST(Info, WritesOneRecordPerInputToOneFile)
+{
+    setupTestDataPaths();
+    std::filesystem::path inputPath;
+    for (const std::string inputFile : { "ottavas.musx", "ottavas_edge.musx", "ottavas_simple.musx" }) {
+        copyInputToOutput(inputFile, inputPath);
+    }
+    const auto catalogPath = getOutputPath() / "ottavas-catalog.jsonl";
+    ArgList args = { DENIGMA_NAME, "info", pathString(getOutputPath() / "ottavas*.musx"), "--jsonl", pathString(catalogPath), "--force" };
+    EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0);
+
+    std::ifstream catalog(catalogPath);
+    ASSERT_TRUE(catalog.is_open());
+    std::vector<nlohmann::json> records;
+    for (std::string line; std::getline(catalog, line); ) {
+        records.push_back(nlohmann::json::parse(line));
+    }
+    ASSERT_EQ(records.size(), 3u);
+    for (const auto& record : records) {
+        EXPECT_NE(record["source"].get<std::string>().find("ottavas"), std::string::npos);
+        EXPECT_GT(record["measures"].get<int>(), 0);
+        EXPECT_GT(record["pages"].get<int>(), 0);
+        EXPECT_TRUE(record["fileVersion"].is_string());
+        EXPECT_TRUE(record["parts"].is_array());
+    }
+}
+
+TEST(Info, WritesToStandardOutputByDefault)
+{
+    setupTestDataPaths();
+    std::filesystem::path inputPath;
+    copyInputToOutput("ottavas_simple.musx", inputPath);
+    ArgList args = { DENIGMA_NAME, "info", pathString(inputPath) };
+    checkStdout({ "\"source\":", "\"measures\":" }, [&]() {
+        EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0);
+    });
+    EXPECT_FALSE(std::filesystem::exists(getOutputPath() / "ottavas_simple.jsonl"));
+}
@@ -21,8 +21,12 @@
  */
 #include <string>
 #include <filesystem>
+#include <fstream>
 #include <iterator>
+#include <set>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "core/denigma.h"
@@ -171,3 +175,123 @@ TEST(Logging, ConversionResultCollectsWarningAndErrorDiagnostics)
     EXPECT_EQ(result.diagnostics().back().severity, denigma::MessageSeverity::Error);
     EXPECT_EQ(result.diagnostics().back().message, "error message");
 }
+
+TEST(Logging, SuppressedMessagesAreNotFormatted)
+{
+    denigma::DenigmaContext context(DENIGMA_NAME);
+    std::vector<std::string> messages;
+    context.logCallback = [&](denigma::MessageSeverity, std::string_view message) { messages.emplace_back(message); };
+    int formatCount = 0;
+    auto format = [&](denigma::LogMsg& msg) {
+        ++formatCount;
+        msg << "message " << formatCount;
+    };
+
+    context.logMessage(format, denigma::MessageSeverity::Verbose);
+    EXPECT_EQ(formatCount, 0);
+    context.logMessage(format, denigma::MessageSeverity::Info);
+    EXPECT_EQ(formatCount, 1);
+
+    context.verbose = true;
+    context.logMessage(format, denigma::MessageSeverity::Verbose);
+    EXPECT_EQ(formatCount, 2);
+
+    context.quiet = true;
+    context.logMessage(format, denigma::MessageSeverity::Verbose);
+    context.logMessage(format, denigma::MessageSeverity::Info);
+    EXPECT_EQ(formatCount, 2);
+    context.logMessage(format, denigma::MessageSeverity::Warning);
+    EXPECT_EQ(formatCount, 3);
+    EXPECT_EQ(messages, (std::vector<std::string>{ "message 1", "message 2", "message 3" }));
+}
+
+TEST(Logging, LogFileWriterKeepsOrderThroughASmallRing)
+{
+    setupTestDataPaths();
+    const auto logPath = getOutputPath() / "log_file_writer.log";
+    std::filesystem::remove(logPath);
+    auto writeLines = [&](int first, int count) {
+        denigma::LogFileWriter writer(logPath, 2);
+        for (int index = first; index < first + count; index++) {
+            writer.write("line " + std::to_string(index), index == first);
+        }
+    };
+    writeLines(0, 50);
+    writeLines(50, 10); // appends after an empty line
+
+    std::ifstream log(logPath);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(log, line); ) {
+        lines.push_back(line);
+    }
+    ASSERT_EQ(lines.size(), 61u);
+    EXPECT_TRUE(lines[50].empty());
+    for (int index = 0; index < 60; index++) {
+        const auto& line = lines[static_cast<std::size_t>(index < 50 ? index : index + 1)];
+        ASSERT_EQ(line.size(), std::string("[YYYY-MM-DD HH:MM:SS] ").size() + ("line " + std::to_string(index)).size()) << line;
+        EXPECT_EQ(line.front(), '[');
+        EXPECT_EQ(line.substr(line.find("] ") + 2), "line " + std::to_string(index));
+    }
+}
+
+TEST(Logging, MusxLoggerScopeRoutesPerThread)
+{
+    using LogLevel = musx::util::Logger::LogLevel;
+    auto collectInto = [](std::vector<std::string>& messages) {
+        return [&messages](LogLevel, const std::string& message) { messages.push_back(message); };
+    };
+    std::vector<std::string> mainMessages;
+    std::vector<std::string> workerMessages;
+    denigma::MusxLoggerScope mainScope(collectInto(mainMessages));
+    const auto bridge = musx::util::Logger::getCallback();
+    std::thread worker([&]() {
+        denigma::MusxLoggerScope workerScope(collectInto(workerMessages));
+        bridge(LogLevel::Info, "worker");
+    });
+    worker.join();
+    std::thread([&]() { bridge(LogLevel::Verbose, "unscoped"); }).join();
+    bridge(LogLevel::Info, "main");
+    {
+        std::vector<std::string> nestedMessages;
+        denigma::MusxLoggerScope nestedScope(collectInto(nestedMessages));
+        bridge(LogLevel::Info, "nested");
+        EXPECT_EQ(nestedMessages, std::vector<std::string>{ "nested" });
+    }
+    bridge(LogLevel::Info, "main again");
+    EXPECT_EQ(mainMessages, (std::vector<std::string>{ "main", "main again" }));
+    EXPECT_EQ(workerMessages, std::vector<std::string>{ "worker" });
+}
+
+TEST(Logging, TraceFile)
+{
+    setupTestDataPaths();
+    std::string inputFile = "notAscii-其れ";
+    std::filesystem::path inputPath;
+    copyInputToOutput(inputFile + ".musx", inputPath);
+    const auto tracePath = inputPath.parent_path() / "trace.json";
+    ArgList args = { DENIGMA_NAME, "export", pathString(inputPath), "--mnx", "--force", "--trace", pathString(tracePath) };
+    EXPECT_EQ(denigmaTestMain(args.argc(), args.argv()), 0) << "create from " << pathString(inputPath);
+
+    nlohmann::json trace;
+    openJson(tracePath, trace);
+    ASSERT_TRUE(trace.contains("traceEvents"));
+    std::set<std::string> spanNames;
+    bool taggedWithInput = false;
+    bool namedMainThread = false;
+    for (const auto& event : trace["traceEvents"]) {
+        if (event["ph"] == "X") {
+            spanNames.insert(event["name"].get<std::string>());
+            EXPECT_GE(event["dur"].get<double>(), 0.0);
+            if (event.contains("args") && event["args"]["file"].get<std::string>().find(inputFile) != std::string::npos) {
+                taggedWithInput = true;
+            }
+        } else if (event["ph"] == "M" && event["name"] == "thread_name") {
+            namedMainThread = namedMainThread || event["args"]["name"].get<std::string>().rfind("main", 0) == 0;
+        }
+    }
+    for (const char* expected : { "processFile", "extractMusxInputData", "createMusxDocument", "createMnxDocument", "createSequences" }) {
+        EXPECT_TRUE(spanNames.contains(expected)) << "missing span " << expected;
+    }
+    EXPECT_TRUE(taggedWithInput);
+    EXPECT_TRUE(namedMainThread);
+}
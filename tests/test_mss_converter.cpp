@@ -20,6 +20,7 @@
 #include <cstring>
 #include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -137,3 +138,68 @@ TEST(ConverterApi, MusxToMssXmlInvokesOutputCallbackForParts)
     }
     EXPECT_TRUE(foundNamedPart);
 }
+
+TEST(ConverterApi, MusxToMssXmlParallelPartsMatchSerialOrder)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mss::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MssXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    auto convertWithJobs = [&](unsigned outputJobs) {
+        std::vector<std::pair<std::string, std::string>> outputs;
+        denigma::formats::mss::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.outputJobs = outputJobs;
+        options.allPartsAndScore = true;
+        const auto result = converter->convert(input, [&](std::string_view suggestedName, std::span<const std::byte> data) {
+            outputs.emplace_back(std::string(suggestedName), std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_TRUE(result.diagnostics().empty());
+        return outputs;
+    };
+
+    const auto serialOutputs = convertWithJobs(1);
+    const auto parallelOutputs = convertWithJobs(0);
+    ASSERT_GE(serialOutputs.size(), 2);
+    EXPECT_EQ(parallelOutputs, serialOutputs);
+}
+
+TEST(ConverterApi, MusxToMssXmlOwningCallbackMatchesViewingCallback)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mss::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::MssXml);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    denigma::formats::mss::Options options;
+    options.common.sourceName = "notAscii-其れ.musx";
+    options.allPartsAndScore = true;
+
+    std::vector<std::pair<std::string, std::string>> viewedOutputs;
+    const denigma::MultiOutputCallback viewingCallback = [&](std::string_view suggestedName, std::span<const std::byte> data) {
+        viewedOutputs.emplace_back(std::string(suggestedName), std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+    };
+    EXPECT_FALSE(viewingCallback.ownsOutput());
+    const auto viewedResult = converter->convert(input, viewingCallback, denigma::ConversionRequest{ &options });
+    EXPECT_TRUE(viewedResult.diagnostics().empty());
+
+    std::vector<std::pair<std::string, std::string>> ownedOutputs;
+    const denigma::MultiOutputCallback owningCallback = [&](std::string_view suggestedName, std::string&& data) {
+        ownedOutputs.emplace_back(std::string(suggestedName), std::move(data));
+    };
+    EXPECT_TRUE(owningCallback.ownsOutput());
+    const auto ownedResult = converter->convert(input, owningCallback, denigma::ConversionRequest{ &options });
+    EXPECT_TRUE(ownedResult.diagnostics().empty());
+
+    ASSERT_GE(viewedOutputs.size(), 2);
+    EXPECT_EQ(ownedOutputs, viewedOutputs);
+    EXPECT_EQ(ownedResult.stats().outputs, viewedResult.stats().outputs);
+    EXPECT_EQ(ownedResult.stats().bytesWritten, viewedResult.stats().bytesWritten);
+}
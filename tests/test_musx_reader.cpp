@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "gtest/gtest.h"
+
+#include "core/enigma_binary_codec.h"
+#include "core/musx_reader.h"
+
+namespace {
+
+bool keepsStyleFamilies(std::string_view name)
+{
+    return name == "header" || name == "options" || name == "others" || name == "texts";
+}
+
+denigma::Buffer toBuffer(std::string_view text)
+{
+    return denigma::Buffer(text.begin(), text.end());
+}
+
+std::string rawXml(const pugi::xml_document& document)
+{
+    std::ostringstream text;
+    document.save(text, "", pugi::format_raw | pugi::format_no_declaration);
+    return text.str();
+}
+
+} // namespace
+
+TEST(MusxReader, RemovesExcludedRootChildrenWithoutParsing)
+{
+    auto xml = toBuffer("<?xml version=\"1.0\"?>\n<finale xmlns=\"x\">\n <header><a/></header>\n <details><gfhold>x</gfhold></details>\n"
+                        " <others attr=\"a>b\"><x/></others>\n <entries/>\n <entries><entry id=\"1\"/></entries >\n</finale>\n");
+    ASSERT_TRUE(denigma::detail::removeRootChildElements(xml, &keepsStyleFamilies));
+    EXPECT_EQ(std::string(xml.begin(), xml.end()),
+              "<?xml version=\"1.0\"?>\n<finale xmlns=\"x\">\n <header><a/></header>\n \n <others attr=\"a>b\"><x/></others>\n \n \n</finale>\n");
+}
+
+TEST(MusxReader, LeavesUnexpectedRootContentUnchanged)
+{
+    const std::string text = "<finale><details/>stray text<entries/></finale>";
+    auto xml = toBuffer(text);
+    EXPECT_FALSE(denigma::detail::removeRootChildElements(xml, &keepsStyleFamilies));
+    EXPECT_EQ(std::string(xml.begin(), xml.end()), text);
+}
+
+TEST(EnigmaBinary, DecodesToTheParsedDocument)
+{
+    const std::string text = "<?xml version=\"1.0\"?>\n<finale xmlns=\"x\">\n <header><a k=\"1 &amp; 2\"/></header>\n"
+                             " <entries><entry id=\"1\"><note id=\"1\"/></entry><entry id=\"2\"/></entries>\n"
+                             " <texts><text>a &lt; b</text><text><![CDATA[^font(Times)]]></text></texts>\n</finale>\n";
+    const auto binary = denigma::enigma_binary::encode(text);
+    ASSERT_TRUE(denigma::enigma_binary::isEnigmaBinary(binary));
+    const auto header = denigma::enigma_binary::readHeader(binary);
+    ASSERT_TRUE(header.has_value());
+    EXPECT_EQ(header->entries, 2u);
+    EXPECT_EQ(header->notes, 1u);
+
+    pugi::xml_document parsed;
+    ASSERT_TRUE(parsed.load_buffer(text.data(), text.size(), pugi::parse_cdata | pugi::parse_escapes | pugi::parse_eol));
+    pugi::xml_document decoded;
+    denigma::enigma_binary::decode(binary, decoded);
+    EXPECT_EQ(rawXml(decoded), rawXml(parsed));
+
+    pugi::xml_document filtered;
+    denigma::enigma_binary::decode(binary, filtered, &keepsStyleFamilies);
+    parsed.document_element().remove_child("entries");
+    EXPECT_EQ(rawXml(filtered), rawXml(parsed));
+
+    auto truncated = binary;
+    truncated.resize(truncated.size() - 3);
+    EXPECT_THROW(denigma::enigma_binary::decode(truncated, decoded), std::runtime_error);
+}
@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 
+#include "classify/classification_cache.h"
 #include "core/musx_reader.h"
 #include "denigma/classify/noteheads.h"
 #include "musx/musx.h"
@@ -232,3 +233,19 @@ TEST(NoteheadClassification, ClassifyNoteheadReturnsUnclassifiedForInvalidNote)
 {
     EXPECT_FALSE(classifyNotehead(NoteInfoPtr()));
 }
+
+TEST(NoteheadClassification, ClassifiesEachFontSymbolOncePerDocument)
+{
+    const auto fontContext = makeFontContext("Finale Maestro");
+    const auto cache = denigma::classify::detail::ClassificationCache::forDocument(fontContext.document);
+    ASSERT_TRUE(cache);
+
+    const auto first = classifyNoteheadSymbol(fontContext.fontInfo, 0xE0A4); // noteheadBlack
+    const auto afterFirst = cache->lookupCounts();
+    const auto second = classifyNoteheadSymbol(fontContext.fontInfo, 0xE0A4);
+    EXPECT_EQ(cache->lookupCounts().misses, afterFirst.misses);
+    EXPECT_EQ(second.shape, first.shape);
+    EXPECT_EQ(second.fill, first.fill);
+    EXPECT_EQ(second.glyphName, first.glyphName);
+    EXPECT_EQ(second.noteheadInfo.font, fontContext.fontInfo);
+}
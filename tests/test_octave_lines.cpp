@@ -25,6 +25,7 @@
 
 #include "gtest/gtest.h"
 
+#include "classify/classification_cache.h"
 #include "core/musx_reader.h"
 #include "denigma/classify/octaves.h"
 #include "denigma/classify/smartshapes.h"
@@ -312,6 +313,26 @@ TEST(OctaveLineClassification, ConflictingContinuationTextIsNotOttava)
     EXPECT_NE(classification.as<classifiedshape::GeneralLine>(), nullptr);
 }
 
+TEST(OctaveLineClassification, CustomLineIsClassifiedOncePerDocument)
+{
+    const auto scenario = makeOttavaScenario("^fontid(0)^size(12)^nfx(0)8va", "^fontid(0)^size(12)^nfx(0)8va");
+    const auto cache = denigma::classify::detail::ClassificationCache::forDocument(scenario.document);
+    ASSERT_TRUE(cache);
+
+    const auto first = classifySmartShape(scenario.visualShape);
+    const auto afterFirst = cache->lookupCounts();
+    const auto second = classifySmartShape(scenario.visualShape);
+    const auto afterSecond = cache->lookupCounts();
+    EXPECT_EQ(afterSecond.misses, afterFirst.misses);
+    EXPECT_GT(afterSecond.hits, afterFirst.hits);
+
+    const auto* firstOttava = first.as<classifiedshape::Ottava>();
+    const auto* secondOttava = second.as<classifiedshape::Ottava>();
+    ASSERT_NE(firstOttava, nullptr);
+    ASSERT_NE(secondOttava, nullptr);
+    EXPECT_EQ(secondOttava->octaveShift, firstOttava->octaveShift);
+}
+
 TEST(OctaveLineClassification, VisibleBuiltInOttavaIsUnchanged)
 {
     std::string xml = R"xml(<?xml version="1.0" encoding="UTF-8"?>
@@ -238,6 +238,106 @@ TEST(Options, ParseOptions)
         ASSERT_TRUE(ctx.cueLayer.has_value());
         EXPECT_EQ(ctx.cueLayer.value(), 4);
     }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--jobs", "3", "--mnx" };
+        DenigmaContext ctx(DENIGMA_NAME);
+        auto newArgs = ctx.parseOptions(args.argc(), args.argv());
+        EXPECT_EQ(newArgs.size(), 3);
+        EXPECT_EQ(pathString(std::filesystem::path(newArgs[2])), "--mnx");
+        EXPECT_EQ(ctx.jobs, 3u);
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--jobs" };
+        DenigmaContext ctx(DENIGMA_NAME);
+        auto newArgs = ctx.parseOptions(args.argc(), args.argv());
+        EXPECT_EQ(newArgs.size(), 2);
+        EXPECT_EQ(ctx.jobs, 0u) << "omitted count means all cores";
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--jobs", "4", "--memory-budget", "2G", "--mnx" };
+        DenigmaContext ctx(DENIGMA_NAME);
+        auto newArgs = ctx.parseOptions(args.argc(), args.argv());
+        EXPECT_EQ(newArgs.size(), 3);
+        EXPECT_EQ(ctx.memoryBudget, std::uint64_t(2) << 30);
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--isolate", "--mnx" };
+        DenigmaContext ctx(DENIGMA_NAME);
+        auto newArgs = ctx.parseOptions(args.argc(), args.argv());
+        EXPECT_EQ(newArgs.size(), 3);
+        ASSERT_TRUE(ctx.isolateTimeoutSeconds.has_value());
+        EXPECT_EQ(ctx.isolateTimeoutSeconds.value(), 600u) << "omitted timeout means the default";
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--pipeline", "--jobs", "2", "--mnx" };
+        DenigmaContext ctx(DENIGMA_NAME);
+        auto newArgs = ctx.parseOptions(args.argc(), args.argv());
+        EXPECT_EQ(newArgs.size(), 3);
+        ASSERT_TRUE(ctx.pipelineReadJobs.has_value());
+        EXPECT_EQ(ctx.pipelineReadJobs.value(), 2u) << "omitted count means the default";
+        EXPECT_EQ(ctx.jobs, 2u);
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--prefetch", "--mnx" };
+        DenigmaContext ctx(DENIGMA_NAME);
+        auto newArgs = ctx.parseOptions(args.argc(), args.argv());
+        EXPECT_EQ(newArgs.size(), 3);
+        ASSERT_TRUE(ctx.prefetchDepth.has_value());
+        EXPECT_EQ(ctx.prefetchDepth.value(), 1u) << "omitted depth means the default";
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--prefetch", "2", "--jobs", "4", "--mnx" };
+        checkStderr("--prefetch applies to serial runs", [&]() {
+            EXPECT_NE(denigmaTestMain(args.argc(), args.argv()), 0) << "prefetch keeps conversion serial";
+        });
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--pipeline", "0" };
+        checkStderr("Invalid value for --pipeline: 0", [&]() {
+            EXPECT_NE(denigmaTestMain(args.argc(), args.argv()), 0) << "the read stage needs a thread";
+        });
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--file-timeout", "30", "--mnx" };
+        DenigmaContext ctx(DENIGMA_NAME);
+        auto newArgs = ctx.parseOptions(args.argc(), args.argv());
+        EXPECT_EQ(newArgs.size(), 3);
+        EXPECT_EQ(ctx.fileTimeoutSeconds, 30u);
+        EXPECT_FALSE(ctx.isolateTimeoutSeconds.has_value());
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--file-timeout", "--mnx" };
+        checkStderr("Missing value for --file-timeout", [&]() {
+            EXPECT_NE(denigmaTestMain(args.argc(), args.argv()), 0) << "file timeout needs a value";
+        });
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--output-jobs", "2", "--musicxml" };
+        DenigmaContext ctx(DENIGMA_NAME);
+        auto newArgs = ctx.parseOptions(args.argc(), args.argv());
+        EXPECT_EQ(newArgs.size(), 3);
+        EXPECT_EQ(ctx.outputJobs, 2u);
+        EXPECT_EQ(ctx.jobs, 1u);
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--text-metrics", "heuristic", "--svg" };
+        DenigmaContext ctx(DENIGMA_NAME);
+        auto newArgs = ctx.parseOptions(args.argc(), args.argv());
+        EXPECT_EQ(newArgs.size(), 3);
+        EXPECT_EQ(ctx.textMetrics, TextMetricsMode::Heuristic);
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--text-metrics", "guess" };
+        checkStderr("Invalid value for --text-metrics: guess", [&]() {
+            EXPECT_NE(denigmaTestMain(args.argc(), args.argv()), 0) << "unknown text metrics mode should fail";
+        });
+    }
+    {
+        ArgList args = { DENIGMA_NAME, "--testing", "export", "input.musx", "--jobs", "-2" };
+        checkStderr("Invalid value for --jobs: -2", [&]() {
+            EXPECT_NE(denigmaTestMain(args.argc(), args.argv()), 0) << "negative job count should fail";
+        });
+    }
     {
         static const std::string fileName = "notAscii-其れ";
         ArgList args = { DENIGMA_NAME, "--testing", "export", fileName + ".musx", "--svg", "--shape-def", "3,5", "--shape-def", "5,7",
@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "denigma/batch_converter.h"
+#include "denigma/formats/enigmaxml.h"
+#include "denigma/formats/mnx.h"
+#include "denigma/formats/mss.h"
+#include "denigma/formats/musicxml.h"
+#include "denigma/formats/svg.h"
+#include "denigma/io/random_access_reader.h"
+#include "denigma/prepared_document.h"
+#include "core/musx_reader.h"
+#include "formats/enigmaxml/prepared_document.h"
+#include "test_utils.h"
+
+TEST(ConverterApi, PreparedDocumentConvertsToEveryTarget)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mnx::registerConverters(registry);
+    denigma::formats::mss::registerConverters(registry);
+    denigma::formats::musicxml::registerConverters(registry);
+    denigma::formats::svg::registerConverters(registry);
+
+    denigma::CommonOptions commonOptions;
+    commonOptions.sourceName = "notAscii-其れ.musx";
+    const denigma::FileRandomAccessReader reader(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    const auto prepared = denigma::PreparedDocument::fromMusx(reader, commonOptions);
+    EXPECT_TRUE(prepared.preparationResult().diagnostics().empty());
+
+    for (const auto target : { denigma::FormatId::MnxJson, denigma::FormatId::MssXml, denigma::FormatId::MusicXml }) {
+        const auto* converter = registry.findPrepared(target);
+        ASSERT_NE(converter, nullptr);
+        std::size_t outputCount = 0;
+        std::size_t outputBytes = 0;
+        const auto result = converter->convert(prepared, [&](std::string_view, std::span<const std::byte> data) {
+            ++outputCount;
+            outputBytes += data.size();
+        });
+        EXPECT_FALSE(result.hasError());
+        EXPECT_EQ(outputCount, 1u);
+        EXPECT_GT(outputBytes, 0u);
+    }
+
+    const auto* svgConverter = registry.findPrepared(denigma::FormatId::Svg);
+    ASSERT_NE(svgConverter, nullptr);
+    const auto svgResult = svgConverter->convert(prepared, [](std::string_view, std::span<const std::byte>) {});
+    EXPECT_FALSE(svgResult.hasError());
+}
+
+TEST(ConverterApi, PreparedDocumentSharesOneDomWithoutPartVoicing)
+{
+    setupTestDataPaths();
+
+    const denigma::DenigmaContext context(DENIGMA_NAME);
+    auto documentsFor = [&](const std::string& fileName) {
+        const denigma::FileRandomAccessReader reader(getInputPath() / utils::utf8ToPath(fileName));
+        const auto prepared = denigma::PreparedDocument::fromMusx(reader, denigma::CommonOptions{});
+        const auto ignoring = prepared.impl().document(musx::dom::PartVoicingPolicy::Ignore, context);
+        const auto applying = prepared.impl().document(musx::dom::PartVoicingPolicy::Apply, context);
+        EXPECT_TRUE(ignoring);
+        EXPECT_TRUE(applying);
+        return std::make_pair(ignoring, applying);
+    };
+
+    const auto [ignoring, applying] = documentsFor("notAscii-其れ.musx");
+    EXPECT_EQ(ignoring, applying);
+    const auto [voicedIgnoring, voicedApplying] = documentsFor("voiced_parts.musx");
+    EXPECT_NE(voicedIgnoring, voicedApplying);
+}
+
+TEST(ConverterApi, PreparedDocumentLoadsProfilesUntilTheFullDocumentExists)
+{
+    setupTestDataPaths();
+
+    const denigma::DenigmaContext context(DENIGMA_NAME);
+    const denigma::FileRandomAccessReader reader(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    const auto prepared = denigma::PreparedDocument::fromMusx(reader, denigma::CommonOptions{});
+
+    // styles and shapes alone never build the entries
+    const auto styles = prepared.impl().document(denigma::MusxLoadProfile::Styles, context);
+    ASSERT_TRUE(styles);
+    EXPECT_EQ(prepared.impl().document(denigma::MusxLoadProfile::Styles, context), styles) << "built once";
+    EXPECT_TRUE(styles->getOptions()->get<musx::dom::options::PageFormatOptions>());
+
+    const auto full = prepared.impl().document(musx::dom::PartVoicingPolicy::Ignore, context);
+    ASSERT_TRUE(full);
+    EXPECT_NE(full, styles);
+    EXPECT_EQ(prepared.impl().document(denigma::MusxLoadProfile::Shapes, context), full) << "the full document serves every profile";
+    EXPECT_EQ(prepared.impl().document(denigma::MusxLoadProfile::Full, context), full);
+}
+
+TEST(ConverterApi, PreparedDocumentMatchesDirectConversion)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mss::registerConverters(registry);
+
+    std::vector<char> input;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), input);
+    const auto inputBytes = std::as_bytes(std::span<const char>(input.data(), input.size()));
+
+    denigma::formats::mss::Options options;
+    options.common.sourceName = "notAscii-其れ.enigmaxml";
+
+    std::string directText;
+    const auto* directConverter = registry.findMultiOutput(denigma::FormatId::EnigmaXml, denigma::FormatId::MssXml);
+    ASSERT_NE(directConverter, nullptr);
+    const auto directResult = directConverter->convert(inputBytes, [&](std::string_view, std::span<const std::byte> data) {
+        directText.assign(reinterpret_cast<const char*>(data.data()), data.size());
+    }, denigma::ConversionRequest{ &options });
+    EXPECT_FALSE(directResult.hasError());
+
+    const auto prepared = denigma::PreparedDocument::fromEnigmaXml(inputBytes, options.common);
+    const auto* preparedConverter = registry.findPrepared(denigma::FormatId::MssXml);
+    ASSERT_NE(preparedConverter, nullptr);
+    for (int pass = 0; pass < 2; pass++) {
+        std::string preparedText;
+        const auto preparedResult = preparedConverter->convert(prepared, [&](std::string_view, std::span<const std::byte> data) {
+            preparedText.assign(reinterpret_cast<const char*>(data.data()), data.size());
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_FALSE(preparedResult.hasError());
+        EXPECT_EQ(preparedText, directText) << "pass " << pass;
+    }
+}
+
+TEST(ConverterApi, EnigmaBinaryConvertsLikeEnigmaXml)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::enigmaxml::registerConverters(registry);
+    denigma::formats::mss::registerConverters(registry);
+    denigma::formats::musicxml::registerConverters(registry);
+
+    const auto* extractor = registry.findReader(denigma::FormatId::Musx, denigma::FormatId::EnigmaBinary);
+    ASSERT_NE(extractor, nullptr);
+    const denigma::FileRandomAccessReader reader(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    std::ostringstream binaryOutput;
+    const auto extractResult = extractor->convert(reader, binaryOutput);
+    EXPECT_FALSE(extractResult.hasError());
+    const std::string binary = binaryOutput.str();
+
+    std::vector<char> xml;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), xml);
+    EXPECT_LT(binary.size(), xml.size());
+
+    auto convert = [&](denigma::FormatId target, const denigma::IOptions& options, std::span<const char> input) {
+        std::string text;
+        const auto* converter = registry.findMultiOutput(denigma::FormatId::EnigmaXml, target);
+        EXPECT_NE(converter, nullptr);
+        const auto result = converter->convert(std::as_bytes(input), [&](std::string_view, std::span<const std::byte> data) {
+            text.assign(reinterpret_cast<const char*>(data.data()), data.size());
+        }, denigma::ConversionRequest{ &options });
+        EXPECT_FALSE(result.hasError());
+        return text;
+    };
+    const std::span<const char> xmlInput(xml.data(), xml.size());
+    const std::span<const char> binaryInput(binary.data(), binary.size());
+
+    denigma::formats::mss::Options mssOptions; // reads through the styles profile, which skips families in the cache
+    mssOptions.common.sourceName = "notAscii-其れ.enigmaxml";
+    EXPECT_EQ(convert(denigma::FormatId::MssXml, mssOptions, binaryInput), convert(denigma::FormatId::MssXml, mssOptions, xmlInput));
+
+    denigma::formats::musicxml::Options musicXmlOptions;
+    musicXmlOptions.common.sourceName = "notAscii-其れ.enigmaxml";
+    EXPECT_EQ(convert(denigma::FormatId::MusicXml, musicXmlOptions, binaryInput),
+              convert(denigma::FormatId::MusicXml, musicXmlOptions, xmlInput));
+}
+
+TEST(ConverterApi, ConversionStatsCoverEachPhase)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mnx::registerConverters(registry);
+
+    using Phase = denigma::ConversionStats::Phase;
+    const denigma::FileRandomAccessReader reader(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    const auto prepared = denigma::PreparedDocument::fromMusx(reader);
+    const auto& preparation = prepared.preparationResult().stats();
+    EXPECT_GT(preparation.phaseTime(Phase::Unzip).count(), 0);
+    EXPECT_GT(preparation.phaseTime(Phase::Inflate).count(), 0);
+    EXPECT_EQ(preparation.phaseTime(Phase::BuildDom).count(), 0);
+
+    denigma::formats::mnx::Options options;
+    options.common.statsReport = denigma::StatsReport::Json;
+    std::vector<std::string> messages;
+    options.common.logCallback = [&](denigma::MessageSeverity, std::string_view message) {
+        messages.emplace_back(message);
+    };
+    const auto* converter = registry.findPrepared(denigma::FormatId::MnxJson);
+    ASSERT_NE(converter, nullptr);
+    std::size_t outputBytes = 0;
+    const auto result = converter->convert(prepared, [&](std::string_view, std::span<const std::byte> data) {
+        outputBytes += data.size();
+    }, denigma::ConversionRequest{ &options });
+    ASSERT_FALSE(result.hasError());
+
+    const auto& stats = result.stats();
+    EXPECT_EQ(stats.phaseTime(Phase::Unzip).count(), 0);
+    EXPECT_GT(stats.phaseTime(Phase::BuildDom).count(), 0);
+    EXPECT_GT(stats.phaseTime(Phase::Convert).count(), 0);
+    EXPECT_GT(stats.phaseTime(Phase::Serialize).count(), 0);
+    EXPECT_GT(stats.measures, 0u);
+    EXPECT_GT(stats.entries, 0u);
+    EXPECT_GT(stats.notes, 0u);
+    EXPECT_EQ(stats.outputs, 1u);
+    EXPECT_EQ(stats.bytesWritten, outputBytes);
+    EXPECT_GT(stats.cacheHits + stats.cacheMisses, 0u);
+    if (stats.memoryCounted) { // built with DENIGMA_ALLOCATION_STATS
+        EXPECT_GT(stats.phaseMemory[static_cast<std::size_t>(Phase::BuildDom)].allocatedBytes, 0u);
+        EXPECT_GT(stats.phaseMemory[static_cast<std::size_t>(Phase::BuildDom)].peakBytes, 0u);
+        EXPECT_GT(stats.phaseMemory[static_cast<std::size_t>(Phase::Serialize)].allocatedBytes, 0u);
+    }
+    EXPECT_NE(std::find(messages.begin(), messages.end(), stats.toJson()), messages.end());
+}
+
+TEST(ConverterApi, BatchConverterReportsEachJob)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::mnx::registerConverters(registry);
+    denigma::formats::mss::registerConverters(registry);
+
+    class CountingSink final : public denigma::IMultiOutputSink
+    {
+    public:
+        bool begin(std::string_view) override { ++documents; return true; }
+        void write(std::span<const std::byte> data) override { bytes += data.size(); }
+        void end() override {}
+
+        std::size_t documents{};
+        std::size_t bytes{};
+    };
+
+    constexpr std::size_t JOB_COUNT = 3;
+    const denigma::FileRandomAccessReader reader(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    denigma::formats::mnx::Options mnxOptions;
+    denigma::formats::mss::Options mssOptions;
+    std::vector<CountingSink> sinks(JOB_COUNT * 3);
+    std::vector<denigma::BatchJob> jobs(JOB_COUNT);
+    for (std::size_t index = 0; index < JOB_COUNT; index++) {
+        jobs[index].input = &reader;
+        jobs[index].estimatedBytes = index + 1;
+        jobs[index].targets = {
+            { denigma::FormatId::MnxJson, &mnxOptions, &sinks[index * 3] },
+            { denigma::FormatId::MssXml, &mssOptions, &sinks[index * 3 + 1] },
+            { denigma::FormatId::EnigmaXml, nullptr, &sinks[index * 3 + 2] }, // nothing converts musx to EnigmaXML
+        };
+    }
+
+    denigma::BatchOptions batchOptions;
+    batchOptions.jobs = 2;
+    batchOptions.memoryBudget = 2;
+    std::vector<std::size_t> finished;
+    denigma::BatchConverter(registry, batchOptions).convertMany(jobs, [&](std::size_t jobIndex, std::vector<denigma::ConversionResult> results) {
+        finished.push_back(jobIndex);
+        ASSERT_EQ(results.size(), 3u);
+        EXPECT_FALSE(results[0].hasError());
+        EXPECT_FALSE(results[1].hasError());
+        EXPECT_TRUE(results[2].hasError());
+    });
+
+    ASSERT_EQ(finished.size(), JOB_COUNT);
+    std::sort(finished.begin(), finished.end());
+    for (std::size_t index = 0; index < JOB_COUNT; index++) {
+        EXPECT_EQ(finished[index], index);
+        EXPECT_EQ(sinks[index * 3].documents, 1u);
+        EXPECT_GT(sinks[index * 3].bytes, 0u);
+        EXPECT_EQ(sinks[index * 3 + 1].documents, 1u);
+        EXPECT_EQ(sinks[index * 3 + 2].documents, 0u);
+    }
+}
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "denigma/formats/mss.h"
+#include "denigma/process_caches.h"
+#include "serve/metrics.h"
+#include "serve/result_cache.h"
+#include "serve/scheduler.h"
+#include "serve/serve.h"
+#include "test_utils.h"
+
+namespace {
+
+struct ResponseFrame
+{
+    char type{};
+    std::string target;
+    std::string name;
+    std::string data;
+};
+
+std::string makeFrame(const std::string& payload)
+{
+    const auto size = static_cast<std::uint32_t>(payload.size());
+    std::string frame;
+    frame.push_back(static_cast<char>(size >> 24));
+    frame.push_back(static_cast<char>(size >> 16));
+    frame.push_back(static_cast<char>(size >> 8));
+    frame.push_back(static_cast<char>(size));
+    return frame + payload;
+}
+
+std::uint32_t readLength(const std::string& buffer, size_t& pos)
+{
+    std::uint32_t value = 0;
+    for (int x = 0; x < 4; x++) {
+        value = (value << 8) | static_cast<unsigned char>(buffer[pos++]);
+    }
+    return value;
+}
+
+std::vector<ResponseFrame> parseResponse(const std::string& response)
+{
+    std::vector<ResponseFrame> frames;
+    size_t pos = 0;
+    while (pos < response.size()) {
+        const auto size = readLength(response, pos);
+        const std::string payload = response.substr(pos, size);
+        pos += size;
+        ResponseFrame frame;
+        frame.type = payload[0];
+        size_t payloadPos = 1;
+        if (frame.type == 'O') {
+            const auto targetSize = readLength(payload, payloadPos);
+            frame.target = payload.substr(payloadPos, targetSize);
+            payloadPos += targetSize;
+            const auto nameSize = readLength(payload, payloadPos);
+            frame.name = payload.substr(payloadPos, nameSize);
+            payloadPos += nameSize;
+        }
+        frame.data = payload.substr(payloadPos);
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+} // namespace
+
+TEST(Serve, ConvertsRequestsLikeTheConverterApi)
+{
+    setupTestDataPaths();
+
+    std::vector<char> input;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), input);
+    const std::string inputText(input.begin(), input.end());
+
+    denigma::formats::mss::Options options;
+    options.common.sourceName = "notAscii-其れ.enigmaxml";
+    std::string directText;
+    const auto directResult = denigma::formats::mss::EnigmaXmlToMssXmlMultiOutputConverter().convert(
+        std::as_bytes(std::span<const char>(input.data(), input.size())),
+        [&](std::string_view, std::span<const std::byte> data) {
+            directText.assign(reinterpret_cast<const char*>(data.data()), data.size());
+        }, options);
+    ASSERT_FALSE(directResult.hasError());
+
+    // a bad request is answered with an error and does not end the loop
+    std::istringstream requests(makeFrame("target=mss\nname=notAscii-其れ.enigmaxml\n\n" + inputText)
+                                + makeFrame("target=pdf\nname=notAscii-其れ.enigmaxml\n\n")
+                                + makeFrame("target=mss\nsource=enigmaxml\n\n" + inputText));
+    std::ostringstream responses;
+    denigma::DenigmaContext denigmaContext(DENIGMA_NAME);
+    checkStderr("Unsupported target format: pdf", [&]() {
+        EXPECT_EQ(denigma::serveConversions(requests, responses, denigmaContext), 0);
+    });
+
+    const auto frames = parseResponse(responses.str());
+    ASSERT_EQ(frames.size(), 6u);
+    EXPECT_EQ(frames[0].type, 'O');
+    EXPECT_EQ(frames[0].target, "mss");
+    EXPECT_EQ(frames[0].data, directText);
+    EXPECT_EQ(frames[1].type, 'R');
+    EXPECT_EQ(frames[1].data, std::string(1, '\0'));
+    EXPECT_EQ(frames[2].type, 'D');
+    EXPECT_EQ(frames[2].data, "EUnsupported target format: pdf");
+    EXPECT_EQ(frames[3].type, 'R');
+    EXPECT_EQ(frames[3].data, std::string(1, '\1'));
+    EXPECT_EQ(frames[4].type, 'O');
+    EXPECT_EQ(frames[5].type, 'R');
+    EXPECT_EQ(frames[5].data, std::string(1, '\0'));
+}
+
+TEST(Serve, TruncatedRequestEndsTheLoop)
+{
+    std::istringstream requests(std::string("\0\0\0\x10", 4) + "target=mss");
+    std::ostringstream responses;
+    denigma::DenigmaContext denigmaContext(DENIGMA_NAME);
+    checkStderr("Request stream ended inside a frame.", [&]() {
+        EXPECT_EQ(denigma::serveConversions(requests, responses, denigmaContext), 1);
+    });
+    EXPECT_TRUE(responses.str().empty());
+}
+
+TEST(Serve, IdenticalRequestIsAnsweredFromTheResultCache)
+{
+    setupTestDataPaths();
+
+    std::vector<char> input;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), input);
+    const std::string request = makeFrame("target=mss\nname=notAscii-其れ.enigmaxml\n\n" + std::string(input.begin(), input.end()));
+
+    std::istringstream requests(request + request + makeFrame("target=mss\nname=other.enigmaxml\n\n" + std::string(input.begin(), input.end())));
+    std::ostringstream responses;
+    denigma::DenigmaContext denigmaContext(DENIGMA_NAME);
+    denigma::ServeResultCache resultCache(std::size_t(64) << 20);
+    EXPECT_EQ(denigma::serveConversions(requests, responses, denigmaContext, &resultCache), 0);
+
+    const auto frames = parseResponse(responses.str());
+    ASSERT_EQ(frames.size(), 6u);
+    EXPECT_EQ(frames[0].type, 'O');
+    EXPECT_EQ(frames[2].type, 'O');
+    EXPECT_EQ(frames[2].data, frames[0].data);
+    EXPECT_EQ(frames[3].type, 'R');
+    EXPECT_EQ(frames[3].data, std::string(1, '\0'));
+
+    const auto stats = resultCache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u); // a different name is a different request
+    EXPECT_EQ(stats.entries, 2u);
+}
+
+TEST(Serve, MetricsRequestReportsConversionsAndCacheUse)
+{
+    setupTestDataPaths();
+
+    std::vector<char> input;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), input);
+    const std::string request = makeFrame("target=mss\nname=notAscii-其れ.enigmaxml\n\n" + std::string(input.begin(), input.end()));
+
+    std::istringstream requests(request + request + makeFrame("target=metrics\n\n"));
+    std::ostringstream responses;
+    denigma::DenigmaContext denigmaContext(DENIGMA_NAME);
+    denigma::ServeResultCache resultCache(std::size_t(64) << 20);
+    denigma::ServeMetrics metrics(&resultCache);
+    EXPECT_EQ(denigma::serveConversions(requests, responses, denigmaContext, &resultCache, &metrics), 0);
+
+    const auto frames = parseResponse(responses.str());
+    ASSERT_EQ(frames.size(), 6u);
+    EXPECT_EQ(frames[4].type, 'O');
+    EXPECT_EQ(frames[4].target, "metrics");
+    const auto& text = frames[4].data;
+    EXPECT_NE(text.find("denigma_serve_requests_total{outcome=\"converted\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("denigma_serve_requests_total{outcome=\"cached\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("denigma_serve_active_requests 1\n"), std::string::npos); // the metrics request itself
+    EXPECT_NE(text.find("denigma_conversions_total{target=\"mss\",outcome=\"ok\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("denigma_serve_request_duration_seconds_count 2\n"), std::string::npos);
+    EXPECT_NE(text.find("denigma_conversion_phase_seconds_bucket{phase=\"buildDom\",le=\"+Inf\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("denigma_serve_result_cache_lookups_total{result=\"hit\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("denigma_serve_input_bytes_total " + std::to_string(2 * (request.size() - 4) + std::string("target=metrics\n\n").size()) + "\n"), std::string::npos);
+}
+
+TEST(Serve, ResultCacheCoalescesRequestsInFlight)
+{
+    denigma::ServeResultCache resultCache(0); // keeps nothing, but still shares a conversion in flight
+    int conversions = 0;
+    auto convert = [&]() {
+        ++conversions;
+        // hold the conversion until the second request is waiting for it
+        while (resultCache.stats().coalesced == 0) {
+            std::this_thread::yield();
+        }
+        return denigma::ServeResultCache::Response{ "frames", false };
+    };
+
+    bool firstProduced = false;
+    std::thread first([&]() { resultCache.get("key", convert, firstProduced); });
+    while (resultCache.stats().misses == 0) {
+        std::this_thread::yield();
+    }
+    bool secondProduced = true;
+    const auto response = resultCache.get("key", convert, secondProduced);
+    first.join();
+
+    EXPECT_TRUE(firstProduced);
+    EXPECT_FALSE(secondProduced);
+    EXPECT_EQ(response->frames, "frames");
+    EXPECT_EQ(conversions, 1);
+    EXPECT_EQ(resultCache.stats().entries, 0u);
+
+    bool produced = false;
+    resultCache.get("key", convert, produced);
+    EXPECT_TRUE(produced); // nothing was kept, so the next request converts again
+}
+
+TEST(Serve, ProcessCacheBudgetEvictsLeastRecentlyUsedAcrossCaches)
+{
+    denigma::ServeResultCache first(1024);
+    denigma::ServeResultCache second(1024);
+    auto respond = [](std::size_t size) {
+        return [size]() { return denigma::ServeResultCache::Response{ std::string(size, 'x'), false }; };
+    };
+    bool produced = false;
+    first.get("a", respond(99), produced);  // 100 bytes with its key
+    second.get("b", respond(99), produced);
+    first.get("c", respond(99), produced);
+    first.get("a", respond(99), produced);  // "b", in the other cache, is now least recently used
+    EXPECT_FALSE(produced);
+
+    denigma::setProcessCacheBudget(250);
+    EXPECT_EQ(first.stats().entries, 2u);
+    EXPECT_EQ(second.stats().entries, 0u);
+    denigma::setProcessCacheBudget(150);
+    EXPECT_EQ(first.stats().entries, 1u);
+    first.get("a", respond(99), produced);
+    EXPECT_FALSE(produced);
+    denigma::setProcessCacheBudget(0);
+
+    std::size_t evictions = 0;
+    for (const auto& usage : denigma::processCacheUsage()) {
+        if (usage.name == "serve-results") {
+            evictions += usage.evictions;
+        }
+    }
+    EXPECT_EQ(evictions, 2u);
+}
+
+TEST(Serve, SchedulerReservesWorkersAndPreemptsBulkForInteractive)
+{
+    denigma::ServeScheduler::Limits limits;
+    limits.workers = 2;
+    limits.reservedInteractive = 1;
+    denigma::ServeScheduler scheduler(limits);
+    EXPECT_EQ(scheduler.classify(std::nullopt, 1000), denigma::ServePriority::Interactive);
+    EXPECT_EQ(scheduler.classify(std::nullopt, limits.interactiveCostLimit + 1), denigma::ServePriority::Bulk);
+
+    std::optional<denigma::ServeScheduler::Ticket> bulk;
+    bulk.emplace(scheduler.admit(denigma::ServePriority::Bulk, 1 << 30, true));
+    std::atomic<bool> secondBulkAdmitted = false;
+    std::thread secondBulk([&]() {
+        auto ticket = scheduler.admit(denigma::ServePriority::Bulk, 1 << 30, true);
+        secondBulkAdmitted = true;
+    });
+    while (scheduler.stats().queuedBulk == 0) {
+        std::this_thread::yield();
+    }
+
+    // the reserved worker is free, so interactive work does not wait for the bulk conversion
+    auto interactive = scheduler.admit(denigma::ServePriority::Interactive, 100, false);
+    EXPECT_FALSE(bulk->preempted());
+
+    // with every worker busy, the next interactive request cancels the bulk conversion and takes its worker
+    bool secondInteractiveAdmitted = false;
+    std::thread secondInteractive([&]() {
+        auto ticket = scheduler.admit(denigma::ServePriority::Interactive, 100, false);
+        secondInteractiveAdmitted = true;
+    });
+    while (!bulk->cancellation().isCancelled()) {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(bulk->preempted());
+    bulk.reset();
+    secondInteractive.join();
+    EXPECT_TRUE(secondInteractiveAdmitted);
+    EXPECT_EQ(scheduler.stats().preemptions, 1u);
+
+    { auto released = std::move(interactive); }
+    secondBulk.join();
+    EXPECT_TRUE(secondBulkAdmitted);
+}
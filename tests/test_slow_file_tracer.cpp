@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <chrono>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+#include "core/trace.h"
+
+using namespace denigma;
+using namespace std::chrono_literals;
+
+TEST(SlowFileTracer, ParsesThresholds)
+{
+    const auto seconds = SlowFileThreshold::parse("2.5");
+    EXPECT_DOUBLE_EQ(seconds.minimum.count(), 2.5);
+    EXPECT_EQ(seconds.medianMultiple, 0);
+
+    const auto multiple = SlowFileThreshold::parse("10x");
+    EXPECT_EQ(multiple.minimum.count(), 0);
+    EXPECT_DOUBLE_EQ(multiple.medianMultiple, 10);
+
+    const auto both = SlowFileThreshold::parse("1,8X");
+    EXPECT_DOUBLE_EQ(both.minimum.count(), 1);
+    EXPECT_DOUBLE_EQ(both.medianMultiple, 8);
+
+    for (const char* invalid : { "", "x", "0", "-1", "2s", "1,", "abc" }) {
+        EXPECT_THROW(SlowFileThreshold::parse(invalid), std::invalid_argument) << invalid;
+    }
+}
+
+TEST(SlowFileTracer, AbsoluteThreshold)
+{
+    SlowFileTracer tracer(SlowFileThreshold::parse("2"), {}, {});
+    EXPECT_FALSE(tracer.observe(1s));
+    EXPECT_FALSE(tracer.observe(2s));
+    EXPECT_TRUE(tracer.observe(3s));
+}
+
+TEST(SlowFileTracer, MedianMultipleWaitsForSamples)
+{
+    SlowFileTracer tracer(SlowFileThreshold::parse("0.5,10x"), {}, {});
+    for (std::size_t x = 0; x < SlowFileTracer::MIN_MEDIAN_SAMPLES; ++x) {
+        EXPECT_FALSE(tracer.observe(10s)) << "no median yet";
+    }
+    EXPECT_FALSE(tracer.observe(50s));
+    EXPECT_TRUE(tracer.observe(101s));
+
+    SlowFileTracer fastRun(SlowFileThreshold::parse("0.5,10x"), {}, {});
+    for (std::size_t x = 0; x < SlowFileTracer::MIN_MEDIAN_SAMPLES; ++x) {
+        fastRun.observe(1ms);
+    }
+    EXPECT_FALSE(fastRun.observe(100ms)) << "over the multiple but under the absolute limit";
+}
+
+TEST(SlowFileTracer, TracePathsAreUnique)
+{
+    SlowFileTracer besideLog(SlowFileThreshold::parse("1"), "logs", "denigma-20260101-000000-");
+    EXPECT_EQ(besideLog.nextTracePath("scores/a.musx"), std::filesystem::path("logs/denigma-20260101-000000-slow1-a.musx.trace.json"));
+    EXPECT_EQ(besideLog.nextTracePath("other/a.musx"), std::filesystem::path("logs/denigma-20260101-000000-slow2-a.musx.trace.json"));
+
+    SlowFileTracer besideInput(SlowFileThreshold::parse("1"), {}, {});
+    EXPECT_EQ(besideInput.nextTracePath("scores/b.musx"), std::filesystem::path("scores/slow1-b.musx.trace.json"));
+}
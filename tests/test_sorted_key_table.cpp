@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "utils/sorted_key_table.h"
+
+TEST(SortedKeyTable, FirstAppendedValueWinsDuplicateKeys)
+{
+    utils::SortedKeyTable<std::uint64_t, std::string> table;
+    table.append(30, "first thirty");
+    table.append(10, "ten");
+    table.append(30, "second thirty");
+    EXPECT_FALSE(table.isSealed());
+    table.seal();
+
+    ASSERT_NE(table.find(30), nullptr);
+    EXPECT_EQ(*table.find(30), "first thirty");
+    ASSERT_NE(table.find(10), nullptr);
+    EXPECT_EQ(*table.find(10), "ten");
+    EXPECT_EQ(table.find(20), nullptr);
+    EXPECT_EQ(table.size(), 2u);
+}
+
+TEST(SortedKeyTable, AppendFromKeepsEarlierEntries)
+{
+    utils::SortedKeyTable<int, int> earlier;
+    earlier.append(2, 20);
+    utils::SortedKeyTable<int, int> later;
+    later.append(2, 99);
+    later.append(1, 10);
+
+    earlier.appendFrom(std::move(later));
+    EXPECT_EQ(later.size(), 0u);
+    earlier.seal();
+    ASSERT_NE(earlier.find(2), nullptr);
+    EXPECT_EQ(*earlier.find(2), 20);
+    ASSERT_NE(earlier.find(1), nullptr);
+    EXPECT_EQ(*earlier.find(1), 10);
+}
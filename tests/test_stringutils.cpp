@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string_view>
+
+#include "gtest/gtest.h"
+
+#include "utils/stringutils.h"
+
+TEST(StringUtils, WildcardMatchStarAndQuestionMark)
+{
+    using View = std::string_view;
+    EXPECT_TRUE(utils::wildcardMatch(View("*.musx"), View("score.musx")));
+    EXPECT_FALSE(utils::wildcardMatch(View("*.musx"), View("score.musxx")));
+    EXPECT_TRUE(utils::wildcardMatch(View("s?ore*"), View("score.mxl")));
+    EXPECT_TRUE(utils::wildcardMatch(View("*a*b"), View("xxaxxbxb")));
+    EXPECT_TRUE(utils::wildcardMatch(View("*"), View("")));
+    EXPECT_FALSE(utils::wildcardMatch(View("?"), View("")));
+}
+
+TEST(StringUtils, WildcardMatchTreatsOtherCharactersLiterally)
+{
+    using View = std::string_view;
+    EXPECT_FALSE(utils::wildcardMatch(View("a.b"), View("axb")));
+    EXPECT_TRUE(utils::wildcardMatch(View("part (1).musx"), View("part (1).musx")));
+    EXPECT_TRUE(utils::wildcardMatch(View("[x]*"), View("[x]score.musx")));
+}
+
+TEST(StringUtils, NumberTextMatchesPrintfStyles)
+{
+    EXPECT_EQ(utils::NumberText::general(0.123456789, 5).view(), "0.12346");
+    EXPECT_EQ(utils::NumberText::general(2.0, 5).view(), "2");
+    EXPECT_EQ(utils::NumberText::shortest(0.1).view(), "0.1");
+    EXPECT_EQ(utils::NumberText::fixedTrimmed(0.75, 6).view(), "0.75");
+    EXPECT_EQ(utils::NumberText::fixedTrimmed(3.0, 6).view(), "3");
+    EXPECT_EQ(std::string_view(utils::NumberText::fixedTrimmed(1.0 / 3.0, 6).c_str()), "0.333333");
+}
@@ -127,3 +127,76 @@ TEST(ConverterApi, MusxToSvgCollectsWarningsInConversionResult)
         EXPECT_TRUE(outputs.empty());
     });
 }
+
+TEST(ConverterApi, MusxToSvgParallelShapesMatchSerialOrder)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::svg::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::Svg);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    struct Run
+    {
+        std::vector<std::pair<std::string, std::string>> outputs;
+        std::vector<std::string> diagnostics;
+    };
+    auto convertWithJobs = [&](unsigned outputJobs) {
+        Run run;
+        denigma::formats::svg::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.outputJobs = outputJobs;
+        const auto result = converter->convert(
+            input,
+            [&](std::string_view suggestedName, std::span<const std::byte> data) {
+                run.outputs.emplace_back(std::string(suggestedName), std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+            },
+            denigma::ConversionRequest{ &options });
+        for (const auto& diagnostic : result.diagnostics()) {
+            run.diagnostics.push_back(diagnostic.message);
+        }
+        return run;
+    };
+
+    const auto serialRun = convertWithJobs(1);
+    const auto parallelRun = convertWithJobs(4);
+    ASSERT_GE(serialRun.outputs.size(), 2u);
+    EXPECT_EQ(parallelRun.outputs, serialRun.outputs);
+    EXPECT_EQ(parallelRun.diagnostics, serialRun.diagnostics);
+}
+
+TEST(ConverterApi, MusxToSvgWithHeuristicTextMetricsWritesEveryShape)
+{
+    setupTestDataPaths();
+
+    denigma::ConverterRegistry registry;
+    denigma::formats::svg::registerConverters(registry);
+    const auto* converter = registry.findReaderMultiOutput(denigma::FormatId::Musx, denigma::FormatId::Svg);
+    ASSERT_NE(converter, nullptr);
+
+    denigma::FileRandomAccessReader input(getInputPath() / utils::utf8ToPath("notAscii-其れ.musx"));
+    auto convertWith = [&](denigma::TextMetricsMode textMetrics) {
+        std::vector<std::pair<std::string, std::string>> outputs;
+        denigma::formats::svg::Options options;
+        options.common.sourceName = "notAscii-其れ.musx";
+        options.common.textMetrics = textMetrics;
+        const auto result = converter->convert(
+            input,
+            [&](std::string_view suggestedName, std::span<const std::byte> data) {
+                outputs.emplace_back(std::string(suggestedName), std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+            },
+            denigma::ConversionRequest{ &options });
+        EXPECT_FALSE(result.hasError());
+        return outputs;
+    };
+
+    const auto fontOutputs = convertWith(denigma::TextMetricsMode::Fonts);
+    const auto heuristicOutputs = convertWith(denigma::TextMetricsMode::Heuristic);
+    ASSERT_EQ(heuristicOutputs.size(), fontOutputs.size());
+    for (size_t index = 0; index < heuristicOutputs.size(); index++) {
+        EXPECT_EQ(heuristicOutputs[index].first, fontOutputs[index].first);
+        EXPECT_NE(heuristicOutputs[index].second.find("<svg"), std::string::npos);
+    }
+}
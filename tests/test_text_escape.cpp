@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string>
+#include <string_view>
+
+#include "gtest/gtest.h"
+
+#include "utils/text_escape.h"
+
+TEST(TextEscape, EscapesXmlMarkup)
+{
+    EXPECT_EQ(utils::xmlEscaped(""), "");
+    EXPECT_EQ(utils::xmlEscaped("plain text"), "plain text");
+    EXPECT_EQ(utils::xmlEscaped("a&b<c>d\"e'f"), "a&amp;b&lt;c&gt;d&quot;e&apos;f");
+    EXPECT_EQ(utils::xmlEscaped("Allegro \xC3\xA0 la \"Bach\""), "Allegro \xC3\xA0 la &quot;Bach&quot;");
+}
+
+TEST(TextEscape, EscapesJsonStringContent)
+{
+    EXPECT_EQ(utils::jsonEscaped("plain"), "plain");
+    EXPECT_EQ(utils::jsonEscaped("q\"b\\n\nr\rt\t"), "q\\\"b\\\\n\\nr\\rt\\t");
+    EXPECT_EQ(utils::jsonEscaped(std::string_view("\x01\x1f\0", 3)), "\\u0001\\u001f\\u0000");
+    EXPECT_EQ(utils::jsonEscaped("\x7f\xC3\xA9"), "\x7f\xC3\xA9");
+}
+
+TEST(TextEscape, FindsEscapesAtEveryBlockOffset)
+{
+    // every position across several 16-byte blocks and the scalar tail, so the bulk path and the tail agree
+    for (std::size_t length = 1; length <= 50; ++length) {
+        for (std::size_t pos = 0; pos < length; ++pos) {
+            std::string text(length, 'x');
+            text[pos] = '<';
+            EXPECT_EQ(utils::detail::findXmlEscape(text, 0), pos);
+            EXPECT_EQ(utils::detail::findXmlEscape(text, pos + 1), length);
+            text[pos] = '\x1f';
+            EXPECT_EQ(utils::detail::findJsonEscape(text, 0), pos);
+            EXPECT_EQ(utils::detail::findXmlEscape(text, 0), length);
+            text[pos] = '\x80';
+            EXPECT_EQ(utils::detail::findJsonEscape(text, 0), length);
+        }
+    }
+
+    std::string longText(100, 'y');
+    longText[40] = '&';
+    longText[99] = '"';
+    std::string expected(100, 'y');
+    expected.replace(99, 1, "&quot;");
+    expected.replace(40, 1, "&amp;");
+    EXPECT_EQ(utils::xmlEscaped(longText), expected);
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.h"
+#include "utils/text_metrics_cache.h"
+
+using namespace denigma::textmetrics;
+
+namespace {
+
+TextMetricsDiskKey keyFor(std::u32string_view text, long long fontModified = 100)
+{
+    TextMetricsDiskKey key;
+    key.fontFile = "/fonts/Times.ttf";
+    key.fontModified = fontModified;
+    key.fontSize = 4096;
+    key.charSize26d6 = 12 * 64;
+    key.text = text;
+    return key;
+}
+
+std::filesystem::path freshCachePath(const std::string& name)
+{
+    setupTestDataPaths();
+    const auto path = getOutputPath() / name;
+    std::filesystem::remove(path);
+    return path;
+}
+
+} // namespace
+
+TEST(TextMetricsDiskCache, ReopenedCacheFindsEarlierMeasurements)
+{
+    const auto path = freshCachePath("reopen.textmetrics");
+    {
+        TextMetricsDiskCache cache(path);
+        EXPECT_FALSE(cache.find(keyFor(U"Allegro")).has_value());
+        cache.insert(keyFor(U"Allegro"), TextMetricsEvpu{ 120.5, 30.0, 8.0 });
+        cache.insert(keyFor(U"Flute"), TextMetricsEvpu{ 80.0, 30.0, 2.0 });
+    }
+    TextMetricsDiskCache reopened(path);
+    EXPECT_EQ(reopened.size(), 2u);
+    const auto allegro = reopened.find(keyFor(U"Allegro"));
+    ASSERT_TRUE(allegro.has_value());
+    EXPECT_DOUBLE_EQ(allegro->advance, 120.5);
+    EXPECT_DOUBLE_EQ(allegro->descent, 8.0);
+
+    auto glyphKey = keyFor(U"Allegro");
+    glyphKey.measurement = DiskCachedMeasurement::GlyphWidth;
+    EXPECT_FALSE(reopened.find(glyphKey).has_value());
+}
+
+TEST(TextMetricsDiskCache, ChangedFontFileMisses)
+{
+    const auto path = freshCachePath("changed.textmetrics");
+    TextMetricsDiskCache cache(path);
+    cache.insert(keyFor(U"Allegro"), TextMetricsEvpu{ 120.5, 30.0, 8.0 });
+    EXPECT_FALSE(cache.find(keyFor(U"Allegro", 101)).has_value());
+}
+
+TEST(TextMetricsDiskCache, TornRecordIsDroppedAndLaterAppendsSurvive)
+{
+    const auto path = freshCachePath("torn.textmetrics");
+    {
+        TextMetricsDiskCache cache(path);
+        cache.insert(keyFor(U"Allegro"), TextMetricsEvpu{ 120.5, 30.0, 8.0 });
+    }
+    {
+        std::ofstream output(path, std::ios::out | std::ios::binary | std::ios::app);
+        output.write("\x40\x00\x00\x00partial", 11);
+    }
+    {
+        TextMetricsDiskCache cache(path);
+        EXPECT_EQ(cache.size(), 1u);
+        cache.insert(keyFor(U"Flute"), TextMetricsEvpu{ 80.0, 30.0, 2.0 });
+    }
+    TextMetricsDiskCache reopened(path);
+    EXPECT_EQ(reopened.size(), 2u);
+    EXPECT_TRUE(reopened.find(keyFor(U"Flute")).has_value());
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "utils/utf8_iterator.h"
+
+TEST(Utf8Iterator, DecodesMixedAsciiAndMultiByteText)
+{
+    const std::string text = "Allegro \xC3\xA9 \xE2\x99\xAF \xF0\x9D\x84\x9E!";
+    std::vector<char32_t> iterated;
+    for (utils::Utf8Iterator iter(text); !iter.atEnd(); iter.next()) {
+        iterated.push_back(iter->codepoint);
+    }
+    const std::vector<char32_t> expected = { U'A', U'l', U'l', U'e', U'g', U'r', U'o', U' ', 0xE9, U' ', 0x266F, U' ', 0x1D11E, U'!' };
+    EXPECT_EQ(iterated, expected);
+
+    std::u32string decoded = U"stale";
+    EXPECT_TRUE(utils::decodeToU32(text, decoded));
+    EXPECT_EQ(decoded, std::u32string(expected.begin(), expected.end()));
+}
+
+TEST(Utf8Iterator, AsciiPrefixLengthStopsAtFirstNonAsciiByte)
+{
+    const std::string longAscii(37, 'x');
+    EXPECT_EQ(utils::asciiPrefixLength(longAscii), 37u);
+    EXPECT_EQ(utils::asciiPrefixLength(""), 0u);
+    for (size_t position : { 0u, 5u, 8u, 15u, 16u, 23u, 36u }) {
+        std::string text = longAscii;
+        text[position] = '\xC3';
+        EXPECT_EQ(utils::asciiPrefixLength(text), position);
+    }
+}
+
+TEST(Utf8Iterator, DecodeStopsAtInvalidSequenceLikeTheIterator)
+{
+    const std::string text = std::string(20, 'a') + "\xE2\x99" + "b";
+    std::u32string decoded;
+    EXPECT_FALSE(utils::decodeToU32(text, decoded));
+    EXPECT_EQ(decoded, std::u32string(20, U'a'));
+
+    utils::Utf8Iterator iter(text);
+    size_t count = 0;
+    for (; !iter.atEnd(); iter.next()) {
+        ++count;
+    }
+    EXPECT_EQ(count, 20u);
+    EXPECT_FALSE(iter.valid());
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.h"
+#include "utils/xml_header_probe.h"
+
+TEST(XmlHeaderProbe, ReadsEnigmaXmlHeaderAndStopsAfterIt)
+{
+    setupTestDataPaths();
+    std::vector<char> input;
+    readFile(getInputPath() / "reference" / utils::utf8ToPath("notAscii-其れ.enigmaxml"), input);
+    const std::string_view xml(input.data(), input.size());
+
+    const utils::XmlHeaderProbe probe(xml, "finale/header");
+    EXPECT_EQ(probe.rootElement(), "finale");
+    EXPECT_EQ(probe.rootAttribute("version"), "27.4");
+    EXPECT_TRUE(probe.reachedStopPath());
+    EXPECT_EQ(probe.intValue("finale/header/headerData/created/fileVersion/major"), 27);
+    EXPECT_EQ(probe.text("finale/header/headerData/wordOrder"), "lo-endian");
+
+    const auto version = utils::probeEnigmaXmlFileVersion(xml);
+    ASSERT_TRUE(version.has_value());
+    EXPECT_EQ(*version, std::make_pair(27, 4));
+}
+
+TEST(XmlHeaderProbe, PrefersModifiedVersionAndSkipsMarkup)
+{
+    const std::string xml =
+        "<?xml version=\"1.0\"?>\n<!-- comment <header> -->\n"
+        "<finale version='26.2'><header><headerData>"
+        "<created><fileVersion><major>26</major><minor>2</minor></fileVersion></created>"
+        "<modified><modifiedBy/><fileVersion><major> 27 </major><minor>1</minor></fileVersion></modified>"
+        "</headerData></header><others/></finale>";
+    EXPECT_EQ(utils::probeEnigmaXmlFileVersion(xml), std::make_pair(27, 1));
+
+    const utils::XmlHeaderProbe probe(xml);
+    EXPECT_EQ(probe.rootAttribute("version"), "26.2");
+    EXPECT_EQ(probe.text("finale/header/headerData/modified/modifiedBy"), "");
+    EXPECT_FALSE(probe.text("finale/header/headerData").has_value()) << "elements with children have no leaf text";
+}
+
+TEST(XmlHeaderProbe, GivesUpAtByteBudget)
+{
+    const std::string header = "<finale><header><headerData><created><fileVersion><major>26</major><minor>2</minor>"
+                               "</fileVersion></created></headerData></header></finale>";
+    const std::string padded = "<finale>" + std::string(200, ' ') + header.substr(std::string("<finale>").size());
+    EXPECT_TRUE(utils::probeEnigmaXmlFileVersion(header).has_value());
+    EXPECT_FALSE(utils::XmlHeaderProbe(padded, "finale/header", 100).intValue(
+        "finale/header/headerData/created/fileVersion/major").has_value());
+    EXPECT_FALSE(utils::probeEnigmaXmlFileVersion("<finale><header><headerData><created><fileVers").has_value());
+    EXPECT_FALSE(utils::probeEnigmaXmlFileVersion("").has_value());
+}
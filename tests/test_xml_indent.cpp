@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string>
+#include <string_view>
+
+#include "gtest/gtest.h"
+
+#include "utils/xml_indent.h"
+
+TEST(XmlIndentStripper, RemovesIndentationBetweenElements)
+{
+    const std::string xml =
+        "<?xml version=\"1.0\"?>\n<!DOCTYPE score-partwise>\n"
+        "<score-partwise version=\"4.0\">\n"
+        "    <part id=\"P1\">\n"
+        "        <measure number=\"1\"/>\n"
+        "        <words>  spaced text  </words>\n"
+        "        <empty>\n        </empty>\n"
+        "        <single> </single>\n"
+        "    </part>\n"
+        "</score-partwise>";
+    EXPECT_EQ(utils::stripXmlIndentation(xml),
+        "<?xml version=\"1.0\"?><!DOCTYPE score-partwise>"
+        "<score-partwise version=\"4.0\"><part id=\"P1\"><measure number=\"1\"/>"
+        "<words>  spaced text  </words><empty>\n        </empty><single> </single></part></score-partwise>");
+}
+
+TEST(XmlIndentStripper, KeepsQuotedMarkupAndMatchesAcrossChunks)
+{
+    const std::string xml = "<a title=\"x >\n <y\">\n\t<b>1</b>\n\t<c k='>'/>\n</a>\n";
+    const std::string whole = utils::stripXmlIndentation(xml);
+    EXPECT_EQ(whole, "<a title=\"x >\n <y\"><b>1</b><c k='>'/></a>\n");
+
+    for (std::size_t chunkSize = 1; chunkSize < xml.size(); ++chunkSize) {
+        utils::XmlIndentStripper stripper;
+        std::string chunked;
+        for (std::size_t offset = 0; offset < xml.size(); offset += chunkSize) {
+            stripper.strip(std::string_view(xml).substr(offset, chunkSize), chunked);
+        }
+        stripper.finish(chunked);
+        EXPECT_EQ(chunked, whole) << "chunk size " << chunkSize;
+    }
+}
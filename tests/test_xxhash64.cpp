@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026, Robert Patterson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "gtest/gtest.h"
+
+#include "core/xxhash64.h"
+
+namespace {
+
+std::span<const std::byte> bytesOf(std::string_view text)
+{
+    return std::as_bytes(std::span<const char>(text.data(), text.size()));
+}
+
+} // namespace
+
+TEST(Xxh64, MatchesReferenceDigests)
+{
+    EXPECT_EQ(denigma::Xxh64::toHex(denigma::Xxh64::hash(bytesOf(""))), "ef46db3751d8e999");
+    EXPECT_EQ(denigma::Xxh64::toHex(denigma::Xxh64::hash(bytesOf("a"))), "d24ec4f1a98c6e5b");
+    EXPECT_EQ(denigma::Xxh64::toHex(denigma::Xxh64::hash(bytesOf("abc"))), "44bc2cf5ad770999");
+}
+
+TEST(Xxh64, SameDigestAcrossChunks)
+{
+    std::string text;
+    for (int i = 0; i < 100; ++i) {
+        text += "<measure number=\"" + std::to_string(i) + "\"/>";
+    }
+    const auto whole = denigma::Xxh64::hash(bytesOf(text));
+    for (std::size_t chunkSize = 1; chunkSize < 80; ++chunkSize) {
+        denigma::Xxh64 hasher;
+        for (std::size_t offset = 0; offset < text.size(); offset += chunkSize) {
+            hasher.update(bytesOf(std::string_view(text).substr(offset, chunkSize)));
+        }
+        EXPECT_EQ(hasher.digest(), whole) << "chunk size " << chunkSize;
+    }
+}